@@ -54,6 +54,21 @@ echo Copy Struct files ...
 if not exist %TARGET_DIR%\structs mkdir %TARGET_DIR%\structs
 xcopy /i /s /y /d %RES_DIR%\grt\structs*.xml %TARGET_DIR%\structs\. 1> nul 2> nul
 
+rem Binary image of the struct definitions, loaded at startup instead of parsing the XML files. It is created from
+rem the copied files, as it is only used for files with the same size and modification time. genobj is built by
+rem tools\tools.sln and needs the grt libraries from the target directory.
+echo Generate struct cache ...
+set GENOBJ=%1tools\bin\%3\%2\genobj.exe
+if not exist %GENOBJ% set GENOBJ=%1tools\bin\%3\Debug\genobj.exe
+if exist %GENOBJ% (
+  setlocal
+  set PATH=%TARGET_DIR%;%PATH%
+  %GENOBJ% --cache %TARGET_DIR%\structs %TARGET_DIR%\structs\structs.cache 1> nul
+  endlocal
+) else (
+  echo genobj.exe not found, build tools\tools.sln to get the struct cache
+)
+
 echo Copy image files ...
 if not exist %TARGET_DIR%\images\grt\structs mkdir %TARGET_DIR%\images\grt\structs
 if not exist %TARGET_DIR%\images\icons mkdir %TARGET_DIR%\images\icons
@@ -78,6 +78,7 @@ grt::Ref<C> get_parent_for_object(const GrtObjectRef &object) {
 }
 
 WBComponentPhysical::WBComponentPhysical(WBContext *wb) : WBComponent(wb) {
+  scoped_connect(grt::ChangeBatch::signal_flushed(), std::bind(&WBComponentPhysical::change_batch_flushed, this));
 }
 
 WBComponentPhysical::~WBComponentPhysical() {
@@ -2105,7 +2106,10 @@ void WBComponentPhysical::catalog_object_list_changed(grt::internal::OwnedList *
 
 void WBComponentPhysical::schema_member_changed(const std::string &member, const grt::ValueRef &ovalue,
                                                 const db_SchemaRef &schema) {
-  if (wb::WBContextUI::get()->get_physical_overview())
+  if (grt::ChangeBatch::flushing()) {
+    std::lock_guard<std::mutex> lock(_pending_refresh_mutex);
+    _pending_schema_refreshes[schema.id()] = schema;
+  } else if (wb::WBContextUI::get()->get_physical_overview())
     ((PhysicalOverviewBE *)wb::WBContextUI::get()->get_physical_overview())->send_refresh_for_schema(schema, true);
 
   _wb->get_model_context()->notify_catalog_tree_view(NodeAddUpdate, schema);
@@ -2136,9 +2140,44 @@ void WBComponentPhysical::schema_object_list_changed(grt::internal::OwnedList *l
     _wb->request_refresh(RefreshCloseEditor, object.id());
   }
 
-  if (wb::WBContextUI::get()->get_physical_overview())
+  if (grt::ChangeBatch::flushing()) {
+    // One refresh per schema object category is enough for the whole batch. The object may have been moved or
+    // deleted by the time the refresh is sent, so the schema whose list changed is kept with it.
+    std::lock_guard<std::mutex> lock(_pending_refresh_mutex);
+    _pending_object_refreshes[schema.id() + ":" + object.class_name()] =
+      std::make_pair(schema, GrtObjectRef::cast_from(value));
+  } else if (wb::WBContextUI::get()->get_physical_overview())
     ((PhysicalOverviewBE *)wb::WBContextUI::get()->get_physical_overview())
-      ->send_refresh_for_schema_object(GrtObjectRef::cast_from(value), false);
+      ->send_refresh_for_schema_object(GrtObjectRef::cast_from(value), false, schema);
+}
+
+/**
+ * Sends the overview refreshes collected while the notifications of a grt::ChangeBatch were delivered. Batches
+ * flushed in other threads are handled when the main thread is idle.
+ */
+void WBComponentPhysical::change_batch_flushed() {
+  if (!bec::GRTManager::get()->in_main_thread()) {
+    bec::GRTManager::get()->run_once_when_idle(this, std::bind(&WBComponentPhysical::change_batch_flushed, this));
+    return;
+  }
+
+  std::map<std::string, db_SchemaRef> schemata;
+  std::map<std::string, std::pair<db_SchemaRef, GrtObjectRef> > objects;
+  {
+    std::lock_guard<std::mutex> lock(_pending_refresh_mutex);
+    schemata.swap(_pending_schema_refreshes);
+    objects.swap(_pending_object_refreshes);
+  }
+
+  PhysicalOverviewBE *overview = (PhysicalOverviewBE *)wb::WBContextUI::get()->get_physical_overview();
+  if (!overview)
+    return;
+
+  for (std::map<std::string, db_SchemaRef>::const_iterator iter = schemata.begin(); iter != schemata.end(); ++iter)
+    overview->send_refresh_for_schema(iter->second, true);
+  for (std::map<std::string, std::pair<db_SchemaRef, GrtObjectRef> >::const_iterator iter = objects.begin();
+       iter != objects.end(); ++iter)
+    overview->send_refresh_for_schema_object(iter->second.second, false, iter->second.first);
 }
 
 void WBComponentPhysical::view_object_list_changed(grt::internal::OwnedList *list, bool added,
@@ -39,6 +39,8 @@
 
 #include "wbcanvas/workbench_physical_model_impl.h"
 
+#include <mutex>
+
 namespace wb {
 
   enum RelationshipType {
@@ -247,6 +249,13 @@ namespace wb {
     boost::signals2::connection _model_list_listener;
     boost::signals2::connection _catalog_object_list_listener;
 
+    // Overview refreshes collected while a grt::ChangeBatch is flushed. Batches can be flushed on any thread,
+    // the refreshes are sent from the main thread. Object refreshes keep the schema the object was in when the
+    // change happened.
+    std::mutex _pending_refresh_mutex;
+    std::map<std::string, db_SchemaRef> _pending_schema_refreshes;
+    std::map<std::string, std::pair<db_SchemaRef, GrtObjectRef> > _pending_object_refreshes;
+
     void refresh_ui_for_object(const GrtObjectRef &object);
 
     bool update_table_fk_connection(const db_TableRef &table, const db_ForeignKeyRef &fk, bool added);
@@ -267,6 +276,7 @@ namespace wb {
     void schema_content_object_changed(const db_DatabaseObjectRef &object);
 
     void schema_member_changed(const std::string &name, const grt::ValueRef &ovalue, const db_SchemaRef &schema);
+    void change_batch_flushed();
 
     bool handle_button_event(ModelDiagramForm *, mdc::MouseButton, bool, base::Point, mdc::EventState, void *data);
   };
@@ -636,11 +636,12 @@ void PhysicalOverviewBE::send_refresh_for_schema(const db_SchemaRef &schema, boo
     send_refresh_children(NodeId(_schemata_node_index));
 }
 
-void PhysicalOverviewBE::send_refresh_for_schema_object(const GrtObjectRef &object, bool refresh_object_itself) {
+void PhysicalOverviewBE::send_refresh_for_schema_object(const GrtObjectRef &object, bool refresh_object_itself,
+                                                        const GrtObjectRef &owner) {
   NodeId schema_node;
 
   NodeId schemata_node = NodeId(_schemata_node_index);
-  schema_node = get_node_child_for_object(schemata_node, object->owner());
+  schema_node = get_node_child_for_object(schemata_node, owner.is_valid() ? owner : object->owner());
 
   if (object.is_instance(db_Table::static_class_name()))
     schema_node.append(0);
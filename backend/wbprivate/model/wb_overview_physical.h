@@ -145,7 +145,9 @@ namespace wb {
     void send_refresh_notes();
     void send_refresh_schema_list();
     void send_refresh_for_schema(const db_SchemaRef &schema, bool refresh_object_itself);
-    void send_refresh_for_schema_object(const GrtObjectRef &object, bool refresh_object_itself);
+    // The object's category is refreshed in the given owner's node, if valid, or else in that of its current owner.
+    void send_refresh_for_schema_object(const GrtObjectRef &object, bool refresh_object_itself,
+                                        const GrtObjectRef &owner = GrtObjectRef());
 
     void set_model(workbench_physical_ModelRef model);
 
@@ -0,0 +1,479 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include <sqlite/execute.hpp>
+#include <sqlite/query.hpp>
+#include <glib.h>
+
+#include "base/file_utilities.h"
+#include "base/log.h"
+#include "base/string_utilities.h"
+#include "base/boost_smart_ptr_helpers.h"
+#include "sqlide/sqlide_generics.h"
+
+#include "query_performance_history.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+DEFAULT_LOG_DOMAIN("QueryHistory");
+
+namespace {
+
+  const double history_retention = 90 * 24 * 3600.0;  // Entries older than that are dropped when opening the store.
+  const size_t max_normalized_statement_size = 65536; // Larger statements are only masked, not parsed.
+
+  bool is_identifier_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '$' || (unsigned char)c >= 0x80;
+  }
+
+  // Returns the position after the quoted text starting at i.
+  size_t skip_quoted(const std::string &sql, size_t i) {
+    char quote = sql[i++];
+    while (i < sql.size()) {
+      if (sql[i] == '\\' && quote != '`')
+        i += 2;
+      else if (sql[i] == quote) {
+        if (i + 1 < sql.size() && sql[i + 1] == quote)
+          i += 2;
+        else
+          return i + 1;
+      } else
+        ++i;
+    }
+    return sql.size();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  // Replaces a list of placeholders with (...) and drops repetitions of such lists, as in multi row INSERTs.
+  void append_value_list(std::string &out) {
+    std::string::size_type end = out.find_last_not_of(' ');
+    if (end != std::string::npos && out[end] == ',') {
+      std::string::size_type previous = out.find_last_not_of(' ', end - 1);
+      if (previous != std::string::npos && previous >= 4 && out.compare(previous - 4, 5, "(...)") == 0) {
+        out.erase(previous + 1);
+        return;
+      }
+    }
+    out.append("(...)");
+  }
+
+  std::string collapse_value_lists(const std::string &sql) {
+    std::string out;
+    out.reserve(sql.size());
+    for (size_t i = 0; i < sql.size();) {
+      if (sql[i] == '(') {
+        size_t j = i + 1;
+        bool is_list = false;
+        while (j < sql.size() && sql[j] == ' ')
+          ++j;
+        while (j < sql.size() && sql[j] == '?') {
+          ++j;
+          while (j < sql.size() && sql[j] == ' ')
+            ++j;
+          if (j < sql.size() && sql[j] == ')') {
+            is_list = true;
+            ++j;
+            break;
+          }
+          if (j >= sql.size() || sql[j] != ',')
+            break;
+          ++j;
+          while (j < sql.size() && sql[j] == ' ')
+            ++j;
+        }
+        if (is_list) {
+          append_value_list(out);
+          i = j;
+          continue;
+        }
+      }
+      out.push_back(sql[i++]);
+    }
+    return out;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  double percentile(const std::vector<double> &sorted, double fraction) {
+    if (sorted.empty())
+      return 0;
+    size_t rank = (size_t)(fraction * sorted.size() + 0.999999);
+    return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+  }
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+
+QueryPerformanceHistory::Entry::Entry()
+  : executed_at(0), duration(0), fetch_duration(0), rows_affected(-1), rows_returned(0) {
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QueryPerformanceHistory::QueryPerformanceHistory(const std::string &connection_id, const std::string &cache_dir,
+                                                 Sql_normalizer::Ref normalizer)
+  : _connection_id(connection_id), _normalizer(normalizer) {
+  std::string path = base::makePath(cache_dir, connection_id) + ".query_history";
+  _sqconn = new sqlite::connection(path);
+  sqlite::execute(*_sqconn, "PRAGMA temp_store=MEMORY", true);
+  sqlite::execute(*_sqconn, "PRAGMA synchronous=NORMAL", true);
+
+  logDebug2("Using query history file %s\n", path.c_str());
+
+  init_db();
+  purge(history_retention);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+QueryPerformanceHistory::~QueryPerformanceHistory() {
+  delete _sqconn;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void QueryPerformanceHistory::init_db() {
+  static const char *statements[] = {
+    "create table if not exists statements (id integer primary key, digest varchar(32), digest_text text, "
+    "schema_name text, executed_at real, duration real, client_time real, fetch_time real, server_time real, "
+    "lock_time real, rows_affected int, rows_returned int, rows_examined int, errors int, warnings int, "
+    "tmp_disk_tables int, tmp_tables int, full_scans int, no_index_used int)",
+    "create index if not exists statements_digest on statements (digest, executed_at)",
+    "create index if not exists statements_time on statements (executed_at)",
+    "create table if not exists stages (statement_id int, name text, wait_time real)",
+    "create index if not exists stages_statement on stages (statement_id)",
+    "create table if not exists waits (statement_id int, name text, wait_time real)",
+    "create index if not exists waits_statement on waits (statement_id)",
+    nullptr};
+
+  for (const char **statement = statements; *statement; ++statement) {
+    try {
+      sqlite::execute(*_sqconn, *statement, true);
+    } catch (std::exception &exc) {
+      logError("Error initializing query history for %s: %s\n", _connection_id.c_str(), exc.what());
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void QueryPerformanceHistory::purge(double older_than) {
+  try {
+    sqlide::Sqlite_transaction_guarder transaction(_sqconn);
+    double limit = (double)time(nullptr) - older_than;
+    for (const char *table : {"stages", "waits"}) {
+      sqlite::command purge_details(
+        *_sqconn, base::strfmt("delete from %s where statement_id in (select id from statements where executed_at < ?)",
+                               table));
+      purge_details % limit;
+      purge_details.emit();
+    }
+    sqlite::command purge_statements(*_sqconn, "delete from statements where executed_at < ?");
+    purge_statements % limit;
+    purge_statements.emit();
+  } catch (std::exception &exc) {
+    logError("Error purging query history for %s: %s\n", _connection_id.c_str(), exc.what());
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Stores a batch of executed statements. Statements that were run with performance_schema statistics collection
+ * enabled also get the server side timings and their stage and wait breakdown.
+ */
+void QueryPerformanceHistory::record(const std::vector<Entry> &entries) {
+  if (entries.empty())
+    return;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlide::Sqlite_transaction_guarder transaction(_sqconn);
+    sqlite::command insert(*_sqconn,
+                           "insert into statements (digest, digest_text, schema_name, executed_at, duration, "
+                           "client_time, fetch_time, server_time, lock_time, rows_affected, rows_returned, "
+                           "rows_examined, errors, warnings, tmp_disk_tables, tmp_tables, full_scans, no_index_used) "
+                           "values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    sqlite::command insert_stage(*_sqconn, "insert into stages (statement_id, name, wait_time) values (?, ?, ?)");
+    sqlite::command insert_wait(*_sqconn, "insert into waits (statement_id, name, wait_time) values (?, ?, ?)");
+
+    for (const Entry &entry : entries) {
+      std::string text = make_digest_text(entry.statement, entry.schema);
+      bool has_ps = entry.ps_stats.find("TIMER_WAIT") != entry.ps_stats.end();
+      std::map<std::string, std::int64_t> ps(entry.ps_stats);
+
+      // Server side timings are more accurate, so they are preferred for percentiles.
+      double server_time = has_ps ? ps["TIMER_WAIT"] / 1000000000000.0 : 0;
+      insert.clear();
+      insert % digest(text) % text % entry.schema % entry.executed_at;
+      insert % (server_time > 0 ? server_time : entry.duration) % entry.duration % entry.fetch_duration;
+      if (has_ps) {
+        insert % server_time % (ps["LOCK_TIME"] / 1000000000000.0);
+        insert % (std::int64_t)entry.rows_affected % (std::int64_t)entry.rows_returned % ps["ROWS_EXAMINED"];
+        insert % ps["ERRORS"] % ps["WARNINGS"] % ps["CREATED_TMP_DISK_TABLES"] % ps["CREATED_TMP_TABLES"];
+        insert % (ps["SELECT_SCAN"] + ps["SELECT_FULL_JOIN"]) % ps["NO_INDEX_USED"];
+      } else {
+        insert % sqlite::nil % sqlite::nil;
+        insert % (std::int64_t)entry.rows_affected % (std::int64_t)entry.rows_returned % sqlite::nil;
+        insert % sqlite::nil % sqlite::nil % sqlite::nil % sqlite::nil % sqlite::nil % sqlite::nil;
+      }
+      insert.emit();
+
+      if (entry.ps_stages.empty() && entry.ps_waits.empty())
+        continue;
+
+      std::int64_t statement_id = 0;
+      {
+        sqlite::query last_id(*_sqconn, "select last_insert_rowid()");
+        if (last_id.emit())
+          statement_id = BoostHelper::convertPointer(last_id.get_result())->get_int64(0);
+      }
+      for (const auto &stage : entry.ps_stages) {
+        insert_stage.clear();
+        insert_stage % statement_id % stage.first % stage.second;
+        insert_stage.emit();
+      }
+      for (const auto &wait : entry.ps_waits) {
+        insert_wait.clear();
+        insert_wait % statement_id % wait.first % wait.second;
+        insert_wait.emit();
+      }
+    }
+    transaction.commit();
+  } catch (std::exception &exc) {
+    logError("Error storing query history for %s: %s\n", _connection_id.c_str(), exc.what());
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<QueryPerformanceHistory::Percentiles> QueryPerformanceHistory::percentiles(const std::string &digest,
+                                                                                       double period,
+                                                                                       size_t max_periods) {
+  std::vector<Percentiles> result;
+  std::map<double, std::vector<double> > durations; // Keyed by period start.
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlite::query q(*_sqconn, "select executed_at, duration from statements where digest = ? order by executed_at");
+    q.bind(1, digest);
+    if (q.emit()) {
+      std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(q.get_result()));
+      do {
+        double executed_at = res->get_double(0);
+        durations[executed_at - fmod(executed_at, period)].push_back(res->get_double(1));
+      } while (res->next_row());
+    }
+  } catch (std::exception &exc) {
+    logError("Error reading query history for %s: %s\n", _connection_id.c_str(), exc.what());
+  }
+
+  for (auto iter = durations.rbegin(); iter != durations.rend() && result.size() < max_periods; ++iter) {
+    std::vector<double> &values = iter->second;
+    std::sort(values.begin(), values.end());
+    Percentiles entry = {iter->first,
+                         values.size(),
+                         percentile(values, 0.5),
+                         percentile(values, 0.95),
+                         percentile(values, 0.99),
+                         values.back()};
+    result.push_back(entry);
+  }
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<QueryPerformanceHistory::Regression> QueryPerformanceHistory::regressions(double recent, double factor,
+                                                                                      size_t min_count) {
+  struct Durations {
+    std::string text;
+    std::vector<double> recent;
+    std::vector<double> baseline;
+  };
+  std::map<std::string, Durations> digests;
+  double recent_start = (double)time(nullptr) - recent;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  try {
+    sqlite::query q(*_sqconn, "select digest, digest_text, executed_at, duration from statements order by digest");
+    if (q.emit()) {
+      std::shared_ptr<sqlite::result> res(BoostHelper::convertPointer(q.get_result()));
+      do {
+        Durations &durations = digests[res->get_string(0)];
+        if (durations.text.empty())
+          durations.text = res->get_string(1);
+        (res->get_double(2) >= recent_start ? durations.recent : durations.baseline).push_back(res->get_double(3));
+      } while (res->next_row());
+    }
+  } catch (std::exception &exc) {
+    logError("Error reading query history for %s: %s\n", _connection_id.c_str(), exc.what());
+  }
+
+  std::vector<Regression> result;
+  for (auto &iter : digests) {
+    Durations &durations = iter.second;
+    if (durations.recent.size() < min_count || durations.baseline.size() < min_count)
+      continue;
+    std::sort(durations.recent.begin(), durations.recent.end());
+    std::sort(durations.baseline.begin(), durations.baseline.end());
+    Regression regression = {iter.first, durations.text, durations.recent.size(),
+                             percentile(durations.recent, 0.95), percentile(durations.baseline, 0.95)};
+    if (regression.recent_p95 > factor * regression.baseline_p95)
+      result.push_back(regression);
+  }
+
+  // Worst first.
+  std::sort(result.begin(), result.end(), [](const Regression &a, const Regression &b) {
+    return a.recent_p95 * b.baseline_p95 > b.recent_p95 * a.baseline_p95;
+  });
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string QueryPerformanceHistory::digest_text(const std::string &statement, const std::string &schema) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return make_digest_text(statement, schema);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Normalizes the statement with the SQL normalizer of the connection, then replaces all literals by placeholders.
+ * Must be called with the store locked, since the normalizer keeps state while parsing.
+ */
+std::string QueryPerformanceHistory::make_digest_text(const std::string &statement, const std::string &schema) {
+  std::string text;
+  if (_normalizer && statement.size() <= max_normalized_statement_size) {
+    try {
+      text = _normalizer->normalize(statement, schema);
+    } catch (std::exception &exc) {
+      logDebug("Could not normalize statement: %s\n", exc.what());
+    }
+  }
+  if (text.empty())
+    text = statement;
+  return mask_literals(text);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string QueryPerformanceHistory::digest(const std::string &digest_text) {
+  gchar *checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA256, digest_text.c_str(), -1);
+  std::string result(checksum, 32);
+  g_free(checksum);
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Replaces string and number literals with ?, removes comments and collapses whitespace. Value lists are
+ * reduced to (...), so that statements differing only in the number of values get the same digest.
+ */
+std::string QueryPerformanceHistory::mask_literals(const std::string &sql) {
+  std::string result;
+  result.reserve(sql.size());
+
+  bool pending_space = false;
+  size_t length = sql.size();
+  for (size_t i = 0; i < length;) {
+    char c = sql[i];
+    if (isspace((unsigned char)c)) {
+      pending_space = true;
+      ++i;
+      continue;
+    }
+    if (c == '#' || (c == '-' && i + 1 < length && sql[i + 1] == '-' &&
+                     (i + 2 == length || isspace((unsigned char)sql[i + 2])))) {
+      i = sql.find('\n', i);
+      if (i == std::string::npos)
+        i = length;
+      pending_space = true;
+      continue;
+    }
+    if (c == '/' && i + 1 < length && sql[i + 1] == '*') {
+      i = sql.find("*/", i + 2);
+      i = (i == std::string::npos) ? length : i + 2;
+      pending_space = true;
+      continue;
+    }
+
+    if (pending_space && !result.empty())
+      result.push_back(' ');
+    pending_space = false;
+
+    if (c == '\'' || c == '"') {
+      i = skip_quoted(sql, i);
+      result.push_back('?');
+    } else if (c == '`') {
+      size_t end = skip_quoted(sql, i);
+      result.append(sql, i, end - i);
+      i = end;
+    } else if (isdigit((unsigned char)c) || (c == '.' && i + 1 < length && isdigit((unsigned char)sql[i + 1]))) {
+      size_t start = i;
+      while (i < length && (isdigit((unsigned char)sql[i]) || sql[i] == '.'))
+        ++i;
+      if (i < length && (sql[i] == 'e' || sql[i] == 'E') && i + 1 < length &&
+          (isdigit((unsigned char)sql[i + 1]) ||
+           ((sql[i + 1] == '+' || sql[i + 1] == '-') && i + 2 < length && isdigit((unsigned char)sql[i + 2])))) {
+        i += 2;
+        while (i < length && isdigit((unsigned char)sql[i]))
+          ++i;
+      }
+      if (i < length && is_identifier_char(sql[i])) {
+        // Either a hex/bit literal (0x1F, 0b101) or an identifier starting with digits.
+        while (i < length && is_identifier_char(sql[i]))
+          ++i;
+        if (sql.size() > start + 1 && sql[start] == '0' && (sql[start + 1] == 'x' || sql[start + 1] == 'b'))
+          result.push_back('?');
+        else
+          result.append(sql, start, i - start);
+      } else
+        result.push_back('?');
+    } else if (is_identifier_char(c)) {
+      size_t start = i;
+      while (i < length && is_identifier_char(sql[i]))
+        ++i;
+      // X'..', B'..', N'..' and character set introducers like _utf8mb4'..' are literals too.
+      bool prefix = (i - start == 1 && strchr("xXbBnN", c) != nullptr) || c == '_';
+      if (prefix && i < length && sql[i] == '\'') {
+        i = skip_quoted(sql, i);
+        result.push_back('?');
+      } else
+        result.append(sql, start, i - start);
+    } else {
+      result.push_back(c);
+      ++i;
+    }
+  }
+
+  return collapse_value_lists(result);
+}
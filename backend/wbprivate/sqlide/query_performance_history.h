@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include "workbench/wb_backend_public_interface.h"
+#include "grtsqlparser/sql_normalizer.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sqlite {
+  class connection;
+}
+
+/**
+ * Keeps the execution statistics of every statement run in a SQL editor in a local SQLite store, one per
+ * connection. Statements are grouped by a digest of their normalized text (literals replaced by ?), so the
+ * timings of the same query can be followed over time.
+ */
+class MYSQLWBBACKEND_PUBLIC_FUNC QueryPerformanceHistory {
+public:
+  struct Entry {
+    Entry();
+
+    std::string statement;
+    std::string schema;
+    double executed_at;           // Seconds since the epoch.
+    double duration;              // Execution time measured by the client, in seconds.
+    double fetch_duration;
+    std::int64_t rows_affected;   // -1 for statements returning rows.
+    std::int64_t rows_returned;
+    std::map<std::string, std::int64_t> ps_stats; // From events_statements_current, if collected.
+    std::vector<std::pair<std::string, double> > ps_stages; // Stage/wait name and time spent in ms.
+    std::vector<std::pair<std::string, double> > ps_waits;
+  };
+
+  // Execution time percentiles of one digest in a period, in seconds.
+  struct Percentiles {
+    double start;
+    size_t count;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+  };
+
+  struct Regression {
+    std::string digest;
+    std::string digest_text;
+    size_t recent_count;
+    double recent_p95;
+    double baseline_p95;
+  };
+
+  QueryPerformanceHistory(const std::string &connection_id, const std::string &cache_dir,
+                          Sql_normalizer::Ref normalizer);
+  ~QueryPerformanceHistory();
+
+  void record(const std::vector<Entry> &entries);
+
+  // Percentiles per period for the given digest, newest period first.
+  std::vector<Percentiles> percentiles(const std::string &digest, double period, size_t max_periods);
+
+  // Statements whose 95th percentile over the last recent seconds exceeds factor times the one before.
+  std::vector<Regression> regressions(double recent, double factor, size_t min_count);
+
+  // The normalized text of a statement, as used for its digest. Can be called from any thread.
+  std::string digest_text(const std::string &statement, const std::string &schema);
+  static std::string digest(const std::string &digest_text);
+  static std::string mask_literals(const std::string &sql);
+
+private:
+  std::string make_digest_text(const std::string &statement, const std::string &schema);
+  void init_db();
+  void purge(double older_than);
+
+  std::string _connection_id;
+  sqlite::connection *_sqconn;
+  Sql_normalizer::Ref _normalizer;
+  std::mutex _mutex;
+};
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "wb_helpers.h"
+
+#include "base/file_utilities.h"
+#include "sqlide/query_performance_history.h"
+
+#include <cmath>
+#include <ctime>
+
+#define HISTORY_TEST_DIR "query_history_test"
+
+BEGIN_TEST_DATA_CLASS(query_performance_history_test)
+protected:
+  std::unique_ptr<QueryPerformanceHistory> _history;
+
+  QueryPerformanceHistory::Entry entry(const std::string &statement, double executed_at, double duration) {
+    QueryPerformanceHistory::Entry result;
+    result.statement = statement;
+    result.schema = "test";
+    result.executed_at = executed_at;
+    result.duration = duration;
+    return result;
+  }
+
+TEST_DATA_CONSTRUCTOR(query_performance_history_test) {
+  base::remove_recursive(HISTORY_TEST_DIR);
+  base::create_directory(HISTORY_TEST_DIR, 0700);
+  // Without a normalizer statements are only masked.
+  _history.reset(new QueryPerformanceHistory("test_connection", HISTORY_TEST_DIR, Sql_normalizer::Ref()));
+}
+
+TEST_DATA_DESTRUCTOR(query_performance_history_test) {
+  _history.reset();
+  base::remove_recursive(HISTORY_TEST_DIR);
+}
+END_TEST_DATA_CLASS
+
+TEST_MODULE(query_performance_history_test, "query performance history");
+
+// Literals become placeholders, comments and extra whitespace go away, quoted identifiers stay.
+TEST_FUNCTION(1) {
+  ensure_equals("literals", QueryPerformanceHistory::mask_literals("SELECT * FROM t WHERE a = 'x' AND b = 42"),
+                "SELECT * FROM t WHERE a = ? AND b = ?");
+  ensure_equals("comments", QueryPerformanceHistory::mask_literals("SELECT 1 -- comment\n, 2 /* c */ FROM `t 1`"),
+                "SELECT ? , ? FROM `t 1`");
+  ensure_equals("whitespace", QueryPerformanceHistory::mask_literals("  SELECT\n\t1  "), "SELECT ?");
+  ensure_equals("escaped quotes", QueryPerformanceHistory::mask_literals("SELECT 'it''s', \"a\\\"b\""),
+                "SELECT ?, ?");
+  ensure_equals("hash comment", QueryPerformanceHistory::mask_literals("SELECT 1 # comment 'x'"), "SELECT ?");
+}
+
+// Prefixed, hex and exponent literals versus identifiers containing digits.
+TEST_FUNCTION(2) {
+  ensure_equals("literal forms",
+                QueryPerformanceHistory::mask_literals("SELECT 0x1F, X'ab', _utf8mb4'x', 1e10, .5, b'101'"),
+                "SELECT ?, ?, ?, ?, ?, ?");
+  ensure_equals("identifiers", QueryPerformanceHistory::mask_literals("SELECT t1.col2, 3abc FROM x1"),
+                "SELECT t1.col2, 3abc FROM x1");
+}
+
+// Value lists collapse, so statements differing in the number of values share a digest.
+TEST_FUNCTION(3) {
+  ensure_equals("multi row insert",
+                QueryPerformanceHistory::mask_literals("INSERT INTO t VALUES (1, 'a'), (2, 'b'),(3,'c')"),
+                "INSERT INTO t VALUES (...)");
+  ensure_equals("in list", QueryPerformanceHistory::mask_literals("SELECT * FROM t WHERE id IN (1,2,3)"),
+                "SELECT * FROM t WHERE id IN (...)");
+  ensure_equals("function call kept", QueryPerformanceHistory::mask_literals("SELECT f(a, 1)"), "SELECT f(a, ?)");
+
+  std::string one = _history->digest_text("SELECT * FROM t WHERE id IN (1)", "test");
+  std::string many = _history->digest_text("SELECT * FROM t WHERE id IN (4, 5, 6)", "test");
+  ensure_equals("same digest text", one, many);
+  ensure_equals("same digest", QueryPerformanceHistory::digest(one), QueryPerformanceHistory::digest(many));
+  ensure_equals("digest length", QueryPerformanceHistory::digest(one).size(), 32U);
+  ensure("different digest", QueryPerformanceHistory::digest(one) !=
+                               QueryPerformanceHistory::digest(_history->digest_text("SELECT 1", "test")));
+}
+
+// Nearest rank percentiles per period, newest period first.
+TEST_FUNCTION(4) {
+  double hour = 3600;
+  double period_start = std::floor((double)time(nullptr) / hour) * hour - 2 * hour;
+
+  std::vector<QueryPerformanceHistory::Entry> entries;
+  for (int i = 0; i < 100; ++i)
+    entries.push_back(
+      entry("SELECT * FROM t WHERE id = " + std::to_string(i), period_start + hour + i, (i + 1) / 1000.0));
+  for (int i = 0; i < 10; ++i)
+    entries.push_back(entry("SELECT * FROM t WHERE id = 1", period_start + i, (10 - i) / 100.0));
+  entries.push_back(entry("SELECT 1", period_start, 5));
+  _history->record(entries);
+
+  std::string digest = QueryPerformanceHistory::digest(_history->digest_text("SELECT * FROM t WHERE id = 5", "test"));
+  std::vector<QueryPerformanceHistory::Percentiles> periods = _history->percentiles(digest, hour, 10);
+  ensure_equals("periods", periods.size(), 2U);
+
+  ensure_equals("newest first", periods[0].start, period_start + hour);
+  ensure_equals("count", periods[0].count, 100U);
+  ensure_equals("p50", periods[0].p50, 50 / 1000.0);
+  ensure_equals("p95", periods[0].p95, 95 / 1000.0);
+  ensure_equals("p99", periods[0].p99, 99 / 1000.0);
+  ensure_equals("max", periods[0].max, 100 / 1000.0);
+
+  ensure_equals("older period", periods[1].start, period_start);
+  ensure_equals("small count", periods[1].count, 10U);
+  ensure_equals("small p50", periods[1].p50, 5 / 100.0);
+  ensure_equals("small p95", periods[1].p95, 10 / 100.0);
+
+  ensure_equals("limited periods", _history->percentiles(digest, hour, 1).size(), 1U);
+  ensure("unknown digest", _history->percentiles("unknown", hour, 10).empty());
+}
+
+// A statement is reported when its recent 95th percentile grew beyond the factor.
+TEST_FUNCTION(5) {
+  double now = (double)time(nullptr);
+  std::vector<QueryPerformanceHistory::Entry> entries;
+  for (int i = 0; i < 20; ++i) {
+    entries.push_back(entry("SELECT * FROM slow WHERE id = " + std::to_string(i), now - 7200 + i, 0.01));
+    entries.push_back(entry("SELECT * FROM slow WHERE id = " + std::to_string(i), now - 60 + i, 0.05));
+    entries.push_back(entry("SELECT * FROM steady", now - 7200 + i, 0.02));
+    entries.push_back(entry("SELECT * FROM steady", now - 60 + i, 0.021));
+  }
+  entries.push_back(entry("SELECT * FROM rare", now - 7200, 0.01));
+  entries.push_back(entry("SELECT * FROM rare", now - 60, 1));
+  _history->record(entries);
+
+  std::vector<QueryPerformanceHistory::Regression> regressions = _history->regressions(3600, 2, 5);
+  ensure_equals("regressions", regressions.size(), 1U);
+  ensure_equals("text", regressions[0].digest_text, "SELECT * FROM slow WHERE id = ?");
+  ensure_equals("recent count", regressions[0].recent_count, 20U);
+  ensure_equals("recent p95", regressions[0].recent_p95, 0.05);
+  ensure_equals("baseline p95", regressions[0].baseline_p95, 0.01);
+}
+
+END_TESTS
@@ -472,6 +472,17 @@ static void call_exec_sql(wb::WBContextSQLIDE *sqlide, bool current_statement_on
     form->run_editor_contents(current_statement_only);
 }
 
+static void call_exec_sql_file_in_bulk(wb::WBContextSQLIDE *sqlide) {
+  SqlEditorForm *form = sqlide->get_active_sql_editor();
+  if (form) {
+    mforms::FileChooser chooser(mforms::OpenFile);
+    chooser.set_title(_("Run SQL Script in Bulk Mode"));
+    chooser.set_extensions("SQL Files (*.sql)|*.sql", "sql");
+    if (chooser.run_modal())
+      form->exec_sql_file_in_bulk(chooser.get_path());
+  }
+}
+
 static bool validate_exec_sql(wb::WBContextSQLIDE *sqlide) {
   SqlEditorForm *form = sqlide->get_active_sql_editor();
   return (form && !form->is_running_query() && form->connected());
@@ -700,6 +711,8 @@ void WBContextSQLIDE::init() {
                              std::bind(validate_exec_sql, this));
   cmdui->add_builtin_command("query.execute_current_statement", std::bind(call_exec_sql, this, true),
                              std::bind(validate_exec_sql, this));
+  cmdui->add_builtin_command("query.execute_file_in_bulk", std::bind(call_exec_sql_file_in_bulk, this),
+                             std::bind(validate_exec_sql, this));
 
   cmdui->add_builtin_command("query.explain_current_statement", std::bind(&WBContextSQLIDE::call_in_editor, this,
                                                                           &SqlEditorForm::explain_current_statement),
@@ -646,10 +646,8 @@ void SqlEditorForm::open_file(const std::string &path, bool in_new_tab, bool ask
     if (askForFile && panel->load_from(file_path) == SqlEditorPanel::RunInstead) {
       if (in_new_tab)
         remove_sql_editor(panel);
-      grt::BaseListRef args(true);
-      args.ginsert(grtobj());
-      args.ginsert(grt::StringRef(file_path));
-      grt::GRT::get()->call_module_function("SQLIDEUtils", "runSQLScriptFile", args);
+      // Files this large are executed from disk rather than being read into memory first.
+      run_sql_script_file_wizard(file_path);
       return;
     }
   } catch (std::exception &exc) {
@@ -39,6 +39,9 @@
 #include "sqlide/sql_script_run_wizard.h"
 
 #include "sqlide/column_width_cache.h"
+#include "sqlide/query_performance_history.h"
+#include "sqlide/sql_statement_stream.h"
+#include "sqlide/sql_script_file_runner.h"
 
 #include "objimpl/db.query/db_query_Resultset.h"
 #include "objimpl/wrapper/mforms_ObjectReference_impl.h"
@@ -76,6 +79,11 @@
 #include "grtsqlparser/mysql_parser_services.h"
 
 #include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <thread>
 
@@ -277,6 +285,7 @@ SqlEditorForm::SqlEditorForm(wb::WBContextSQLIDE *wbsql)
   GRTNotificationCenter::get()->add_grt_observer(this, "GRNServerStateChanged");
   exec_sql_task->desc("execute sql queries");
   exec_sql_task->send_task_res_msg(false);
+  exec_sql_task->lane(bec::GRTExecutor::InteractiveLane);
   exec_sql_task->msg_cb(std::bind(&SqlEditorForm::add_log_message, this, std::placeholders::_1, std::placeholders::_2,
                                   std::placeholders::_3, ""));
 
@@ -284,6 +293,12 @@ SqlEditorForm::SqlEditorForm(wb::WBContextSQLIDE *wbsql)
 
   long keep_alive_interval = bec::GRTManager::get()->get_app_option_int("DbSqlEditor:KeepAliveInterval", 600);
 
+  // Idle connections left in the pool by all tabs are pinged by the pool itself.
+  sql::ConnectionPool *pool = sql::DriverManager::getDriverManager()->getConnectionPool();
+  long prewarmed = bec::GRTManager::get()->get_app_option_int("DbSqlEditor:PrewarmedConnections", 1);
+  pool->set_warm_count(prewarmed > 0 ? (size_t)prewarmed : 0);
+  pool->set_keep_alive_interval((int)keep_alive_interval);
+
   if (keep_alive_interval != 0) {
     logDebug3("Creating KeepAliveInterval timer...\n");
     _keep_alive_task_id = ThreadedTimer::add_task(
@@ -315,6 +330,7 @@ SqlEditorForm::~SqlEditorForm() {
                                               _connection->parameterValues().get_string("userName"));
 
   delete _column_width_cache;
+  delete _query_history;
 
   // debug: ensure that close() was called when the tab is closed
   if (_toolbar != nullptr)
@@ -374,6 +390,12 @@ void SqlEditorForm::finish_startup() {
   }
 
   _column_width_cache = new ColumnWidthCache(sanitize_file_name(get_session_name()), cache_dir);
+  try {
+    _query_history = new QueryPerformanceHistory(sanitize_file_name(get_session_name()), cache_dir,
+                                                 SqlFacade::instance_for_rdbms(rdbms())->sqlNormalizer());
+  } catch (std::exception &e) {
+    logError("Could not open query history: %s\n", e.what());
+  }
 
   if (_usr_dbc_conn && !_usr_dbc_conn->active_schema.empty())
     _live_tree->on_active_schema_change(_usr_dbc_conn->active_schema);
@@ -545,11 +567,13 @@ grt::StringRef SqlEditorForm::do_disconnect() {
       _usr_dbc_conn->ref.reset();
     }
 
+    // The aux connection only runs our own queries, so it can go back to the connection pool. The user connection
+    // is closed above, its session state can't be reset reliably.
     {
       RecMutexLock lock(_aux_dbc_conn_mutex);
-      close_connection(_aux_dbc_conn);
       _aux_dbc_conn->ref.reset();
     }
+    sql::DriverManager::getDriverManager()->getConnectionPool()->log_stats();
   }
 
   return grt::StringRef();
@@ -774,6 +798,24 @@ void SqlEditorForm::query_ps_statistics(std::int64_t conn_id, std::map<std::stri
   }
 }
 
+// Returns the number of bytes the server sent so far on the given connection, or -1 if that can't be determined.
+std::int64_t SqlEditorForm::query_bytes_sent(std::int64_t conn_id) {
+  RecMutexLock lock(ensure_valid_aux_connection());
+
+  std::auto_ptr<sql::Statement> stmt(_aux_dbc_conn->ref->createStatement());
+  try {
+    std::auto_ptr<sql::ResultSet> result(stmt->executeQuery(base::strfmt(
+      "SELECT st.VARIABLE_VALUE FROM performance_schema.status_by_thread st JOIN performance_schema.threads thr"
+      " ON thr.thread_id = st.thread_id WHERE thr.processlist_id = %lli AND st.VARIABLE_NAME = 'Bytes_sent'",
+      (long long int)conn_id)));
+    if (result->next())
+      return result->getInt64(1);
+  } catch (sql::SQLException &exc) {
+    logException("Error querying performance_schema.status_by_thread\n", exc);
+  }
+  return -1;
+}
+
 std::vector<SqlEditorForm::PSStage> SqlEditorForm::query_ps_stages(std::int64_t stmt_event_id) {
   RecMutexLock lock(ensure_valid_aux_connection());
 
@@ -1028,9 +1070,13 @@ void SqlEditorForm::create_connection(sql::Dbc_connection_handler::Ref &dbc_conn
   temp_connection->parameterValues().set("CLIENT_INTERACTIVE", grt::IntegerRef(1));
 
   try {
-    dbc_conn->ref = dbc_drv_man->getConnection(temp_connection, tunnel, auth,
-                                               std::bind(&SqlEditorForm::init_connection, this, std::placeholders::_1,
-                                                         std::placeholders::_2, dbc_conn, user_connection));
+    // Connections come from the shared pool, which saves the handshake if another tab left an idle one behind.
+    // The user connection runs arbitrary SQL, its session can't be reset for reuse, so it's never given back.
+    dbc_conn->ref = dbc_drv_man->getConnectionPool()->acquire(
+      temp_connection, tunnel, auth,
+      std::bind(&SqlEditorForm::init_connection, this, std::placeholders::_1, std::placeholders::_2, dbc_conn,
+                user_connection),
+      !user_connection);
 
     note_connection_open_outcome(0); // success
   } catch (sql::SQLException &exc) {
@@ -1813,6 +1859,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
   bool query_ps_stats = collect_ps_statement_events();
   std::string query_ps_statement_events_error;
   std::string statement;
+  std::vector<QueryPerformanceHistory::Entry> history_entries;
   int max_query_size_to_log = (int)bec::GRTManager::get()->get_app_option_int("DbSqlEditor:MaxQuerySizeToHistory", 0);
   int limit_rows = 0;
   if (bec::GRTManager::get()->get_app_option_int("SqlEditor:LimitRows") != 0)
@@ -1860,6 +1907,10 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
       query_ps_statement_events_error = "Query stats can only be fetched when a single statement is executed.";
     }
 
+    // The server counts the bytes it sent per session, which tells how much a result cost on the wire.
+    bool query_transfer_stats = query_ps_stats && is_supported_mysql_version_at_least(rdbms_version(), 5, 7);
+    sql::TransferProfile transfer_profile = sql::DriverManager::getDriverManager()->getTransferProfile(_connection);
+
     if (!max_query_size_to_log || max_query_size_to_log >= (int)sql->size()) {
       logging_queries = true;
     } else {
@@ -1949,10 +2000,15 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
 
           bool statement_failed = false;
           long long updated_rows_count = -1;
+          std::int64_t returned_rows_count = 0;
+          double executed_at = (double)time(nullptr);
           Timer statement_exec_timer(false);
           Timer statement_fetch_timer(false);
           std::shared_ptr<sql::Statement> dbc_statement(_usr_dbc_conn->ref->createStatement());
           bool is_result_set_first = false;
+          if (transfer_profile.streamResults)
+            dbc_statement->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+          std::int64_t bytes_sent = query_transfer_stats ? query_bytes_sent(_usr_dbc_conn->id) : -1;
 
           if (_usr_dbc_conn->is_stop_query_requested)
             throw std::runtime_error(
@@ -2132,6 +2188,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                     if (!data_storage) {
                       data_storage = Recordset_cdbc_storage::create();
                       data_storage->set_gather_field_info(true);
+                      data_storage->stream_results(transfer_profile.streamResults);
                       data_storage->rdbms(rdbms());
                       data_storage->setUserConnectionGetter(std::bind(&SqlEditorForm::getUserConnection, this,
                                                                       std::placeholders::_1, std::placeholders::_2));
@@ -2158,6 +2215,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                       std::bind(&SqlEditorForm::apply_changes_to_recordset, this, Recordset::Ptr(rs));
                     rs->generator_query(statement);
 
+                    RecordsetData *rdata = new RecordsetData();
                     {
                       if (query_ps_stats) {
                         query_ps_statistics(_usr_dbc_conn->id, ps_stats);
@@ -2165,18 +2223,29 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                         ps_waits = query_ps_waits(ps_stats["EVENT_ID"]);
                         query_ps_stats = false;
                       }
-                      RecordsetData *rdata = new RecordsetData();
                       rdata->duration = statement_exec_timer.duration();
+                      rdata->schema_name = _usr_dbc_conn->active_schema;
                       rdata->ps_stat_error = query_ps_statement_events_error;
                       rdata->ps_stat_info = ps_stats;
                       rdata->ps_stage_info = ps_stages;
                       rdata->ps_wait_info = ps_waits;
+                      rdata->transfer_profile = transfer_profile.name;
                       rs->set_client_data(rdata);
                     }
 
                     rs->data_storage(data_storage);
                     rs->reset(true);
 
+                    // Results are only complete on the wire once fetched, so the counter is read afterwards.
+                    rdata->decoded_bytes = data_storage->decoded_bytes();
+                    if (bytes_sent >= 0) {
+                      std::int64_t total_bytes_sent = query_bytes_sent(_usr_dbc_conn->id);
+                      if (total_bytes_sent >= 0) {
+                        rdata->wire_bytes = total_bytes_sent - bytes_sent;
+                        bytes_sent = total_bytes_sent;
+                      }
+                    }
+
                     if (data_storage->valid()) // query statement
                     {
                       if (result_list)
@@ -2185,6 +2254,7 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
                       if (editor)
                         editor->add_panel_for_recordset_from_main(rs);
 
+                      returned_rows_count += rs->row_count();
                       std::string statement_res_msg = std::to_string(rs->row_count()) + _(" row(s) returned");
                       if (!last_statement_info->empty())
                         statement_res_msg.append("\n").append(last_statement_info);
@@ -2206,6 +2276,31 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
           if ((updated_rows_count < 0) && !(resultset_count))
             set_log_message(log_message_index, DbSqlEditorLog::OKMsg, _("OK"), statement,
                             statement_exec_timer.duration_formatted());
+
+          if (logging_queries && _query_history != nullptr) {
+            // Statements without a result set did not fetch the performance_schema data yet.
+            if (query_ps_stats) {
+              query_ps_statistics(_usr_dbc_conn->id, ps_stats);
+              ps_stages = query_ps_stages(ps_stats["EVENT_ID"]);
+              ps_waits = query_ps_waits(ps_stats["EVENT_ID"]);
+              query_ps_stats = false;
+            }
+
+            QueryPerformanceHistory::Entry entry;
+            entry.statement = statement;
+            entry.schema = _usr_dbc_conn->active_schema;
+            entry.executed_at = executed_at;
+            entry.duration = statement_exec_timer.duration();
+            entry.fetch_duration = statement_fetch_timer.duration();
+            entry.rows_affected = updated_rows_count;
+            entry.rows_returned = returned_rows_count;
+            entry.ps_stats = ps_stats;
+            for (auto &stage : ps_stages)
+              entry.ps_stages.push_back({stage.name, stage.wait_time});
+            for (auto &wait : ps_waits)
+              entry.ps_waits.push_back({wait.name, wait.wait_time});
+            history_entries.push_back(entry);
+          }
         }
       }
     } // statement range loop
@@ -2236,6 +2331,10 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
   if (dbc_driver)
     dbc_driver->threadEnd();
 
+  // Written in one go after the whole script ran, to keep the history store out of the timings.
+  if (_query_history != nullptr)
+    _query_history->record(history_entries);
+
   logDebug("SQL execution finished\n");
 
   update_menu_and_toolbar();
@@ -2245,6 +2344,317 @@ grt::StringRef SqlEditorForm::do_exec_sql(Ptr self_ptr, std::shared_ptr<std::str
   return grt::StringRef("");
 }
 
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Reads and splits a script file on its own thread, so that file access and splitting overlap with the
+ * statement execution. Statements are handed out in groups of roughly one network packet and only a few
+ * groups are buffered, which keeps memory use bounded regardless of the file size.
+ */
+class BulkScriptReader {
+public:
+  struct Group {
+    std::list<std::string> statements;
+    std::uint64_t start_offset;                  // File offset where the first statement of the group begins.
+    std::vector<std::uint64_t> statement_ends;  // File offset right after each statement.
+
+    // File offset where the statement at the given index begins.
+    std::uint64_t statement_offset(size_t index) const {
+      return index == 0 ? start_offset : statement_ends[std::min(index, statement_ends.size()) - 1];
+    }
+  };
+
+  BulkScriptReader(FILE *file, SqlFacade::Ref sql_facade, size_t group_size)
+    : _file(file), _stream(sql_facade), _group_size(group_size), _bytes_read(0), _finished(false), _stopped(false) {
+  }
+
+  ~BulkScriptReader() {
+    stop();
+  }
+
+  void start() {
+    _thread = std::thread(&BulkScriptReader::read, this);
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopped = true;
+    }
+    _changed.notify_all();
+    if (_thread.joinable())
+      _thread.join();
+  }
+
+  // Waits for the next group of statements. Returns false once the whole file was handed out.
+  bool next(Group &group) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _changed.wait(lock, [this]() { return !_groups.empty() || _finished; });
+    if (_groups.empty())
+      return false;
+
+    group.statements.swap(_groups.front().statements);
+    group.statement_ends.swap(_groups.front().statement_ends);
+    group.start_offset = _groups.front().start_offset;
+    _groups.pop_front();
+    _changed.notify_all();
+    return true;
+  }
+
+  std::uint64_t bytes_read() const {
+    return _bytes_read;
+  }
+
+  std::string error() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _error;
+  }
+
+private:
+  static const size_t MaxPendingGroups = 4;
+
+  void read() {
+    try {
+      std::vector<char> buffer(1024 * 1024);
+      Group group;
+      group.start_offset = 0;
+      size_t group_bytes = 0;
+      bool done = false;
+      while (!done) {
+        size_t count = fread(buffer.data(), 1, buffer.size(), _file);
+        if (count > 0) {
+          _stream.feed(buffer.data(), count);
+          _bytes_read += count;
+        }
+        if (count < buffer.size()) {
+          if (ferror(_file))
+            throw std::runtime_error(strfmt("Error reading script file: %s", strerror(errno)));
+          _stream.finish();
+          done = true;
+        }
+
+        std::string statement;
+        while (_stream.next(statement)) {
+          group_bytes += statement.size() + 1;
+          group.statements.push_back(std::string());
+          group.statements.back().swap(statement);
+          group.statement_ends.push_back(_stream.offset());
+          if (group_bytes >= _group_size) {
+            std::uint64_t next_start = group.statement_ends.back();
+            if (!push(group))
+              return;
+            group.start_offset = next_start;
+            group_bytes = 0;
+          }
+        }
+      }
+      if (!group.statements.empty())
+        push(group);
+    } catch (std::exception &e) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _error = e.what();
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _finished = true;
+    _changed.notify_all();
+  }
+
+  bool push(Group &group) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _changed.wait(lock, [this]() { return _groups.size() < MaxPendingGroups || _stopped; });
+    if (_stopped)
+      return false;
+
+    _groups.push_back(Group());
+    _groups.back().statements.swap(group.statements);
+    _groups.back().statement_ends.swap(group.statement_ends);
+    _groups.back().start_offset = group.start_offset;
+    _changed.notify_all();
+    return true;
+  }
+
+  FILE *_file;
+  SqlStatementStream _stream;
+  size_t _group_size;
+  std::atomic<std::uint64_t> _bytes_read;
+
+  std::thread _thread;
+  std::mutex _mutex;
+  std::condition_variable _changed;
+  std::deque<Group> _groups;
+  std::string _error;
+  bool _finished;
+  bool _stopped;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Runs a script file in bulk mode, which is meant for large data scripts that are not worth loading into an editor.
+ * The file is read and split while executing, consecutive DML statements are sent to the server in multi-statement
+ * packets and no result tabs or history entries are created per statement. Only errors and a final summary with the
+ * achieved throughput go to the output log.
+ */
+void SqlEditorForm::exec_sql_file_in_bulk(const std::string &path) {
+  if (!connected())
+    throw grt::db_not_connected("Not connected");
+
+  exec_sql_task->exec(false, std::bind(&SqlEditorForm::do_exec_sql_in_bulk, this, weak_ptr_from(this), path));
+}
+
+grt::StringRef SqlEditorForm::do_exec_sql_in_bulk(Ptr self_ptr, const std::string &path) {
+  logDebug("Background task for bulk execution of %s started\n", path.c_str());
+
+  std::shared_ptr<SqlEditorForm> self_ref = (self_ptr).lock();
+  if (!self_ref) {
+    logError("Couldn't aquire lock for SQL editor form\n");
+    return grt::StringRef("");
+  }
+
+  bec::GRTManager::get()->replace_status_text(_("Executing Script..."));
+
+  // add_log_message() will increment this variable on errors or warnings
+  _exec_sql_error_count = 0;
+
+  bool interrupted = true;
+  sql::Driver *dbc_driver = nullptr;
+  FILE *file = nullptr;
+  try {
+    RecMutexLock use_dbc_conn_mutex(ensure_valid_usr_connection());
+
+    dbc_driver = _usr_dbc_conn->ref->getDriver();
+    dbc_driver->threadInit();
+
+    bool is_running_query = true;
+    AutoSwap<bool> is_running_query_keeper(_is_running_query, is_running_query);
+    update_menu_and_toolbar();
+
+    _has_pending_log_messages = false;
+    base::ScopeExitTrigger schedule_log_messages_refresh(std::bind(&SqlEditorForm::refresh_log_messages, this, true));
+
+    file = base_fopen(path.c_str(), "rb");
+    if (file == nullptr)
+      throw std::runtime_error(strfmt(_("Cannot open %s: %s"), path.c_str(), strerror(errno)));
+    double file_size = (double)base_get_file_size(path.c_str());
+
+    std::list<std::string> history_entry;
+    history_entry.push_back(strfmt("-- Script %s executed in bulk mode", path.c_str()));
+    _history->add_entry(history_entry);
+
+    RowId log_message_index = add_log_message(DbSqlEditorLog::BusyMsg, _("Running script in bulk mode..."), path, "");
+
+    // Leave some room in the packet for the statement separators and protocol overhead.
+    size_t batch_size_limit = 0;
+    try {
+      size_t max_allowed_packet = sql::SqlBatchExec::max_allowed_packet(_usr_dbc_conn->ref.get());
+      if (max_allowed_packet > 1024)
+        batch_size_limit = max_allowed_packet - 1024;
+    } catch (sql::SQLException &e) {
+      logWarning("Could not determine max_allowed_packet, executing statements one by one: %s\n", e.what());
+    }
+
+    long statement_count = 0;
+    long error_count = 0;
+    long group_success_count = 0;
+    sql::SqlBatchExec sql_batch_exec;
+    sql_batch_exec.stop_on_error(!_continueOnError);
+    sql_batch_exec.batch_size_limit(batch_size_limit);
+    sql_batch_exec.error_cb([this](long long error_code, const std::string &error_msg, const std::string &statement) {
+      add_log_message(DbSqlEditorLog::ErrorMsg, strfmt(SQL_EXCEPTION_MSG_FORMAT, (int)error_code, error_msg.c_str()),
+                      statement, "");
+      return 0;
+    });
+    sql_batch_exec.batch_exec_stat_cb([&](long success_count, long err_count) {
+      statement_count += success_count + err_count;
+      error_count += err_count;
+      group_success_count = success_count;
+      return 0;
+    });
+
+    const std::unique_ptr<sql::Statement> dbc_statement(_usr_dbc_conn->ref->createStatement());
+    SqlFacade::Ref sql_facade = SqlFacade::instance_for_rdbms(rdbms());
+    BulkScriptReader reader(file, sql_facade, batch_size_limit > 0 ? batch_size_limit : 1024 * 1024);
+    reader.start();
+
+    Timer exec_timer(true);
+    double last_status_update = 0;
+    std::uint64_t executed_offset = 0;
+    std::uint64_t failed_offset = 0;
+    bool stopped = false;
+    bool failed = false;
+    BulkScriptReader::Group group;
+    while (reader.next(group)) {
+      if (_usr_dbc_conn->is_stop_query_requested) {
+        stopped = true;
+        break;
+      }
+
+      if (sql_batch_exec(dbc_statement.get(), group.statements) > 0 && !_continueOnError) {
+        // Statements run in order and execution stops at the first error, so the failing statement is the one
+        // following the successful ones.
+        failed_offset = group.statement_offset((size_t)group_success_count);
+        stopped = true;
+        failed = true;
+        break;
+      }
+      executed_offset = group.statement_ends.back();
+
+      if (exec_timer.duration() - last_status_update >= 1.0) {
+        last_status_update = exec_timer.duration();
+        bec::GRTManager::get()->replace_status_text(
+          strfmt(_("Executing Script... %.0f%% (%.0f statements/s)"),
+                 file_size > 0 ? 100 * reader.bytes_read() / file_size : 0.0, statement_count / last_status_update));
+      }
+    }
+    reader.stop();
+    exec_timer.stop();
+
+    std::string error = reader.error();
+    if (!error.empty())
+      throw std::runtime_error(error);
+
+    double duration = std::max(exec_timer.duration(), 0.001);
+    std::string message = strfmt(_("%li statement(s) executed, %li error(s), %.0f statements/s, %.2f MB/s"),
+                                 statement_count, error_count, statement_count / duration,
+                                 executed_offset / duration / (1024 * 1024));
+    if (failed)
+      message.append(strfmt(_("\nExecution stopped at the statement starting at byte %llu of the script"),
+                            (unsigned long long)failed_offset));
+    else if (stopped)
+      message.append(
+        strfmt(_("\nExecution stopped after byte %llu of the script"), (unsigned long long)executed_offset));
+    set_log_message(log_message_index, error_count > 0 ? DbSqlEditorLog::ErrorMsg : DbSqlEditorLog::OKMsg, message,
+                    path, exec_timer.duration_formatted());
+
+    // The script may have changed the default schema or the sql mode.
+    cache_active_schema_name();
+    cache_sql_mode();
+
+    interrupted = stopped;
+    if (!interrupted)
+      bec::GRTManager::get()->replace_status_text(_("Script Completed"));
+  }
+  CATCH_ANY_EXCEPTION_AND_DISPATCH(path)
+
+  if (interrupted)
+    bec::GRTManager::get()->replace_status_text(_("Script interrupted"));
+
+  if (file != nullptr)
+    fclose(file);
+
+  if (dbc_driver)
+    dbc_driver->threadEnd();
+
+  logDebug("Bulk execution finished\n");
+
+  update_menu_and_toolbar();
+
+  _usr_dbc_conn->is_stop_query_requested = false;
+
+  return grt::StringRef("");
+}
+
 void SqlEditorForm::exec_management_sql(const std::string &sql, bool log) {
   sql::Dbc_connection_handler::Ref conn;
   base::RecMutexLock lock(ensure_valid_aux_connection(conn));
@@ -2522,6 +2932,92 @@ bool SqlEditorForm::run_data_changes_commit_wizard(Recordset::Ptr rs_ptr, bool s
   return !wizard.has_errors();
 }
 
+/**
+ * Runs a script file through the script run wizard without loading it into an editor. The file is executed from disk
+ * with bounded memory use, so it can be of any size. The wizard offers a default schema and character set for the
+ * script. If execution stops on an error, going back in the wizard and applying again continues after the last
+ * statement that succeeded.
+ */
+bool SqlEditorForm::run_sql_script_file_wizard(const std::string &path) {
+  SqlScriptRunWizard wizard(rdbms_version(), "", "");
+  wizard.set_title(_("Run SQL Script File"));
+  wizard.script_file_runner.reset(new SqlScriptFileRunner(path, SqlFacade::instance_for_rdbms(rdbms())));
+  wizard.schema_names = _live_tree->fetch_schema_list();
+  std::sort(wizard.schema_names.begin(), wizard.schema_names.end());
+  std::set<std::string> charsets = valid_charsets();
+  wizard.charset_names.assign(charsets.begin(), charsets.end());
+
+  scoped_connection c1(
+    on_sql_script_run_error.connect(std::bind(&SqlScriptApplyPage::on_error, wizard.apply_page, std::placeholders::_1,
+                                              std::placeholders::_2, std::placeholders::_3)));
+  scoped_connection c2(on_sql_script_run_progress.connect(
+    std::bind(&SqlScriptApplyPage::on_exec_progress, wizard.apply_page, std::placeholders::_1)));
+  scoped_connection c3(on_sql_script_run_statistics.connect(
+    std::bind(&SqlScriptApplyPage::on_exec_stat, wizard.apply_page, std::placeholders::_1, std::placeholders::_2)));
+
+  wizard.apply_page->apply_sql_script_file =
+    std::bind(&SqlEditorForm::apply_sql_script_file, this, std::placeholders::_1);
+  SqlScriptFileRunner *runner = wizard.script_file_runner.get();
+  wizard.abort_apply = [this, runner]() {
+    runner->stop();
+    cancel_query();
+  };
+  wizard.run_modal();
+
+  return wizard.applied() && !wizard.has_errors();
+}
+
+void SqlEditorForm::apply_sql_script_file(SqlScriptFileRunner &runner) {
+  std::uint64_t start_offset = runner.offset();
+  RowId log_id = add_log_message(DbSqlEditorLog::BusyMsg, _("Running script file..."), runner.path(), "");
+
+  sql::SqlBatchExec sql_batch_exec;
+  sql_batch_exec.stop_on_error(true);
+  sql_batch_exec.error_cb(std::ref(on_sql_script_run_error));
+  sql_batch_exec.batch_exec_progress_cb(std::ref(on_sql_script_run_progress));
+  sql_batch_exec.batch_exec_stat_cb(std::ref(on_sql_script_run_statistics));
+
+  Timer exec_timer(true);
+  try {
+    RecMutexLock usr_dbc_conn_mutex(ensure_valid_usr_connection(true));
+
+    // Consecutive DML is sent in multi-statement packets, leaving some room for separators and protocol overhead.
+    size_t batch_size_limit = 0;
+    try {
+      size_t max_allowed_packet = sql::SqlBatchExec::max_allowed_packet(_usr_dbc_conn->ref.get());
+      if (max_allowed_packet > 1024)
+        batch_size_limit = max_allowed_packet - 1024;
+    } catch (sql::SQLException &e) {
+      logWarning("Could not determine max_allowed_packet, executing statements one by one: %s\n", e.what());
+    }
+    sql_batch_exec.batch_size_limit(batch_size_limit);
+
+    std::unique_ptr<sql::Statement> stmt(_usr_dbc_conn->ref->createStatement());
+    runner.run(stmt.get(), sql_batch_exec, batch_size_limit > 0 ? batch_size_limit : 1024 * 1024);
+  } catch (std::exception &e) {
+    set_log_message(log_id, DbSqlEditorLog::ErrorMsg, strfmt(EXCEPTION_MSG_FORMAT, e.what()), runner.path(), "");
+    throw;
+  }
+  exec_timer.stop();
+
+  std::list<std::string> history_entry;
+  history_entry.push_back(strfmt("-- Script %s executed from byte %llu to %llu", runner.path().c_str(),
+                                 (unsigned long long)start_offset, (unsigned long long)runner.offset()));
+  _history->add_entry(history_entry);
+
+  if (runner.finished())
+    set_log_message(log_id, DbSqlEditorLog::OKMsg, _("Script file executed"), runner.path(),
+                    exec_timer.duration_formatted());
+  else
+    set_log_message(log_id, DbSqlEditorLog::ErrorMsg,
+                    strfmt(_("Script file execution stopped after byte %llu"), (unsigned long long)runner.offset()),
+                    runner.path(), exec_timer.duration_formatted());
+
+  // The script may have changed the default schema or the sql mode.
+  cache_active_schema_name();
+  cache_sql_mode();
+}
+
 void SqlEditorForm::apply_object_alter_script(const std::string &alter_script, bec::DBObjectEditorBE *obj_editor,
                                               RowId log_id) {
   set_log_message(
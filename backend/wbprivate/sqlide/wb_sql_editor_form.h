@@ -64,8 +64,10 @@ namespace bec {
 class QuerySidePalette;
 class SqlEditorTreeController;
 class ColumnWidthCache;
+class QueryPerformanceHistory;
 class SqlEditorPanel;
 class SqlEditorResult;
+class SqlScriptFileRunner;
 
 typedef std::vector<Recordset::Ref> Recordsets;
 typedef std::shared_ptr<Recordsets> RecordsetsRef;
@@ -97,12 +99,17 @@ public:
   public:
     SqlEditorResult *result_panel;
     std::string generator_query;
+    std::string schema_name;
 
     double duration;
     std::string ps_stat_error;
     std::map<std::string, std::int64_t> ps_stat_info;
     std::vector<PSStage> ps_stage_info;
     std::vector<PSWait> ps_wait_info;
+
+    std::string transfer_profile;
+    std::int64_t wire_bytes;    // sent by the server for this result, as counted by it (after compression)
+    std::int64_t decoded_bytes; // result data as fetched by the client
   };
 
 public:
@@ -292,6 +299,7 @@ private:
   void update_sql_mode_for_editors();
 
   void query_ps_statistics(std::int64_t conn_id, std::map<std::string, std::int64_t> &stats);
+  std::int64_t query_bytes_sent(std::int64_t conn_id);
 
   std::vector<SqlEditorForm::PSStage> query_ps_stages(std::int64_t stmt_event_id);
   std::vector<SqlEditorForm::PSWait> query_ps_waits(std::int64_t stmt_event_id);
@@ -335,6 +343,10 @@ public:
     return _column_width_cache;
   }
 
+  QueryPerformanceHistory *query_history() {
+    return _query_history;
+  }
+
   bool exec_editor_sql(SqlEditorPanel *editor, bool sync, bool current_statement_only = false,
                        bool wrap_with_non_std_delimiter = false, bool dont_add_limit_clause = false,
                        SqlEditorResult *into_result = NULL);
@@ -343,6 +355,8 @@ public:
 
   RecordsetsRef exec_sql_returning_results(const std::string &sql_script, bool dont_add_limit_clause);
 
+  void exec_sql_file_in_bulk(const std::string &path);
+
   void exec_management_sql(const std::string &sql, bool log);
   db_query_ResultsetRef exec_management_query(const std::string &sql, bool log);
 
@@ -362,6 +376,7 @@ private:
 
   grt::StringRef do_exec_sql(Ptr self_ptr, std::shared_ptr<std::string> sql, SqlEditorPanel *editor, ExecFlags flags,
                              RecordsetsRef result_list);
+  grt::StringRef do_exec_sql_in_bulk(Ptr self_ptr, const std::string &path);
 
   void handle_command_side_effects(const std::string &sql);
 
@@ -399,11 +414,13 @@ public:
   void apply_object_alter_script(const std::string &alter_script, bec::DBObjectEditorBE *obj_editor, RowId log_id);
   bool run_live_object_alteration_wizard(const std::string &alter_script, bec::DBObjectEditorBE *obj_editor,
                                          RowId log_id, const std::string &log_context);
+  bool run_sql_script_file_wizard(const std::string &path);
 
 private:
   void apply_changes_to_recordset(Recordset::Ptr rs_ptr);
   bool run_data_changes_commit_wizard(Recordset::Ptr rs_ptr, bool skip_commit);
   void apply_data_changes_commit(const std::string &sql_script_text, Recordset::Ptr rs_ptr, bool skip_commit);
+  void apply_sql_script_file(SqlScriptFileRunner &runner);
   void update_editor_title_schema(const std::string &schema);
 
 public:
@@ -558,6 +575,7 @@ private:
   ServerState _last_server_running_state = UnknownState;
 
   ColumnWidthCache *_column_width_cache = nullptr;
+  QueryPerformanceHistory *_query_history = nullptr;
 
   parsers::SymbolTable _staticServerSymbols; // Charsets, collations, engines.
   parsers::SymbolTable _databaseSymbols; // All available db objects reachable via the current connection.
@@ -35,6 +35,7 @@
 #include "objimpl/db.query/db_query_EditableResultset.h"
 
 #include "sqlide/column_width_cache.h"
+#include "sqlide/query_performance_history.h"
 
 #include "base/sqlstring.h"
 #include "grt/parse_utils.h"
@@ -108,10 +109,12 @@ SqlEditorResult::SqlEditorResult(SqlEditorPanel *owner)
   _column_info_menu = NULL;
   _column_info_created = false;
   _query_stats_created = false;
+  _query_history_created = false;
   _form_view_created = false;
 
   _column_info_box = nullptr;
   _query_stats_box = nullptr;
+  _query_history_box = nullptr;
   _execution_plan_placeholder = nullptr;
   _query_stats_panel = nullptr;
   _form_result_view = nullptr;
@@ -166,6 +169,8 @@ void SqlEditorResult::updateColors() {
     _column_info_box->set_back_color(background);
   if (_query_stats_box != nullptr)
     _query_stats_box->set_back_color(background);
+  if (_query_history_box != nullptr)
+    _query_history_box->set_back_color(background);
   if (_execution_plan_placeholder != nullptr)
     _execution_plan_placeholder->set_back_color(background);
   if (_query_stats_panel != nullptr)
@@ -422,6 +427,9 @@ void SqlEditorResult::switch_tab() {
     } else if (tab->identifier() == "query_stats" && !_query_stats_created) {
       _query_stats_created = true;
       create_query_stats_panel();
+    } else if (tab->identifier() == "query_history" && !_query_history_created) {
+      _query_history_created = true;
+      create_query_history_panel();
     } else if (tab->identifier() == "form_result") {
       if (!_form_view_created) {
         _form_view_created = true;
@@ -709,6 +717,12 @@ void SqlEditorResult::dock_result_grid(mforms::GridView *view) {
     _query_stats_box->set_identifier("query_stats");
     _tabdock.dock_view(_query_stats_box, "output_type-querystats.png");
   }
+  if (_owner->owner()->query_history() != nullptr) {
+    _query_history_box = mforms::manage(new mforms::AppView(false, "Result Query History", "ResultQueryHistory", false));
+    _query_history_box->set_title("Query\nHistory");
+    _query_history_box->set_identifier("query_history");
+    _tabdock.dock_view(_query_history_box, "output_type-querystats.png");
+  }
 
   create_spatial_view_panel_if_needed();
 
@@ -1061,6 +1075,17 @@ void SqlEditorResult::create_query_stats_panel() {
     info = strfmt("Execution time: %s\n", format_ps_time(std::int64_t(rsdata->duration * 1000000000000.0)).c_str());
     box->add(mforms::manage(new mforms::Label(info)), false, true);
 
+    box->add(bold_label("Network Transfer:"), false, true);
+    info = strfmt("Transfer profile: %s\n", rsdata->transfer_profile.c_str());
+    info.append(strfmt("Result data (decoded): %s\n", base::sizefmt(rsdata->decoded_bytes, false).c_str()));
+    if (rsdata->wire_bytes > 0) {
+      info.append(strfmt("Bytes on the wire: %s\n", base::sizefmt(rsdata->wire_bytes, false).c_str()));
+      if (rsdata->decoded_bytes > 0)
+        info.append(strfmt("Wire / decoded ratio: %.2f\n", (double)rsdata->wire_bytes / rsdata->decoded_bytes));
+    } else
+      info.append("Bytes on the wire: n/a (needs Performance Schema stats)\n");
+    box->add(mforms::manage(new mforms::Label(info)), false, true);
+
     // if we're in a server with PS, show some extra PS goodies
     // we need to convert this to long long it cause int64_t is not the same (long long) on the all platforms.
     std::map<std::string, long long int> ps_stats;
@@ -1180,6 +1205,111 @@ void SqlEditorResult::create_query_stats_panel() {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+static std::string format_history_time(double seconds) {
+  return base::strfmt("%.3f ms", seconds * 1000.0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Shows how the execution time of the statement behind this result developed over the last days, as recorded
+ * by the query history of the connection, plus all statements whose recent timings are notably worse than before.
+ */
+void SqlEditorResult::create_query_history_panel() {
+  static const double day = 24 * 3600.0;
+  static const double regression_factor = 1.5;
+  static const size_t regression_min_count = 5;
+
+  RETURN_IF_FAIL_TO_RETAIN_WEAK_PTR(Recordset, _rset, rs) {
+    SqlEditorForm::RecordsetData *rsdata = dynamic_cast<SqlEditorForm::RecordsetData *>(rs->client_data());
+    QueryPerformanceHistory *history = _owner->owner()->query_history();
+
+    mforms::ToolBar *tbar = mforms::manage(new mforms::ToolBar(mforms::SecondaryToolBar));
+    _toolbars.push_back(tbar);
+    mforms::ToolBarItem *item;
+    item = mforms::manage(new mforms::ToolBarItem(mforms::TitleItem));
+    item->set_text("Query History");
+    tbar->add_item(item);
+
+    add_switch_toggle_toolbar_item(tbar);
+
+    _query_history_box->add(tbar, false, true);
+
+    mforms::Box *box = mforms::manage(new mforms::Box(false));
+    box->set_padding(8);
+    box->set_spacing(8);
+
+    std::string digest_text = history->digest_text(rs->generator_query(), rsdata ? rsdata->schema_name : "");
+    std::string digest = QueryPerformanceHistory::digest(digest_text);
+    box->add(bold_label("Statement (normalized):"), false, true);
+    mforms::Label *label = mforms::manage(new mforms::Label(digest_text));
+    label->set_wrap_text(true);
+    box->add(label, false, true);
+
+    std::vector<QueryPerformanceHistory::Regression> regressions =
+      history->regressions(7 * day, regression_factor, regression_min_count);
+    for (auto &regression : regressions) {
+      if (regression.digest == digest) {
+        box->add(bold_label(strfmt("This statement got slower: the 95th percentile of the last 7 days is %s, "
+                                   "before it was %s.",
+                                   format_history_time(regression.recent_p95).c_str(),
+                                   format_history_time(regression.baseline_p95).c_str())),
+                 false, true);
+        break;
+      }
+    }
+
+    mforms::TreeView *tree = mforms::manage(
+      new mforms::TreeView(mforms::TreeFlatList | mforms::TreeAltRowColors | mforms::TreeShowRowLines |
+                           mforms::TreeShowColumnLines));
+    tree->add_column(mforms::StringColumnType, "Day (UTC)", 100);
+    tree->add_column(mforms::IntegerColumnType, "Executions", 80);
+    tree->add_column(mforms::NumberWithUnitColumnType, "Median", 100);
+    tree->add_column(mforms::NumberWithUnitColumnType, "95th Percentile", 100);
+    tree->add_column(mforms::NumberWithUnitColumnType, "99th Percentile", 100);
+    tree->add_column(mforms::NumberWithUnitColumnType, "Max", 100);
+    tree->end_columns();
+
+    for (auto &period : history->percentiles(digest, day, 30)) {
+      char date[32];
+      time_t start = (time_t)period.start;
+      strftime(date, sizeof(date), "%Y-%m-%d", gmtime(&start));
+
+      mforms::TreeNodeRef node = tree->add_node();
+      node->set_string(0, date);
+      node->set_int(1, (int)period.count);
+      node->set_string(2, format_history_time(period.p50));
+      node->set_string(3, format_history_time(period.p95));
+      node->set_string(4, format_history_time(period.p99));
+      node->set_string(5, format_history_time(period.max));
+    }
+    box->add(tree, true, true);
+
+    box->add(bold_label("Statements that got slower over the last 7 days:"), false, true);
+    tree = mforms::manage(
+      new mforms::TreeView(mforms::TreeFlatList | mforms::TreeAltRowColors | mforms::TreeShowRowLines |
+                           mforms::TreeShowColumnLines));
+    tree->add_column(mforms::StringColumnType, "Statement", 400);
+    tree->add_column(mforms::IntegerColumnType, "Executions", 80);
+    tree->add_column(mforms::NumberWithUnitColumnType, "95th Percentile", 100);
+    tree->add_column(mforms::NumberWithUnitColumnType, "Before", 100);
+    tree->end_columns();
+
+    for (auto &regression : regressions) {
+      mforms::TreeNodeRef node = tree->add_node();
+      node->set_string(0, regression.digest_text);
+      node->set_int(1, (int)regression.recent_count);
+      node->set_string(2, format_history_time(regression.recent_p95));
+      node->set_string(3, format_history_time(regression.baseline_p95));
+    }
+    box->add(tree, true, true);
+
+    _query_history_box->add(box, true, true);
+  }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 void SqlEditorResult::view_record_in_form(int row_id) {
   if (_form_result_view) {
     _tabview.set_active_tab(1);
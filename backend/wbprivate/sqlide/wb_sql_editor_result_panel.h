@@ -122,6 +122,7 @@ private:
   mforms::AppView *_column_info_box;
   mforms::AppView *_query_stats_box;
   mforms::ScrollPanel *_query_stats_panel;
+  mforms::AppView *_query_history_box;
   mforms::AppView *_resultset_placeholder;
   mforms::AppView *_execution_plan_placeholder;
   ResultFormView *_form_result_view;
@@ -139,6 +140,7 @@ private:
 
   bool _column_info_created;
   bool _query_stats_created;
+  bool _query_history_created;
   bool _form_view_created;
   bool _spatial_view_initialized;
 
@@ -154,6 +156,7 @@ private:
   void switcher_collapsed();
 
   void create_query_stats_panel();
+  void create_query_history_panel();
   void create_column_info_panel();
   void create_spatial_view_panel_if_needed();
 
@@ -161,11 +161,13 @@ SqlEditorTreeController::SqlEditorTreeController(SqlEditorForm *owner)
 
   live_schemata_refresh_task->desc("Live Schema Refresh Task");
   live_schemata_refresh_task->send_task_res_msg(false);
+  live_schemata_refresh_task->lane(bec::GRTExecutor::BackgroundLane);
   live_schemata_refresh_task->msg_cb(std::bind(&SqlEditorForm::add_log_message, _owner, std::placeholders::_1,
                                                std::placeholders::_2, std::placeholders::_3, ""));
 
   live_schema_fetch_task->desc("Live Schema Fetch Task");
   live_schema_fetch_task->send_task_res_msg(false);
+  live_schema_fetch_task->lane(bec::GRTExecutor::InteractiveLane);
   live_schema_fetch_task->msg_cb(std::bind(&SqlEditorForm::add_log_message, _owner, std::placeholders::_1,
                                            std::placeholders::_2, std::placeholders::_3, ""));
 }
@@ -87,6 +87,18 @@ grt::IntegerRef ssh::SSHFileWrapper::seek(const size_t offset) {
   return sftp_seek64(_file, offset);
 }
 
+// The size of the file this handle refers to, which may differ from what is found at its path by now.
+grt::IntegerRef ssh::SSHFileWrapper::size() {
+  auto lock = _session->lockSession();
+  sftp_attributes info = sftp_fstat(_file);
+  if (info == nullptr)
+    throw SSHSftpException(ssh_get_error(_file->sftp->session));
+
+  uint64_t size = info->size;
+  sftp_attributes_free(info);
+  return (std::size_t)size;
+}
+
 grt::IntegerRef ssh::SSHFileWrapper::tell() {
   auto lock = _session->lockSession();
   return (std::size_t)sftp_tell64(_file);
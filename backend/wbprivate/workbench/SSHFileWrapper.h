@@ -44,6 +44,7 @@ namespace ssh {
     virtual grt::StringRef read(const size_t length);
     virtual grt::StringRef readline();
     virtual grt::IntegerRef seek(const size_t offset);
+    virtual grt::IntegerRef size();
     virtual grt::IntegerRef tell();
   };
 }  /* namespace ssh */
@@ -24,6 +24,19 @@
 #include "base/util_functions.h"
 #include "base/file_utilities.h"
 
+#include <stdlib.h>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+#ifndef _MSC_VER
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
 #include "wb_helpers.h"
 #include "SSHCommon.h"
 #include "SSHTunnelManager.h"
@@ -272,6 +285,222 @@ TEST_FUNCTION(5) {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+TEST_FUNCTION(6) {
+  // The tunnel ring buffers must keep data in order when wrapping around their end.
+  ssh::RingBuffer buffer(8);
+  std::size_t len = 0;
+  char *in = buffer.writePtr(len);
+  ensure_equals("Initial free space", len, 8U);
+  memcpy(in, "abcdef", 6);
+  buffer.commit(6);
+
+  const char *out = buffer.readPtr(len);
+  ensure_equals("Readable data", std::string(out, len), "abcdef");
+  buffer.consume(4);
+
+  in = buffer.writePtr(len);
+  ensure_equals("Free space up to the end", len, 2U);
+  memcpy(in, "gh", 2);
+  buffer.commit(2);
+  in = buffer.writePtr(len);
+  ensure_equals("Wrapped free space", len, 4U);
+  memcpy(in, "ijkl", 4);
+  buffer.commit(4);
+  ensure_true("Buffer is full", buffer.full());
+
+  std::string data;
+  while (!buffer.empty()) {
+    out = buffer.readPtr(len);
+    data.append(out, len);
+    buffer.consume(len);
+  }
+  ensure_equals("Data after wrap around", data, "efghijkl");
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static std::shared_ptr<ssh::SSHSession> connectSftpSession() {
+  ssh::SSHConnectionConfig config;
+  config.localhost = "127.0.0.1";
+  config.remoteSSHhost = test_params->getSSHHostName();
+  config.remoteSSHport = test_params->getSSHPort();
+  config.connectTimeout = 10;
+  config.strictHostKeyCheck = false;
+  ssh::SSHConnectionCredentials credentials;
+  credentials.username = test_params->getSSHUserName();
+  credentials.password = test_params->getSSHPassword();
+  credentials.auth = ssh::SSHAuthtype::PASSWORD;
+
+  auto session = ssh::SSHSession::createSession();
+  auto retVal = session->connect(config, credentials);
+  ensure_true("Connection failed", std::get<0>(retVal) == ssh::SSHReturnType::CONNECTED);
+  return session;
+}
+
+static std::string readLocalFile(const std::string &path) {
+  std::ifstream stream(path, std::ios::binary);
+  std::stringstream content;
+  content << stream.rdbuf();
+  return content.str();
+}
+
+// Runs a transfer of the given size. If BENCHMARK is set in the environment the throughput is printed.
+static void timedTransfer(const std::string &name, std::size_t size, const std::function<void()> &transfer) {
+  auto start = std::chrono::steady_clock::now();
+  transfer();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (getenv("BENCHMARK") != nullptr)
+    std::cout << name << ": " << (seconds > 0 ? size / seconds / (1024 * 1024) : 0) << " MB/s" << std::endl;
+}
+
+TEST_FUNCTION(7) {
+  // Round trip a file large enough to need many pipelined requests, with the different transfer modes.
+  std::string data(20 * 1024 * 1024 + 123, '\0');
+  for (std::size_t i = 0; i < data.size(); ++i)
+    data[i] = (char)(rand() & 0xff);
+
+  auto file = base::makeTmpFile("sftp_upload");
+  std::string uploadPath = file.getPath();
+  fwrite(data.data(), 1, data.size(), file.file());
+  file.dispose();
+  auto download = base::makeTmpFile("sftp_download");
+  std::string downloadPath = download.getPath();
+  download.dispose();
+
+  std::vector<std::shared_ptr<ssh::SSHSession>> sessions = { connectSftpSession(), connectSftpSession() };
+  ssh::SSHSftp sftp(sessions.front(), 0);
+  std::string remoteFile = "tut_ssh_throughput_" + randomString();
+
+  try {
+    timedTransfer("put", data.size(), [&]() { sftp.put(uploadPath, remoteFile); });
+    ensure_equals("Uploaded file size", sftp.stat(remoteFile).size, (uint64_t)data.size());
+
+    timedTransfer("get", data.size(), [&]() { sftp.get(remoteFile, downloadPath); });
+    ensure_true("Downloaded content differs", readLocalFile(downloadPath) == data);
+
+    timedTransfer("getParallel", data.size(),
+                  [&]() { ssh::SSHSftp::getParallel(sessions, remoteFile, downloadPath); });
+    ensure_true("Parallel downloaded content differs", readLocalFile(downloadPath) == data);
+
+    sftp.unlink(remoteFile);
+    timedTransfer("putParallel", data.size(), [&]() { ssh::SSHSftp::putParallel(sessions, uploadPath, remoteFile); });
+    sftp.get(remoteFile, downloadPath);
+    ensure_true("Parallel uploaded content differs", readLocalFile(downloadPath) == data);
+
+    // Without pipelining, and with a size that is a multiple of the chunk size, so the last request ends exactly at
+    // the end of the file.
+    sftp.setPipelining(32768, 1);
+    timedTransfer("get without pipelining", data.size(), [&]() { sftp.get(remoteFile, downloadPath); });
+    ensure_true("Downloaded content differs without pipelining", readLocalFile(downloadPath) == data);
+
+    data.resize(64 * 32768);
+    {
+      std::ofstream stream(uploadPath, std::ios::binary | std::ios::trunc);
+      stream.write(data.data(), data.size());
+    }
+    sftp.unlink(remoteFile);
+    sftp.put(uploadPath, remoteFile);
+    sftp.get(remoteFile, downloadPath);
+    ensure_true("Downloaded content differs for chunk size multiple", readLocalFile(downloadPath) == data);
+  } catch (ssh::SSHSftpException &exc) {
+    fail(std::string("Sftp transfer failed: ").append(exc.what()));
+  }
+
+  sftp.unlink(remoteFile);
+  base::remove(uploadPath);
+  base::remove(downloadPath);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Reads one MySQL protocol packet (header and payload) from a blocking socket. Returns false if the connection ended.
+static bool readPacket(int sock, std::string &packet) {
+  packet.clear();
+  std::size_t needed = 4;
+  while (packet.size() < needed) {
+    char buffer[4096];
+    ssize_t len = recv(sock, buffer, std::min(sizeof(buffer), needed - packet.size()), 0);
+    if (len <= 0)
+      return false;
+    packet.append(buffer, len);
+    if (needed == 4 && packet.size() == 4)
+      needed += (unsigned char)packet[0] | (unsigned char)packet[1] << 8 | (unsigned char)packet[2] << 16;
+  }
+  return true;
+}
+
+TEST_FUNCTION(8) {
+  // When the server closes a connection right after its last reply, both usually arrive in the same poll round.
+  // The reply must still reach the client before the tunnel closes the client socket.
+  ssh::SSHConnectionConfig config;
+  config.localhost = "127.0.0.1";
+  config.remotehost = "127.0.0.1";
+  config.remoteport = test_params->getSSHDbPort();
+  config.remoteSSHhost = test_params->getSSHHostName();
+  config.remoteSSHport = test_params->getSSHPort();
+  config.connectTimeout = 10;
+  config.optionsDir = test_params->getSSHOptionsDir();
+  config.strictHostKeyCheck = false;
+  ssh::SSHConnectionCredentials credentials;
+  credentials.username = test_params->getSSHUserName();
+  credentials.password = test_params->getSSHPassword();
+  credentials.auth = ssh::SSHAuthtype::PASSWORD;
+
+  auto manager = std::unique_ptr<ssh::SSHTunnelManager>(new ssh::SSHTunnelManager());
+  manager->start();
+
+  auto session = ssh::SSHSession::createSession();
+  auto retVal = session->connect(config, credentials);
+  ensure_true("connection established", std::get<0>(retVal) == ssh::SSHReturnType::CONNECTED);
+
+  try {
+    retVal = manager->createTunnel(session);
+  } catch (ssh::SSHTunnelException &exc) {
+    manager->setStop();
+    manager->pokeWakeupSocket();
+    fail(std::string("Unable to create tunnel: ").append(exc.what()));
+  }
+  uint16_t port = std::get<1>(retVal);
+
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  inet_pton(AF_INET, config.localhost.c_str(), &address.sin_addr);
+
+  // Several rounds, as the timing of the server's reply and EOF varies.
+  for (int round = 0; round < 10; ++round) {
+    int sock = (int)socket(AF_INET, SOCK_STREAM, 0);
+    ensure("socket created", sock >= 0);
+#ifdef _MSC_VER
+    DWORD timeout = 10000;
+#else
+    struct timeval timeout = { 10, 0 };
+#endif
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
+    ensure_equals("connected to the tunnel", connect(sock, (struct sockaddr *)&address, sizeof(address)), 0);
+
+    std::string packet;
+    ensure_true("server greeting", readPacket(sock, packet));
+    ensure("protocol version", packet.size() > 4 && packet[4] == 10);
+
+    // A handshake response that is too short makes the server send an error and close the connection at once.
+    const char response[] = { 1, 0, 0, 1, 0 };
+    ensure_equals("response sent", (int)send(sock, response, sizeof(response), 0), (int)sizeof(response));
+
+    bool gotError = false;
+    while (readPacket(sock, packet))
+      gotError = packet.size() > 4 && (unsigned char)packet[4] == 0xff;
+    wbCloseSocket(sock);
+    ensure_true("error packet delivered before the connection closed", gotError);
+  }
+
+  manager->setStop();
+  manager->pokeWakeupSocket();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 TEST_FUNCTION(99) {
   delete _tester;
 }
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "base/file_utilities.h"
+#include "base/string_utilities.h"
+
+#include "wb_helpers.h"
+#include "workbench/wb_log_index.h"
+
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+using namespace wb;
+
+#define LOG_TEST_DIR "log_index_test"
+
+BEGIN_TEST_DATA_CLASS(wb_log_index_test)
+protected:
+  std::string _log_file;
+  std::string _cache_dir;
+
+TEST_DATA_CONSTRUCTOR(wb_log_index_test)
+  : _log_file(base::makePath(LOG_TEST_DIR, "server.err")), _cache_dir(base::makePath(LOG_TEST_DIR, "cache")) {
+  base::remove_recursive(LOG_TEST_DIR);
+  base::create_directory(LOG_TEST_DIR, 0700);
+}
+
+TEST_DATA_DESTRUCTOR(wb_log_index_test) {
+  base::remove_recursive(LOG_TEST_DIR);
+}
+
+  // An error log with one record per second starting at 2018-02-13T10:00:00Z, every 10th record has a
+  // continuation line.
+  std::string error_log(size_t first, size_t count) {
+    std::string log;
+    for (size_t i = first; i < first + count; ++i) {
+      log += base::strfmt("2018-02-13T%02i:%02i:%02i.000000Z 0 [Note] Record %i with some text to make it longer\n",
+                          (int)(10 + i / 3600), (int)(i / 60 % 60), (int)(i % 60), (int)i);
+      if (i % 10 == 0)
+        log += "continuation of the record\n";
+    }
+    return log;
+  }
+
+  void append(const std::string &data) {
+    base::FileHandle file(_log_file, "ab");
+    fwrite(data.data(), 1, data.size(), file.file());
+  }
+
+  void wait_ready(LogFileIndex &index) {
+    for (int i = 0; i < 1000 && !index.ready() && index.error().empty(); ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ensure_equals("no error", index.error(), "");
+    ensure("index ready", index.ready());
+  }
+
+  std::string line_at(uint64_t offset) {
+    std::string content = base::getTextFileContent(_log_file);
+    return content.substr((size_t)offset, content.find('\n', (size_t)offset) - (size_t)offset);
+  }
+END_TEST_DATA_CLASS;
+
+TEST_MODULE(wb_log_index_test, "log file index");
+
+// The timestamp formats of the different server versions.
+TEST_FUNCTION(1) {
+  const int64_t base_time = 1518516062; // 2018-02-13 10:01:02 UTC
+
+  const char *utc = "2018-02-13T10:01:02.123456Z 0 [Note] text";
+  ensure_equals("5.7 UTC", LogFileIndex::parse_time(utc, strlen(utc)), base_time);
+  const char *offset = "2018-02-13T12:01:02.123456+02:00 0 [Note] text";
+  ensure_equals("5.7 with offset", LogFileIndex::parse_time(offset, strlen(offset)), base_time);
+  const char *negative = "2018-02-13T08:31:02-01:30 text";
+  ensure_equals("negative offset", LogFileIndex::parse_time(negative, strlen(negative)), base_time);
+
+  // Local time formats give the same result as mktime.
+  struct tm local;
+  memset(&local, 0, sizeof(local));
+  local.tm_year = 118;
+  local.tm_mon = 1;
+  local.tm_mday = 13;
+  local.tm_hour = 9;
+  local.tm_min = 1;
+  local.tm_sec = 2;
+  local.tm_isdst = -1;
+  int64_t expected = (int64_t)mktime(&local);
+  const char *v56 = "2018-02-13 09:01:02 1234 [Note] text";
+  ensure_equals("5.6", LogFileIndex::parse_time(v56, strlen(v56)), expected);
+  const char *v55 = "180213  9:01:02 [Note] text";
+  ensure_equals("5.5", LogFileIndex::parse_time(v55, strlen(v55)), expected);
+
+  const char *not_a_time = "InnoDB: Starting shutdown...";
+  ensure_equals("no time", LogFileIndex::parse_time(not_a_time, strlen(not_a_time)), -1);
+  const char *bad_month = "2018-13-13T10:01:02Z";
+  ensure_equals("invalid month", LogFileIndex::parse_time(bad_month, strlen(bad_month)), -1);
+  const char *thread_id = "\t\t   42 Query\tSELECT 1";
+  ensure_equals("general log continuation", LogFileIndex::parse_time(thread_id, strlen(thread_id)), -1);
+}
+
+// Records are found by number, time and offset, also past the first checkpoint.
+TEST_FUNCTION(2) {
+  const size_t count = 5000;
+  base::setTextFileContent(_log_file, error_log(0, count) + "incomplete line without line break");
+
+  LogFileIndex index(LogFileIndex::local_source(_log_file), LogFileIndex::ErrorLog, _cache_dir, 64 * 1024);
+  index.start();
+  wait_ready(index);
+
+  ensure_equals("records", index.record_count(), (uint64_t)count);
+  ensure("incomplete line not indexed", index.indexed_size() < index.file_size());
+  ensure_equals("first time", index.first_time(), (int64_t)1518516000);
+  ensure_equals("last time", index.last_time(), (int64_t)1518516000 + (int64_t)count - 1);
+
+  LogFileIndex::Position position = index.find_record(4321);
+  ensure_equals("record number", position.record, 4321U);
+  ensure("record line", base::hasPrefix(line_at(position.offset), "2018-02-13T11:12:01.000000Z 0 [Note] Record 4321 "));
+
+  position = index.find_time(1518516000 + 2500);
+  ensure_equals("record by time", position.record, 2500U);
+  ensure_equals("time", position.time, (int64_t)1518516000 + 2500);
+
+  // An offset inside a record gives the next one, continuation lines are not records.
+  LogFileIndex::Position record_3000 = index.find_record(3000);
+  position = index.find_offset(record_3000.offset + 1);
+  ensure_equals("record by offset", position.record, 3001U);
+  ensure("skips continuation", base::hasPrefix(line_at(position.offset), "2018-02-13T10:50:01"));
+
+  position = index.find_record(count + 10);
+  ensure_equals("past the end", position.record, (uint64_t)count);
+  ensure_equals("end offset", position.offset, index.indexed_size());
+}
+
+// Slow log records start at "# Time:" or, for queries logged in the same second, at "# User@Host:".
+TEST_FUNCTION(3) {
+  std::string log = "/usr/sbin/mysqld, Version: 5.6.40 (MySQL Community Server (GPL)). started with:\n"
+                    "Time                 Id Command    Argument\n";
+  for (int i = 0; i < 100; ++i) {
+    if (i % 2 == 0)
+      log += base::strfmt("# Time: 2018-02-13T10:00:%02iZ\n", i / 2);
+    log += "# User@Host: root[root] @ localhost []  Id:     3\n"
+           "# Query_time: 2.000000  Lock_time: 0.000000 Rows_sent: 1  Rows_examined: 0\n"
+           "SET timestamp=1518516000;\n"
+           "SELECT SLEEP(2);\n";
+  }
+  base::setTextFileContent(_log_file, log);
+
+  LogFileIndex index(LogFileIndex::local_source(_log_file), LogFileIndex::SlowLog, _cache_dir);
+  index.start();
+  wait_ready(index);
+
+  ensure_equals("records", index.record_count(), 100U);
+  LogFileIndex::Position position = index.find_record(51);
+  ensure("user line", base::hasPrefix(line_at(position.offset), "# User@Host: "));
+  ensure_equals("inherits time", position.time, (int64_t)1518516025);
+  position = index.find_time(1518516030);
+  ensure_equals("by time", position.record, 60U);
+  ensure("time line", base::hasPrefix(line_at(position.offset), "# Time: 2018-02-13T10:00:30Z"));
+}
+
+// The cached index is reused for an appended file and dropped for a replaced one.
+TEST_FUNCTION(4) {
+  base::setTextFileContent(_log_file, error_log(0, 3000));
+  {
+    LogFileIndex index(LogFileIndex::local_source(_log_file), LogFileIndex::ErrorLog, _cache_dir, 64 * 1024);
+    index.start();
+    wait_ready(index);
+    ensure_equals("records", index.record_count(), 3000U);
+  }
+
+  append(error_log(3000, 1000));
+  {
+    LogFileIndex index(LogFileIndex::local_source(_log_file), LogFileIndex::ErrorLog, _cache_dir, 64 * 1024);
+    index.start();
+    wait_ready(index);
+    ensure_equals("appended records", index.record_count(), 4000U);
+    ensure("appended record", base::hasPrefix(line_at(index.find_record(3500).offset),
+                                              "2018-02-13T10:58:20.000000Z 0 [Note] Record 3500 "));
+  }
+
+  // Same size, but one day later: the old checkpoints must not be used.
+  base::setTextFileContent(_log_file, base::replaceString(error_log(0, 4000), "2018-02-13T", "2018-02-14T"));
+  {
+    LogFileIndex index(LogFileIndex::local_source(_log_file), LogFileIndex::ErrorLog, _cache_dir, 64 * 1024);
+    index.start();
+    wait_ready(index);
+    ensure_equals("records after replace", index.record_count(), 4000U);
+    ensure_equals("first time after replace", index.first_time(), (int64_t)1518516000 + 86400);
+    ensure_equals("record by time", index.find_time(1518516000 + 86400 + 2000).record, 2000U);
+  }
+}
+
+// With a tail interval new records are picked up while the index is open.
+TEST_FUNCTION(5) {
+  base::setTextFileContent(_log_file, error_log(0, 100));
+  LogFileIndex index(LogFileIndex::local_source(_log_file), LogFileIndex::ErrorLog, _cache_dir);
+  index.start(0.05);
+  wait_ready(index);
+  ensure_equals("records", index.record_count(), 100U);
+
+  append(error_log(100, 50));
+  for (int i = 0; i < 500 && index.record_count() < 150; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ensure_equals("tailed records", index.record_count(), 150U);
+  ensure_equals("last time", index.last_time(), (int64_t)1518516000 + 149);
+}
+
+// Rotation renames the log and starts a new file at its path, which the source switches to. Windows does not
+// allow renaming a file that is open.
+#ifndef _MSC_VER
+TEST_FUNCTION(6) {
+  base::setTextFileContent(_log_file, error_log(0, 100));
+  std::shared_ptr<LogFileIndex::Source> source = LogFileIndex::local_source(_log_file);
+  uint64_t old_size = source->size();
+  ensure_equals("size", old_size, (uint64_t)error_log(0, 100).size());
+
+  std::string rotated_file = _log_file + ".1";
+  base::rename(_log_file, rotated_file);
+  ensure_equals("renamed file still open", source->size(), old_size);
+
+  base::setTextFileContent(_log_file, error_log(100, 5));
+  ensure_equals("new file", source->size(), (uint64_t)error_log(100, 5).size());
+  ensure("new content", base::hasPrefix(source->read(0, 100), "2018-02-13T10:01:40.000000Z 0 [Note] Record 100 "));
+
+  // The same happens while the index tails the file.
+  LogFileIndex index(LogFileIndex::local_source(_log_file), LogFileIndex::ErrorLog, _cache_dir);
+  index.start(0.05);
+  wait_ready(index);
+  ensure_equals("records", index.record_count(), 5U);
+
+  base::rename(_log_file, rotated_file);
+  base::setTextFileContent(_log_file, error_log(200, 3));
+  for (int i = 0; i < 500 && index.last_time() != (int64_t)1518516000 + 202; ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ensure_equals("records after rotation", index.record_count(), 3U);
+  ensure_equals("first time after rotation", index.first_time(), (int64_t)1518516000 + 200);
+}
+#endif
+
+END_TESTS
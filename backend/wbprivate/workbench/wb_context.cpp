@@ -582,6 +582,9 @@ void WBContext::finalize() {
   }
 
   _grtManager->get_dispatcher()->shutdown();
+
+  // Pooled connections may go through tunnels, close them first.
+  sql::DriverManager::getDriverManager()->getConnectionPool()->shutdown();
   if (_tunnel_manager) {
     delete _tunnel_manager;
     _tunnel_manager = nullptr;
@@ -1412,6 +1415,7 @@ void WBContext::set_default_options(grt::DictRef options) {
   set_default(options, "DbSqlEditor:CodeCompletionUpperCaseKeywords", 0);
   set_default(options, "DbSqlEditor:ProgressStatusUpdateInterval", 500); // in ms
   set_default(options, "DbSqlEditor:KeepAliveInterval", 600);            // in seconds
+  set_default(options, "DbSqlEditor:PrewarmedConnections", 1);           // idle connections kept open per server
   set_default(options, "DbSqlEditor:ReadTimeOut", 30);                  // in seconds
   set_default(options, "DbSqlEditor:ConnectionTimeOut", 60);             // in seconds
   set_default(options, "DbSqlEditor:MaxQuerySizeToHistory", 65536);
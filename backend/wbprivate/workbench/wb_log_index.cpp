@@ -0,0 +1,799 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "wb_log_index.h"
+
+#include "base/file_functions.h"
+#include "base/file_utilities.h"
+#include "base/log.h"
+#include "base/string_utilities.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+DEFAULT_LOG_DOMAIN("LogIndex")
+
+using namespace wb;
+
+namespace {
+
+  const char cache_magic[8] = {'W', 'B', 'L', 'O', 'G', 'I', 'D', 'X'};
+  const uint32_t cache_version = 1;
+  const size_t read_block_size = 1024 * 1024;
+  const uint64_t scan_slice_size = 64 * 1024 * 1024; // Amount of data indexed before results are published.
+  const uint64_t signature_size = 4096;
+
+  uint64_t fnv1a(const char *data, size_t length, uint64_t hash = 14695981039346656037ULL) {
+    for (size_t i = 0; i < length; ++i) {
+      hash ^= (unsigned char)data[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  bool starts_with(const char *line, size_t length, const char *prefix) {
+    size_t prefix_length = strlen(prefix);
+    return length >= prefix_length && memcmp(line, prefix, prefix_length) == 0;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  class LocalSource : public LogFileIndex::Source {
+  public:
+    LocalSource(const std::string &path) : _path(path), _file(path, "rb") {
+    }
+
+    virtual std::string id() const override {
+      return "file:" + _path;
+    }
+
+    // Log files easily grow beyond what a long can hold on Windows.
+    virtual uint64_t size() override {
+      reopen_if_rotated();
+#ifdef _MSC_VER
+      _fseeki64(_file.file(), 0, SEEK_END);
+      return (uint64_t)_ftelli64(_file.file());
+#else
+      fseeko(_file.file(), 0, SEEK_END);
+      return (uint64_t)ftello(_file.file());
+#endif
+    }
+
+    virtual std::string read(uint64_t offset, size_t length) override {
+      std::string data(length, '\0');
+#ifdef _MSC_VER
+      _fseeki64(_file.file(), offset, SEEK_SET);
+#else
+      fseeko(_file.file(), (off_t)offset, SEEK_SET);
+#endif
+      data.resize(fread(&data[0], 1, length, _file.file()));
+      return data;
+    }
+
+  private:
+    /**
+     * Log rotation renames the file and starts a new one at its path, while the open handle still refers to
+     * the old file. Open the path again if it no longer leads to the file of the handle, the index then sees a
+     * truncated or replaced file. Windows has no inode numbers, a file at the path smaller than the open one is
+     * taken as a new file there.
+     */
+    void reopen_if_rotated() {
+#ifdef _MSC_VER
+      struct _stat path_info, file_info;
+      if (base_stat(_path.c_str(), &path_info) != 0 || _fstat(_fileno(_file.file()), &file_info) != 0)
+        return;
+      bool rotated = path_info.st_size < file_info.st_size;
+#else
+      struct stat path_info, file_info;
+      if (base_stat(_path.c_str(), &path_info) != 0 || fstat(fileno(_file.file()), &file_info) != 0)
+        return;
+      bool rotated = path_info.st_ino != file_info.st_ino || path_info.st_dev != file_info.st_dev;
+#endif
+      if (rotated) {
+        logInfo("%s was rotated, opening the new file\n", _path.c_str());
+        base::FileHandle file(_path, "rb");
+        _file.swap(file);
+      }
+    }
+
+    std::string _path;
+    base::FileHandle _file;
+  };
+
+  //------------------------------------------------------------------------------------------------
+
+  class SftpSource : public LogFileIndex::Source {
+  public:
+    SftpSource(const db_mgmt_SSHConnectionRef &connection, const std::string &server, const std::string &path)
+      : _connection(connection), _server(server), _path(path) {
+      _file = _connection->open(path);
+      if (!_file.is_valid())
+        throw std::runtime_error("Could not open remote file " + path);
+    }
+
+    virtual std::string id() const override {
+      return "sftp:" + _server + ":" + _path;
+    }
+
+    // The size of the open file. SFTP has no inode numbers, a file at the path smaller than the open one is taken
+    // as a rotated log and opened instead.
+    virtual uint64_t size() override {
+      uint64_t size = (uint64_t)*_file->size();
+      try {
+        if ((uint64_t)_connection->stat(_path).get_int("size") < size) {
+          db_mgmt_SSHFileRef file = _connection->open(_path);
+          if (file.is_valid()) {
+            logInfo("%s was rotated, opening the new file\n", id().c_str());
+            _file = file;
+            size = (uint64_t)*_file->size();
+          }
+        }
+      } catch (std::exception &e) {
+        // The new file might not be there yet, keep reading the old one.
+        logDebug("Could not check %s for rotation: %s\n", id().c_str(), e.what());
+      }
+      return size;
+    }
+
+    virtual std::string read(uint64_t offset, size_t length) override {
+      _file->seek((size_t)offset);
+      return *_file->read(length);
+    }
+
+  private:
+    db_mgmt_SSHConnectionRef _connection;
+    db_mgmt_SSHFileRef _file;
+    std::string _server;
+    std::string _path;
+  };
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+
+struct LogFileIndex::ScanState {
+  ScanState() : last_time(0), after_time_line(false) {
+  }
+
+  int64_t last_time;    // Timestamp of the last record which had one.
+  bool after_time_line; // Slow log only: the previous line was a "# Time:" line.
+};
+
+//--------------------------------------------------------------------------------------------------
+
+std::shared_ptr<LogFileIndex::Source> LogFileIndex::local_source(const std::string &path) {
+  return std::shared_ptr<Source>(new LocalSource(path));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::shared_ptr<LogFileIndex::Source> LogFileIndex::sftp_source(const db_mgmt_SSHConnectionRef &connection,
+                                                                const std::string &server, const std::string &path) {
+  return std::shared_ptr<Source>(new SftpSource(connection, server, path));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+LogFileIndex::LogKind LogFileIndex::kind_from_string(const std::string &kind) {
+  if (kind == "error")
+    return ErrorLog;
+  if (kind == "general")
+    return GeneralLog;
+  if (kind == "slow")
+    return SlowLog;
+  throw std::invalid_argument("Unknown log kind: " + kind);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Recognizes the timestamp formats the server used in its logs over the versions:
+ *   2018-02-13T10:01:02.123456Z (5.7+, also with a +hh:mm offset when log_timestamps=SYSTEM)
+ *   2018-02-13 10:01:02 (5.6)
+ *   180213 10:01:02 or 180213  9:01:02 (up to 5.5)
+ */
+int64_t LogFileIndex::parse_time(const char *text, size_t length) {
+  size_t i = 0;
+  auto number = [&](size_t min_digits, size_t max_digits, int &value) {
+    size_t start = i;
+    value = 0;
+    while (i < length && i - start < max_digits && isdigit((unsigned char)text[i]))
+      value = value * 10 + (text[i++] - '0');
+    return i - start >= min_digits;
+  };
+  auto skip = [&](char c) {
+    if (i < length && text[i] == c) {
+      ++i;
+      return true;
+    }
+    return false;
+  };
+
+  int year, month, day, hour, minute, second;
+  if (number(2, 4, year) && skip('-')) {
+    if (!number(1, 2, month) || !skip('-') || !number(2, 2, day))
+      return -1;
+    if (!skip('T') && !skip(' '))
+      return -1;
+    skip(' ');
+  } else {
+    i = 0;
+    if (!number(6, 6, year) || !skip(' '))
+      return -1;
+    skip(' ');
+    day = year % 100;
+    month = (year / 100) % 100;
+    year /= 10000;
+  }
+  if (!number(1, 2, hour) || !skip(':') || !number(2, 2, minute) || !skip(':') || !number(2, 2, second))
+    return -1;
+  if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+    return -1;
+  if (year < 100)
+    year += 2000;
+
+  if (skip('.')) {
+    int fraction;
+    number(1, 9, fraction);
+  }
+
+  if (skip('Z'))
+    return days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+  if (i < length && (text[i] == '+' || text[i] == '-')) {
+    int sign = text[i++] == '-' ? -1 : 1;
+    int offset_hours, offset_minutes;
+    if (number(2, 2, offset_hours) && skip(':') && number(2, 2, offset_minutes))
+      return days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second -
+             sign * (offset_hours * 3600 + offset_minutes * 60);
+  }
+
+  struct tm local;
+  memset(&local, 0, sizeof(local));
+  local.tm_year = year - 1900;
+  local.tm_mon = month - 1;
+  local.tm_mday = day;
+  local.tm_hour = hour;
+  local.tm_min = minute;
+  local.tm_sec = second;
+  local.tm_isdst = -1;
+  return (int64_t)mktime(&local);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+LogFileIndex::LogFileIndex(std::shared_ptr<Source> source, LogKind kind, const std::string &cache_dir,
+                           uint64_t granularity)
+  : _source(source),
+    _kind(kind),
+    _cache_dir(cache_dir),
+    _granularity(std::max(granularity, (uint64_t)read_block_size / 16)),
+    _stop(false),
+    _state(new ScanState()),
+    _file_size(0),
+    _indexed_size(0),
+    _record_count(0),
+    _signature(0),
+    _signature_length(0),
+    _first_time(0),
+    _ready(false) {
+}
+
+//--------------------------------------------------------------------------------------------------
+
+LogFileIndex::~LogFileIndex() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _wakeup.notify_all();
+  if (_thread.joinable())
+    _thread.join();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void LogFileIndex::start(double tail_interval) {
+  if (_thread.joinable())
+    throw std::logic_error("Log index was already started");
+  _thread = std::thread(&LogFileIndex::run, this, tail_interval);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool LogFileIndex::ready() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _ready;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+float LogFileIndex::progress() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_ready || _file_size == 0)
+    return _ready ? 1.0f : 0.0f;
+  return (float)_indexed_size / _file_size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string LogFileIndex::error() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _error;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+uint64_t LogFileIndex::file_size() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _file_size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+uint64_t LogFileIndex::indexed_size() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _indexed_size;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+uint64_t LogFileIndex::record_count() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _record_count;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int64_t LogFileIndex::first_time() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _first_time;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int64_t LogFileIndex::last_time() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _state->last_time;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+LogFileIndex::Position LogFileIndex::find_time(int64_t time) {
+  Position start;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // Checkpoint times grow with the offset, so start at the last one before the wanted time.
+    auto iter = std::partition_point(_checkpoints.begin(), _checkpoints.end(),
+                                     [time](const Position &position) { return position.time < time; });
+    if (iter != _checkpoints.begin())
+      start = *(iter - 1);
+  }
+  return scan_to(start, [time](const Position &position) { return position.time >= time; });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+LogFileIndex::Position LogFileIndex::find_record(uint64_t record) {
+  Position start;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iter = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), record,
+                                 [](uint64_t value, const Position &position) { return value < position.record; });
+    if (iter != _checkpoints.begin())
+      start = *(iter - 1);
+  }
+  return scan_to(start, [record](const Position &position) { return position.record >= record; });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+LogFileIndex::Position LogFileIndex::find_offset(uint64_t offset) {
+  Position start;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iter = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), offset,
+                                 [](uint64_t value, const Position &position) { return value < position.offset; });
+    if (iter != _checkpoints.begin())
+      start = *(iter - 1);
+  }
+  return scan_to(start, [offset](const Position &position) { return position.offset >= offset; });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Reads the records following a checkpoint until one matches. Returns the end of the indexed data
+ * if none does.
+ */
+LogFileIndex::Position LogFileIndex::scan_to(const Position &start, const std::function<bool(const Position &)> &found) {
+  Position result;
+  uint64_t end;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    end = _indexed_size;
+    result.offset = end;
+    result.record = _record_count;
+    result.time = _state->last_time;
+  }
+
+  ScanState state;
+  state.last_time = start.time;
+  uint64_t record = start.record;
+  scan(start.offset, end, end, state, [&](uint64_t offset, int64_t time) {
+    Position position;
+    position.offset = offset;
+    position.record = record++;
+    position.time = time;
+    if (!found(position))
+      return true;
+    result = position;
+    return false;
+  });
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Calls on_record for every record starting in the given range, until it returns false.
+ * Only complete lines are looked at, a line starting before soft_end may be read up to hard_end.
+ * Returns the offset of the first line which wasn't processed.
+ */
+uint64_t LogFileIndex::scan(uint64_t from, uint64_t soft_end, uint64_t hard_end, ScanState &state,
+                            const std::function<bool(uint64_t offset, int64_t time)> &on_record) {
+  std::string data;
+  uint64_t data_offset = from; // File offset of data[0].
+  uint64_t read_offset = from;
+  size_t pos = 0;
+
+  while (!_stop && data_offset + pos < soft_end) {
+    size_t eol = data.find('\n', pos);
+    if (eol == std::string::npos) {
+      if (read_offset >= hard_end)
+        break;
+      data.erase(0, pos);
+      data_offset += pos;
+      pos = 0;
+
+      std::string block;
+      {
+        std::lock_guard<std::mutex> lock(_read_mutex);
+        block = _source->read(read_offset, (size_t)std::min((uint64_t)read_block_size, hard_end - read_offset));
+      }
+      if (block.empty())
+        break;
+      read_offset += block.size();
+      data.append(block);
+      continue;
+    }
+
+    const char *line = data.data() + pos;
+    size_t length = eol - pos;
+    uint64_t line_offset = data_offset + pos;
+    bool is_record = false;
+    int64_t time = -1;
+
+    switch (_kind) {
+      case ErrorLog:
+        time = parse_time(line, length);
+        is_record = time >= 0;
+        break;
+
+      case GeneralLog:
+        time = parse_time(line, length);
+        if (time >= 0)
+          is_record = true;
+        else if (starts_with(line, length, "\t\t")) {
+          // Entries logged in the same second as the previous one start with the thread id only.
+          size_t i = 2;
+          while (i < length && (line[i] == ' ' || line[i] == '\t'))
+            ++i;
+          is_record = i < length && isdigit((unsigned char)line[i]);
+        }
+        break;
+
+      case SlowLog:
+        if (starts_with(line, length, "# Time: ")) {
+          time = parse_time(line + 8, length - 8);
+          is_record = true;
+        } else if (starts_with(line, length, "# User@Host: "))
+          is_record = !state.after_time_line; // 5.6 and older only write the time when it changed.
+        break;
+    }
+
+    if (is_record && !on_record(line_offset, time >= 0 ? time : state.last_time))
+      return line_offset;
+
+    if (time >= 0)
+      state.last_time = time;
+    if (_kind == SlowLog)
+      state.after_time_line = starts_with(line, length, "# Time: ");
+    pos = eol + 1;
+  }
+  return data_offset + pos;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void LogFileIndex::run(double tail_interval) {
+  try {
+    if (load_cache())
+      logDebug("Loaded index of %s with %llu records\n", _source->id().c_str(), (unsigned long long)_record_count);
+
+    if (index_new_data())
+      save_cache();
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _ready = !_stop;
+    }
+
+    while (!_stop && tail_interval > 0) {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _wakeup.wait_for(lock, std::chrono::duration<double>(tail_interval), [this]() { return _stop.load(); });
+      }
+      if (!_stop && index_new_data())
+        save_cache();
+    }
+  } catch (std::exception &e) {
+    logError("Error indexing %s: %s\n", _source->id().c_str(), e.what());
+    std::lock_guard<std::mutex> lock(_mutex);
+    _error = e.what();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void LogFileIndex::reset() {
+  _checkpoints.clear();
+  _state.reset(new ScanState());
+  _indexed_size = 0;
+  _record_count = 0;
+  _signature = 0;
+  _signature_length = 0;
+  _first_time = 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Indexes what was appended to the file since the last pass, publishing the results slice by slice.
+ * Starts over if the file was truncated or replaced. Returns true if the index changed.
+ */
+bool LogFileIndex::index_new_data() {
+  uint64_t size;
+  {
+    std::lock_guard<std::mutex> lock(_read_mutex);
+    size = _source->size();
+  }
+
+  bool changed = false;
+  uint64_t signature_length;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _file_size = size;
+    signature_length = size < _indexed_size ? 0 : _signature_length;
+    if (size < _indexed_size) {
+      logInfo("%s was truncated, indexing it again\n", _source->id().c_str());
+      reset();
+      changed = true;
+    }
+  }
+  if (signature_length > 0 && signature(signature_length) != _signature) {
+    logInfo("%s was replaced, indexing it again\n", _source->id().c_str());
+    std::lock_guard<std::mutex> lock(_mutex);
+    reset();
+    changed = true;
+  }
+
+  while (!_stop) {
+    uint64_t from;
+    uint64_t record;
+    uint64_t next_checkpoint;
+    ScanState state;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      from = _indexed_size;
+      record = _record_count;
+      state = *_state;
+      next_checkpoint = _checkpoints.empty() ? 0 : _checkpoints.back().offset + _granularity;
+    }
+    if (from >= size)
+      break;
+
+    std::vector<Position> checkpoints;
+    int64_t first_time = 0;
+    uint64_t end = scan(from, std::min(size, from + scan_slice_size), size, state, [&](uint64_t offset, int64_t time) {
+      if (offset >= next_checkpoint) {
+        Position position;
+        position.offset = offset;
+        position.record = record;
+        position.time = time;
+        checkpoints.push_back(position);
+        next_checkpoint = offset + _granularity;
+      }
+      if (first_time == 0 && time > 0)
+        first_time = time;
+      ++record;
+      return true;
+    });
+    if (end == from)
+      break; // Only an incomplete line is left.
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _checkpoints.insert(_checkpoints.end(), checkpoints.begin(), checkpoints.end());
+    _indexed_size = end;
+    _record_count = record;
+    *_state = state;
+    if (_first_time == 0)
+      _first_time = first_time;
+    changed = true;
+  }
+
+  if (changed && _signature_length < signature_size) {
+    uint64_t length;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      length = std::min(_indexed_size, signature_size);
+    }
+    uint64_t hash = signature(length);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _signature = hash;
+    _signature_length = length;
+  }
+  return changed;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+uint64_t LogFileIndex::signature(uint64_t length) {
+  std::string data;
+  {
+    std::lock_guard<std::mutex> lock(_read_mutex);
+    data = _source->read(0, (size_t)length);
+  }
+  return fnv1a(data.data(), data.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string LogFileIndex::cache_file() const {
+  std::string id = _source->id();
+  return base::makePath(_cache_dir,
+                        base::strfmt("%016llx-%i.idx", (unsigned long long)fnv1a(id.data(), id.size()), (int)_kind));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool LogFileIndex::load_cache() {
+  std::string path = cache_file();
+  if (!base::file_exists(path))
+    return false;
+
+  try {
+    base::FileHandle file(path, "rb");
+    char magic[sizeof(cache_magic)];
+    uint32_t version;
+    uint64_t granularity, indexed_size, record_count, signature_value, signature_length, count;
+    int64_t first_time;
+    ScanState state;
+    uint8_t after_time_line;
+
+    bool ok = fread(magic, sizeof(magic), 1, file.file()) == 1 && memcmp(magic, cache_magic, sizeof(magic)) == 0 &&
+              fread(&version, sizeof(version), 1, file.file()) == 1 && version == cache_version &&
+              fread(&granularity, sizeof(granularity), 1, file.file()) == 1 && granularity == _granularity &&
+              fread(&indexed_size, sizeof(indexed_size), 1, file.file()) == 1 &&
+              fread(&record_count, sizeof(record_count), 1, file.file()) == 1 &&
+              fread(&signature_value, sizeof(signature_value), 1, file.file()) == 1 &&
+              fread(&signature_length, sizeof(signature_length), 1, file.file()) == 1 &&
+              fread(&first_time, sizeof(first_time), 1, file.file()) == 1 &&
+              fread(&state.last_time, sizeof(state.last_time), 1, file.file()) == 1 &&
+              fread(&after_time_line, sizeof(after_time_line), 1, file.file()) == 1 &&
+              fread(&count, sizeof(count), 1, file.file()) == 1;
+    if (!ok)
+      return false;
+
+    std::vector<Position> checkpoints((size_t)count);
+    for (Position &position : checkpoints) {
+      if (fread(&position.offset, sizeof(position.offset), 1, file.file()) != 1 ||
+          fread(&position.record, sizeof(position.record), 1, file.file()) != 1 ||
+          fread(&position.time, sizeof(position.time), 1, file.file()) != 1)
+        return false;
+    }
+
+    // The cached index is only good if the log file still starts with the same data.
+    {
+      std::lock_guard<std::mutex> lock(_read_mutex);
+      if (_source->size() < indexed_size)
+        return false;
+    }
+    if (signature_length > 0 && signature(signature_length) != signature_value)
+      return false;
+
+    state.after_time_line = after_time_line != 0;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _checkpoints.swap(checkpoints);
+    *_state = state;
+    _indexed_size = indexed_size;
+    _record_count = record_count;
+    _signature = signature_value;
+    _signature_length = signature_length;
+    _first_time = first_time;
+    return true;
+  } catch (std::exception &e) {
+    logWarning("Could not read log index cache %s: %s\n", path.c_str(), e.what());
+    return false;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void LogFileIndex::save_cache() {
+  std::string path = cache_file();
+  try {
+    base::create_directory(_cache_dir, 0700, true);
+    base::FileHandle file(path + ".tmp", "wb");
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t count = _checkpoints.size();
+    uint8_t after_time_line = _state->after_time_line ? 1 : 0;
+    fwrite(cache_magic, sizeof(cache_magic), 1, file.file());
+    fwrite(&cache_version, sizeof(cache_version), 1, file.file());
+    fwrite(&_granularity, sizeof(_granularity), 1, file.file());
+    fwrite(&_indexed_size, sizeof(_indexed_size), 1, file.file());
+    fwrite(&_record_count, sizeof(_record_count), 1, file.file());
+    fwrite(&_signature, sizeof(_signature), 1, file.file());
+    fwrite(&_signature_length, sizeof(_signature_length), 1, file.file());
+    fwrite(&_first_time, sizeof(_first_time), 1, file.file());
+    fwrite(&_state->last_time, sizeof(_state->last_time), 1, file.file());
+    fwrite(&after_time_line, sizeof(after_time_line), 1, file.file());
+    fwrite(&count, sizeof(count), 1, file.file());
+    for (const Position &position : _checkpoints) {
+      fwrite(&position.offset, sizeof(position.offset), 1, file.file());
+      fwrite(&position.record, sizeof(position.record), 1, file.file());
+      fwrite(&position.time, sizeof(position.time), 1, file.file());
+    }
+    file.dispose();
+    base::tryRemove(path);
+    base::rename(path + ".tmp", path);
+  } catch (std::exception &e) {
+    logWarning("Could not write log index cache %s: %s\n", path.c_str(), e.what());
+  }
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include "grts/structs.db.mgmt.h"
+#include "wb_backend_public_interface.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace wb {
+
+  /**
+   * A sparse index over a server log file (error, general query or slow query log), which allows
+   * to jump to a record number or a point in time without reading the file from the start.
+   *
+   * The file is read once in a background thread, remembering the offset, number and timestamp of one
+   * record about every `granularity` bytes. The index is stored in a cache folder and reused as long
+   * as the log file was only appended to. Optionally the thread keeps watching the file and indexes
+   * new records as they are written.
+   */
+  class MYSQLWBBACKEND_PUBLIC_FUNC LogFileIndex {
+  public:
+    enum LogKind { ErrorLog, GeneralLog, SlowLog };
+
+    // Random access to the log file contents.
+    class Source {
+    public:
+      virtual ~Source() {
+      }
+
+      virtual std::string id() const = 0; // Identifies the file in the index cache.
+      virtual uint64_t size() = 0;
+      virtual std::string read(uint64_t offset, size_t length) = 0;
+    };
+
+    static std::shared_ptr<Source> local_source(const std::string &path);
+    // The server name only serves to tell apart equally named files of different servers in the index cache.
+    static std::shared_ptr<Source> sftp_source(const db_mgmt_SSHConnectionRef &connection, const std::string &server,
+                                               const std::string &path);
+
+    struct Position {
+      Position() : offset(0), record(0), time(0) {
+      }
+
+      uint64_t offset; // File offset where the record starts.
+      uint64_t record; // 0 based number of the record.
+      int64_t time;    // Timestamp of the record (or of the last preceding one with a timestamp), 0 if unknown.
+    };
+
+    LogFileIndex(std::shared_ptr<Source> source, LogKind kind, const std::string &cache_dir,
+                 uint64_t granularity = 256 * 1024);
+    ~LogFileIndex();
+
+    // Loads the cached index, if there is one, and indexes the rest of the file in the background.
+    // A tail interval > 0 makes the background thread check for new records every that many seconds.
+    void start(double tail_interval = 0);
+
+    bool ready() const;
+    float progress() const;
+    std::string error() const;
+    uint64_t file_size() const;
+    uint64_t indexed_size() const;
+    uint64_t record_count() const;
+    int64_t first_time() const;
+    int64_t last_time() const;
+
+    // Positions of the first record with a timestamp >= time, of a record by number and of the first record
+    // starting at or after offset. Only the indexed part of the file is considered.
+    Position find_time(int64_t time);
+    Position find_record(uint64_t record);
+    Position find_offset(uint64_t offset);
+
+    static LogKind kind_from_string(const std::string &kind);
+
+    // Parses the timestamp at the start of a log line, returning seconds since the epoch or -1 if the line
+    // doesn't start with one. Timestamps without time zone are taken as local time.
+    static int64_t parse_time(const char *text, size_t length);
+
+  private:
+    struct ScanState;
+
+    void run(double tail_interval);
+    bool index_new_data();
+    void reset();
+    uint64_t scan(uint64_t from, uint64_t soft_end, uint64_t hard_end, ScanState &state,
+                  const std::function<bool(uint64_t offset, int64_t time)> &on_record);
+    Position scan_to(const Position &start, const std::function<bool(const Position &)> &found);
+    uint64_t signature(uint64_t length);
+    std::string cache_file() const;
+    bool load_cache();
+    void save_cache();
+
+    std::shared_ptr<Source> _source;
+    LogKind _kind;
+    std::string _cache_dir;
+    uint64_t _granularity;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _wakeup;
+    std::thread _thread;
+    std::atomic<bool> _stop;
+    std::mutex _read_mutex; // Serializes reads from the source.
+
+    std::vector<Position> _checkpoints;
+    std::unique_ptr<ScanState> _state; // Scanner state at the end of the indexed data.
+    uint64_t _file_size;
+    uint64_t _indexed_size;
+    uint64_t _record_count;
+    uint64_t _signature;        // Hash of the first _signature_length bytes, to detect a rotated log file.
+    uint64_t _signature_length;
+    int64_t _first_time;
+    bool _ready;
+    std::string _error;
+  };
+
+} // namespace wb
@@ -59,7 +59,8 @@ DEFAULT_LOG_DOMAIN(DOMAIN_WB_MODULE)
 
 //--------------------------------------------------------------------------------------------------
 
-WorkbenchImpl::WorkbenchImpl(CPPModuleLoader *loader) : super(loader), _wb(0), _is_other_dbms_initialized(false) {
+WorkbenchImpl::WorkbenchImpl(CPPModuleLoader *loader)
+  : super(loader), _wb(0), _is_other_dbms_initialized(false), _last_log_index_id(0) {
 #ifdef _MSC_VER
   _last_wmi_session_id = 1;
   _last_wmi_monitor_id = 1;
@@ -2040,6 +2041,111 @@ db_mgmt_SSHConnectionRef WorkbenchImpl::createSSHSession(const grt::ObjectRef &v
   return db_mgmt_SSHConnectionRef();
 }
 
+/**
+ * Starts indexing a server log file in the background, see LogFileIndex. Remote files are read through
+ * the given SSH connection, local ones directly. The index is cached in the user data folder.
+ *
+ * @param path The path of the log file.
+ * @param kind The kind of log: error, general or slow.
+ * @param connection The SSH connection for remote files or None for local ones.
+ * @param server Identifies the remote server in the index cache.
+ * @param tailInterval If > 0 the index keeps picking up new records every that many seconds.
+ * @return An id for the other logIndex functions, -1 on error. The index must be released with closeLogIndex.
+ */
+int WorkbenchImpl::openLogIndex(const std::string &path, const std::string &kind,
+                                const db_mgmt_SSHConnectionRef &connection, const std::string &server,
+                                double tailInterval) {
+  try {
+    std::shared_ptr<LogFileIndex::Source> source;
+    if (connection.is_valid())
+      source = LogFileIndex::sftp_source(connection, server, path);
+    else
+      source = LogFileIndex::local_source(path);
+
+    std::shared_ptr<LogFileIndex> index(new LogFileIndex(source, LogFileIndex::kind_from_string(kind),
+                                                         base::makePath(_wb->get_user_datadir(), "log-index")));
+    index->start(tailInterval);
+    _log_indexes[++_last_log_index_id] = index;
+    return _last_log_index_id;
+  } catch (std::exception &e) {
+    logError("Could not index log file %s: %s\n", path.c_str(), e.what());
+    return -1;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static std::shared_ptr<LogFileIndex> get_log_index(const std::map<int, std::shared_ptr<LogFileIndex> > &indexes,
+                                                   int index) {
+  auto iter = indexes.find(index);
+  if (iter == indexes.end())
+    throw std::invalid_argument("Invalid log index id");
+  return iter->second;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static grt::DictRef log_position_dict(const LogFileIndex::Position &position) {
+  grt::DictRef result(true);
+  result.set("offset", grt::IntegerRef((ssize_t)position.offset));
+  result.set("record", grt::IntegerRef((ssize_t)position.record));
+  result.gset("time", (double)position.time);
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the state of a log index: ready (initial pass done), progress (0.0 - 1.0), error, fileSize,
+ * indexedSize, recordCount, firstTime and lastTime (seconds since the epoch, 0 if unknown).
+ */
+grt::DictRef WorkbenchImpl::logIndexInfo(int index) {
+  std::shared_ptr<LogFileIndex> log_index(get_log_index(_log_indexes, index));
+
+  grt::DictRef info(true);
+  info.gset("ready", log_index->ready() ? 1 : 0);
+  info.gset("progress", log_index->progress());
+  info.gset("error", log_index->error());
+  info.set("fileSize", grt::IntegerRef((ssize_t)log_index->file_size()));
+  info.set("indexedSize", grt::IntegerRef((ssize_t)log_index->indexed_size()));
+  info.set("recordCount", grt::IntegerRef((ssize_t)log_index->record_count()));
+  info.gset("firstTime", (double)log_index->first_time());
+  info.gset("lastTime", (double)log_index->last_time());
+  return info;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * The logIndexFind functions return a dict with the offset, record number and time of the first record
+ * logged at or after the given time, with the given number or starting at or after the given offset.
+ */
+grt::DictRef WorkbenchImpl::logIndexFindTime(int index, double time) {
+  return log_position_dict(get_log_index(_log_indexes, index)->find_time((int64_t)time));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+grt::DictRef WorkbenchImpl::logIndexFindRecord(int index, ssize_t record) {
+  return log_position_dict(get_log_index(_log_indexes, index)->find_record((uint64_t)std::max(record, (ssize_t)0)));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+grt::DictRef WorkbenchImpl::logIndexFindOffset(int index, ssize_t offset) {
+  return log_position_dict(get_log_index(_log_indexes, index)->find_offset((uint64_t)std::max(offset, (ssize_t)0)));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int WorkbenchImpl::closeLogIndex(int index) {
+  if (_log_indexes.erase(index) == 0)
+    return -1;
+  return 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+
 /**
 * Removes a connection from the stored connections list along with all associated data
 * (including its server instance entry).
@@ -27,6 +27,7 @@
 #include "grtpp_module_cpp.h"
 
 #include "wb_context.h"
+#include "wb_log_index.h"
 #include "grts/structs.db.mgmt.h"
 #include "interfaces/plugin.h"
 
@@ -165,7 +166,13 @@ namespace wb {
       DECLARE_MODULE_FUNCTION(WorkbenchImpl::initializeOtherRDBMS),
       DECLARE_MODULE_FUNCTION(WorkbenchImpl::deleteConnection),
       DECLARE_MODULE_FUNCTION(WorkbenchImpl::deleteConnectionGroup),
-      DECLARE_MODULE_FUNCTION(WorkbenchImpl::createSSHSession));
+      DECLARE_MODULE_FUNCTION(WorkbenchImpl::createSSHSession),
+
+      // Server log files
+      DECLARE_MODULE_FUNCTION(WorkbenchImpl::openLogIndex), DECLARE_MODULE_FUNCTION(WorkbenchImpl::logIndexInfo),
+      DECLARE_MODULE_FUNCTION(WorkbenchImpl::logIndexFindTime),
+      DECLARE_MODULE_FUNCTION(WorkbenchImpl::logIndexFindRecord),
+      DECLARE_MODULE_FUNCTION(WorkbenchImpl::logIndexFindOffset), DECLARE_MODULE_FUNCTION(WorkbenchImpl::closeLogIndex));
 
   protected:
     virtual void initialization_done() override {
@@ -195,6 +202,9 @@ namespace wb {
     int _last_wmi_monitor_id;
 #endif
 
+    std::map<int, std::shared_ptr<LogFileIndex> > _log_indexes;
+    int _last_log_index_id;
+
     virtual grt::ListRef<app_Plugin> getPluginInfo() override;
 
     int copyToClipboard(const std::string &str);
@@ -333,6 +343,14 @@ namespace wb {
     db_mgmt_SSHConnectionRef createSSHSession(const grt::ObjectRef &val);
     int deleteConnection(const db_mgmt_ConnectionRef &connection);
     int deleteConnectionGroup(const std::string &group);
+
+    int openLogIndex(const std::string &path, const std::string &kind, const db_mgmt_SSHConnectionRef &connection,
+                     const std::string &server, double tailInterval);
+    grt::DictRef logIndexInfo(int index);
+    grt::DictRef logIndexFindTime(int index, double time);
+    grt::DictRef logIndexFindRecord(int index, ssize_t record);
+    grt::DictRef logIndexFindOffset(int index, ssize_t offset);
+    int closeLogIndex(int index);
   };
 };
 
@@ -329,17 +329,20 @@ static void sleep_2ms() {
 
 static GThread *_main_thread = NULL;
 
-GRTDispatcher::GRTDispatcher(bool threaded, bool is_main_dispatcher)
+GRTDispatcher::GRTDispatcher(bool threaded, bool is_main_dispatcher, GRTExecutor::Lane lane)
   : _busy(0),
     _threading_disabled(!threaded),
     _w_runing(0),
     _is_main_dispatcher(is_main_dispatcher),
     _shut_down(false),
-    _started(false) {
+    _started(false),
+    _pooled(threaded && !is_main_dispatcher),
+    _lane(lane),
+    _drain_scheduled(false) {
   _shutdown_callback = false;
 
   if (threaded) {
-    _task_queue = g_async_queue_new();
+    _task_queue = _pooled ? NULL : g_async_queue_new();
     _callback_queue = g_async_queue_new();
   } else {
     _task_queue = NULL;
@@ -366,8 +369,8 @@ GRTDispatcher::~GRTDispatcher() {
 
 //--------------------------------------------------------------------------------------------------
 
-GRTDispatcher::Ref GRTDispatcher::create_dispatcher(bool threaded, bool is_main_dispatcher) {
-  return Ref(new GRTDispatcher(threaded, is_main_dispatcher));
+GRTDispatcher::Ref GRTDispatcher::create_dispatcher(bool threaded, bool is_main_dispatcher, GRTExecutor::Lane lane) {
+  return Ref(new GRTDispatcher(threaded, is_main_dispatcher, lane));
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -376,7 +379,7 @@ void GRTDispatcher::start() {
   _grtm = bec::GRTManager::get();
 
   _shut_down = false;
-  if (!_threading_disabled) {
+  if (!_threading_disabled && !_pooled) {
     logDebug("starting worker thread\n");
 
     GrtDispatcherHelper *helper = new GrtDispatcherHelper(shared_from_this());
@@ -409,6 +412,27 @@ void GRTDispatcher::shutdown() {
 
   _shutdown_callback = true;
 
+  if (_pooled) {
+    // Let the queued tasks run out. Main thread callbacks are released but not executed, as above.
+    if (in_drain_thread())
+      logError("Dispatcher shut down from one of its own tasks, pending tasks are left behind\n");
+    else {
+      bool is_main_thread = g_thread_self() == _main_thread;
+      while (true) {
+        {
+          base::MutexLock lock(_pool_mutex);
+          if (!_drain_scheduled)
+            break;
+        }
+        flush_pending_callbacks();
+        if (_flush_main_thread_and_wait && is_main_thread)
+          _flush_main_thread_and_wait();
+        else
+          sleep_2ms();
+      }
+    }
+  }
+
   // _thread == 0, means that init was not called, but threading_disabled was set to false.
   if (!_threading_disabled && _thread != 0) {
     std::shared_ptr<GrtNullTask> task(new GrtNullTask(shared_from_this()));
@@ -468,45 +492,13 @@ gpointer GRTDispatcher::worker_thread(gpointer data) {
     delete helper;
 #endif
 
-    g_atomic_int_inc(&self->_busy);
-    logDebug3("Running task \"%s\"\n", task->name().c_str());
-
     if (dynamic_cast<GrtNullTask *>(task.get()) != 0) { // a NULL task terminates the thread
       logDebug3("Null task found. Terminating worker thread...\n");
       task->finished(grt::ValueRef());
-      g_atomic_int_dec_and_test(&self->_busy);
       break;
     }
 
-    if (task->is_cancelled()) {
-      logDebug3("Task \"%s\" cancelled\n", task->name().c_str());
-      g_atomic_int_dec_and_test(&self->_busy);
-      continue;
-    }
-
-    int count = grt::GRT::get()->message_handler_count();
-
-    // do pre-execution preparations
-    self->prepare_task(task);
-
-    // execute the task
-    self->execute_task(task);
-
-    logDebug3("Task \"%s\" finished\n", task->name().c_str());
-    if (task->get_error()) {
-      logError("%s\n",
-               std::string(("worker: task '" + task->name() + "' has failed with error:.") + task->get_error()->what())
-                 .c_str());
-      g_atomic_int_dec_and_test(&self->_busy);
-      continue;
-    }
-
-    if (count != grt::GRT::get()->message_handler_count()) {
-      logError("INTERNAL ERROR: Message handler count mismatch after executing task '%s' (%i vs %i)",
-               task->name().c_str(), count, grt::GRT::get()->message_handler_count());
-    }
-
-    g_atomic_int_dec_and_test(&self->_busy);
+    self->run_task(task);
   }
 
   self->worker_thread_release();
@@ -523,6 +515,82 @@ gpointer GRTDispatcher::worker_thread(gpointer data) {
 
 //--------------------------------------------------------------------------------------------------
 
+void GRTDispatcher::run_task(const GRTTaskBase::Ref task) {
+  g_atomic_int_inc(&_busy);
+  logDebug3("Running task \"%s\"\n", task->name().c_str());
+
+  if (task->is_cancelled()) {
+    logDebug3("Task \"%s\" cancelled\n", task->name().c_str());
+    g_atomic_int_dec_and_test(&_busy);
+    return;
+  }
+
+  int count = grt::GRT::get()->message_handler_count();
+
+  // do pre-execution preparations
+  prepare_task(task);
+
+  // execute the task
+  execute_task(task);
+
+  logDebug3("Task \"%s\" finished\n", task->name().c_str());
+  if (task->get_error()) {
+    logError("%s\n",
+             std::string(("worker: task '" + task->name() + "' has failed with error:.") + task->get_error()->what())
+               .c_str());
+    g_atomic_int_dec_and_test(&_busy);
+    return;
+  }
+
+  if (count != grt::GRT::get()->message_handler_count()) {
+    logError("INTERNAL ERROR: Message handler count mismatch after executing task '%s' (%i vs %i)",
+             task->name().c_str(), count, grt::GRT::get()->message_handler_count());
+  }
+
+  g_atomic_int_dec_and_test(&_busy);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Executor job for pooled dispatchers. Runs the queued tasks in order, but only a few of them per job,
+ * so a dispatcher with a long queue doesn't hold on to a pool thread while other dispatchers wait.
+ */
+void GRTDispatcher::drain_pool_tasks() {
+  static const int batch_size = 8;
+
+  for (int i = 0; i < batch_size; ++i) {
+    GRTTaskBase::Ref task;
+    {
+      base::MutexLock lock(_pool_mutex);
+      if (_pool_tasks.empty()) {
+        _drain_scheduled = false;
+        _drain_thread = std::thread::id();
+        return;
+      }
+      task = _pool_tasks.front();
+      _pool_tasks.pop_front();
+      _drain_thread = std::this_thread::get_id();
+    }
+    run_task(task);
+  }
+
+  {
+    base::MutexLock lock(_pool_mutex);
+    _drain_thread = std::thread::id();
+  }
+  GRTExecutor::get()->submit(_lane, std::bind(&GRTDispatcher::drain_pool_tasks, shared_from_this()));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool GRTDispatcher::in_drain_thread() {
+  base::MutexLock lock(_pool_mutex);
+  return _drain_thread == std::this_thread::get_id();
+}
+
+//--------------------------------------------------------------------------------------------------
+
 void GRTDispatcher::execute_now(const GRTTaskBase::Ref task) {
   g_atomic_int_inc(&_busy);
   prepare_task(task);
@@ -539,7 +607,22 @@ void GRTDispatcher::add_task(const GRTTaskBase::Ref task) {
   // task, we have to execute it immediately otherwise we'd just deadlock.
   if (_threading_disabled || _thread == g_thread_self())
     execute_now(task);
-  else {
+  else if (_pooled) {
+    if (in_drain_thread()) {
+      execute_now(task);
+      return;
+    }
+
+    bool schedule;
+    {
+      base::MutexLock lock(_pool_mutex);
+      _pool_tasks.push_back(task);
+      schedule = !_drain_scheduled;
+      _drain_scheduled = true;
+    }
+    if (schedule)
+      GRTExecutor::get()->submit(_lane, std::bind(&GRTDispatcher::drain_pool_tasks, shared_from_this()));
+  } else {
     GRTTaskHelper *helper = new GRTTaskHelper(task);
     g_async_queue_push(_task_queue, helper);
   }
@@ -554,6 +637,11 @@ void GRTDispatcher::cancel_task(const GRTTaskBase::Ref task) {
 //--------------------------------------------------------------------------------------------------
 
 bool GRTDispatcher::get_busy() {
+  if (_pooled) {
+    base::MutexLock lock(_pool_mutex);
+    if (!_pool_tasks.empty())
+      return true;
+  }
   return (_task_queue && g_async_queue_length(_task_queue) > 0) || g_atomic_int_get(&_busy);
 }
 
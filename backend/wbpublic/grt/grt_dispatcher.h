@@ -30,6 +30,7 @@
 #include "grtpp_shell.h"
 
 #include "common.h"
+#include "grt_executor.h"
 
 #include "wbpublic_public_interface.h"
 
@@ -289,6 +290,8 @@ namespace bec {
 
   //------------------------------------------------------------------------------------------------
 
+  // Threaded dispatchers run their tasks one after the other in a background thread. The main dispatcher owns a
+  // dedicated thread, all others are scheduled on the shared GRTExecutor pool in the lane given at creation.
   class WBPUBLICBACKEND_PUBLIC_FUNC GRTDispatcher : public std::enable_shared_from_this<GRTDispatcher> {
   public:
     typedef void (*FlushAndWaitCallback)();
@@ -311,11 +314,23 @@ namespace bec {
     GAsyncQueue *_callback_queue;
     GThread *_thread;
 
+    // Executor state, used by threaded dispatchers other than the main one.
+    bool _pooled;
+    GRTExecutor::Lane _lane;
+    base::Mutex _pool_mutex;
+    std::deque<GRTTaskBase::Ref> _pool_tasks;
+    bool _drain_scheduled;
+    std::thread::id _drain_thread;
+
     static gpointer worker_thread(gpointer data);
 
     GRTTaskBase::Ref _current_task;
 
-    GRTDispatcher(bool threaded, bool is_main_dispatcher);
+    GRTDispatcher(bool threaded, bool is_main_dispatcher, GRTExecutor::Lane lane);
+
+    void run_task(const GRTTaskBase::Ref task);
+    void drain_pool_tasks();
+    bool in_drain_thread();
 
     void prepare_task(const GRTTaskBase::Ref task);
     void execute_task(const GRTTaskBase::Ref task);
@@ -329,7 +344,8 @@ namespace bec {
     bool message_callback(const grt::Message &msg, void *sender);
 
   public:
-    static Ref create_dispatcher(bool threaded, bool is_main_dispatcher);
+    static Ref create_dispatcher(bool threaded, bool is_main_dispatcher,
+                                 GRTExecutor::Lane lane = GRTExecutor::BackgroundLane);
 
     virtual ~GRTDispatcher();
 
@@ -372,6 +388,13 @@ namespace bec {
     GThread *get_thread() const {
       return _thread;
     }
+
+    GRTExecutor::Lane get_lane() const {
+      return _lane;
+    }
+    void set_lane(GRTExecutor::Lane lane) {
+      _lane = lane;
+    }
   };
 
   template <>
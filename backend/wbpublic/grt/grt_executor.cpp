@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2007, 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+
+#include <algorithm>
+
+#include "base/log.h"
+
+#include "grt_executor.h"
+
+#include "mforms/utilities.h"
+
+using namespace bec;
+
+DEFAULT_LOG_DOMAIN("GRTExecutor");
+
+// A job running longer than this frees its worker's slot in the pool limit, see grow_for_long_jobs().
+static const std::chrono::milliseconds long_job_time(500);
+
+static int64_t clock_us(std::chrono::steady_clock::time_point time) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+// Set for the pool threads, so jobs submitted from within a job stay on the submitting worker.
+static thread_local GRTExecutor *current_executor = nullptr;
+static thread_local size_t current_worker = 0;
+
+//--------------------------------------------------------------------------------------------------
+
+GRTExecutor *GRTExecutor::get() {
+  static GRTExecutor executor;
+  return &executor;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const char *GRTExecutor::lane_name(Lane lane) {
+  switch (lane) {
+    case InteractiveLane:
+      return "interactive";
+    case BackgroundLane:
+      return "background";
+    case BulkLane:
+      return "bulk";
+    default:
+      return "unknown";
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+GRTExecutor::GRTExecutor() : _worker_count(0), _pending(0), _idle(0), _next_worker(0), _stopping(false) {
+  size_t cores = std::max(std::thread::hardware_concurrency(), 1U);
+  _workers.resize(std::max<size_t>(256, cores * 8), nullptr);
+  _max_workers = std::max<size_t>(16, cores * 2);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+GRTExecutor::~GRTExecutor() {
+  shutdown();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void GRTExecutor::set_max_workers(size_t count) {
+  std::lock_guard<std::mutex> lock(_spawn_mutex);
+  _max_workers = std::min(std::max<size_t>(count, 1), _workers.size());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+size_t GRTExecutor::max_workers() const {
+  return _max_workers;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+size_t GRTExecutor::worker_count() const {
+  return _worker_count;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Starts another worker if there are less than limit (and the pool capacity is not reached). The first worker
+ * also starts the monitor thread.
+ */
+void GRTExecutor::spawn_worker(size_t limit) {
+  std::lock_guard<std::mutex> lock(_spawn_mutex);
+  size_t index = _worker_count;
+  if (_stopping || index >= std::min(limit, _workers.size()))
+    return;
+
+  // Make the worker visible before it runs, it may already pick up jobs queued in the other workers.
+  Worker *worker = new Worker();
+  _workers[index] = worker;
+  _worker_count = index + 1;
+  worker->thread = std::thread(&GRTExecutor::worker_main, this, index);
+  logDebug("Started worker %i\n", (int)index);
+
+  if (!_monitor.joinable())
+    _monitor = std::thread(&GRTExecutor::monitor_main, this);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+size_t GRTExecutor::long_running_workers() const {
+  int64_t limit = clock_us(Clock::now() - long_job_time);
+  size_t count = _worker_count;
+  size_t result = 0;
+  for (size_t i = 0; i < count; ++i) {
+    int64_t since = _workers[i]->busy_since;
+    if (since != 0 && since < limit)
+      ++result;
+  }
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Jobs like a SQL editor running a query keep their worker for as long as the query takes. Workers busy with
+ * such a long job don't count against the pool limit, so when all workers are busy another one is started
+ * for every long job, instead of letting queued jobs (e.g. from other editor tabs) wait for them.
+ */
+void GRTExecutor::grow_for_long_jobs() {
+  if (_idle > 0 || _pending == 0)
+    return;
+
+  size_t long_running = long_running_workers();
+  if (long_running > 0) {
+    logDebug("%i workers busy with long jobs, allowing more workers\n", (int)long_running);
+    spawn_worker(_max_workers + long_running);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Looks for jobs stuck behind long running ones. A job can be queued while all workers are busy with jobs that
+ * only later turn out to be long, and nothing else would start a worker for it then.
+ */
+void GRTExecutor::monitor_main() {
+  mforms::Utilities::set_thread_name("GRTExecutor monitor");
+
+  std::unique_lock<std::mutex> lock(_idle_mutex);
+  while (!_stopping) {
+    _monitor_condition.wait_for(lock, long_job_time);
+    if (_stopping)
+      break;
+
+    if (_pending > 0 && _idle == 0) {
+      lock.unlock();
+      grow_for_long_jobs();
+      lock.lock();
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void GRTExecutor::submit(Lane lane, const Job &job) {
+  if (lane < InteractiveLane || lane >= LaneCount)
+    lane = BackgroundLane;
+
+  // All workers are busy (or there are none yet), so add one while we are below the limit.
+  if (_idle == 0 && _worker_count < _max_workers)
+    spawn_worker(_max_workers);
+
+  size_t count = _worker_count;
+  if (count == 0) {
+    // Pool is shutting down or could not start a thread. Run the job in place rather than losing it.
+    logWarning("No worker available, running %s job on the calling thread\n", lane_name(lane));
+    job();
+    return;
+  }
+
+  size_t index = current_executor == this ? current_worker : _next_worker++ % count;
+  Worker *worker = _workers[index];
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    Item item;
+    item.job = job;
+    item.queued_at = Clock::now();
+    worker->lanes[lane].push_back(std::move(item));
+  }
+  ++_counters[lane].queued;
+  ++_pending;
+
+  if (_idle == 0 && _worker_count >= _max_workers)
+    grow_for_long_jobs();
+
+  {
+    std::lock_guard<std::mutex> lock(_idle_mutex);
+  }
+  _idle_condition.notify_one();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Picks the next job for the given worker. Lanes are checked in priority order, for each lane the worker's own
+ * deque is tried first (oldest job first), then the other workers are robbed from the back of their deques.
+ */
+bool GRTExecutor::take(size_t index, Lane &lane, Item &item) {
+  size_t count = _worker_count;
+  for (int l = InteractiveLane; l < LaneCount; ++l) {
+    for (size_t i = 0; i < count; ++i) {
+      size_t victim = (index + i) % count;
+      Worker *worker = _workers[victim];
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      std::deque<Item> &deque = worker->lanes[l];
+      if (deque.empty())
+        continue;
+
+      if (victim == index) {
+        item = std::move(deque.front());
+        deque.pop_front();
+      } else {
+        item = std::move(deque.back());
+        deque.pop_back();
+      }
+      lane = (Lane)l;
+      --_counters[l].queued;
+      --_pending;
+      return true;
+    }
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void GRTExecutor::run(Lane lane, Item &item) {
+  LaneCounters &counters = _counters[lane];
+
+  Clock::time_point started = Clock::now();
+  uint64_t wait = std::chrono::duration_cast<std::chrono::microseconds>(started - item.queued_at).count();
+  counters.wait_us += wait;
+  uint64_t max_wait = counters.max_wait_us;
+  while (wait > max_wait && !counters.max_wait_us.compare_exchange_weak(max_wait, wait))
+    ;
+
+  ++counters.running;
+  try {
+    item.job();
+  } catch (std::exception &exc) {
+    logException("Uncaught exception in executor job", exc);
+  } catch (...) {
+    logError("Unknown exception in executor job\n");
+  }
+  --counters.running;
+
+  counters.run_us += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - started).count();
+  ++counters.completed;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void GRTExecutor::worker_main(size_t index) {
+  current_executor = this;
+  current_worker = index;
+  mforms::Utilities::set_thread_name("GRTExecutor");
+
+  while (true) {
+    Lane lane;
+    Item item;
+    if (take(index, lane, item)) {
+      Worker *worker = _workers[index];
+      worker->busy_since = std::max<int64_t>(clock_us(Clock::now()), 1);
+      run(lane, item);
+      worker->busy_since = 0;
+      continue;
+    }
+
+    if (_pending > 0) {
+      // Another worker grabbed the job in between, or it was pushed into a worker not yet visible to us.
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(_idle_mutex);
+    if (_stopping && _pending == 0)
+      break;
+
+    ++_idle;
+    _idle_condition.wait(lock, [this]() { return _pending > 0 || _stopping; });
+    --_idle;
+  }
+
+  // Release per thread client library resources (e.g. MySQL's thread specific data).
+  mforms::Utilities::driver_shutdown();
+  logDebug("Worker %i exiting\n", (int)index);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+GRTExecutor::LaneStats GRTExecutor::lane_stats(Lane lane) const {
+  const LaneCounters &counters = _counters[lane];
+
+  LaneStats stats;
+  stats.queued = counters.queued;
+  stats.running = counters.running;
+  stats.completed = counters.completed;
+  stats.avg_wait_ms = stats.completed > 0 ? counters.wait_us / 1000.0 / stats.completed : 0;
+  stats.max_wait_ms = counters.max_wait_us / 1000.0;
+  stats.avg_run_ms = stats.completed > 0 ? counters.run_us / 1000.0 / stats.completed : 0;
+  return stats;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void GRTExecutor::log_stats() const {
+  logInfo("%i worker threads\n", (int)worker_count());
+  for (int l = InteractiveLane; l < LaneCount; ++l) {
+    LaneStats stats = lane_stats((Lane)l);
+    logInfo("%s lane: %i queued, %i running, %i completed, wait avg %.2fms max %.2fms, run avg %.2fms\n",
+            lane_name((Lane)l), (int)stats.queued, (int)stats.running, (int)stats.completed, stats.avg_wait_ms,
+            stats.max_wait_ms, stats.avg_run_ms);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Lets the workers finish all queued jobs and joins them. Must not be called from a pool thread.
+ * Jobs submitted afterwards start a new set of workers.
+ */
+void GRTExecutor::shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(_spawn_mutex);
+    std::lock_guard<std::mutex> idle_lock(_idle_mutex);
+    if (_stopping)
+      return;
+    _stopping = true;
+  }
+  _idle_condition.notify_all();
+  _monitor_condition.notify_all();
+
+  if (_monitor.joinable())
+    _monitor.join();
+
+  size_t count = _worker_count;
+  for (size_t i = 0; i < count; ++i) {
+    if (_workers[i]->thread.joinable())
+      _workers[i]->thread.join();
+  }
+
+  if (count > 0)
+    log_stats();
+
+  for (size_t i = 0; i < count; ++i) {
+    delete _workers[i];
+    _workers[i] = nullptr;
+  }
+  _worker_count = 0;
+
+  std::lock_guard<std::mutex> lock(_spawn_mutex);
+  _stopping = false;
+}
+
+//--------------------------------------------------------------------------------------------------
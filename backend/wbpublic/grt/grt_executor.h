@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2007, 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "wbpublic_public_interface.h"
+
+namespace bec {
+
+  // Process wide thread pool used by the threaded GRT dispatchers. Jobs are submitted into one of three
+  // priority lanes. Every worker owns a deque per lane, jobs submitted from a worker go to its own deque and
+  // jobs from other threads are spread over the workers. An idle worker first looks at its own deques and then
+  // steals from the other workers, always taking the highest priority lane that has work.
+  // The pool starts empty and adds workers on demand, up to a maximum, since GRT jobs often block on
+  // network I/O. Workers that have been running a single job for a while (e.g. a SQL editor executing a query)
+  // don't count against that maximum, so long jobs can't starve the queued ones. A monitor thread checks for
+  // this while jobs are waiting and all workers are busy.
+  class WBPUBLICBACKEND_PUBLIC_FUNC GRTExecutor {
+  public:
+    enum Lane {
+      InteractiveLane = 0, // Work a user is actively waiting for (queries, object browsing).
+      BackgroundLane,      // Refreshes and other work nobody waits for.
+      BulkLane,            // Long running exports, imports and similar.
+      LaneCount
+    };
+
+    typedef std::function<void()> Job;
+
+    struct LaneStats {
+      size_t queued;          // Jobs waiting to be picked up.
+      size_t running;         // Jobs currently executing.
+      size_t completed;       // Jobs finished since startup.
+      double avg_wait_ms;     // Average time between submit and start.
+      double max_wait_ms;
+      double avg_run_ms;      // Average execution time.
+    };
+
+    static GRTExecutor *get();
+    static const char *lane_name(Lane lane);
+
+    ~GRTExecutor();
+
+    void submit(Lane lane, const Job &job);
+
+    // Limits the number of threads the pool may start for short jobs. Already running workers are kept.
+    void set_max_workers(size_t count);
+    size_t max_workers() const;
+    size_t worker_count() const;
+
+    LaneStats lane_stats(Lane lane) const;
+    void log_stats() const;
+
+    void shutdown();
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Item {
+      Job job;
+      Clock::time_point queued_at;
+    };
+
+    struct Worker {
+      std::mutex mutex;
+      std::deque<Item> lanes[LaneCount];
+      std::thread thread;
+      std::atomic<int64_t> busy_since; // Start of the running job in microseconds since the clock epoch, or 0.
+
+      Worker() : busy_since(0) {
+      }
+    };
+
+    struct LaneCounters {
+      std::atomic<size_t> queued;
+      std::atomic<size_t> running;
+      std::atomic<size_t> completed;
+      std::atomic<uint64_t> wait_us;
+      std::atomic<uint64_t> max_wait_us;
+      std::atomic<uint64_t> run_us;
+
+      LaneCounters() : queued(0), running(0), completed(0), wait_us(0), max_wait_us(0), run_us(0) {
+      }
+    };
+
+    std::vector<Worker *> _workers; // Sized to the capacity upfront, filled up to _worker_count.
+    std::atomic<size_t> _worker_count;
+    size_t _max_workers;
+    std::mutex _spawn_mutex;
+
+    std::mutex _idle_mutex;
+    std::condition_variable _idle_condition;
+    std::atomic<size_t> _pending;
+    std::atomic<size_t> _idle;
+    std::atomic<size_t> _next_worker;
+    std::atomic<bool> _stopping;
+
+    std::thread _monitor;
+    std::condition_variable _monitor_condition; // Uses _idle_mutex.
+
+    LaneCounters _counters[LaneCount];
+
+    GRTExecutor();
+    GRTExecutor(const GRTExecutor &);
+    GRTExecutor &operator=(const GRTExecutor &);
+
+    void spawn_worker(size_t limit);
+    size_t long_running_workers() const;
+    void grow_for_long_jobs();
+    void monitor_main();
+    void worker_main(size_t index);
+    bool take(size_t index, Lane &lane, Item &item);
+    void run(Lane lane, Item &item);
+  };
+
+};
@@ -25,8 +25,11 @@
 #include "base/log.h"
 #include "base/file_utilities.h"
 
+#include <chrono>
+
 #include "grtpp_module_python.h"
 #include "grtpp_module_cpp.h"
+#include "grtpp_module_cache.h"
 
 #include "python_context.h"
 
@@ -55,7 +58,8 @@ static void init_all() {
   }
 }
 
-GRTManager::GRTManager(bool threaded) : _has_unsaved_changes(false), _threaded(threaded), _verbose(false) {
+GRTManager::GRTManager(bool threaded)
+  : _has_unsaved_changes(false), _threaded(threaded), _verbose(false), _module_cache(NULL) {
   _grt = grt::GRT::get(); // Ensure the grt singleton is created when we need it and stays as long as we are alive.
   _globals_tree_soft_lock_count = 0;
 
@@ -160,6 +164,11 @@ GRTManager::~GRTManager() {
   _dispatcher->shutdown();
   _dispatcher.reset();
 
+  GRTExecutor::get()->shutdown();
+
+  _grt->set_module_cache(NULL);
+  delete _module_cache;
+
   delete _shell;
   _shell = 0;
   delete _messages_list;
@@ -252,11 +261,23 @@ void GRTManager::show_message(const std::string &title, const std::string &messa
 }
 
 void GRTManager::initialize(bool init_python, const std::string &loader_module_path) {
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point phase_start = Clock::now();
+  auto end_phase = [&](const std::string &phase) {
+    Clock::time_point now = Clock::now();
+    _startup_timings.push_back(
+      std::make_pair(phase, std::chrono::duration<double, std::milli>(now - phase_start).count()));
+    phase_start = now;
+  };
+  _startup_timings.clear();
+
   _dispatcher->start();
 
   load_structs();
+  end_phase("structs");
 
   init_module_loaders(loader_module_path, init_python);
+  end_phase("loaders");
 
 #ifdef _MSC_VER
   add_python_module_dir(_basedir + "\\python");
@@ -271,10 +292,24 @@ void GRTManager::initialize(bool init_python, const std::string &loader_module_p
 #endif
 
   pyobject_initialize();
+  end_phase("python setup");
 
   load_libraries();
+  end_phase("libraries");
 
   load_modules();
+  end_phase("modules");
+
+  std::string report;
+  double total = 0;
+  for (auto &timing : _startup_timings) {
+    report.append(strfmt("%s%s %.0fms", report.empty() ? "" : ", ", timing.first.c_str(), timing.second));
+    total += timing.second;
+  }
+  if (_module_cache != NULL)
+    report.append(strfmt(" (%i modules from cache, %i loaded)", (int)_module_cache->hits(),
+                         (int)_module_cache->misses()));
+  logInfo("GRT initialization took %.0fms: %s\n", total, report.c_str());
 }
 
 bool GRTManager::initialize_shell(const std::string &shell_type) {
@@ -625,8 +660,25 @@ bool GRTManager::load_libraries() {
 bool GRTManager::load_modules() {
   if (_verbose)
     _shell->write_line(_("Loading modules..."));
+
+  // Modules already seen in an earlier session are registered from the cache and loaded on first use.
+  if (_module_cache == NULL && !_user_datadir.empty() && getenv("WB_NO_MODULE_CACHE") == NULL) {
+    std::string cache_dir = _user_datadir + "/cache/";
+    try {
+      base::create_directory(cache_dir, 0700); // No-op if the folder already exists.
+    } catch (std::exception &e) {
+      logError("Could not create %s: %s\n", cache_dir.c_str(), e.what());
+    }
+    _module_cache = new grt::ModuleCache(cache_dir + "grt_modules.xml");
+    _module_cache->load();
+    _grt->set_module_cache(_module_cache);
+  }
+
   scan_modules_grt(_module_extensions, false);
 
+  if (_module_cache != NULL)
+    _module_cache->save();
+
   return true;
 }
 
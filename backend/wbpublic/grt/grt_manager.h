@@ -128,6 +128,11 @@ namespace bec {
     void initialize(bool init_python, const std::string &loader_module_path = "");
     bool initialize_shell(const std::string &shell_type);
 
+    // Duration in ms of each phase run by initialize(), in execution order.
+    const std::vector<std::pair<std::string, double> > &get_startup_timings() const {
+      return _startup_timings;
+    }
+
     bool cancel_idle_tasks();
     void perform_idle_tasks();
 
@@ -274,6 +279,9 @@ namespace bec {
 
     int _globals_tree_soft_lock_count;
 
+    grt::ModuleCache *_module_cache;
+    std::vector<std::pair<std::string, double> > _startup_timings;
+
     virtual bool load_structs();
     virtual bool load_modules();
     virtual bool load_libraries();
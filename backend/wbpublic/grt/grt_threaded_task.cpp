@@ -30,12 +30,19 @@ DEFAULT_LOG_DOMAIN("GRT task")
 
 //--------------------------------------------------------------------------------------------------
 
-GrtThreadedTask::GrtThreadedTask() : _send_task_res_msg(true), _onetime_finish_cb(false), _onetime_fail_cb(false) {
+GrtThreadedTask::GrtThreadedTask()
+  : _lane(bec::GRTExecutor::BackgroundLane),
+    _send_task_res_msg(true),
+    _onetime_finish_cb(false),
+    _onetime_fail_cb(false) {
 }
 //--------------------------------------------------------------------------------------------------
 
 GrtThreadedTask::GrtThreadedTask(const GrtThreadedTask::Ref parent_task)
-  : _send_task_res_msg(true), _onetime_finish_cb(false), _onetime_fail_cb(false) {
+  : _lane(bec::GRTExecutor::BackgroundLane),
+    _send_task_res_msg(true),
+    _onetime_finish_cb(false),
+    _onetime_fail_cb(false) {
   this->parent_task(parent_task);
 }
 
@@ -68,6 +75,7 @@ void GrtThreadedTask::parent_task(const GrtThreadedTask::Ref val) {
   _parent_task = val;
   disconnect_callbacks();
   if (_parent_task) {
+    _lane = _parent_task->_lane;
     _dispatcher = _parent_task->dispatcher();
     _msg_cb = _parent_task->_msg_cb;
     _progress_cb = _parent_task->_progress_cb;
@@ -83,7 +91,7 @@ void GrtThreadedTask::parent_task(const GrtThreadedTask::Ref val) {
 
 const bec::GRTDispatcher::Ref &GrtThreadedTask::dispatcher() {
   if (!_dispatcher) {
-    _dispatcher = bec::GRTDispatcher::create_dispatcher(bec::GRTManager::get()->is_threaded(), false);
+    _dispatcher = bec::GRTDispatcher::create_dispatcher(bec::GRTManager::get()->is_threaded(), false, _lane);
     _dispatcher->set_main_thread_flush_and_wait(
       bec::GRTManager::get()->get_dispatcher()->get_main_thread_flush_and_wait());
     _dispatcher->start();
@@ -93,6 +101,14 @@ const bec::GRTDispatcher::Ref &GrtThreadedTask::dispatcher() {
 
 //--------------------------------------------------------------------------------------------------
 
+void GrtThreadedTask::lane(bec::GRTExecutor::Lane lane) {
+  _lane = lane;
+  if (_dispatcher && !_parent_task)
+    _dispatcher->set_lane(lane);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 const bec::GRTTask::Ref GrtThreadedTask::task() {
   return (_task) ? _task : ((_parent_task) ? _parent_task->task() : bec::GRTTask::Ref());
 }
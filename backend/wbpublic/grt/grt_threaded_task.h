@@ -84,6 +84,16 @@ public:
 private:
   std::string _desc;
 
+public:
+  // Executor lane the task's dispatcher is scheduled in. Must be set before the first exec().
+  bec::GRTExecutor::Lane lane() const {
+    return _lane;
+  }
+  void lane(bec::GRTExecutor::Lane lane);
+
+private:
+  bec::GRTExecutor::Lane _lane;
+
 public:
   void send_task_res_msg(bool value) {
     _send_task_res_msg = value;
@@ -92,6 +92,93 @@ TEST_FUNCTION(6)
 }
 */
 
+// Jobs from all lanes run on the shared executor and show up in the lane statistics.
+TEST_FUNCTION(10) {
+  GRTExecutor *executor = GRTExecutor::get();
+
+  size_t completed[GRTExecutor::LaneCount];
+  for (int l = 0; l < GRTExecutor::LaneCount; ++l)
+    completed[l] = executor->lane_stats((GRTExecutor::Lane)l).completed;
+
+  base::refcount_t done = 0;
+  for (int i = 0; i < 30; ++i)
+    executor->submit((GRTExecutor::Lane)(i % GRTExecutor::LaneCount), [&done]() { g_atomic_int_inc(&done); });
+
+  // The executor counts a job as completed only after it returned, so wait for its statistics, not the jobs.
+  auto all_completed = [&]() {
+    for (int l = 0; l < GRTExecutor::LaneCount; ++l) {
+      if (executor->lane_stats((GRTExecutor::Lane)l).completed - completed[l] < 10)
+        return false;
+    }
+    return true;
+  };
+  for (int i = 0; i < 500 && !all_completed(); ++i)
+    g_usleep(10000);
+
+  ensure_equals("all jobs executed", g_atomic_int_get(&done), 30);
+  ensure("workers started", executor->worker_count() > 0);
+  for (int l = 0; l < GRTExecutor::LaneCount; ++l) {
+    GRTExecutor::LaneStats stats = executor->lane_stats((GRTExecutor::Lane)l);
+    ensure_equals("lane completed", stats.completed - completed[l], 10U);
+    ensure_equals("lane queue empty", stats.queued, 0U);
+  }
+}
+
+// A threaded non-main dispatcher runs its tasks on the executor, in submission order.
+TEST_FUNCTION(11) {
+  GRTDispatcher::Ref dispatcher = GRTDispatcher::create_dispatcher(true, false, GRTExecutor::InteractiveLane);
+  dispatcher->start();
+  ensure("no own thread", dispatcher->get_thread() == NULL);
+
+  std::vector<int> order;
+  for (int i = 0; i < 20; ++i)
+    dispatcher->execute_async_function("order", [&order, i]() {
+      order.push_back(i);
+      return grt::ValueRef();
+    });
+
+  grt::ValueRef result = dispatcher->execute_sync_function("last", []() { return grt::IntegerRef(42); });
+  ensure_equals("sync result", *grt::IntegerRef::cast_from(result), 42);
+  ensure_equals("all tasks ran", order.size(), 20U);
+  for (int i = 0; i < 20; ++i)
+    ensure_equals("task order", order[i], i);
+
+  dispatcher->shutdown();
+}
+
+// Workers busy with long jobs don't count against the pool limit, so other jobs don't have to wait for them.
+TEST_FUNCTION(12) {
+  GRTExecutor *executor = GRTExecutor::get();
+  size_t max_workers = executor->max_workers();
+  size_t busy = std::max<size_t>(executor->worker_count(), 1);
+  executor->set_max_workers(busy);
+
+  base::refcount_t release = 0;
+  for (size_t i = 0; i < busy; ++i)
+    executor->submit(GRTExecutor::BulkLane, [&release]() {
+      while (g_atomic_int_get(&release) == 0)
+        g_usleep(1000);
+    });
+  for (int i = 0; i < 500 && executor->lane_stats(GRTExecutor::BulkLane).running < busy; ++i)
+    g_usleep(10000);
+  ensure_equals("all workers busy", executor->lane_stats(GRTExecutor::BulkLane).running, busy);
+
+  base::refcount_t done = 0;
+  executor->submit(GRTExecutor::InteractiveLane, [&done]() { g_atomic_int_inc(&done); });
+  for (int i = 0; i < 500 && g_atomic_int_get(&done) == 0; ++i)
+    g_usleep(10000);
+  bool ran = g_atomic_int_get(&done) != 0;
+  bool grown = executor->worker_count() > busy;
+
+  g_atomic_int_set(&release, 1);
+  for (int i = 0; i < 500 && executor->lane_stats(GRTExecutor::BulkLane).running > 0; ++i)
+    g_usleep(10000);
+  executor->set_max_workers(max_workers);
+
+  ensure("job ran while the others were busy", ran);
+  ensure("pool grown", grown);
+}
+
 TEST_FUNCTION(99) {
   // we need to shutdown it here instead of d-tor because it will crash otherwise
   _dispatcher->shutdown();
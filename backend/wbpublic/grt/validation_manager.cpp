@@ -180,7 +180,7 @@ void bec::ValidationManager::scan() {
   for (size_t i = 0; i < plugins.size(); ++i) {
     if (bec::ValidationManager::is_validation_plugin(plugins[i])) {
       grt::Module* module = grt::GRT::get()->get_module(plugins[i]->moduleName());
-      grt::CPPModule* cpp_module = dynamic_cast<grt::CPPModule*>(module);
+      grt::CPPModule* cpp_module = dynamic_cast<grt::CPPModule*>(module ? module->resolve() : NULL);
       if (cpp_module) {
         // Handle plugin directly
         // 1. Fetch slot
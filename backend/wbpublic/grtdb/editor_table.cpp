@@ -2418,6 +2418,7 @@ bool FKConstraintListBE::set_field(const NodeId &node, ColumnId column, const st
 
         db_TableRef dbtable;
         if (schema.is_valid()) {
+          grt::index_list(schema->tables());
           dbtable = grt::find_named_object_in_list(schema->tables(), table, "name");
           if (!dbtable.is_valid())
             return false;
@@ -2662,6 +2663,7 @@ NodeId TableEditorBE::duplicate_column(const db_ColumnRef &column, ssize_t inser
 
   std::string name = new_column->name();
   std::string new_name = name;
+  grt::index_list(get_table()->columns());
   for (int i = 1;; i++) {
     if (!find_named_object_in_list(get_table()->columns(), new_name).is_valid())
       break;
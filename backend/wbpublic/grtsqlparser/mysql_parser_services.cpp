@@ -31,8 +31,7 @@ using namespace parsers;
 //------------------ MySQLParserServices -----------------------------------------------------------
 
 MySQLParserServices::Ref MySQLParserServices::get() {
-  MySQLParserServices::Ref module =
-    dynamic_cast<MySQLParserServices::Ref>(grt::GRT::get()->get_module("MySQLParserServices"));
+  MySQLParserServices::Ref module = grt::GRT::get()->find_native_module<MySQLParserServices>("MySQLParserServices");
   if (module == nullptr)
     throw std::runtime_error("Can't get MySQLParserServices module.");
   return module;
@@ -58,7 +58,7 @@ SqlFacade::Ref SqlFacade::instance_for_rdbms(db_mgmt_RdbmsRef rdbms) {
 SqlFacade::Ref SqlFacade::instance_for_rdbms_name(const std::string &name) {
   const char *def_module_name = "SqlFacade";
   std::string module_name = name + def_module_name;
-  SqlFacade::Ref module = dynamic_cast<SqlFacade::Ref>(grt::GRT::get()->get_module(module_name));
+  SqlFacade::Ref module = grt::GRT::get()->find_native_module<SqlFacade>(module_name.c_str());
   if (!module)
     throw std::runtime_error(base::strfmt("Can't get '%s' module.", module_name.c_str()));
   return module;
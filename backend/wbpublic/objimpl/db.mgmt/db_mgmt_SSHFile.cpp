@@ -84,6 +84,14 @@ grt::IntegerRef db_mgmt_SSHFile::seek(const size_t offset) {
 
 //------------------------------------------------------------------------------------------------
 
+grt::IntegerRef db_mgmt_SSHFile::size() {
+  if (_data)
+    return _data->size();
+  return -1;
+}
+
+//------------------------------------------------------------------------------------------------
+
 grt::IntegerRef db_mgmt_SSHFile::tell() {
   if (_data)
     return _data->tell();
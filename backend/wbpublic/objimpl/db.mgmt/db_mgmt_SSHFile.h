@@ -30,5 +30,6 @@ public:
   virtual grt::StringRef read(const size_t length) = 0;
   virtual grt::StringRef readline() = 0;
   virtual grt::IntegerRef seek(const size_t offset) = 0;
+  virtual grt::IntegerRef size() = 0;
   virtual grt::IntegerRef tell() = 0;
 };
@@ -90,6 +90,7 @@ Recordset::Recordset()
 
   task->desc("Recordset task");
   task->send_task_res_msg(false);
+  task->lane(bec::GRTExecutor::InteractiveLane);
   apply_changes_cb = [this]() { apply_changes_(); };
   register_default_actions();
   reset();
@@ -1314,7 +1315,7 @@ void Recordset::copy_rows_to_clipboard(const std::vector<int> &indeces, std::str
         line += boost::apply_visitor(_var_to_str, *cell);
     }
     if (!line.empty())
-      text += line + "\n";
+      text.append(line).append("\n");
   }
   mforms::Utilities::set_clipboard_text(text);
 }
@@ -29,6 +29,7 @@
 #include "grtsqlparser/sql_facade.h"
 #include "base/string_utilities.h"
 #include "base/sqlstring.h"
+#include "base/log.h"
 #include <sqlite/query.hpp>
 #include <algorithm>
 #include <ctype.h>
@@ -37,8 +38,12 @@ using namespace bec;
 using namespace grt;
 using namespace base;
 
+DEFAULT_LOG_DOMAIN(DOMAIN_WQE_BE)
+
 Recordset_cdbc_storage::Recordset_cdbc_storage()
-  : Recordset_sql_storage(), _reloadable(true), _gather_field_info(false) {
+  : Recordset_sql_storage(), _reloadable(true), _gather_field_info(false), _stream_results(false), _decoded_bytes(0) {
+  // Merge row changes into multi-row statements. Stays well below the smallest default max_allowed_packet (4MB).
+  coalesce_size_limit(1024 * 1024);
 }
 
 Recordset_cdbc_storage::~Recordset_cdbc_storage() {
@@ -110,6 +115,27 @@ private:
   size_t _foreknown_blob_size;
 };
 
+// Size of a fetched value, used for the transfer statistics of a result set.
+class FetchedSize : public boost::static_visitor<std::int64_t> {
+public:
+  result_type operator()(const std::string &v) const {
+    return (std::int64_t)v.size();
+  }
+  result_type operator()(const sqlite::blob_ref_t &v) const {
+    return v ? (std::int64_t)v->size() : 0;
+  }
+  result_type operator()(const sqlite::null_t &v) const {
+    return 0;
+  }
+  result_type operator()(const sqlite::unknown_t &v) const {
+    return 0;
+  }
+  template <typename V>
+  result_type operator()(const V &v) const {
+    return sizeof(V);
+  }
+};
+
 size_t Recordset_cdbc_storage::determine_pkey_columns(Recordset::Column_names &column_names,
                                                       Recordset::Column_types &column_types,
                                                       Recordset::Column_types &real_column_types) {
@@ -269,6 +295,8 @@ void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connec
     // if (!_schema_name.empty()) //! default schema is to be set for connector
     //  stmt->execute(strfmt("use `%s`", _schema_name.c_str()));
     // stmt->setFetchSize(100); //! setFetchSize is not implemented. param value to be customized.
+    if (_stream_results)
+      stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
     stmt->execute(sql_query);
     rs.reset(stmt->getResultSet());
   }
@@ -436,7 +464,9 @@ void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connec
     create_data_swap_tables(data_swap_db, column_names, column_types);
 
     FetchVar fetch_var(rs.get());
+    FetchedSize fetched_size;
     Var_vector row_values(editable_col_count + rowid_col_count);
+    _decoded_bytes = 0;
 
     std::list<std::shared_ptr<sqlite::command> > insert_commands =
       prepare_data_swap_record_add_statement(data_swap_db, column_names);
@@ -448,6 +478,7 @@ void Recordset_cdbc_storage::do_unserialize(Recordset *recordset, sqlite::connec
         } else {
           sqlite::variant_t index = (int)n + 1;
           row_values[n] = boost::apply_visitor(fetch_var, column_types[n], index);
+          _decoded_bytes += boost::apply_visitor(fetched_size, row_values[n]);
         }
       }
       for (ColumnId n = 0; rowid_col_count > n; ++n) // copy original value of pk field(s)
@@ -546,11 +577,67 @@ void Recordset_cdbc_storage::run_sql_script(const Sql_script &sql_script, bool s
   int processed_statement_count = 0;
   std::string msg;
   BlobVarToStream blob_var_to_stream;
+  size_t batch_size_limit = std::string::npos; // Determined on first use.
   Sql_script::Statements_bindings::const_iterator sql_bindings = sql_script.statements_bindings.begin();
   std::auto_ptr<sql::PreparedStatement> stmt;
-  for (const std::string &sql : sql_script.statements) {
+  for (Sql_script::Statements::const_iterator sql = sql_script.statements.begin(); sql != sql_script.statements.end();
+       ++sql) {
+    // Runs of DML statements without bound values are sent in multi-statement packets, saving a round trip each.
+    std::list<std::string> batch;
+    for (Sql_script::Statements::const_iterator next = sql;
+         next != sql_script.statements.end() && sql::SqlBatchExec::is_batchable_statement(*next) &&
+         (sql_script.statements_bindings.end() == sql_bindings || sql_bindings->empty());
+         ++next) {
+      batch.push_back(*next);
+      if (sql_script.statements_bindings.end() != sql_bindings)
+        ++sql_bindings;
+    }
+
+    if (!batch.empty()) {
+      if (batch_size_limit == std::string::npos) {
+        batch_size_limit = 0;
+        try {
+          // Leave room for the packet header and the statement separators.
+          size_t max_allowed_packet = sql::SqlBatchExec::max_allowed_packet(conn->ref.get());
+          if (max_allowed_packet > 1024)
+            batch_size_limit = max_allowed_packet - 1024;
+        } catch (sql::SQLException &e) {
+          logWarning("Could not determine max_allowed_packet, executing statements one by one: %s\n", e.what());
+        }
+      }
+
+      sql::SqlBatchExec sql_batch_exec;
+      sql_batch_exec.stop_on_error(false);
+      sql_batch_exec.batch_size_limit(batch_size_limit);
+      sql_batch_exec.error_cb([&](long long error_code, const std::string &error_msg, const std::string &statement) {
+        ++err_count;
+        msg = strfmt("%i: %s", (int)error_code, error_msg.c_str());
+        on_sql_script_run_error((int)error_code, msg, statement);
+        return 0;
+      });
+      sql_batch_exec.split_cb([&](const std::string &statement, std::list<std::string> &parts) {
+        Sql_script::Merged_statements::const_iterator merged = sql_script.merged_statements.find(statement);
+        if (merged == sql_script.merged_statements.end())
+          return false;
+        parts = merged->second;
+        return true;
+      });
+      sql_batch_exec.batch_exec_progress_cb([&](float batch_progress) {
+        on_sql_script_run_progress(progress_state + batch_progress * batch.size() * progress_state_inc);
+        return 0;
+      });
+
+      std::auto_ptr<sql::Statement> batch_stmt(conn->ref->createStatement());
+      sql_batch_exec(batch_stmt.get(), batch);
+
+      processed_statement_count += (int)batch.size();
+      progress_state += batch.size() * progress_state_inc;
+      std::advance(sql, batch.size() - 1);
+      continue;
+    }
+
     try {
-      stmt.reset(conn->ref->prepareStatement(sql));
+      stmt.reset(conn->ref->prepareStatement(*sql));
       std::list<std::shared_ptr<std::stringstream> > blob_streams;
       if (sql_script.statements_bindings.end() != sql_bindings) {
         int bind_var_index = 1;
@@ -569,14 +656,31 @@ void Recordset_cdbc_storage::run_sql_script(const Sql_script &sql_script, bool s
       }
       stmt->executeUpdate();
     } catch (sql::SQLException &e) {
-      ++err_count;
-      msg = strfmt("%i: %s", e.getErrorCode(), e.what());
-      on_sql_script_run_error(e.getErrorCode(), msg, sql);
+      // A merged statement that cannot be batched (e.g. a value containing a semicolon) is retried row by row, so the
+      // error points to the row that caused it.
+      Sql_script::Merged_statements::const_iterator merged = sql_script.merged_statements.find(*sql);
+      if (merged != sql_script.merged_statements.end()) {
+        for (const std::string &part : merged->second) {
+          try {
+            stmt.reset(conn->ref->prepareStatement(part));
+            stmt->executeUpdate();
+          } catch (sql::SQLException &part_error) {
+            ++err_count;
+            msg = strfmt("%i: %s", part_error.getErrorCode(), part_error.what());
+            on_sql_script_run_error(part_error.getErrorCode(), msg, part);
+          }
+        }
+      } else {
+        ++err_count;
+        msg = strfmt("%i: %s", e.getErrorCode(), e.what());
+        on_sql_script_run_error(e.getErrorCode(), msg, *sql);
+      }
     }
     ++processed_statement_count;
     progress_state += progress_state_inc;
     on_sql_script_run_progress(progress_state);
-    ++sql_bindings;
+    if (sql_script.statements_bindings.end() != sql_bindings)
+      ++sql_bindings;
   }
   if (err_count) {
     if (!skip_transaction)
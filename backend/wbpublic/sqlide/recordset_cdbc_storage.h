@@ -87,6 +87,15 @@ public:
   void set_gather_field_info(bool flag) {
     _gather_field_info = flag;
   }
+
+  // Read rows from the server as they are fetched instead of buffering the complete result set first.
+  void stream_results(bool flag) {
+    _stream_results = flag;
+  }
+  // Size of the result data fetched by the last unserialization, as decoded by the client.
+  std::int64_t decoded_bytes() const {
+    return _decoded_bytes;
+  }
   std::vector<FieldInfo> &field_info() {
     return _field_info;
   }
@@ -100,6 +109,8 @@ private:
   std::vector<FieldInfo> _field_info;
   bool _reloadable; // whether can be reloaded using stored sql query
   bool _gather_field_info;
+  bool _stream_results;
+  std::int64_t _decoded_bytes;
 
   size_t determine_pkey_columns(Recordset::Column_names &column_names, Recordset::Column_types &column_types,
                                 Recordset::Column_types &real_column_types);
@@ -66,6 +66,127 @@ std::string PrimaryKeyPredicate::operator()(std::vector<std::shared_ptr<sqlite::
   return predicate;
 }
 
+std::string PrimaryKeyPredicate::key_value(std::vector<std::shared_ptr<sqlite::result> > &data_row_results) {
+  if (_pkey_columns->size() != 1)
+    return "";
+
+  ColumnId col = _pkey_columns->front();
+  size_t partition;
+  ColumnId partition_column = Recordset::translate_data_swap_db_column(col, &partition);
+  sqlite::variant_t v = data_row_results[partition]->get_variant((int)partition_column);
+  std::string value = boost::apply_visitor(*_qv, (*_column_types)[col], v);
+  return value == "NULL" ? "" : value;
+}
+
+//------------------------------------------------------------------------------
+
+DmlCoalescer::DmlCoalescer(Sql_script &sql_script, size_t size_limit)
+  : _sql_script(sql_script), _size_limit(size_limit), _merged_size(0), _is_update(false) {
+}
+
+DmlCoalescer::~DmlCoalescer() {
+  flush();
+}
+
+void DmlCoalescer::add(const std::string &statement, const std::string &head, const std::string &separator,
+                       const std::string &item, const std::string &tail) {
+  if (_size_limit == 0) {
+    add_other(statement, Sql_script::Statement_bindings());
+    return;
+  }
+
+  if (!_statements.empty() && !_is_update && head == _head && separator == _separator && tail == _tail &&
+      _merged.size() + separator.size() + item.size() + tail.size() <= _size_limit) {
+    _merged.append(separator).append(item);
+    _statements.push_back(statement);
+    return;
+  }
+
+  flush();
+  _statements.push_back(statement);
+  _head = head;
+  _separator = separator;
+  _tail = tail;
+  _merged = head + item;
+}
+
+/**
+ * Consecutive UPDATEs of the same columns are merged into
+ *   UPDATE t SET `a` = CASE `id` WHEN k1 THEN v1 WHEN k2 THEN v2 END, ... WHERE `id` IN (k1, k2)
+ * The WHERE clause limits the statement to the listed rows, so no ELSE branch is needed.
+ */
+void DmlCoalescer::add_update(const std::string &statement, const std::string &table, const std::string &key_column,
+                              const std::string &key_value, const Assignments &assignments) {
+  if (_size_limit == 0 || assignments.empty()) {
+    add_other(statement, Sql_script::Statement_bindings());
+    return;
+  }
+
+  std::string head = "UPDATE " + table + " SET ";
+  bool same_group = !_statements.empty() && _is_update && head == _head && key_column == _key_column &&
+                    assignments.size() == _update_columns.size();
+  for (size_t i = 0; same_group && i < assignments.size(); ++i)
+    same_group = assignments[i].first == _update_columns[i];
+
+  size_t row_size = key_value.size() + 2;
+  for (const auto &assignment : assignments)
+    row_size += 6 + key_value.size() + 6 + assignment.second.size(); // " WHEN " k " THEN " v
+  if (same_group && _merged_size + row_size <= _size_limit) {
+    for (size_t i = 0; i < assignments.size(); ++i)
+      _update_cases[i] += " WHEN " + key_value + " THEN " + assignments[i].second;
+    _merged += ", " + key_value;
+    _merged_size += row_size;
+    _statements.push_back(statement);
+    return;
+  }
+
+  flush();
+  _statements.push_back(statement);
+  _is_update = true;
+  _head = head;
+  _key_column = key_column;
+  _update_columns.clear();
+  _update_cases.clear();
+  for (const auto &assignment : assignments) {
+    _update_columns.push_back(assignment.first);
+    _update_cases.push_back(" WHEN " + key_value + " THEN " + assignment.second);
+  }
+  _merged = key_value;
+  _merged_size = merged_update().size();
+}
+
+void DmlCoalescer::add_other(const std::string &statement, const Sql_script::Statement_bindings &bindings) {
+  flush();
+  _sql_script.statements.push_back(statement);
+  _sql_script.statements_bindings.push_back(bindings);
+}
+
+void DmlCoalescer::flush() {
+  if (_statements.empty())
+    return;
+
+  if (_statements.size() == 1)
+    _sql_script.statements.push_back(_statements.front());
+  else {
+    std::string merged = _is_update ? merged_update() : _merged + _tail;
+    _sql_script.statements.push_back(merged);
+    _sql_script.merged_statements[merged] = _statements;
+  }
+  _sql_script.statements_bindings.push_back(Sql_script::Statement_bindings());
+  _statements.clear();
+  _is_update = false;
+}
+
+std::string DmlCoalescer::merged_update() const {
+  std::string sql = _head;
+  for (size_t i = 0; i < _update_columns.size(); ++i) {
+    if (i > 0)
+      sql += ", ";
+    sql += "`" + _update_columns[i] + "` = CASE `" + _key_column + "`" + _update_cases[i] + " END";
+  }
+  return sql + " WHERE `" + _key_column + "` IN (" + _merged + ")";
+}
+
 //------------------------------------------------------------------------------
 
 class JsonTypeFinder : public boost::static_visitor<bool> {
@@ -101,7 +222,8 @@ Recordset_sql_storage::Recordset_sql_storage()
   : Recordset_data_storage(),
     _is_sql_script_substitute_enabled(false),
     _omit_schema_qualifier(false),
-    _binding_blobs(true) {
+    _binding_blobs(true),
+    _coalesce_size_limit(0) {
 }
 
 Recordset_sql_storage::~Recordset_sql_storage() {
@@ -400,11 +522,13 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
     changes_query % (int)min_new_rowid;
     changes_query % (int)min_new_rowid;
     if (changes_query.emit()) {
+      DmlCoalescer coalescer(sql_script, _coalesce_size_limit);
       std::shared_ptr<sqlite::result> rs = BoostHelper::convertPointer(changes_query.get_result());
       do {
         RowId rowid = rs->get_int(1);
         std::string sql;
         Sql_script::Statement_bindings sql_bindings;
+        bool coalesced = false;
 
         switch (rs->get_int(2)) // action
         {
@@ -413,7 +537,18 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
             std::list<sqlite::variant_t> bind_vars;
             bind_vars.push_back((int)rowid);
             if (Recordset::emit_partition_queries(data_swap_db, deleted_row_queries, deleted_row_results, bind_vars)) {
-              sql = strfmt("DELETE FROM %s WHERE %s", full_table_name.c_str(), pkey_pred(deleted_row_results).c_str());
+              std::string predicate = pkey_pred(deleted_row_results);
+              sql = strfmt("DELETE FROM %s WHERE %s", full_table_name.c_str(), predicate.c_str());
+
+              std::string key_value = pkey_pred.key_value(deleted_row_results);
+              if (!key_value.empty())
+                coalescer.add(sql, strfmt("DELETE FROM %s WHERE `%s` IN (", full_table_name.c_str(),
+                                          column_names[_pkey_columns.front()].c_str()),
+                              ", ", key_value, ")");
+              else
+                coalescer.add(sql, strfmt("DELETE FROM %s WHERE ", full_table_name.c_str()), " OR ",
+                              "(" + predicate + ")", "");
+              coalesced = true;
             }
           } break;
 
@@ -465,10 +600,16 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
                 col_names.resize(col_names.size() - 2);
               if (!values.empty())
                 values.resize(values.size() - 2);
-              sql = strfmt("INSERT INTO %s (%s) VALUES (%s)",
-                           _omit_schema_qualifier ? (std::string("`") + table_name() + std::string("`")).c_str()
-                                                  : full_table_name.c_str(),
-                           col_names.c_str(), values.c_str());
+              std::string head = strfmt("INSERT INTO %s (%s) VALUES ",
+                                        _omit_schema_qualifier
+                                          ? (std::string("`") + table_name() + std::string("`")).c_str()
+                                          : full_table_name.c_str(),
+                                        col_names.c_str());
+              sql = head + "(" + values + ")";
+              if (sql_bindings.empty()) {
+                coalescer.add(sql, head, ", ", "(" + values + ")", "");
+                coalesced = true;
+              }
             }
           } break;
 
@@ -488,9 +629,14 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
                 BoostHelper::convertPointer(changed_row_columns_query.get_result());
 
               std::string values;
+              DmlCoalescer::Assignments assignments;
+              bool key_changed = false;
               sqlite::variant_t v;
               do {
                 ColumnId column = changed_row_columns_rs->get_int(0);
+                for (auto key_column : _pkey_columns)
+                  if (column_names[key_column] == column_names[column])
+                    key_changed = true;
 
                 size_t partition;
                 ColumnId partition_column = Recordset::translate_data_swap_db_column(column, &partition);
@@ -500,8 +646,9 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
 
                 if (!qv.store_unknown_as_string && boost::apply_visitor(jsonTypeFinder, column_types[column], v))
                   qv.store_unknown_as_string = true;
-                values += strfmt("`%s` = %s, ", column_names[column].c_str(),
-                                 boost::apply_visitor(qv, column_types[column], v).c_str());
+                assignments.push_back(
+                  std::make_pair(column_names[column], boost::apply_visitor(qv, column_types[column], v)));
+                values += strfmt("`%s` = %s, ", column_names[column].c_str(), assignments.back().second.c_str());
                 if (unknownAsStringOrginal != qv.store_unknown_as_string)
                   qv.store_unknown_as_string = unknownAsStringOrginal;
                 if (blob_columns[column] && _binding_blobs)
@@ -511,13 +658,22 @@ void Recordset_sql_storage::generate_sql_script(const Recordset *recordset, sqli
                 values.resize(values.size() - 2);
               sql = strfmt("UPDATE %s SET %s WHERE %s", full_table_name.c_str(), values.c_str(),
                            pkey_pred(data_row_results).c_str());
+
+              // MySQL applies SET assignments from left to right, so a later CASE would see an already changed key.
+              std::string key_value = pkey_pred.key_value(data_row_results);
+              if (sql_bindings.empty() && !key_value.empty() && !key_changed) {
+                coalescer.add_update(sql, full_table_name, column_names[_pkey_columns.front()], key_value,
+                                     assignments);
+                coalesced = true;
+              }
             }
           } break;
         }
 
-        sql_script.statements.push_back(sql);
-        sql_script.statements_bindings.push_back(sql_bindings);
+        if (!coalesced)
+          coalescer.add_other(sql, sql_bindings);
       } while (rs->next_row());
+      coalescer.flush();
     }
   } else {
     std::string col_names;
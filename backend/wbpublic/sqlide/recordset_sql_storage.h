@@ -29,20 +29,66 @@
 #include "grtsqlparser/sql_inserts_loader.h"
 #include "grts/structs.db.mgmt.h"
 #include <vector>
+#include <map>
 
 class WBPUBLICBACKEND_PUBLIC_FUNC Sql_script {
 public:
   typedef std::list<std::string> Statements;
   typedef std::list<sqlite::variant_t> Statement_bindings;
   typedef std::list<Statement_bindings> Statements_bindings;
+  typedef std::map<std::string, Statements> Merged_statements;
   Statements statements;
   Statements_bindings statements_bindings;
+  Merged_statements merged_statements; // per row statements each merged statement was built from
   void reset() {
     statements.clear();
     statements_bindings.clear();
+    merged_statements.clear();
   }
 };
 
+/**
+ * Collects the statements generated for a change set and merges runs of compatible statements: consecutive INSERTs
+ * into the same columns become one multi-row INSERT, consecutive DELETEs one DELETE with a combined predicate and
+ * consecutive UPDATEs of the same columns one UPDATE with a CASE expression per column. Merged statements never grow
+ * beyond the given size (0 disables merging) and a group with a single row is emitted in its original form.
+ * The original statements of every merged statement are kept in Sql_script::merged_statements.
+ */
+class WBPUBLICBACKEND_PUBLIC_FUNC DmlCoalescer {
+public:
+  typedef std::vector<std::pair<std::string, std::string> > Assignments; // column name, quoted value
+
+  DmlCoalescer(Sql_script &sql_script, size_t size_limit);
+  ~DmlCoalescer();
+
+  // Adds a statement which can be merged with others having the same head, separator and tail.
+  void add(const std::string &statement, const std::string &head, const std::string &separator,
+           const std::string &item, const std::string &tail);
+  // Adds an UPDATE of a single row identified by a single column key, which must not be among the assigned columns.
+  void add_update(const std::string &statement, const std::string &table, const std::string &key_column,
+                  const std::string &key_value, const Assignments &assignments);
+  void add_other(const std::string &statement, const Sql_script::Statement_bindings &bindings);
+  void flush();
+
+private:
+  std::string merged_update() const;
+
+  Sql_script &_sql_script;
+  size_t _size_limit;
+  Sql_script::Statements _statements;
+  std::string _head;
+  std::string _separator;
+  std::string _tail;
+  std::string _merged;
+  size_t _merged_size;
+
+  // Pending UPDATE group: the key column, the assigned columns and per column the WHEN branches collected so far.
+  bool _is_update;
+  std::string _key_column;
+  std::vector<std::string> _update_columns;
+  std::vector<std::string> _update_cases;
+};
+
 class WBPUBLICBACKEND_PUBLIC_FUNC Recordset_sql_storage : public Recordset_data_storage {
 public:
   typedef std::shared_ptr<Recordset_sql_storage> Ref;
@@ -206,6 +252,19 @@ public:
 
 private:
   bool _binding_blobs;
+
+public:
+  // Maximum size of a statement built by merging row changes (multi-row INSERT, DELETE ... IN (...), UPDATE ... CASE).
+  // 0 generates one statement per changed row.
+  size_t coalesce_size_limit() const {
+    return _coalesce_size_limit;
+  }
+  void coalesce_size_limit(size_t val) {
+    _coalesce_size_limit = val;
+  }
+
+private:
+  size_t _coalesce_size_limit;
 };
 
 namespace sqlite {
@@ -222,6 +281,8 @@ public:
   PrimaryKeyPredicate(const Recordset::Column_types *column_types, const Recordset::Column_names *column_names,
                       const std::vector<ColumnId> *pkey_columns, sqlide::QuoteVar *qv);
   std::string operator()(std::vector<std::shared_ptr<sqlite::result> > &data_row_results);
+  // Quoted key value for single column keys, empty for composite keys or NULL values.
+  std::string key_value(std::vector<std::shared_ptr<sqlite::result> > &data_row_results);
 };
 
 #endif /* _RECORDSET_SQL_STORAGE_BE_H_ */
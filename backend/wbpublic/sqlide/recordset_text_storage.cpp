@@ -195,6 +195,7 @@ void Recordset_text_storage::do_serialize(const Recordset *recordset, sqlite::co
   const Recordset::Column_flags &column_flags = get_column_flags(recordset);
 
   ColumnId visible_col_count = recordset->get_column_count();
+  const sqlide::VarToStr var_to_str;
   sqlide::QuoteVar qv;
   {
     if (info.quote != "")
@@ -295,7 +296,6 @@ void Recordset_text_storage::do_serialize(const Recordset *recordset, sqlite::co
               field_dictionary->setValue("FIELD_NAME", (*column_names)[col]);
 
               std::string field_value;
-              sqlide::VarToStr var_to_str;
 
               if (is_null)
                 field_value = null_syntax;
@@ -349,7 +349,6 @@ void Recordset_text_storage::do_serialize(const Recordset *recordset, sqlite::co
               mtemplate::DictionaryInterface *field_dictionary = row_dictionary->addSectionDictionary("FIELD");
               field_dictionary->setValue("FIELD_NAME", (*column_names)[col]);
               std::string field_value;
-              sqlide::VarToStr var_to_str;
 
               if (strings_are_pre_quoted)
                 field_value = (column_flags[col] & Recordset::NeedsQuoteFlag) || sqlide::is_var_null(v)
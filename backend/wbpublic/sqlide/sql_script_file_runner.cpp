@@ -0,0 +1,358 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
+
+#include "sql_script_file_runner.h"
+#include "sql_statement_stream.h"
+#include "base/string_utilities.h"
+#include "base/sqlstring.h"
+
+#include <algorithm>
+#include <list>
+#include <stdexcept>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Read only mapping of a window of a file. Only one window is mapped at a time.
+ */
+class SqlScriptFileRunner::MappedFile {
+public:
+  MappedFile(const std::string &path) : _view(nullptr), _view_size(0) {
+#ifdef _WIN32
+    _file = CreateFileW(base::path_from_utf8(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+      throw std::runtime_error(base::strfmt("Cannot open %s (error %lu)", path.c_str(), GetLastError()));
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(_file, &size);
+    _size = size.QuadPart;
+    _mapping = nullptr;
+    if (_size > 0) {
+      _mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (_mapping == nullptr) {
+        DWORD error = GetLastError();
+        CloseHandle(_file);
+        throw std::runtime_error(base::strfmt("Cannot map %s (error %lu)", path.c_str(), error));
+      }
+    }
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    _granularity = info.dwAllocationGranularity;
+#else
+    _file = open(path.c_str(), O_RDONLY);
+    if (_file < 0)
+      throw std::runtime_error(base::strfmt("Cannot open %s: %s", path.c_str(), strerror(errno)));
+
+    struct stat info;
+    if (fstat(_file, &info) < 0) {
+      int error = errno;
+      close(_file);
+      throw std::runtime_error(base::strfmt("Cannot open %s: %s", path.c_str(), strerror(error)));
+    }
+    _size = info.st_size;
+    _granularity = sysconf(_SC_PAGESIZE);
+#endif
+  }
+
+  ~MappedFile() {
+    unmap();
+#ifdef _WIN32
+    if (_mapping != nullptr)
+      CloseHandle(_mapping);
+    CloseHandle(_file);
+#else
+    close(_file);
+#endif
+  }
+
+  std::uint64_t size() const {
+    return _size;
+  }
+
+  // Maps the given range of the file (which must lie within the file) and returns a pointer to its first byte.
+  // The previously mapped window becomes invalid.
+  const char *map(std::uint64_t offset, size_t length) {
+    unmap();
+
+    // Mappings must start at a multiple of the allocation granularity.
+    std::uint64_t start = offset - offset % _granularity;
+    _view_size = (size_t)(offset - start) + length;
+#ifdef _WIN32
+    _view = MapViewOfFile(_mapping, FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)(start & 0xFFFFFFFF), _view_size);
+    if (_view == nullptr)
+      throw std::runtime_error(base::strfmt("Cannot map script file (error %lu)", GetLastError()));
+#else
+    _view = mmap(nullptr, _view_size, PROT_READ, MAP_PRIVATE, _file, (off_t)start);
+    if (_view == MAP_FAILED) {
+      _view = nullptr;
+      throw std::runtime_error(base::strfmt("Cannot map script file: %s", strerror(errno)));
+    }
+    madvise(_view, _view_size, MADV_SEQUENTIAL);
+#endif
+    return (const char *)_view + (offset - start);
+  }
+
+  void unmap() {
+    if (_view == nullptr)
+      return;
+#ifdef _WIN32
+    UnmapViewOfFile(_view);
+#else
+    munmap(_view, _view_size);
+#endif
+    _view = nullptr;
+  }
+
+private:
+#ifdef _WIN32
+  HANDLE _file;
+  HANDLE _mapping;
+#else
+  int _file;
+#endif
+  std::uint64_t _size;
+  std::uint64_t _granularity;
+  void *_view;
+  size_t _view_size;
+};
+
+//----------------- SqlScriptFileRunner ------------------------------------------------------------
+
+SqlScriptFileRunner::SqlScriptFileRunner(const std::string &path, SqlFacade::Ref sql_facade, size_t window_size)
+  : _path(path),
+    _sql_facade(sql_facade),
+    _window_size(window_size),
+    _offset(0),
+    _delimiter(";"),
+    _finished(false),
+    _stop_requested(false) {
+  _file_size = MappedFile(path).size();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+SqlScriptFileRunner::~SqlScriptFileRunner() {
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SqlScriptFileRunner::resume_from(std::uint64_t offset, const std::string &delimiter) {
+  _offset = offset;
+  _delimiter = delimiter;
+  _finished = false;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::list<std::string> SqlScriptFileRunner::context_statements() const {
+  std::list<std::string> statements;
+  if (!_default_schema.empty()) {
+    statements.push_back(base::sqlstring("CREATE SCHEMA IF NOT EXISTS !", 0) << _default_schema);
+    statements.push_back(base::sqlstring("USE !", 0) << _default_schema);
+  }
+  if (!_default_charset.empty())
+    statements.push_back(base::sqlstring("SET NAMES ?", 0) << _default_charset);
+  return statements;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+// Looks for a line like "/*!40101 SET NAMES utf8 */" in the first 4KB of the file.
+std::string SqlScriptFileRunner::detect_charset() const {
+  MappedFile file(_path);
+  size_t length = (size_t)std::min<std::uint64_t>(file.size(), 4096);
+  if (length == 0)
+    return "";
+
+  const char *data = file.map(0, length);
+  std::string head(data, length);
+  static const std::string set_names = " SET NAMES ";
+  for (std::string::size_type line = 0; line < head.size();) {
+    std::string::size_type end = head.find('\n', line);
+    if (end == std::string::npos)
+      end = head.size();
+    if (head.compare(line, 2, "/*") == 0) {
+      std::string::size_type p = head.find(set_names, line);
+      if (p != std::string::npos && p < end && head.find(' ', line) == p) {
+        p += set_names.size();
+        std::string::size_type name_end = p;
+        while (name_end < end && (isalnum((unsigned char)head[name_end]) || head[name_end] == '_'))
+          ++name_end;
+        if (name_end > p && head.compare(name_end, 3, " */") == 0)
+          return head.substr(p, name_end - p);
+      }
+    }
+    line = end + 1;
+  }
+  return "";
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool SqlScriptFileRunner::scan(const Statement_cb &statement_cb) {
+  MappedFile file(_path);
+  _file_size = file.size();
+
+  // Offsets reported by the stream are relative to the position it started at.
+  SqlStatementStream stream(_sql_facade, _delimiter);
+  const std::uint64_t start_offset = _offset;
+  const size_t slice_size = 1024 * 1024;
+  std::string text;
+  for (std::uint64_t position = _offset; position < _file_size;) {
+    // Map the next window and feed it to the splitter in smaller slices, so statements can be executed early.
+    size_t window_size = (size_t)std::min<std::uint64_t>(_window_size, _file_size - position);
+    const char *window = file.map(position, window_size);
+    for (size_t i = 0; i < window_size; i += slice_size) {
+      stream.feed(window + i, std::min(slice_size, window_size - i));
+      while (stream.next(text))
+        if (!statement_cb(text, start_offset + stream.offset(), stream.delimiter()))
+          return false;
+    }
+    file.unmap();
+    position += window_size;
+  }
+
+  stream.finish();
+  while (stream.next(text))
+    if (!statement_cb(text, start_offset + stream.offset(), stream.delimiter()))
+      return false;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+long SqlScriptFileRunner::run(sql::Statement *statement, sql::SqlBatchExec &batch_exec, size_t group_size) {
+  _stop_requested = false;
+  if (_finished)
+    return 0;
+
+  // Progress of a group is turned into progress of the whole file and statistics are summed up over all groups.
+  // The caller's callbacks are restored when done.
+  sql::SqlBatchExec::Batch_exec_progress_cb progress_cb = batch_exec._batch_exec_progress_cb;
+  sql::SqlBatchExec::Batch_exec_stat_cb stat_cb = batch_exec._batch_exec_stat_cb;
+
+  std::uint64_t group_start = _offset;
+  std::uint64_t group_end = _offset;
+  long success_count = 0;
+  long error_count = 0;
+  long group_success_count = 0;
+  if (progress_cb)
+    batch_exec.batch_exec_progress_cb([&](float progress) {
+      return progress_cb(_file_size > 0 ? (float)((group_start + progress * (group_end - group_start)) / _file_size)
+                                        : 1.f);
+    });
+  batch_exec.batch_exec_stat_cb([&](long success, long errors) {
+    group_success_count = success;
+    success_count += success;
+    error_count += errors;
+    return 0;
+  });
+
+  struct Position {
+    std::uint64_t offset;
+    std::string delimiter;
+  };
+
+  std::list<std::string> group;
+  std::vector<Position> positions;
+  size_t pending_size = 0;
+  bool failed = false;
+
+  // Runs the collected statements and moves the resume position behind the last one that succeeded.
+  // Returns false if execution must not continue.
+  auto execute_group = [&]() -> bool {
+    group_end = positions.back().offset;
+    group_success_count = 0;
+    long errors = batch_exec(statement, group);
+
+    size_t executed = positions.size();
+    if (errors > 0 && batch_exec.stop_on_error())
+      executed = (size_t)std::min<long>(group_success_count, (long)positions.size());
+    if (executed > 0) {
+      _offset = positions[executed - 1].offset;
+      _delimiter = positions[executed - 1].delimiter;
+    }
+
+    failed = errors > 0 && batch_exec.stop_on_error();
+    group.clear();
+    positions.clear();
+    pending_size = 0;
+    group_start = group_end;
+    return !failed && !_stop_requested;
+  };
+
+  try {
+    // The defaults apply to the session the script starts in. A resumed run continues in the context the script
+    // left behind.
+    bool stopped = false;
+    std::list<std::string> context = context_statements();
+    if (_offset == 0 && !context.empty()) {
+      failed = batch_exec(statement, context) > 0 && batch_exec.stop_on_error();
+      success_count = 0; // Only statements of the script count as executed, failures are reported though.
+      stopped = failed || _stop_requested;
+    }
+
+    if (!stopped) {
+      stopped = !scan([&](std::string &text, std::uint64_t offset, const std::string &delimiter) {
+        pending_size += text.size() + 1;
+        group.push_back(std::string());
+        group.back().swap(text);
+        positions.push_back({offset, delimiter});
+        return pending_size < group_size || execute_group();
+      });
+    }
+
+    if (!stopped) {
+      if (!group.empty())
+        execute_group();
+      _finished = !failed;
+    }
+  } catch (...) {
+    batch_exec.batch_exec_progress_cb(progress_cb);
+    batch_exec.batch_exec_stat_cb(stat_cb);
+    throw;
+  }
+
+  batch_exec.batch_exec_progress_cb(progress_cb);
+  batch_exec.batch_exec_stat_cb(stat_cb);
+  if (stat_cb)
+    stat_cb(success_count, error_count);
+
+  return error_count;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include "wbpublic_public_interface.h"
+#include "grtsqlparser/sql_facade.h"
+#include "cppdbc.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+
+/**
+ * Executes a SQL script file of any size directly from disk. The file is memory mapped in windows of
+ * a fixed size, split incrementally (see SqlStatementStream) and executed in groups of statements,
+ * so memory use does not depend on the size of the script.
+ *
+ * The runner keeps the byte offset (and the delimiter active there) right after the last statement
+ * which was executed successfully. A run that stopped because of an error or stop() continues from
+ * that position when run() is called again.
+ */
+class WBPUBLICBACKEND_PUBLIC_FUNC SqlScriptFileRunner {
+public:
+  SqlScriptFileRunner(const std::string &path, SqlFacade::Ref sql_facade, size_t window_size = 64 * 1024 * 1024);
+  ~SqlScriptFileRunner();
+
+  void resume_from(std::uint64_t offset, const std::string &delimiter);
+
+  // Splits the script from the current offset and passes every statement to the callback, together with the offset
+  // and delimiter right after it. The callback may take the statement text. Stops early if the callback returns false
+  // and returns whether the end of the file was reached.
+  typedef std::function<bool(std::string &, std::uint64_t, const std::string &)> Statement_cb;
+  bool scan(const Statement_cb &statement_cb);
+
+  // Executes the script from the current offset using the callbacks and error handling set up in the given
+  // batch executor. Progress is reported for the whole file and statistics once at the end of the run.
+  // group_size is the amount of statement text passed to the executor at once. Returns the error count.
+  long run(sql::Statement *statement, sql::SqlBatchExec &batch_exec, size_t group_size = 1024 * 1024);
+
+  // Schema and character set to use unless the script selects them itself. They are set up before the first
+  // statement of the file, the schema is created if it does not exist yet. Empty values leave the session as it is.
+  void default_schema(const std::string &schema) {
+    _default_schema = schema;
+  }
+  const std::string &default_schema() const {
+    return _default_schema;
+  }
+  void default_charset(const std::string &charset) {
+    _default_charset = charset;
+  }
+  const std::string &default_charset() const {
+    return _default_charset;
+  }
+
+  // The statements run() executes to set up the default schema and character set.
+  std::list<std::string> context_statements() const;
+
+  // The character set of a SET NAMES comment (as written by mysqldump) near the start of the file, if any.
+  std::string detect_charset() const;
+
+  // Makes a running run() return after the group of statements currently executing. Can be called from any thread.
+  void stop() {
+    _stop_requested = true;
+  }
+
+  const std::string &path() const {
+    return _path;
+  }
+  std::uint64_t file_size() const {
+    return _file_size;
+  }
+  std::uint64_t offset() const {
+    return _offset;
+  }
+  const std::string &delimiter() const {
+    return _delimiter;
+  }
+  bool finished() const {
+    return _finished;
+  }
+
+private:
+  class MappedFile;
+
+  std::string _path;
+  SqlFacade::Ref _sql_facade;
+  size_t _window_size;
+  std::uint64_t _file_size;
+  std::uint64_t _offset;
+  std::string _delimiter;
+  std::string _default_schema;
+  std::string _default_charset;
+  bool _finished;
+  std::atomic<bool> _stop_requested;
+};
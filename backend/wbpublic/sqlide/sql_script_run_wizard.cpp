@@ -23,10 +23,16 @@
 
 #include "grtdb/db_helpers.h"
 #include "sql_script_run_wizard.h"
+#include "sql_script_file_runner.h"
 
 #include "mforms/code_editor.h"
 #include "mforms/selector.h"
 #include "mforms/button.h"
+#include "mforms/table.h"
+#include "mforms/panel.h"
+#include "base/log.h"
+
+DEFAULT_LOG_DOMAIN("SqlScriptRunWizard")
 
 //--------------------------------------------------------------------------------------------------
 
@@ -104,6 +110,8 @@ SqlScriptReviewPage::SqlScriptReviewPage(grtui::WizardForm *form, GrtVersionRef
     _lock_selector = 0;
     _algorithm_selector = 0;
   }
+  _schema_selector = 0;
+  _charset_selector = 0;
 
   _sql_editor = mforms::manage(new mforms::CodeEditor());
   if (!version.is_valid() || version->majorNumber() < 5)
@@ -135,13 +143,34 @@ SqlScriptReviewPage::~SqlScriptReviewPage() {
 //--------------------------------------------------------------------------------------------------
 
 void SqlScriptReviewPage::enter(bool advancing) {
-  _sql_editor->set_value(values().get_string("sql_script"));
+  SqlScriptRunWizard *wizard = dynamic_cast<SqlScriptRunWizard *>(_form);
+  if (wizard != NULL && wizard->script_file_runner) {
+    // Script files are executed from disk as they may be far too large for the editor.
+    SqlScriptFileRunner *runner = wizard->script_file_runner.get();
+    std::string text = base::strfmt(_("-- The script file %s (%.2f MB) is executed directly from disk.\n"),
+                                    runner->path().c_str(), runner->file_size() / 1024.0 / 1024.0);
+    if (runner->offset() > 0)
+      text.append(base::strfmt(_("-- Execution continues at byte %llu, after the last statement which succeeded.\n"),
+                               (unsigned long long)runner->offset()));
+    _sql_editor->set_value(text);
+    _sql_editor->set_read_only(true);
+    if (_schema_selector == 0)
+      add_script_file_options(runner);
+  } else
+    _sql_editor->set_value(values().get_string("sql_script"));
   grtui::WizardPage::enter(advancing);
 }
 
 //--------------------------------------------------------------------------------------------------
 
 bool SqlScriptReviewPage::advance() {
+  SqlScriptRunWizard *wizard = dynamic_cast<SqlScriptRunWizard *>(_form);
+  if (wizard != NULL && wizard->script_file_runner) {
+    wizard->script_file_runner->default_schema(base::trim(_schema_selector->get_string_value()));
+    wizard->script_file_runner->default_charset(_charset_selector->get_string_value());
+    return grtui::WizardPage::advance();
+  }
+
   std::string sql = base::trim(_sql_editor->get_text(false));
 
   if (sql.empty())
@@ -154,6 +183,65 @@ bool SqlScriptReviewPage::advance() {
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Adds the default schema and character set choices for a script file, like the external script runner offered them.
+ */
+void SqlScriptReviewPage::add_script_file_options(SqlScriptFileRunner *runner) {
+  SqlScriptRunWizard *wizard = dynamic_cast<SqlScriptRunWizard *>(_form);
+
+  mforms::Panel *frame = mforms::manage(new mforms::Panel(mforms::TitledBoxPanel));
+  frame->set_title(_("Options"));
+  _box.add(frame, false);
+
+  mforms::Table *table = mforms::manage(new mforms::Table());
+  table->set_padding(20, 0, 20, 0);
+  table->set_row_count(2);
+  table->set_column_count(3);
+  table->set_row_spacing(8);
+  table->set_column_spacing(4);
+  frame->add(table);
+
+  table->add(mforms::manage(new mforms::Label(_("Default Schema Name:"))), 0, 1, 0, 1, 0);
+  _schema_selector = mforms::manage(new mforms::Selector(mforms::SelectorCombobox));
+  _schema_selector->add_item("");
+  for (const auto &name : wizard->schema_names)
+    _schema_selector->add_item(name);
+  _schema_selector->set_value(runner->default_schema());
+  table->add(_schema_selector, 1, 2, 0, 1, mforms::HFillFlag | mforms::HExpandFlag);
+
+  mforms::Label *help = mforms::manage(new mforms::Label(
+    _("Schema to be used unless explicitly specified in the script. Leave blank if the script already specifies it, "
+      "pick a schema from the list or type a name to create a new one.")));
+  help->set_style(mforms::SmallHelpTextStyle);
+  help->set_wrap_text(true);
+  table->add(help, 2, 3, 0, 1, mforms::HFillFlag | mforms::HExpandFlag);
+
+  table->add(mforms::manage(new mforms::Label(_("Default Character Set:"))), 0, 1, 1, 2, 0);
+  _charset_selector = mforms::manage(new mforms::Selector());
+  _charset_selector->add_item("");
+  for (const auto &name : wizard->charset_names)
+    _charset_selector->add_item(name);
+  std::string charset = runner->default_charset();
+  if (charset.empty()) {
+    try {
+      charset = runner->detect_charset();
+    } catch (std::exception &exc) {
+      logWarning("Cannot read the start of %s: %s\n", runner->path().c_str(), exc.what());
+    }
+  }
+  int index = _charset_selector->index_of_item_with_title(charset);
+  _charset_selector->set_selected(index < 0 ? 0 : index);
+  table->add(_charset_selector, 1, 2, 1, 2, mforms::HFillFlag | mforms::HExpandFlag);
+
+  help = mforms::manage(
+    new mforms::Label(_("Default character set to use when executing the script, unless specified in the script.")));
+  help->set_style(mforms::SmallHelpTextStyle);
+  help->set_wrap_text(true);
+  table->add(help, 2, 3, 1, 2, mforms::HFillFlag | mforms::HExpandFlag);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 std::string SqlScriptReviewPage::next_button_caption() {
   return _("Apply");
 }
@@ -240,9 +328,43 @@ grt::ValueRef SqlScriptApplyPage::do_execute_sql_script(const std::string &sql_s
   return grt::ValueRef();
 }
 
+grt::ValueRef SqlScriptApplyPage::do_execute_sql_script_file(SqlScriptFileRunner *runner) {
+  bec::GRTManager::get()->run_once_when_idle(
+    this, std::bind(&SqlScriptApplyPage::add_log_text, this,
+                    base::strfmt(_("Executing script file %s from byte %llu of %llu\n"), runner->path().c_str(),
+                                 (unsigned long long)runner->offset(), (unsigned long long)runner->file_size())));
+
+  _err_count = 0;
+  apply_sql_script_file(*runner);
+
+  if (_err_count || !runner->finished()) {
+    values().gset("has_errors", 1);
+    _log += base::strfmt(_("Execution stopped after byte %llu of the script file. Go back and apply again to continue "
+                           "from there.\n"),
+                         (unsigned long long)runner->offset());
+    bec::GRTManager::get()->run_once_when_idle(this, std::bind(&SqlScriptApplyPage::add_log_text, this, _log));
+    _log.clear();
+    throw std::runtime_error(_("There was an error while applying the SQL script to the database."));
+  } else {
+    bec::GRTManager::get()->run_once_when_idle(
+      this,
+      std::bind(&SqlScriptApplyPage::add_log_text, this, _("SQL script was successfully applied to the database.")));
+  }
+
+  return grt::ValueRef();
+}
+
 bool SqlScriptApplyPage::execute_sql_script() {
   values().gset("applied", 1);
   values().gset("has_errors", 0);
+
+  SqlScriptRunWizard *wizard = dynamic_cast<SqlScriptRunWizard *>(_form);
+  if (wizard != NULL && wizard->script_file_runner) {
+    execute_grt_task(
+      std::bind(&SqlScriptApplyPage::do_execute_sql_script_file, this, wizard->script_file_runner.get()), false);
+    return true;
+  }
+
   std::string sql_script = values().get_string("sql_script");
 
   // apply_sql_script(sql_script);
@@ -29,11 +29,16 @@
 #include "grtui/wizard_progress_page.h"
 #include "grtui/wizard_finished_page.h"
 
+#include <memory>
+#include <vector>
+
 namespace mforms {
   class CodeEditor;
   class Selector;
 }
 
+class SqlScriptFileRunner;
+
 class WBPUBLICBACKEND_PUBLIC_FUNC SqlScriptReviewPage : public grtui::WizardPage {
 public:
   SqlScriptReviewPage(grtui::WizardForm *form, GrtVersionRef version, std::string algorithm, std::string lock);
@@ -45,6 +50,7 @@ protected:
   virtual std::string next_button_caption();
 
   void option_changed();
+  void add_script_file_options(SqlScriptFileRunner *runner);
 
 private:
   mforms::Box _box;
@@ -52,6 +58,8 @@ private:
   mforms::CodeEditor *_sql_editor;
   mforms::Selector *_algorithm_selector;
   mforms::Selector *_lock_selector;
+  mforms::Selector *_schema_selector;
+  mforms::Selector *_charset_selector;
 };
 
 class WBPUBLICBACKEND_PUBLIC_FUNC SqlScriptApplyPage : public grtui::WizardProgressPage {
@@ -63,6 +71,7 @@ private:
   void abort_exec();
 
   grt::ValueRef do_execute_sql_script(const std::string &sql_script);
+  grt::ValueRef do_execute_sql_script_file(SqlScriptFileRunner *runner);
 
 public:
   SqlScriptApplyPage(grtui::WizardForm *form);
@@ -70,6 +79,7 @@ public:
   int on_exec_progress(float progress);
   int on_exec_stat(long success_count, long err_count);
   std::function<void(const std::string &)> apply_sql_script;
+  std::function<void(SqlScriptFileRunner &)> apply_sql_script_file;
   bool execute_sql_script();
   virtual std::string next_button_caption();
   virtual bool allow_back();
@@ -91,6 +101,14 @@ public:
 
   std::function<void()> abort_apply;
 
+  // Set to run a script file directly from disk instead of the "sql_script" value. Such scripts are not shown
+  // for review. Applying again after an error continues after the last statement that succeeded.
+  std::shared_ptr<SqlScriptFileRunner> script_file_runner;
+
+  // Choices offered for the default schema and character set of a script file.
+  std::vector<std::string> schema_names;
+  std::vector<std::string> charset_names;
+
   // Used by the wizard if an option changed.
   // Parameters: online DDL algorithm and lock.
   std::function<std::string(const std::string &, const std::string &)> regenerate_script;
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "sql_statement_stream.h"
+#include "base/string_utilities.h"
+
+#include <vector>
+
+//--------------------------------------------------------------------------------------------------
+
+static bool is_identifier_char(unsigned char c) {
+  return c >= 0x80 || (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '$' || c == '_';
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Looks for DELIMITER commands in the text between two statements (which the splitter skips) and
+ * updates the given delimiter accordingly. Comments are skipped the same way the splitter does it.
+ */
+static void scan_for_delimiter(const char *head, const char *tail, std::string &delimiter) {
+  static const char keyword[] = "delimiter ";
+  const char *start = head;
+  while (head < tail) {
+    if (head[0] == '/' && head + 1 < tail && head[1] == '*') {
+      head += 2;
+      while (head + 1 < tail && !(head[0] == '*' && head[1] == '/'))
+        ++head;
+      head += 2;
+    } else if (head[0] == '#' || (head[0] == '-' && head + 2 < tail && head[1] == '-' &&
+                                  (head[2] == ' ' || head[2] == '\t' || head[2] == '\n'))) {
+      while (head < tail && *head != '\n')
+        ++head;
+    } else if ((*head | 0x20) == 'd' && (head == start || !is_identifier_char((unsigned char)head[-1])) &&
+               tail - head > 10 && base::same_string(std::string(head, 10), keyword, false)) {
+      const char *run = head + 10;
+      head = run;
+      while (run < tail && *run != '\n')
+        ++run;
+      delimiter = base::trim(std::string(head, run - head));
+      head = run;
+    } else
+      ++head;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+SqlStatementStream::SqlStatementStream(SqlFacade::Ref sql_facade, const std::string &initial_delimiter,
+                                       size_t chunk_size)
+  : _sql_facade(sql_facade),
+    _pending_offset(0),
+    _delimiter(initial_delimiter.empty() ? ";" : initial_delimiter),
+    _chunk_size(chunk_size),
+    _split_size(chunk_size),
+    _finished(false),
+    _offset(0),
+    _statement_delimiter(_delimiter) {
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SqlStatementStream::feed(const char *data, size_t length) {
+  _pending.append(data, length);
+  if (_pending.size() >= _split_size)
+    split(false);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void SqlStatementStream::finish() {
+  if (!_finished) {
+    _finished = true;
+    split(true);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool SqlStatementStream::next(std::string &statement) {
+  if (_statements.empty())
+    return false;
+
+  Statement &front = _statements.front();
+  statement.swap(front.text);
+  _offset = front.end;
+  _statement_delimiter.swap(front.delimiter);
+  _statements.pop_front();
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Splits the pending text. Unless at_end is set, the last range found might be cut off by the chunk end.
+ * So it is kept in the buffer and split again once more text is there. The buffer is always cut right after
+ * a statement delimiter, which is the state the splitter is in after each statement.
+ */
+void SqlStatementStream::split(bool at_end) {
+  std::vector<std::pair<size_t, size_t> > ranges;
+  _sql_facade->splitSqlScript(_pending.c_str(), _pending.size(), _delimiter, ranges);
+
+  size_t complete = at_end ? ranges.size() : (ranges.empty() ? 0 : ranges.size() - 1);
+  if (complete == 0 && !at_end) {
+    // A single statement larger than the chunk. Wait for more text.
+    _split_size = _pending.size() * 2;
+    return;
+  }
+
+  std::string delimiter = _delimiter;
+  size_t previous_end = 0;
+  for (size_t i = 0; i < complete; ++i) {
+    scan_for_delimiter(_pending.data() + previous_end, _pending.data() + ranges[i].first, delimiter);
+    previous_end = std::min(ranges[i].first + ranges[i].second + delimiter.size(), _pending.size());
+
+    Statement statement;
+    statement.text = _pending.substr(ranges[i].first, ranges[i].second);
+    statement.end = _pending_offset + previous_end;
+    statement.delimiter = delimiter;
+    _statements.push_back(statement);
+  }
+
+  if (at_end)
+    previous_end = _pending.size();
+  _pending.erase(0, previous_end);
+  _pending_offset += previous_end;
+  _delimiter = delimiter;
+  _split_size = std::max(_chunk_size, _pending.size() * 2);
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include "wbpublic_public_interface.h"
+#include "grtsqlparser/sql_facade.h"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+/**
+ * Splits a SQL script into statements while it is being read, so that scripts of any size can be
+ * executed without holding their entire text in memory.
+ *
+ * Text is appended with feed() and split whenever enough of it has accumulated. Statements that are
+ * known to be complete can then be taken with next(). The last statement in the buffer is only
+ * handed out after more text arrived or finish() was called. DELIMITER commands are honored across
+ * chunk boundaries.
+ */
+class WBPUBLICBACKEND_PUBLIC_FUNC SqlStatementStream {
+public:
+  SqlStatementStream(SqlFacade::Ref sql_facade, const std::string &initial_delimiter = ";",
+                     size_t chunk_size = 1024 * 1024);
+
+  void feed(const char *data, size_t length);
+  void finish();
+  bool next(std::string &statement);
+
+  // Position in the script right after the last statement returned by next() (including its delimiter) and
+  // the delimiter which was active at that point. Feeding the script from that offset into a new stream using that delimiter
+  // continues exactly after that statement.
+  std::uint64_t offset() const {
+    return _offset;
+  }
+  const std::string &delimiter() const {
+    return _statement_delimiter;
+  }
+
+  // Number of script bytes passed to feed() so far.
+  std::uint64_t bytes_fed() const {
+    return _pending_offset + _pending.size();
+  }
+
+private:
+  struct Statement {
+    std::string text;
+    std::uint64_t end;
+    std::string delimiter;
+  };
+
+  void split(bool at_end);
+
+  SqlFacade::Ref _sql_facade;
+  std::string _pending;
+  std::uint64_t _pending_offset; // Script offset of the first char in _pending.
+  std::string _delimiter;        // Delimiter active at the start of _pending.
+  size_t _chunk_size;
+  size_t _split_size;
+  bool _finished;
+
+  std::deque<Statement> _statements;
+  std::uint64_t _offset;
+  std::string _statement_delimiter;
+};
@@ -27,6 +27,9 @@
 #include <sys/time.h>
 #endif
 #include <locale>
+#include <clocale>
+#include <cstdio>
+#include <cstring>
 
 namespace sqlide {
 
@@ -45,6 +48,76 @@ namespace sqlide {
   };
   static const IsVarTypeEqTo is_var_type_eq_to;
 
+  size_t format_integer(std::int64_t value, char *buffer) {
+    static const char digit_pairs[] =
+      "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+      "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+      "8081828384858687888990919293949596979899";
+
+    // Digits are produced back to front, two at a time. Unsigned arithmetic keeps INT64_MIN intact.
+    char digits[IntegerBufferSize];
+    char *p = digits + sizeof(digits);
+    std::uint64_t n = (value < 0) ? (0 - (std::uint64_t)value) : (std::uint64_t)value;
+    while (n >= 100) {
+      size_t pair = (size_t)(n % 100) * 2;
+      n /= 100;
+      *--p = digit_pairs[pair + 1];
+      *--p = digit_pairs[pair];
+    }
+    if (n >= 10) {
+      size_t pair = (size_t)n * 2;
+      *--p = digit_pairs[pair + 1];
+      *--p = digit_pairs[pair];
+    } else
+      *--p = (char)('0' + n);
+    if (value < 0)
+      *--p = '-';
+
+    size_t length = digits + sizeof(digits) - p;
+    memcpy(buffer, p, length);
+    return length;
+  }
+
+  size_t format_floating(long double value, char *buffer) {
+    // Same output as a stream with precision digits10 and default float field (i.e. %g).
+    int length = snprintf(buffer, FloatingBufferSize, "%.*Lg", std::numeric_limits<long double>::digits10, value);
+    if (length < 0)
+      return 0;
+    if (length >= FloatingBufferSize)
+      length = FloatingBufferSize - 1;
+
+    // printf honors LC_NUMERIC (set by the UI toolkit), while our stream based conversion always used the
+    // classic locale. Undo any localized decimal separator.
+    const char *decimal_point = localeconv()->decimal_point;
+    if (decimal_point != nullptr && decimal_point[0] != '.' && decimal_point[0] != '\0' && decimal_point[1] == '\0') {
+      char *separator = (char *)memchr(buffer, decimal_point[0], length);
+      if (separator != nullptr)
+        *separator = '.';
+    }
+    return length;
+  }
+
+  void QuoteVar::append_escaped_ansi_sql_string(std::string &output, const char *data, size_t length) {
+    // Only the quote char needs escaping (by doubling it), so copy everything between quotes in one go.
+    output.reserve(output.size() + length);
+    const char *end = data + length;
+    while (data < end) {
+      const char *quote = (const char *)memchr(data, '\'', end - data);
+      if (quote == nullptr)
+        break;
+      output.append(data, quote - data + 1);
+      output.push_back('\'');
+      data = quote + 1;
+    }
+    output.append(data, end - data);
+  }
+
+  std::string QuoteVar::escape_ansi_sql_string(const std::string &text) {
+    std::string escaped;
+    append_escaped_ansi_sql_string(escaped, text.data(), text.size());
+    return escaped;
+  }
+
   bool is_var_null(const sqlite::variant_t &value) {
     static const sqlite::variant_t null_value = sqlite::null_t();
     return boost::apply_visitor(is_var_type_eq_to, value, null_value);
@@ -37,6 +37,12 @@ namespace sqlide {
 
   using namespace sqlite;
 
+  // Allocation free formatting kernels for cell values. They write into a caller supplied buffer
+  // (of at least the given size) and return the number of characters written.
+  enum { IntegerBufferSize = 24, FloatingBufferSize = 64 };
+  WBPUBLICBACKEND_PUBLIC_FUNC size_t format_integer(std::int64_t value, char *buffer);
+  WBPUBLICBACKEND_PUBLIC_FUNC size_t format_floating(long double value, char *buffer);
+
   class WBPUBLICBACKEND_PUBLIC_FUNC VarEq : public boost::static_visitor<bool> {
   public:
     VarEq() {
@@ -126,6 +132,19 @@ namespace sqlide {
                : v;
     }
 
+    result_type operator()(const int &v) const {
+      char buffer[IntegerBufferSize];
+      return std::string(buffer, format_integer(v, buffer));
+    }
+    result_type operator()(const std::int64_t &v) const {
+      char buffer[IntegerBufferSize];
+      return std::string(buffer, format_integer(v, buffer));
+    }
+    result_type operator()(const long double &v) const {
+      char buffer[FloatingBufferSize];
+      return std::string(buffer, format_floating(v, buffer));
+    }
+
     template <typename T>
     result_type operator()(const T &v) const {
       StateKeeper sk(const_cast<VarConvBase *>((const VarConvBase *)this));
@@ -251,32 +270,8 @@ namespace sqlide {
     bool bitMode;
     bool needQuote;
 
-    static std::string escape_ansi_sql_string(const std::string &text) // used by sqlite
-    {
-      std::string escaped;
-      std::string::size_type p, s, len = text.length();
-
-      // escapes '
-
-      p = 0;
-      s = 0;
-      while (p < len) {
-        switch (text[p]) {
-          case '\'':
-            if (p > s)
-              escaped.append(text.substr(s, p - s));
-            escaped.append("\'");
-            escaped.append(text.substr(p, 1));
-            s = p + 1;
-            break;
-        }
-        p++;
-      }
-      if (p > s)
-        escaped.append(text.substr(s));
-
-      return escaped;
-    }
+    static std::string escape_ansi_sql_string(const std::string &text); // used by sqlite
+    static void append_escaped_ansi_sql_string(std::string &output, const char *data, size_t length);
 
     static std::string blob_to_hex_string(const unsigned char *data, size_t size) {
       static const char hex_dig[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
@@ -291,6 +286,17 @@ namespace sqlide {
       return out;
     }
 
+    result_type quoted(const std::string &escaped) const {
+      if (!needQuote)
+        return escaped;
+      std::string result;
+      result.reserve(escaped.size() + 2 * quote.size() + 1);
+      if (bitMode)
+        result.push_back('b');
+      result.append(quote).append(escaped).append(quote);
+      return result;
+    }
+
     result_type operator()(const unknown_t &, const std::string &v) const {
       static std::string t;
       return store_unknown_as_string ? operator()(t, v) : v;
@@ -315,10 +321,25 @@ namespace sqlide {
           if ((v.size() > func_call_seq.size()) && (v.compare(0, func_call_seq.size(), func_call_seq) == 0))
             return v.substr(func_call_seq.size());
           else if ((v.size() > func_call_exc.size()) && (v.compare(0, func_call_exc.size(), func_call_exc) == 0))
-            return (needQuote ? ((bitMode ? "b" : "" ) + quote) : "") + escape_string(v.substr(1)) + (needQuote ? quote : "");
+            return quoted(escape_string(v.substr(1)));
         }
       }
-      return (needQuote ? ((bitMode ? "b" : "" ) + quote) : "") + escape_string(v) + (needQuote ? quote : "");
+      return quoted(escape_string(v));
+    }
+    template <typename T>
+    result_type operator()(const T &, const int &v) const {
+      char buffer[IntegerBufferSize];
+      return std::string(buffer, format_integer(v, buffer));
+    }
+    template <typename T>
+    result_type operator()(const T &, const std::int64_t &v) const {
+      char buffer[IntegerBufferSize];
+      return std::string(buffer, format_integer(v, buffer));
+    }
+    template <typename T>
+    result_type operator()(const T &, const long double &v) const {
+      char buffer[FloatingBufferSize];
+      return std::string(buffer, format_floating(v, buffer));
     }
     template <typename T>
     result_type operator()(const T &, const blob_ref_t &v) const {
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "sqlide/recordset_sql_storage.h"
+#include "sqlide/recordset_be.h"
+#include "sqlide/sqlide_generics.h"
+#include "base/string_utilities.h"
+#include "wb_helpers.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Serves the fixed table `test`.`t` (id INT PRIMARY KEY, name VARCHAR, qty INT) with the rows (1, 'a', 10) up to
+ * (4, 'd', 40). The key is copied into an aux column like the SQL editor storage does it. Applying changes only
+ * records the generated script.
+ */
+class FixedTableStorage : public Recordset_sql_storage {
+public:
+  typedef std::shared_ptr<FixedTableStorage> Ref;
+  static Ref create() {
+    return Ref(new FixedTableStorage());
+  }
+
+  Sql_script script;
+
+protected:
+  FixedTableStorage() {
+    schema_name("test");
+    table_name("t");
+  }
+
+  virtual void do_unserialize(Recordset *recordset, sqlite::connection *data_swap_db) {
+    Recordset_sql_storage::do_unserialize(recordset, data_swap_db);
+
+    Recordset::Column_names &column_names = get_column_names(recordset);
+    Recordset::Column_types &column_types = get_column_types(recordset);
+    Recordset::Column_types &real_column_types = get_real_column_types(recordset);
+    Recordset::Column_flags &column_flags = get_column_flags(recordset);
+    Recordset::DBColumn_types &db_column_types = getDbColumnTypes(recordset);
+
+    static const char *names[] = {"id", "name", "qty", "id"};
+    for (size_t n = 0; n < 4; ++n) {
+      column_names.push_back(names[n]);
+      column_types.push_back(n == 1 ? sqlite::variant_t(std::string()) : sqlite::variant_t(int()));
+      real_column_types.push_back(column_types.back());
+      column_flags.push_back(n == 1 ? Recordset::NeedsQuoteFlag : 0);
+      if (n < 3)
+        db_column_types.push_back(n == 1 ? "VARCHAR" : "INT");
+    }
+    _pkey_columns.push_back(3);
+
+    sqlide::Sqlite_transaction_guarder transaction_guarder(data_swap_db, false);
+    create_data_swap_tables(data_swap_db, column_names, column_types);
+    std::list<std::shared_ptr<sqlite::command> > insert_commands =
+      prepare_data_swap_record_add_statement(data_swap_db, column_names);
+    Var_vector row_values(4);
+    for (int id = 1; id <= 4; ++id) {
+      row_values[0] = id;
+      row_values[1] = std::string(1, (char)('a' + id - 1));
+      row_values[2] = id * 10;
+      row_values[3] = id;
+      add_data_swap_record(insert_commands, row_values);
+    }
+    transaction_guarder.commit();
+
+    _readonly = false;
+    _valid = true;
+  }
+
+  virtual void run_sql_script(const Sql_script &sql_script, bool skip_commit) {
+    script = sql_script;
+  }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+BEGIN_TEST_DATA_CLASS(dml_coalescer)
+public:
+WBTester *wbt;
+TEST_DATA_CONSTRUCTOR(dml_coalescer) {
+  wbt = new WBTester;
+}
+END_TEST_DATA_CLASS
+
+TEST_MODULE(dml_coalescer, "Row change coalescing");
+
+static Recordset::Ref open_table(const FixedTableStorage::Ref &storage) {
+  Recordset::Ref rs = Recordset::create();
+  rs->data_storage(storage);
+  rs->reset();
+  ensure_equals("rows (with placeholder)", rs->count(), 5U);
+  return rs;
+}
+
+static std::vector<std::string> statements(const Sql_script &script) {
+  ensure_equals("one binding list per statement", script.statements_bindings.size(), script.statements.size());
+  return std::vector<std::string>(script.statements.begin(), script.statements.end());
+}
+
+// Compatible neighbours are merged, everything else keeps its position.
+TEST_FUNCTION(1) {
+  Sql_script script;
+  {
+    DmlCoalescer coalescer(script, 1024);
+    coalescer.add("INSERT INTO t (a) VALUES (1)", "INSERT INTO t (a) VALUES ", ", ", "(1)", "");
+    coalescer.add("INSERT INTO t (a) VALUES (2)", "INSERT INTO t (a) VALUES ", ", ", "(2)", "");
+    coalescer.add("DELETE FROM t WHERE (`a` = 3)", "DELETE FROM t WHERE `a` IN (", ", ", "3", ")");
+    coalescer.add_other("UPDATE t SET `b` = ? WHERE (`a` = 4)", Sql_script::Statement_bindings(1, std::string("x")));
+    coalescer.add("DELETE FROM t WHERE (`a` = 5)", "DELETE FROM t WHERE `a` IN (", ", ", "5", ")");
+    coalescer.add("DELETE FROM t WHERE (`a` = 6)", "DELETE FROM t WHERE `a` IN (", ", ", "6", ")");
+    coalescer.add("INSERT INTO t (b) VALUES (7)", "INSERT INTO t (b) VALUES ", ", ", "(7)", "");
+  } // The destructor flushes the last group.
+
+  std::vector<std::string> result = statements(script);
+  ensure_equals("statement count", result.size(), 5U);
+  ensure_equals("multi-row insert", result[0], "INSERT INTO t (a) VALUES (1), (2)");
+  ensure_equals("single delete keeps its form", result[1], "DELETE FROM t WHERE (`a` = 3)");
+  ensure_equals("other statement", result[2], "UPDATE t SET `b` = ? WHERE (`a` = 4)");
+  ensure_equals("delete with key list", result[3], "DELETE FROM t WHERE `a` IN (5, 6)");
+  ensure_equals("insert into other columns", result[4], "INSERT INTO t (b) VALUES (7)");
+  ensure_equals("bindings stay with their statement", std::next(script.statements_bindings.begin(), 2)->size(), 1U);
+
+  ensure_equals("merged statement count", script.merged_statements.size(), 2U);
+  std::list<std::string> parts = script.merged_statements["DELETE FROM t WHERE `a` IN (5, 6)"];
+  ensure_equals("delete parts", parts.size(), 2U);
+  ensure_equals("first delete part", parts.front(), "DELETE FROM t WHERE (`a` = 5)");
+  ensure_equals("second delete part", parts.back(), "DELETE FROM t WHERE (`a` = 6)");
+}
+
+// Merged statements never exceed the size limit and a limit of 0 disables merging.
+TEST_FUNCTION(2) {
+  Sql_script script;
+  {
+    // "INSERT INTO t (a) VALUES (1), (2)" has 33 characters.
+    DmlCoalescer coalescer(script, 33);
+    for (int i = 1; i <= 5; ++i)
+      coalescer.add(base::strfmt("INSERT INTO t (a) VALUES (%i)", i), "INSERT INTO t (a) VALUES ", ", ",
+                    base::strfmt("(%i)", i), "");
+  }
+  std::vector<std::string> result = statements(script);
+  ensure_equals("statement count", result.size(), 3U);
+  ensure_equals("first chunk", result[0], "INSERT INTO t (a) VALUES (1), (2)");
+  ensure_equals("second chunk", result[1], "INSERT INTO t (a) VALUES (3), (4)");
+  ensure_equals("last chunk", result[2], "INSERT INTO t (a) VALUES (5)");
+
+  script.reset();
+  {
+    DmlCoalescer coalescer(script, 0);
+    coalescer.add("INSERT INTO t (a) VALUES (1)", "INSERT INTO t (a) VALUES ", ", ", "(1)", "");
+    coalescer.add("INSERT INTO t (a) VALUES (2)", "INSERT INTO t (a) VALUES ", ", ", "(2)", "");
+    DmlCoalescer::Assignments assignments(1, std::make_pair(std::string("b"), std::string("1")));
+    coalescer.add_update("UPDATE t SET `b` = 1 WHERE (`a` = 1)", "t", "a", "1", assignments);
+    coalescer.add_update("UPDATE t SET `b` = 1 WHERE (`a` = 2)", "t", "a", "2", assignments);
+  }
+  ensure_equals("no merging without limit", statements(script).size(), 4U);
+  ensure("nothing merged", script.merged_statements.empty());
+}
+
+// UPDATEs are merged only if they change the same columns of the same table.
+TEST_FUNCTION(3) {
+  DmlCoalescer::Assignments b_x(1, std::make_pair(std::string("b"), std::string("'x'")));
+  DmlCoalescer::Assignments b_y(1, std::make_pair(std::string("b"), std::string("'y'")));
+  DmlCoalescer::Assignments b_c;
+  b_c.push_back(std::make_pair(std::string("b"), std::string("'z'")));
+  b_c.push_back(std::make_pair(std::string("c"), std::string("NULL")));
+
+  Sql_script script;
+  {
+    DmlCoalescer coalescer(script, 1024);
+    coalescer.add_update("UPDATE t SET `b` = 'x' WHERE (`a` = 1)", "t", "a", "1", b_x);
+    coalescer.add_update("UPDATE t SET `b` = 'y' WHERE (`a` = 2)", "t", "a", "2", b_y);
+    coalescer.add_update("UPDATE t SET `b` = 'z', `c` = NULL WHERE (`a` = 3)", "t", "a", "3", b_c);
+    coalescer.add_update("UPDATE t SET `b` = 'z', `c` = NULL WHERE (`a` = 4)", "t", "a", "4", b_c);
+    coalescer.add_update("UPDATE u SET `b` = 'x' WHERE (`a` = 5)", "u", "a", "5", b_x);
+    coalescer.add("DELETE FROM u WHERE (`a` = 6)", "DELETE FROM u WHERE `a` IN (", ", ", "6", ")");
+  }
+
+  std::vector<std::string> result = statements(script);
+  ensure_equals("statement count", result.size(), 4U);
+  ensure_equals("same column", result[0],
+                "UPDATE t SET `b` = CASE `a` WHEN 1 THEN 'x' WHEN 2 THEN 'y' END WHERE `a` IN (1, 2)");
+  ensure_equals("same columns", result[1],
+                "UPDATE t SET `b` = CASE `a` WHEN 3 THEN 'z' WHEN 4 THEN 'z' END, "
+                "`c` = CASE `a` WHEN 3 THEN NULL WHEN 4 THEN NULL END WHERE `a` IN (3, 4)");
+  ensure_equals("other table", result[2], "UPDATE u SET `b` = 'x' WHERE (`a` = 5)");
+  ensure_equals("delete", result[3], "DELETE FROM u WHERE (`a` = 6)");
+
+  std::list<std::string> parts = script.merged_statements[result[1]];
+  ensure_equals("update parts", parts.size(), 2U);
+  ensure_equals("first update part", parts.front(), "UPDATE t SET `b` = 'z', `c` = NULL WHERE (`a` = 3)");
+
+  // The merged UPDATE of the first two rows has 83 characters, a third row does not fit.
+  script.reset();
+  {
+    DmlCoalescer coalescer(script, 83);
+    for (int i = 1; i <= 3; ++i)
+      coalescer.add_update(base::strfmt("UPDATE t SET `b` = 'x' WHERE (`a` = %i)", i), "t", "a",
+                           base::strfmt("%i", i), b_x);
+  }
+  result = statements(script);
+  ensure_equals("limited update count", result.size(), 2U);
+  ensure_equals("limited update", result[0],
+                "UPDATE t SET `b` = CASE `a` WHEN 1 THEN 'x' WHEN 2 THEN 'x' END WHERE `a` IN (1, 2)");
+  ensure_equals("remaining update", result[1], "UPDATE t SET `b` = 'x' WHERE (`a` = 3)");
+}
+
+// Script generation for edited rows: UPDATEs of the same columns are merged, key changes are not.
+TEST_FUNCTION(4) {
+  FixedTableStorage::Ref storage = FixedTableStorage::create();
+  storage->coalesce_size_limit(1024);
+  Recordset::Ref rs = open_table(storage);
+
+  rs->set_field(bec::NodeId(0), 1, std::string("A"));
+  rs->set_field(bec::NodeId(1), 1, std::string("B"));
+  rs->set_field(bec::NodeId(2), 1, std::string("C"));
+  rs->set_field(bec::NodeId(2), 2, (ssize_t)33);
+  rs->set_field(bec::NodeId(3), 0, (ssize_t)40);
+  storage->apply_changes(rs, false);
+
+  std::vector<std::string> result = statements(storage->script);
+  ensure_equals("statement count", result.size(), 3U);
+  ensure_equals("merged update", result[0],
+                "UPDATE `test`.`t` SET `name` = CASE `id` WHEN 1 THEN 'A' WHEN 2 THEN 'B' END WHERE `id` IN (1, 2)");
+  ensure_equals("other columns", result[1], "UPDATE `test`.`t` SET `name` = 'C', `qty` = 33 WHERE (`id` = 3)");
+  ensure_equals("key change", result[2], "UPDATE `test`.`t` SET `id` = 40 WHERE (`id` = 4)");
+
+  std::list<std::string> parts = storage->script.merged_statements[result[0]];
+  ensure_equals("update parts", parts.size(), 2U);
+  ensure_equals("first update part", parts.front(), "UPDATE `test`.`t` SET `name` = 'A' WHERE (`id` = 1)");
+  ensure_equals("second update part", parts.back(), "UPDATE `test`.`t` SET `name` = 'B' WHERE (`id` = 2)");
+}
+
+// Script generation for deleted and added rows, with and without coalescing.
+TEST_FUNCTION(5) {
+  for (size_t limit = 0; limit <= 1024; limit += 1024) {
+    FixedTableStorage::Ref storage = FixedTableStorage::create();
+    storage->coalesce_size_limit(limit);
+    Recordset::Ref rs = open_table(storage);
+
+    std::vector<bec::NodeId> deleted;
+    deleted.push_back(bec::NodeId(2));
+    deleted.push_back(bec::NodeId(3));
+    rs->delete_nodes(deleted);
+    for (ssize_t id = 5; id <= 6; ++id) {
+      bec::NodeId placeholder(rs->count() - 1);
+      rs->set_field(placeholder, 0, id);
+      rs->set_field(placeholder, 1, std::string(1, (char)('a' + id - 1)));
+      rs->set_field(placeholder, 2, id * 10);
+    }
+    storage->apply_changes(rs, false);
+
+    std::vector<std::string> result = statements(storage->script);
+    if (limit == 0) {
+      ensure_equals("statement count", result.size(), 4U);
+      ensure_equals("delete", result[0], "DELETE FROM `test`.`t` WHERE (`id` = 3)");
+      ensure_equals("insert", result[3], "INSERT INTO `test`.`t` (`id`, `name`, `qty`) VALUES (6, 'f', 60)");
+      ensure("nothing merged", storage->script.merged_statements.empty());
+    } else {
+      ensure_equals("statement count", result.size(), 2U);
+      ensure_equals("merged delete", result[0], "DELETE FROM `test`.`t` WHERE `id` IN (3, 4)");
+      ensure_equals("merged insert", result[1],
+                    "INSERT INTO `test`.`t` (`id`, `name`, `qty`) VALUES (5, 'e', 50), (6, 'f', 60)");
+      ensure_equals("merged statement count", storage->script.merged_statements.size(), 2U);
+    }
+  }
+}
+
+END_TESTS
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "sqlide/sql_script_file_runner.h"
+#include "grtsqlparser/sql_facade.h"
+#include "base/file_utilities.h"
+#include "connection_helpers.h"
+#include "cppdbc.h"
+#include "wb_helpers.h"
+
+#include <string.h>
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+BEGIN_TEST_DATA_CLASS(sql_script_file_runner)
+public:
+WBTester *wbt;
+SqlFacade::Ref sql_facade;
+sql::ConnectionWrapper connection;
+TEST_DATA_CONSTRUCTOR(sql_script_file_runner) : sql_facade(nullptr) {
+  wbt = new WBTester;
+}
+END_TEST_DATA_CLASS
+
+TEST_MODULE(sql_script_file_runner, "SQL script file runner");
+
+static const char *script_file = "sql_script_file_runner_test.sql";
+
+static void dummy() {
+}
+
+struct Scanned {
+  std::string text;
+  std::uint64_t offset;
+  std::string delimiter;
+};
+
+static std::vector<Scanned> scan(SqlScriptFileRunner &runner) {
+  std::vector<Scanned> result;
+  ensure("scan reached the end", runner.scan([&](std::string &text, std::uint64_t offset, const std::string &delimiter) {
+    result.push_back({text, offset, delimiter});
+    return true;
+  }));
+  return result;
+}
+
+// Counts the rows of the test table, which lives in the schema the runner made the default one.
+static int row_count(sql::Statement *statement) {
+  std::unique_ptr<sql::ResultSet> rs(statement->executeQuery("SELECT COUNT(*) FROM t"));
+  ensure("count row", rs->next());
+  return (int)rs->getInt64(1);
+}
+
+TEST_FUNCTION(1) {
+  wbt->create_new_document();
+  sql_facade = SqlFacade::instance_for_rdbms(wbt->wb->get_document()->physicalModels().get(0)->rdbms());
+  ensure("failed to get sqlparser module", sql_facade != nullptr);
+}
+
+// Statements found in the mapped file must be the same for any window size, including windows which end in the
+// middle of a statement, a comment or a DELIMITER command.
+TEST_FUNCTION(2) {
+  std::string script =
+    "SELECT 1;\n"
+    "INSERT INTO t VALUES ('a;b', \"c;\\\"d\");\n"
+    "-- comment; here\n"
+    "DELIMITER $$\n"
+    "CREATE PROCEDURE p() BEGIN SELECT 1; END$$\n"
+    "DELIMITER ;\n"
+    "/* block ; */ UPDATE t SET a = 1;\n"
+    "DELIMITER //\n"
+    "SELECT 2//\n"
+    "delimiter ;\n"
+    "SELECT `x;y` FROM z";
+  base::setTextFileContent(script_file, script);
+
+  std::vector<std::pair<size_t, size_t> > ranges;
+  sql_facade->splitSqlScript(script.c_str(), script.size(), ";", ranges);
+  ensure_equals("statement count", ranges.size(), 6U);
+
+  for (size_t window_size = 1; window_size <= 41; ++window_size) {
+    // The last round uses the default window, which holds the whole file.
+    SqlScriptFileRunner runner(script_file, sql_facade, window_size <= 40 ? window_size : 64 * 1024 * 1024);
+    ensure_equals("file size", runner.file_size(), (std::uint64_t)script.size());
+
+    std::vector<Scanned> statements = scan(runner);
+    ensure_equals("statement count", statements.size(), ranges.size());
+    for (size_t i = 0; i < ranges.size(); ++i) {
+      ensure_equals("statement text", statements[i].text, script.substr(ranges[i].first, ranges[i].second));
+      ensure("offset behind the statement", statements[i].offset >= ranges[i].first + ranges[i].second);
+      ensure("offset before the next statement",
+             i + 1 == ranges.size() || statements[i].offset <= ranges[i + 1].first);
+    }
+    ensure_equals("delimiter after the procedure", statements[2].delimiter, "$$");
+    ensure_equals("delimiter after the last statement", statements.back().delimiter, ";");
+  }
+
+  // Resuming behind any statement continues with exactly the statements that follow it.
+  SqlScriptFileRunner runner(script_file, sql_facade, 16);
+  std::vector<Scanned> statements = scan(runner);
+  for (size_t i = 0; i < statements.size(); ++i) {
+    SqlScriptFileRunner resumed(script_file, sql_facade, 16);
+    resumed.resume_from(statements[i].offset, statements[i].delimiter);
+    std::vector<Scanned> rest = scan(resumed);
+    ensure_equals("remaining statement count", rest.size(), statements.size() - i - 1);
+    for (size_t j = 0; j < rest.size(); ++j) {
+      ensure_equals("remaining statement", rest[j].text, statements[i + j + 1].text);
+      ensure_equals("remaining offset", rest[j].offset, statements[i + j + 1].offset);
+    }
+  }
+
+  // The callback can stop the scan.
+  size_t count = 0;
+  ensure("stopped scan", !runner.scan([&](std::string &, std::uint64_t, const std::string &) { return ++count < 2; }));
+  ensure_equals("statements seen before stopping", count, 2U);
+
+  base::tryRemove(script_file);
+}
+
+// Default schema and character set.
+TEST_FUNCTION(3) {
+  base::setTextFileContent(script_file,
+                           "-- MySQL dump 10.13\n"
+                           "/*!40101 SET @OLD_CHARACTER_SET_CLIENT=@@CHARACTER_SET_CLIENT */;\n"
+                           "/*!40101 SET NAMES utf8mb4 */;\n"
+                           "SELECT 1;\n");
+  SqlScriptFileRunner runner(script_file, sql_facade);
+  ensure_equals("charset from dump header", runner.detect_charset(), "utf8mb4");
+  ensure("no context by default", runner.context_statements().empty());
+
+  runner.default_schema("my schema");
+  std::list<std::string> context = runner.context_statements();
+  ensure_equals("schema statements", context.size(), 2U);
+  ensure_equals("create schema", context.front(), "CREATE SCHEMA IF NOT EXISTS `my schema`");
+  ensure_equals("use schema", context.back(), "USE `my schema`");
+
+  runner.default_charset("latin1");
+  context = runner.context_statements();
+  ensure_equals("context statements", context.size(), 3U);
+  ensure_equals("set names", context.back(), "SET NAMES 'latin1'");
+
+  runner.default_schema("");
+  ensure_equals("charset only", runner.context_statements().size(), 1U);
+
+  base::setTextFileContent(script_file, "SELECT 'SET NAMES utf8 */';\n/* SET NAMES */\n");
+  ensure_equals("no charset", SqlScriptFileRunner(script_file, sql_facade).detect_charset(), "");
+
+  base::setTextFileContent(script_file, "");
+  ensure_equals("empty file", SqlScriptFileRunner(script_file, sql_facade).detect_charset(), "");
+
+  base::tryRemove(script_file);
+}
+
+TEST_FUNCTION(4) {
+  populate_grt(*wbt);
+
+  connection = sql::DriverManager::getDriverManager()->getConnection(wbt->get_connection_properties(),
+                                                                       std::bind(dummy));
+  ensure("connection", connection.get() != nullptr);
+}
+
+// Execution in groups, stopping at the first error and resuming behind it.
+TEST_FUNCTION(5) {
+  std::string script =
+    "DROP TABLE IF EXISTS t;\n"
+    "CREATE TABLE t (id INT PRIMARY KEY);\n"
+    "INSERT INTO t VALUES (1);\n"
+    "INSERT INTO t VALUES (2);\n"
+    "INSERT INTO t VALUES (1);\n"
+    "INSERT INTO t VALUES (3);\n"
+    "DELIMITER $$\n"
+    "INSERT INTO t VALUES (4)$$\n"
+    "DELIMITER ;\n"
+    "INSERT INTO t VALUES (5);\n";
+  base::setTextFileContent(script_file, script);
+  std::unique_ptr<sql::Statement> statement(connection->createStatement());
+
+  long successes = 0;
+  long errors = 0;
+  long reported_errors = 0;
+  float progress = 0;
+  sql::SqlBatchExec batch_exec;
+  batch_exec.error_cb([&](long long, const std::string &, const std::string &) {
+    ++reported_errors;
+    return 0;
+  });
+  batch_exec.batch_exec_stat_cb([&](long success, long error) {
+    successes = success;
+    errors = error;
+    return 0;
+  });
+  batch_exec.batch_exec_progress_cb([&](float value) {
+    ensure("progress does not go back", value >= progress);
+    progress = value;
+    return 0;
+  });
+
+  // Groups of about two statements.
+  SqlScriptFileRunner runner(script_file, sql_facade);
+  runner.default_schema("sql_script_file_runner_test");
+  ensure_equals("errors", runner.run(statement.get(), batch_exec, 40), 1);
+  ensure_equals("reported errors", reported_errors, 1);
+  ensure_equals("statistics", successes, 4);
+  ensure_equals("statistics errors", errors, 1);
+  ensure("not finished", !runner.finished());
+  std::string::size_type failed = script.find("INSERT INTO t VALUES (1);\nINSERT INTO t VALUES (3)");
+  // Offsets point right behind the delimiter of a statement.
+  ensure_equals("stopped behind the last good statement", runner.offset(), (std::uint64_t)failed - 1);
+  ensure_equals("rows", row_count(statement.get()), 2);
+
+  // The failing statement is skipped, the session is still in the default schema.
+  runner.resume_from(failed + strlen("INSERT INTO t VALUES (1);"), ";");
+  progress = 0;
+  ensure_equals("errors after resume", runner.run(statement.get(), batch_exec, 40), 0);
+  ensure_equals("statistics after resume", successes, 3);
+  ensure_equals("statistics errors after resume", errors, 0);
+  ensure("finished", runner.finished());
+  ensure_equals("end offset", runner.offset(), (std::uint64_t)script.size() - 1);
+  ensure_equals("rows after resume", row_count(statement.get()), 5);
+  ensure_equals("nothing left to run", runner.run(statement.get(), batch_exec), 0);
+
+  // Without stopping on errors everything runs at once, in groups of single statements.
+  batch_exec.stop_on_error(false);
+  reported_errors = 0;
+  progress = 0;
+  SqlScriptFileRunner full_run(script_file, sql_facade);
+  full_run.default_schema("sql_script_file_runner_test");
+  ensure_equals("errors without stopping", full_run.run(statement.get(), batch_exec, 1), 1);
+  ensure_equals("reported errors without stopping", reported_errors, 1);
+  ensure_equals("statistics without stopping", successes, 7);
+  ensure("finished without stopping", full_run.finished());
+  ensure_equals("rows without stopping", row_count(statement.get()), 5);
+
+  statement->execute("DROP SCHEMA sql_script_file_runner_test");
+  base::tryRemove(script_file);
+}
+
+// Due to the tut nature, this must be executed as a last test always,
+// we can't have this inside of the d-tor.
+TEST_FUNCTION(99) {
+  delete wbt;
+}
+
+END_TESTS
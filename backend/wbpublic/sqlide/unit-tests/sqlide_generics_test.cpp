@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "sqlide/sqlide_generics.h"
+#include "base/string_utilities.h"
+#include "wb_helpers.h"
+
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <locale>
+#include <sstream>
+
+BEGIN_TEST_DATA_CLASS(sqlide_generics)
+END_TEST_DATA_CLASS
+
+TEST_MODULE(sqlide_generics, "SQL IDE value formatting");
+
+// The text a stream produced for the value before the formatting kernels replaced it.
+template <typename T>
+static std::string stream_format(T value) {
+  std::ostringstream stream;
+  stream.imbue(std::locale::classic());
+  stream.precision(std::numeric_limits<long double>::digits10);
+  stream << value;
+  return stream.str();
+}
+
+static std::string format_integer(std::int64_t value) {
+  char buffer[sqlide::IntegerBufferSize];
+  return std::string(buffer, sqlide::format_integer(value, buffer));
+}
+
+static std::string format_floating(long double value) {
+  char buffer[sqlide::FloatingBufferSize];
+  return std::string(buffer, sqlide::format_floating(value, buffer));
+}
+
+TEST_FUNCTION(1) {
+  const std::int64_t values[] = {0,
+                                 1,
+                                 9,
+                                 10,
+                                 99,
+                                 100,
+                                 101,
+                                 -1,
+                                 -10,
+                                 -99,
+                                 1234567890123LL,
+                                 -1234567890123LL,
+                                 std::numeric_limits<std::int32_t>::max(),
+                                 std::numeric_limits<std::int32_t>::min(),
+                                 std::numeric_limits<std::int64_t>::max(),
+                                 std::numeric_limits<std::int64_t>::min()};
+  for (std::int64_t value : values)
+    ensure_equals("integer", format_integer(value), stream_format(value));
+
+  // Every length from 1 to 19 digits.
+  std::int64_t value = 7;
+  for (int digits = 1; digits < 19; ++digits, value = value * 10 + 3) {
+    ensure_equals("positive integer", format_integer(value), stream_format(value));
+    ensure_equals("negative integer", format_integer(-value), stream_format(-value));
+  }
+}
+
+TEST_FUNCTION(2) {
+  const long double values[] = {0.0L, 1.5L, -2.25L, 1e-20L, 1e20L, 3.14159265358979L, 0.1L, 1.0L / 3, 123456789.0L,
+                                -0.000125L};
+  for (long double value : values)
+    ensure_equals("floating", format_floating(value), stream_format(value));
+
+  ensure_equals("exponent", format_floating(1e-20L), "1e-20");
+  ensure_equals("fraction", format_floating(1.5L), "1.5");
+}
+
+// Conversion and quoting of cell values.
+TEST_FUNCTION(3) {
+  sqlide::VarToStr var_to_str;
+  ensure_equals("int", boost::apply_visitor(var_to_str, sqlite::variant_t(-42)), "-42");
+  ensure_equals("int64 max",
+                boost::apply_visitor(var_to_str, sqlite::variant_t(std::numeric_limits<std::int64_t>::max())),
+                "9223372036854775807");
+  ensure_equals("int64 min",
+                boost::apply_visitor(var_to_str, sqlite::variant_t(std::numeric_limits<std::int64_t>::min())),
+                "-9223372036854775808");
+  ensure_equals("double", boost::apply_visitor(var_to_str, sqlite::variant_t((long double)1.5)), "1.5");
+  ensure_equals("double exp", boost::apply_visitor(var_to_str, sqlite::variant_t(1e-20L)), "1e-20");
+
+  sqlide::QuoteVar qv;
+  qv.escape_string = std::bind(sqlide::QuoteVar::escape_ansi_sql_string, std::placeholders::_1);
+  qv.blob_to_string = std::bind(sqlide::QuoteVar::blob_to_hex_string, std::placeholders::_1, std::placeholders::_2);
+  sqlite::variant_t string_type = std::string();
+  sqlite::variant_t blob_type = sqlite::blob_ref_t();
+  ensure_equals("quoted int", boost::apply_visitor(qv, string_type, sqlite::variant_t(7)), "7");
+  ensure_equals("quoted string", boost::apply_visitor(qv, string_type, sqlite::variant_t(std::string("it's"))),
+                "'it''s'");
+  ensure_equals("blob as hex", boost::apply_visitor(qv, blob_type, sqlite::variant_t(std::string("\x01\xAB"))),
+                "0x01AB");
+  qv.needQuote = false;
+  ensure_equals("unquoted string", boost::apply_visitor(qv, string_type, sqlite::variant_t(std::string("''"))),
+                "''''");
+}
+
+// The ANSI escaper copies the runs between quotes in one go.
+TEST_FUNCTION(4) {
+  ensure_equals("no quote", sqlide::QuoteVar::escape_ansi_sql_string("plain text"), "plain text");
+  ensure_equals("empty", sqlide::QuoteVar::escape_ansi_sql_string(""), "");
+  ensure_equals("only quotes", sqlide::QuoteVar::escape_ansi_sql_string("''"), "''''");
+  ensure_equals("quotes at the ends", sqlide::QuoteVar::escape_ansi_sql_string("'a'"), "''a''");
+  ensure_equals("backslash kept", sqlide::QuoteVar::escape_ansi_sql_string("a\\'b"), "a\\''b");
+
+  std::string output = "prefix ";
+  sqlide::QuoteVar::append_escaped_ansi_sql_string(output, "it's", 4);
+  ensure_equals("append to existing buffer", output, "prefix it''s");
+}
+
+static std::vector<std::pair<sqlite::variant_t, std::string> > quote_samples() {
+  return {{sqlite::variant_t((std::int64_t)1234567890123LL), "1234567890123"},
+          {sqlite::variant_t(3.14159265358979L), "3.14159265358979"},
+          {sqlite::variant_t(std::string("The quick brown fox jumps over the lazy dog's back")),
+           "'The quick brown fox jumps over the lazy dog\\'s back'"},
+          {sqlite::variant_t(sqlite::blob_ref_t(new sqlite::blob_t(4, 0xA5))), "0xA5A5A5A5"}};
+}
+
+// Cell formatting paths used by grid rendering, copy and export, with a reused formatter.
+TEST_FUNCTION(5) {
+  sqlide::VarToStr var_to_str;
+  sqlide::QuoteVar qv;
+  qv.escape_string = std::bind(base::escape_sql_string, std::placeholders::_1, false);
+  qv.blob_to_string = std::bind(sqlide::QuoteVar::blob_to_hex_string, std::placeholders::_1, std::placeholders::_2);
+
+  std::vector<std::pair<sqlite::variant_t, std::string> > samples = quote_samples();
+
+  // Run each sample several times to make sure no state leaks from one value into the next.
+  for (int round = 0; round < 3; ++round) {
+    for (auto &sample : samples)
+      ensure_equals("quoted value", boost::apply_visitor(qv, sample.first, sample.first), sample.second);
+  }
+  ensure_equals("formatted int", boost::apply_visitor(var_to_str, samples[0].first), "1234567890123");
+}
+
+// Quoting throughput per value type, only run if BENCHMARK is set in the environment.
+TEST_FUNCTION(6) {
+  if (getenv("BENCHMARK") == nullptr)
+    return;
+
+  sqlide::QuoteVar qv;
+  qv.escape_string = std::bind(base::escape_sql_string, std::placeholders::_1, false);
+  qv.blob_to_string = std::bind(sqlide::QuoteVar::blob_to_hex_string, std::placeholders::_1, std::placeholders::_2);
+
+  const char *names[] = {"int", "double", "string", "blob"};
+  std::vector<std::pair<sqlite::variant_t, std::string> > samples = quote_samples();
+  const size_t count = 1000000;
+  for (size_t i = 0; i < samples.size(); ++i) {
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t n = 0; n < count; ++n)
+      bytes += boost::apply_visitor(qv, samples[i].first, samples[i].first).size();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Quoting " << names[i] << ": " << count / seconds / 1000000 << " M values/s, "
+              << bytes / seconds / (1024 * 1024) << " MB/s" << std::endl;
+    ensure_equals("output size", bytes, count * samples[i].second.size());
+  }
+}
+
+END_TESTS
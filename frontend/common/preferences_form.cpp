@@ -819,6 +819,12 @@ mforms::View *PreferencesForm::create_sqlide_page() {
                                  "Set to 0 to not send keep-alive messages."));
     entry->set_size(100, -1);
 
+    entry = otable->add_entry_option("DbSqlEditor:PrewarmedConnections",
+                                     _("Connections kept open in the background per server:"), "Prewarmed Connections",
+                                     _("Number of idle connections opened ahead of time for each server, so new SQL "
+                                       "editor tabs can connect without waiting. Set to 0 to disable."));
+    entry->set_size(100, -1);
+
     entry = otable->add_entry_option("DbSqlEditor:ReadTimeOut",
                                      _("DBMS connection read timeout interval (in seconds):"), "Connection Read Timeout",
                                      _("The maximum amount of time the query can take to return data from the DBMS."
@@ -374,6 +374,11 @@ public:
 
    */
   virtual grt::IntegerRef seek(const size_t offset);
+  /** Method. return the current size of the open file.
+   \return
+
+   */
+  virtual grt::IntegerRef size();
   /** Method. return the file's current position.
    \return
 
@@ -414,6 +419,10 @@ private:
     return dynamic_cast<db_mgmt_SSHFile*>(self)->seek(grt::IntegerRef::cast_from(args[0]));
   }
 
+  static grt::ValueRef call_size(grt::internal::Object *self, const grt::BaseListRef &args) {
+    return dynamic_cast<db_mgmt_SSHFile*>(self)->size();
+  }
+
   static grt::ValueRef call_tell(grt::internal::Object *self, const grt::BaseListRef &args) {
     return dynamic_cast<db_mgmt_SSHFile*>(self)->tell();
   }
@@ -428,6 +437,7 @@ public:
     meta->bind_method("read", &db_mgmt_SSHFile::call_read);
     meta->bind_method("readline", &db_mgmt_SSHFile::call_readline);
     meta->bind_method("seek", &db_mgmt_SSHFile::call_seek);
+    meta->bind_method("size", &db_mgmt_SSHFile::call_size);
     meta->bind_method("tell", &db_mgmt_SSHFile::call_tell);
   }
 };
@@ -89,6 +89,8 @@ namespace base {
 
   BASELIBRARY_PUBLIC_FUNC std::string escape_sql_string(const std::string &string,
                                                         bool wildcards = false); // "strings" or 'strings'
+  BASELIBRARY_PUBLIC_FUNC void append_escaped_sql_string(std::string &output, const char *data, size_t length,
+                                                         bool wildcards = false);
   BASELIBRARY_PUBLIC_FUNC std::string escape_json_string(const std::string &string);
   BASELIBRARY_PUBLIC_FUNC std::string unescape_sql_string(const std::string &string, char escape_char);
   BASELIBRARY_PUBLIC_FUNC std::string escape_backticks(const std::string &string); // `identifier`
@@ -32,6 +32,7 @@
 #include <math.h>
 #include <errno.h>
 #include <string.h>
+#include <cstdint>
 #include <fstream>
 #include <boost/locale/encoding_utf.hpp>
 
@@ -1163,6 +1164,91 @@ namespace base {
 
   //--------------------------------------------------------------------------------------------------
 
+  static inline char sql_escape_char(char ch, bool wildcards) {
+    switch (ch) {
+      case 0: /* Must be escaped for 'mysql' */
+        return '0';
+      case '\n': /* Must be escaped for logs */
+        return 'n';
+      case '\r':
+        return 'r';
+      case '\\':
+        return '\\';
+      case '\'':
+        return '\'';
+      case '"': /* Better safe than sorry */
+        return '"';
+      case '\032': /* This gives problems on Win32 */
+        return 'Z';
+      case '_':
+        return wildcards ? '_' : 0;
+      case '%':
+        return wildcards ? '%' : 0;
+    }
+    return 0;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  /**
+   * Tests 8 bytes at once for any of the characters handled by sql_escape_char (SWAR, i.e. SIMD within
+   * a register). Plain text rarely contains such characters, so most words can be copied unchanged.
+   */
+  static inline bool word_needs_sql_escape(std::uint64_t word, bool wildcards) {
+    static const std::uint64_t ones = 0x0101010101010101ULL;
+    static const std::uint64_t highs = 0x8080808080808080ULL;
+
+    auto has_byte = [](std::uint64_t w, std::uint64_t pattern) {
+      std::uint64_t v = w ^ pattern;
+      return ((v - ones) & ~v & highs) != 0;
+    };
+
+    if (has_byte(word, 0) || has_byte(word, ones * '\n') || has_byte(word, ones * '\r') ||
+        has_byte(word, ones * '\\') || has_byte(word, ones * '\'') || has_byte(word, ones * '"') ||
+        has_byte(word, ones * '\032'))
+      return true;
+    return wildcards && (has_byte(word, ones * '_') || has_byte(word, ones * '%'));
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  /**
+   * Escapes the given character range like escape_sql_string() does, but appends the result to the
+   * caller provided output string, so that buffers can be reused across many values.
+   * Unescaped runs are copied in one go instead of char by char.
+   */
+  void append_escaped_sql_string(std::string &output, const char *data, size_t length, bool wildcards) {
+    output.reserve(output.size() + length);
+
+    const char *run = data;
+    const char *p = data;
+    const char *end = data + length;
+    while (p < end) {
+      const char *stop = std::min(p + sizeof(std::uint64_t), end);
+      if (stop - p == sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        if (!word_needs_sql_escape(word, wildcards)) {
+          p = stop;
+          continue;
+        }
+      }
+
+      for (; p < stop; ++p) {
+        char escape = sql_escape_char(*p, wildcards);
+        if (escape) {
+          output.append(run, p - run);
+          output.push_back('\\');
+          output.push_back(escape);
+          run = p + 1;
+        }
+      }
+    }
+    output.append(run, end - run);
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
   /**
    * Escape a string to be used in a SQL query
    * Same code as used by mysql. Handles null bytes in the middle of the string.
@@ -1170,51 +1256,12 @@ namespace base {
    */
   std::string escape_sql_string(const std::string &s, bool wildcards) {
     std::string result;
-    result.reserve(s.size());
-
-    for (std::string::const_iterator ch = s.begin(); ch != s.end(); ++ch) {
-      char escape = 0;
-
-      switch (*ch) {
-        case 0: /* Must be escaped for 'mysql' */
-          escape = '0';
-          break;
-        case '\n': /* Must be escaped for logs */
-          escape = 'n';
-          break;
-        case '\r':
-          escape = 'r';
-          break;
-        case '\\':
-          escape = '\\';
-          break;
-        case '\'':
-          escape = '\'';
-          break;
-        case '"': /* Better safe than sorry */
-          escape = '"';
-          break;
-        case '\032': /* This gives problems on Win32 */
-          escape = 'Z';
-          break;
-        case '_':
-          if (wildcards)
-            escape = '_';
-          break;
-        case '%':
-          if (wildcards)
-            escape = '%';
-          break;
-      }
-      if (escape) {
-        result.push_back('\\');
-        result.push_back(escape);
-      } else
-        result.push_back(*ch);
-    }
+    append_escaped_sql_string(result, s.data(), s.size(), wildcards);
     return result;
   }
 
+  //--------------------------------------------------------------------------------------------------
+
   /**
    * Escape a string to be used in a JSON
    */
@@ -927,6 +927,30 @@ TEST_FUNCTION(43) {
   assure_false(italic);
 }
 
+TEST_FUNCTION(44) {
+  // Escape characters at every position of an 8 byte block, to cover the word-at-a-time fast path.
+  const char special[] = {'\0', '\n', '\r', '\\', '\'', '"', '\032'};
+  const char *escaped[] = {"\\0", "\\n", "\\r", "\\\\", "\\'", "\\\"", "\\Z"};
+  for (size_t i = 0; i < sizeof(special); ++i) {
+    for (size_t position = 0; position < 17; ++position) {
+      std::string input(17, 'x');
+      input[position] = special[i];
+      std::string expected = std::string(position, 'x') + escaped[i] + std::string(16 - position, 'x');
+      ensure_equals("TEST 44.1: Escape in block", base::escape_sql_string(input), expected);
+    }
+  }
+
+  ensure_equals("TEST 44.2: No escape needed", base::escape_sql_string("lorem ipsum dolor sit amet"),
+                "lorem ipsum dolor sit amet");
+  ensure_equals("TEST 44.3: Wildcards kept", base::escape_sql_string("100% of_all"), "100% of_all");
+  ensure_equals("TEST 44.4: Wildcards escaped", base::escape_sql_string("100% of_all", true), "100\\% of\\_all");
+  ensure_equals("TEST 44.5: Empty string", base::escape_sql_string(""), "");
+
+  std::string output = "prefix ";
+  base::append_escaped_sql_string(output, "it's", 4);
+  ensure_equals("TEST 44.6: Append to existing buffer", output, "prefix it\\'s");
+}
+
 TEST_FUNCTION(50) {
   std::string separator(1, G_DIR_SEPARATOR);
 
@@ -0,0 +1,643 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+
+#include "connection_pool.h"
+
+#include "base/log.h"
+#include "base/string_utilities.h"
+
+#include <cppconn/exception.h>
+#include <cppconn/statement.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+DEFAULT_LOG_DOMAIN("ConnectionPool")
+
+namespace sql {
+
+  struct ConnectionPool::Idle {
+    Connection *conn; // Owned, deleted by whoever takes it out of the pool.
+    std::shared_ptr<TunnelConnection> tunnel;
+    time_t since;
+  };
+
+  struct ConnectionPool::Server {
+    Server() : generation(0), open_ms(0), warm_failed(false) {
+    }
+
+    // Tells apart entries of the same key, as an entry is dropped when its last connection is released.
+    unsigned generation;
+
+    // Settings and credentials of the last connection opened by a caller, used to open connections in the background.
+    db_mgmt_ConnectionRef properties;
+    std::shared_ptr<TunnelConnection> tunnel;
+    Authentication::Ref auth;
+
+    std::deque<Idle> idle;
+    Stats stats;
+    double open_ms;
+    bool warm_failed;
+  };
+
+  struct ConnectionPool::State {
+    State()
+      : generations(0),
+        retired_open_ms(0),
+        warm_count(1),
+        max_idle(8),
+        keep_alive_interval(600),
+        idle_timeout(1800),
+        started(false),
+        stopping(false) {
+    }
+
+    Server &server(const std::string &key) {
+      std::map<std::string, Server>::iterator iter = servers.find(key);
+      if (iter == servers.end()) {
+        iter = servers.insert(std::make_pair(key, Server())).first;
+        iter->second.generation = ++generations;
+      }
+      return iter->second;
+    }
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::map<std::string, Server> servers;
+    std::deque<std::string> warm_requests;
+    unsigned generations;
+
+    // Metrics of the entries dropped so far, still part of the totals.
+    Stats retired;
+    double retired_open_ms;
+
+    size_t warm_count;
+    size_t max_idle;
+    int keep_alive_interval;
+    int idle_timeout;
+    bool started;
+    bool stopping;
+  };
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  static void close_connection(Connection *conn) {
+    try {
+      delete conn;
+    } catch (std::exception &exc) {
+      logDebug("Error closing pooled connection: %s\n", exc.what());
+    }
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  /**
+   * Brings a returned connection back to a fresh session state. Anything that can't be undone here (user variables,
+   * temporary tables) is left to the owner, which should close the connection instead of returning it.
+   */
+  static bool reset_session(Connection *conn) {
+    try {
+      if (conn->isClosed())
+        return false;
+
+      conn->rollback();
+      if (!conn->getAutoCommit())
+        conn->setAutoCommit(true);
+
+      std::unique_ptr<Statement> statement(conn->createStatement());
+      statement->execute("UNLOCK TABLES");
+      return true;
+    } catch (std::exception &exc) {
+      logDebug("Could not reset pooled connection: %s\n", exc.what());
+      return false;
+    }
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  /**
+   * Deleter of the handed out connections, which puts them back into the pool.
+   */
+  class ConnectionPool::Returner {
+  public:
+    Returner(const std::weak_ptr<State> &state, const std::string &key, std::shared_ptr<TunnelConnection> tunnel,
+             bool reusable)
+      : _state(state), _key(key), _tunnel(tunnel), _reusable(reusable) {
+    }
+
+    void operator()(Connection *conn) {
+      std::shared_ptr<State> state = _state.lock();
+      bool reusable = _reusable && state && reset_session(conn);
+      std::vector<Connection *> closing(1, conn);
+
+      if (state) {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        std::map<std::string, Server>::iterator server = state->servers.find(_key);
+        if (server != state->servers.end()) {
+          if (server->second.stats.in_use > 0)
+            --server->second.stats.in_use;
+
+          if (server->second.stats.in_use == 0) {
+            // Nobody uses this server anymore. Forget its credentials and don't keep connections open for it.
+            ++server->second.stats.dropped;
+            for (std::deque<Idle>::iterator idle = server->second.idle.begin(); idle != server->second.idle.end();
+                 ++idle)
+              closing.push_back(idle->conn);
+            server->second.stats.dropped += server->second.idle.size();
+            server->second.idle.clear();
+            server->second.stats.warming = 0; // Accounted for in warm(), once they are done.
+            state->retired.add(server->second.stats);
+            state->retired_open_ms += server->second.open_ms;
+            state->servers.erase(server);
+            state->warm_requests.erase(std::remove(state->warm_requests.begin(), state->warm_requests.end(), _key),
+                                       state->warm_requests.end());
+          } else if (reusable && !state->stopping && server->second.idle.size() < state->max_idle) {
+            Idle idle = {conn, _tunnel, time(NULL)};
+            server->second.idle.push_back(idle);
+            ++server->second.stats.returned;
+            return;
+          } else
+            ++server->second.stats.dropped;
+        }
+      }
+
+      for (std::vector<Connection *>::iterator iter = closing.begin(); iter != closing.end(); ++iter)
+        close_connection(*iter);
+    }
+
+  private:
+    std::weak_ptr<State> _state;
+    std::string _key;
+    std::shared_ptr<TunnelConnection> _tunnel;
+    bool _reusable;
+  };
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  ConnectionPool::Stats::Stats()
+    : idle(0), in_use(0), warming(0), opened(0), reused(0), returned(0), dropped(0), pings(0), avg_open_ms(0) {
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::Stats::add(const Stats &other) {
+    idle += other.idle;
+    in_use += other.in_use;
+    warming += other.warming;
+    opened += other.opened;
+    reused += other.reused;
+    returned += other.returned;
+    dropped += other.dropped;
+    pings += other.pings;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  ConnectionPool::ConnectionPool(DriverManager *manager) : _manager(manager), _state(new State()) {
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  ConnectionPool::~ConnectionPool() {
+    shutdown();
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  std::string ConnectionPool::pool_key(const db_mgmt_ConnectionRef &connectionProperties) {
+    std::string key;
+
+    if (connectionProperties->driver().is_valid())
+      key.append(*connectionProperties->driver()->name());
+    key.append("|").append(*connectionProperties->hostIdentifier()).append("|");
+
+    grt::DictRef parameters = connectionProperties->parameterValues();
+    for (grt::DictRef::const_iterator iter = parameters.begin(); iter != parameters.end(); ++iter) {
+      if (iter->first == "password" || base::hasPrefix(iter->first, "DbSqlEditor:"))
+        continue;
+      key.append(iter->first).append("=").append(iter->second.toString()).append(";");
+    }
+
+    return key;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  ConnectionWrapper ConnectionPool::acquire(const db_mgmt_ConnectionRef &connectionProperties,
+                                            std::shared_ptr<TunnelConnection> tunnel, Authentication::Ref password,
+                                            DriverManager::ConnectionInitSlot connection_init_slot, bool reusable) {
+    std::string key = pool_key(connectionProperties);
+
+    for (;;) {
+      Idle idle;
+      {
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        Server &server = _state->server(key);
+        if (server.idle.empty())
+          break;
+        idle = server.idle.back();
+        server.idle.pop_back();
+        ++server.stats.in_use;
+      }
+
+      try {
+        // One round trip, to catch connections that died since the last keep alive pass.
+        if (idle.conn->isValid()) {
+          _manager->prepareConnection(idle.conn, connectionProperties, connection_init_slot);
+          {
+            std::lock_guard<std::mutex> lock(_state->mutex);
+            ++_state->server(key).stats.reused;
+          }
+          schedule_warm(key);
+          return wrap(std::unique_ptr<Connection>(idle.conn), key, idle.tunnel, reusable);
+        }
+      } catch (std::exception &exc) {
+        logDebug("Pooled connection could not be reused: %s\n", exc.what());
+      }
+
+      close_connection(idle.conn);
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      Server &server = _state->server(key);
+      --server.stats.in_use;
+      ++server.stats.dropped;
+    }
+
+    std::string used_password;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::unique_ptr<Connection> conn(
+      _manager->connect(connectionProperties, tunnel, password, connection_init_slot, &used_password));
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    {
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      Server &server = _state->server(key);
+      server.properties = connectionProperties;
+      server.tunnel = tunnel;
+      server.auth = Authentication::create(connectionProperties);
+      server.auth->set_password(used_password.c_str());
+      server.warm_failed = false;
+      server.open_ms += ms;
+      ++server.stats.opened;
+      ++server.stats.in_use;
+    }
+    std::fill(used_password.begin(), used_password.end(), 0);
+
+    schedule_warm(key);
+    return wrap(std::move(conn), key, tunnel, reusable);
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  ConnectionWrapper ConnectionPool::wrap(std::unique_ptr<Connection> conn, const std::string &key,
+                                         std::shared_ptr<TunnelConnection> tunnel, bool reusable) {
+    return ConnectionWrapper(ConnectionPtr(conn.release(), Returner(_state, key, tunnel, reusable)), tunnel);
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::schedule_warm(const std::string &key) {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    if (_state->stopping || _state->warm_count == 0)
+      return;
+
+    if (std::find(_state->warm_requests.begin(), _state->warm_requests.end(), key) == _state->warm_requests.end())
+      _state->warm_requests.push_back(key);
+
+    if (!_state->started) {
+      _state->started = true;
+      _thread = std::thread(&ConnectionPool::run, this);
+    }
+    _state->wakeup.notify_one();
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::warm(const std::string &key) {
+    for (;;) {
+      db_mgmt_ConnectionRef properties;
+      std::shared_ptr<TunnelConnection> tunnel;
+      Authentication::Ref auth;
+      unsigned generation;
+      {
+        // Only servers somebody is connected to are kept warm.
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        std::map<std::string, Server>::iterator server = _state->servers.find(key);
+        if (_state->stopping || server == _state->servers.end() || server->second.stats.in_use == 0 ||
+            server->second.warm_failed || !server->second.auth || !server->second.auth->is_valid() ||
+            server->second.idle.size() + server->second.stats.warming >= _state->warm_count)
+          return;
+
+        properties = server->second.properties;
+        tunnel = server->second.tunnel;
+        auth = server->second.auth;
+        generation = server->second.generation;
+        ++server->second.stats.warming;
+      }
+
+      std::unique_ptr<Connection> conn;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      try {
+        conn = _manager->connect(properties, tunnel, auth, DriverManager::ConnectionInitSlot(), NULL);
+      } catch (std::exception &exc) {
+        logWarning("Could not open a connection in the background for %s: %s\n", properties->name().c_str(),
+                   exc.what());
+        std::lock_guard<std::mutex> lock(_state->mutex);
+        std::map<std::string, Server>::iterator server = _state->servers.find(key);
+        if (server != _state->servers.end() && server->second.generation == generation) {
+          --server->second.stats.warming;
+          server->second.warm_failed = true; // Until the next successful connection by a caller.
+        }
+        return;
+      }
+      double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+      std::unique_lock<std::mutex> lock(_state->mutex);
+      std::map<std::string, Server>::iterator server = _state->servers.find(key);
+      if (server == _state->servers.end() || server->second.generation != generation) {
+        // The last user disconnected meanwhile.
+        ++_state->retired.opened;
+        ++_state->retired.dropped;
+        _state->retired_open_ms += ms;
+        lock.unlock();
+        close_connection(conn.release());
+        return;
+      }
+      --server->second.stats.warming;
+      ++server->second.stats.opened;
+      server->second.open_ms += ms;
+      if (_state->stopping || server->second.stats.in_use == 0) {
+        ++server->second.stats.dropped;
+        lock.unlock();
+        close_connection(conn.release());
+        return;
+      }
+      Idle idle = {conn.release(), tunnel, time(NULL)};
+      server->second.idle.push_back(idle);
+    }
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::keep_alive() {
+    std::vector<std::pair<std::string, Idle> > batch;
+    int idle_timeout;
+    {
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      idle_timeout = _state->idle_timeout;
+      for (std::map<std::string, Server>::iterator server = _state->servers.begin(); server != _state->servers.end();
+           ++server) {
+        for (std::deque<Idle>::iterator idle = server->second.idle.begin(); idle != server->second.idle.end(); ++idle)
+          batch.push_back(std::make_pair(server->first, *idle));
+        server->second.idle.clear();
+      }
+    }
+
+    // Connections are taken out of the pool while they are pinged, so nobody has to wait for that.
+    time_t now = time(NULL);
+    std::vector<bool> alive(batch.size(), false);
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (idle_timeout > 0 && now - batch[i].second.since > idle_timeout)
+        continue;
+      try {
+        alive[i] = batch[i].second.conn->isValid();
+      } catch (std::exception &exc) {
+        logDebug("Keep alive ping failed: %s\n", exc.what());
+      }
+    }
+
+    std::vector<Connection *> dropped;
+    std::vector<std::string> refill;
+    {
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      // Put them back in front of the connections returned meanwhile, to keep the most recent ones at the back.
+      for (size_t i = batch.size(); i-- > 0;) {
+        // The entry is gone if its last user disconnected while the connection was pinged.
+        std::map<std::string, Server>::iterator server = _state->servers.find(batch[i].first);
+        Stats &stats = server != _state->servers.end() ? server->second.stats : _state->retired;
+        ++stats.pings;
+        if (alive[i] && !_state->stopping && server != _state->servers.end())
+          server->second.idle.push_front(batch[i].second);
+        else {
+          ++stats.dropped;
+          dropped.push_back(batch[i].second.conn);
+        }
+      }
+
+      for (std::map<std::string, Server>::iterator server = _state->servers.begin(); server != _state->servers.end();
+           ++server) {
+        if (server->second.stats.in_use > 0 && server->second.idle.size() < _state->warm_count)
+          refill.push_back(server->first);
+      }
+    }
+
+    for (std::vector<Connection *>::iterator conn = dropped.begin(); conn != dropped.end(); ++conn)
+      close_connection(*conn);
+    for (std::vector<std::string>::iterator key = refill.begin(); key != refill.end(); ++key)
+      schedule_warm(*key);
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::run() {
+    std::unique_lock<std::mutex> lock(_state->mutex);
+    std::chrono::steady_clock::time_point next_ping =
+      std::chrono::steady_clock::now() + std::chrono::seconds(_state->keep_alive_interval);
+
+    while (!_state->stopping) {
+      if (!_state->warm_requests.empty()) {
+        std::string key = _state->warm_requests.front();
+        _state->warm_requests.pop_front();
+        lock.unlock();
+        warm(key);
+        lock.lock();
+        continue;
+      }
+
+      if (_state->keep_alive_interval > 0 && std::chrono::steady_clock::now() >= next_ping) {
+        lock.unlock();
+        keep_alive();
+        lock.lock();
+        next_ping = std::chrono::steady_clock::now() + std::chrono::seconds(_state->keep_alive_interval);
+        continue;
+      }
+
+      if (_state->keep_alive_interval > 0)
+        _state->wakeup.wait_until(lock, next_ping);
+      else
+        _state->wakeup.wait(lock);
+    }
+    lock.unlock();
+
+    // Free the thread specific data of the drivers used by this thread.
+    _manager->thread_cleanup();
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::set_warm_count(size_t count) {
+    std::vector<std::string> keys;
+    {
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      _state->warm_count = count;
+      for (std::map<std::string, Server>::iterator server = _state->servers.begin(); server != _state->servers.end();
+           ++server)
+        keys.push_back(server->first);
+    }
+    for (std::vector<std::string>::iterator key = keys.begin(); key != keys.end(); ++key)
+      schedule_warm(*key);
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  size_t ConnectionPool::warm_count() const {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    return _state->warm_count;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::set_max_idle(size_t count) {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    _state->max_idle = count;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  size_t ConnectionPool::max_idle() const {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    return _state->max_idle;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::set_keep_alive_interval(int seconds) {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    _state->keep_alive_interval = seconds;
+    _state->wakeup.notify_one();
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  int ConnectionPool::keep_alive_interval() const {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    return _state->keep_alive_interval;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::set_idle_timeout(int seconds) {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    _state->idle_timeout = seconds;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  int ConnectionPool::idle_timeout() const {
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    return _state->idle_timeout;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::clear(const std::string &key) {
+    std::vector<Connection *> closing;
+    {
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      for (std::map<std::string, Server>::iterator server = _state->servers.begin(); server != _state->servers.end();
+           ++server) {
+        if (!key.empty() && server->first != key)
+          continue;
+        for (std::deque<Idle>::iterator idle = server->second.idle.begin(); idle != server->second.idle.end(); ++idle)
+          closing.push_back(idle->conn);
+        server->second.stats.dropped += server->second.idle.size();
+        server->second.idle.clear();
+        server->second.auth.reset();
+        server->second.tunnel.reset();
+      }
+    }
+
+    for (std::vector<Connection *>::iterator conn = closing.begin(); conn != closing.end(); ++conn)
+      close_connection(*conn);
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  ConnectionPool::Stats ConnectionPool::stats(const std::string &key) const {
+    Stats result;
+    double open_ms = 0;
+
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    if (key.empty()) {
+      result.add(_state->retired);
+      open_ms = _state->retired_open_ms;
+    }
+    for (std::map<std::string, Server>::const_iterator server = _state->servers.begin();
+         server != _state->servers.end(); ++server) {
+      if (!key.empty() && server->first != key)
+        continue;
+
+      const Stats &stats(server->second.stats);
+      result.idle += server->second.idle.size();
+      result.in_use += stats.in_use;
+      result.warming += stats.warming;
+      result.opened += stats.opened;
+      result.reused += stats.reused;
+      result.returned += stats.returned;
+      result.dropped += stats.dropped;
+      result.pings += stats.pings;
+      open_ms += server->second.open_ms;
+    }
+    if (result.opened > 0)
+      result.avg_open_ms = open_ms / result.opened;
+
+    return result;
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::log_stats() const {
+    Stats s = stats();
+    logInfo("Connection pool: %i idle, %i in use, %i opened (avg %.1f ms), %i reused, %i returned, %i dropped, "
+            "%i pings\n",
+            (int)s.idle, (int)s.in_use, (int)s.opened, s.avg_open_ms, (int)s.reused, (int)s.returned, (int)s.dropped,
+            (int)s.pings);
+  }
+
+  //--------------------------------------------------------------------------------------------------------------------
+
+  void ConnectionPool::shutdown() {
+    {
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      _state->stopping = true;
+      _state->warm_requests.clear();
+      _state->wakeup.notify_all();
+    }
+    if (_thread.joinable())
+      _thread.join();
+
+    clear();
+  }
+
+} // namespace sql
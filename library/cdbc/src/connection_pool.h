@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+
+#ifndef _CONNECTION_POOL_H_
+#define _CONNECTION_POOL_H_
+
+#include "cppdbc_public_interface.h"
+#include "driver_manager.h"
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sql {
+
+  /**
+   * Pool of open connections, shared by everything that connects to the same server with the same account.
+   *
+   * acquire() hands out an idle connection if there is one, otherwise a new one is opened. A reusable connection goes
+   * back to the pool once the last copy of the returned ConnectionWrapper is gone. Before that, it is reset to a clean
+   * session (open transaction rolled back, table locks released, autocommit on). Sessions that can't be reset that
+   * way (e.g. ones that run arbitrary user SQL) must be acquired as not reusable, they are closed when released.
+   * Connections that were closed by their user are dropped as well.
+   *
+   * While connections to a server are in use, a background thread keeps warm_count() idle connections open for it,
+   * so later requests skip the TLS, auth and tunnel handshakes. It also pings all idle connections in a single pass
+   * every keep_alive_interval() seconds and closes those that are dead or have been idle for longer than
+   * idle_timeout(). Once the last connection to a server is released, its idle connections are closed and the
+   * credentials and tunnel kept for warming are dropped.
+   */
+  class CPPDBC_PUBLIC_FUNC ConnectionPool {
+  public:
+    struct CPPDBC_PUBLIC_FUNC Stats {
+      Stats();
+
+      size_t idle;         // Connections waiting in the pool.
+      size_t in_use;       // Connections handed out and not yet returned.
+      size_t warming;      // Connections being opened in the background.
+      size_t opened;       // Connections opened so far.
+      size_t reused;       // Requests served from an idle connection.
+      size_t returned;     // Connections that went back to the pool.
+      size_t dropped;      // Connections closed by the pool (not reusable, failed reset or ping, idle timeout, over
+                           // limit, last user gone).
+      size_t pings;        // Keep alive pings sent to idle connections.
+      double avg_open_ms;  // Average time it took to open a connection.
+
+      void add(const Stats &other);
+    };
+
+    ConnectionPool(DriverManager *manager);
+    ~ConnectionPool();
+
+    // Identifies the server and account of a connection, ignoring the password and editor settings.
+    static std::string pool_key(const db_mgmt_ConnectionRef &connectionProperties);
+
+    // A connection which isn't reusable may come from the pool, but is closed instead of returned when released.
+    ConnectionWrapper acquire(const db_mgmt_ConnectionRef &connectionProperties,
+                              std::shared_ptr<TunnelConnection> tunnel, Authentication::Ref password,
+                              DriverManager::ConnectionInitSlot connection_init_slot =
+                                DriverManager::ConnectionInitSlot(),
+                              bool reusable = true);
+
+    // Number of idle connections kept open per server, 0 disables warming.
+    void set_warm_count(size_t count);
+    size_t warm_count() const;
+
+    // Idle connections beyond this are closed when they come back.
+    void set_max_idle(size_t count);
+    size_t max_idle() const;
+
+    void set_keep_alive_interval(int seconds);
+    int keep_alive_interval() const;
+
+    void set_idle_timeout(int seconds);
+    int idle_timeout() const;
+
+    // Pings all idle connections, drops the dead and expired ones and refills the pool to warm_count().
+    // Called periodically by the pool thread.
+    void keep_alive();
+
+    // Closes the idle connections of a server (all servers if the key is empty) and forgets its credentials.
+    void clear(const std::string &key = "");
+
+    // Metrics of one server in use, or the sum over all servers (including the ones no longer used) if the key is
+    // empty.
+    Stats stats(const std::string &key = "") const;
+    void log_stats() const;
+
+    // Stops the pool thread and closes all idle connections. Connections still in use are closed when released.
+    void shutdown();
+
+  private:
+    struct Idle;
+    struct Server;
+    struct State;
+    class Returner;
+
+    DriverManager *_manager;
+    std::shared_ptr<State> _state;
+    std::thread _thread;
+
+    ConnectionWrapper wrap(std::unique_ptr<Connection> conn, const std::string &key,
+                           std::shared_ptr<TunnelConnection> tunnel, bool reusable);
+    void schedule_warm(const std::string &key);
+    void warm(const std::string &key);
+    void run();
+  };
+
+} // namespace sql
+
+#endif // _CONNECTION_POOL_H_
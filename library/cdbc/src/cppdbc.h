@@ -24,8 +24,11 @@
 #ifndef _CPPDBC_H_
 #define _CPPDBC_H_
 
+#include "connection_pool.h"
 #include "driver_manager.h"
 #include "sql_batch_exec.h"
+#include "sql_parallel_dump.h"
+#include "sql_parallel_restore.h"
 
 #include <cppconn/connection.h>
 #include <cppconn/driver.h>
@@ -22,6 +22,7 @@
  */
 
 #include "driver_manager.h"
+#include "connection_pool.h"
 
 #include "mysql_driver.h"
 #include "cppconn/driver.h"
@@ -135,7 +136,32 @@ namespace sql {
     return dm;
   }
 
-  DriverManager::DriverManager() : _driver_path("."), _cacheTime(0) {
+  DriverManager::DriverManager() : _driver_path("."), _cacheTime(0), _connectorVersion(0) {
+    _pool = new ConnectionPool(this);
+
+    TransferProfile profile;
+    profile.name = "default";
+    setTransferProfile(profile);
+
+    profile.name = "compressed";
+    profile.compression = "zlib";
+    setTransferProfile(profile);
+
+    profile.name = "zstd";
+    profile.compression = "zstd";
+    profile.zstdLevel = 3;
+    setTransferProfile(profile);
+
+    // For large results over slow links: compress, move data in big packets and don't hold the full result in memory.
+    profile.name = "bulk";
+    profile.netBufferLength = 1024 * 1024;
+    profile.maxAllowedPacket = 1024 * 1024 * 1024;
+    profile.streamResults = true;
+    setTransferProfile(profile);
+  }
+
+  ConnectionPool *DriverManager::getConnectionPool() {
+    return _pool;
   }
 
   void DriverManager::setTunnelFactoryFunction(TunnelFactoryFunction function) {
@@ -201,6 +227,7 @@ namespace sql {
     _versionInfo = "C++ " + std::to_string(driver->getMajorVersion()) + ".";
     _versionInfo += std::to_string(driver->getMinorVersion()) + ".";
     _versionInfo += std::to_string(driver->getPatchVersion());
+    _connectorVersion = driver->getMajorVersion() * 10000 + driver->getMinorVersion() * 100 + driver->getPatchVersion();
   }
 
   //--------------------------------------------------------------------------------------------------
@@ -211,9 +238,111 @@ namespace sql {
 
   //--------------------------------------------------------------------------------------------------
 
+  void DriverManager::setTransferProfile(const TransferProfile &profile) {
+    std::lock_guard<std::mutex> lock(_profileMutex);
+    _transferProfiles[profile.name] = profile;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  TransferProfile DriverManager::getTransferProfile(const std::string &name) const {
+    std::lock_guard<std::mutex> lock(_profileMutex);
+    std::map<std::string, TransferProfile>::const_iterator iter = _transferProfiles.find(name);
+    if (iter != _transferProfiles.end())
+      return iter->second;
+
+    TransferProfile profile;
+    profile.name = "default";
+    return profile;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  TransferProfile DriverManager::getTransferProfile(const db_mgmt_ConnectionRef &connectionProperties) const {
+    return getTransferProfile(connectionProperties->parameterValues().get_string("transferProfile", "default"));
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  std::vector<std::string> DriverManager::getTransferProfileNames() const {
+    std::lock_guard<std::mutex> lock(_profileMutex);
+    std::vector<std::string> names;
+    for (auto &iter : _transferProfiles)
+      names.push_back(iter.first);
+    return names;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  /**
+   * Translates a transfer profile into connector options. Sizes set explicitly as driver parameters are kept,
+   * compression is enabled if either the profile or the CLIENT_COMPRESS parameter asks for it.
+   */
+  void DriverManager::applyTransferProfile(const TransferProfile &profile, int connectorVersion,
+                                           ConnectOptionsMap &properties) {
+    if (!profile.compression.empty()) {
+      properties["CLIENT_COMPRESS"] = true;
+
+      // The algorithm options are only known to Connector/C++ 8.0.18 and newer. The connector is released together
+      // with and built on the client library of the same version, which is also where zstd support starts.
+      // Older connectors always use zlib.
+      if (connectorVersion >= 80018) {
+        // zlib stays in the list so servers without zstd still get a compressed connection.
+        properties["OPT_COMPRESSION_ALGORITHMS"] =
+          std::string(profile.compression == "zstd" ? "zstd,zlib" : profile.compression.c_str());
+        if (profile.compression == "zstd" && profile.zstdLevel > 0)
+          properties["OPT_ZSTD_COMPRESSION_LEVEL"] = profile.zstdLevel;
+      }
+    }
+
+    if (profile.netBufferLength > 0 && properties.find("OPT_NET_BUFFER_LENGTH") == properties.end())
+      properties["OPT_NET_BUFFER_LENGTH"] = profile.netBufferLength;
+    if (profile.maxAllowedPacket > 0 && properties.find("OPT_MAX_ALLOWED_PACKET") == properties.end())
+      properties["OPT_MAX_ALLOWED_PACKET"] = profile.maxAllowedPacket;
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
   ConnectionWrapper DriverManager::getConnection(const db_mgmt_ConnectionRef &connectionProperties,
                                                  std::shared_ptr<TunnelConnection> tunnel, Authentication::Ref password,
                                                  ConnectionInitSlot connection_init_slot) {
+    return ConnectionWrapper(connect(connectionProperties, tunnel, password, connection_init_slot, NULL), tunnel);
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  void DriverManager::prepareConnection(Connection *conn, const db_mgmt_ConnectionRef &connectionProperties,
+                                        ConnectionInitSlot connection_init_slot) {
+    grt::DictRef parameter_values = connectionProperties->parameterValues();
+
+    std::string sql_mode = parameter_values.get_string("SQL_MODE", "");
+    if (!sql_mode.empty()) {
+      std::unique_ptr<sql::Statement> statement(conn->createStatement());
+      statement->execute("SET SESSION SQL_MODE='" + sql_mode + "'");
+    }
+
+    if (connection_init_slot)
+      connection_init_slot(conn, connectionProperties);
+
+    //  We could set this on the parameters, but we wouldn't know the server version
+    if( conn->getMetaData()->getDatabaseMajorVersion() >= 8 ) {
+      conn->createStatement()->executeUpdate("set character_set_client = utf8mb4");
+      conn->createStatement()->executeUpdate("set character_set_connection = utf8mb4");
+      conn->createStatement()->executeUpdate("set character_set_results = utf8mb4");
+    }
+
+    std::string def_schema = parameter_values.get_string("schema", "");
+    if (!def_schema.empty())
+      conn->setSchema(def_schema);
+  }
+
+  //--------------------------------------------------------------------------------------------------
+
+  std::unique_ptr<Connection> DriverManager::connect(const db_mgmt_ConnectionRef &connectionProperties,
+                                                     std::shared_ptr<TunnelConnection> tunnel,
+                                                     Authentication::Ref password,
+                                                     ConnectionInitSlot connection_init_slot,
+                                                     std::string *used_password) {
     grt::DictRef parameter_values = connectionProperties->parameterValues();
     if (parameter_values.get_string("userName").empty())
       throw SQLException("No user name set for this connection");
@@ -302,6 +431,8 @@ namespace sql {
       if (properties.find("OPT_READ_TIMEOUT") == properties.end())
         properties["OPT_READ_TIMEOUT"] = read_timeout;
     }
+    applyTransferProfile(getTransferProfile(connectionProperties), _connectorVersion, properties);
+
     properties["OPT_CAN_HANDLE_EXPIRED_PASSWORDS"] = true;
     properties["CLIENT_MULTI_STATEMENTS"] = true;
     properties["metadataUseInfoSchema"] =
@@ -453,27 +584,17 @@ namespace sql {
         }
       }
 
-      std::string sql_mode = parameter_values.get_string("SQL_MODE", "");
-      if (!sql_mode.empty()) {
-        std::unique_ptr<sql::Statement> statement(conn.get()->createStatement());
-        statement->execute("SET SESSION SQL_MODE='" + sql_mode + "'");
-      }
-
-      if (connection_init_slot)
-        connection_init_slot(conn.get(), connectionProperties);
+      prepareConnection(conn.get(), connectionProperties, connection_init_slot);
 
-      //  We could set this on the parameters, but we wouldn't know the server version
-      if( conn->getMetaData()->getDatabaseMajorVersion() >= 8 ) {
-        conn.get()->createStatement()->executeUpdate("set character_set_client = utf8mb4");
-        conn.get()->createStatement()->executeUpdate("set character_set_connection = utf8mb4");
-        conn.get()->createStatement()->executeUpdate("set character_set_results = utf8mb4");
+      if (used_password != NULL) {
+        ConnectOptionsMap::iterator prop_iter = properties.find("password");
+        if (prop_iter != properties.end() && prop_iter->second.get<sql::SQLString>() != NULL)
+          *used_password = prop_iter->second.get<sql::SQLString>()->asStdString();
+        else
+          used_password->clear();
       }
-      
-      std::string def_schema = parameter_values.get_string("schema", "");
-      if (!def_schema.empty())
-        conn->setSchema(def_schema);
 
-      return ConnectionWrapper(std::move(conn), tunnel);
+      return conn;
     } catch (sql::SQLException &exc) {
       // authentication error
       if (exc.getErrorCode() == 1045 || exc.getErrorCode() == 1044 ||
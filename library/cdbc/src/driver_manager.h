@@ -28,6 +28,7 @@
 
 #include <cppconn/driver.h>
 #include <memory>
+#include <mutex>
 #include <set>
 
 #include "grts/structs.db.mgmt.h"
@@ -128,6 +129,21 @@ namespace sql {
     }
   };
 
+  class ConnectionPool;
+
+  // Network settings applied when a connection is opened, selected by the "transferProfile" connection parameter.
+  struct TransferProfile {
+    std::string name;
+    std::string compression; // Empty for none, "zlib" or "zstd". zstd falls back to zlib on connectors before 8.0.18.
+    int zstdLevel;           // 0 keeps the library default, same for the sizes below.
+    int netBufferLength;
+    int maxAllowedPacket;
+    bool streamResults; // Rows are read from the network as they are fetched instead of buffering the whole result.
+
+    TransferProfile() : zstdLevel(0), netBufferLength(0), maxAllowedPacket(0), streamResults(false) {
+    }
+  };
+
   class CPPDBC_PUBLIC_FUNC DriverManager {
     std::string _driver_path;
 
@@ -155,6 +171,13 @@ namespace sql {
                                     std::shared_ptr<TunnelConnection> tunnel, Authentication::Ref password,
                                     ConnectionInitSlot connection_init_slot = ConnectionInitSlot());
 
+    // Runs the per session setup (SQL_MODE, init slot, character set, default schema) on an open connection.
+    void prepareConnection(Connection *conn, const db_mgmt_ConnectionRef &connectionProperties,
+                           ConnectionInitSlot connection_init_slot);
+
+    // Returns the pool of connections shared between all users of the same server.
+    ConnectionPool *getConnectionPool();
+
     void thread_cleanup();
 
     std::shared_ptr<TunnelConnection> getTunnel(const db_mgmt_ConnectionRef &connectionProperties);
@@ -180,9 +203,28 @@ namespace sql {
 
     const std::string &getClientLibVersion() const;
 
+    // Adds a transfer profile or replaces the one with the same name.
+    void setTransferProfile(const TransferProfile &profile);
+    // Returns the named profile or the default one, which leaves all settings to the driver, if there's none.
+    TransferProfile getTransferProfile(const std::string &name) const;
+    TransferProfile getTransferProfile(const db_mgmt_ConnectionRef &connectionProperties) const;
+    std::vector<std::string> getTransferProfileNames() const;
+
+    // Adds the connector options for the given profile. connectorVersion is the Connector/C++ version
+    // as major * 10000 + minor * 100 + patch.
+    static void applyTransferProfile(const TransferProfile &profile, int connectorVersion,
+                                     ConnectOptionsMap &properties);
+
   private:
+    friend class ConnectionPool;
+
     void getClientLibVersion(Driver *driver);
 
+    // Opens a new connection. The password that was finally used is returned in used_password, if given.
+    std::unique_ptr<Connection> connect(const db_mgmt_ConnectionRef &connectionProperties,
+                                        std::shared_ptr<TunnelConnection> tunnel, Authentication::Ref password,
+                                        ConnectionInitSlot connection_init_slot, std::string *used_password);
+
     TunnelFactoryFunction _createTunnel;
     PasswordFindFunction _findPassword;
     PasswordRequestFunction _requestPassword;
@@ -191,6 +233,11 @@ namespace sql {
     std::string _cacheKey;
     time_t _cacheTime;
     std::string _versionInfo;
+    int _connectorVersion; // Connector/C++ version, major * 10000 + minor * 100 + patch
+    ConnectionPool *_pool;
+
+    mutable std::mutex _profileMutex;
+    std::map<std::string, TransferProfile> _transferProfiles;
   };
 
   class Dbc_connection_handler {
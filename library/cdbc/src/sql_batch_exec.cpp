@@ -25,6 +25,10 @@
 #include <cppconn/exception.h>
 #include <cppconn/resultset.h>
 #include <memory>
+#include <iterator>
+#include <algorithm>
+#include <string.h>
+#include <ctype.h>
 
 namespace sql {
 
@@ -33,7 +37,8 @@ namespace sql {
       _batch_exec_err_count(0),
       _batch_exec_progress_state(0),
       _batch_exec_progress_inc(0),
-      _stop_on_error(true) {
+      _stop_on_error(true),
+      _batch_size_limit(0) {
   }
 
   long SqlBatchExec::operator()(sql::Statement *stmt, std::list<std::string> &statements) {
@@ -54,34 +59,161 @@ namespace sql {
     return _batch_exec_err_count;
   }
 
+  /**
+   * Only plain DML produces exactly one result per statement, which is needed to map errors in a multi-statement
+   * packet back to the statement that caused them.
+   */
+  bool SqlBatchExec::is_batchable_statement(const std::string &statement) {
+    std::string::size_type start = statement.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos)
+      return false;
+
+    static const char *keywords[] = {"INSERT", "UPDATE", "DELETE", "REPLACE"};
+    for (const char *keyword : keywords) {
+      size_t length = strlen(keyword);
+      if (statement.size() <= start + length || isalnum((unsigned char)statement[start + length]) ||
+          statement[start + length] == '_')
+        continue;
+      if (std::equal(keyword, keyword + length, statement.begin() + start,
+                     [](char a, char b) { return a == toupper((unsigned char)b); }))
+        return statement.find(';') == std::string::npos; // Embedded separators would break result counting.
+    }
+    return false;
+  }
+
+  size_t SqlBatchExec::max_allowed_packet(sql::Connection *connection) {
+    std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+    std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery("SELECT @@max_allowed_packet"));
+    if (rs->next())
+      return (size_t)rs->getUInt64(1);
+    return 0;
+  }
+
   void SqlBatchExec::exec_sql_script(sql::Statement *stmt, std::list<std::string> &statements,
                                      long &batch_exec_err_count) {
     _batch_exec_progress_state = 0;
     _batch_exec_progress_inc = 1.f / statements.size();
 
-    for (std::list<std::string>::const_iterator i = statements.begin(), i_end = statements.end(); i != i_end; ++i) {
+    std::list<std::string>::const_iterator i = statements.begin(), i_end = statements.end();
+    while (i != i_end) {
+      // Collect as many consecutive DML statements as fit into one packet.
+      std::list<std::string>::const_iterator batch_end = i;
+      size_t batch_size = 0;
+      if (_batch_size_limit > 0) {
+        while (batch_end != i_end && is_batchable_statement(*batch_end) &&
+               (batch_end == i || batch_size + batch_end->size() + 1 <= _batch_size_limit)) {
+          batch_size += batch_end->size() + 1;
+          ++batch_end;
+        }
+      }
+
+      if (std::distance(i, batch_end) > 1) {
+        exec_batch(stmt, i, batch_end, batch_exec_err_count);
+        i = batch_end;
+      } else
+        exec_statement(stmt, *i++, batch_exec_err_count);
+
+      if (batch_exec_err_count && _stop_on_error)
+        break;
+    }
+  }
+
+  void SqlBatchExec::exec_statement(sql::Statement *stmt, const std::string &statement, long &batch_exec_err_count) {
+    try {
+      _sql_log.push_back(statement);
+      if (stmt->execute(statement))
+        std::auto_ptr<sql::ResultSet> rs(stmt->getResultSet());
+      ++_batch_exec_success_count;
+    } catch (SQLException &e) {
+      if (!exec_split_statement(stmt, statement, batch_exec_err_count))
+        report_error(e, statement, batch_exec_err_count);
+    }
+    step_progress();
+  }
+
+  /**
+   * Executes the parts of a failed merged statement one by one. A failing statement changes nothing on transactional
+   * tables, so every part is applied once and errors are reported with the text of the part that caused them.
+   * Returns false if the statement was not built from other statements.
+   */
+  bool SqlBatchExec::exec_split_statement(sql::Statement *stmt, const std::string &statement,
+                                          long &batch_exec_err_count) {
+    std::list<std::string> parts;
+    if (!_split_cb || !_split_cb(statement, parts) || parts.empty())
+      return false;
+
+    for (const std::string &part : parts) {
       try {
-        _sql_log.push_back(*i);
-        if (stmt->execute(*i))
+        _sql_log.push_back(part);
+        if (stmt->execute(part))
           std::auto_ptr<sql::ResultSet> rs(stmt->getResultSet());
         ++_batch_exec_success_count;
       } catch (SQLException &e) {
-        ++batch_exec_err_count;
-        if (!_error_cb)
-          throw;
-        else {
-          if (&_batch_exec_err_count != &batch_exec_err_count) // applies only to failback scripts
-            _error_cb(-1, "Error when running failback script. Details follow.", "");
-          _error_cb(e.getErrorCode(), e.what(), *i);
+        report_error(e, part, batch_exec_err_count);
+        if (_stop_on_error)
+          break;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Sends all statements in the given range as one multi-statement packet. The server stops at the first failing
+   * statement, so on error the remaining statements are executed again in a new packet (unless stop on error is set).
+   */
+  void SqlBatchExec::exec_batch(sql::Statement *stmt, std::list<std::string>::const_iterator begin,
+                                std::list<std::string>::const_iterator end, long &batch_exec_err_count) {
+    while (begin != end) {
+      std::string packet;
+      for (std::list<std::string>::const_iterator i = begin; i != end; ++i) {
+        if (!packet.empty())
+          packet.append(";\n");
+        packet.append(*i);
+      }
+
+      std::list<std::string>::const_iterator current = begin;
+      try {
+        // Each statement in the packet yields exactly one result. Errors surface when their result is reached.
+        _sql_log.push_back(*current);
+        if (stmt->execute(packet))
+          std::auto_ptr<sql::ResultSet> rs(stmt->getResultSet());
+        ++_batch_exec_success_count;
+        step_progress();
+
+        while (++current != end) {
+          _sql_log.push_back(*current);
+          if (stmt->getMoreResults())
+            std::auto_ptr<sql::ResultSet> rs(stmt->getResultSet());
+          ++_batch_exec_success_count;
+          step_progress();
         }
+        begin = end;
+      } catch (SQLException &e) {
+        if (!exec_split_statement(stmt, *current, batch_exec_err_count))
+          report_error(e, *current, batch_exec_err_count);
+        step_progress();
+        if (_stop_on_error && batch_exec_err_count)
+          return;
+        begin = ++current;
       }
-      _batch_exec_progress_state += _batch_exec_progress_inc;
-      if (_batch_exec_progress_cb)
-        _batch_exec_progress_cb(_batch_exec_progress_state);
+    }
+  }
 
-      if (batch_exec_err_count && _stop_on_error)
-        break;
+  void SqlBatchExec::report_error(SQLException &e, const std::string &statement, long &batch_exec_err_count) {
+    ++batch_exec_err_count;
+    if (!_error_cb)
+      throw;
+    else {
+      if (&_batch_exec_err_count != &batch_exec_err_count) // applies only to failback scripts
+        _error_cb(-1, "Error when running failback script. Details follow.", "");
+      _error_cb(e.getErrorCode(), e.what(), statement);
     }
   }
 
+  void SqlBatchExec::step_progress() {
+    _batch_exec_progress_state += _batch_exec_progress_inc;
+    if (_batch_exec_progress_cb)
+      _batch_exec_progress_cb(_batch_exec_progress_state);
+  }
+
 } // namespace sql
@@ -27,6 +27,7 @@
 #include "cppdbc_public_interface.h"
 #include <cppconn/statement.h>
 #include <cppconn/connection.h>
+#include <cppconn/exception.h>
 #include <list>
 #include <string>
 #include <functional>
@@ -42,6 +43,12 @@ namespace sql {
 
   private:
     void exec_sql_script(sql::Statement *stmt, std::list<std::string> &statements, long &batch_exec_err_count);
+    void exec_statement(sql::Statement *stmt, const std::string &statement, long &batch_exec_err_count);
+    void exec_batch(sql::Statement *stmt, std::list<std::string>::const_iterator begin,
+                    std::list<std::string>::const_iterator end, long &batch_exec_err_count);
+    void report_error(SQLException &e, const std::string &statement, long &batch_exec_err_count);
+    bool exec_split_statement(sql::Statement *stmt, const std::string &statement, long &batch_exec_err_count);
+    void step_progress();
 
   public:
     typedef std::function<int(long long, const std::string &, const std::string &)> Error_cb;
@@ -79,6 +86,35 @@ namespace sql {
   private:
     bool _stop_on_error;
 
+  public:
+    // Maximum size (in bytes) of a multi-statement packet. Consecutive DML statements are sent together up to that
+    // size, which saves a network round trip per statement. 0 (the default) executes statements one by one.
+    // The connection must have been opened with CLIENT_MULTI_STATEMENTS.
+    void batch_size_limit(size_t value) {
+      _batch_size_limit = value;
+    }
+    size_t batch_size_limit() const {
+      return _batch_size_limit;
+    }
+
+    static bool is_batchable_statement(const std::string &statement);
+    static size_t max_allowed_packet(sql::Connection *connection);
+
+  private:
+    size_t _batch_size_limit;
+
+  public:
+    // Returns the statements a merged statement was built from (e.g. the single row INSERTs of a multi-row INSERT).
+    // When such a statement fails its parts are executed one by one, so errors are reported for the statement that
+    // caused them instead of the merged text.
+    typedef std::function<bool(const std::string &, std::list<std::string> &)> Split_cb;
+    void split_cb(const Split_cb &cb) {
+      _split_cb = cb;
+    }
+
+  private:
+    Split_cb _split_cb;
+
   public:
     void failback_statements(const std::list<std::string> &value) {
       _failback_statements = value;
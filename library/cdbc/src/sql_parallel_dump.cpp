@@ -0,0 +1,1037 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "sql_parallel_dump.h"
+
+#include "base/file_utilities.h"
+#include "base/jsonparser.h"
+#include "base/log.h"
+#include "base/sqlstring.h"
+#include "base/string_utilities.h"
+
+#include <cppconn/driver.h>
+#include <cppconn/exception.h>
+#include <cppconn/resultset.h>
+#include <cppconn/resultset_metadata.h>
+#include <cppconn/statement.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+DEFAULT_LOG_DOMAIN("ParallelDump")
+
+using namespace JsonParser;
+
+namespace {
+
+  /**
+   * Writes a single gzip member to a file, compressing the data as it is passed in.
+   */
+  class GzipFile {
+  public:
+    GzipFile(const std::string &path, int level) : _file(path, "wb"), _buffer(64 * 1024) {
+      memset(&_stream, 0, sizeof(_stream));
+      // 16 added to the window bits selects the gzip format instead of a raw zlib stream.
+      if (deflateInit2(&_stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::runtime_error("Could not initialize compression for " + path);
+    }
+
+    ~GzipFile() {
+      deflateEnd(&_stream);
+    }
+
+    void write(const std::string &data) {
+      compress(data.data(), data.size(), Z_NO_FLUSH);
+    }
+
+    void close() {
+      compress(nullptr, 0, Z_FINISH);
+      if (fflush(_file.file()) != 0)
+        throw std::runtime_error("Error writing to " + _file.getPath());
+    }
+
+  private:
+    void compress(const char *data, size_t length, int flush) {
+      _stream.next_in = (Bytef *)data;
+      _stream.avail_in = (uInt)length;
+      do {
+        _stream.next_out = _buffer.data();
+        _stream.avail_out = (uInt)_buffer.size();
+        if (deflate(&_stream, flush) == Z_STREAM_ERROR)
+          throw std::runtime_error("Compression error writing " + _file.getPath());
+
+        size_t produced = _buffer.size() - _stream.avail_out;
+        if (produced > 0 && fwrite(_buffer.data(), 1, produced, _file.file()) != produced)
+          throw std::runtime_error("Error writing to " + _file.getPath());
+      } while (_stream.avail_out == 0);
+    }
+
+    base::FileHandle _file;
+    z_stream _stream;
+    std::vector<unsigned char> _buffer;
+  };
+
+  //------------------------------------------------------------------------------------------------
+
+  void write_file(const std::string &path, const std::string &content) {
+    base::FileHandle file(path, "wb");
+    if (fwrite(content.data(), 1, content.size(), file.file()) != content.size() || fflush(file.file()) != 0)
+      throw std::runtime_error("Error writing to " + path);
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  std::string encode_name(const std::string &name) {
+    std::string result;
+    for (unsigned char c : name) {
+      if (isalnum(c) || c == '_' || c == '-' || c >= 0x80)
+        result.push_back((char)c);
+      else
+        result.append(base::strfmt("%%%02X", c));
+    }
+    return result;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  bool is_integer_type(const std::string &type) {
+    return type == "tinyint" || type == "smallint" || type == "mediumint" || type == "int" || type == "integer" ||
+           type == "bigint";
+  }
+
+
+  //------------------------------------------------------------------------------------------------
+
+  std::string script_header(const std::string &charset) {
+    return "-- MySQL Workbench parallel dump\n"
+           "/*!40101 SET NAMES " +
+           charset +
+           " */;\n"
+           "/*!40103 SET TIME_ZONE='+00:00' */;\n"
+           "/*!40014 SET UNIQUE_CHECKS=0, FOREIGN_KEY_CHECKS=0 */;\n"
+           "/*!40101 SET SQL_MODE='NO_AUTO_VALUE_ON_ZERO' */;\n\n";
+  }
+
+} // namespace
+
+namespace sql {
+
+  struct ParallelDump::Column {
+    enum Kind { Numeric, Binary, Text };
+
+    std::string name;
+    Kind kind;
+  };
+
+  struct ParallelDump::Chunk {
+    Chunk() : rows(0), bytes(0) {
+    }
+
+    std::string where;
+    std::string file;
+    unsigned long long rows;
+    unsigned long long bytes; // Uncompressed size.
+  };
+
+  struct ParallelDump::Table {
+    std::string schema;
+    std::string name;
+    bool is_view;
+    double weight; // Estimated row count, used for scheduling and progress.
+    std::string file;
+    std::vector<Column> columns;
+    std::string primary_key;
+    bool unsigned_key;
+    std::vector<Chunk> chunks;
+    size_t pending_chunks;
+  };
+
+  struct ParallelDump::Schema {
+    std::string name;
+    std::vector<std::string> requested_tables;
+    std::string file;
+    std::string routines_file;
+    std::vector<std::unique_ptr<Table> > tables;
+  };
+
+  struct ParallelDump::Job {
+    enum Kind { DumpSchema, DumpTable, DumpChunk };
+
+    Kind kind;
+    Schema *schema;
+    Table *table;
+    size_t chunk;
+  };
+
+  //------------------------------------------------------------------------------------------------
+
+  ParallelDump::Options::Options()
+    : chunk_rows(250000),
+      insert_size(1024 * 1024),
+      compression_level(6),
+      consistent(true),
+      dump_structure(true),
+      dump_data(true),
+      dump_triggers(false),
+      dump_routines(false),
+      dump_events(false) {
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  ParallelDump::ParallelDump(const std::vector<ConnectionWrapper> &connections, const Options &options)
+    : _connections(connections),
+      _options(options),
+      _charset("utf8"),
+      _snapshot_consistent(false),
+      _busy_workers(0),
+      _total_weight(0),
+      _done_weight(0),
+      _tables_total(0),
+      _tables_done(0),
+      _rows_done(0),
+      _error_count(0),
+      _cancelled(false) {
+    if (_connections.empty())
+      throw std::invalid_argument("ParallelDump needs at least one connection");
+    if (_options.chunk_rows == 0)
+      _options.chunk_rows = 1;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  ParallelDump::~ParallelDump() {
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelDump::add_schema(const std::string &schema, const std::vector<std::string> &tables) {
+    std::unique_ptr<Schema> entry(new Schema());
+    entry->name = schema;
+    entry->requested_tables = tables;
+    _schemas.push_back(std::move(entry));
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  /**
+   * File name used for a schema script (no table given), a table script (no chunk given) or a data chunk,
+   * relative to the output folder. Names are encoded so that they are valid on all platforms and cannot clash.
+   */
+  std::string ParallelDump::file_name(const std::string &schema, const std::string &table, int chunk) {
+    std::string name = encode_name(schema);
+    if (!table.empty())
+      name += "@" + encode_name(table);
+    if (chunk >= 0)
+      return name + base::strfmt("@%i.sql.gz", chunk);
+    return name + ".sql";
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  std::string ParallelDump::program_script(const std::string &ddl, const ProgramSettings &settings) {
+    std::string script;
+    std::string restore;
+    if (!settings.character_set_client.empty()) {
+      script +=
+        "/*!50003 SET @saved_cs_client      = @@character_set_client */ ;\n"
+        "/*!50003 SET @saved_cs_results     = @@character_set_results */ ;\n"
+        "/*!50003 SET @saved_col_connection = @@collation_connection */ ;\n"
+        "/*!50003 SET character_set_client  = " +
+        settings.character_set_client + " */ ;\n" + "/*!50003 SET character_set_results = " +
+        settings.character_set_client + " */ ;\n";
+      if (!settings.collation_connection.empty())
+        script += "/*!50003 SET collation_connection  = " + settings.collation_connection + " */ ;\n";
+      restore =
+        "/*!50003 SET character_set_client  = @saved_cs_client */ ;\n"
+        "/*!50003 SET character_set_results = @saved_cs_results */ ;\n"
+        "/*!50003 SET collation_connection  = @saved_col_connection */ ;\n";
+    }
+    if (!settings.time_zone.empty()) {
+      script += "/*!50106 SET @saved_time_zone      = @@time_zone */ ;\n"
+                "/*!50106 SET time_zone             = " +
+                std::string(base::sqlstring("?", 0) << settings.time_zone) + " */ ;\n";
+      restore += "/*!50106 SET time_zone             = @saved_time_zone */ ;\n";
+    }
+    script += "/*!50003 SET @saved_sql_mode       = @@sql_mode */ ;\n"
+              "/*!50003 SET sql_mode              = " +
+              std::string(base::sqlstring("?", 0) << settings.sql_mode) + " */ ;\n";
+    restore = "/*!50003 SET sql_mode              = @saved_sql_mode */ ;\n" + restore;
+
+    return script + "DELIMITER ;;\n" + ddl + " ;;\nDELIMITER ;\n" + restore + "\n";
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  /**
+   * Maps a key value to an unsigned number with the same ordering, so that signed and unsigned
+   * keys can share the range arithmetic.
+   */
+  unsigned long long ParallelDump::key_to_offset(const std::string &value, bool is_unsigned) {
+    if (is_unsigned)
+      return strtoull(value.c_str(), nullptr, 10);
+    return (unsigned long long)strtoll(value.c_str(), nullptr, 10) ^ (1ULL << 63);
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  std::string ParallelDump::offset_to_key(unsigned long long offset, bool is_unsigned) {
+    if (is_unsigned)
+      return std::to_string(offset);
+    return std::to_string((long long)(offset ^ (1ULL << 63)));
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  /**
+   * Splits the key range from min to max (both included) into at most chunk_count ranges of about the same size.
+   * Returns the first key of every range but the first one, so no bounds at all mean a single chunk.
+   */
+  std::vector<std::string> ParallelDump::chunk_bounds(const std::string &min, const std::string &max, bool is_unsigned,
+                                                      unsigned long long chunk_count) {
+    std::vector<std::string> bounds;
+    if (chunk_count < 2)
+      return bounds;
+
+    unsigned long long low = key_to_offset(min, is_unsigned);
+    unsigned long long span = key_to_offset(max, is_unsigned) - low;
+    if (span < chunk_count)
+      chunk_count = span + 1;
+    unsigned long long step = span / chunk_count + 1;
+    for (unsigned long long i = 1; i < chunk_count && i * step <= span; ++i)
+      bounds.push_back(offset_to_key(low + i * step, is_unsigned));
+    return bounds;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  /**
+   * Returns the WHERE condition of each chunk for the given bounds of the (quoted) key column. The chunks cover
+   * the key space without gaps. The first and last are open ended, as the bounds are taken from the MIN/MAX
+   * of the key and only serve to balance the chunks. A single chunk has no condition.
+   */
+  std::vector<std::string> ParallelDump::chunk_conditions(const std::string &key,
+                                                          const std::vector<std::string> &bounds) {
+    std::vector<std::string> conditions(bounds.size() + 1);
+    if (bounds.empty())
+      return conditions;
+
+    conditions.front() = key + " < " + bounds.front();
+    for (size_t i = 1; i < bounds.size(); ++i)
+      conditions[i] = key + " >= " + bounds[i - 1] + " AND " + key + " < " + bounds[i];
+    conditions.back() = key + " >= " + bounds.back();
+    return conditions;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  int ParallelDump::run() {
+    base::create_directory(_options.output_dir, 0700, true);
+
+    log("Starting snapshot on " + std::to_string(_connections.size()) + " connection(s)");
+    if (!begin_snapshot() || !list_tables())
+      return _error_count;
+
+    // Schema scripts first, then the largest tables, so that big tables are split up while there is
+    // still other work around to keep every connection busy.
+    std::vector<Job> jobs;
+    std::vector<Table *> tables;
+    for (auto &schema : _schemas) {
+      if (_options.dump_structure || _options.dump_routines || _options.dump_events)
+        jobs.push_back({Job::DumpSchema, schema.get(), nullptr, 0});
+      for (auto &table : schema->tables)
+        tables.push_back(table.get());
+    }
+    std::stable_sort(tables.begin(), tables.end(), [](Table *a, Table *b) { return a->weight > b->weight; });
+    for (Table *table : tables)
+      jobs.push_back({Job::DumpTable, nullptr, table, 0});
+    push_jobs(jobs);
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < _connections.size(); ++i)
+      workers.push_back(std::thread(&ParallelDump::work, this, i));
+    for (std::thread &worker : workers)
+      worker.join();
+
+    if (_cancelled) {
+      log("Dump cancelled");
+      return _error_count;
+    }
+
+    try {
+      write_manifest();
+    } catch (std::exception &e) {
+      report_error(std::string("Could not write the dump manifest: ") + e.what());
+    }
+    log(status_text());
+
+    return _error_count;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelDump::cancel() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _cancelled = true;
+    }
+    _job_available.notify_all();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  float ParallelDump::progress() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_total_weight <= 0)
+      return 0;
+    return (float)std::min(1.0, _done_weight / _total_weight);
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  std::string ParallelDump::status_text() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return base::strfmt("%i of %i tables exported, %llu rows", (int)_tables_done, (int)_tables_total, _rows_done);
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  int ParallelDump::error_count() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _error_count;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  /**
+   * Starts a transaction with a consistent snapshot on every connection. The global read lock taken
+   * meanwhile makes sure no write slips in between the individual START TRANSACTION calls, so all sessions
+   * see the same data. If the account may not lock, the dump goes on with independent snapshots.
+   */
+  bool ParallelDump::begin_snapshot() {
+    std::unique_ptr<sql::Statement> coordinator(_connections[0]->createStatement());
+    bool locked = false;
+
+    if (_options.consistent) {
+      try {
+        coordinator->execute("FLUSH TABLES WITH READ LOCK");
+        locked = true;
+      } catch (sql::SQLException &e) {
+        log(std::string("WARNING: Could not lock tables for a consistent snapshot, connections may see different "
+                        "data: ") +
+            e.what());
+      }
+    }
+
+    try {
+      for (auto &connection : _connections) {
+        std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+        try {
+          stmt->execute("SET NAMES utf8mb4");
+          _charset = "utf8mb4";
+        } catch (sql::SQLException &) {
+          // Servers older than 5.5.3.
+          stmt->execute("SET NAMES utf8");
+          _charset = "utf8";
+        }
+        stmt->execute("SET SESSION time_zone = '+00:00'");
+        stmt->execute("SET SESSION TRANSACTION ISOLATION LEVEL REPEATABLE READ");
+        stmt->execute("START TRANSACTION /*!40108 WITH CONSISTENT SNAPSHOT */");
+      }
+
+      if (locked) {
+        try {
+          std::unique_ptr<sql::ResultSet> rs(coordinator->executeQuery("SHOW MASTER STATUS"));
+          if (rs->next()) {
+            _binlog_file = rs->getString(1);
+            _binlog_position = rs->getString(2);
+            if (rs->getMetaData()->getColumnCount() >= 5)
+              _gtid_executed = rs->getString(5);
+          }
+        } catch (sql::SQLException &e) {
+          logWarning("Could not read the binary log position: %s\n", e.what());
+        }
+        coordinator->execute("UNLOCK TABLES");
+      }
+
+      std::unique_ptr<sql::ResultSet> rs(coordinator->executeQuery("SELECT VERSION()"));
+      if (rs->next())
+        _server_version = rs->getString(1);
+    } catch (sql::SQLException &e) {
+      report_error(std::string("Could not start the dump transaction: ") + e.what());
+      if (locked) {
+        try {
+          coordinator->execute("UNLOCK TABLES");
+        } catch (sql::SQLException &) {
+        }
+      }
+      return false;
+    }
+
+    _snapshot_consistent = locked || _connections.size() == 1;
+    return true;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  bool ParallelDump::list_tables() {
+    try {
+      std::unique_ptr<sql::Statement> stmt(_connections[0]->createStatement());
+      for (auto &schema : _schemas) {
+        schema->file = file_name(schema->name);
+
+        std::map<std::string, std::pair<bool, double> > existing;
+        std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(
+          std::string(base::sqlstring("SELECT TABLE_NAME, TABLE_TYPE, TABLE_ROWS FROM information_schema.TABLES "
+                                      "WHERE TABLE_SCHEMA = ?",
+                                      0)
+                      << schema->name)));
+        while (rs->next()) {
+          std::string type = rs->getString(2);
+          existing[rs->getString(1)] =
+            std::make_pair(type == "VIEW" || type == "SYSTEM VIEW", rs->isNull(3) ? 0.0 : (double)rs->getUInt64(3));
+        }
+
+        for (const std::string &name : schema->requested_tables) {
+          auto entry = existing.find(name);
+          if (entry == existing.end()) {
+            report_error("Table `" + schema->name + "`.`" + name + "` does not exist");
+            continue;
+          }
+
+          std::unique_ptr<Table> table(new Table());
+          table->schema = schema->name;
+          table->name = name;
+          table->is_view = entry->second.first;
+          table->weight = table->is_view ? 1.0 : entry->second.second + 1.0;
+          table->unsigned_key = false;
+          table->pending_chunks = 0;
+          _total_weight += table->weight;
+          schema->tables.push_back(std::move(table));
+        }
+        _total_weight += 1.0;
+        _tables_total += schema->tables.size();
+      }
+    } catch (sql::SQLException &e) {
+      report_error(std::string("Could not list the tables to dump: ") + e.what());
+      return false;
+    }
+    return true;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelDump::work(size_t connection_index) {
+    sql::Connection *connection = _connections[connection_index].get();
+    sql::Driver *driver = connection->getDriver();
+    driver->threadInit();
+
+    for (;;) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        // Running jobs may still queue data chunks, so only stop once nobody is busy anymore.
+        _job_available.wait(lock, [this]() { return _cancelled || !_jobs.empty() || _busy_workers == 0; });
+        if (_cancelled || _jobs.empty())
+          break;
+        job = _jobs.front();
+        _jobs.pop_front();
+        ++_busy_workers;
+      }
+
+      run_job(connection, job);
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        --_busy_workers;
+      }
+      _job_available.notify_all();
+    }
+
+    try {
+      std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+      stmt->execute("ROLLBACK");
+    } catch (sql::SQLException &) {
+    }
+    driver->threadEnd();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelDump::run_job(sql::Connection *connection, const Job &job) {
+    switch (job.kind) {
+      case Job::DumpSchema:
+        try {
+          dump_schema(connection, *job.schema);
+        } catch (std::exception &e) {
+          report_error("Error dumping schema `" + job.schema->name + "`: " + e.what());
+        }
+        add_done_weight(1.0);
+        break;
+
+      case Job::DumpTable: {
+        Table &table = *job.table;
+        bool chunked = false;
+        try {
+          if (_options.dump_structure)
+            dump_table_structure(connection, table);
+          if (!table.is_view && _options.dump_data && !_cancelled) {
+            plan_chunks(connection, table);
+            chunked = true;
+          }
+        } catch (std::exception &e) {
+          report_error("Error dumping `" + table.schema + "`.`" + table.name + "`: " + e.what());
+        }
+
+        if (!chunked) {
+          add_done_weight(table.weight);
+          std::lock_guard<std::mutex> lock(_mutex);
+          ++_tables_done;
+        }
+        break;
+      }
+
+      case Job::DumpChunk: {
+        Table &table = *job.table;
+        try {
+          dump_chunk(connection, table, job.chunk);
+        } catch (std::exception &e) {
+          report_error(base::strfmt("Error dumping `%s`.`%s` (chunk %i): %s", table.schema.c_str(),
+                                    table.name.c_str(), (int)job.chunk, e.what()));
+        }
+
+        add_done_weight(table.weight / table.chunks.size());
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--table.pending_chunks == 0)
+          ++_tables_done;
+        break;
+      }
+    }
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  /**
+   * Writes the schema script (CREATE DATABASE) and, if requested, a separate script with the routines and
+   * events of the schema, which must only be restored after all tables.
+   */
+  void ParallelDump::dump_schema(sql::Connection *connection, Schema &schema) {
+    std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+
+    if (_options.dump_structure) {
+      std::unique_ptr<sql::ResultSet> rs(
+        stmt->executeQuery(std::string(base::sqlstring("SHOW CREATE DATABASE !", 0) << schema.name)));
+      if (rs->next()) {
+        std::string ddl = base::replaceString(rs->getString(2), "CREATE DATABASE ",
+                                              "CREATE DATABASE /*!32312 IF NOT EXISTS*/ ");
+        write_file(base::makePath(_options.output_dir, schema.file), script_header(_charset) + ddl + ";\n");
+      }
+    }
+
+    if (!_options.dump_routines && !_options.dump_events)
+      return;
+
+    std::string script = script_header(_charset);
+    if (_options.dump_routines) {
+      std::vector<std::pair<std::string, std::string> > routines;
+      {
+        std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(std::string(
+          base::sqlstring("SELECT ROUTINE_NAME, ROUTINE_TYPE FROM information_schema.ROUTINES WHERE ROUTINE_SCHEMA = ?",
+                          0)
+          << schema.name)));
+        while (rs->next())
+          routines.push_back(std::make_pair(rs->getString(1), rs->getString(2)));
+      }
+      for (auto &routine : routines) {
+        std::string ddl;
+        ProgramSettings settings;
+        {
+          std::string query = "SHOW CREATE " + routine.second + " !.!";
+          std::unique_ptr<sql::ResultSet> rs(
+            stmt->executeQuery(std::string(base::sqlstring(query.c_str(), 0) << schema.name << routine.first)));
+          if (rs->next() && !rs->isNull(3)) {
+            ddl = rs->getString(3);
+            settings.sql_mode = rs->getString(2);
+            settings.character_set_client = rs->getString(4);
+            settings.collation_connection = rs->getString(5);
+          }
+        }
+        if (ddl.empty()) {
+          report_error("No permission to read the definition of " + base::tolower(routine.second) + " `" +
+                       schema.name + "`.`" + routine.first + "`");
+          continue;
+        }
+        script += "DROP " + routine.second + " IF EXISTS " + base::quote_identifier(routine.first, '`') + ";\n" +
+                  program_script(ddl, settings);
+      }
+    }
+
+    if (_options.dump_events) {
+      std::vector<std::string> events;
+      {
+        std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(std::string(
+          base::sqlstring("SELECT EVENT_NAME FROM information_schema.EVENTS WHERE EVENT_SCHEMA = ?", 0)
+          << schema.name)));
+        while (rs->next())
+          events.push_back(rs->getString(1));
+      }
+      for (auto &event : events) {
+        std::unique_ptr<sql::ResultSet> rs(
+          stmt->executeQuery(std::string(base::sqlstring("SHOW CREATE EVENT !.!", 0) << schema.name << event)));
+        if (rs->next()) {
+          ProgramSettings settings;
+          settings.sql_mode = rs->getString(2);
+          settings.time_zone = rs->getString(3);
+          settings.character_set_client = rs->getString(5);
+          settings.collation_connection = rs->getString(6);
+          script += "DROP EVENT IF EXISTS " + base::quote_identifier(event, '`') + ";\n" +
+                    program_script(rs->getString(4), settings);
+        }
+      }
+    }
+
+    schema.routines_file = encode_name(schema.name) + ".routines.sql";
+    write_file(base::makePath(_options.output_dir, schema.routines_file), script);
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelDump::dump_table_structure(sql::Connection *connection, Table &table) {
+    std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+    std::string script = script_header(_charset);
+    std::string name = base::quote_identifier(table.name, '`');
+
+    {
+      std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(
+        std::string(base::sqlstring(table.is_view ? "SHOW CREATE VIEW !.!" : "SHOW CREATE TABLE !.!", 0)
+                    << table.schema << table.name)));
+      if (!rs->next())
+        throw std::runtime_error("no definition returned by the server");
+      script += std::string(table.is_view ? "DROP VIEW IF EXISTS " : "DROP TABLE IF EXISTS ") + name + ";\n" +
+                std::string(rs->getString(2)) + ";\n\n";
+    }
+
+    if (!table.is_view && _options.dump_triggers) {
+      std::vector<std::string> triggers;
+      {
+        std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(
+          std::string(base::sqlstring("SELECT TRIGGER_NAME FROM information_schema.TRIGGERS "
+                                      "WHERE EVENT_OBJECT_SCHEMA = ? AND EVENT_OBJECT_TABLE = ? ORDER BY ACTION_ORDER",
+                                      0)
+                      << table.schema << table.name)));
+        while (rs->next())
+          triggers.push_back(rs->getString(1));
+      }
+      for (auto &trigger : triggers) {
+        std::unique_ptr<sql::ResultSet> rs(
+          stmt->executeQuery(std::string(base::sqlstring("SHOW CREATE TRIGGER !.!", 0) << table.schema << trigger)));
+        if (rs->next()) {
+          ProgramSettings settings;
+          settings.sql_mode = rs->getString(2);
+          settings.character_set_client = rs->getString(4);
+          settings.collation_connection = rs->getString(5);
+          script += program_script(rs->getString(3), settings);
+        }
+      }
+    }
+
+    table.file = file_name(table.schema, table.name);
+    write_file(base::makePath(_options.output_dir, table.file), script);
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  /**
+   * Looks up the columns of the table and splits its data into ranges of the primary key, if it consists
+   * of a single integer column. Queues one job per resulting chunk.
+   */
+  void ParallelDump::plan_chunks(sql::Connection *connection, Table &table) {
+    std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+
+    std::vector<std::string> key_columns;
+    std::string key_type;
+    {
+      std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(std::string(
+        base::sqlstring("SELECT COLUMN_NAME, DATA_TYPE, COLUMN_TYPE, COLUMN_KEY, EXTRA FROM information_schema.COLUMNS "
+                        "WHERE TABLE_SCHEMA = ? AND TABLE_NAME = ? ORDER BY ORDINAL_POSITION",
+                        0)
+        << table.schema << table.name)));
+      while (rs->next()) {
+        std::string type = base::tolower(rs->getString(2));
+        std::string column_type = base::tolower(rs->getString(3));
+        if (std::string(rs->getString(4)) == "PRI") {
+          key_columns.push_back(rs->getString(1));
+          key_type = type;
+          table.unsigned_key = column_type.find("unsigned") != std::string::npos;
+        }
+
+        // Generated columns cannot be inserted into.
+        std::string extra = base::toupper(rs->getString(5));
+        if (extra.find("VIRTUAL GENERATED") != std::string::npos || extra.find("STORED GENERATED") != std::string::npos)
+          continue;
+
+        Column column;
+        column.name = rs->getString(1);
+        if (is_integer_type(type) || type == "decimal" || type == "float" || type == "double" || type == "year")
+          column.kind = Column::Numeric;
+        else if (type.find("binary") != std::string::npos || type.find("blob") != std::string::npos ||
+                 type == "bit" || type == "geometry" || type == "point" || type == "linestring" ||
+                 type == "polygon" || type == "multipoint" || type == "multilinestring" || type == "multipolygon" ||
+                 type == "geometrycollection" || type == "geomcollection")
+          column.kind = Column::Binary;
+        else
+          column.kind = Column::Text;
+        table.columns.push_back(column);
+      }
+    }
+    if (table.columns.empty())
+      throw std::runtime_error("no columns to dump");
+
+    std::vector<std::string> bounds;
+    unsigned long long chunk_count = (unsigned long long)std::ceil(table.weight / _options.chunk_rows);
+    if (key_columns.size() == 1 && is_integer_type(key_type) && chunk_count > 1) {
+      table.primary_key = key_columns[0];
+
+      std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(std::string(
+        base::sqlstring("SELECT MIN(!), MAX(!) FROM !.!", 0) << table.primary_key << table.primary_key << table.schema
+                                                              << table.name)));
+      if (rs->next() && !rs->isNull(1))
+        bounds = chunk_bounds(rs->getString(1), rs->getString(2), table.unsigned_key, chunk_count);
+    }
+
+    std::vector<std::string> conditions = chunk_conditions(base::quote_identifier(table.primary_key, '`'), bounds);
+    table.chunks.resize(conditions.size());
+    for (size_t i = 0; i < table.chunks.size(); ++i) {
+      table.chunks[i].where = conditions[i];
+      table.chunks[i].file = file_name(table.schema, table.name, (int)i);
+    }
+    table.pending_chunks = table.chunks.size();
+
+    std::vector<Job> jobs;
+    for (size_t i = 0; i < table.chunks.size(); ++i)
+      jobs.push_back({Job::DumpChunk, nullptr, &table, i});
+    push_jobs(jobs);
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelDump::dump_chunk(sql::Connection *connection, Table &table, size_t index) {
+    Chunk &chunk = table.chunks[index];
+
+    std::string columns;
+    std::string select;
+    for (const Column &column : table.columns) {
+      std::string name = base::quote_identifier(column.name, '`');
+      if (!columns.empty()) {
+        columns += ",";
+        select += ",";
+      }
+      columns += name;
+      select += column.kind == Column::Binary ? "HEX(" + name + ")" : name;
+    }
+    select = "SELECT " + select + " FROM " + base::quote_identifier(table.schema, '`') + "." +
+             base::quote_identifier(table.name, '`');
+    if (!chunk.where.empty())
+      select += " WHERE " + chunk.where;
+
+    GzipFile file(base::makePath(_options.output_dir, chunk.file), _options.compression_level);
+    std::string header = script_header(_charset);
+    file.write(header);
+    chunk.bytes += header.size();
+
+    std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+    // Stream the rows instead of buffering the whole chunk on the client.
+    stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+    std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery(select));
+
+    const std::string insert = "INSERT INTO " + base::quote_identifier(table.name, '`') + " (" + columns + ") VALUES ";
+    const size_t column_count = table.columns.size();
+    std::string buffer;
+    buffer.reserve(_options.insert_size + 64 * 1024);
+    unsigned long long buffered_rows = 0;
+
+    auto flush = [&]() {
+      buffer.append(";\n");
+      file.write(buffer);
+      chunk.bytes += buffer.size();
+      chunk.rows += buffered_rows;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _rows_done += buffered_rows;
+      }
+      buffer.clear();
+      buffered_rows = 0;
+    };
+
+    while (rs->next()) {
+      if (_cancelled)
+        return;
+
+      buffer.append(buffer.empty() ? insert : ",");
+      buffer.push_back('(');
+      for (size_t i = 0; i < column_count; ++i) {
+        if (i > 0)
+          buffer.push_back(',');
+        if (rs->isNull((uint32_t)i + 1)) {
+          buffer.append("NULL");
+          continue;
+        }
+
+        std::string value = rs->getString((uint32_t)i + 1);
+        switch (table.columns[i].kind) {
+          case Column::Numeric:
+            buffer.append(value);
+            break;
+          case Column::Binary:
+            if (value.empty())
+              buffer.append("''");
+            else
+              buffer.append("0x").append(value);
+            break;
+          case Column::Text:
+            buffer.push_back('\'');
+            base::append_escaped_sql_string(buffer, value.data(), value.size());
+            buffer.push_back('\'');
+            break;
+        }
+      }
+      buffer.push_back(')');
+      ++buffered_rows;
+
+      if (buffer.size() >= _options.insert_size)
+        flush();
+    }
+    if (!buffer.empty())
+      flush();
+
+    file.close();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  /**
+   * Describes the dump in manifest.json, which lists the scripts of each schema and table in the order
+   * they have to be restored, along with the binary log position of the snapshot.
+   */
+  void ParallelDump::write_manifest() {
+    JsonObject manifest;
+    manifest.insert("version", JsonValue(1.0));
+    manifest.insert("serverVersion", JsonValue(_server_version));
+    manifest.insert("characterSet", JsonValue(_charset));
+    manifest.insert("compression", JsonValue("gzip"));
+    manifest.insert("consistent", JsonValue(_snapshot_consistent));
+    manifest.insert("binlogFile", JsonValue(_binlog_file));
+    manifest.insert("binlogPosition", JsonValue(_binlog_position));
+    manifest.insert("gtidExecuted", JsonValue(_gtid_executed));
+    manifest.insert("errors", JsonValue((double)_error_count));
+
+    JsonArray schemas;
+    for (auto &schema : _schemas) {
+      JsonObject schema_entry;
+      schema_entry.insert("name", JsonValue(schema->name));
+      schema_entry.insert("file", JsonValue(_options.dump_structure ? schema->file : std::string()));
+      schema_entry.insert("routinesFile", JsonValue(schema->routines_file));
+
+      JsonArray tables;
+      for (auto &table : schema->tables) {
+        JsonObject table_entry;
+        table_entry.insert("name", JsonValue(table->name));
+        table_entry.insert("type", JsonValue(table->is_view ? "view" : "table"));
+        table_entry.insert("file", JsonValue(table->file));
+        table_entry.insert("primaryKey", JsonValue(table->primary_key));
+
+        JsonArray chunks;
+        unsigned long long rows = 0;
+        for (auto &chunk : table->chunks) {
+          JsonObject chunk_entry;
+          chunk_entry.insert("file", JsonValue(chunk.file));
+          chunk_entry.insert("where", JsonValue(chunk.where));
+          chunk_entry.insert("rows", JsonValue((double)chunk.rows));
+          chunk_entry.insert("bytes", JsonValue((double)chunk.bytes));
+          chunks.pushBack(JsonValue(std::move(chunk_entry)));
+          rows += chunk.rows;
+        }
+        table_entry.insert("rows", JsonValue((double)rows));
+        table_entry.insert("chunks", JsonValue(std::move(chunks)));
+        tables.pushBack(JsonValue(std::move(table_entry)));
+      }
+      schema_entry.insert("tables", JsonValue(std::move(tables)));
+      schemas.pushBack(JsonValue(std::move(schema_entry)));
+    }
+    manifest.insert("schemas", JsonValue(std::move(schemas)));
+
+    std::string text;
+    JsonWriter::write(text, JsonValue(std::move(manifest)));
+    write_file(base::makePath(_options.output_dir, "manifest.json"), text);
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelDump::push_jobs(const std::vector<Job> &jobs) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      // Data chunks go first, so that the work of a table already started is spread over all connections.
+      if (!jobs.empty() && jobs.front().kind == Job::DumpChunk)
+        _jobs.insert(_jobs.begin(), jobs.begin(), jobs.end());
+      else
+        _jobs.insert(_jobs.end(), jobs.begin(), jobs.end());
+    }
+    _job_available.notify_all();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelDump::add_done_weight(double weight) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _done_weight += weight;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelDump::log(const std::string &message) {
+    logInfo("%s\n", message.c_str());
+    if (_log_cb)
+      _log_cb(message);
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelDump::report_error(const std::string &message) {
+    logError("%s\n", message.c_str());
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      ++_error_count;
+    }
+    if (_log_cb)
+      _log_cb("ERROR: " + message);
+  }
+
+} // namespace sql
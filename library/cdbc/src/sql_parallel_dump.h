@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#ifndef _SQL_PARALLEL_DUMP_H_
+#define _SQL_PARALLEL_DUMP_H_
+
+#include "cppdbc_public_interface.h"
+#include "driver_manager.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sql {
+
+  /**
+   * Logical dump of a set of schemas and tables over several connections at once.
+   *
+   * While the first connection holds FLUSH TABLES WITH READ LOCK, every connection starts a transaction
+   * WITH CONSISTENT SNAPSHOT, so all of them see the same point in time. Tables with a single column integer
+   * primary key are split into key ranges, which are dumped in parallel as separate gzip compressed SQL scripts.
+   * The output folder is described by a manifest.json file listing every schema, table and chunk.
+   */
+  class CPPDBC_PUBLIC_FUNC ParallelDump {
+  public:
+    struct CPPDBC_PUBLIC_FUNC Options {
+      Options();
+
+      std::string output_dir;
+      size_t chunk_rows;     // Target number of rows per data chunk.
+      size_t insert_size;    // Maximum size of a single extended INSERT statement.
+      int compression_level; // zlib compression level (0-9).
+      bool consistent;       // Lock tables while the snapshot is taken.
+      bool dump_structure;
+      bool dump_data;
+      bool dump_triggers;
+      bool dump_routines;
+      bool dump_events;
+    };
+
+    // The session settings a routine, event or trigger was created with, as reported by SHOW CREATE.
+    struct CPPDBC_PUBLIC_FUNC ProgramSettings {
+      std::string sql_mode;
+      std::string character_set_client;
+      std::string collation_connection;
+      std::string time_zone; // Events only.
+    };
+
+    typedef std::function<void(const std::string &)> Log_cb;
+
+    ParallelDump(const std::vector<ConnectionWrapper> &connections, const Options &options);
+    ~ParallelDump();
+
+    // Tables may also name views. An empty list only dumps the schema itself, plus routines and events if enabled.
+    void add_schema(const std::string &schema, const std::vector<std::string> &tables);
+
+    // Runs the dump, blocking until it is finished or cancelled. Returns the number of errors.
+    int run();
+    void cancel();
+
+    float progress() const;
+    std::string status_text() const;
+    int error_count() const;
+    bool cancelled() const {
+      return _cancelled;
+    }
+
+    void log_cb(const Log_cb &cb) {
+      _log_cb = cb;
+    }
+
+    static std::string file_name(const std::string &schema, const std::string &table = "", int chunk = -1);
+
+    // Wraps the definition of a stored program in the statements that switch the session to the settings it was
+    // created with and restore the previous ones afterwards, like mysqldump does.
+    static std::string program_script(const std::string &ddl, const ProgramSettings &settings);
+
+    // Chunk planning for tables with a single column integer primary key.
+    static unsigned long long key_to_offset(const std::string &value, bool is_unsigned);
+    static std::string offset_to_key(unsigned long long offset, bool is_unsigned);
+    static std::vector<std::string> chunk_bounds(const std::string &min, const std::string &max, bool is_unsigned,
+                                                 unsigned long long chunk_count);
+    static std::vector<std::string> chunk_conditions(const std::string &key, const std::vector<std::string> &bounds);
+
+  private:
+    struct Column;
+    struct Chunk;
+    struct Table;
+    struct Schema;
+    struct Job;
+
+    bool begin_snapshot();
+    bool list_tables();
+    void work(size_t connection_index);
+    void run_job(sql::Connection *connection, const Job &job);
+    void dump_schema(sql::Connection *connection, Schema &schema);
+    void dump_table_structure(sql::Connection *connection, Table &table);
+    void plan_chunks(sql::Connection *connection, Table &table);
+    void dump_chunk(sql::Connection *connection, Table &table, size_t index);
+    void write_manifest();
+
+    void push_jobs(const std::vector<Job> &jobs);
+    void add_done_weight(double weight);
+    void log(const std::string &message);
+    void report_error(const std::string &message);
+
+    std::vector<ConnectionWrapper> _connections;
+    Options _options;
+    Log_cb _log_cb;
+
+    std::vector<std::unique_ptr<Schema> > _schemas;
+    std::string _charset;
+    std::string _server_version;
+    std::string _binlog_file;
+    std::string _binlog_position;
+    std::string _gtid_executed;
+    bool _snapshot_consistent;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _job_available;
+    std::deque<Job> _jobs;
+    size_t _busy_workers;
+    double _total_weight;
+    double _done_weight;
+    size_t _tables_total;
+    size_t _tables_done;
+    unsigned long long _rows_done;
+    int _error_count;
+    std::atomic<bool> _cancelled;
+  };
+
+} // namespace sql
+
+#endif // _SQL_PARALLEL_DUMP_H_
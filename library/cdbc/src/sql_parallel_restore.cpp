@@ -0,0 +1,1146 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "sql_parallel_restore.h"
+
+#include "base/file_functions.h"
+#include "base/file_utilities.h"
+#include "base/jsonparser.h"
+#include "base/log.h"
+#include "base/string_utilities.h"
+
+#include <cppconn/driver.h>
+#include <cppconn/exception.h>
+#include <cppconn/statement.h>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+DEFAULT_LOG_DOMAIN("ParallelRestore")
+
+using namespace JsonParser;
+
+namespace {
+
+  /**
+   * Reads a SQL script statement by statement, decompressing it on the fly if it is gzip compressed.
+   * Dump scripts only need a lexical split: quotes, comments and DELIMITER commands are honored, but
+   * no parsing is done. Line comments are dropped, block comments (including versioned ones) are kept.
+   */
+  class ScriptReader {
+  public:
+    explicit ScriptReader(const std::string &path)
+      : _file(path, "rb"), _gzip(false), _eof(false), _input(256 * 1024), _pos(0), _buffer_offset(0),
+        _delimiter(";"), _statement_start(0) {
+      memset(&_stream, 0, sizeof(_stream));
+
+      size_t read = fread(_input.data(), 1, 2, _file.file());
+      if (read == 2 && _input[0] == 0x1f && _input[1] == 0x8b) {
+        // 32 added to the window bits lets zlib detect the gzip header.
+        if (inflateInit2(&_stream, 15 + 32) != Z_OK)
+          throw std::runtime_error("Could not initialize decompression for " + path);
+        _gzip = true;
+        _stream.next_in = _input.data();
+        _stream.avail_in = (uInt)read;
+      } else
+        _buffer.append((const char *)_input.data(), read);
+    }
+
+    ~ScriptReader() {
+      if (_gzip)
+        inflateEnd(&_stream);
+    }
+
+    // Returns the next non-empty statement without its delimiter.
+    bool next(std::string &statement) {
+      statement.clear();
+      _statement_start = offset();
+      _statement_delimiter = _delimiter;
+
+      bool at_start = true;
+      for (;;) {
+        if (!ensure(std::max(_delimiter.size(), (size_t)10)) && _pos >= _buffer.size())
+          break;
+
+        char c = _buffer[_pos];
+        if (at_start) {
+          if (isspace((unsigned char)c)) {
+            ++_pos;
+            _statement_start = offset();
+            continue;
+          }
+          if (is_delimiter_command()) {
+            read_delimiter_command();
+            _statement_start = offset();
+            _statement_delimiter = _delimiter;
+            continue;
+          }
+        }
+
+        if (c == '#' || (c == '-' && looking_at("--") && (_pos + 2 >= _buffer.size() ||
+                                                             (unsigned char)_buffer[_pos + 2] <= ' '))) {
+          skip_line();
+          continue;
+        }
+
+        if (looking_at(_delimiter)) {
+          _pos += _delimiter.size();
+          statement = base::trim(statement);
+          if (!statement.empty())
+            return true;
+          at_start = true;
+          _statement_start = offset();
+          continue;
+        }
+
+        at_start = false;
+        if (c == '\'' || c == '"' || c == '`')
+          copy_quoted(statement);
+        else if (c == '/' && looking_at("/*"))
+          copy_comment(statement);
+        else
+          copy_plain(statement);
+      }
+
+      statement = base::trim(statement);
+      return !statement.empty();
+    }
+
+    // Script offset (of the uncompressed text) of the current read position.
+    unsigned long long offset() const {
+      return _buffer_offset + _pos;
+    }
+
+    // Where the statement last returned by next() started and the delimiter that was active there.
+    unsigned long long statement_start() const {
+      return _statement_start;
+    }
+    const std::string &statement_delimiter() const {
+      return _statement_delimiter;
+    }
+
+    // Continues reading at the given offset, which must have been taken from statement_start().
+    void seek(unsigned long long target, const std::string &delimiter) {
+      while (offset() < target) {
+        if (_pos >= _buffer.size() && !ensure(1))
+          break;
+        size_t available = _buffer.size() - _pos;
+        _pos += (size_t)std::min<unsigned long long>(available, target - offset());
+      }
+      _delimiter = delimiter;
+    }
+
+  private:
+    // Makes sure at least count unread bytes are buffered. Returns false if the end of the script comes first.
+    bool ensure(size_t count) {
+      if (_buffer.size() - _pos >= count)
+        return true;
+
+      _buffer_offset += _pos;
+      _buffer.erase(0, _pos);
+      _pos = 0;
+      while (_buffer.size() < count && !_eof)
+        fill();
+      return _buffer.size() >= count;
+    }
+
+    void fill() {
+      if (!_gzip) {
+        size_t read = fread(_input.data(), 1, _input.size(), _file.file());
+        if (read == 0)
+          _eof = true;
+        _buffer.append((const char *)_input.data(), read);
+        return;
+      }
+
+      if (_stream.avail_in == 0) {
+        size_t read = fread(_input.data(), 1, _input.size(), _file.file());
+        if (read == 0) {
+          _eof = true;
+          return;
+        }
+        _stream.next_in = _input.data();
+        _stream.avail_in = (uInt)read;
+      }
+
+      char output[256 * 1024];
+      _stream.next_out = (Bytef *)output;
+      _stream.avail_out = sizeof(output);
+      int result = inflate(&_stream, Z_NO_FLUSH);
+      if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+        throw std::runtime_error("Corrupt compressed data in " + _file.getPath());
+      _buffer.append(output, sizeof(output) - _stream.avail_out);
+
+      // Concatenated gzip members form a single script.
+      if (result == Z_STREAM_END)
+        inflateReset(&_stream);
+    }
+
+    bool looking_at(const std::string &text) {
+      if (!ensure(text.size()))
+        return false;
+      return _buffer.compare(_pos, text.size(), text) == 0;
+    }
+
+    bool is_delimiter_command() {
+      static const char keyword[] = "DELIMITER";
+      const size_t length = sizeof(keyword) - 1;
+      if (!ensure(length + 1))
+        return false;
+      for (size_t i = 0; i < length; ++i) {
+        if (toupper((unsigned char)_buffer[_pos + i]) != keyword[i])
+          return false;
+      }
+      return _buffer[_pos + length] == ' ' || _buffer[_pos + length] == '\t';
+    }
+
+    void read_delimiter_command() {
+      std::string line;
+      _pos += 10;
+      for (;;) {
+        if (!ensure(1))
+          break;
+        char c = _buffer[_pos++];
+        if (c == '\n')
+          break;
+        line.push_back(c);
+      }
+      line = base::trim(line);
+      if (!line.empty())
+        _delimiter = line;
+    }
+
+    void skip_line() {
+      for (;;) {
+        if (!ensure(1))
+          return;
+        const char *start = _buffer.data() + _pos;
+        const char *end = (const char *)memchr(start, '\n', _buffer.size() - _pos);
+        // The line break stays, it may separate the surrounding tokens.
+        if (end) {
+          _pos += end - start;
+          return;
+        }
+        _pos = _buffer.size();
+      }
+    }
+
+    void copy_quoted(std::string &statement) {
+      char quote = _buffer[_pos++];
+      statement.push_back(quote);
+      for (;;) {
+        if (!ensure(1))
+          return;
+        // Copy everything up to the next quote or escape char in one go.
+        size_t end = _pos;
+        while (end < _buffer.size() && _buffer[end] != quote && (_buffer[end] != '\\' || quote == '`'))
+          ++end;
+        statement.append(_buffer, _pos, end - _pos);
+        _pos = end;
+        if (_pos >= _buffer.size())
+          continue;
+
+        char c = _buffer[_pos++];
+        statement.push_back(c);
+        if (c == quote)
+          return; // A doubled quote simply starts a new quoted section.
+        if (ensure(1))
+          statement.push_back(_buffer[_pos++]);
+      }
+    }
+
+    void copy_comment(std::string &statement) {
+      statement.append("/*");
+      _pos += 2;
+      for (;;) {
+        if (!ensure(2)) {
+          statement.append(_buffer, _pos, std::string::npos);
+          _pos = _buffer.size();
+          return;
+        }
+        if (_buffer[_pos] == '*' && _buffer[_pos + 1] == '/') {
+          statement.append("*/");
+          _pos += 2;
+          return;
+        }
+        statement.push_back(_buffer[_pos++]);
+      }
+    }
+
+    void copy_plain(std::string &statement) {
+      const char first = _delimiter[0];
+      size_t end = _pos + 1;
+      while (end < _buffer.size()) {
+        char c = _buffer[end];
+        if (c == first || c == '\'' || c == '"' || c == '`' || c == '/' || c == '-' || c == '#')
+          break;
+        ++end;
+      }
+      statement.append(_buffer, _pos, end - _pos);
+      _pos = end;
+    }
+
+    base::FileHandle _file;
+    bool _gzip;
+    bool _eof;
+    z_stream _stream;
+    std::vector<unsigned char> _input;
+    std::string _buffer;
+    size_t _pos;
+    unsigned long long _buffer_offset; // Script offset of _buffer[0].
+    std::string _delimiter;
+    unsigned long long _statement_start;
+    std::string _statement_delimiter;
+  };
+
+  //------------------------------------------------------------------------------------------------
+
+  enum StatementKind { SessionStatement, StructureStatement, DataStatement, OtherStatement };
+
+  /**
+   * Returns the first words of a statement, looking through comments and into versioned comments,
+   * so that "/*!50003 CREATE*\/ /*!50017 DEFINER=..." starts with CREATE DEFINER.
+   */
+  std::vector<std::string> leading_words(const std::string &statement, size_t count) {
+    std::vector<std::string> words;
+    size_t i = 0;
+    while (i < statement.size() && words.size() < count) {
+      unsigned char c = statement[i];
+      if (isspace(c))
+        ++i;
+      else if (statement.compare(i, 3, "/*!") == 0) {
+        i += 3;
+        while (i < statement.size() && isdigit((unsigned char)statement[i]))
+          ++i;
+      } else if (statement.compare(i, 2, "/*") == 0) {
+        size_t end = statement.find("*/", i + 2);
+        i = end == std::string::npos ? statement.size() : end + 2;
+      } else if (statement.compare(i, 2, "*/") == 0)
+        i += 2;
+      else if (isalpha(c) || c == '_') {
+        size_t start = i;
+        while (i < statement.size() && (isalnum((unsigned char)statement[i]) || statement[i] == '_'))
+          ++i;
+        words.push_back(base::toupper(statement.substr(start, i - start)));
+      } else
+        break;
+    }
+    return words;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  StatementKind classify(const std::string &statement) {
+    std::vector<std::string> words = leading_words(statement, 2);
+    if (words.empty())
+      return SessionStatement;
+
+    const std::string &first = words[0];
+    if (first == "SET" || first == "USE")
+      return SessionStatement;
+    if (first == "INSERT" || first == "REPLACE" || first == "LOCK" || first == "UNLOCK")
+      return DataStatement;
+    if (first == "ALTER" && (statement.find("DISABLE KEYS") != std::string::npos ||
+                             statement.find("ENABLE KEYS") != std::string::npos))
+      return DataStatement;
+    if ((first == "CREATE" || first == "DROP") && words.size() > 1 &&
+        (words[1] == "TABLE" || words[1] == "DATABASE" || words[1] == "SCHEMA"))
+      return StructureStatement;
+    return OtherStatement;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  // Settings of the global server state must not be repeated on other connections.
+  bool is_session_setting(const std::string &statement) {
+    return base::toupper(statement).find("GLOBAL") == std::string::npos;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  double file_weight(const std::string &path) {
+    long size = base_get_file_size(path.c_str());
+    return size > 0 ? (double)size : 1.0;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void use_schema(sql::Connection *connection, const std::string &schema) {
+    if (schema.empty())
+      return;
+    try {
+      connection->setSchema(schema);
+    } catch (sql::SQLException &) {
+      // The script may create the schema itself.
+    }
+  }
+
+} // namespace
+
+namespace sql {
+
+  struct ParallelRestore::Table {
+    // A statement run after the data was loaded, with the session settings that were in effect before it.
+    struct PostStatement {
+      std::vector<std::string> session_statements;
+      std::string statement;
+    };
+
+    Table() : combined(false), failed(false), has_data(false), data_offset(0), pending_data(0) {
+    }
+
+    std::string schema;
+    std::string name;
+    std::string structure_file;
+    bool combined; // A mysqldump script holding definition, data and triggers.
+    std::vector<std::string> data_files;
+    double structure_weight;
+    double data_weight;
+
+    // Filled in while the structure is restored.
+    bool failed;
+    bool has_data;
+    unsigned long long data_offset;
+    std::string data_delimiter;
+    std::vector<std::string> session_statements;
+    std::vector<std::string> index_statements;
+    std::vector<PostStatement> post_statements;
+    size_t pending_data;
+  };
+
+  struct ParallelRestore::Schema {
+    std::string name;
+    std::string create_file;
+    std::vector<std::string> view_files;
+    std::vector<std::string> post_files;
+    std::vector<std::unique_ptr<Table> > tables;
+  };
+
+  struct ParallelRestore::Job {
+    enum Kind { CreateSchema, Structure, Data, TablePost, SchemaPost };
+
+    Kind kind;
+    Schema *schema;
+    Table *table;
+    size_t index;
+  };
+
+  //------------------------------------------------------------------------------------------------
+
+  ParallelRestore::Options::Options() : defer_indexes(false) {
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  ParallelRestore::ParallelRestore(const std::vector<ConnectionWrapper> &connections, const Options &options)
+    : _connections(connections),
+      _options(options),
+      _busy_workers(0),
+      _total_weight(0),
+      _done_weight(0),
+      _tables_total(0),
+      _tables_done(0),
+      _error_count(0),
+      _cancelled(false) {
+    if (_connections.empty())
+      throw std::invalid_argument("ParallelRestore needs at least one connection");
+    _workers.resize(_connections.size());
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  ParallelRestore::~ParallelRestore() {
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  ParallelRestore::Schema &ParallelRestore::schema(const std::string &name) {
+    for (auto &schema : _schemas) {
+      if (schema->name == name)
+        return *schema;
+    }
+    _schemas.push_back(std::unique_ptr<Schema>(new Schema()));
+    _schemas.back()->name = name;
+    return *_schemas.back();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::add_manifest(const std::string &folder,
+                                     const std::map<std::string, std::set<std::string> > &selection) {
+    JsonValue value;
+    JsonReader::readFromFile(base::makePath(folder, "manifest.json"), value);
+    const JsonObject &manifest = value;
+
+    const JsonArray &schemas = manifest.get("schemas");
+    for (const JsonValue &schema_value : schemas) {
+      const JsonObject &schema_entry = schema_value;
+      const std::string &name = schema_entry.get("name");
+
+      const std::set<std::string> *filter = nullptr;
+      if (!selection.empty()) {
+        auto entry = selection.find(name);
+        if (entry == selection.end())
+          continue;
+        filter = &entry->second;
+      }
+
+      Schema &target = schema(name);
+      const std::string &file = schema_entry.get("file");
+      if (!file.empty())
+        target.create_file = base::makePath(folder, file);
+
+      const JsonArray &tables = schema_entry.get("tables");
+      for (const JsonValue &table_value : tables) {
+        const JsonObject &table_entry = table_value;
+        const std::string &table_name = table_entry.get("name");
+        if (filter && filter->find(table_name) == filter->end())
+          continue;
+
+        const std::string &table_file = table_entry.get("file");
+        if ((const std::string &)table_entry.get("type") == "view") {
+          if (!table_file.empty())
+            target.view_files.push_back(base::makePath(folder, table_file));
+          continue;
+        }
+
+        std::unique_ptr<Table> table(new Table());
+        table->schema = name;
+        table->name = table_name;
+        if (!table_file.empty())
+          table->structure_file = base::makePath(folder, table_file);
+        table->structure_weight = table_file.empty() ? 0.0 : file_weight(table->structure_file);
+        table->data_weight = 0;
+
+        const JsonArray &chunks = table_entry.get("chunks");
+        for (const JsonValue &chunk_value : chunks) {
+          const JsonObject &chunk_entry = chunk_value;
+          std::string path = base::makePath(folder, chunk_entry.get("file"));
+          table->data_weight += file_weight(path);
+          table->data_files.push_back(path);
+        }
+        target.tables.push_back(std::move(table));
+      }
+
+      const std::string &routines_file = schema_entry.get("routinesFile");
+      if (!routines_file.empty())
+        target.post_files.push_back(base::makePath(folder, routines_file));
+    }
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::add_script(const std::string &schema_name, const std::string &table_name,
+                                   const std::string &path) {
+    Schema &target = schema(schema_name);
+    if (table_name.empty()) {
+      target.post_files.push_back(path);
+      return;
+    }
+
+    std::unique_ptr<Table> table(new Table());
+    table->schema = schema_name;
+    table->name = table_name;
+    table->structure_file = path;
+    table->combined = true;
+    table->structure_weight = 1.0;
+    table->data_weight = file_weight(path);
+    target.tables.push_back(std::move(table));
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  int ParallelRestore::run() {
+    std::vector<Job> schema_jobs, structure_jobs, post_jobs;
+    std::vector<Table *> tables;
+    for (auto &schema : _schemas) {
+      if (!schema->create_file.empty()) {
+        schema_jobs.push_back({Job::CreateSchema, schema.get(), nullptr, 0});
+        _total_weight += 1.0;
+      }
+      for (auto &table : schema->tables) {
+        tables.push_back(table.get());
+        _total_weight += table->structure_weight + table->data_weight + 1.0;
+      }
+      if (!schema->view_files.empty() || !schema->post_files.empty()) {
+        post_jobs.push_back({Job::SchemaPost, schema.get(), nullptr, 0});
+        _total_weight += 1.0;
+      }
+    }
+    _tables_total = tables.size();
+
+    // Big tables first, so that their data loads start early and smaller ones fill the gaps.
+    std::stable_sort(tables.begin(), tables.end(),
+                     [](Table *a, Table *b) { return a->data_weight > b->data_weight; });
+    for (Table *table : tables) {
+      if (!table->structure_file.empty())
+        structure_jobs.push_back({Job::Structure, nullptr, table, 0});
+      else
+        table->has_data = !table->data_files.empty();
+    }
+
+    for (auto &connection : _connections) {
+      try {
+        std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+        stmt->execute("SET SESSION FOREIGN_KEY_CHECKS = 0, UNIQUE_CHECKS = 0");
+      } catch (sql::SQLException &e) {
+        report_error(std::string("Could not prepare the restore session: ") + e.what());
+        return _error_count;
+      }
+    }
+
+    log("Restoring schema and table definitions");
+    run_phase(schema_jobs);
+    if (!_cancelled)
+      run_phase(structure_jobs);
+
+    if (!_cancelled) {
+      log("Loading table data");
+      std::vector<Job> data_jobs;
+      for (Table *table : tables) {
+        if (table->failed) {
+          job_done(table->data_weight + 1.0);
+          std::lock_guard<std::mutex> lock(_mutex);
+          ++_tables_done;
+          continue;
+        }
+
+        if (!table->has_data) {
+          job_done(table->data_weight);
+          data_jobs.push_back({Job::TablePost, nullptr, table, 0});
+          continue;
+        }
+
+        table->pending_data = table->combined ? 1 : table->data_files.size();
+        for (size_t i = 0; i < table->pending_data; ++i)
+          data_jobs.push_back({Job::Data, nullptr, table, i});
+      }
+      run_phase(data_jobs);
+    }
+
+    if (!_cancelled) {
+      log("Restoring views, routines and events");
+      run_phase(post_jobs);
+    }
+
+    if (_cancelled)
+      log("Restore cancelled");
+    else
+      log(status_text());
+    return _error_count;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::cancel() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _cancelled = true;
+    }
+    _job_available.notify_all();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  float ParallelRestore::progress() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_total_weight <= 0)
+      return 0;
+    return (float)std::min(1.0, _done_weight / _total_weight);
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  std::string ParallelRestore::status_text() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    unsigned long long rows = 0;
+    std::string rates;
+    for (const WorkerStatus &worker : _workers) {
+      rows += worker.rows;
+      rates += (rates.empty() ? "" : ", ") + std::to_string((long long)worker.rows_per_second());
+    }
+    return base::strfmt("%i of %i tables restored, %llu rows (rows/s per connection: %s)", (int)_tables_done,
+                        (int)_tables_total, rows, rates.c_str());
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  int ParallelRestore::error_count() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _error_count;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  std::vector<ParallelRestore::WorkerStatus> ParallelRestore::worker_status() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _workers;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  std::vector<std::string> ParallelRestore::split_script(const std::string &path) {
+    std::vector<std::string> statements;
+    ScriptReader reader(path);
+    std::string statement;
+    while (reader.next(statement))
+      statements.push_back(statement);
+    return statements;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  std::string ParallelRestore::defer_secondary_indexes(const std::string &statement,
+                                                       std::vector<std::string> &alter_statements) {
+    std::vector<std::string> lines = base::split(statement, "\n");
+    if (lines.size() < 3 || !base::hasSuffix(base::trim_right(lines[0]), "("))
+      return statement;
+
+    size_t close = lines.size() - 1;
+    while (close > 0 && !base::hasPrefix(lines[close], ")"))
+      --close;
+    if (close < 2)
+      return statement;
+
+    std::string table = base::trim(lines[0].substr(0, lines[0].rfind('(')));
+    size_t table_start = base::toupper(table).find(" TABLE ");
+    if (table_start == std::string::npos)
+      return statement;
+    table = base::trim(table.substr(table_start + 7));
+    if (base::hasPrefix(base::toupper(table), "IF NOT EXISTS "))
+      table = base::trim(table.substr(14));
+
+    std::string auto_increment_column;
+    std::vector<std::string> definitions;
+    for (size_t i = 1; i < close; ++i) {
+      std::string definition = base::trim(lines[i]);
+      if (base::hasSuffix(definition, ","))
+        definition.resize(definition.size() - 1);
+
+      // An index may be the one backing a foreign key, so leave such tables alone.
+      if (base::hasPrefix(definition, "CONSTRAINT ") && definition.find(" FOREIGN KEY ") != std::string::npos)
+        return statement;
+      if (definition[0] == '`' && definition.find(" AUTO_INCREMENT") != std::string::npos)
+        auto_increment_column = definition.substr(0, definition.find('`', 1) + 1);
+      definitions.push_back(definition);
+    }
+
+    std::vector<std::string> kept, deferred, fulltext;
+    for (const std::string &definition : definitions) {
+      bool is_key = base::hasPrefix(definition, "KEY ") || base::hasPrefix(definition, "UNIQUE KEY ") ||
+                    base::hasPrefix(definition, "SPATIAL KEY ");
+      bool is_fulltext = base::hasPrefix(definition, "FULLTEXT KEY ");
+      if (!is_key && !is_fulltext) {
+        kept.push_back(definition);
+        continue;
+      }
+
+      // The AUTO_INCREMENT column must lead some index at all times.
+      size_t columns = definition.find('(');
+      if (!auto_increment_column.empty() && columns != std::string::npos &&
+          definition.compare(columns + 1, auto_increment_column.size(), auto_increment_column) == 0) {
+        kept.push_back(definition);
+        continue;
+      }
+      (is_fulltext ? fulltext : deferred).push_back("ADD " + definition);
+    }
+    if (deferred.empty() && fulltext.empty())
+      return statement;
+
+    if (!deferred.empty())
+      alter_statements.push_back("ALTER TABLE " + table + " " + base::join(deferred, ", "));
+    // InnoDB builds only one FULLTEXT index per statement.
+    for (const std::string &index : fulltext)
+      alter_statements.push_back("ALTER TABLE " + table + " " + index);
+
+    std::string result = lines[0] + "\n  " + base::join(kept, ",\n  ");
+    for (size_t i = close; i < lines.size(); ++i)
+      result += "\n" + lines[i];
+    return result;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::run_phase(const std::vector<Job> &jobs) {
+    if (jobs.empty())
+      return;
+
+    push_jobs(jobs, false);
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < _connections.size(); ++i)
+      workers.push_back(std::thread(&ParallelRestore::work, this, i));
+    for (std::thread &worker : workers)
+      worker.join();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _jobs.clear();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::work(size_t worker) {
+    sql::Connection *connection = _connections[worker].get();
+    sql::Driver *driver = connection->getDriver();
+    driver->threadInit();
+
+    for (;;) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        // Running jobs may still queue follow-up work, so only stop once nobody is busy anymore.
+        _job_available.wait(lock, [this]() { return _cancelled || !_jobs.empty() || _busy_workers == 0; });
+        if (_cancelled || _jobs.empty())
+          break;
+        job = _jobs.front();
+        _jobs.pop_front();
+        ++_busy_workers;
+      }
+
+      run_job(worker, connection, job);
+      set_task(worker, "");
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        --_busy_workers;
+      }
+      _job_available.notify_all();
+    }
+
+    driver->threadEnd();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::run_job(size_t worker, sql::Connection *connection, const Job &job) {
+    switch (job.kind) {
+      case Job::CreateSchema:
+        set_task(worker, job.schema->create_file);
+        try {
+          run_script(worker, connection, "", job.schema->create_file);
+        } catch (std::exception &e) {
+          report_error("Error creating schema `" + job.schema->name + "`: " + e.what());
+        }
+        job_done(1.0);
+        break;
+
+      case Job::Structure: {
+        Table &table = *job.table;
+        set_task(worker, table.structure_file);
+        try {
+          run_structure(worker, connection, table);
+        } catch (std::exception &e) {
+          table.failed = true;
+          report_error("Error restoring the definition of `" + table.schema + "`.`" + table.name + "`: " + e.what());
+        }
+        job_done(table.structure_weight);
+        break;
+      }
+
+      case Job::Data: {
+        Table &table = *job.table;
+        std::string path = table.combined ? table.structure_file : table.data_files[job.index];
+        set_task(worker, path);
+        try {
+          run_data(worker, connection, table, job.index);
+        } catch (std::exception &e) {
+          report_error("Error loading " + path + " into `" + table.schema + "`.`" + table.name + "`: " + e.what());
+        }
+        job_done(table.combined ? table.data_weight : file_weight(path));
+
+        bool last;
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          last = --table.pending_data == 0;
+        }
+        if (last)
+          push_jobs({{Job::TablePost, nullptr, &table, 0}}, true);
+        break;
+      }
+
+      case Job::TablePost: {
+        Table &table = *job.table;
+        set_task(worker, "`" + table.schema + "`.`" + table.name + "` indexes and triggers");
+        try {
+          run_table_post(worker, connection, table);
+        } catch (std::exception &e) {
+          report_error("Error creating indexes or triggers of `" + table.schema + "`.`" + table.name + "`: " +
+                       e.what());
+        }
+        job_done(1.0);
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_tables_done;
+        break;
+      }
+
+      case Job::SchemaPost:
+        run_schema_post(worker, connection, *job.schema);
+        job_done(1.0);
+        break;
+    }
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  /**
+   * Runs the definition part of a table script. For a mysqldump script this stops at the first data
+   * statement, remembering where the data starts and which session settings were made up to there.
+   */
+  void ParallelRestore::run_structure(size_t worker, sql::Connection *connection, Table &table) {
+    use_schema(connection, table.schema);
+    std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+
+    ScriptReader reader(table.structure_file);
+    std::string statement;
+    while (!_cancelled && reader.next(statement)) {
+      switch (classify(statement)) {
+        case SessionStatement:
+          execute(worker, stmt.get(), statement, false);
+          if (is_session_setting(statement))
+            table.session_statements.push_back(statement);
+          break;
+
+        case StructureStatement:
+          if (_options.defer_indexes && leading_words(statement, 1)[0] == "CREATE")
+            statement = defer_secondary_indexes(statement, table.index_statements);
+          execute(worker, stmt.get(), statement, false);
+          break;
+
+        case DataStatement:
+          if (table.combined) {
+            table.has_data = true;
+            table.data_offset = reader.statement_start();
+            table.data_delimiter = reader.statement_delimiter();
+            return;
+          }
+          execute(worker, stmt.get(), statement, true);
+          break;
+
+        case OtherStatement:
+          // Triggers must not fire while the data is loaded.
+          table.post_statements.push_back({table.session_statements, statement});
+          break;
+      }
+    }
+    if (!table.combined)
+      table.has_data = !table.data_files.empty();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::run_data(size_t worker, sql::Connection *connection, Table &table, size_t index) {
+    use_schema(connection, table.schema);
+    std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+
+    std::unique_ptr<ScriptReader> reader;
+    std::vector<std::string> session_statements;
+    if (table.combined) {
+      session_statements = table.session_statements;
+      reader.reset(new ScriptReader(table.structure_file));
+      for (const std::string &statement : table.session_statements)
+        execute(worker, stmt.get(), statement, false);
+      reader->seek(table.data_offset, table.data_delimiter);
+    } else
+      reader.reset(new ScriptReader(table.data_files[index]));
+
+    std::string statement;
+    while (!_cancelled && reader->next(statement)) {
+      switch (classify(statement)) {
+        case DataStatement:
+          execute(worker, stmt.get(), statement, true);
+          break;
+
+        case OtherStatement:
+          // Only one job reads a mysqldump script, so its trailing triggers can be collected here.
+          if (table.combined) {
+            table.post_statements.push_back({session_statements, statement});
+            break;
+          }
+          execute(worker, stmt.get(), statement, false);
+          break;
+
+        case SessionStatement:
+          // mysqldump switches sql_mode and character set around each trigger.
+          if (table.combined && is_session_setting(statement))
+            session_statements.push_back(statement);
+          execute(worker, stmt.get(), statement, false);
+          break;
+
+        default:
+          execute(worker, stmt.get(), statement, false);
+          break;
+      }
+    }
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::run_table_post(size_t worker, sql::Connection *connection, Table &table) {
+    use_schema(connection, table.schema);
+    std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+
+    for (const std::string &statement : table.index_statements) {
+      if (_cancelled)
+        return;
+      execute(worker, stmt.get(), statement, false);
+    }
+    // Triggers keep the sql_mode and character set they were created with, so the session settings made
+    // before each of them in the script are repeated first.
+    const std::vector<std::string> *session_statements = nullptr;
+    for (const Table::PostStatement &post : table.post_statements) {
+      if (_cancelled)
+        return;
+      if (session_statements == nullptr || *session_statements != post.session_statements) {
+        for (const std::string &statement : post.session_statements)
+          execute(worker, stmt.get(), statement, false);
+        session_statements = &post.session_statements;
+      }
+      execute(worker, stmt.get(), post.statement, false);
+    }
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  /**
+   * Creates the views of a schema, then runs its routine scripts. Views may depend on each other, so
+   * the ones failing are retried as long as others could be created meanwhile.
+   */
+  void ParallelRestore::run_schema_post(size_t worker, sql::Connection *connection, Schema &schema) {
+    std::vector<std::string> pending = schema.view_files;
+    std::map<std::string, std::string> errors;
+    while (!pending.empty() && !_cancelled) {
+      std::vector<std::string> failed;
+      for (const std::string &path : pending) {
+        set_task(worker, path);
+        try {
+          run_script(worker, connection, schema.name, path);
+        } catch (std::exception &e) {
+          errors[path] = e.what();
+          failed.push_back(path);
+        }
+      }
+      if (failed.size() == pending.size())
+        break;
+      pending.swap(failed);
+    }
+    for (const std::string &path : pending)
+      report_error("Error restoring " + path + ": " + errors[path]);
+
+    for (const std::string &path : schema.post_files) {
+      if (_cancelled)
+        return;
+      set_task(worker, path);
+      try {
+        run_script(worker, connection, schema.name, path);
+      } catch (std::exception &e) {
+        report_error("Error restoring " + path + ": " + e.what());
+      }
+    }
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  bool ParallelRestore::run_script(size_t worker, sql::Connection *connection, const std::string &schema,
+                                   const std::string &path) {
+    use_schema(connection, schema);
+    std::unique_ptr<sql::Statement> stmt(connection->createStatement());
+
+    ScriptReader reader(path);
+    std::string statement;
+    while (reader.next(statement)) {
+      if (_cancelled)
+        return false;
+      execute(worker, stmt.get(), statement, classify(statement) == DataStatement);
+    }
+    return true;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::execute(size_t worker, sql::Statement *stmt, const std::string &statement, bool is_data) {
+    if (!is_data) {
+      stmt->execute(statement);
+      return;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    stmt->execute(statement);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    unsigned long long rows = stmt->getUpdateCount();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _workers[worker].rows += rows;
+    _workers[worker].seconds += elapsed.count();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::set_task(size_t worker, const std::string &task) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _workers[worker].task = task;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::push_jobs(const std::vector<Job> &jobs, bool front) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _jobs.insert(front ? _jobs.begin() : _jobs.end(), jobs.begin(), jobs.end());
+    }
+    _job_available.notify_all();
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::job_done(double weight) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _done_weight += weight;
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::log(const std::string &message) {
+    logInfo("%s\n", message.c_str());
+    if (_log_cb)
+      _log_cb(message);
+  }
+
+  //------------------------------------------------------------------------------------------------
+
+  void ParallelRestore::report_error(const std::string &message) {
+    logError("%s\n", message.c_str());
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      ++_error_count;
+    }
+    if (_log_cb)
+      _log_cb("ERROR: " + message);
+  }
+
+} // namespace sql
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#ifndef _SQL_PARALLEL_RESTORE_H_
+#define _SQL_PARALLEL_RESTORE_H_
+
+#include "cppdbc_public_interface.h"
+#include "driver_manager.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace sql {
+
+  /**
+   * Restores a dump folder over several connections at once.
+   *
+   * The folder is either a chunked dump described by a manifest.json (as written by ParallelDump) or a
+   * Dump Project Folder with one mysqldump script per table. Work is done in phases: schemas and table
+   * definitions first, then all table data, spread over the connections with the largest tables first.
+   * Triggers and deferred secondary indexes of a table are created as soon as its data is loaded.
+   * Views, routines and events follow at the end.
+   */
+  class CPPDBC_PUBLIC_FUNC ParallelRestore {
+  public:
+    struct CPPDBC_PUBLIC_FUNC Options {
+      Options();
+
+      bool defer_indexes; // Create secondary indexes only after the table data was loaded.
+    };
+
+    struct WorkerStatus {
+      WorkerStatus() : rows(0), seconds(0) {
+      }
+
+      double rows_per_second() const {
+        return seconds > 0 ? rows / seconds : 0;
+      }
+
+      unsigned long long rows; // Rows inserted so far.
+      double seconds;          // Time spent executing data statements.
+      std::string task;        // Script being executed, empty while idle.
+    };
+
+    typedef std::function<void(const std::string &)> Log_cb;
+
+    ParallelRestore(const std::vector<ConnectionWrapper> &connections, const Options &options);
+    ~ParallelRestore();
+
+    // Adds a dump written by ParallelDump. The selection maps schema names to the tables and views to restore,
+    // schemas not listed in a non-empty selection are skipped. Throws if the manifest cannot be read.
+    void add_manifest(const std::string &folder, const std::map<std::string, std::set<std::string> > &selection);
+
+    // Adds a mysqldump script of a Dump Project Folder. Scripts without a table name (views, routines and events)
+    // are run in the given schema after all tables have been restored.
+    void add_script(const std::string &schema, const std::string &table, const std::string &path);
+
+    // Runs the restore, blocking until it is finished or cancelled. Returns the number of errors.
+    int run();
+    void cancel();
+
+    float progress() const;
+    std::string status_text() const;
+    int error_count() const;
+    std::vector<WorkerStatus> worker_status() const;
+    bool cancelled() const {
+      return _cancelled;
+    }
+
+    void log_cb(const Log_cb &cb) {
+      _log_cb = cb;
+    }
+
+    // Splits a dump script, which may be gzip compressed, into its statements the way the restore does.
+    static std::vector<std::string> split_script(const std::string &path);
+
+    // Removes the secondary indexes from a CREATE TABLE statement as returned by SHOW CREATE TABLE and
+    // returns the ALTER TABLE statements to add them back. Indexes needed by foreign keys or by an
+    // AUTO_INCREMENT column are kept. Returns the statement unchanged if nothing can be deferred.
+    static std::string defer_secondary_indexes(const std::string &statement, std::vector<std::string> &alter_statements);
+
+  private:
+    struct Table;
+    struct Schema;
+    struct Job;
+
+    void run_phase(const std::vector<Job> &jobs);
+    void work(size_t worker);
+    void run_job(size_t worker, sql::Connection *connection, const Job &job);
+    void run_structure(size_t worker, sql::Connection *connection, Table &table);
+    void run_data(size_t worker, sql::Connection *connection, Table &table, size_t index);
+    void run_table_post(size_t worker, sql::Connection *connection, Table &table);
+    void run_schema_post(size_t worker, sql::Connection *connection, Schema &schema);
+    void execute(size_t worker, sql::Statement *stmt, const std::string &statement, bool is_data);
+    bool run_script(size_t worker, sql::Connection *connection, const std::string &schema, const std::string &path);
+
+    Schema &schema(const std::string &name);
+    void set_task(size_t worker, const std::string &task);
+    void push_jobs(const std::vector<Job> &jobs, bool front);
+    void job_done(double weight);
+    void log(const std::string &message);
+    void report_error(const std::string &message);
+
+    std::vector<ConnectionWrapper> _connections;
+    Options _options;
+    Log_cb _log_cb;
+
+    std::vector<std::unique_ptr<Schema> > _schemas;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _job_available;
+    std::deque<Job> _jobs;
+    size_t _busy_workers;
+    std::vector<WorkerStatus> _workers;
+    double _total_weight;
+    double _done_weight;
+    size_t _tables_total;
+    size_t _tables_done;
+    int _error_count;
+    std::atomic<bool> _cancelled;
+  };
+
+} // namespace sql
+
+#endif // _SQL_PARALLEL_RESTORE_H_
@@ -281,6 +281,86 @@ TEST_FUNCTION(9) {
   }
 }
 
+// Test the connection pool: reuse, session reset on return, dropping closed and not reusable connections and
+// forgetting a server once its last connection is released.
+TEST_FUNCTION(10) {
+  sql::ConnectionPool *pool = sql::DriverManager::getDriverManager()->getConnectionPool();
+  ensure("pool is NULL", pool != NULL);
+
+  pool->set_warm_count(0);
+  std::string key = sql::ConnectionPool::pool_key(connectionProperties);
+  pool->clear(key);
+
+  // Stands for another editor tab, connections are only kept while the server is in use.
+  sql::ConnectionWrapper other_tab = pool->acquire(connectionProperties, std::shared_ptr<sql::TunnelConnection>(),
+                                                   sql::Authentication::Ref());
+  sql::ConnectionPool::Stats before = pool->stats(key);
+
+  int connection_id;
+  {
+    sql::ConnectionWrapper wrapper = pool->acquire(connectionProperties, std::shared_ptr<sql::TunnelConnection>(),
+                                                   sql::Authentication::Ref());
+    ensure("conn is NULL", wrapper.get() != NULL);
+    std::auto_ptr<sql::Statement> stmt(wrapper->createStatement());
+    std::auto_ptr<sql::ResultSet> rs(stmt->executeQuery("SELECT CONNECTION_ID()"));
+    ensure("no connection id", rs->next());
+    connection_id = rs->getInt(1);
+
+    wrapper->setAutoCommit(false);
+    ensure_equals("in use", pool->stats(key).in_use, before.in_use + 1);
+  }
+  ensure_equals("returned", pool->stats(key).idle, 1U);
+
+  {
+    sql::ConnectionWrapper wrapper = pool->acquire(connectionProperties, std::shared_ptr<sql::TunnelConnection>(),
+                                                   sql::Authentication::Ref());
+    std::auto_ptr<sql::Statement> stmt(wrapper->createStatement());
+    std::auto_ptr<sql::ResultSet> rs(stmt->executeQuery("SELECT CONNECTION_ID()"));
+    ensure("no connection id", rs->next());
+    ensure_equals("same session", rs->getInt(1), connection_id);
+    ensure("autocommit reset", wrapper->getAutoCommit());
+    ensure_equals("reused", pool->stats(key).reused, before.reused + 1);
+
+    // A closed connection must not go back to the pool.
+    wrapper->close();
+  }
+  ensure_equals("closed one dropped", pool->stats(key).idle, 0U);
+
+  // Not reusable connections are closed when released.
+  {
+    sql::ConnectionWrapper wrapper =
+      pool->acquire(connectionProperties, std::shared_ptr<sql::TunnelConnection>(), sql::Authentication::Ref(),
+                    sql::DriverManager::ConnectionInitSlot(), false);
+    std::auto_ptr<sql::Statement> stmt(wrapper->createStatement());
+    stmt->execute("SET @pool_test = 1");
+  }
+  ensure_equals("not reusable one dropped", pool->stats(key).idle, 0U);
+
+  // Keep alive keeps healthy idle connections.
+  {
+    sql::ConnectionWrapper wrapper = pool->acquire(connectionProperties, std::shared_ptr<sql::TunnelConnection>(),
+                                                   sql::Authentication::Ref());
+  }
+  pool->keep_alive();
+  ensure_equals("idle after ping", pool->stats(key).idle, 1U);
+  ensure("pinged", pool->stats(key).pings > before.pings);
+
+  pool->clear(key);
+  ensure_equals("cleared", pool->stats(key).idle, 0U);
+
+  // Once the last connection is released, nothing is kept for the server.
+  {
+    sql::ConnectionWrapper wrapper = pool->acquire(connectionProperties, std::shared_ptr<sql::TunnelConnection>(),
+                                                   sql::Authentication::Ref());
+  }
+  ensure_equals("kept while in use", pool->stats(key).idle, 1U);
+  size_t dropped = pool->stats().dropped;
+  other_tab.reset();
+  ensure_equals("nothing kept", pool->stats(key).idle, 0U);
+  ensure_equals("none in use", pool->stats(key).in_use, 0U);
+  ensure_equals("closed on last release", pool->stats().dropped, dropped + 2);
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
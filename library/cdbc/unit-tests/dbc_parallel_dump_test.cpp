@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "sql_parallel_dump.h"
+#include "base/file_utilities.h"
+#include "base/jsonparser.h"
+#include "base/string_utilities.h"
+#include "connection_helpers.h"
+#include "wb_helpers.h"
+
+#include <limits>
+#include <memory>
+
+BEGIN_TEST_DATA_CLASS(module_dbc_parallel_dump_test)
+END_TEST_DATA_CLASS
+
+TEST_MODULE(module_dbc_parallel_dump_test, "DBC: parallel dump tests");
+
+// A routine or trigger is created with its own sql_mode, client character set and collation, which are restored
+// afterwards.
+TEST_FUNCTION(1) {
+  sql::ParallelDump::ProgramSettings settings;
+  settings.sql_mode = "ANSI_QUOTES,NO_ENGINE_SUBSTITUTION";
+  settings.character_set_client = "latin1";
+  settings.collation_connection = "latin1_swedish_ci";
+
+  std::string script = sql::ParallelDump::program_script("CREATE PROCEDURE p() SELECT \"a\"", settings);
+  ensure_equals("routine script", script,
+                "/*!50003 SET @saved_cs_client      = @@character_set_client */ ;\n"
+                "/*!50003 SET @saved_cs_results     = @@character_set_results */ ;\n"
+                "/*!50003 SET @saved_col_connection = @@collation_connection */ ;\n"
+                "/*!50003 SET character_set_client  = latin1 */ ;\n"
+                "/*!50003 SET character_set_results = latin1 */ ;\n"
+                "/*!50003 SET collation_connection  = latin1_swedish_ci */ ;\n"
+                "/*!50003 SET @saved_sql_mode       = @@sql_mode */ ;\n"
+                "/*!50003 SET sql_mode              = 'ANSI_QUOTES,NO_ENGINE_SUBSTITUTION' */ ;\n"
+                "DELIMITER ;;\n"
+                "CREATE PROCEDURE p() SELECT \"a\" ;;\n"
+                "DELIMITER ;\n"
+                "/*!50003 SET sql_mode              = @saved_sql_mode */ ;\n"
+                "/*!50003 SET character_set_client  = @saved_cs_client */ ;\n"
+                "/*!50003 SET character_set_results = @saved_cs_results */ ;\n"
+                "/*!50003 SET collation_connection  = @saved_col_connection */ ;\n"
+                "\n");
+}
+
+// Events also get their time zone. An empty sql_mode is still set, it differs from the script default.
+TEST_FUNCTION(2) {
+  sql::ParallelDump::ProgramSettings settings;
+  settings.time_zone = "SYSTEM";
+  settings.character_set_client = "utf8mb4";
+  settings.collation_connection = "utf8mb4_0900_ai_ci";
+
+  std::string script =
+    sql::ParallelDump::program_script("CREATE EVENT e ON SCHEDULE EVERY 1 DAY DO DELETE FROM t", settings);
+  ensure("time zone saved", script.find("/*!50106 SET @saved_time_zone      = @@time_zone */ ;\n"
+                                        "/*!50106 SET time_zone             = 'SYSTEM' */ ;\n") != std::string::npos);
+  ensure("empty sql mode", script.find("/*!50003 SET sql_mode              = '' */ ;\n") != std::string::npos);
+  ensure("time zone restored after the definition",
+         script.find("/*!50106 SET time_zone             = @saved_time_zone */ ;\n") >
+           script.find("DELIMITER ;\n"));
+  ensure("collation", script.find("SET collation_connection  = utf8mb4_0900_ai_ci */") != std::string::npos);
+}
+
+// Without character set information (e.g. insufficient privileges) only the sql_mode is switched.
+TEST_FUNCTION(3) {
+  sql::ParallelDump::ProgramSettings settings;
+  settings.sql_mode = "NO_BACKSLASH_ESCAPES";
+
+  std::string script =
+    sql::ParallelDump::program_script("CREATE TRIGGER t BEFORE INSERT ON a FOR EACH ROW SET @x = 1", settings);
+  ensure("no charset", script.find("character_set") == std::string::npos);
+  ensure("no time zone", script.find("time_zone") == std::string::npos);
+  ensure_equals("trigger script", script,
+                "/*!50003 SET @saved_sql_mode       = @@sql_mode */ ;\n"
+                "/*!50003 SET sql_mode              = 'NO_BACKSLASH_ESCAPES' */ ;\n"
+                "DELIMITER ;;\n"
+                "CREATE TRIGGER t BEFORE INSERT ON a FOR EACH ROW SET @x = 1 ;;\n"
+                "DELIMITER ;\n"
+                "/*!50003 SET sql_mode              = @saved_sql_mode */ ;\n"
+                "\n");
+}
+
+// Signed and unsigned keys map to offsets with the same ordering, and back.
+TEST_FUNCTION(4) {
+  const unsigned long long max = std::numeric_limits<unsigned long long>::max();
+  ensure_equals("unsigned zero", sql::ParallelDump::key_to_offset("0", true), 0ULL);
+  ensure_equals("unsigned max", sql::ParallelDump::key_to_offset("18446744073709551615", true), max);
+  ensure_equals("signed min", sql::ParallelDump::key_to_offset("-9223372036854775808", false), 0ULL);
+  ensure_equals("signed zero", sql::ParallelDump::key_to_offset("0", false), 1ULL << 63);
+  ensure_equals("signed max", sql::ParallelDump::key_to_offset("9223372036854775807", false), max);
+  ensure("signed order",
+         sql::ParallelDump::key_to_offset("-1", false) < sql::ParallelDump::key_to_offset("1", false));
+
+  const char *keys[] = {"-9223372036854775808", "-1000", "-1", "0", "1", "42", "9223372036854775807"};
+  for (const char *key : keys)
+    ensure_equals("signed round trip",
+                  sql::ParallelDump::offset_to_key(sql::ParallelDump::key_to_offset(key, false), false), key);
+  const char *unsigned_keys[] = {"0", "1", "9223372036854775808", "18446744073709551615"};
+  for (const char *key : unsigned_keys)
+    ensure_equals("unsigned round trip",
+                  sql::ParallelDump::offset_to_key(sql::ParallelDump::key_to_offset(key, true), true), key);
+}
+
+// Key ranges are split into chunks of about the same size, never more than there are keys.
+TEST_FUNCTION(5) {
+  std::vector<std::string> bounds = sql::ParallelDump::chunk_bounds("1", "100", false, 4);
+  ensure_equals("bound count", bounds.size(), 3U);
+  ensure_equals("bound 1", bounds[0], "26");
+  ensure_equals("bound 2", bounds[1], "51");
+  ensure_equals("bound 3", bounds[2], "76");
+
+  ensure("single chunk", sql::ParallelDump::chunk_bounds("1", "100", false, 1).empty());
+  ensure("no rows estimated", sql::ParallelDump::chunk_bounds("1", "100", false, 0).empty());
+  ensure("single key", sql::ParallelDump::chunk_bounds("5", "5", false, 10).empty());
+
+  bounds = sql::ParallelDump::chunk_bounds("1", "3", false, 10);
+  ensure_equals("fewer keys than chunks", bounds.size(), 2U);
+  ensure_equals("fewer keys 1", bounds[0], "2");
+  ensure_equals("fewer keys 2", bounds[1], "3");
+
+  bounds = sql::ParallelDump::chunk_bounds("-10", "10", false, 2);
+  ensure_equals("negative range", bounds.size(), 1U);
+  ensure_equals("negative range bound", bounds[0], "1");
+
+  bounds = sql::ParallelDump::chunk_bounds("-9223372036854775808", "9223372036854775807", false, 2);
+  ensure_equals("full signed range", bounds.size(), 1U);
+  ensure_equals("full signed range bound", bounds[0], "0");
+
+  bounds = sql::ParallelDump::chunk_bounds("0", "18446744073709551615", true, 4);
+  ensure_equals("full unsigned range", bounds.size(), 3U);
+  ensure_equals("full unsigned range bound 1", bounds[0], "4611686018427387904");
+  ensure_equals("full unsigned range bound 3", bounds[2], "13835058055282163712");
+
+  // Bounds lie inside the range and increase strictly.
+  bounds = sql::ParallelDump::chunk_bounds("-500", "12345", false, 7);
+  ensure_equals("bound count", bounds.size(), 6U);
+  long long previous = -500;
+  for (const std::string &bound : bounds) {
+    long long value = std::stoll(bound);
+    ensure("bound increases", value > previous);
+    ensure("bound inside range", value <= 12345);
+    previous = value;
+  }
+}
+
+// The chunk conditions cover the whole key space without overlaps.
+TEST_FUNCTION(6) {
+  std::vector<std::string> conditions = sql::ParallelDump::chunk_conditions("`id`", {});
+  ensure_equals("single chunk", conditions.size(), 1U);
+  ensure_equals("no condition", conditions[0], "");
+
+  conditions = sql::ParallelDump::chunk_conditions("`id`", {"10"});
+  ensure_equals("two chunks", conditions.size(), 2U);
+  ensure_equals("first of two", conditions[0], "`id` < 10");
+  ensure_equals("last of two", conditions[1], "`id` >= 10");
+
+  conditions = sql::ParallelDump::chunk_conditions("`id`", {"10", "20", "30"});
+  ensure_equals("four chunks", conditions.size(), 4U);
+  ensure_equals("first", conditions[0], "`id` < 10");
+  ensure_equals("second", conditions[1], "`id` >= 10 AND `id` < 20");
+  ensure_equals("third", conditions[2], "`id` >= 20 AND `id` < 30");
+  ensure_equals("last", conditions[3], "`id` >= 30");
+}
+
+static const JsonParser::JsonObject &find_table(const JsonParser::JsonArray &tables, const std::string &name) {
+  for (const JsonParser::JsonValue &value : tables) {
+    const JsonParser::JsonObject &table = value;
+    if ((const std::string &)table.get("name") == name)
+      return table;
+  }
+  fail("table " + name + " missing in the manifest");
+  throw std::logic_error("not reached");
+}
+
+// A dump of empty, single row, chunked and unkeyed tables and a view, checked against its manifest.
+TEST_FUNCTION(7) {
+  db_mgmt_ConnectionRef connectionProperties(grt::Initialized);
+  setup_env(connectionProperties);
+
+  sql::DriverManager *dm = sql::DriverManager::getDriverManager();
+  std::vector<sql::ConnectionWrapper> connections;
+  connections.push_back(dm->getConnection(connectionProperties));
+  connections.push_back(dm->getConnection(connectionProperties));
+
+  std::unique_ptr<sql::Statement> stmt(connections[0]->createStatement());
+  stmt->execute("DROP SCHEMA IF EXISTS parallel_dump_test");
+  stmt->execute("CREATE SCHEMA parallel_dump_test");
+  stmt->execute("USE parallel_dump_test");
+  stmt->execute("CREATE TABLE empty_table (id INT PRIMARY KEY)");
+  stmt->execute("CREATE TABLE single_row (id INT PRIMARY KEY, name VARCHAR(10))");
+  stmt->execute("INSERT INTO single_row VALUES (7, 'seven')");
+  stmt->execute("CREATE TABLE many_rows (id INT PRIMARY KEY, data BLOB)");
+  for (int i = -50; i < 50; ++i)
+    stmt->execute("INSERT INTO many_rows VALUES (" + std::to_string(i * 3) + ", 'x')");
+  stmt->execute("CREATE TABLE no_key (name VARCHAR(10))");
+  stmt->execute("INSERT INTO no_key VALUES ('a'), ('b'), ('c')");
+  stmt->execute("CREATE VIEW a_view AS SELECT id FROM single_row");
+  stmt->execute("ANALYZE TABLE empty_table, single_row, many_rows, no_key");
+
+  std::string output_dir = "parallel_dump_test";
+  base::remove_recursive(output_dir);
+
+  sql::ParallelDump::Options options;
+  options.output_dir = output_dir;
+  options.chunk_rows = 10;
+  options.consistent = false;
+  sql::ParallelDump dump(connections, options);
+  std::vector<std::string> tables = {"empty_table", "single_row", "many_rows", "no_key", "a_view"};
+  dump.add_schema("parallel_dump_test", tables);
+  ensure_equals("dump errors", dump.run(), 0);
+
+  JsonParser::JsonValue value;
+  JsonParser::JsonReader::readFromFile(base::makePath(output_dir, "manifest.json"), value);
+  const JsonParser::JsonObject &manifest = value;
+  ensure_equals("compression", (const std::string &)manifest.get("compression"), "gzip");
+  ensure("server version", !((const std::string &)manifest.get("serverVersion")).empty());
+  ensure("character set", !((const std::string &)manifest.get("characterSet")).empty());
+  ensure_equals("manifest errors", (double)manifest.get("errors"), 0.0);
+
+  const JsonParser::JsonArray &schemas = manifest.get("schemas");
+  ensure_equals("schema count", schemas.size(), 1U);
+  const JsonParser::JsonObject &schema = schemas[0];
+  ensure_equals("schema name", (const std::string &)schema.get("name"), "parallel_dump_test");
+  ensure_equals("schema file", (const std::string &)schema.get("file"),
+                sql::ParallelDump::file_name("parallel_dump_test"));
+  ensure("schema file written",
+         base::file_exists(base::makePath(output_dir, sql::ParallelDump::file_name("parallel_dump_test"))));
+
+  const JsonParser::JsonArray &table_list = schema.get("tables");
+  ensure_equals("table count", table_list.size(), tables.size());
+  for (const std::string &name : tables) {
+    const JsonParser::JsonObject &table = find_table(table_list, name);
+    ensure_equals("table file", (const std::string &)table.get("file"),
+                  sql::ParallelDump::file_name("parallel_dump_test", name));
+    ensure("table file written", base::file_exists(base::makePath(output_dir, table.get("file"))));
+
+    const JsonParser::JsonArray &chunks = table.get("chunks");
+    double rows = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      const JsonParser::JsonObject &chunk = chunks[i];
+      ensure_equals("chunk file", (const std::string &)chunk.get("file"),
+                    sql::ParallelDump::file_name("parallel_dump_test", name, (int)i));
+      ensure("chunk file written", base::file_exists(base::makePath(output_dir, chunk.get("file"))));
+      rows += (double)chunk.get("rows");
+    }
+    ensure_equals("table rows", (double)table.get("rows"), rows);
+  }
+
+  const JsonParser::JsonObject &view = find_table(table_list, "a_view");
+  ensure_equals("view type", (const std::string &)view.get("type"), "view");
+  ensure_equals("no view data", ((const JsonParser::JsonArray &)view.get("chunks")).size(), 0U);
+
+  // Empty and single row tables end up in a single chunk without a condition.
+  const char *single_chunk_tables[] = {"empty_table", "single_row", "no_key"};
+  const double single_chunk_rows[] = {0, 1, 3};
+  for (size_t i = 0; i < 3; ++i) {
+    const JsonParser::JsonObject &table = find_table(table_list, single_chunk_tables[i]);
+    ensure_equals("table type", (const std::string &)table.get("type"), "table");
+    const JsonParser::JsonArray &chunks = table.get("chunks");
+    ensure_equals("single chunk", chunks.size(), 1U);
+    ensure_equals("no condition", (const std::string &)((const JsonParser::JsonObject &)chunks[0]).get("where"), "");
+    ensure_equals("single chunk rows", (double)table.get("rows"), single_chunk_rows[i]);
+  }
+  ensure_equals("no primary key", (const std::string &)find_table(table_list, "no_key").get("primaryKey"), "");
+
+  const JsonParser::JsonObject &many_rows = find_table(table_list, "many_rows");
+  ensure_equals("chunk key", (const std::string &)many_rows.get("primaryKey"), "id");
+  ensure_equals("all rows dumped", (double)many_rows.get("rows"), 100.0);
+  const JsonParser::JsonArray &chunks = many_rows.get("chunks");
+  ensure("split into chunks", chunks.size() > 1);
+  std::string first = ((const JsonParser::JsonObject &)chunks[0]).get("where");
+  std::string last = ((const JsonParser::JsonObject &)chunks[chunks.size() - 1]).get("where");
+  ensure("first chunk open ended", base::hasPrefix(first, "`id` < ") && first.find("AND") == std::string::npos);
+  ensure("last chunk open ended", base::hasPrefix(last, "`id` >= ") && last.find("AND") == std::string::npos);
+
+  stmt->execute("DROP SCHEMA parallel_dump_test");
+  base::remove_recursive(output_dir);
+}
+
+END_TESTS
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "sql_parallel_restore.h"
+#include "base/file_utilities.h"
+#include "base/string_utilities.h"
+#include "wb_helpers.h"
+
+#include <zlib.h>
+
+BEGIN_TEST_DATA_CLASS(module_dbc_parallel_restore_test)
+protected:
+  std::string _path;
+
+  std::vector<std::string> split(const std::string &script) {
+    base::setTextFileContent(_path, script);
+    return sql::ParallelRestore::split_script(_path);
+  }
+
+TEST_DATA_CONSTRUCTOR(module_dbc_parallel_restore_test) : _path("parallel_restore_test.sql") {
+}
+
+TEST_DATA_DESTRUCTOR(module_dbc_parallel_restore_test) {
+  base::tryRemove(_path);
+}
+
+END_TEST_DATA_CLASS
+
+TEST_MODULE(module_dbc_parallel_restore_test, "DBC: parallel restore tests");
+
+// Delimiters inside quotes and comments do not end a statement, line comments are dropped.
+TEST_FUNCTION(1) {
+  std::vector<std::string> statements = split(
+    "-- MySQL dump\n"
+    "/*!40101 SET NAMES utf8mb4 */;\n"
+    "# a comment; with a delimiter\n"
+    "INSERT INTO `t;1` VALUES ('a;b','it''s;', \"x\\\";y\");\n"
+    "  ;  ;\n"
+    "SELECT 1 /* not; the end */ FROM dual;\n"
+    "SELECT 2--3\n"
+    "  FROM dual;\n"
+    "SELECT 'no delimiter at the end'");
+  ensure_equals("statement count", statements.size(), 5U);
+  ensure_equals("versioned comment", statements[0], "/*!40101 SET NAMES utf8mb4 */");
+  ensure_equals("quotes", statements[1], "INSERT INTO `t;1` VALUES ('a;b','it''s;', \"x\\\";y\")");
+  ensure_equals("block comment", statements[2], "SELECT 1 /* not; the end */ FROM dual");
+  ensure_equals("not a line comment", statements[3], "SELECT 2--3\n  FROM dual");
+  ensure_equals("last statement", statements[4], "SELECT 'no delimiter at the end'");
+}
+
+// DELIMITER commands switch the delimiter until the next one.
+TEST_FUNCTION(2) {
+  std::vector<std::string> statements = split(
+    "/*!50003 SET sql_mode = 'ANSI_QUOTES' */ ;\n"
+    "DELIMITER ;;\n"
+    "CREATE TRIGGER t BEFORE INSERT ON a FOR EACH ROW BEGIN SET @x = 1; SET @y = 2; END ;;\n"
+    "delimiter $$\n"
+    "CREATE PROCEDURE p() BEGIN SELECT ';;'; END$$\n"
+    "DELIMITER ;\n"
+    "/*!50003 SET sql_mode = @saved_sql_mode */ ;\n");
+  ensure_equals("statement count", statements.size(), 4U);
+  ensure_equals("trigger", statements[1],
+                "CREATE TRIGGER t BEFORE INSERT ON a FOR EACH ROW BEGIN SET @x = 1; SET @y = 2; END");
+  ensure_equals("procedure", statements[2], "CREATE PROCEDURE p() BEGIN SELECT ';;'; END");
+  ensure_equals("restore", statements[3], "/*!50003 SET sql_mode = @saved_sql_mode */");
+}
+
+// Gzip compressed scripts are read the same way, also when they consist of several gzip members.
+TEST_FUNCTION(3) {
+  std::string gz_path = _path + ".gz";
+  gzFile file = gzopen(gz_path.c_str(), "wb");
+  ensure("gzip file created", file != nullptr);
+  gzputs(file, "INSERT INTO t VALUES (1),(2);\nINSERT INTO t VALUES ('");
+  gzclose(file);
+  file = gzopen(gz_path.c_str(), "ab");
+  gzputs(file, ";');\n");
+  gzclose(file);
+
+  std::vector<std::string> statements = sql::ParallelRestore::split_script(gz_path);
+  base::tryRemove(gz_path);
+  ensure_equals("statement count", statements.size(), 2U);
+  ensure_equals("first", statements[0], "INSERT INTO t VALUES (1),(2)");
+  ensure_equals("spans members", statements[1], "INSERT INTO t VALUES (';')");
+}
+
+// Secondary indexes are moved into ALTER TABLE statements, FULLTEXT indexes get one statement each.
+TEST_FUNCTION(4) {
+  std::vector<std::string> alter_statements;
+  std::string result = sql::ParallelRestore::defer_secondary_indexes(
+    "CREATE TABLE `t` (\n"
+    "  `id` int(11) NOT NULL,\n"
+    "  `name` varchar(40) DEFAULT NULL,\n"
+    "  `body` text,\n"
+    "  PRIMARY KEY (`id`),\n"
+    "  UNIQUE KEY `name_uq` (`name`),\n"
+    "  KEY `name_idx` (`name`,`id`),\n"
+    "  FULLTEXT KEY `body_ft` (`body`),\n"
+    "  FULLTEXT KEY `both_ft` (`name`,`body`)\n"
+    ") ENGINE=InnoDB DEFAULT CHARSET=utf8mb4",
+    alter_statements);
+  ensure_equals("table", result,
+                "CREATE TABLE `t` (\n"
+                "  `id` int(11) NOT NULL,\n"
+                "  `name` varchar(40) DEFAULT NULL,\n"
+                "  `body` text,\n"
+                "  PRIMARY KEY (`id`)\n"
+                ") ENGINE=InnoDB DEFAULT CHARSET=utf8mb4");
+  ensure_equals("alter count", alter_statements.size(), 3U);
+  ensure_equals("keys", alter_statements[0],
+                "ALTER TABLE `t` ADD UNIQUE KEY `name_uq` (`name`), ADD KEY `name_idx` (`name`,`id`)");
+  ensure_equals("fulltext 1", alter_statements[1], "ALTER TABLE `t` ADD FULLTEXT KEY `body_ft` (`body`)");
+  ensure_equals("fulltext 2", alter_statements[2], "ALTER TABLE `t` ADD FULLTEXT KEY `both_ft` (`name`,`body`)");
+}
+
+// The index on an AUTO_INCREMENT column stays, tables with foreign keys and without secondary indexes are
+// left alone.
+TEST_FUNCTION(5) {
+  std::vector<std::string> alter_statements;
+  std::string result = sql::ParallelRestore::defer_secondary_indexes(
+    "CREATE TABLE IF NOT EXISTS `s`.`t` (\n"
+    "  `id` int(11) NOT NULL AUTO_INCREMENT,\n"
+    "  `code` int(11) NOT NULL,\n"
+    "  PRIMARY KEY (`code`),\n"
+    "  KEY `id_idx` (`id`),\n"
+    "  KEY `code_idx` (`code`,`id`)\n"
+    ")",
+    alter_statements);
+  ensure("auto increment key kept", result.find("KEY `id_idx` (`id`)") != std::string::npos);
+  ensure_equals("alter count", alter_statements.size(), 1U);
+  ensure_equals("qualified name", alter_statements[0], "ALTER TABLE `s`.`t` ADD KEY `code_idx` (`code`,`id`)");
+
+  alter_statements.clear();
+  std::string with_fk =
+    "CREATE TABLE `c` (\n"
+    "  `id` int(11) NOT NULL,\n"
+    "  `p` int(11) DEFAULT NULL,\n"
+    "  PRIMARY KEY (`id`),\n"
+    "  KEY `p_idx` (`p`),\n"
+    "  CONSTRAINT `fk` FOREIGN KEY (`p`) REFERENCES `p` (`id`)\n"
+    ") ENGINE=InnoDB";
+  ensure_equals("foreign key", sql::ParallelRestore::defer_secondary_indexes(with_fk, alter_statements), with_fk);
+
+  std::string plain =
+    "CREATE TABLE `p` (\n"
+    "  `id` int(11) NOT NULL,\n"
+    "  PRIMARY KEY (`id`)\n"
+    ") ENGINE=InnoDB";
+  ensure_equals("nothing to defer", sql::ParallelRestore::defer_secondary_indexes(plain, alter_statements), plain);
+  ensure("no alter statements", alter_statements.empty());
+}
+
+END_TESTS
@@ -23,6 +23,7 @@
 
 #include "connection_helpers.h"
 #include "grtsqlparser/sql_facade.h"
+#include <map>
 
 #define DATABASE_TO_USE "USE test"
 
@@ -644,6 +645,107 @@ TEST_FUNCTION(16) {
   }
 }
 
+// Test SqlBatchExec with multi-statement packets: errors must be reported for the failing statement only.
+TEST_FUNCTION(17) {
+  db_mgmt_ConnectionRef connectionProperties(grt::Initialized);
+
+  setup_env(connectionProperties);
+
+  sql::DriverManager *dm = sql::DriverManager::getDriverManager();
+  sql::ConnectionWrapper wrapper = dm->getConnection(connectionProperties);
+  ensure("conn is NULL", wrapper.get() != NULL);
+
+  std::auto_ptr<sql::Statement> stmt(wrapper->createStatement());
+  stmt->execute("DROP DATABASE IF EXISTS dbc_statement_test_17");
+  stmt->execute("CREATE DATABASE dbc_statement_test_17");
+  stmt->execute("CREATE TABLE dbc_statement_test_17.t1 (id int primary key)");
+
+  ensure("INSERT is batchable", sql::SqlBatchExec::is_batchable_statement("  insert into t1 values (1)"));
+  ensure("SELECT is not batchable", !sql::SqlBatchExec::is_batchable_statement("SELECT 1"));
+  ensure("INSERTS is not batchable", !sql::SqlBatchExec::is_batchable_statement("INSERTS"));
+
+  std::list<std::string> statements;
+  statements.push_back("INSERT INTO dbc_statement_test_17.t1 VALUES (1)");
+  statements.push_back("INSERT INTO dbc_statement_test_17.t1 VALUES (2)");
+  statements.push_back("INSERT INTO dbc_statement_test_17.t1 VALUES (1)"); // Duplicate key.
+  statements.push_back("INSERT INTO dbc_statement_test_17.t1 VALUES (3)");
+  statements.push_back("UPDATE dbc_statement_test_17.t1 SET id = id + 10 WHERE id = 3");
+
+  std::list<std::string> failed_statements;
+  sql::SqlBatchExec batch_exec;
+  batch_exec.stop_on_error(false);
+  batch_exec.batch_size_limit(sql::SqlBatchExec::max_allowed_packet(wrapper.get()));
+  batch_exec.error_cb([&](long long, const std::string &, const std::string &statement) {
+    failed_statements.push_back(statement);
+    return 0;
+  });
+  ensure_equals("error count", batch_exec(stmt.get(), statements), 1L);
+  ensure_equals("failed statement count", failed_statements.size(), 1U);
+  ensure_equals("failed statement", failed_statements.front(), "INSERT INTO dbc_statement_test_17.t1 VALUES (1)");
+
+  std::auto_ptr<sql::ResultSet> rs(stmt->executeQuery("SELECT SUM(id) FROM dbc_statement_test_17.t1"));
+  ensure("result", rs->next());
+  ensure_equals("rows after batch", rs->getInt(1), 16);
+
+  stmt->execute("DROP DATABASE IF EXISTS dbc_statement_test_17");
+}
+
+TEST_FUNCTION(18) {
+  db_mgmt_ConnectionRef connectionProperties(grt::Initialized);
+
+  setup_env(connectionProperties);
+
+  sql::DriverManager *dm = sql::DriverManager::getDriverManager();
+  sql::ConnectionWrapper wrapper = dm->getConnection(connectionProperties);
+  ensure("conn is NULL", wrapper.get() != NULL);
+
+  std::auto_ptr<sql::Statement> stmt(wrapper->createStatement());
+  stmt->execute("DROP DATABASE IF EXISTS dbc_statement_test_18");
+  stmt->execute("CREATE DATABASE dbc_statement_test_18");
+  stmt->execute("CREATE TABLE dbc_statement_test_18.t1 (id int primary key) ENGINE=InnoDB");
+  stmt->execute("INSERT INTO dbc_statement_test_18.t1 VALUES (2)");
+
+  // A failing merged statement is run again as its parts and the error is reported for the part that failed.
+  std::map<std::string, std::list<std::string> > merged;
+  std::string merged_insert = "INSERT INTO dbc_statement_test_18.t1 VALUES (1), (2), (3)";
+  merged[merged_insert].push_back("INSERT INTO dbc_statement_test_18.t1 VALUES (1)");
+  merged[merged_insert].push_back("INSERT INTO dbc_statement_test_18.t1 VALUES (2)");
+  merged[merged_insert].push_back("INSERT INTO dbc_statement_test_18.t1 VALUES (3)");
+
+  std::list<std::string> statements;
+  statements.push_back("INSERT INTO dbc_statement_test_18.t1 VALUES (10)");
+  statements.push_back(merged_insert);
+  statements.push_back("INSERT INTO dbc_statement_test_18.t1 VALUES (20)");
+
+  for (size_t batch_size_limit = 0; batch_size_limit <= 1024 * 1024; batch_size_limit += 1024 * 1024) {
+    stmt->execute("DELETE FROM dbc_statement_test_18.t1 WHERE id <> 2");
+
+    std::list<std::string> failed_statements;
+    sql::SqlBatchExec batch_exec;
+    batch_exec.stop_on_error(false);
+    batch_exec.batch_size_limit(batch_size_limit);
+    batch_exec.error_cb([&](long long, const std::string &, const std::string &statement) {
+      failed_statements.push_back(statement);
+      return 0;
+    });
+    batch_exec.split_cb([&](const std::string &statement, std::list<std::string> &parts) {
+      if (merged.find(statement) == merged.end())
+        return false;
+      parts = merged[statement];
+      return true;
+    });
+    ensure_equals("error count", batch_exec(stmt.get(), statements), 1L);
+    ensure_equals("failed statement count", failed_statements.size(), 1U);
+    ensure_equals("failed statement", failed_statements.front(), "INSERT INTO dbc_statement_test_18.t1 VALUES (2)");
+
+    std::auto_ptr<sql::ResultSet> rs(stmt->executeQuery("SELECT SUM(id) FROM dbc_statement_test_18.t1"));
+    ensure("result", rs->next());
+    ensure_equals("rows after batch", rs->getInt(1), 36);
+  }
+
+  stmt->execute("DROP DATABASE IF EXISTS dbc_statement_test_18");
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
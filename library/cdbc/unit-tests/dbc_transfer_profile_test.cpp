@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "driver_manager.h"
+#include "wb_helpers.h"
+
+BEGIN_TEST_DATA_CLASS(module_dbc_transfer_profile_test)
+protected:
+  sql::TransferProfile profile(const std::string &compression, int zstdLevel = 0) {
+    sql::TransferProfile result;
+    result.name = "test";
+    result.compression = compression;
+    result.zstdLevel = zstdLevel;
+    return result;
+  }
+
+  std::string string_option(sql::ConnectOptionsMap &properties, const std::string &name) {
+    sql::ConnectOptionsMap::iterator iter = properties.find(name);
+    if (iter == properties.end() || iter->second.get<sql::SQLString>() == NULL)
+      return "";
+    return iter->second.get<sql::SQLString>()->asStdString();
+  }
+
+  int int_option(sql::ConnectOptionsMap &properties, const std::string &name) {
+    sql::ConnectOptionsMap::iterator iter = properties.find(name);
+    if (iter == properties.end() || iter->second.get<int>() == NULL)
+      return -1;
+    return *iter->second.get<int>();
+  }
+END_TEST_DATA_CLASS
+
+TEST_MODULE(module_dbc_transfer_profile_test, "DBC: transfer profiles");
+
+// The default profile adds nothing.
+TEST_FUNCTION(1) {
+  sql::ConnectOptionsMap properties;
+  sql::DriverManager::applyTransferProfile(profile(""), 80018, properties);
+  ensure("no options", properties.empty());
+}
+
+// zlib only needs the capability flag, on new connectors the algorithm is named as well.
+TEST_FUNCTION(2) {
+  sql::ConnectOptionsMap properties;
+  sql::DriverManager::applyTransferProfile(profile("zlib"), 10109, properties);
+  ensure("compress flag", properties.find("CLIENT_COMPRESS") != properties.end());
+  ensure_equals("old connector", properties.count("OPT_COMPRESSION_ALGORITHMS"), (size_t)0);
+
+  properties.clear();
+  sql::DriverManager::applyTransferProfile(profile("zlib"), 80018, properties);
+  ensure("compress flag", properties.find("CLIENT_COMPRESS") != properties.end());
+  ensure_equals("algorithms", string_option(properties, "OPT_COMPRESSION_ALGORITHMS"), "zlib");
+}
+
+// zstd keeps zlib as fallback and passes the level on, connectors before 8.0.18 get plain compression.
+TEST_FUNCTION(3) {
+  sql::ConnectOptionsMap properties;
+  sql::DriverManager::applyTransferProfile(profile("zstd", 3), 80018, properties);
+  ensure_equals("algorithms", string_option(properties, "OPT_COMPRESSION_ALGORITHMS"), "zstd,zlib");
+  ensure_equals("level", int_option(properties, "OPT_ZSTD_COMPRESSION_LEVEL"), 3);
+
+  properties.clear();
+  sql::DriverManager::applyTransferProfile(profile("zstd"), 80020, properties);
+  ensure_equals("algorithms", string_option(properties, "OPT_COMPRESSION_ALGORITHMS"), "zstd,zlib");
+  ensure_equals("default level", properties.count("OPT_ZSTD_COMPRESSION_LEVEL"), (size_t)0);
+
+  properties.clear();
+  sql::DriverManager::applyTransferProfile(profile("zstd", 3), 80017, properties);
+  ensure("compress flag", properties.find("CLIENT_COMPRESS") != properties.end());
+  ensure_equals("no algorithms", properties.count("OPT_COMPRESSION_ALGORITHMS"), (size_t)0);
+  ensure_equals("no level", properties.count("OPT_ZSTD_COMPRESSION_LEVEL"), (size_t)0);
+}
+
+// Buffer sizes are set from the profile unless the connection already has them.
+TEST_FUNCTION(4) {
+  sql::TransferProfile bulk = profile("");
+  bulk.netBufferLength = 1024 * 1024;
+  bulk.maxAllowedPacket = 1024 * 1024 * 1024;
+
+  sql::ConnectOptionsMap properties;
+  sql::DriverManager::applyTransferProfile(bulk, 80018, properties);
+  ensure_equals("net buffer", int_option(properties, "OPT_NET_BUFFER_LENGTH"), 1024 * 1024);
+  ensure_equals("max packet", int_option(properties, "OPT_MAX_ALLOWED_PACKET"), 1024 * 1024 * 1024);
+  ensure_equals("no compression", properties.count("CLIENT_COMPRESS"), (size_t)0);
+
+  properties.clear();
+  properties["OPT_NET_BUFFER_LENGTH"] = 16384;
+  sql::DriverManager::applyTransferProfile(bulk, 80018, properties);
+  ensure_equals("explicit net buffer", int_option(properties, "OPT_NET_BUFFER_LENGTH"), 16384);
+  ensure_equals("max packet", int_option(properties, "OPT_MAX_ALLOWED_PACKET"), 1024 * 1024 * 1024);
+}
+
+// The built-in profiles exist and unknown names fall back to the default.
+TEST_FUNCTION(5) {
+  sql::DriverManager *dm = sql::DriverManager::getDriverManager();
+  ensure_equals("zstd profile", dm->getTransferProfile("zstd").compression, "zstd");
+  ensure("bulk streams", dm->getTransferProfile("bulk").streamResults);
+  ensure_equals("fallback", dm->getTransferProfile("no such profile").name, "default");
+}
+
+END_TESTS
@@ -31,6 +31,7 @@
 #include "diffchange.h"
 #include "changefactory.h"
 #include "grtlistdiff.h"
+#include "grtdiffhash.h"
 #include "grtpp_util.h"
 
 #include "grts/structs.h"
@@ -151,6 +152,13 @@ namespace grt {
         return std::shared_ptr<DiffChange>();
     }
 
+    // Objects with identical content hashes can't have any differences. The hashes are cached in the objects,
+    // so this is cheap for unchanged subtrees of long lived catalogs (e.g. the model side of a sync).
+    DiffHasher hasher(omf->dontdiff_mask);
+    uint64_t source_hash, target_hash;
+    if (hasher.hash(source, source_hash) && hasher.hash(target, target_hash) && source_hash == target_hash)
+      return std::shared_ptr<DiffChange>();
+
     // Compare all members of the objects with each other, looking for any differences
     do {
       for (MetaClass::MemberList::const_iterator iter = meta->get_members_partial().begin();
@@ -165,8 +173,8 @@ namespace grt {
         if (dontdiff)
           continue;
 
-        ValueRef v1 = source.get_member(name);
-        ValueRef v2 = target.get_member(name);
+        ValueRef v1 = source->get_member(iter->second.id);
+        ValueRef v2 = target->get_member(iter->second.id);
 
         if (!v1.is_valid() && !v2.is_valid())
           continue;
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+
+#include <string.h>
+
+#include "base/util_functions.h"
+
+#include "grtdiffhash.h"
+#include "grtpp_util.h"
+#include "grts/structs.h"
+
+namespace {
+
+  enum HashTag {
+    NullTag = 1,
+    IntegerTag,
+    DoubleTag,
+    StringTag,
+    ListTag,
+    DictTag,
+    ObjectTag,
+    ReferenceTag
+  };
+
+  // splitmix64 finalizer, spreads the combined bits over the whole result.
+  inline uint64_t mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+  }
+
+  inline void combine(uint64_t &seed, uint64_t value) {
+    seed = mix(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+  }
+
+  // 64 bit FNV-1a.
+  inline uint64_t hash_string(const std::string &value) {
+    uint64_t result = 0xcbf29ce484222325ULL;
+    for (std::string::const_iterator iter = value.begin(); iter != value.end(); ++iter) {
+      result ^= (unsigned char)*iter;
+      result *= 0x100000001b3ULL;
+    }
+    return result;
+  }
+
+  inline std::string string_member(grt::internal::Object *object, const std::string &name) {
+    if (!object->has_member(name))
+      return "";
+    grt::ValueRef value(object->get_member(name));
+    return value.is_valid() && value.type() == grt::StringType ? *grt::StringRef::cast_from(value) : "";
+  }
+
+  inline grt::internal::Object *owner_of(grt::internal::Object *object) {
+    if (!object->has_member("owner"))
+      return nullptr;
+    grt::ValueRef owner(object->get_member("owner"));
+    return owner.is_valid() && owner.type() == grt::ObjectType ? static_cast<grt::internal::Object *>(owner.valueptr())
+                                                                : nullptr;
+  }
+}
+
+using namespace grt;
+
+//--------------------------------------------------------------------------------------------------
+
+bool DiffHasher::hash(const ValueRef &value, uint64_t &result) {
+  bool cacheable = true;
+
+  // The identity of the top level object is not hashed, GrtDiff compares it with whatever it was matched to.
+  if (value.is_valid() && value.type() == ObjectType)
+    return hash_object(static_cast<internal::Object *>(value.valueptr()), result, cacheable);
+  return hash_value(value, false, nullptr, result, cacheable);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Hashes the members of the object the same way GrtDiff::on_object walks them. The result is cached in the object
+ * unless it depends on something outside of the object's owned subtree.
+ */
+bool DiffHasher::hash_object(internal::Object *object, uint64_t &result, bool &cacheable) {
+  if (object->get_cached_diff_hash(_dontdiff_mask, result))
+    return true;
+
+  // Only possible with broken ownership, such values are diffed the old way.
+  if (_visiting.find(object) != _visiting.end())
+    return false;
+  _visiting.insert(object);
+
+  bool object_cacheable = true;
+  bool success = true;
+  std::vector<internal::Object *> name_sources;
+  uint64_t hash = ObjectTag;
+  combine(hash, hash_string(object->class_name()));
+
+  MetaClass *meta = object->get_metaclass();
+  do {
+    for (MetaClass::MemberList::const_iterator iter = meta->get_members_partial().begin();
+         success && iter != meta->get_members_partial().end(); ++iter) {
+      if (iter->second.overrides)
+        continue;
+
+      const std::string &name = iter->second.name;
+      std::string attr = meta->get_member_attribute(name, "dontdiff");
+      if (attr.size() && (base::atoi<int>(attr, 0) & _dontdiff_mask))
+        continue;
+
+      combine(hash, hash_string(name));
+
+      ValueRef value(object->get_member(iter->second.id));
+      if (!value.is_valid()) {
+        combine(hash, NullTag);
+        continue;
+      }
+
+      // Same rule as in GrtDiff::on_object.
+      const bool dontfollow =
+        !iter->second.owned_object && (name != "flags") && (name != "columns" || meta->is_a("db.Index"));
+      uint64_t member_hash = 0;
+      if (dontfollow && GrtObjectRef::can_wrap(value)) {
+        member_hash = ReferenceTag;
+        hash_identity(static_cast<internal::Object *>(value.valueptr()), member_hash, &name_sources);
+      } else if (dontfollow && value.type() == ObjectType) {
+        // Compared as a simple value, which always reports a change.
+        success = false;
+      } else if (dontfollow && !is_simple_type(value.type())) {
+        // Containers which are not followed never produce changes.
+        member_hash = value.type();
+      } else
+        success = hash_value(value, iter->second.owned_object, object, member_hash, object_cacheable);
+
+      combine(hash, member_hash);
+    }
+    meta = meta->parent();
+  } while (success && meta != nullptr);
+
+  _visiting.erase(object);
+
+  if (!success)
+    return false;
+
+  if (object_cacheable)
+    object->set_cached_diff_hash(_dontdiff_mask, hash, name_sources);
+  else
+    cacheable = false;
+  result = hash;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Adds what list diffing matches objects by: the name and old name of the object and of its owner.
+ * The objects whose names were used are added to name_sources, if given.
+ */
+void DiffHasher::hash_identity(internal::Object *object, uint64_t &seed,
+                               std::vector<internal::Object *> *name_sources) {
+  for (int level = 0; level < 2 && object != nullptr; ++level) {
+    combine(seed, hash_string(string_member(object, "name")));
+    combine(seed, hash_string(string_member(object, "oldName")));
+    if (name_sources != nullptr)
+      name_sources->push_back(object);
+    object = owner_of(object);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool DiffHasher::hash_value(const ValueRef &value, bool owned, internal::Object *parent, uint64_t &result,
+                            bool &cacheable) {
+  if (!value.is_valid()) {
+    result = NullTag;
+    return true;
+  }
+
+  switch (value.type()) {
+    case IntegerType:
+      result = IntegerTag;
+      combine(result, (uint64_t)*IntegerRef::cast_from(value));
+      return true;
+
+    case DoubleType: {
+      double d = *DoubleRef::cast_from(value);
+      uint64_t bits;
+      memcpy(&bits, &d, sizeof(bits));
+      result = DoubleTag;
+      combine(result, bits);
+      return true;
+    }
+
+    case StringType:
+      result = StringTag;
+      combine(result, hash_string(*StringRef::cast_from(value)));
+      return true;
+
+    case ListType: {
+      internal::List *list = static_cast<internal::List *>(value.valueptr());
+      // Changes in plain lists are not reported to the owning object.
+      if (dynamic_cast<internal::OwnedList *>(list) == nullptr)
+        cacheable = false;
+
+      result = ListTag;
+      combine(result, list->content_type());
+      combine(result, hash_string(list->content_class_name()));
+      combine(result, list->count());
+      for (size_t i = 0; i < list->count(); ++i) {
+        uint64_t item_hash;
+        if (!hash_value(list->get(i), owned, parent, item_hash, cacheable))
+          return false;
+        combine(result, item_hash);
+      }
+      return true;
+    }
+
+    case DictType: {
+      internal::Dict *dict = static_cast<internal::Dict *>(value.valueptr());
+      if (dynamic_cast<internal::OwnedDict *>(dict) == nullptr)
+        cacheable = false;
+
+      result = DictTag;
+      combine(result, dict->content_type());
+      combine(result, dict->count());
+      for (internal::Dict::const_iterator iter = dict->begin(); iter != dict->end(); ++iter) {
+        uint64_t item_hash;
+        if (!hash_value(iter->second, false, parent, item_hash, cacheable))
+          return false;
+        combine(result, hash_string(iter->first));
+        combine(result, item_hash);
+      }
+      return true;
+    }
+
+    case ObjectType: {
+      internal::Object *object = static_cast<internal::Object *>(value.valueptr());
+      uint64_t object_hash;
+      if (!hash_object(object, object_hash, cacheable))
+        return false;
+
+      result = ObjectTag;
+      combine(result, object_hash);
+      hash_identity(object, result);
+
+      // Changes of the object only reach the parent's cache if the parent owns it.
+      if (!owned || owner_of(object) != parent)
+        cacheable = false;
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include <set>
+#include <vector>
+
+#include "grt.h"
+
+namespace grt {
+
+  /**
+   * Structural content hashes of GRT values as compared by GrtDiff.
+   *
+   * Object hashes cover exactly the members GrtDiff looks at: members excluded by the dontdiff mask are left out
+   * and references GrtDiff does not follow only contribute the identity (name, old name and owner names) of the
+   * referenced object. List items contribute their identity as well, since that is what list diffing matches them
+   * by. Two objects with the same hash therefore cannot produce any change and GrtDiff skips them without walking
+   * their members.
+   * Omf normalizations (case folding, SQL normalization etc.) are not applied, values which only compare equal
+   * after normalization get different hashes and are diffed as before.
+   *
+   * Object hashes are cached in the objects and dropped through the object change notifications. Renaming or
+   * moving a referenced object drops the hashes of the objects referencing it. Hashes that depend on objects
+   * outside of the owned subtree (lists of references) are computed on each request.
+   */
+  class MYSQLGRT_PUBLIC DiffHasher {
+  public:
+    DiffHasher(unsigned int dontdiff_mask) : _dontdiff_mask(dontdiff_mask) {
+    }
+
+    // Returns false if the value has no usable hash (e.g. reference cycles or members that always compare as
+    // changed), in which case the value must be diffed member by member.
+    bool hash(const ValueRef &value, uint64_t &result);
+
+  private:
+    unsigned int _dontdiff_mask;
+    std::set<internal::Object *> _visiting;
+
+    bool hash_object(internal::Object *object, uint64_t &result, bool &cacheable);
+    void hash_identity(internal::Object *object, uint64_t &seed,
+                       std::vector<internal::Object *> *name_sources = nullptr);
+    bool hash_value(const ValueRef &value, bool owned, internal::Object *parent, uint64_t &result, bool &cacheable);
+  };
+}
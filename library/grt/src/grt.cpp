@@ -32,11 +32,14 @@
 #include "grtpp_util.h"
 #include "grtpp_shell.h"
 #include "grtpp_module_cpp.h"
+#include "grtpp_module_cache.h"
+#include "grtpp_metaclass_cache.h"
 #include "grtpp_undo_manager.h"
 #include "grtpp_notifications.h"
 
 #include <cppconn/exception.h>
 #include <algorithm>
+#include <memory>
 #include <glib.h>
 
 #include "serializer.h"
@@ -252,6 +255,8 @@ StringRef StringRef::format(const char *format, ...) {
 
 GRT::GRT() : _check_serialized_crc(false), _verbose(false), _testing(false) {
   _scanning_modules = false;
+  _module_cache = NULL;
+  _use_metaclass_cache = getenv("WB_NO_STRUCT_CACHE") == NULL;
 
   _tracking_changes = 0;
   _shell = 0;
@@ -404,16 +409,33 @@ int GRT::scan_metaclasses_in(const std::string &directory, std::multimap<std::st
   if (!dir)
     throw grt::os_error("Invalid path " + directory);
 
+  // Struct files with an up to date entry in the binary cache don't need to be parsed.
+  std::unique_ptr<MetaClassCache> cache;
+  if (_use_metaclass_cache) {
+    char *cache_path = g_build_filename(directory.c_str(), MetaClassCache::file_name, NULL);
+    if (g_file_test(cache_path, G_FILE_TEST_EXISTS)) {
+      cache.reset(new MetaClassCache(cache_path));
+      if (!cache->open())
+        cache.reset();
+    }
+    g_free(cache_path);
+  }
+
   while ((entry = g_dir_read_name(dir)) != NULL) {
     if ((g_str_has_prefix(entry, "structs.")) && (g_str_has_suffix(entry, ".xml"))) {
       char *path = g_build_filename(directory.c_str(), entry, NULL);
       std::list<std::string> reqs;
+      std::list<MetaClass *> cached;
 
       reqs.clear();
       try {
-        load_metaclasses(path, &reqs);
+        if (cache && cache->load(path, cached, &reqs))
+          _metaclasses_list.insert(_metaclasses_list.end(), cached.begin(), cached.end());
+        else
+          load_metaclasses(path, &reqs);
       } catch (...) {
         g_free(path);
+        g_dir_close(dir);
         throw;
       }
 
@@ -428,6 +450,10 @@ int GRT::scan_metaclasses_in(const std::string &directory, std::multimap<std::st
 
   g_dir_close(dir);
 
+  if (cache)
+    logDebug("Struct files in %s: %i from cache, %i parsed\n", directory.c_str(), (int)cache->hits(),
+             (int)cache->misses());
+
   return (int)(_metaclasses.size() - old_count);
 }
 
@@ -487,6 +513,9 @@ void GRT::end_loading_metaclasses(bool check_class_binding) {
   // register GRT object classes
   internal::ClassRegistry::get_instance()->register_all();
 
+  for (std::map<std::string, MetaClass *>::iterator iter = _metaclasses.begin(); iter != _metaclasses.end(); ++iter)
+    iter->second->build_member_index();
+
   if (check_class_binding) {
     // check if there are any metaclasses with unbound members
     for (std::map<std::string, MetaClass *>::iterator iter = _metaclasses.begin(); iter != _metaclasses.end(); ++iter) {
@@ -656,8 +685,17 @@ bool GRT::load_module(const std::string &path, const std::string &basePath, bool
     if ((*loader)->check_file_extension(path)) {
       logDebug2("Trying to load module '%s' (%s)\n", shortendPath.c_str(), (*loader)->get_loader_name().c_str());
 
+      // A forced refresh always loads the module file, as it is usually done after a file was replaced.
+      Module *module = NULL;
+      bool cached = false;
+      if (_module_cache != NULL && !refresh) {
+        module = _module_cache->create_module(*loader, path);
+        cached = module != NULL;
+      }
+
       // Problems, if any, are logged in init_module.
-      Module *module = (*loader)->init_module(path);
+      if (module == NULL)
+        module = (*loader)->init_module(path);
       if (module) {
         try {
           if (refresh)
@@ -669,6 +707,8 @@ bool GRT::load_module(const std::string &path, const std::string &basePath, bool
           delete module;
           throw;
         }
+        if (_module_cache != NULL && !cached)
+          _module_cache->store(module, path);
         return true;
       }
     }
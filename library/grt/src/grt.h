@@ -1816,6 +1816,7 @@ namespace grt {
    */
   struct MYSQLGRT_PUBLIC ClassMember {
     std::string name;
+    MemberId id = InvalidMemberId; //!< interned name, for the MemberId based accessors
     TypeSpec type;
     std::string default_value;
     bool read_only;            //!< member not directly settable (setter still needed for unserializing)
@@ -1955,6 +1956,15 @@ namespace grt {
     */
     template <typename TPred>
     bool foreach_member(TPred pred) {
+      if (!_visible_members.empty()) {
+        for (std::vector<const Member *>::const_iterator mem = _visible_members.begin(); mem != _visible_members.end();
+             ++mem) {
+          if (!pred(*mem))
+            return false;
+        }
+        return true;
+      }
+
       // set of already seen members (only overridden ones)
       std::set<std::string> seen;
       MetaClass *mc = this;
@@ -2077,6 +2087,22 @@ namespace grt {
     ValueRef call_method(internal::Object *object, const std::string &name, const BaseListRef &args);
     ValueRef call_method(internal::Object *object, const Method *method, const BaseListRef &args);
 
+    /** Member name interning.
+     *
+     * Every member name gets a small integer id when structs are loaded, which is stored in Member::id.
+     * The MemberId overloads below look members up in a flat index instead of walking the name maps of the
+     * class hierarchy. Interning is only done while loading structs, lookup_member_id() and member_name() can
+     * be used from any thread.
+     */
+    static MemberId intern_member(const std::string &name);
+    static bool lookup_member_id(const std::string &name, MemberId &id);
+    static const std::string &member_name(MemberId id);
+
+    bool has_member(MemberId member) const;
+    const Member *get_member_info(MemberId member) const;
+    void set_member_value(internal::Object *object, MemberId member, const ValueRef &value);
+    ValueRef get_member_value(const internal::Object *object, MemberId member);
+
     ObjectRef allocate();
 
   public:
@@ -2108,6 +2134,8 @@ namespace grt {
     }
 
     void set_member_internal(internal::Object *object, const std::string &name, const ValueRef &value, bool force);
+    void set_member_internal(internal::Object *object, MemberId member, const ValueRef &value, bool force);
+    void build_member_index();
 
   public: // for use by Objects during registration
     void bind_allocator(Allocator alloc);
@@ -2120,6 +2148,7 @@ namespace grt {
   protected:
     friend class Serializer;
     friend class Unserializer;
+    friend class MetaClassCache;
 
     MetaClass();
     void load_xml(xmlNodePtr node);
@@ -2139,6 +2168,16 @@ namespace grt {
     SignalList _signals;
     ValidatorList _validators;
 
+    struct IndexedMember {
+      MemberId id;
+      const Member *info;   //!< what get_member_info() returns
+      const Member *getter; //!< member whose property get_member_value() uses
+      const Member *setter; //!< member whose property set_member_value() uses, 0 if left to the name lookup
+    };
+    std::vector<IndexedMember> _member_index;     //!< sorted by id, see build_member_index()
+    std::vector<const Member *> _visible_members; //!< in foreach_member() order
+    const IndexedMember *find_indexed_member(MemberId id) const;
+
     unsigned int _crc32;
 
     bool _bound;
@@ -2213,6 +2252,11 @@ namespace grt {
     virtual void closeModule() noexcept {
     }
 
+    //! Returns the module implementing the functions. Differs from this for modules whose loading was deferred.
+    virtual Module *resolve() {
+      return this;
+    }
+
     std::string name() const {
       return _name;
     }
@@ -2398,6 +2442,7 @@ namespace grt {
   class UndoManager;
   class Shell;
   class ModuleWrapper;
+  class ModuleCache;
   class CPPModuleLoader;
   class Interface;
 
@@ -2451,6 +2496,12 @@ namespace grt {
      * files is stored
      */
     int scan_metaclasses_in(const std::string &dir, std::multimap<std::string, std::string> *requires = 0);
+    /** Whether scan_metaclasses_in() takes struct files from a MetaClassCache found in the directory.
+     * Enabled by default, unless the WB_NO_STRUCT_CACHE environment variable is set.
+     */
+    void use_metaclass_cache(bool flag) {
+      _use_metaclass_cache = flag;
+    }
     /** End loading of metaclass definition files.
      * Finishes up loading of metaclass definition XMLs files. This will
      * check that all metaclasses referred by something were loaded. It will
@@ -2520,6 +2571,15 @@ namespace grt {
 
     void add_module_loader(ModuleLoader *loader);
     bool load_module(const std::string &path, const std::string &basePath, bool refresh);
+
+    // When set, scanned modules with an up to date cache entry are registered without loading them.
+    // The cache is not owned by the GRT.
+    void set_module_cache(ModuleCache *cache) {
+      _module_cache = cache;
+    }
+    ModuleCache *get_module_cache() const {
+      return _module_cache;
+    }
     void end_loading_modules();
 
     ModuleLoader *get_module_loader(const std::string &name);
@@ -2567,7 +2627,7 @@ namespace grt {
         instance->init_module();
         register_new_module(instance);
       } else {
-        instance = dynamic_cast<ModuleImplClass *>(module);
+        instance = dynamic_cast<ModuleImplClass *>(module->resolve());
         if (!instance)
           return 0;
       }
@@ -2576,11 +2636,12 @@ namespace grt {
     }
 
     // locate an instance of a module. suitable for direct access to modules
+    // Use this instead of casting the result of get_module(), which can be a CachedModule that was not loaded yet.
     template <class ModuleImplClass>
     ModuleImplClass *find_native_module(const char *name) {
       Module *module = get_module(name);
 
-      return static_cast<ModuleImplClass *>(module);
+      return dynamic_cast<ModuleImplClass *>(module ? module->resolve() : NULL);
     }
 
     std::vector<Module *> find_modules_matching(const std::string &interface_name, const std::string &name_pattern);
@@ -2697,6 +2758,7 @@ namespace grt {
 
   protected:
     friend class MetaClass;
+    friend class MetaClassCache;
 
     std::map<std::string, ObjectRef> _objects_cache;
 
@@ -2709,6 +2771,8 @@ namespace grt {
 
     std::list<ModuleLoader *> _loaders;
     std::vector<Module *> _modules;
+    ModuleCache *_module_cache;
+    bool _use_metaclass_cache;
     std::map<std::string, Interface *> _interfaces;
     std::map<std::string, ModuleWrapper *> _cached_module_wrapper;
 
@@ -26,6 +26,8 @@
 #include "base/log.h"
 #include <glib.h>
 #include <algorithm>
+#include <deque>
+#include <unordered_map>
 
 DEFAULT_LOG_DOMAIN(DOMAIN_GRT)
 
@@ -361,6 +363,7 @@ void MetaClass::load_xml(xmlNodePtr node) {
           std::string type = get_prop(member_node, "type");
 
           member.name = get_prop(member_node, "name");
+          member.id = intern_member(member.name);
           member.default_value = get_prop(member_node, "default");
 
           if (!get_prop(member_node, "dontfollow").empty())
@@ -777,6 +780,150 @@ const MetaClass::Member *MetaClass::get_member_info(const std::string &member) c
   return &mem->second;
 }
 
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+  struct MemberNames {
+    std::unordered_map<std::string, MemberId> ids;
+    std::deque<std::string> names; // indexed by id, a deque keeps references valid while growing
+  };
+
+  MemberNames &member_names() {
+    static MemberNames names;
+    return names;
+  }
+}
+
+MemberId MetaClass::intern_member(const std::string &name) {
+  MemberNames &names = member_names();
+  std::unordered_map<std::string, MemberId>::const_iterator iter = names.ids.find(name);
+  if (iter != names.ids.end())
+    return iter->second;
+
+  MemberId id = (MemberId)names.names.size();
+  names.names.push_back(name);
+  names.ids[name] = id;
+  return id;
+}
+
+bool MetaClass::lookup_member_id(const std::string &name, MemberId &id) {
+  const MemberNames &names = member_names();
+  std::unordered_map<std::string, MemberId>::const_iterator iter = names.ids.find(name);
+  if (iter == names.ids.end())
+    return false;
+  id = iter->second;
+  return true;
+}
+
+const std::string &MetaClass::member_name(MemberId id) {
+  const MemberNames &names = member_names();
+  if (id >= names.names.size())
+    throw bad_item("member id " + std::to_string(id));
+  return names.names[id];
+}
+
+/**
+ * Builds the flat member index used by the MemberId accessors and the member list for foreach_member().
+ * Must be called after validate() (which sets the overrides flags) for this class and its parents and after
+ * the C++ classes were registered. The GRT does that for all classes in end_loading_metaclasses(). Members
+ * whose lookup depends on things not known yet (unbound properties) are left to the name based lookup.
+ */
+void MetaClass::build_member_index() {
+  _member_index.clear();
+  _visible_members.clear();
+
+  std::set<MemberId> ids;
+  for (const MetaClass *mc = this; mc != nullptr; mc = mc->_parent) {
+    for (MemberList::const_iterator mem = mc->_members.begin(); mem != mc->_members.end(); ++mem) {
+      if (mem->second.id == InvalidMemberId)
+        throw std::logic_error("Member " + mc->_name + "::" + mem->first + " was not interned");
+      if (ids.insert(mem->second.id).second)
+        _visible_members.push_back(&mem->second);
+    }
+  }
+
+  _member_index.reserve(ids.size());
+  for (std::set<MemberId>::const_iterator id = ids.begin(); id != ids.end(); ++id) {
+    IndexedMember entry;
+    entry.id = *id;
+    entry.info = nullptr;
+    entry.getter = nullptr;
+    entry.setter = nullptr;
+
+    // Same resolution as in get_member_info(), get_member_value() and set_member_internal().
+    bool setter_done = false;
+    const std::string &name = member_name(*id);
+    for (const MetaClass *mc = this; mc != nullptr; mc = mc->_parent) {
+      MemberList::const_iterator mem = mc->_members.find(name);
+      if (mem == mc->_members.end())
+        continue;
+
+      const Member *member = &mem->second;
+      if (entry.info == nullptr)
+        entry.info = member;
+      if (member->overrides)
+        continue;
+
+      if (entry.getter == nullptr)
+        entry.getter = member;
+      if (!setter_done) {
+        if (member->property == nullptr)
+          setter_done = true;
+        else if (member->property->has_setter()) {
+          entry.setter = member;
+          setter_done = true;
+        }
+      }
+    }
+    _member_index.push_back(entry);
+  }
+}
+
+const MetaClass::IndexedMember *MetaClass::find_indexed_member(MemberId id) const {
+  std::vector<IndexedMember>::const_iterator iter =
+    std::lower_bound(_member_index.begin(), _member_index.end(), id,
+                     [](const IndexedMember &entry, MemberId id) { return entry.id < id; });
+  if (iter == _member_index.end() || iter->id != id)
+    return nullptr;
+  return &*iter;
+}
+
+bool MetaClass::has_member(MemberId member) const {
+  if (_member_index.empty())
+    return has_member(member_name(member));
+  return find_indexed_member(member) != nullptr;
+}
+
+const MetaClass::Member *MetaClass::get_member_info(MemberId member) const {
+  if (_member_index.empty())
+    return get_member_info(member_name(member));
+
+  const IndexedMember *entry = find_indexed_member(member);
+  return entry != nullptr ? entry->info : nullptr;
+}
+
+ValueRef MetaClass::get_member_value(const internal::Object *object, MemberId member) {
+  const IndexedMember *entry = find_indexed_member(member);
+  if (entry == nullptr || entry->getter == nullptr || entry->getter->property == nullptr)
+    return get_member_value(object, member_name(member)); // also reports errors
+  return entry->getter->property->get(object);
+}
+
+void MetaClass::set_member_value(internal::Object *object, MemberId member, const ValueRef &value) {
+  set_member_internal(object, member, value, false);
+}
+
+void MetaClass::set_member_internal(internal::Object *object, MemberId member, const ValueRef &value, bool force) {
+  const IndexedMember *entry = find_indexed_member(member);
+  if (entry == nullptr || entry->setter == nullptr || (entry->setter->read_only && !force)) {
+    set_member_internal(object, member_name(member), value, force); // also reports errors
+    return;
+  }
+  entry->setter->property->set(object, value);
+}
+
+//--------------------------------------------------------------------------------------------------
+
 const MetaClass::Method *MetaClass::get_method_info(const std::string &method) const {
   const MetaClass *mc = this;
   MethodList::const_iterator mem, end;
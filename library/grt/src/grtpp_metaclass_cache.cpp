@@ -0,0 +1,586 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+
+#include "grtpp_metaclass_cache.h"
+#include "grtpp_util.h"
+#include "base/file_functions.h"
+#include "base/file_utilities.h"
+#include "base/log.h"
+
+#include <cstring>
+
+DEFAULT_LOG_DOMAIN(DOMAIN_GRT)
+
+using namespace grt;
+
+// Layout (all integers little endian, strings are a 32 bit length followed by the bytes):
+//   magic, format version, GRT_VERSION, section count
+//   per struct file: file name, file size, file modification time, section length, section data
+// A section holds the required struct files and the classes in the order they were loaded.
+static const char cache_magic[8] = {'G', 'R', 'T', 'S', 'T', 'R', 'U', 'C'};
+static const guint32 cache_format_version = 2;
+
+const char *const MetaClassCache::file_name = "structs.cache";
+
+enum {
+  ForceImplFlag = 1 << 0,
+  WatchListsFlag = 1 << 1,
+  WatchDictsFlag = 1 << 2,
+  ImplDataFlag = 1 << 3
+};
+
+enum {
+  ReadOnlyFlag = 1 << 0,
+  DelegateGetFlag = 1 << 1,
+  DelegateSetFlag = 1 << 2,
+  PrivateFlag = 1 << 3,
+  CalculatedFlag = 1 << 4,
+  OwnedObjectFlag = 1 << 5,
+  OverridesFlag = 1 << 6,
+  NullContentAllowedFlag = 1 << 7
+};
+
+enum {
+  ConstructorFlag = 1 << 0,
+  AbstractFlag = 1 << 1
+};
+
+//--------------------------------------------------------------------------------------------------
+
+namespace {
+
+  class CacheWriter {
+  public:
+    std::string data;
+
+    void put_u8(guint8 value) {
+      data.push_back((char)value);
+    }
+
+    void put_u32(guint32 value) {
+      for (int i = 0; i < 4; ++i)
+        data.push_back((char)((value >> (i * 8)) & 0xff));
+    }
+
+    void put_u64(guint64 value) {
+      for (int i = 0; i < 8; ++i)
+        data.push_back((char)((value >> (i * 8)) & 0xff));
+    }
+
+    void put_string(const std::string &value) {
+      put_u32((guint32)value.size());
+      data.append(value);
+    }
+
+    void put_type(const TypeSpec &type) {
+      put_u8((guint8)type.base.type);
+      put_string(type.base.object_class);
+      put_u8((guint8)type.content.type);
+      put_string(type.content.object_class);
+    }
+  };
+
+  class CacheReader {
+  public:
+    CacheReader(const char *data, size_t size) : _ptr(data), _end(data + size) {
+    }
+
+    bool at_end() const {
+      return _ptr == _end;
+    }
+
+    const char *skip(size_t size) {
+      if ((size_t)(_end - _ptr) < size)
+        throw std::runtime_error("truncated struct cache");
+      const char *ptr = _ptr;
+      _ptr += size;
+      return ptr;
+    }
+
+    guint8 get_u8() {
+      return (guint8)*skip(1);
+    }
+
+    guint32 get_u32() {
+      const unsigned char *p = (const unsigned char *)skip(4);
+      return (guint32)p[0] | ((guint32)p[1] << 8) | ((guint32)p[2] << 16) | ((guint32)p[3] << 24);
+    }
+
+    guint64 get_u64() {
+      guint64 low = get_u32();
+      guint64 high = get_u32();
+      return low | (high << 32);
+    }
+
+    std::string get_string() {
+      guint32 size = get_u32();
+      const char *p = skip(size);
+      return std::string(p, size);
+    }
+
+    void get_type(TypeSpec &type) {
+      type.base.type = (Type)get_u8();
+      type.base.object_class = get_string();
+      type.content.type = (Type)get_u8();
+      type.content.object_class = get_string();
+    }
+
+  private:
+    const char *_ptr;
+    const char *_end;
+  };
+};
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Size and modification time of a struct file, as used by the ModuleCache for module files.
+ */
+static bool file_stamp(const std::string &path, guint64 &size, guint64 &mtime) {
+  time_t t;
+  if (!base::file_mtime(path, t))
+    return false;
+
+  long length = base_get_file_size(path.c_str());
+  if (length < 0)
+    return false;
+
+  size = (guint64)length;
+  mtime = (guint64)t;
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static std::string section_name(const std::string &struct_file) {
+  gchar *name = g_path_get_basename(struct_file.c_str());
+  std::string result = name;
+  g_free(name);
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+MetaClassCache::MetaClassCache(const std::string &path) : _path(path), _file(NULL), _hits(0), _misses(0) {
+}
+
+//--------------------------------------------------------------------------------------------------
+
+MetaClassCache::~MetaClassCache() {
+  if (_file != NULL)
+    g_mapped_file_unref(_file);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool MetaClassCache::open() {
+  GError *error = NULL;
+
+  _file = g_mapped_file_new(_path.c_str(), FALSE, &error);
+  if (_file == NULL) {
+    logDebug("Struct cache %s not available: %s\n", _path.c_str(), error->message);
+    g_error_free(error);
+    return false;
+  }
+
+  try {
+    CacheReader reader(g_mapped_file_get_contents(_file), g_mapped_file_get_length(_file));
+
+    if (memcmp(reader.skip(sizeof(cache_magic)), cache_magic, sizeof(cache_magic)) != 0)
+      throw std::runtime_error("not a struct cache");
+    if (reader.get_u32() != cache_format_version || reader.get_string() != GRT_VERSION)
+      throw std::runtime_error("struct cache was written by a different version");
+
+    guint32 count = reader.get_u32();
+    for (guint32 i = 0; i < count; ++i) {
+      std::string name = reader.get_string();
+      Section section;
+
+      section.file_size = reader.get_u64();
+      section.file_mtime = reader.get_u64();
+      section.size = reader.get_u32();
+      section.data = reader.skip(section.size);
+      _sections[name] = section;
+    }
+  } catch (std::exception &exc) {
+    logWarning("Ignoring struct cache %s: %s\n", _path.c_str(), exc.what());
+    _sections.clear();
+    g_mapped_file_unref(_file);
+    _file = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+const MetaClassCache::Section *MetaClassCache::find_section(const std::string &struct_file) {
+  std::map<std::string, Section>::const_iterator iter = _sections.find(section_name(struct_file));
+  if (iter == _sections.end())
+    return NULL;
+  return &iter->second;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool MetaClassCache::is_current(const std::string &struct_file) {
+  const Section *section = find_section(struct_file);
+  guint64 size, mtime;
+
+  if (section == NULL || !file_stamp(struct_file, size, mtime))
+    return false;
+
+  return section->file_size == size && section->file_mtime == mtime;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetaClassCache::read(const std::string &struct_file, std::list<MetaClass *> &classes,
+                          std::list<std::string> *requires, std::list<std::string> *parents) {
+  const Section *section = find_section(struct_file);
+  if (section == NULL)
+    throw std::runtime_error("No cached structs for " + struct_file);
+
+  CacheReader reader(section->data, section->size);
+  std::list<MetaClass *> result;
+
+  try {
+    guint32 count = reader.get_u32();
+    for (guint32 i = 0; i < count; ++i) {
+      std::string file = reader.get_string();
+      if (requires)
+        requires->push_back(file);
+    }
+
+    count = reader.get_u32();
+    for (guint32 i = 0; i < count; ++i) {
+      MetaClass *mc = new MetaClass;
+      result.push_back(mc);
+
+      mc->_name = reader.get_string();
+      mc->_source = struct_file;
+      std::string parent = reader.get_string();
+      if (parents)
+        parents->push_back(parent);
+
+      guint8 flags = reader.get_u8();
+      mc->_force_impl = (flags & ForceImplFlag) != 0;
+      mc->_watch_lists = (flags & WatchListsFlag) != 0;
+      mc->_watch_dicts = (flags & WatchDictsFlag) != 0;
+      mc->_impl_data = (flags & ImplDataFlag) != 0;
+      mc->_crc32 = reader.get_u32();
+
+      guint32 attribute_count = reader.get_u32();
+      for (guint32 a = 0; a < attribute_count; ++a) {
+        std::string key = reader.get_string();
+        mc->_attributes[key] = reader.get_string();
+      }
+
+      guint32 member_count = reader.get_u32();
+      for (guint32 m = 0; m < member_count; ++m) {
+        MetaClass::Member member;
+
+        member.name = reader.get_string();
+        member.id = MetaClass::intern_member(member.name);
+        reader.get_type(member.type);
+        member.default_value = reader.get_string();
+
+        flags = reader.get_u8();
+        member.read_only = (flags & ReadOnlyFlag) != 0;
+        member.delegate_get = (flags & DelegateGetFlag) != 0;
+        member.delegate_set = (flags & DelegateSetFlag) != 0;
+        member.private_ = (flags & PrivateFlag) != 0;
+        member.calculated = (flags & CalculatedFlag) != 0;
+        member.owned_object = (flags & OwnedObjectFlag) != 0;
+        member.overrides = (flags & OverridesFlag) != 0;
+        member.null_content_allowed = (flags & NullContentAllowedFlag) != 0;
+        member.property = 0;
+
+        mc->_members[member.name] = member;
+      }
+
+      guint32 method_count = reader.get_u32();
+      for (guint32 m = 0; m < method_count; ++m) {
+        MetaClass::Method method;
+
+        method.name = reader.get_string();
+        method.module_name = reader.get_string();
+        method.module_function = reader.get_string();
+        reader.get_type(method.ret_type);
+
+        flags = reader.get_u8();
+        method.constructor = (flags & ConstructorFlag) != 0;
+        method.abstract = (flags & AbstractFlag) != 0;
+        method.function = 0;
+
+        guint32 arg_count = reader.get_u32();
+        for (guint32 a = 0; a < arg_count; ++a) {
+          ArgSpec arg;
+          arg.name = reader.get_string();
+          arg.doc = reader.get_string();
+          reader.get_type(arg.type);
+          method.arg_types.push_back(arg);
+        }
+
+        mc->_methods[method.name] = method;
+      }
+
+      guint32 signal_count = reader.get_u32();
+      for (guint32 s = 0; s < signal_count; ++s) {
+        MetaClass::Signal sig;
+
+        sig.name = reader.get_string();
+        guint32 arg_count = reader.get_u32();
+        for (guint32 a = 0; a < arg_count; ++a) {
+          MetaClass::SignalArg arg;
+          arg.name = reader.get_string();
+          arg.type = (MetaClass::SignalArgType)reader.get_u8();
+          arg.object_class = reader.get_string();
+          sig.arg_types.push_back(arg);
+        }
+
+        mc->_signals.push_back(sig);
+      }
+    }
+
+    if (!reader.at_end())
+      throw std::runtime_error("unexpected data in struct cache");
+  } catch (...) {
+    for (std::list<MetaClass *>::iterator iter = result.begin(); iter != result.end(); ++iter)
+      delete *iter;
+    throw;
+  }
+
+  classes.insert(classes.end(), result.begin(), result.end());
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool MetaClassCache::load(const std::string &struct_file, std::list<MetaClass *> &classes,
+                          std::list<std::string> *requires) {
+  if (!is_current(struct_file)) {
+    ++_misses;
+    return false;
+  }
+
+  std::list<MetaClass *> loaded;
+  std::list<std::string> parents;
+  std::list<std::string> reqs;
+
+  try {
+    read(struct_file, loaded, &reqs, &parents);
+  } catch (std::exception &exc) {
+    logWarning("Could not read cached structs for %s: %s\n", struct_file.c_str(), exc.what());
+    ++_misses;
+    return false;
+  }
+
+  // Register the classes as MetaClass::from_xml() and GRT::load_metaclasses() would, filling placeholders created
+  // for classes that were referred to as parent before.
+  std::list<std::string>::const_iterator parent = parents.begin();
+  while (!loaded.empty()) {
+    MetaClass *mc = loaded.front();
+    MetaClass *existing = GRT::get()->get_metaclass(mc->_name);
+    loaded.pop_front();
+
+    if (existing != NULL) {
+      if (!existing->_placeholder) {
+        std::string name = mc->_name;
+        delete mc;
+        for (std::list<MetaClass *>::iterator iter = loaded.begin(); iter != loaded.end(); ++iter)
+          delete *iter;
+        throw std::runtime_error(
+          std::string("Error loading struct from ").append(struct_file).append(": duplicate struct name ").append(name));
+      }
+
+      existing->_placeholder = false;
+      existing->_source = mc->_source;
+      existing->_attributes.swap(mc->_attributes);
+      existing->_members.swap(mc->_members);
+      existing->_methods.swap(mc->_methods);
+      existing->_signals.swap(mc->_signals);
+      existing->_force_impl = mc->_force_impl;
+      existing->_watch_lists = mc->_watch_lists;
+      existing->_watch_dicts = mc->_watch_dicts;
+      existing->_impl_data = mc->_impl_data;
+      existing->_crc32 = mc->_crc32;
+      delete mc;
+      mc = existing;
+    }
+
+    std::string parent_name = parent->empty() ? internal::Object::static_class_name() : *parent;
+    ++parent;
+    mc->_parent = GRT::get()->get_metaclass(parent_name);
+    if (mc->_parent == NULL) {
+      // If the parent is not loaded yet, create a placeholder object to be filled later.
+      MetaClass *tmp = new MetaClass;
+      tmp->_name = parent_name;
+      tmp->_source = mc->_source;
+      tmp->_placeholder = true;
+      mc->_parent = tmp;
+      GRT::get()->add_metaclass(tmp);
+    }
+
+    if (existing == NULL)
+      GRT::get()->add_metaclass(mc);
+    classes.push_back(mc);
+  }
+
+  if (requires)
+    requires->insert(requires->end(), reqs.begin(), reqs.end());
+  ++_hits;
+
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void MetaClassCache::write(const std::string &path, const std::string &directory,
+                           const std::multimap<std::string, std::string> &requires) {
+  GDir *dir = g_dir_open(directory.c_str(), 0, NULL);
+  if (!dir)
+    throw grt::os_error("Invalid path " + directory);
+
+  const std::list<MetaClass *> &metaclasses = GRT::get()->get_metaclasses();
+  CacheWriter writer;
+  CacheWriter index;
+  guint32 section_count = 0;
+  const char *entry;
+
+  while ((entry = g_dir_read_name(dir)) != NULL) {
+    if (!g_str_has_prefix(entry, "structs.") || !g_str_has_suffix(entry, ".xml"))
+      continue;
+
+    char *struct_file = g_build_filename(directory.c_str(), entry, NULL);
+    std::string source = struct_file;
+    g_free(struct_file);
+
+    guint64 file_size, file_mtime;
+    if (!file_stamp(source, file_size, file_mtime)) {
+      g_dir_close(dir);
+      throw grt::os_error("Could not read " + source);
+    }
+
+    CacheWriter section;
+    std::pair<std::multimap<std::string, std::string>::const_iterator,
+              std::multimap<std::string, std::string>::const_iterator>
+      range = requires.equal_range(source);
+
+    section.put_u32((guint32)std::distance(range.first, range.second));
+    for (std::multimap<std::string, std::string>::const_iterator iter = range.first; iter != range.second; ++iter)
+      section.put_string(iter->second);
+
+    std::list<MetaClass *> classes;
+    for (std::list<MetaClass *>::const_iterator iter = metaclasses.begin(); iter != metaclasses.end(); ++iter) {
+      if (!(*iter)->placeholder() && (*iter)->source() == source)
+        classes.push_back(*iter);
+    }
+
+    section.put_u32((guint32)classes.size());
+    for (std::list<MetaClass *>::const_iterator iter = classes.begin(); iter != classes.end(); ++iter) {
+      MetaClass *mc = *iter;
+
+      section.put_string(mc->_name);
+      section.put_string(mc->_parent ? mc->_parent->_name : "");
+      section.put_u8((mc->_force_impl ? ForceImplFlag : 0) | (mc->_watch_lists ? WatchListsFlag : 0) |
+                     (mc->_watch_dicts ? WatchDictsFlag : 0) | (mc->_impl_data ? ImplDataFlag : 0));
+      section.put_u32(mc->_crc32);
+
+      section.put_u32((guint32)mc->_attributes.size());
+      for (std::unordered_map<std::string, std::string>::const_iterator attr = mc->_attributes.begin();
+           attr != mc->_attributes.end(); ++attr) {
+        section.put_string(attr->first);
+        section.put_string(attr->second);
+      }
+
+      section.put_u32((guint32)mc->_members.size());
+      for (MetaClass::MemberList::const_iterator mem = mc->_members.begin(); mem != mc->_members.end(); ++mem) {
+        const MetaClass::Member &member(mem->second);
+
+        section.put_string(member.name);
+        section.put_type(member.type);
+        section.put_string(member.default_value);
+        section.put_u8((member.read_only ? ReadOnlyFlag : 0) | (member.delegate_get ? DelegateGetFlag : 0) |
+                       (member.delegate_set ? DelegateSetFlag : 0) | (member.private_ ? PrivateFlag : 0) |
+                       (member.calculated ? CalculatedFlag : 0) | (member.owned_object ? OwnedObjectFlag : 0) |
+                       (member.overrides ? OverridesFlag : 0) |
+                       (member.null_content_allowed ? NullContentAllowedFlag : 0));
+      }
+
+      section.put_u32((guint32)mc->_methods.size());
+      for (MetaClass::MethodList::const_iterator meth = mc->_methods.begin(); meth != mc->_methods.end(); ++meth) {
+        const MetaClass::Method &method(meth->second);
+
+        section.put_string(method.name);
+        section.put_string(method.module_name);
+        section.put_string(method.module_function);
+        section.put_type(method.ret_type);
+        section.put_u8((method.constructor ? ConstructorFlag : 0) | (method.abstract ? AbstractFlag : 0));
+        section.put_u32((guint32)method.arg_types.size());
+        for (ArgSpecList::const_iterator arg = method.arg_types.begin(); arg != method.arg_types.end(); ++arg) {
+          section.put_string(arg->name);
+          section.put_string(arg->doc);
+          section.put_type(arg->type);
+        }
+      }
+
+      section.put_u32((guint32)mc->_signals.size());
+      for (MetaClass::SignalList::const_iterator sig = mc->_signals.begin(); sig != mc->_signals.end(); ++sig) {
+        section.put_string(sig->name);
+        section.put_u32((guint32)sig->arg_types.size());
+        for (std::vector<MetaClass::SignalArg>::const_iterator arg = sig->arg_types.begin();
+             arg != sig->arg_types.end(); ++arg) {
+          section.put_string(arg->name);
+          section.put_u8((guint8)arg->type);
+          section.put_string(arg->object_class);
+        }
+      }
+    }
+
+    index.put_string(entry);
+    index.put_u64(file_size);
+    index.put_u64(file_mtime);
+    index.put_u32((guint32)section.data.size());
+    index.data.append(section.data);
+    ++section_count;
+  }
+  g_dir_close(dir);
+
+  writer.data.append(cache_magic, sizeof(cache_magic));
+  writer.put_u32(cache_format_version);
+  writer.put_string(GRT_VERSION);
+  writer.put_u32(section_count);
+  writer.data.append(index.data);
+
+  GError *error = NULL;
+  if (!g_file_set_contents(path.c_str(), writer.data.data(), (gssize)writer.data.size(), &error)) {
+    std::string message = error->message;
+    g_error_free(error);
+    throw grt::os_error("Could not write struct cache " + path + ": " + message);
+  }
+  logInfo("Wrote struct cache %s with %u struct files\n", path.c_str(), section_count);
+}
+
+//--------------------------------------------------------------------------------------------------
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+
+#pragma once
+
+#include <glib.h>
+
+#include "grt.h"
+
+namespace grt {
+
+  /** Binary image of the metaclasses defined in a directory of struct files.
+   *
+   * The image is generated at build time (genobj --cache) and installed next to the structs.*.xml files, so that
+   * GRT::scan_metaclasses_in() can create the metaclasses without parsing the XML. The file is mapped into memory
+   * in one go. Every struct file has its own section, keyed by the file name and stamped with the size and
+   * modification time of the file, so struct files which changed or were added later (e.g. user supplied ones) are
+   * still loaded from XML. The stamps are taken from the files the cache is generated from, so it must be generated
+   * from (or installed together with) files which keep their modification time.
+   *
+   * @ingroup GRT
+   */
+  class MYSQLGRT_PUBLIC MetaClassCache {
+  public:
+    static const char *const file_name; // "structs.cache"
+
+    MetaClassCache(const std::string &path);
+    ~MetaClassCache();
+
+    // Maps the cache file and reads the section index. Returns false if there's no usable cache.
+    bool open();
+
+    // Whether the cache has a section for the struct file which matches its current content.
+    bool is_current(const std::string &struct_file);
+
+    // Creates and registers the metaclasses of the struct file from the cache, the same way MetaClass::from_xml()
+    // does. Returns false if the file has to be parsed instead.
+    bool load(const std::string &struct_file, std::list<MetaClass *> &classes, std::list<std::string> *requires);
+
+    // Reads the classes of a struct file without registering them. The caller owns the returned classes,
+    // their parents are not resolved but returned by name in @a parents.
+    void read(const std::string &struct_file, std::list<MetaClass *> &classes, std::list<std::string> *requires,
+              std::list<std::string> *parents);
+
+    // Writes a cache for all structs.*.xml files in the directory, from the metaclasses currently loaded.
+    static void write(const std::string &path, const std::string &directory,
+                      const std::multimap<std::string, std::string> &requires);
+
+    size_t hits() const {
+      return _hits;
+    }
+    size_t misses() const {
+      return _misses;
+    }
+
+  private:
+    struct Section {
+      const char *data;
+      size_t size;
+      guint64 file_size;
+      guint64 file_mtime;
+    };
+
+    std::string _path;
+    GMappedFile *_file;
+    std::map<std::string, Section> _sections;
+    size_t _hits;
+    size_t _misses;
+
+    const Section *find_section(const std::string &struct_file);
+  };
+};
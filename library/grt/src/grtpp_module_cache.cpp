@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+
+#include <algorithm>
+#include <chrono>
+
+#include "grtpp_module_cache.h"
+#include "grtpp_util.h"
+
+#include "base/file_functions.h"
+#include "base/file_utilities.h"
+#include "base/log.h"
+
+DEFAULT_LOG_DOMAIN(DOMAIN_GRT)
+
+using namespace grt;
+
+static const char *cache_doctype = "grt-module-cache";
+static const char *cache_version = "1";
+
+//----------------- Type spec helpers --------------------------------------------------------------
+
+static DictRef type_to_dict(const TypeSpec &type) {
+  DictRef dict(true);
+  dict.gset("type", type_to_str(type.base.type));
+  dict.gset("class", type.base.object_class);
+  dict.gset("contentType", type_to_str(type.content.type));
+  dict.gset("contentClass", type.content.object_class);
+  return dict;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static TypeSpec type_from_dict(const DictRef &dict) {
+  TypeSpec type;
+  type.base.type = str_to_type(dict.get_string("type"));
+  type.base.object_class = dict.get_string("class");
+  type.content.type = str_to_type(dict.get_string("contentType"));
+  type.content.object_class = dict.get_string("contentClass");
+  return type;
+}
+
+//----------------- CachedModule -------------------------------------------------------------------
+
+CachedModule::CachedModule(ModuleLoader *loader, const std::string &path, const DictRef &entry)
+  : Module(loader) {
+  _path = path;
+  _name = entry.get_string("name");
+  _meta_version = entry.get_string("version");
+  _meta_author = entry.get_string("author");
+  _meta_description = entry.get_string("description");
+  _extends = entry.get_string("extends");
+  _is_bundle = entry.get_int("bundle") != 0;
+  _plugin_info = entry.get_string("pluginInfo");
+
+  StringListRef interfaces(StringListRef::cast_from(entry.get("interfaces")));
+  for (StringListRef::const_iterator iter = interfaces.begin(); iter != interfaces.end(); ++iter)
+    _interfaces.push_back(*iter);
+
+  BaseListRef functions(BaseListRef::cast_from(entry.get("functions")));
+  for (size_t c = functions.count(), i = 0; i < c; ++i) {
+    DictRef fdict(DictRef::cast_from(functions[i]));
+    Function func;
+
+    func.name = fdict.get_string("name");
+    func.description = fdict.get_string("description");
+    func.ret_type = type_from_dict(DictRef::cast_from(fdict.get("returnType")));
+
+    BaseListRef args(BaseListRef::cast_from(fdict.get("arguments")));
+    for (size_t ac = args.count(), a = 0; a < ac; ++a) {
+      DictRef adict(DictRef::cast_from(args[a]));
+      ArgSpec arg;
+      arg.name = adict.get_string("name");
+      arg.doc = adict.get_string("doc");
+      arg.type = type_from_dict(DictRef::cast_from(adict.get("type")));
+      func.arg_types.push_back(arg);
+    }
+
+    func.call = std::bind(&CachedModule::call_function, this, func.name, std::placeholders::_1);
+    add_function(func);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+CachedModule::~CachedModule() {
+  // Release the loaded module like the GRT does for registered modules. It's deliberately not closed here, as the
+  // module object's code may live in the library closeModule() unloads.
+  _module.reset();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+ValueRef CachedModule::call_function(const std::string &name, const BaseListRef &args) {
+  // The plugin manager asks every plugin module for its plugins at startup. Answer that from the cache,
+  // so plugin modules are only loaded once one of their plugins is actually used.
+  if (name == "getPluginInfo" && !_plugin_info.empty() && !is_loaded())
+    return GRT::get()->unserialize_xml_data(_plugin_info);
+
+  return resolve()->call_function(name, args);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Module *CachedModule::resolve() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_module) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    Module *module = _loader->init_module(_path);
+    if (module == NULL)
+      throw grt::module_error("Module " + _name + " could not be loaded from " + _path);
+    if (module->name() != _name)
+      logWarning("Module file %s now contains module %s instead of %s\n", _path.c_str(), module->name().c_str(),
+                 _name.c_str());
+    _module.reset(module);
+
+    logDebug("Loaded deferred module %s in %.1fms\n", _name.c_str(),
+             std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+  }
+  return _module.get();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void CachedModule::closeModule() noexcept {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_module)
+    _module->closeModule();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool CachedModule::is_loaded() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _module != nullptr;
+}
+
+//----------------- ModuleCache --------------------------------------------------------------------
+
+ModuleCache::ModuleCache(const std::string &path)
+  : _path(path), _entries(true), _used(true), _hits(0), _misses(0), _changed(false) {
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ModuleCache::load() {
+  if (!base::file_exists(_path))
+    return;
+
+  try {
+    std::string doctype, version;
+    ValueRef root = GRT::get()->unserialize(_path, doctype, version);
+    if (doctype != cache_doctype || version != std::string(cache_version) + "/" + GRT_VERSION) {
+      logInfo("Ignoring module cache %s from a different version\n", _path.c_str());
+      return;
+    }
+    _entries = DictRef::cast_from(root);
+  } catch (std::exception &exc) {
+    logWarning("Could not read module cache %s: %s\n", _path.c_str(), exc.what());
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ModuleCache::save() {
+  // Nothing to do if every entry was used and none was added.
+  if (!_changed && _used.count() == _entries.count())
+    return;
+
+  try {
+    GRT::get()->serialize(_used, _path, cache_doctype, std::string(cache_version) + "/" + GRT_VERSION);
+    _entries = _used;
+    _changed = false;
+  } catch (std::exception &exc) {
+    logWarning("Could not write module cache %s: %s\n", _path.c_str(), exc.what());
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool ModuleCache::file_stamp(const std::string &path, ssize_t &mtime, ssize_t &size) {
+  time_t t;
+  if (!base::file_mtime(path, t))
+    return false;
+  mtime = (ssize_t)t;
+  size = (ssize_t)base_get_file_size(path.c_str());
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Module *ModuleCache::create_module(ModuleLoader *loader, const std::string &path) {
+  DictRef entry(DictRef::cast_from(_entries.get(path)));
+  ssize_t mtime, size;
+
+  if (!entry.is_valid() || entry.get_string("loader") != loader->get_loader_name() || !file_stamp(path, mtime, size) ||
+      entry.get_int("mtime") != mtime || entry.get_int("size") != size) {
+    ++_misses;
+    return NULL;
+  }
+
+  ++_hits;
+  _used.set(path, entry);
+  return new CachedModule(loader, path, entry);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ModuleCache::store(Module *module, const std::string &path) {
+  ssize_t mtime, size;
+  if (dynamic_cast<CachedModule *>(module) != NULL || !file_stamp(path, mtime, size))
+    return;
+
+  DictRef entry(true);
+  entry.gset("loader", module->get_loader()->get_loader_name());
+  entry.set("mtime", IntegerRef(mtime));
+  entry.set("size", IntegerRef(size));
+  entry.gset("name", module->name());
+  entry.gset("version", module->version());
+  entry.gset("author", module->author());
+  entry.gset("description", module->description());
+  entry.gset("extends", module->extends());
+  entry.gset("bundle", module->is_bundle() ? 1 : 0);
+
+  StringListRef interfaces(Initialized);
+  for (Module::Interfaces::const_iterator iter = module->get_interfaces().begin();
+       iter != module->get_interfaces().end(); ++iter)
+    interfaces.insert(*iter);
+  entry.set("interfaces", interfaces);
+
+  BaseListRef functions(true);
+  for (std::vector<Module::Function>::const_iterator func = module->get_functions().begin();
+       func != module->get_functions().end(); ++func) {
+    DictRef fdict(true);
+    fdict.gset("name", func->name);
+    fdict.gset("description", func->description);
+    fdict.set("returnType", type_to_dict(func->ret_type));
+
+    BaseListRef args(true);
+    for (ArgSpecList::const_iterator arg = func->arg_types.begin(); arg != func->arg_types.end(); ++arg) {
+      DictRef adict(true);
+      adict.gset("name", arg->name);
+      adict.gset("doc", arg->doc);
+      adict.set("type", type_to_dict(arg->type));
+      args.ginsert(adict);
+    }
+    fdict.set("arguments", args);
+    functions.ginsert(fdict);
+  }
+  entry.set("functions", functions);
+
+  if (std::find(module->get_interfaces().begin(), module->get_interfaces().end(), "PluginInterface") !=
+      module->get_interfaces().end()) {
+    try {
+      ValueRef plugins = module->call_function("getPluginInfo", BaseListRef());
+      if (plugins.is_valid())
+        entry.gset("pluginInfo", GRT::get()->serialize_xml_data(plugins));
+    } catch (std::exception &exc) {
+      // Leave the plugin list out, it will be fetched from the loaded module instead.
+      logWarning("Could not cache plugins of module %s: %s\n", module->name().c_str(), exc.what());
+    }
+  }
+
+  _used.set(path, entry);
+  _changed = true;
+}
+
+//--------------------------------------------------------------------------------------------------
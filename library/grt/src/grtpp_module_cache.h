@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+#include "grt.h"
+
+namespace grt {
+
+  /** A module created from the module cache.
+   *
+   * Carries the metadata of a module file (name, interfaces, function signatures and the plugin list) without
+   * loading it. The module file is loaded through its loader the first time one of the functions is called,
+   * calls are then forwarded to the loaded module.
+   *
+   * @ingroup GRT
+   */
+  class MYSQLGRT_PUBLIC CachedModule : public Module {
+  public:
+    CachedModule(ModuleLoader *loader, const std::string &path, const DictRef &entry);
+    virtual ~CachedModule();
+
+    virtual ValueRef call_function(const std::string &name, const BaseListRef &args) override;
+    virtual Module *resolve() override;
+    virtual void closeModule() noexcept override;
+
+    bool is_loaded();
+
+  private:
+    std::mutex _mutex;
+    std::unique_ptr<Module> _module; // The loaded module is not registered in the GRT, the cached one owns it.
+    std::string _plugin_info; // Serialized result of getPluginInfo, if the module implements PluginInterface.
+  };
+
+  /** Persistent registry of the modules found in the module directories.
+   *
+   * Entries are keyed by the module file path and are only used as long as the file's size and modification time
+   * match. Entries not used during a session are dropped when the cache is saved.
+   *
+   * @ingroup GRT
+   */
+  class MYSQLGRT_PUBLIC ModuleCache {
+  public:
+    ModuleCache(const std::string &path);
+
+    void load();
+    void save();
+
+    // Returns a CachedModule for the file if there's an up to date entry for it, otherwise NULL.
+    Module *create_module(ModuleLoader *loader, const std::string &path);
+    // Records a module that was just loaded from the given file.
+    void store(Module *module, const std::string &path);
+
+    size_t hits() const {
+      return _hits;
+    }
+    size_t misses() const {
+      return _misses;
+    }
+
+  private:
+    std::string _path;
+    DictRef _entries;
+    DictRef _used;
+    size_t _hits;
+    size_t _misses;
+    bool _changed;
+
+    bool file_stamp(const std::string &path, ssize_t &mtime, ssize_t &size);
+  };
+};
@@ -78,9 +78,29 @@ namespace grt {
     return "";
   }
 
+  /**
+   * Enables the lookup index of an owned list (see internal::OwnedList::enable_index()), which is then used by
+   * find_named_object_in_list() and find_object_in_list(). Worth it for large lists that are searched often.
+   * Lists which are not owned by an object are left alone.
+   */
+  inline void index_list(const BaseListRef &list) {
+    if (list.is_valid()) {
+      internal::OwnedList *owned_list = dynamic_cast<internal::OwnedList *>(&list.content());
+      if (owned_list != nullptr)
+        owned_list->enable_index();
+    }
+  }
+
   template <class O>
   inline Ref<O> find_named_object_in_list(const ListRef<O> &list, const std::string &value, bool case_sensitive = true,
                                           const std::string &name = "name") {
+    if (name == "name" && list.is_valid()) {
+      internal::OwnedList *owned_list = dynamic_cast<internal::OwnedList *>(&list.content());
+      ValueRef result;
+      if (owned_list != nullptr && owned_list->find_indexed_named_object(value, case_sensitive, result))
+        return Ref<O>::cast_from(result);
+    }
+
     for (size_t i = 0; i < list.count(); i++) {
       Ref<O> tmp = list[i];
 
@@ -92,6 +112,13 @@ namespace grt {
 
   template <class O>
   inline Ref<O> find_object_in_list(const ListRef<O> &list, const std::string &id) {
+    if (list.is_valid()) {
+      internal::OwnedList *owned_list = dynamic_cast<internal::OwnedList *>(&list.content());
+      ValueRef result;
+      if (owned_list != nullptr && owned_list->find_indexed_object(id, result))
+        return Ref<O>::cast_from(result);
+    }
+
     size_t i, c = list.count();
     for (i = 0; i < c; i++) {
       Ref<O> value = list[i];
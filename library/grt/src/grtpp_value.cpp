@@ -23,12 +23,20 @@
 
 #include "base/string_utilities.h"
 #include "base/threading.h"
+#include "base/log.h"
 
 #include "grt.h"
 #include "grtpp_util.h"
 #include "grtpp_undo_manager.h"
 
 #include <glib.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+
+DEFAULT_LOG_DOMAIN(DOMAIN_GRT)
 
 using namespace grt;
 using namespace grt::internal;
@@ -402,12 +410,155 @@ void List::__retype(Type type, const std::string& content_class) {
 
 //--------------------------------------------------------------------------------------------------
 
+/**
+ * Creates the key under which a name is indexed. Names are compared like base::same_string() does it, that is,
+ * normalized, optionally case folded and then collated. Collation keys compare equal exactly when g_utf8_collate()
+ * does, so a name that is not in the index is not in the list either.
+ */
+static std::string index_key(const std::string& name, bool fold_case) {
+  gchar* normalized = g_utf8_normalize(name.c_str(), -1, G_NORMALIZE_DEFAULT);
+  if (normalized == NULL) // Invalid UTF-8.
+    return name;
+  if (fold_case) {
+    gchar* folded = g_utf8_casefold(normalized, -1);
+    g_free(normalized);
+    normalized = folded;
+  }
+  gchar* collated = g_utf8_collate_key(normalized, -1);
+  g_free(normalized);
+  std::string key(collated);
+  g_free(collated);
+  return key;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+class OwnedList::ObjectIndex {
+public:
+  typedef std::unordered_map<std::string, std::vector<Object*> > Map;
+
+  Map ids;
+  Map names;
+  Map folded_names;
+
+  ~ObjectIndex() {
+    for (auto& item : _items)
+      item.second.connection.disconnect();
+  }
+
+  void add(const ValueRef& value) {
+    Object* object = object_of(value);
+    if (object == nullptr)
+      return;
+
+    Item& item = _items[object];
+    if (item.count++ == 0) {
+      item.id = object->id();
+      item.named = object->has_member("name");
+      if (item.named) {
+        item.name = object->get_string_member("name");
+        item.connection = object->signal_changed()->connect(
+          std::bind(&ObjectIndex::member_changed, this, object, std::placeholders::_1));
+      }
+    }
+
+    ids[item.id].push_back(object);
+    if (item.named)
+      add_name(object, item.name);
+  }
+
+  // Removes one or all occurrences of the value.
+  void remove(const ValueRef& value, bool all) {
+    Object* object = object_of(value);
+    if (object == nullptr)
+      return;
+
+    std::unordered_map<Object*, Item>::iterator item = _items.find(object);
+    if (item == _items.end())
+      return;
+
+    for (size_t i = all ? item->second.count : 1; i > 0; --i) {
+      erase(ids, item->second.id, object);
+      if (item->second.named)
+        remove_name(object, item->second.name);
+      --item->second.count;
+    }
+
+    if (item->second.count == 0) {
+      item->second.connection.disconnect();
+      _items.erase(item);
+    }
+  }
+
+private:
+  // Keys are stored with each object, so that entries can be removed even if the object changed in the meantime.
+  struct Item {
+    size_t count;
+    std::string id;
+    std::string name;
+    bool named;
+    boost::signals2::connection connection;
+
+    Item() : count(0), named(false) {
+    }
+  };
+
+  static Object* object_of(const ValueRef& value) {
+    if (!value.is_valid() || value.type() != ObjectType)
+      return nullptr;
+    return static_cast<Object*>(value.valueptr());
+  }
+
+  static void erase(Map& map, const std::string& key, Object* object) {
+    Map::iterator entry = map.find(key);
+    if (entry == map.end())
+      return;
+
+    std::vector<Object*>::iterator position = std::find(entry->second.begin(), entry->second.end(), object);
+    if (position != entry->second.end())
+      entry->second.erase(position);
+    if (entry->second.empty())
+      map.erase(entry);
+  }
+
+  void add_name(Object* object, const std::string& name) {
+    names[index_key(name, false)].push_back(object);
+    folded_names[index_key(name, true)].push_back(object);
+  }
+
+  void remove_name(Object* object, const std::string& name) {
+    erase(names, index_key(name, false), object);
+    erase(folded_names, index_key(name, true), object);
+  }
+
+  void member_changed(Object* object, const std::string& member) {
+    if (member != "name")
+      return;
+
+    Item& item = _items[object];
+    std::string name = object->get_string_member("name");
+    for (size_t i = item.count; i > 0; --i) {
+      remove_name(object, item.name);
+      add_name(object, name);
+    }
+    item.name = name;
+  }
+
+  std::unordered_map<Object*, Item> _items;
+};
+
+//--------------------------------------------------------------------------------------------------
+
 OwnedList::OwnedList(Type type, const std::string& content_class, Object* owner, bool allow_null)
-  : List(type, content_class, allow_null), _owner(owner) {
+  : List(type, content_class, allow_null), _owner(owner), _index(nullptr) {
   if (!owner)
     throw std::invalid_argument("owner cannot be NULL");
 }
 
+OwnedList::~OwnedList() {
+  delete _index;
+}
+
 void OwnedList::set_unchecked(size_t index, const ValueRef& value) {
   ValueRef item;
 
@@ -418,6 +569,11 @@ void OwnedList::set_unchecked(size_t index, const ValueRef& value) {
 
   List::set_unchecked(index, value);
 
+  if (_index != nullptr) {
+    _index->remove(item, false);
+    _index->add(value);
+  }
+
   if (item.is_valid())
     _owner->owned_list_item_removed(this, item);
   if (value.is_valid())
@@ -427,12 +583,18 @@ void OwnedList::set_unchecked(size_t index, const ValueRef& value) {
 void OwnedList::insert_unchecked(const ValueRef& value, size_t index) {
   List::insert_unchecked(value, index);
 
+  if (_index != nullptr)
+    _index->add(value);
+
   _owner->owned_list_item_added(this, value);
 }
 
 void OwnedList::remove(const ValueRef& value) {
   List::remove(value);
 
+  if (_index != nullptr)
+    _index->remove(value, true);
+
   _owner->owned_list_item_removed(this, value);
 }
 
@@ -441,9 +603,68 @@ void OwnedList::remove(size_t index) {
 
   List::remove(index);
 
+  if (_index != nullptr)
+    _index->remove(item, false);
+
   _owner->owned_list_item_removed(this, item);
 }
 
+void OwnedList::reorder(size_t oi, size_t ni) {
+  List::reorder(oi, ni);
+
+  // Moving items sends no notification but changes the content as seen by the diff.
+  if (oi != ni)
+    _owner->invalidate_diff_hash();
+}
+
+void OwnedList::enable_index() {
+  if (_index != nullptr)
+    return;
+
+  _index = new ObjectIndex();
+  for (storage_type::const_iterator iter = _content.begin(); iter != _content.end(); ++iter)
+    _index->add(*iter);
+}
+
+bool OwnedList::find_indexed_object(const std::string& id, ValueRef& result) const {
+  if (_index == nullptr)
+    return false;
+
+  ObjectIndex::Map::const_iterator entry = _index->ids.find(id);
+  if (entry == _index->ids.end()) {
+    result = ValueRef();
+    return true;
+  }
+  if (entry->second.size() > 1)
+    return false;
+
+  // Ids are not supposed to change while an object is in the list, but don't rely on that.
+  if (entry->second.front()->id() != id)
+    return false;
+
+  result = ValueRef(entry->second.front());
+  return true;
+}
+
+bool OwnedList::find_indexed_named_object(const std::string& name, bool case_sensitive, ValueRef& result) const {
+  // Renames done in a change batch reach the index only when the batch ends.
+  if (_index == nullptr || ChangeBatch::has_pending_change("name"))
+    return false;
+
+  const ObjectIndex::Map& map = case_sensitive ? _index->names : _index->folded_names;
+  ObjectIndex::Map::const_iterator entry = map.find(index_key(name, !case_sensitive));
+  if (entry == map.end()) {
+    result = ValueRef();
+    return true;
+  }
+  // Entries are kept in insertion order, not list order, so let the caller find the first of several matches.
+  if (entry->second.size() > 1)
+    return false;
+
+  result = ValueRef(entry->second.front());
+  return true;
+}
+
 //--------------------------------------------------------------------------------------------------
 
 std::string Dict::debugDescription(const std::string& indentation) const {
@@ -652,15 +873,92 @@ void OwnedDict::reset_entries() {
 
 //--------------------------------------------------------------------------------------------------
 
+// Guards the cached diff hashes and their links. Diffs hash objects on worker threads while the main thread may
+// change them.
+static std::mutex diff_hash_mutex;
+
+/**
+ * Links between an object with a cached diff hash and the objects whose names went into that hash. Only allocated
+ * for objects which have such links.
+ */
+struct Object::DiffHashLinks {
+  std::vector<const Object*> sources;
+  std::unordered_set<const Object*> dependents;
+
+  // Removes the links from the object to its name sources. The lock must be held.
+  static void unlink_sources(const Object* object) {
+    DiffHashLinks* links = object->_diff_hash_links;
+    if (links == nullptr)
+      return;
+    for (const Object* source : links->sources) {
+      source->_diff_hash_links->dependents.erase(object);
+      release(source);
+    }
+    links->sources.clear();
+    release(object);
+  }
+
+  static void link(const Object* object, const Object* source) {
+    if (object->_diff_hash_links == nullptr)
+      object->_diff_hash_links = new DiffHashLinks();
+    if (source->_diff_hash_links == nullptr)
+      source->_diff_hash_links = new DiffHashLinks();
+    if (source->_diff_hash_links->dependents.insert(object).second)
+      object->_diff_hash_links->sources.push_back(source);
+  }
+
+  static void release(const Object* object) {
+    DiffHashLinks* links = object->_diff_hash_links;
+    if (links != nullptr && links->sources.empty() && links->dependents.empty()) {
+      delete links;
+      object->_diff_hash_links = nullptr;
+    }
+  }
+
+  // Drops the cached hash of the object and of its owners. An owner only keeps a hash while the objects it owns do
+  // (DiffHasher does not cache hashes of objects whose owned objects point elsewhere), so the walk can stop at the
+  // first object without one. The lock must be held.
+  static void drop(const Object* object) {
+    while (object != nullptr && object->_diff_hash_valid) {
+      object->_diff_hash_valid = false;
+      unlink_sources(object);
+
+      if (!object->_metaclass->has_member("owner"))
+        break;
+      ValueRef owner(object->get_member("owner"));
+      object = owner.is_valid() && owner.type() == ObjectType ? static_cast<Object*>(owner.valueptr()) : nullptr;
+    }
+  }
+
+  // Drops the cached hashes which contain the name of the object. The lock must be held.
+  static void drop_dependents(const Object* object) {
+    if (object->_diff_hash_links == nullptr)
+      return;
+    std::vector<const Object*> dependents(object->_diff_hash_links->dependents.begin(),
+                                          object->_diff_hash_links->dependents.end());
+    for (const Object* dependent : dependents)
+      drop(dependent);
+  }
+};
+
 Object::Object(MetaClass* metaclass) : _metaclass(metaclass) {
   if (!_metaclass)
     throw std::runtime_error("GRT object allocated without a metaclass (make sure metaclass data was loaded)");
 
   _id = get_guid();
   _is_global = 0;
+  _diff_hash_valid = false;
+  _diff_hash_mask = 0;
+  _diff_hash = 0;
+  _diff_hash_links = nullptr;
 }
 
 Object::~Object() {
+  std::lock_guard<std::mutex> lock(diff_hash_mutex);
+  if (_diff_hash_links != nullptr) {
+    DiffHashLinks::drop_dependents(this);
+    DiffHashLinks::unlink_sources(this);
+  }
 }
 
 const std::string& Object::id() const {
@@ -781,6 +1079,18 @@ bool Object::has_member(const std::string& member) const {
   return _metaclass->has_member(member);
 }
 
+void Object::set_member(MemberId member, const ValueRef& value) {
+  _metaclass->set_member_value(this, member, value);
+}
+
+ValueRef Object::get_member(MemberId member) const {
+  return _metaclass->get_member_value(this, member);
+}
+
+bool Object::has_member(MemberId member) const {
+  return _metaclass->has_member(member);
+}
+
 bool Object::has_method(const std::string& method) const {
   return _metaclass->has_method(method);
 }
@@ -872,6 +1182,7 @@ bool Object::less_than(const Value* o) const {
 }
 
 void Object::owned_member_changed(const std::string& name, const grt::ValueRef& ovalue, const grt::ValueRef& nvalue) {
+  invalidate_diff_hash();
   if (_is_global) {
     if (ovalue != nvalue) {
       if (ovalue.is_valid())
@@ -882,29 +1193,295 @@ void Object::owned_member_changed(const std::string& name, const grt::ValueRef&
     if (grt::GRT::get()->tracking_changes())
       grt::GRT::get()->get_undo_manager()->add_undo(new UndoObjectChangeAction(this, name, ovalue));
   }
-  _changed_signal(name, ovalue);
+  if (!ChangeBatch::defer_member_change(this, name, ovalue))
+    _changed_signal(name, ovalue);
 }
 
 void Object::member_changed(const std::string& name, const grt::ValueRef& ovalue, const grt::ValueRef& nvalue) {
+  invalidate_diff_hash();
+  if (name == "name" || name == "oldName" || name == "owner")
+    invalidate_dependent_diff_hashes();
   if (_is_global && grt::GRT::get()->tracking_changes())
     grt::GRT::get()->get_undo_manager()->add_undo(new UndoObjectChangeAction(this, name, ovalue));
-  _changed_signal(name, ovalue);
+  if (!ChangeBatch::defer_member_change(this, name, ovalue))
+    _changed_signal(name, ovalue);
 }
 
 void Object::owned_list_item_added(OwnedList* list, const grt::ValueRef& value) {
-  _list_changed_signal(list, true, value);
+  invalidate_diff_hash();
+  if (!ChangeBatch::defer_list_change(this, list, true, value))
+    _list_changed_signal(list, true, value);
 }
 
 void Object::owned_list_item_removed(OwnedList* list, const grt::ValueRef& value) {
-  _list_changed_signal(list, false, value);
+  invalidate_diff_hash();
+  if (!ChangeBatch::defer_list_change(this, list, false, value))
+    _list_changed_signal(list, false, value);
 }
 
 void Object::owned_dict_item_set(OwnedDict* dict, const std::string& key) {
-  _dict_changed_signal(dict, true, key);
+  invalidate_diff_hash();
+  if (!ChangeBatch::defer_dict_change(this, dict, true, key))
+    _dict_changed_signal(dict, true, key);
 }
 
 void Object::owned_dict_item_removed(OwnedDict* dict, const std::string& key) {
-  _dict_changed_signal(dict, false, key);
+  invalidate_diff_hash();
+  if (!ChangeBatch::defer_dict_change(this, dict, false, key))
+    _dict_changed_signal(dict, false, key);
+}
+
+bool Object::get_cached_diff_hash(unsigned int dontdiff_mask, uint64_t& hash) const {
+  if (!_diff_hash_valid)
+    return false;
+
+  std::lock_guard<std::mutex> lock(diff_hash_mutex);
+  if (!_diff_hash_valid || _diff_hash_mask != dontdiff_mask)
+    return false;
+  hash = _diff_hash;
+  return true;
+}
+
+void Object::set_cached_diff_hash(unsigned int dontdiff_mask, uint64_t hash,
+                                  const std::vector<Object*>& name_sources) const {
+  std::lock_guard<std::mutex> lock(diff_hash_mutex);
+  DiffHashLinks::unlink_sources(this);
+  for (const Object* source : name_sources) {
+    // The object's own name is covered by its own change notifications.
+    if (source != this)
+      DiffHashLinks::link(this, source);
+  }
+  _diff_hash_mask = dontdiff_mask;
+  _diff_hash = hash;
+  _diff_hash_valid = true;
+}
+
+/**
+ * Drops the cached hash of this object and of its owners. Cheap while nothing is cached, e.g. during loading.
+ */
+void Object::invalidate_diff_hash() {
+  if (!_diff_hash_valid)
+    return;
+
+  std::lock_guard<std::mutex> lock(diff_hash_mutex);
+  DiffHashLinks::drop(this);
+}
+
+/**
+ * Drops the cached hashes of the objects which hash this one by its name, after it was renamed or moved.
+ */
+void Object::invalidate_dependent_diff_hashes() {
+  std::lock_guard<std::mutex> lock(diff_hash_mutex);
+  DiffHashLinks::drop_dependents(this);
+}
+
+//----------------- ChangeBatch --------------------------------------------------------------------
+
+struct ChangeBatch::Changes {
+  struct ListChange {
+    ValueRef list;
+    bool added;
+    ValueRef value;
+    bool cancelled;
+  };
+
+  struct DictChange {
+    ValueRef dict;
+    bool added;
+    std::string key;
+  };
+
+  // Everything that happened to one object, in the order of the first change of each kind.
+  struct ObjectChanges {
+    ValueRef object;
+    std::vector<std::pair<std::string, ValueRef> > members; // Member name and value before the first change.
+    std::vector<ListChange> lists;
+    std::vector<DictChange> dicts;
+  };
+
+  int depth;
+  std::vector<ObjectChanges> objects;
+  std::unordered_map<Object*, size_t> positions;
+  std::unordered_set<std::string> pending_members;
+
+  // Additions which can still be cancelled by a removal of the same value, as (object, list change) positions.
+  std::map<std::pair<OwnedList*, Value*>, std::vector<std::pair<size_t, size_t> > > additions;
+  std::map<std::pair<OwnedDict*, std::string>, std::pair<size_t, size_t> > dict_changes;
+
+  Changes() : depth(0) {
+  }
+
+  size_t position_of(Object* object) {
+    std::unordered_map<Object*, size_t>::iterator iter = positions.find(object);
+    if (iter != positions.end())
+      return iter->second;
+
+    positions[object] = objects.size();
+    objects.push_back(ObjectChanges());
+    objects.back().object = ValueRef(object);
+    return objects.size() - 1;
+  }
+};
+
+// Batches are opened on the GRT worker thread as well as on the UI thread, so each thread has its own.
+ChangeBatch::ThreadState& ChangeBatch::state() {
+  static thread_local ThreadState state = {nullptr, false};
+  return state;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+ChangeBatch::ChangeBatch() {
+  ThreadState& thread = state();
+  if (thread.current == nullptr)
+    thread.current = new Changes();
+  ++thread.current->depth;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+ChangeBatch::~ChangeBatch() {
+  ThreadState& thread = state();
+  if (--thread.current->depth == 0) {
+    // Notifications sent from here on (including those caused by listeners during the flush) are not deferred.
+    Changes* changes = thread.current;
+    thread.current = nullptr;
+    flush(changes);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool ChangeBatch::active() {
+  return state().current != nullptr;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool ChangeBatch::flushing() {
+  return state().flushing;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool ChangeBatch::has_pending_change(const std::string& member) {
+  Changes* current = state().current;
+  return current != nullptr && current->pending_members.count(member) > 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+boost::signals2::signal<void()>* ChangeBatch::signal_flushed() {
+  static boost::signals2::signal<void()> signal;
+  return &signal;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool ChangeBatch::defer_member_change(Object* object, const std::string& member, const ValueRef& ovalue) {
+  Changes* current = state().current;
+  if (current == nullptr)
+    return false;
+  if (object->signal_changed()->empty())
+    return true; // Nobody is listening, so there's nothing to send later either.
+
+  Changes::ObjectChanges& changes = current->objects[current->position_of(object)];
+  for (auto& change : changes.members) {
+    if (change.first == member)
+      return true; // Only the value before the first change is reported.
+  }
+  changes.members.push_back(std::make_pair(member, ovalue));
+  current->pending_members.insert(member);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool ChangeBatch::defer_list_change(Object* object, OwnedList* list, bool added, const ValueRef& value) {
+  Changes* current = state().current;
+  if (current == nullptr)
+    return false;
+  if (object->signal_list_changed()->empty())
+    return true;
+
+  size_t position = current->position_of(object);
+  Changes::ObjectChanges& changes = current->objects[position];
+  std::pair<OwnedList*, Value*> key(list, value.valueptr());
+  if (added)
+    current->additions[key].push_back(std::make_pair(position, changes.lists.size()));
+  else {
+    // An item that was added in this batch and removed again is not reported at all.
+    auto addition = current->additions.find(key);
+    if (addition != current->additions.end()) {
+      std::pair<size_t, size_t> cancelled = addition->second.back();
+      current->objects[cancelled.first].lists[cancelled.second].cancelled = true;
+      addition->second.pop_back();
+      if (addition->second.empty())
+        current->additions.erase(addition);
+      return true;
+    }
+  }
+
+  Changes::ListChange change = {ValueRef(list), added, value, false};
+  changes.lists.push_back(change);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+bool ChangeBatch::defer_dict_change(Object* object, OwnedDict* dict, bool added, const std::string& key) {
+  Changes* current = state().current;
+  if (current == nullptr)
+    return false;
+  if (object->signal_dict_changed()->empty())
+    return true;
+
+  size_t position = current->position_of(object);
+  Changes::ObjectChanges& changes = current->objects[position];
+
+  // Each key is reported once, with its final state.
+  auto previous = current->dict_changes.find(std::make_pair(dict, key));
+  if (previous != current->dict_changes.end()) {
+    current->objects[previous->second.first].dicts[previous->second.second].added = added;
+    return true;
+  }
+
+  current->dict_changes[std::make_pair(dict, key)] = std::make_pair(position, changes.dicts.size());
+  Changes::DictChange change = {ValueRef(dict), added, key};
+  changes.dicts.push_back(change);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void ChangeBatch::flush(Changes* changes) {
+  ThreadState& thread = state();
+  thread.flushing = true;
+  try {
+    for (auto& object_changes : changes->objects) {
+      Object* object = static_cast<Object*>(object_changes.object.valueptr());
+      for (auto& change : object_changes.members)
+        (*object->signal_changed())(change.first, change.second);
+      for (auto& change : object_changes.lists) {
+        if (!change.cancelled)
+          (*object->signal_list_changed())(static_cast<OwnedList*>(change.list.valueptr()), change.added,
+                                            change.value);
+      }
+      for (auto& change : object_changes.dicts)
+        (*object->signal_dict_changed())(static_cast<OwnedDict*>(change.dict.valueptr()), change.added, change.key);
+    }
+  } catch (std::exception& e) {
+    // Called from a destructor, so exceptions must not escape.
+    logError("Exception while sending deferred change notifications: %s\n", e.what());
+  }
+  thread.flushing = false;
+  delete changes;
+
+  try {
+    (*signal_flushed())();
+  } catch (std::exception& e) {
+    logError("Exception while handling a change batch: %s\n", e.what());
+  }
 }
 
 #ifdef USE_EXPRERIMENTAL_REFS
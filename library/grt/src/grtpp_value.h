@@ -31,6 +31,9 @@
   #endif
 #endif
 
+#include <atomic>
+#include <cstdint>
+#include <vector>
 #include <boost/signals2.hpp>
 #include "base/threading.h"
 
@@ -47,6 +50,10 @@ namespace grt {
 
   enum Type { UnknownType, AnyType = UnknownType, IntegerType, DoubleType, StringType, ListType, DictType, ObjectType };
 
+  // Process wide id of a metaclass member name, see MetaClass::intern_member().
+  typedef unsigned int MemberId;
+  const MemberId InvalidMemberId = (MemberId)-1;
+
   struct MYSQLGRT_PUBLIC SimpleTypeSpec {
     Type type;
     std::string object_class;
@@ -300,7 +307,7 @@ namespace internal {
 
       virtual void remove(const ValueRef &value);
       virtual void remove(size_t index);
-      void reorder(size_t oi, size_t ni);
+      virtual void reorder(size_t oi, size_t ni);
 
       size_t get_index(const ValueRef &value);
 
@@ -363,13 +370,32 @@ namespace internal {
 
       virtual void remove(const ValueRef &value);
       virtual void remove(size_t index);
+      virtual void reorder(size_t oi, size_t ni);
 
       Object *owner_of_owned_list() const {
         return _owner;
       }
 
+      // Optional index over the objects in the list, which maps their id, name and case folded name to the object.
+      // It is kept up to date on list changes and when an object in the list is renamed. Object ids must not
+      // change while the object is part of an indexed list.
+      void enable_index();
+      bool has_index() const {
+        return _index != nullptr;
+      }
+
+      // Lookups through the index. They return false if the index cannot answer the query (because it is not enabled
+      // or the name is used more than once) and the list must be searched instead.
+      bool find_indexed_object(const std::string &id, ValueRef &result) const;
+      bool find_indexed_named_object(const std::string &name, bool case_sensitive, ValueRef &result) const;
+
     protected:
+      class ObjectIndex;
+
+      virtual ~OwnedList();
+
       Object *_owner; // internal: set if it belongs to an object
+      ObjectIndex *_index;
     };
 
     //------------------------------------------------------------------------------------------------
@@ -489,6 +515,11 @@ namespace internal {
       Integer::storage_type get_integer_member(const std::string &member) const;
       bool has_member(const std::string &member) const;
 
+      // Same as above, but without the string lookups (see MetaClass::Member::id).
+      void set_member(MemberId member, const ValueRef &value);
+      ValueRef get_member(MemberId member) const;
+      bool has_member(MemberId member) const;
+
       bool has_method(const std::string &method) const;
 
       virtual bool equals(const Value *) const;
@@ -512,6 +543,15 @@ namespace internal {
 
       virtual void reset_references();
 
+      // Content hash cache for grt::DiffHasher. A hash is only valid for the dontdiff mask it was computed with
+      // and is dropped whenever the object or anything it owns changes. Hashes include the names of referenced
+      // objects, which are passed as name_sources. Renaming or moving one of them drops the hash as well.
+      // Safe to use from several threads.
+      bool get_cached_diff_hash(unsigned int dontdiff_mask, uint64_t &hash) const;
+      void set_cached_diff_hash(unsigned int dontdiff_mask, uint64_t hash,
+                                const std::vector<Object *> &name_sources) const;
+      void invalidate_diff_hash();
+
     public:
       virtual void init();
 
@@ -547,6 +587,15 @@ namespace internal {
 
       mutable short _is_global; // whether object is attached to the global GRT tree
 
+      struct DiffHashLinks;
+
+      void invalidate_dependent_diff_hashes();
+
+      mutable std::atomic<bool> _diff_hash_valid; // Set and cleared under the diff hash lock, read without it.
+      mutable unsigned int _diff_hash_mask;
+      mutable uint64_t _diff_hash;
+      mutable DiffHashLinks *_diff_hash_links;
+
       //    public:
       //      const ObjectValidFlag &weakref_valid_flag() const { return _valid_flag; }
     };
@@ -590,4 +639,59 @@ namespace internal {
     };
 
   }; // internal
+
+  //------------------------------------------------------------------------------------------------
+
+  /** Coalesces change notifications of GRT objects during bulk operations.
+   *
+   * While an instance is alive (instances can be nested) the changed, list changed and dict changed
+   * signals of objects are not emitted right away. Instead they are collected per object and sent when
+   * the outermost batch ends, with a single notification per changed member (carrying the value the
+   * member had before the batch). Items which were added to a list and removed again within the batch
+   * are not reported at all. Undo recording is not affected.
+   *
+   * Listeners which want to handle the whole change set at once can check flushing() and connect to
+   * signal_flushed(), which is emitted after all deferred notifications were sent.
+   *
+   * Batches are per thread. A batch only defers notifications sent on the thread that opened it, and
+   * active(), flushing() and has_pending_change() report the state of the calling thread.
+   *
+   * @ingroup GRTInternal
+   */
+  class MYSQLGRT_PUBLIC ChangeBatch {
+  public:
+    ChangeBatch();
+    ~ChangeBatch();
+
+    static bool active();
+    static bool flushing();
+
+    // Whether a change of the given member is waiting to be sent.
+    static bool has_pending_change(const std::string &member);
+
+    static boost::signals2::signal<void()> *signal_flushed();
+
+  private:
+    friend class internal::Object;
+    struct Changes;
+
+    ChangeBatch(const ChangeBatch &) = delete;
+    ChangeBatch &operator=(const ChangeBatch &) = delete;
+
+    // Called by objects to queue a notification. Return false if no batch is active.
+    static bool defer_member_change(internal::Object *object, const std::string &member, const ValueRef &ovalue);
+    static bool defer_list_change(internal::Object *object, internal::OwnedList *list, bool added,
+                                  const ValueRef &value);
+    static bool defer_dict_change(internal::Object *object, internal::OwnedDict *dict, bool added,
+                                  const std::string &key);
+
+    static void flush(Changes *changes);
+
+    // The batch state of the calling thread.
+    struct ThreadState {
+      Changes *current;
+      bool flushing;
+    };
+    static ThreadState &state();
+  };
 };   // grt
@@ -270,12 +270,13 @@ static PyObject *object_getattro(PyGRTObjectObject *self, PyObject *attr_name) {
     else if (strcmp(attrname, "__id__") == 0)
       return Py_BuildValue("s", self->object->id().c_str());
     else {
-      if (self->object->has_member(attrname)) {
+      grt::MemberId member;
+      if (grt::MetaClass::lookup_member_id(attrname, member) && self->object->has_member(member)) {
         PythonContext *ctx = PythonContext::get_and_check();
         if (!ctx)
           return NULL;
 
-        return ctx->from_grt(self->object->get_member(attrname));
+        return ctx->from_grt(self->object->get_member(member));
       } else if (self->object->has_method(attrname)) {
         // create a method call object and return it
         PyGRTMethodObject *method = (PyGRTMethodObject *)PyType_GenericNew(&PyGRTMethodObjectType, NULL, NULL);
@@ -297,11 +298,12 @@ static int object_setattro(PyGRTObjectObject *self, PyObject *attr_name, PyObjec
   if (PyString_Check(attr_name)) {
     const char *attrname = PyString_AsString(attr_name);
 
-    if (self->object->has_member(attrname)) {
+    grt::MemberId member_id;
+    if (grt::MetaClass::lookup_member_id(attrname, member_id) && self->object->has_member(member_id)) {
       PythonContext *ctx = PythonContext::get_and_check();
       if (!ctx)
         return -1;
-      const grt::MetaClass::Member *member = self->object->get_metaclass()->get_member_info(attrname);
+      const grt::MetaClass::Member *member = self->object->get_metaclass()->get_member_info(member_id);
       if (member) {
         grt::ValueRef value;
 
@@ -318,7 +320,7 @@ static int object_setattro(PyGRTObjectObject *self, PyObject *attr_name, PyObjec
         }
 
         try {
-          self->object->set_member(attrname, value);
+          self->object->set_member(member_id, value);
         } catch (const std::exception &exc) {
           PythonContext::set_python_error(exc);
           return -1;
@@ -279,7 +279,7 @@ bool internal::Serializer::serialize_member(const MetaClass::Member *member, con
 
   xmlNodePtr child;
 
-  v = object->get_member(k);
+  v = object->get_member(member->id);
 
   if (v.is_valid()) {
     // if 'owned' for this member is not set to 1, then we just dump
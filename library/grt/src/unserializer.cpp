@@ -358,8 +358,9 @@ void internal::Unserializer::unserialize_object_contents(const ObjectRef &object
     if (child->type == XML_ELEMENT_NODE) {
       std::string key = base::xml::getProp(child, "key");
 
+      MemberId member;
       if (!key.empty()) {
-        if (!object->has_member(key)) {
+        if (!MetaClass::lookup_member_id(key, member) || !object->has_member(member)) {
           logWarning(
             "in %s: %s", object.id().c_str(),
             std::string("unserialized XML contains invalid member " + object.class_name() + "::" + key).c_str());
@@ -367,7 +368,7 @@ void internal::Unserializer::unserialize_object_contents(const ObjectRef &object
         } else {
           // 1st check if the value is a container and if it has already been created
           // if so, insert it to the unserialize cache for reuse by base_grt_traverse_xml_recreating_tree
-          sub_value = object->get_member(key);
+          sub_value = object->get_member(member);
           if (sub_value.is_valid()) {
             std::string ptr = base::xml::getProp(child, "_ptr_");
             if (!ptr.empty())
@@ -383,7 +384,7 @@ void internal::Unserializer::unserialize_object_contents(const ObjectRef &object
           }
           if (sub_value.is_valid()) {
             try {
-              mc->set_member_internal((internal::Object *)object.valueptr(), key, sub_value, true);
+              mc->set_member_internal((internal::Object *)object.valueptr(), member, sub_value, true);
             } catch (const std::exception &exc) {
               logWarning("exception setting %s<%s>:%s to %s %s", object.id().c_str(), object.class_name().c_str(),
                          key.c_str(), sub_value.debugDescription().c_str(), exc.what());
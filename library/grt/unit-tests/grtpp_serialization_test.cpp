@@ -21,11 +21,16 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
  */
 
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+
 #include "testgrt.h"
 #include "grt_test_utility.h"
 #include "structs.test.h"
 #include "grtdb/db_object_helpers.h"
 #include "grts/structs.db.mysql.h"
+#include "base/string_utilities.h"
 
 BEGIN_TEST_DATA_CLASS(grtpp_serialization_test)
 public:
@@ -173,6 +178,77 @@ TEST_FUNCTION(5) {
   ensure("list[2]", list[2].is_valid());
 }
 
+static db_mysql_CatalogRef create_large_catalog(size_t table_count, size_t column_count) {
+  db_mysql_CatalogRef catalog(grt::Initialized);
+  db_mysql_SchemaRef schema(grt::Initialized);
+  schema->owner(catalog);
+  schema->name("large");
+  catalog->schemata().insert(schema);
+  for (size_t t = 0; t < table_count; ++t) {
+    db_mysql_TableRef table(grt::Initialized);
+    table->owner(schema);
+    table->name(base::strfmt("table%i", (int)t));
+    for (size_t c = 0; c < column_count; ++c) {
+      db_mysql_ColumnRef column(grt::Initialized);
+      column->owner(table);
+      column->name(base::strfmt("column%i", (int)c));
+      table->columns().insert(column);
+    }
+    schema->tables().insert(table);
+  }
+  return catalog;
+}
+
+TEST_FUNCTION(6) {
+  // Round trip of a larger catalog, which goes through the member id based accessors.
+  const size_t table_count = 200, column_count = 20;
+
+  db_mysql_CatalogRef catalog(create_large_catalog(table_count, column_count));
+  grt::GRT::get()->serialize(catalog, "output/large_catalog.xml");
+  db_mysql_CatalogRef loaded(db_mysql_CatalogRef::cast_from(grt::GRT::get()->unserialize("output/large_catalog.xml")));
+
+  ensure_equals("tables", loaded->schemata()[0]->tables().count(), table_count);
+  db_mysql_TableRef last_table(loaded->schemata()[0]->tables()[table_count - 1]);
+  ensure_equals("table name", *last_table->name(), base::strfmt("table%i", (int)table_count - 1));
+  ensure_equals("columns", last_table->columns().count(), column_count);
+  ensure_equals("column name", *last_table->columns()[column_count - 1]->name(),
+                base::strfmt("column%i", (int)column_count - 1));
+  ensure("column owner", last_table->columns()[0]->owner() == last_table);
+
+  // Access through interned member ids must match the named access.
+  grt::MemberId name_id;
+  ensure("interned", grt::MetaClass::lookup_member_id("name", name_id));
+  ensure("valid id", name_id != grt::InvalidMemberId);
+  db_mysql_TableRef table(loaded->schemata()[0]->tables()[0]);
+  ensure("has member", table->has_member(name_id));
+  ensure("invalid id", !table->has_member(grt::InvalidMemberId));
+  ensure_equals("get by id", *grt::StringRef::cast_from(table->get_member(name_id)), *table->name());
+  table->set_member(name_id, grt::StringRef("renamed"));
+  ensure_equals("set by id", *table->name(), "renamed");
+}
+
+// Timings for a 1000 table catalog, only run if BENCHMARK is set in the environment.
+TEST_FUNCTION(7) {
+  if (getenv("BENCHMARK") == nullptr)
+    return;
+
+  const size_t table_count = 1000, column_count = 20;
+  db_mysql_CatalogRef catalog(create_large_catalog(table_count, column_count));
+
+  auto start = std::chrono::steady_clock::now();
+  grt::GRT::get()->serialize(catalog, "output/benchmark_catalog.xml");
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "Serializing " << table_count << " tables: " << seconds << "s" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  db_mysql_CatalogRef loaded(
+    db_mysql_CatalogRef::cast_from(grt::GRT::get()->unserialize("output/benchmark_catalog.xml")));
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "Unserializing " << table_count << " tables: " << seconds << "s" << std::endl;
+
+  ensure_equals("tables", loaded->schemata()[0]->tables().count(), table_count);
+}
+
 #ifdef badtest
 TEST_FUNCTION(5) {
   // dontfollow means the object will be saved as a link, not that it wont be saved
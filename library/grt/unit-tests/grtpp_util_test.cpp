@@ -25,6 +25,11 @@
 #include "grt_test_utility.h"
 #include "structs.test.h"
 #include "grtpp_util.h"
+#include "grtdiffhash.h"
+#include "grts/structs.db.mysql.h"
+#include "base/string_utilities.h"
+
+#include <thread>
 
 using namespace grt;
 
@@ -37,8 +42,11 @@ TEST_MODULE(grtpp_util_test, "GRT: util functions");
 TEST_FUNCTION(1) {
   // Load test data.
   grt::GRT::get()->load_metaclasses("data/structs.test.xml");
-  grt::GRT::get()->end_loading_metaclasses();
   ensure_equals("load structs", grt::GRT::get()->get_metaclasses().size(), 6U);
+
+  // The diff hash tests need objects with owners.
+  grt::GRT::get()->scan_metaclasses_in("../../res/grt/");
+  grt::GRT::get()->end_loading_metaclasses();
 }
 
 TEST_FUNCTION(2) { // set_value_by_path
@@ -88,4 +96,368 @@ TEST_FUNCTION(10) {
   ensure_equals("don't modify owned objects Bug #17324160", book->publisher().id(), publisher.id());
 }
 
+// Lookups in lists with an index must give the same results as scanning the list.
+TEST_FUNCTION(11) {
+  test_BookRef book(grt::Initialized);
+  test_AuthorRef authors[3] = {test_AuthorRef(grt::Initialized), test_AuthorRef(grt::Initialized),
+                               test_AuthorRef(grt::Initialized)};
+  authors[0]->name("Zweig");
+  authors[1]->name("Mann");
+  authors[2]->name("mann");
+
+  book->authors().insert(authors[0]);
+  grt::index_list(book->authors());
+  book->authors().insert(authors[1]);
+  book->authors().insert(authors[2], 0);
+
+  ensure_equals("by id", find_object_in_list(book->authors(), authors[1].id()).id(), authors[1].id());
+  ensure("unknown id", !find_object_in_list(book->authors(), "unknown").is_valid());
+  ensure_equals("by name", find_named_object_in_list(book->authors(), "Mann").id(), authors[1].id());
+  ensure_equals("by name, case insensitive, duplicate", find_named_object_in_list(book->authors(), "MANN", false).id(),
+                authors[2].id());
+  ensure("unknown name", !find_named_object_in_list(book->authors(), "Kafka", false).is_valid());
+
+  // Renaming an item updates the index.
+  authors[0]->name("Kafka");
+  ensure("old name", !find_named_object_in_list(book->authors(), "Zweig").is_valid());
+  ensure_equals("new name", find_named_object_in_list(book->authors(), "kafka", false).id(), authors[0].id());
+
+  book->authors().remove_value(authors[2]);
+  ensure_equals("after remove", find_named_object_in_list(book->authors(), "MANN", false).id(), authors[1].id());
+
+  book->authors().set(0, authors[2]);
+  ensure("replaced item", !find_object_in_list(book->authors(), authors[0].id()).is_valid());
+  ensure_equals("replacement", find_named_object_in_list(book->authors(), "mann").id(), authors[2].id());
+
+  // Renaming an object which is no longer in the list must not affect the index.
+  authors[0]->name("mann");
+  ensure_equals("removed item renamed", find_named_object_in_list(book->authors(), "mann").id(), authors[2].id());
+
+  // Names are matched like base::same_string() does it, so other normalization forms must be found as well.
+  test_AuthorRef accented(grt::Initialized);
+  accented->name("Jos\xC3\xA9"); // Precomposed e with acute accent.
+  book->authors().insert(accented);
+  ensure_equals("decomposed name", find_named_object_in_list(book->authors(), "Jose\xCC\x81").id(), accented.id());
+  ensure_equals("decomposed name, case insensitive",
+                find_named_object_in_list(book->authors(), "JOSE\xCC\x81", false).id(), accented.id());
+}
+
+TEST_FUNCTION(12) {
+  test_BookRef book(grt::Initialized);
+  test_AuthorRef author1(grt::Initialized), author2(grt::Initialized);
+  book->authors().insert(author1);
+
+  std::vector<std::pair<std::string, grt::ValueRef> > changes;
+  std::vector<std::pair<bool, std::string> > list_changes;
+  int flushed = 0;
+  boost::signals2::scoped_connection c1(
+    book->signal_changed()->connect([&](const std::string &name, const grt::ValueRef &ovalue) {
+      changes.push_back(std::make_pair(name, ovalue));
+    }));
+  boost::signals2::scoped_connection c2(
+    book->signal_list_changed()->connect([&](grt::internal::OwnedList *, bool added, const grt::ValueRef &value) {
+      list_changes.push_back(std::make_pair(added, grt::ObjectRef::cast_from(value).id()));
+    }));
+  boost::signals2::scoped_connection c3(grt::ChangeBatch::signal_flushed()->connect([&]() { ++flushed; }));
+
+  book->title("First");
+  {
+    grt::ChangeBatch batch;
+    book->title("Second");
+    book->title("Third");
+    {
+      grt::ChangeBatch nested;
+      book->pages(100);
+      book->authors().insert(author2);
+      book->authors().remove(0);
+      book->authors().remove_value(author2);
+    }
+    ensure("deferred", grt::ChangeBatch::active());
+    ensure_equals("nothing sent yet", changes.size(), 1U);
+    ensure("pending change", grt::ChangeBatch::has_pending_change("title"));
+    ensure_equals("not flushed yet", flushed, 0);
+  }
+  ensure("batch ended", !grt::ChangeBatch::active());
+  ensure_equals("flushed once", flushed, 1);
+
+  // One notification per member, with the value from before the batch.
+  ensure_equals("member changes", changes.size(), 3U);
+  ensure_equals("title", changes[1].first, "title");
+  ensure_equals("old title", *grt::StringRef::cast_from(changes[1].second), "First");
+  ensure_equals("pages", changes[2].first, "pages");
+
+  // author2 was added and removed again, so only the removal of author1 is left.
+  ensure_equals("list changes", list_changes.size(), 1U);
+  ensure("removal", !list_changes[0].first);
+  ensure_equals("removed item", list_changes[0].second, author1.id());
+}
+
+TEST_FUNCTION(13) {
+  test_BookRef book1(grt::Initialized), book2(grt::Initialized);
+  book1->title("Ulysses");
+  book1->pages(730);
+  book2->title("Ulysses");
+  book2->pages(730);
+
+  grt::DiffHasher hasher(1);
+  uint64_t hash1, hash2;
+  ensure("hash 1", hasher.hash(book1, hash1));
+  ensure("hash 2", hasher.hash(book2, hash2));
+  ensure_equals("same content", hash1, hash2);
+
+  // The cached hash must be dropped when the object changes.
+  book2->pages(731);
+  ensure("hash 2 changed", hasher.hash(book2, hash2));
+  ensure("different content", hash1 != hash2);
+
+  book2->pages(730);
+  ensure("hash 2 reverted", hasher.hash(book2, hash2));
+  ensure_equals("same content again", hash1, hash2);
+
+  grt::default_omf omf;
+  ensure("no diff", !grt::diff_make(book1, book2, &omf));
+}
+
+// Change batches are per thread. A batch must neither defer nor flush the notifications of another thread.
+TEST_FUNCTION(14) {
+  test_BookRef book1(grt::Initialized), book2(grt::Initialized);
+  std::vector<std::string> changes1, changes2;
+  boost::signals2::scoped_connection c1(book1->signal_changed()->connect(
+    [&](const std::string &name, const grt::ValueRef &) { changes1.push_back(name); }));
+  boost::signals2::scoped_connection c2(book2->signal_changed()->connect(
+    [&](const std::string &name, const grt::ValueRef &) { changes2.push_back(name); }));
+
+  {
+    grt::ChangeBatch batch;
+    book1->title("Deferred");
+
+    bool active_in_thread = true;
+    bool pending_in_thread = true;
+    size_t sent_in_batch = 1;
+    size_t sent_after_batch = 0;
+    std::thread worker([&]() {
+      active_in_thread = grt::ChangeBatch::active();
+      pending_in_thread = grt::ChangeBatch::has_pending_change("title");
+      {
+        grt::ChangeBatch other;
+        book2->title("Other");
+        book2->pages(10);
+        sent_in_batch = changes2.size();
+      }
+      sent_after_batch = changes2.size();
+    });
+    worker.join();
+
+    ensure("no batch in the other thread", !active_in_thread);
+    ensure("no pending change in the other thread", !pending_in_thread);
+    ensure_equals("deferred in the other thread", sent_in_batch, 0U);
+    ensure_equals("flushed by the other thread", sent_after_batch, 2U);
+    ensure("own batch still active", grt::ChangeBatch::active());
+    ensure_equals("own change still deferred", changes1.size(), 0U);
+  }
+  ensure_equals("own change flushed", changes1.size(), 1U);
+}
+
+// A name missing from the index is reported without a scan, so indexed lookups must agree with a plain scan of
+// the same objects (which compares with base::same_string()) in all cases.
+TEST_FUNCTION(15) {
+  const char *names[] = {"Stra\xC3\x9F" "e", "Strasse", "STRASSE", "Jos\xC3\xA9", "jose\xCC\x81", "Mann", "mann",
+                         "M\xC3\xA4nner", "maenner", ""};
+  const size_t count = sizeof(names) / sizeof(names[0]);
+
+  test_BookRef book(grt::Initialized);
+  grt::index_list(book->authors());
+  grt::ListRef<test_Author> plain(true);
+  for (size_t i = 0; i < count - 1; i += 2) { // Only every other name is in the lists.
+    test_AuthorRef author(grt::Initialized);
+    author->name(names[i]);
+    book->authors().insert(author);
+    plain.insert(author);
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    for (int case_sensitive = 0; case_sensitive < 2; ++case_sensitive) {
+      std::string message = base::strfmt("lookup of \"%s\" (%s)", names[i], case_sensitive ? "cs" : "ci");
+      ensure_equals(message, find_named_object_in_list(book->authors(), names[i], case_sensitive != 0).valueptr(),
+                    find_named_object_in_list(plain, names[i], case_sensitive != 0).valueptr());
+    }
+  }
+}
+
+// Two tables with two columns each in one schema. The columns of the first table reference a datatype, which is
+// owned by a separate catalog.
+struct HashModel {
+  db_mysql_CatalogRef types;
+  db_SimpleDatatypeRef type;
+  db_mysql_SchemaRef schema;
+  db_mysql_TableRef table1;
+  db_mysql_TableRef table2;
+};
+
+static HashModel create_hash_model() {
+  HashModel model;
+  model.types = db_mysql_CatalogRef(grt::Initialized);
+  model.types->name("types");
+  model.type = db_SimpleDatatypeRef(grt::Initialized);
+  model.type->owner(model.types);
+  model.type->name("INT");
+
+  model.schema = db_mysql_SchemaRef(grt::Initialized);
+  model.schema->name("schema");
+  for (int t = 1; t <= 2; ++t) {
+    db_mysql_TableRef table(grt::Initialized);
+    table->owner(model.schema);
+    table->name(base::strfmt("table%i", t));
+    for (int c = 1; c <= 2; ++c) {
+      db_mysql_ColumnRef column(grt::Initialized);
+      column->owner(table);
+      column->name(base::strfmt("column%i", c));
+      column->length(10);
+      if (t == 1)
+        column->simpleType(model.type);
+      table->columns().insert(column);
+    }
+    model.schema->tables().insert(table);
+  }
+  model.table1 = model.schema->tables()[0];
+  model.table2 = model.schema->tables()[1];
+  return model;
+}
+
+static bool is_cached(const grt::ObjectRef &object, unsigned int dontdiff_mask) {
+  uint64_t hash;
+  return object->get_cached_diff_hash(dontdiff_mask, hash);
+}
+
+// Changes deep in the owned subtree reach the hashes of all owners.
+TEST_FUNCTION(16) {
+  HashModel model = create_hash_model();
+  grt::DiffHasher hasher(1);
+  uint64_t original, hash;
+  ensure("hash", hasher.hash(model.schema, original));
+  ensure("schema cached", is_cached(model.schema, 1));
+  ensure("column cached", is_cached(model.table2->columns()[1], 1));
+
+  model.table2->columns()[1]->length(20);
+  ensure("column dropped", !is_cached(model.table2->columns()[1], 1));
+  ensure("table dropped", !is_cached(model.table2, 1));
+  ensure("schema dropped", !is_cached(model.schema, 1));
+  ensure("sibling kept", is_cached(model.table1, 1));
+  ensure("hash changed", hasher.hash(model.schema, hash));
+  ensure("different content", hash != original);
+
+  model.table2->columns()[1]->length(10);
+  ensure("hash reverted", hasher.hash(model.schema, hash));
+  ensure_equals("same content again", hash, original);
+
+  // Same for objects added to and removed from owned lists.
+  db_mysql_ColumnRef column(grt::Initialized);
+  column->owner(model.table2);
+  column->name("column3");
+  model.table2->columns().insert(column);
+  ensure("hash with added column", hasher.hash(model.schema, hash));
+  ensure("column added", hash != original);
+
+  model.table2->columns().remove_value(column);
+  ensure("hash with removed column", hasher.hash(model.schema, hash));
+  ensure_equals("column removed", hash, original);
+}
+
+// Reordering a list sends no change notification but changes the hash.
+TEST_FUNCTION(17) {
+  HashModel model = create_hash_model();
+  grt::DiffHasher hasher(1);
+  uint64_t original, hash;
+  ensure("hash", hasher.hash(model.schema, original));
+
+  model.table1->columns().reorder(0, 1);
+  ensure("table dropped", !is_cached(model.table1, 1));
+  ensure("schema dropped", !is_cached(model.schema, 1));
+  ensure("reordered hash", hasher.hash(model.schema, hash));
+  ensure("reordered", hash != original);
+
+  model.table1->columns().reorder(1, 0);
+  ensure("restored hash", hasher.hash(model.schema, hash));
+  ensure_equals("order restored", hash, original);
+}
+
+// Renaming or moving an object drops the hashes that contain its name, and only those.
+TEST_FUNCTION(18) {
+  HashModel model = create_hash_model();
+  grt::DiffHasher hasher(1);
+  uint64_t original1, original2, hash;
+  ensure("hash 1", hasher.hash(model.table1, original1));
+  ensure("hash 2", hasher.hash(model.table2, original2));
+
+  // The columns of the first table reference the type.
+  model.type->name("BIGINT");
+  ensure("referencing column dropped", !is_cached(model.table1->columns()[0], 1));
+  ensure("owner of referencing column dropped", !is_cached(model.table1, 1));
+  ensure("unrelated table kept", is_cached(model.table2, 1));
+  ensure("hash after rename", hasher.hash(model.table1, hash));
+  ensure("renamed type", hash != original1);
+  uint64_t renamed = hash;
+
+  // The name of the referenced object's owner is part of the hash as well.
+  model.types->name("other types");
+  ensure("dropped by owner rename", !is_cached(model.table1, 1));
+  ensure("hash after owner rename", hasher.hash(model.table1, hash));
+  ensure("renamed owner", hash != renamed && hash != original1);
+
+  model.types->name("types");
+  model.type->name("INT");
+  ensure("hash after renaming back", hasher.hash(model.table1, hash));
+  ensure_equals("names restored", hash, original1);
+
+  // Moving the type to another owner.
+  db_mysql_CatalogRef other(grt::Initialized);
+  other->name("moved");
+  model.type->owner(other);
+  ensure("dropped by move", !is_cached(model.table1, 1));
+  ensure("hash after move", hasher.hash(model.table1, hash));
+  ensure("moved type", hash != original1);
+  model.type->owner(model.types);
+
+  // Renaming an object nobody references keeps the other hashes.
+  ensure("hash before table rename", hasher.hash(model.table1, hash));
+  model.table2->name("renamed");
+  ensure("table 1 kept", is_cached(model.table1, 1));
+  ensure("hash 2 after rename", hasher.hash(model.table2, hash));
+  ensure("renamed table", hash != original2);
+
+  // A column no longer referencing the type is not dropped by renaming it.
+  model.table1->columns()[0]->simpleType(db_SimpleDatatypeRef());
+  model.table1->columns()[1]->simpleType(db_SimpleDatatypeRef());
+  ensure("hash without references", hasher.hash(model.table1, hash));
+  model.type->name("TINYINT");
+  ensure("no longer dependent", is_cached(model.table1, 1));
+}
+
+// Members are only hashed if not excluded by the dontdiff mask, and each mask has its own hash.
+TEST_FUNCTION(19) {
+  db_mysql_TableRef table(grt::Initialized);
+  table->name("table");
+  grt::DiffHasher hasher1(1), hasher2(2);
+  uint64_t original1, original2, hash1, hash2;
+  ensure("hash 1", hasher1.hash(table, original1));
+  ensure("hash 2", hasher2.hash(table, original2));
+  ensure("masks differ", original1 != original2);
+  ensure("hash 1 again", hasher1.hash(table, hash1));
+  ensure_equals("cache keeps the masks apart", hash1, original1);
+
+  // nextAutoInc is excluded by mask 2 and createDate by mask 1.
+  table->nextAutoInc("100");
+  ensure("hash 1 with auto inc", hasher1.hash(table, hash1));
+  ensure("hash 2 with auto inc", hasher2.hash(table, hash2));
+  ensure("auto inc compared with mask 1", hash1 != original1);
+  ensure_equals("auto inc ignored with mask 2", hash2, original2);
+
+  original1 = hash1;
+  table->createDate("2018-01-01 10:00");
+  ensure("hash 1 with date", hasher1.hash(table, hash1));
+  ensure("hash 2 with date", hasher2.hash(table, hash2));
+  ensure_equals("date ignored with mask 1", hash1, original1);
+  ensure("date compared with mask 2", hash2 != original2);
+}
+
 END_TESTS
@@ -23,7 +23,10 @@
 
 #include "testgrt.h"
 #include "grtpp_module_cpp.h"
+#include "grtpp_module_cache.h"
 #include "structs.test.h"
+#include "base/file_utilities.h"
+#include "base/string_utilities.h"
 
 #define DEFINE_TEST_MODULES_CODE
 #include "test_modules.h"
@@ -46,6 +49,62 @@ public:
   }
 };
 
+class CachedSampleModuleImpl : public ModuleImplBase, public SampleInterface1Impl {
+public:
+  CachedSampleModuleImpl(CPPModuleLoader *ldr) : ModuleImplBase(ldr) {
+  }
+
+  DEFINE_INIT_MODULE("1.0", "", ModuleImplBase, DECLARE_MODULE_FUNCTION(CachedSampleModuleImpl::getNumber),
+                     DECLARE_MODULE_FUNCTION(CachedSampleModuleImpl::calculate));
+
+  virtual int getNumber() override {
+    return 7;
+  }
+  virtual int calculate() override {
+    return 8;
+  }
+};
+
+// Pretends to load SampleModule1 (or CachedSampleModule) from any file, counting the loads.
+class CountingModuleLoader : public ModuleLoader {
+public:
+  int loads;
+  bool other_module;
+
+  CountingModuleLoader() : loads(0), other_module(false) {
+  }
+
+  virtual std::string get_loader_name() {
+    return "counting";
+  }
+  virtual Module *init_module(const std::string &path) {
+    ++loads;
+    CPPModuleLoader *cpp_loader = dynamic_cast<CPPModuleLoader *>(grt::GRT::get()->get_module_loader("cpp"));
+    if (other_module) {
+      CachedSampleModuleImpl *module = new CachedSampleModuleImpl(cpp_loader);
+      module->init_module();
+      return module;
+    }
+    SampleModule1Impl *module = new SampleModule1Impl(cpp_loader);
+    module->init_module();
+    return module;
+  }
+  virtual void refresh() {
+  }
+  virtual bool load_library(const std::string &path) {
+    return false;
+  }
+  virtual bool run_script_file(const std::string &path) {
+    return false;
+  }
+  virtual bool run_script(const std::string &script) {
+    return false;
+  }
+  virtual bool check_file_extension(const std::string &path) {
+    return true;
+  }
+};
+
 TEST_MODULE(grt_module_native, "GRT: C++ modules");
 
 TEST_FUNCTION(1) {
@@ -251,4 +310,86 @@ TEST_FUNCTION(7) { // functions returning NULL value were causing exception
   ensure("returnNull", !result.is_valid());
 }
 
+TEST_FUNCTION(8) { // modules created from the module cache are loaded on first call
+  static const char *module_file = "module_cache_test.module";
+  static const char *cache_file = "module_cache_test.xml";
+  base::setTextFileContent(module_file, "module");
+  base::tryRemove(cache_file);
+
+  CountingModuleLoader loader;
+  {
+    ModuleCache cache(cache_file);
+    cache.load();
+    ensure("no entry yet", cache.create_module(&loader, module_file) == NULL);
+
+    Module *module = loader.init_module(module_file);
+    cache.store(module, module_file);
+    cache.save();
+    delete module;
+  }
+
+  ModuleCache cache(cache_file);
+  cache.load();
+  Module *module = cache.create_module(&loader, module_file);
+  ensure("cached module", module != NULL);
+  ensure_equals("module name", module->name(), "SampleModule1");
+  ensure_equals("functions", module->get_functions().size(), 2U);
+  ensure_equals("interfaces", module->get_interfaces().size(), 1U);
+  ensure_equals("not loaded yet", loader.loads, 1);
+
+  BaseListRef args(AnyType);
+  ensure_equals("getNumber", *IntegerRef::cast_from(module->call_function("getNumber", args)), 42);
+  ensure_equals("loaded on first call", loader.loads, 2);
+  ensure("resolved", module->resolve() != module && module->resolve()->name() == "SampleModule1");
+  module->call_function("getNumber", args);
+  ensure_equals("loaded once", loader.loads, 2);
+  delete module;
+
+  // A changed file invalidates the entry.
+  base::setTextFileContent(module_file, "changed module");
+  ensure("changed file", cache.create_module(&loader, module_file) == NULL);
+
+  base::tryRemove(module_file);
+  base::tryRemove(cache_file);
+}
+
+TEST_FUNCTION(9) { // native access to a registered module that was created from the cache
+  static const char *module_file = "module_cache_native_test.module";
+  static const char *cache_file = "module_cache_native_test.xml";
+  base::setTextFileContent(module_file, "module");
+  base::tryRemove(cache_file);
+
+  static CountingModuleLoader loader; // Must outlive the registered module.
+  loader.other_module = true;
+  {
+    ModuleCache cache(cache_file);
+    cache.load();
+    Module *module = loader.init_module(module_file);
+    cache.store(module, module_file);
+    cache.save();
+    delete module;
+  }
+
+  ModuleCache cache(cache_file);
+  cache.load();
+  Module *module = cache.create_module(&loader, module_file);
+  ensure("cached module", module != NULL);
+  grt::GRT::get()->register_new_module(module);
+
+  // The registered module is only a placeholder, casting it directly doesn't give the implementation.
+  Module *registered = grt::GRT::get()->get_module("CachedSampleModule");
+  ensure("placeholder", dynamic_cast<SampleInterface1Impl *>(registered) == NULL);
+
+  SampleInterface1Impl *native = grt::GRT::get()->find_native_module<SampleInterface1Impl>("CachedSampleModule");
+  ensure("native module", native != NULL);
+  ensure_equals("loaded", loader.loads, 2);
+  ensure_equals("getNumber", native->getNumber(), 7);
+  ensure("same instance", native == grt::GRT::get()->find_native_module<SampleInterface1Impl>("CachedSampleModule"));
+  ensure("native implementation",
+         grt::GRT::get()->find_native_module<CachedSampleModuleImpl>("CachedSampleModule") != NULL);
+
+  base::tryRemove(module_file);
+  base::tryRemove(cache_file);
+}
+
 END_TESTS
@@ -23,11 +23,69 @@
 
 #include "testgrt.h"
 #include "structs.test.h"
+#include "grtpp_metaclass_cache.h"
+#include "base/file_functions.h"
+#include "base/file_utilities.h"
 
 using namespace grt;
 
 BEGIN_TEST_DATA_CLASS(grt_struct)
-public:
+protected:
+  void put_u32(std::string &data, guint32 value) {
+    for (int i = 0; i < 4; ++i)
+      data.push_back((char)((value >> (i * 8)) & 0xff));
+  }
+
+  void put_u64(std::string &data, guint64 value) {
+    put_u32(data, (guint32)value);
+    put_u32(data, (guint32)(value >> 32));
+  }
+
+  void put_string(std::string &data, const std::string &value) {
+    put_u32(data, (guint32)value.size());
+    data.append(value);
+  }
+
+  // Writes a struct cache with a single section for the struct file (see the layout in grtpp_metaclass_cache.cpp).
+  // Classes are given as name and parent, each gets a string member m<index>.
+  void write_cache(const std::string &path, const std::string &struct_file,
+                   const std::vector<std::pair<std::string, std::string> > &classes) {
+    std::string section;
+    put_u32(section, 0); // Required struct files.
+    put_u32(section, (guint32)classes.size());
+    for (size_t i = 0; i < classes.size(); ++i) {
+      put_string(section, classes[i].first);
+      put_string(section, classes[i].second);
+      section.push_back(0); // Class flags.
+      put_u32(section, 0);  // crc32
+      put_u32(section, 0);  // Attributes.
+      put_u32(section, 1);  // Members.
+      put_string(section, "m" + std::to_string(i));
+      section.push_back((char)StringType);
+      put_string(section, "");
+      section.push_back((char)UnknownType);
+      put_string(section, "");
+      put_string(section, ""); // Default value.
+      section.push_back(0);    // Member flags.
+      put_u32(section, 0);     // Methods.
+      put_u32(section, 0);     // Signals.
+    }
+
+    time_t mtime;
+    ensure("struct file mtime", base::file_mtime(struct_file, mtime));
+
+    std::string data("GRTSTRUC", 8);
+    put_u32(data, 2);
+    put_string(data, GRT_VERSION);
+    put_u32(data, 1);
+    put_string(data, base::basename(struct_file));
+    put_u64(data, (guint64)base_get_file_size(struct_file.c_str()));
+    put_u64(data, (guint64)mtime);
+    put_u32(data, (guint32)section.size());
+    data.append(section);
+
+    ensure("write struct cache", g_file_set_contents(path.c_str(), data.data(), (gssize)data.size(), NULL) != FALSE);
+  }
 END_TEST_DATA_CLASS
 
 TEST_MODULE(grt_struct, "GRT: structs/metaclasses");
@@ -166,4 +224,100 @@ TEST_FUNCTION(21) {
    */
 }
 
+TEST_FUNCTION(22) {
+  // The struct cache must reproduce the classes loaded from XML.
+  std::multimap<std::string, std::string> requires;
+  grt::MetaClassCache::write("output/structs.cache", "data", requires);
+
+  grt::MetaClassCache cache("output/structs.cache");
+  ensure("open cache", cache.open());
+  ensure("cache is current", cache.is_current("data/structs.test.xml"));
+
+  std::list<MetaClass *> classes;
+  std::list<std::string> parents;
+  cache.read("data/structs.test.xml", classes, NULL, &parents);
+  ensure_equals("cached class count", classes.size(), 6U);
+
+  std::list<std::string>::const_iterator parent = parents.begin();
+  for (std::list<MetaClass *>::const_iterator iter = classes.begin(); iter != classes.end(); ++iter, ++parent) {
+    MetaClass *cached = *iter;
+    MetaClass *loaded = grt::GRT::get()->get_metaclass(cached->name());
+
+    ensure("cached class known", loaded != 0);
+    ensure_equals("parent of " + cached->name(), *parent, loaded->parent()->name());
+    ensure_equals("crc of " + cached->name(), cached->crc32(), loaded->crc32());
+    ensure_equals("members of " + cached->name(), cached->get_members_partial().size(),
+                  loaded->get_members_partial().size());
+    ensure_equals("methods of " + cached->name(), cached->get_methods_partial().size(),
+                  loaded->get_methods_partial().size());
+    ensure_equals("attribute of " + cached->name(), cached->get_attribute("caption", false),
+                  loaded->get_attribute("caption", false));
+  }
+  MetaClass *book = grt::GRT::get()->get_metaclass("test.Book");
+  for (std::list<MetaClass *>::const_iterator iter = classes.begin(); iter != classes.end(); ++iter) {
+    if ((*iter)->name() == "test.Book") {
+      ensure_equals("member attribute", (*iter)->get_member_attribute("authors", "desc", false),
+                    book->get_member_attribute("authors", "desc", false));
+      ensure("owned flag", (*iter)->get_member_info("authors")->owned_object ==
+                             book->get_member_info("authors")->owned_object);
+    }
+    delete *iter;
+  }
+}
+
+// Classes from the cache are registered like the ones parsed from XML. A parent defined later in the file is created
+// as placeholder first and filled when its class is read.
+TEST_FUNCTION(23) {
+  const std::string directory = "output/struct_cache";
+  const std::string struct_file = directory + "/structs.cachetest.xml";
+  const std::string cache_file = directory + "/" + grt::MetaClassCache::file_name;
+
+  g_mkdir_with_parents(directory.c_str(), 0700);
+  // Not parsed as long as the cache is current.
+  ensure("write struct file",
+         g_file_set_contents(struct_file.c_str(), "<?xml version=\"1.0\"?>\n<gstructs/>\n", -1, NULL) != FALSE);
+
+  std::vector<std::pair<std::string, std::string> > classes;
+  classes.push_back(std::make_pair("test.cache.Derived", "test.cache.Base"));
+  classes.push_back(std::make_pair("test.cache.Base", "test.Book"));
+  write_cache(cache_file, struct_file, classes);
+
+  grt::GRT::get()->use_metaclass_cache(true);
+  size_t count = grt::GRT::get()->get_metaclasses().size();
+  ensure_equals("registered classes", grt::GRT::get()->scan_metaclasses_in(directory), 2);
+  ensure_equals("listed classes", grt::GRT::get()->get_metaclasses().size(), count + 2);
+
+  MetaClass *derived = grt::GRT::get()->get_metaclass("test.cache.Derived");
+  MetaClass *base = grt::GRT::get()->get_metaclass("test.cache.Base");
+  ensure("derived registered", derived != 0);
+  ensure("base registered", base != 0);
+  ensure("placeholder filled", !base->placeholder());
+  ensure_equals("derived source", derived->source(), struct_file);
+  ensure("derived parent", derived->parent() == base);
+  ensure("base parent", base->parent() == grt::GRT::get()->get_metaclass("test.Book"));
+  ensure("own member", derived->get_member_info("m0") != 0);
+  ensure("inherited member", derived->get_member_info("m1") != 0);
+  ensure("member of existing parent", derived->get_member_info("title") != 0);
+
+  // Loading the classes again must not replace the registered ones.
+  std::list<MetaClass *> loaded;
+  grt::MetaClassCache cache(cache_file);
+  ensure("open cache", cache.open());
+  ensure("cache is current", cache.is_current(struct_file));
+  try {
+    cache.load(struct_file, loaded, NULL);
+    fail("duplicate classes loaded");
+  } catch (std::runtime_error &) {
+  }
+  ensure("nothing loaded", loaded.empty());
+
+  // A changed struct file is parsed instead.
+  ensure("change struct file",
+         g_file_set_contents(struct_file.c_str(), "<?xml version=\"1.0\"?>\n<gstructs>\n</gstructs>\n", -1, NULL) !=
+           FALSE);
+  ensure("cache is outdated", !cache.is_current(struct_file));
+  ensure("outdated section not loaded", !cache.load(struct_file, loaded, NULL));
+  ensure_equals("cache misses", cache.misses(), 1U);
+}
+
 END_TESTS
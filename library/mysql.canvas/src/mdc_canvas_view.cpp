@@ -24,6 +24,9 @@
 #include "base/file_utilities.h"
 #include "base/threading.h"
 
+#include <png.h>
+#include <setjmp.h>
+
 #ifndef _MSC_VER
 #include <cairo/cairo-pdf.h>
 #include <cairo/cairo-ps.h>
@@ -889,7 +892,79 @@ Rect CanvasView::get_content_bounds() const {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+namespace {
+
+  /**
+   * Writes a PNG file band by band, so the image never has to be in memory as a whole.
+   * libpng reports errors by longjmp'ing back into the frame that called it, so every call into it is wrapped
+   * in a setjmp and no objects with destructors are created between the two.
+   */
+  class PngRowWriter {
+  public:
+    PngRowWriter(FILE *file, int width, int height) : _png(nullptr), _info(nullptr) {
+      _png = png_create_write_struct(PNG_LIBPNG_VER_STRING, this, &PngRowWriter::on_error, &PngRowWriter::on_warning);
+      if (_png != nullptr)
+        _info = png_create_info_struct(_png);
+      if (_info == nullptr) {
+        png_destroy_write_struct(&_png, nullptr);
+        throw canvas_error("Could not create the PNG writer");
+      }
+
+      if (setjmp(png_jmpbuf(_png))) {
+        png_destroy_write_struct(&_png, &_info);
+        throw canvas_error(_error);
+      }
+      png_init_io(_png, file);
+      png_set_IHDR(_png, _info, width, height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                   PNG_FILTER_TYPE_DEFAULT);
+      png_write_info(_png, _info);
+    }
+
+    ~PngRowWriter() {
+      png_destroy_write_struct(&_png, &_info);
+    }
+
+    void write_rows(png_bytepp rows, int count) {
+      if (setjmp(png_jmpbuf(_png)))
+        throw canvas_error(_error);
+      png_write_rows(_png, rows, count);
+    }
+
+    void finish() {
+      if (setjmp(png_jmpbuf(_png)))
+        throw canvas_error(_error);
+      png_write_end(_png, _info);
+    }
+
+  private:
+    png_structp _png;
+    png_infop _info;
+    std::string _error;
+
+    static void on_error(png_structp png, png_const_charp message) {
+      static_cast<PngRowWriter *>(png_get_error_ptr(png))->_error = message;
+      png_longjmp(png, 1);
+    }
+
+    static void on_warning(png_structp, png_const_charp) {
+    }
+  };
+
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Renders the diagram in tiles, each into the same small Cairo surface, and streams the result into the PNG file
+ * one band of tiles at a time. This way neither Cairo's surface size limit nor the available memory restrict the size
+ * of the exported image.
+ */
 void CanvasView::export_png(const std::string &filename, bool crop) {
+  // Tiles are rendered one after the other. Items paint through the view's shared context, so rendering
+  // several tiles in parallel is not possible.
+  static const int tile_width = 4096;
+  static const int band_height = 512;
+
   CanvasAutoLock lock(this);
 
   base::FileHandle fh(filename.c_str(), "wb");
@@ -907,19 +982,52 @@ void CanvasView::export_png(const std::string &filename, bool crop) {
     bounds.size.height += 20;
   }
 
-  cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, (int)bounds.width(), (int)bounds.height());
-  try {
-    CairoCtx ctx(surface);
+  int width = (int)bounds.width();
+  int height = (int)bounds.height();
+  if (width <= 0 || height <= 0)
+    throw canvas_error("There is nothing to export");
 
-    ctx.rectangle(0, 0, bounds.width(), bounds.height());
-    ctx.set_color(Color::white());
-    ctx.fill();
-    render_for_export(bounds, &ctx);
+  PngRowWriter writer(fh.file(), width, height);
+  std::vector<unsigned char> band((size_t)width * 3 * std::min(height, band_height));
+  std::vector<png_bytep> rows(std::min(height, band_height));
 
-    cairo_status_t status;
+  cairo_surface_t *surface =
+    cairo_image_surface_create(CAIRO_FORMAT_RGB24, std::min(width, tile_width), std::min(height, band_height));
+  try {
+    for (int top = 0; top < height; top += band_height) {
+      int rows_in_band = std::min(band_height, height - top);
+      for (int left = 0; left < width; left += tile_width) {
+        int columns = std::min(tile_width, width - left);
+        {
+          CairoCtx ctx(surface);
+
+          ctx.rectangle(0, 0, columns, rows_in_band);
+          ctx.set_color(Color::white());
+          ctx.fill();
+          render_for_export(Rect(bounds.left() + left, bounds.top() + top, columns, rows_in_band), &ctx);
+          ctx.check_state();
+        }
+        cairo_surface_flush(surface);
+
+        // RGB24 pixels are native endian 32-bit words with the unused byte on top.
+        const unsigned char *data = cairo_image_surface_get_data(surface);
+        int stride = cairo_image_surface_get_stride(surface);
+        for (int y = 0; y < rows_in_band; ++y) {
+          const uint32_t *pixel = reinterpret_cast<const uint32_t *>(data + y * stride);
+          unsigned char *out = &band[((size_t)y * width + left) * 3];
+          for (int x = 0; x < columns; ++x, out += 3) {
+            out[0] = (pixel[x] >> 16) & 0xff;
+            out[1] = (pixel[x] >> 8) & 0xff;
+            out[2] = pixel[x] & 0xff;
+          }
+        }
+      }
 
-    if ((status = cairo_surface_write_to_png_stream(surface, &write_to_surface, fh.file())) != CAIRO_STATUS_SUCCESS)
-      throw canvas_error(cairo_status_to_string(status));
+      for (int y = 0; y < rows_in_band; ++y)
+        rows[y] = &band[(size_t)y * width * 3];
+      writer.write_rows(rows.data(), rows_in_band);
+    }
+    writer.finish();
   } catch (std::exception &) {
     cairo_surface_destroy(surface);
     throw;
@@ -28,6 +28,10 @@
 #ifndef _MSC_VER
 #include <unistd.h>
 #endif
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <vector>
 #include "SSHSftp.h"
 
@@ -35,8 +39,15 @@ DEFAULT_LOG_DOMAIN("SSHSftp")
 
 namespace ssh {
 
+  // Servers answer reads up to this size in full, larger requests may be cut short.
+  static const std::size_t DefaultChunkSize = 32768;
+  static const std::size_t DefaultPipelineDepth = 64;
+  // A single write is sent as one packet, sftp-server accepts messages up to 256KB.
+  static const std::size_t UploadChunkSize = 131072;
+
   SSHSftp::SSHSftp(std::shared_ptr<SSHSession> session, std::size_t maxFileSize)
-      : _session(session), _maxFileLimit(maxFileSize) {
+      : _session(session), _maxFileLimit(maxFileSize), _chunkSize(DefaultChunkSize),
+        _pipelineDepth(DefaultPipelineDepth) {
 
     auto lock = _session->lockSession();
     _sftp = sftp_new(_session->getSession()->getCSession());
@@ -216,39 +227,175 @@ namespace ssh {
     return ftpFileUniqueDeleter(new ftpFile(_file), [](ftpFile* f) { sftp_close(f->ptr); delete f;});
   }
 
-  void SSHSftp::get(const std::string &src, const std::string &dest) const {
-    auto lock = _session->lockSession();
-    sftp_file file = sftp_open(_sftp, createRemotePath(src).c_str(), O_RDONLY, 0);
+  static void seekFile(FILE *file, uint64_t offset) {
+#ifdef _MSC_VER
+    int rc = _fseeki64(file, (__int64)offset, SEEK_SET);
+#else
+    int rc = fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+    if (rc != 0)
+      throw SSHSftpException("Error seeking in local file");
+  }
+
+  static uint64_t fileSize(FILE *file) {
+#ifdef _MSC_VER
+    _fseeki64(file, 0, SEEK_END);
+    uint64_t size = (uint64_t)_ftelli64(file);
+#else
+    fseeko(file, 0, SEEK_END);
+    uint64_t size = (uint64_t)ftello(file);
+#endif
+    seekFile(file, 0);
+    return size;
+  }
+
+  static double secondsSince(const std::chrono::steady_clock::time_point &start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  sftp_file SSHSftp::openRemote(const std::string &path, int accessType, unsigned int mode) const {
+    sftp_file file = sftp_open(_sftp, createRemotePath(path).c_str(), accessType, mode);
     if (file == nullptr)
       throw SSHSftpException(_session->getSession()->getError());
+    return file;
+  }
+
+  // Keeps up to _pipelineDepth read requests in flight, so the link isn't idle for a round trip per chunk. Replies are
+  // written at their own offset and short reads request the missing remainder again, hence out must be seekable.
+  // Returns true if the end of the remote file was hit before the end of the range.
+  bool SSHSftp::download(sftp_file file, FILE *out, uint64_t offset, uint64_t length) const {
+    struct ReadRequest {
+      uint32_t id;
+      uint64_t offset;
+      uint32_t length;
+    };
+
+    std::deque<ReadRequest> pending;
+    auto request = [&](uint64_t from, uint32_t size) {
+      sftp_seek64(file, from);
+      int id = sftp_async_read_begin(file, size);
+      if (id < 0)
+        throw SSHSftpException(_session->getSession()->getError());
+      pending.push_back({ (uint32_t)id, from, size });
+    };
+
+    _buffer.resize(_chunkSize);
+    uint64_t next = offset;
+    uint64_t end = offset + length;
+    uint64_t outPosition = UINT64_MAX;
+    bool eof = false;
+    while (true) {
+      while (!eof && next < end && pending.size() < _pipelineDepth) {
+        uint32_t size = (uint32_t)std::min((uint64_t)_chunkSize, end - next);
+        request(next, size);
+        next += size;
+      }
+      if (pending.empty())
+        break;
+
+      ReadRequest current = pending.front();
+      pending.pop_front();
+
+      int nBytes;
+      do {
+        nBytes = sftp_async_read(file, _buffer.data(), current.length, current.id);
+      } while (nBytes == SSH_AGAIN);
+
+      if (nBytes < 0)
+        throw SSHSftpException(_session->getSession()->getError());
+      if (nBytes == 0) {
+        eof = true;
+        continue;
+      }
+
+      if (outPosition != current.offset)
+        seekFile(out, current.offset);
+      if (fwrite(_buffer.data(), sizeof(char), nBytes, out) != (std::size_t)nBytes)
+        throw SSHSftpException("Error writing file");
+      outPosition = current.offset + nBytes;
+
+      if ((uint32_t)nBytes < current.length && !eof)
+        request(current.offset + nBytes, current.length - nBytes);
+    }
+
+    return eof;
+  }
+
+  // libssh offers no asynchronous writes, so uploads use large chunks to carry more data per round trip.
+  void SSHSftp::upload(FILE *in, sftp_file file, uint64_t offset, uint64_t length) const {
+    seekFile(in, offset);
+    sftp_seek64(file, offset);
+
+    _buffer.resize(std::max(_chunkSize, UploadChunkSize));
+    while (length > 0) {
+      std::size_t nBytes = fread(_buffer.data(), sizeof(char), (std::size_t)std::min((uint64_t)_buffer.size(), length),
+                                 in);
+      if (nBytes == 0) {
+        if (ferror(in))
+          throw SSHSftpException("Error reading file");
+        break;
+      }
+
+      ssize_t nWritten = sftp_write(file, _buffer.data(), nBytes);
+      if (nWritten < 0 || (std::size_t)nWritten != nBytes)
+        throw SSHSftpException("Error writing file");
+      length -= nBytes;
+    }
+  }
+
+  void SSHSftp::get(const std::string &src, const std::string &dest) const {
+    auto lock = _session->lockSession();
+    auto file = createPtr(openRemote(src, O_RDONLY, 0));
 
     base::FileHandle fileHandle;
     try {
-      fileHandle = base::FileHandle(dest, "w+", true);
+      fileHandle = base::FileHandle(dest, "wb", true);
     } catch (base::file_error &fe) {
       throw SSHSftpException(fe.what());
     }
 
-    char buffer[16384];
-    while (true) {
-      ssize_t nBytes = sftp_read(file, buffer, sizeof(buffer));
-      if (nBytes == 0)
-        break;
-      else if (nBytes < 0) {
-        sftp_close(file);
-        throw SSHSftpException(_session->getSession()->getError());
-      }
+    uint64_t size = 0;
+    sftp_attributes info = sftp_fstat(file->ptr);
+    if (info != nullptr) {
+      size = info->size;
+      sftp_attributes_free(info);
+    }
 
-      std::size_t nWritten = fwrite(buffer, sizeof(char), nBytes, fileHandle.file());
-      if (nBytes > 0 && nWritten != (std::size_t) nBytes) {
-        sftp_close(file);
-        throw SSHSftpException("Error writing file");
+    // The download is complete once the size reported when opening the file was read. Only files which don't report
+    // a size (like /proc entries) are read sequentially until the end.
+    auto start = std::chrono::steady_clock::now();
+    if (size > 0)
+      download(file->ptr, fileHandle.file(), 0, size);
+    else {
+      _buffer.resize(_chunkSize);
+      while (true) {
+        ssize_t nBytes = sftp_read(file->ptr, _buffer.data(), _buffer.size());
+        if (nBytes == 0)
+          break;
+        else if (nBytes < 0)
+          throw SSHSftpException(_session->getSession()->getError());
+
+        if (fwrite(_buffer.data(), sizeof(char), nBytes, fileHandle.file()) != (std::size_t)nBytes)
+          throw SSHSftpException("Error writing file");
+        size += nBytes;
       }
     }
 
-    int rc = sftp_close(file);
-    if (rc != SSH_OK)
-      throw SSHSftpException(_session->getSession()->getError());
+    logDebug("Downloaded %s, %llu bytes in %.2f s\n", src.c_str(), (unsigned long long)size, secondsSince(start));
+  }
+
+  void SSHSftp::getRange(const std::string &src, const std::string &dest, uint64_t offset, uint64_t length) const {
+    auto lock = _session->lockSession();
+    auto file = createPtr(openRemote(src, O_RDONLY, 0));
+
+    base::FileHandle fileHandle;
+    try {
+      fileHandle = base::FileHandle(dest, "r+b", true);
+    } catch (base::file_error &fe) {
+      throw SSHSftpException(fe.what());
+    }
+
+    download(file->ptr, fileHandle.file(), offset, length);
   }
 
   void SSHSftp::setContent(const std::string &path, const std::string &data) const {
@@ -267,38 +414,113 @@ namespace ssh {
 
   void SSHSftp::put(const std::string &src, const std::string &dest) const {
     auto lock = _session->lockSession();
-    auto file = createPtr(sftp_open(_sftp, createRemotePath(src).c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU));
+    base::FileHandle fileHandle;
+    try {
+      fileHandle = base::FileHandle(src, "rb", true);
+    } catch (base::file_error &fe) {
+      throw SSHSftpException(fe.what());
+    }
 
-    if (!file)
-      throw SSHSftpException(_session->getSession()->getError());
+    auto file = createPtr(openRemote(dest, O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU));
+    auto start = std::chrono::steady_clock::now();
+    uint64_t size = fileSize(fileHandle.file());
+    upload(fileHandle.file(), file->ptr, 0, size);
+    logDebug("Uploaded %s, %llu bytes in %.2f s\n", src.c_str(), (unsigned long long)size, secondsSince(start));
+  }
 
+  void SSHSftp::putRange(const std::string &src, const std::string &dest, uint64_t offset, uint64_t length) const {
+    auto lock = _session->lockSession();
     base::FileHandle fileHandle;
     try {
-      fileHandle = base::FileHandle(src, "w+", true);
+      fileHandle = base::FileHandle(src, "rb", true);
     } catch (base::file_error &fe) {
       throw SSHSftpException(fe.what());
     }
 
-    std::size_t buffSize = 16384;
-    std::vector<char> buff;
-    buff.reserve(buffSize);
-    while (true) {
+    auto file = createPtr(openRemote(dest, O_WRONLY | O_CREAT, S_IRWXU));
+    upload(fileHandle.file(), file->ptr, offset, length);
+  }
 
-      std::size_t nBytes = fread(buff.data(), sizeof(char), buffSize, fileHandle.file());
-      if (nBytes == buffSize) {
-        ssize_t nWritten = sftp_write(file->ptr, buff.data(), buffSize);
-        if (nWritten > 0 && (std::size_t) nWritten != buffSize) {
-          throw SSHSftpException("Error writing file");
-        }
-      } else if (feof(fileHandle.file())) {
-        ssize_t nWritten = sftp_write(file->ptr, buff.data(), nBytes);
-        if (nWritten > 0 && (std::size_t) nWritten != nBytes) {
-          throw SSHSftpException("Error writing file");
+  // Runs transfer for one range of size bytes per session, each on its own thread and sftp channel.
+  static void transferRanges(const std::vector<std::shared_ptr<SSHSession>> &sessions, uint64_t size,
+                             const std::function<void(SSHSftp &, uint64_t, uint64_t)> &transfer) {
+    uint64_t rangeSize = size / sessions.size() + 1;
+    std::vector<std::thread> threads;
+    std::mutex errorMutex;
+    std::string error;
+
+    for (std::size_t i = 0; i < sessions.size() && i * rangeSize < size; ++i) {
+      uint64_t offset = i * rangeSize;
+      uint64_t length = std::min(rangeSize, size - offset);
+      threads.push_back(std::thread([&, i, offset, length]() {
+        try {
+          SSHSftp sftp(sessions[i], 0);
+          transfer(sftp, offset, length);
+        } catch (std::exception &exc) {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if (error.empty())
+            error = exc.what();
         }
-      } else {
-        throw SSHSftpException("Error reading file");
-      }
+      }));
+    }
+
+    for (auto &thread : threads)
+      thread.join();
+
+    if (!error.empty())
+      throw SSHSftpException(error);
+  }
+
+  void SSHSftp::getParallel(const std::vector<std::shared_ptr<SSHSession>> &sessions, const std::string &src,
+                            const std::string &dest) {
+    if (sessions.empty())
+      throw SSHSftpException("No session available for the transfer");
+
+    uint64_t size = SSHSftp(sessions.front(), 0).stat(src).size;
+    try {
+      base::FileHandle(dest, "wb", true);
+    } catch (base::file_error &fe) {
+      throw SSHSftpException(fe.what());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    transferRanges(sessions, size, [&](SSHSftp &sftp, uint64_t offset, uint64_t length) {
+      sftp.getRange(src, dest, offset, length);
+    });
+    logDebug("Downloaded %s over %lu sessions, %llu bytes in %.2f s\n", src.c_str(), (unsigned long)sessions.size(),
+             (unsigned long long)size, secondsSince(start));
+  }
+
+  void SSHSftp::putParallel(const std::vector<std::shared_ptr<SSHSession>> &sessions, const std::string &src,
+                            const std::string &dest) {
+    if (sessions.empty())
+      throw SSHSftpException("No session available for the transfer");
+
+    uint64_t size = 0;
+    try {
+      base::FileHandle fileHandle(src, "rb", true);
+      size = fileSize(fileHandle.file());
+    } catch (base::file_error &fe) {
+      throw SSHSftpException(fe.what());
+    }
+
+    {
+      SSHSftp sftp(sessions.front(), 0);
+      auto lock = sftp._session->lockSession();
+      sftp_close(sftp.openRemote(dest, O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU));
     }
+
+    auto start = std::chrono::steady_clock::now();
+    transferRanges(sessions, size, [&](SSHSftp &sftp, uint64_t offset, uint64_t length) {
+      sftp.putRange(src, dest, offset, length);
+    });
+    logDebug("Uploaded %s over %lu sessions, %llu bytes in %.2f s\n", src.c_str(), (unsigned long)sessions.size(),
+             (unsigned long long)size, secondsSince(start));
+  }
+
+  void SSHSftp::setPipelining(std::size_t chunkSize, std::size_t depth) {
+    _chunkSize = std::max(chunkSize, (std::size_t)1024);
+    _pipelineDepth = std::max(depth, (std::size_t)1);
   }
 
   std::string SSHSftp::getContent(const std::string &src) const {
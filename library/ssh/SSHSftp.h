@@ -41,6 +41,7 @@
 #include "SSHCommon.h"
 #include "SSHSession.h"
 #include "base/any.h"
+#include <cstdio>
 #include <vector>
 
 #if defined(_MSC_VER)
@@ -85,6 +86,9 @@ namespace ssh {
     sftp_session _sftp;
     std::size_t _maxFileLimit;
     std::vector<std::string> _path;
+    std::size_t _chunkSize;
+    std::size_t _pipelineDepth;
+    mutable std::vector<char> _buffer;
   public:
     SSHSftp(std::shared_ptr<SSHSession> session, std::size_t maxFileSize);
     virtual ~SSHSftp();
@@ -95,8 +99,20 @@ namespace ssh {
     void unlink(const std::string &file);
     SftpStatAttrib stat(const std::string &path);
     void get(const std::string &src, const std::string &dest) const;
+    // Transfers length bytes at offset into the same position of dest, which must already exist.
+    void getRange(const std::string &src, const std::string &dest, uint64_t offset, uint64_t length) const;
     void setContent(const std::string &path, const std::string &data) const;
     void put(const std::string &src, const std::string &dest) const;
+    void putRange(const std::string &src, const std::string &dest, uint64_t offset, uint64_t length) const;
+
+    // Split a single file in ranges which are transferred concurrently, one thread and sftp channel per session.
+    static void getParallel(const std::vector<std::shared_ptr<SSHSession>> &sessions, const std::string &src,
+                            const std::string &dest);
+    static void putParallel(const std::vector<std::shared_ptr<SSHSession>> &sessions, const std::string &src,
+                            const std::string &dest);
+
+    // Downloads keep up to depth read requests of chunkSize bytes in flight.
+    void setPipelining(std::size_t chunkSize, std::size_t depth);
     std::string getContent(const std::string &src) const;
     void setMaxFileLimit(std::size_t limit);
     int cd(const std::string &dirname);
@@ -110,6 +126,9 @@ namespace ssh {
     SSHSftp &operator =(SSHSftp&) = delete;
     void throwOnError(int rc) const;
     std::string createRemotePath(const std::string &path) const;
+    sftp_file openRemote(const std::string &path, int accessType, unsigned int mode) const;
+    bool download(sftp_file file, FILE *out, uint64_t offset, uint64_t length) const;
+    void upload(FILE *in, sftp_file file, uint64_t offset, uint64_t length) const;
 
   };
 
@@ -21,6 +21,8 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <algorithm>
+
 #include "SSHTunnelHandler.h"
 
 #include "base/log.h"
@@ -37,14 +39,78 @@ DEFAULT_LOG_DOMAIN("SSHTunnelHandler")
 
 namespace ssh {
 
+  // Number of released ring buffers kept around for new connections.
+  static const std::size_t MaxPooledBuffers = 32;
+
+  RingBuffer::RingBuffer(std::size_t capacity) : _data(capacity, '\0'), _head(0), _size(0) {
+  }
+
+  char *RingBuffer::writePtr(std::size_t &len) {
+    std::size_t tail = (_head + _size) % _data.size();
+    if (full())
+      len = 0;
+    else if (tail >= _head)
+      len = _data.size() - tail;
+    else
+      len = _head - tail;
+    return _data.data() + tail;
+  }
+
+  void RingBuffer::commit(std::size_t len) {
+    _size += len;
+  }
+
+  const char *RingBuffer::readPtr(std::size_t &len) const {
+    len = std::min(_size, _data.size() - _head);
+    return _data.data() + _head;
+  }
+
+  void RingBuffer::consume(std::size_t len) {
+    _size -= len;
+    _head = _size == 0 ? 0 : (_head + len) % _data.size();
+  }
+
+  void RingBuffer::clear() {
+    _head = 0;
+    _size = 0;
+  }
+
+  static bool wouldBlock() {
+#ifdef _MSC_VER
+    int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAEINTR;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+  }
+
+  // The listening socket only signals pending connections, they are accepted here and set up after the poll returned
+  // as the poll context must not be changed while it is being dispatched.
+  static int onListenEvent(socket_t fd, int revents, void *userdata) {
+    static_cast<SSHTunnelHandler *>(userdata)->handleNewConnection(fd);
+    return 0;
+  }
+
+  // This is noop function so ssh_even_dopoll will exit once client socket is ready, the transfer is done afterwards.
+  static int onSocketEvent(socket_t fd, int revents, void *userdata) {
+    //the return should be:
+    //  0 success
+    // -1 the internal ssh_poll_handle was removed/freed and should be removed from the context
+    // -2 an error happened and the ssh_event_dopoll() should stop
+    return 0;
+  }
+
   SSHTunnelHandler::SSHTunnelHandler(uint16_t localPort, int localSocket, std::shared_ptr<SSHSession> session)
-      : _session(std::move(session)), _localPort(localPort), _localSocket(localSocket), _pollTimeout(-1) {
+      : _session(std::move(session)), _localPort(localPort), _localSocket(localSocket) {
     _event = ssh_event_new();
     ssh_event_add_session(_event, _session->getSession()->getCSession());
+    if (ssh_event_add_fd(_event, _localSocket, POLLIN, onListenEvent, this) != SSH_OK)
+      logError("Unable to register tunnel listening socket.\n");
   }
 
   SSHTunnelHandler::~SSHTunnelHandler() {
     stop();
+    ssh_event_remove_fd(_event, _localSocket);
     ssh_event_remove_session(_event, _session->getSession()->getCSession());
     ssh_event_free(_event);
     if (_session) {
@@ -66,204 +132,354 @@ namespace ssh {
     return _session->getConfig();
   }
 
+  std::vector<TunnelChannelStats> SSHTunnelHandler::getChannelStats() const {
+    std::vector<TunnelChannelStats> result;
+    std::lock_guard<std::mutex> lock(_channelMtx);
+    for (auto &it : _channels)
+      result.push_back(it.second->stats);
+    return result;
+  }
+
   void SSHTunnelHandler::run() {
     handleConnection();
   }
 
-  // This is noop function so ssh_even_dopoll will exit once client socket will have new data
-
-    static int onSocketEvent(socket_t fd, int revents, void *userdata) {
-      //the return should be:
-      //  0 success
-      // -1 the internal ssh_poll_handle was removed/freed and should be removed from the context
-      // -2 an error happened and the ssh_event_dopoll() should stop
-      return 0;
-    }
-
   void SSHTunnelHandler::handleConnection() {
     logDebug3("Start tunnel handler thread.\n");
     int rc = 0;
 
     do {
       std::unique_lock<std::recursive_mutex> lock(_newConnMtx);
-      if(!_newConnection.empty()) {
-        prepareTunnel(_newConnection.back());
-        _newConnection.pop_back();
-      }
+      std::vector<int> newConnections;
+      newConnections.swap(_newConnection);
       lock.unlock();
+      for (int clientSocket : newConnections)
+        prepareTunnel(clientSocket);
+
       rc = ssh_event_dopoll(_event, 100);
 
       if (rc == SSH_ERROR) {
         logError("There was an error handling connection poll, retrying: %s\n", _session->getSession()->getError());
 
-        for (auto &sIt : _clientSocketList) {
-          ssh_event_remove_fd(_event, sIt.first);
-          sIt.second->close();
-          wbCloseSocket(sIt.first);
-          sIt.second.reset();
-        }
-        _clientSocketList.clear();
-
+        closeAllChannels();
+        ssh_event_remove_fd(_event, _localSocket);
         ssh_event_remove_session(_event, _session->getSession()->getCSession());
         ssh_event_free(_event);
 
         if (!_session->isConnected())
           _session->reconnect();
         if (!_session->isConnected()) {
+          _event = ssh_event_new();
           logError("Unable to reconnect session.\n");
           break;
         }
 
         _event = ssh_event_new();
         ssh_event_add_session(_event, _session->getSession()->getCSession());
+        ssh_event_add_fd(_event, _localSocket, POLLIN, onListenEvent, this);
         continue;
       }
 
-      for (auto it = _clientSocketList.begin(); it != _clientSocketList.end() && !_stop;) {
+      std::lock_guard<std::mutex> channelLock(_channelMtx);
+      for (auto it = _channels.begin(); it != _channels.end() && !_stop;) {
+        bool keep = false;
         try {
-          transferDataFromClient(it->first, it->second.get());
-          transferDataToClient(it->first, it->second.get());
-          ++it;
+          keep = serviceChannel(*it->second);
         } catch (SSHTunnelException &exc) {
-            ssh_event_remove_fd(_event, it->first);
-            it->second->close();
-            it->second.reset();
-            wbCloseSocket(it->first);
-            it = _clientSocketList.erase(it);
           logError("Error during data transfer: %s\n", exc.what());
         }
+
+        if (keep) {
+          ++it;
+        } else {
+          closeChannel(*it->second);
+          it = _channels.erase(it);
+        }
       }
 
     } while (!_stop);
 
-    for (auto &sIt : _clientSocketList) {
-      ssh_event_remove_fd(_event, sIt.first);
-      sIt.second->close();
-      wbCloseSocket(sIt.first);
-      sIt.second.reset();
-    }
-    _clientSocketList.clear();
+    closeAllChannels();
     logDebug3("Tunnel handler thread stopped.\n");
   }
 
   void SSHTunnelHandler::handleNewConnection(int incomingSocket) {
     logDebug3("About to handle new connection.\n");
-    struct sockaddr_in client;
-    socklen_t addrlen = sizeof(client);
-    errno = 0;
-    int clientSock = accept(incomingSocket, (struct sockaddr*) &client, &addrlen);
-    if (clientSock < 0) {
-      if (errno != EWOULDBLOCK || errno == EINTR)
-        logError("accept() failed: %s\n.", getError().c_str());
+    // The listening socket is non blocking, take everything that queued up since the last poll.
+    while (true) {
+      struct sockaddr_in client;
+      socklen_t addrlen = sizeof(client);
+      errno = 0;
+      int clientSock = accept(incomingSocket, (struct sockaddr*) &client, &addrlen);
+      if (clientSock < 0) {
+        if (!wouldBlock())
+          logError("accept() failed: %s\n.", getError().c_str());
+        return;
+      }
+
+      try {
+        setSocketNonBlocking(clientSock);
+      } catch (SSHTunnelException &exc) {
+        logError("Unable to accept connection: %s\n", exc.what());
+        continue;
+      }
+
+      std::lock_guard<std::recursive_mutex> guard(_newConnMtx);
+      _newConnection.push_back(clientSock);
+      logDebug3("Accepted new connection.\n");
+    }
+  }
+
+  std::unique_ptr<RingBuffer> SSHTunnelHandler::acquireBuffer() {
+    std::size_t capacity = (std::size_t)std::max((ssize_t)1024, _session->getConfig().bufferSize);
+    while (!_bufferPool.empty()) {
+      std::unique_ptr<RingBuffer> buffer = std::move(_bufferPool.back());
+      _bufferPool.pop_back();
+      if (buffer->capacity() == capacity)
+        return buffer;
+    }
+    return std::unique_ptr<RingBuffer>(new RingBuffer(capacity));
+  }
+
+  void SSHTunnelHandler::prepareTunnel(int clientSocket) {
+    std::unique_ptr<TunnelChannel> tunnel(new TunnelChannel());
+    tunnel->socket = clientSocket;
+    tunnel->state = TunnelChannel::Opening;
+    tunnel->events = 0;
+    tunnel->clientEof = false;
+    tunnel->eofSent = false;
+    tunnel->serverEof = false;
+    tunnel->awaitingReply = false;
+    tunnel->openDeadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(_session->getConfig().connectTimeout);
+    tunnel->stats = { clientSocket, 0, 0, 0, 0.0, 0.0 };
+
+    try {
+      tunnel->channel.reset(new ssh::Channel(*(_session->getSession())));
+      ssh_channel_set_blocking(tunnel->channel->getCChannel(), false);
+      openChannel(*tunnel);
+    } catch (std::exception &exc) {
+      wbCloseSocket(clientSocket);
+      logError("Unable to open tunnel. Exception when opening tunnel: %s\n", exc.what());
+      return;
+    } catch (ssh::SshException &exc) {
+      wbCloseSocket(clientSocket);
+      logError("Unable to open tunnel. Exception when opening tunnel: %s\n", exc.getError().c_str());
       return;
     }
 
-    setSocketNonBlocking(clientSock);
+    tunnel->upstream = acquireBuffer();
+    tunnel->downstream = acquireBuffer();
 
-    std::lock_guard<std::recursive_mutex> guard(_newConnMtx);
-    _newConnection.push_back(clientSock);
-    logDebug3("Accepted new connection.\n");
+    std::lock_guard<std::mutex> lock(_channelMtx);
+    _channels.insert(std::make_pair(clientSocket, std::move(tunnel)));
   }
 
-  void SSHTunnelHandler::transferDataFromClient(int sock, ssh::Channel *chan) {
-    ssize_t readlen = 0;
-    std::vector<char> buff(_session->getConfig().bufferSize, '\0');
-
-    while (!_stop && (readlen = recv(sock, buff.data(), buff.size(), 0)) > 0) {
-      int bWritten = 0;
-      for (char* buffPtr = buff.data(); readlen > 0 && !_stop; buffPtr += bWritten, readlen -= bWritten) {
-        try {
-          bWritten = chan->write(buffPtr, readlen);
-          if (bWritten <= 0) {
-            throw SSHTunnelException("unable to write, remote end disconnected");
-          }
-        } catch (SshException &exc) {
-          throw SSHTunnelException(exc.getError());
-        }
-      }
+  // Opening a forward is asynchronous on a non blocking session, it is retried on every loop iteration until the
+  // server answers or the connect timeout is reached.
+  void SSHTunnelHandler::openChannel(TunnelChannel &tunnel) {
+    const SSHConnectionConfig &config = _session->getConfig();
+    int rc = tunnel.channel->openForward(config.remotehost.c_str(), config.remoteport, config.localhost.c_str(),
+                                         config.localport);
+    if (rc == SSH_AGAIN) {
+      if (std::chrono::steady_clock::now() > tunnel.openDeadline)
+        throw SSHTunnelException("Unable to open channel, timeout reached");
+      logDebug3("Channel not yet open, waiting for the server.\n");
+      return;
     }
+
+    if (rc != SSH_OK)
+      throw SSHTunnelException("Unable to open channel");
+
+    tunnel.state = TunnelChannel::Open;
+    updateEvents(tunnel);
+    logDebug("Tunnel created.\n");
   }
 
-  void SSHTunnelHandler::transferDataToClient(int sock, ssh::Channel *chan) {
-    ssize_t readlen = 0;
-    std::vector<char> buff(_session->getConfig().bufferSize, '\0');
-    do {
-      try {
-        readlen = chan->readNonblocking(buff.data(), buff.size());
-      } catch (SshException &exc) {
-        throw SSHTunnelException(exc.getError());
+  // Returns false once the connection has ended on either side and all pending data was delivered.
+  bool SSHTunnelHandler::serviceChannel(TunnelChannel &tunnel) {
+    try {
+      if (tunnel.state == TunnelChannel::Opening) {
+        openChannel(tunnel);
+        if (tunnel.state == TunnelChannel::Opening)
+          return true;
       }
 
-      if (readlen < 0 && readlen != SSH_AGAIN)
-        throw SSHTunnelException("unable to read, remote end disconnected");
+      transferDataFromClient(tunnel);
+      transferDataToClient(tunnel);
+    } catch (SshException &exc) {
+      throw SSHTunnelException(exc.getError());
+    }
+
+    // The client may only have shut down its sending side. Pass that on and keep delivering the server's reply
+    // until the server is done as well (a client that went away completely fails the next send).
+    if (tunnel.clientEof && tunnel.upstream->empty() && !tunnel.eofSent) {
+      if (ssh_channel_send_eof(tunnel.channel->getCChannel()) == SSH_ERROR)
+        throw SSHTunnelException("unable to send EOF, remote end disconnected");
+      tunnel.eofSent = true;
+    }
+    if (tunnel.downstream->empty() && (tunnel.serverEof || tunnel.channel->isEof() || tunnel.channel->isClosed()))
+      return false;
+
+    updateEvents(tunnel);
+    return true;
+  }
 
+  void SSHTunnelHandler::transferDataFromClient(TunnelChannel &tunnel) {
+    RingBuffer &buffer = *tunnel.upstream;
+    while (!tunnel.clientEof && !buffer.full()) {
+      std::size_t len = 0;
+      char *ptr = buffer.writePtr(len);
+      errno = 0;
+      ssize_t readlen = recv(tunnel.socket, ptr, len, 0);
       if (readlen == 0) {
-        if (chan->isClosed())
-          throw SSHTunnelException("channel is closed");
-        break;
+        tunnel.clientEof = true;
+      } else if (readlen < 0) {
+        if (wouldBlock())
+          break;
+        throw SSHTunnelException("unable to read, client disconnected");
+      } else {
+        buffer.commit(readlen);
+        tunnel.stats.bytesFromClient += readlen;
+        if (!tunnel.awaitingReply) {
+          tunnel.awaitingReply = true;
+          tunnel.requestSent = std::chrono::steady_clock::now();
+        }
       }
+    }
 
-      ssize_t bWritten = 0;
-      for (char* buffPtr = buff.data(); readlen > 0 && !_stop; buffPtr += bWritten, readlen -= bWritten) {
-        bWritten = send(sock, buffPtr, readlen, MSG_NOSIGNAL);
-        if (bWritten <= 0)
-          throw SSHTunnelException("unable to write, client disconnected");
-      }
-    } while (!_stop && true);
+    // Only as much as the channel window allows is written, the rest stays queued for the next round.
+    while (!buffer.empty()) {
+      std::size_t len = 0;
+      const char *ptr = buffer.readPtr(len);
+      int bWritten = tunnel.channel->write(ptr, len);
+      if (bWritten < 0)
+        throw SSHTunnelException("unable to write, remote end disconnected");
+      if (bWritten == 0)
+        break;
+      buffer.consume(bWritten);
+    }
   }
 
-  std::unique_ptr<ssh::Channel> SSHTunnelHandler::openTunnel() {
-    std::unique_ptr<ssh::Channel> channel(new ssh::Channel(*(_session->getSession())));
-    ssh_channel_set_blocking(channel->getCChannel(), false);
+  // Data libssh already read from the session socket doesn't wake up the event loop again, so this keeps moving
+  // data until the channel has nothing buffered anymore or the client can't take more.
+  void SSHTunnelHandler::transferDataToClient(TunnelChannel &tunnel) {
+    RingBuffer &buffer = *tunnel.downstream;
+    while (true) {
+      std::uint64_t received = tunnel.stats.bytesToClient;
+      while (!buffer.full() && !tunnel.serverEof) {
+        std::size_t len = 0;
+        char *ptr = buffer.writePtr(len);
+        int readlen = tunnel.channel->readNonblocking(ptr, len);
+        if (readlen == 0 || readlen == SSH_AGAIN)
+          break;
+        // The server closed its side. What was read before is still delivered, the channel is closed once the
+        // client got all of it.
+        if (readlen == SSH_EOF) {
+          tunnel.serverEof = true;
+          break;
+        }
+        if (readlen < 0)
+          throw SSHTunnelException("unable to read, remote end disconnected");
+
+        buffer.commit(readlen);
+        tunnel.stats.bytesToClient += readlen;
+        if (tunnel.awaitingReply) {
+          double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                                     tunnel.requestSent).count();
+          tunnel.awaitingReply = false;
+          tunnel.stats.avgLatency =
+            (tunnel.stats.avgLatency * tunnel.stats.roundTrips + latency) / (tunnel.stats.roundTrips + 1);
+          tunnel.stats.maxLatency = std::max(tunnel.stats.maxLatency, latency);
+          ++tunnel.stats.roundTrips;
+        }
+      }
 
-    int rc = SSH_ERROR;
-    std::size_t i = 0;
+      if (!flushToClient(tunnel) || tunnel.stats.bytesToClient == received || tunnel.serverEof)
+        break;
 
-    while ((_session->getConfig().connectTimeout * 1000 - (i * 100))  > 0) {
-      rc = channel->openForward(_session->getConfig().remotehost.c_str(), _session->getConfig().remoteport,
-                              _session->getConfig().localhost.c_str(), _session->getConfig().localport);
-      if (rc == SSH_AGAIN) {
-        logDebug3("Unable to open channel, wait a moment and retry.\n");
-        i++;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      } else {
-        logDebug("Channel successfully opened\n");
+      int available = ssh_channel_poll(tunnel.channel->getCChannel(), 0);
+      if (available == SSH_ERROR)
+        throw SSHTunnelException("unable to read, remote end disconnected");
+      if (available <= 0) // Nothing buffered or SSH_EOF.
         break;
-      }
     }
-    // If we're here and it's still not ok, we throw exception as we can't open the channel.
-    if (rc != SSH_OK)
-      throw SSHTunnelException("Unable to open channel\n");
+  }
 
-    return channel;
+  // Sends the pending data from the server to the client, returns false if the client socket would block.
+  bool SSHTunnelHandler::flushToClient(TunnelChannel &tunnel) {
+    RingBuffer &buffer = *tunnel.downstream;
+    while (!buffer.empty()) {
+      std::size_t len = 0;
+      const char *ptr = buffer.readPtr(len);
+      errno = 0;
+      ssize_t bWritten = send(tunnel.socket, ptr, len, MSG_NOSIGNAL);
+      if (bWritten < 0) {
+        if (wouldBlock())
+          return false;
+        throw SSHTunnelException("unable to write, client disconnected");
+      }
+      buffer.consume(bWritten);
+    }
+    return true;
   }
 
-  void SSHTunnelHandler::prepareTunnel(int clientSocket) {
-    std::unique_ptr<ssh::Channel> channel;
-    try {
-      channel = std::move(openTunnel());
-    } catch (ssh::SSHTunnelException &exc) {
-      wbCloseSocket(clientSocket);
-      logError("Unable to open tunnel. Exception when opening tunnel: %s\n", exc.what());
-      return;
-    } catch (ssh::SshException &exc) {
-      wbCloseSocket(clientSocket);
-      logError("Unable to open tunnel. Exception when opening tunnel: %s\n", exc.getError().c_str());
+  // Client sockets are only polled for what they can do right now: reading while there is room to queue data for
+  // the channel and writing while data from the server is pending. Otherwise a level triggered poll would spin.
+  void SSHTunnelHandler::updateEvents(TunnelChannel &tunnel) {
+    short events = 0;
+    if (!tunnel.clientEof && !tunnel.upstream->full())
+      events |= POLLIN;
+    if (!tunnel.downstream->empty())
+      events |= POLLOUT;
+
+    if (events == tunnel.events)
       return;
+
+    if (tunnel.events != 0)
+      ssh_event_remove_fd(_event, tunnel.socket);
+    tunnel.events = 0;
+    if (events != 0) {
+      if (ssh_event_add_fd(_event, tunnel.socket, events, onSocketEvent, this) != SSH_OK)
+        throw SSHTunnelException("could not register event handler");
+      tunnel.events = events;
     }
+  }
 
-    short events = POLLIN;
-    if (ssh_event_add_fd(_event, clientSocket, events, onSocketEvent, this) != SSH_OK) {
-      logError("Unable to open tunnel. Could not register event handler.\n");
-      channel.reset();
-      wbCloseSocket(clientSocket);
-      return;
-    } else {
-      logDebug("Tunnel created.\n");
+  void SSHTunnelHandler::closeChannel(TunnelChannel &tunnel) {
+    if (tunnel.events != 0)
+      ssh_event_remove_fd(_event, tunnel.socket);
+    tunnel.events = 0;
+
+    if (tunnel.channel) {
+      try {
+        if (tunnel.channel->isOpen())
+          tunnel.channel->close();
+      } catch (SshException &exc) {
+        logDebug3("Error closing channel: %s\n", exc.getError().c_str());
+      }
+      tunnel.channel.reset();
     }
+    wbCloseSocket(tunnel.socket);
+
+    for (auto buffer : { &tunnel.upstream, &tunnel.downstream }) {
+      if (*buffer && _bufferPool.size() < MaxPooledBuffers) {
+        (*buffer)->clear();
+        _bufferPool.push_back(std::move(*buffer));
+      }
+    }
+
+    logDebug("Tunnel connection closed, %llu bytes sent, %llu bytes received, %lu round trips, "
+             "avg latency %.2f ms, max latency %.2f ms\n",
+             (unsigned long long)tunnel.stats.bytesFromClient, (unsigned long long)tunnel.stats.bytesToClient,
+             (unsigned long)tunnel.stats.roundTrips, tunnel.stats.avgLatency, tunnel.stats.maxLatency);
+  }
 
-    _clientSocketList.insert(std::make_pair(clientSocket, std::move(channel)));
-    return;
+  void SSHTunnelHandler::closeAllChannels() {
+    std::lock_guard<std::mutex> lock(_channelMtx);
+    for (auto &it : _channels)
+      closeChannel(*it.second);
+    _channels.clear();
   }
 
 } /* namespace ssh */
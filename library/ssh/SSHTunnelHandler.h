@@ -28,7 +28,10 @@
 #include <poll.h>
 #endif
 #include <string.h>
+#include <chrono>
+#include <cstdint>
 #include <thread>
+#include <memory>
 #include <map>
 #include <mutex>
 #include <vector>
@@ -36,6 +39,68 @@
 #include "SSHSession.h"
 
 namespace ssh {
+  // Fixed size byte queue staging data between a client socket and its ssh channel. The storage is allocated once
+  // and recycled between connections.
+  class WBSSHLIBRARY_PUBLIC_FUNC RingBuffer {
+  public:
+    explicit RingBuffer(std::size_t capacity);
+    std::size_t size() const {
+      return _size;
+    }
+    std::size_t capacity() const {
+      return _data.size();
+    }
+    bool empty() const {
+      return _size == 0;
+    }
+    bool full() const {
+      return _size == _data.size();
+    }
+
+    // Contiguous free region following the stored data, len receives its size.
+    char *writePtr(std::size_t &len);
+    void commit(std::size_t len);
+    // Contiguous region at the start of the stored data, len receives its size.
+    const char *readPtr(std::size_t &len) const;
+    void consume(std::size_t len);
+    void clear();
+
+  private:
+    std::vector<char> _data;
+    std::size_t _head;
+    std::size_t _size;
+  };
+
+  struct TunnelChannelStats {
+    int socket;
+    std::uint64_t bytesFromClient;
+    std::uint64_t bytesToClient;
+    std::size_t roundTrips;
+    double avgLatency; // ms between forwarding client data and the first byte of the reply.
+    double maxLatency;
+  };
+
+  // One forwarded client connection, owned and serviced by the tunnel event loop only.
+  struct TunnelChannel {
+    enum State { Opening, Open };
+
+    int socket;
+    std::unique_ptr<ssh::Channel> channel;
+    std::unique_ptr<RingBuffer> upstream;   // client -> server
+    std::unique_ptr<RingBuffer> downstream; // server -> client
+    State state;
+    short events; // poll events currently registered for socket.
+    bool clientEof;
+    bool eofSent;   // The client's EOF was forwarded to the channel.
+    bool serverEof; // The server sent EOF and libssh has no more data buffered for the channel.
+    bool awaitingReply;
+    std::chrono::steady_clock::time_point openDeadline;
+    std::chrono::steady_clock::time_point requestSent;
+    TunnelChannelStats stats;
+  };
+
+  // Forwards all client connections of a tunnel over a single ssh session. One thread runs an event loop which
+  // multiplexes the listening socket, the client sockets and the session socket, moving data with non-blocking I/O.
   class WBSSHLIBRARY_PUBLIC_FUNC SSHTunnelHandler : public SSHThread {
   public:
     SSHTunnelHandler(uint16_t localPort, int localSocket, std::shared_ptr<ssh::SSHSession> session);
@@ -43,25 +108,32 @@ namespace ssh {
     int getLocalSocket() const;
     int getLocalPort() const;
     SSHConnectionConfig getConfig() const;
+    std::vector<TunnelChannelStats> getChannelStats() const;
 
     void handleConnection();
     void handleNewConnection(int incomingSocket);
-    void transferDataFromClient(int sock, ssh::Channel *chan);
-    void transferDataToClient(int sock, ssh::Channel *chan);
-
-    std::unique_ptr<ssh::Channel> openTunnel();
-    void prepareTunnel(int clientSocket);
 
   protected:
     virtual void run() override;
 
+    void prepareTunnel(int clientSocket);
+    bool serviceChannel(TunnelChannel &tunnel);
+    void openChannel(TunnelChannel &tunnel);
+    void transferDataFromClient(TunnelChannel &tunnel);
+    void transferDataToClient(TunnelChannel &tunnel);
+    bool flushToClient(TunnelChannel &tunnel);
+    void updateEvents(TunnelChannel &tunnel);
+    void closeChannel(TunnelChannel &tunnel);
+    void closeAllChannels();
+    std::unique_ptr<RingBuffer> acquireBuffer();
+
     std::shared_ptr<SSHSession> _session;
     uint16_t _localPort;
     int _localSocket;
-    std::map<int, std::unique_ptr<ssh::Channel>> _clientSocketList;
-    int _pollTimeout;
+    std::map<int, std::unique_ptr<TunnelChannel>> _channels;
+    mutable std::mutex _channelMtx;
+    std::vector<std::unique_ptr<RingBuffer>> _bufferPool;
     ssh_event _event;
-    std::vector<int> _sockRemovalList;
     std::recursive_mutex _newConnMtx;
     std::vector<int> _newConnection;
   };
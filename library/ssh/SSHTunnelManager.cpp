@@ -139,7 +139,6 @@ namespace ssh {
     std::unique_ptr<SSHTunnelHandler> handler(new SSHTunnelHandler(ret.port, ret.socketHandle, session));
     handler->start();
     _socketList.insert(std::make_pair(ret.socketHandle, std::move(handler)));
-    pokeWakeupSocket();  // If we're connected, we should notify manager that it shoud reload connection list.
     return std::make_tuple(SSHReturnType::CONNECTED, ret.port);
   }
 
@@ -171,16 +170,8 @@ namespace ssh {
 
 
   void SSHTunnelManager::localSocketHandler() {
+    // Tunnel listening sockets are served by the event loop of their handler, only the wakeup socket is watched here.
     std::vector<pollfd> socketList;
-    {
-      auto sockLock = lockSocketList();
-      for (auto &it : _socketList) {
-        pollfd p;
-        p.fd = it.second->getLocalSocket();
-        p.events = POLLIN;
-        socketList.push_back(p);
-      }
-    }
     {
       pollfd p;
       p.fd = _wakeupSocket;
@@ -210,53 +201,16 @@ namespace ssh {
           break;
         }
 
-        if (pollIt.fd == _wakeupSocket)  // This is special case we reload fds and continue.
-            {
-          logDebug2("Wakeup socket got connection, reloading socketList.\n");
-          socketList.clear();
+        if (pollIt.fd == _wakeupSocket) {
+          logDebug2("Wakeup socket got connection.\n");
           acceptAndClose(pollIt.fd);
           if (_stop)
             break;
-
-          {
-            auto sockLock = lockSocketList();
-            for (auto &it : _socketList) {
-              pollfd p;
-              p.fd = it.second->getLocalSocket();
-              p.events = POLLIN;
-              socketList.push_back(p);
-            }
-          }
-
-          {
-            pollfd p;
-            p.fd = _wakeupSocket;
-            p.events = POLLIN;
-            socketList.push_back(p);
-          }
           continue;
-        } else { // This is a new connection, we need to handle it.
-          auto sockLock = lockSocketList();
-          auto it = _socketList.find(pollIt.fd);
-          if (it != _socketList.end()) {
-            it->second->handleNewConnection(pollIt.fd);
-          } else {
-            // Let's check if this is something that wasn't removed from the sock list, then just close it.
-            bool found = false;
-            for (auto s : pollSocketList) {
-              if (s.fd == pollIt.fd && s.fd != _wakeupSocket) {
-                shutdown(pollIt.fd, SHUT_RDWR);
-                found = true;
-                break;
-              }
-            }
-
-            if (!found) {
-              logError("Something went wrong, incoming socket connection wasn't found in the socketList, abort.\n");
-              _stop = true;
-              break;
-            }
-          }
+        } else {
+          logError("Something went wrong, unexpected socket in the poll list, abort.\n");
+          _stop = true;
+          break;
         }
       }
     } while (!_stop);
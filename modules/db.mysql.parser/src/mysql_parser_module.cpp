@@ -671,6 +671,7 @@ MySQLQueryType MySQLParserServicesImpl::determineQueryType(MySQLParserContext::R
  */
 void resolveReferences(db_mysql_CatalogRef catalog, DbObjectsRefsCache &refCache, bool caseSensitive) {
   grt::ListRef<db_mysql_Schema> schemata = catalog->schemata();
+  grt::index_list(schemata);
 
   for (DbObjectsRefsCache::iterator refIt = refCache.begin(); refIt != refCache.end(); ++refIt) {
     DbObjectReferences references = (*refIt);
@@ -681,6 +682,7 @@ void resolveReferences(db_mysql_CatalogRef catalog, DbObjectsRefsCache &refCache
       if (!schema.is_valid()) // Implicitly create the schema if we reference one not yet created.
         schema = ObjectListener::ensureSchemaExists(catalog, references.targetIdentifier.first, caseSensitive);
 
+      grt::index_list(schema->tables());
       referencedTable = find_named_object_in_list(schema->tables(), references.targetIdentifier.second, caseSensitive);
       if (!referencedTable.is_valid()) {
         // If we don't find a table with the given name we create a stub object to be used instead.
@@ -701,6 +703,10 @@ void resolveReferences(db_mysql_CatalogRef catalog, DbObjectsRefsCache &refCache
     }
 
     // Resolve columns.
+    if (references.table.is_valid())
+      grt::index_list(references.table->columns());
+    if (referencedTable.is_valid())
+      grt::index_list(referencedTable->columns());
     switch (references.type) {
       case DbObjectReferences::Index: {
         // Filling column references for an index.
@@ -1464,6 +1470,9 @@ size_t MySQLParserServicesImpl::parseSQLIntoCatalog(MySQLParserContext::Ref cont
 
   bool caseSensitive = impl->caseSensitive;
 
+  // Scripts can create many thousands of objects, each of which is looked up by name in its owner's list.
+  grt::index_list(catalog->schemata());
+
   std::string startSchema = options.get_string("schema");
   db_mysql_SchemaRef currentSchema;
   if (!startSchema.empty())
@@ -1563,6 +1572,8 @@ size_t MySQLParserServicesImpl::parseSQLIntoCatalog(MySQLParserContext::Ref cont
 
         db_mysql_SchemaRef schema =
           db_mysql_SchemaRef::cast_from(table->owner()); // Might be different from current schema.
+        grt::index_list(schema->tables());
+        grt::index_list(schema->views());
 
         // Ignore tables that use a name that is already used for a view (no drop/new-add takes place then).
         db_mysql_ViewRef existingView = find_named_object_in_list(schema->views(), table->name());
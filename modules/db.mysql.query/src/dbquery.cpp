@@ -21,11 +21,15 @@
  * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
  */
 
+#include <atomic>
+#include <list>
 #include <map>
 #include <memory>
+#include <thread>
 
 #include "grtpp_module_cpp.h"
 #include "cppdbc.h"
+#include "status_sampler.h"
 
 #include "grts/structs.db.mgmt.h"
 
@@ -40,10 +44,23 @@
 class DbMySQLQueryImpl : public grt::ModuleImplBase {
 public:
   DbMySQLQueryImpl(grt::CPPModuleLoader *loader)
-    : grt::ModuleImplBase(loader), _last_error_code(0), _connection_id(0), _resultset_id(0), _tunnel_id(0) {
+    : grt::ModuleImplBase(loader), _last_error_code(0), _connection_id(0), _resultset_id(0), _tunnel_id(0), _parallel_dump_id(0),
+      _parallel_restore_id(0), _status_sampler_id(0) {
   }
 
   virtual ~DbMySQLQueryImpl() {
+    for (auto &dump : _parallel_dumps) {
+      dump.second->dump->cancel();
+      if (dump.second->thread.joinable())
+        dump.second->thread.join();
+    }
+    for (auto &restore : _parallel_restores) {
+      restore.second->restore->cancel();
+      if (restore.second->thread.joinable())
+        restore.second->thread.join();
+    }
+    for (auto &sampler : _status_samplers)
+      sampler.second->stop();
   }
 
   DEFINE_INIT_MODULE_DOC(
@@ -167,6 +184,102 @@ public:
                                 "Utility function to return a dictionary containing name/value pairs for the server "
                                 "variables, as returned by SHOW VARIABLES.",
                                 "conn_id the connection id"),
+    DECLARE_MODULE_FUNCTION_DOC(
+      DbMySQLQueryImpl::openParallelDump,
+      "Starts a logical dump of the given tables in the background, using several connections to the server.\n"
+      "All connections share a consistent snapshot. Tables are split into primary key ranges, which are written as\n"
+      "compressed SQL scripts along with a manifest.json file describing the dump.\n"
+      "Returns a dump id to be used with the other parallelDump functions or -1 on error. See lastError() for the "
+      "exact error.\n"
+      "The dump must be released with closeParallelDump() once done.",
+      "info the connection information object for the MySQL instance to dump\n"
+      "password the password for the account used by the connections\n"
+      "objects a dict with the names of the schemas to dump as keys and lists of table and view names as values\n"
+      "options a dict with the dump options: outputDirectory, connections, chunkRows, insertSize, compressionLevel, "
+      "consistent, dumpStructure, dumpData, dumpTriggers, dumpRoutines and dumpEvents"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::parallelDumpStatus,
+                                "Returns a dict with the progress (0.0 - 1.0), status text, error count and done flag "
+                                "of a dump, plus the log messages written since the last call.",
+                                "dump_id the dump id returned by openParallelDump()"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::cancelParallelDump, "Asks a running dump to stop.",
+                                "dump_id the dump id returned by openParallelDump()"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::closeParallelDump,
+                                "Waits for a dump to finish and releases it. Returns the number of errors.",
+                                "dump_id the dump id returned by openParallelDump()"),
+    DECLARE_MODULE_FUNCTION_DOC(
+      DbMySQLQueryImpl::openParallelRestore,
+      "Prepares a restore of dump files using several connections to the server. Scripts are added with "
+      "parallelRestoreAddManifest() and parallelRestoreAddScript(), then the restore is run in the background by "
+      "startParallelRestore().\n"
+      "Returns a restore id to be used with the other parallelRestore functions or -1 on error. See lastError() for "
+      "the exact error.\n"
+      "The restore must be released with closeParallelRestore() once done.",
+      "info the connection information object for the MySQL instance to restore to\n"
+      "password the password for the account used by the connections\n"
+      "options a dict with the restore options: connections and deferIndexes"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::parallelRestoreAddManifest,
+                                "Adds a dump folder written by openParallelDump(). Returns 0 or -1 if the manifest "
+                                "could not be read. See lastError() for the exact error.",
+                                "restore_id the restore id returned by openParallelRestore()\n"
+                                "folder the dump folder containing manifest.json\n"
+                                "selection a dict with the names of the schemas to restore as keys and lists of table "
+                                "and view names as values, an empty dict restores everything"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::parallelRestoreAddScript,
+                                "Adds a script of a Dump Project Folder, as written by mysqldump for a single table.",
+                                "restore_id the restore id returned by openParallelRestore()\n"
+                                "schema the schema the script is run in\n"
+                                "table the table restored by the script, empty for scripts with views and routines, "
+                                "which are run after all tables\n"
+                                "path the path of the script"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::startParallelRestore, "Starts the restore in the background.",
+                                "restore_id the restore id returned by openParallelRestore()"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::parallelRestoreStatus,
+                                "Returns a dict with the progress (0.0 - 1.0), status text, error count and done flag "
+                                "of a restore, the log messages written since the last call and a workers list with "
+                                "the rows, rowsPerSecond and current task of each connection.",
+                                "restore_id the restore id returned by openParallelRestore()"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::cancelParallelRestore, "Asks a running restore to stop.",
+                                "restore_id the restore id returned by openParallelRestore()"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::closeParallelRestore,
+                                "Waits for a restore to finish and releases it. Returns the number of errors.",
+                                "restore_id the restore id returned by openParallelRestore()"),
+    DECLARE_MODULE_FUNCTION_DOC(
+      DbMySQLQueryImpl::openStatusSampler,
+      "Starts sampling the global status variables and performance_schema summaries of a server in the background, "
+      "on a connection of its own. Samples are kept in a ring buffer, older data in a downsampled history which is "
+      "kept between sessions if a history file is given.\n"
+      "Returns a sampler id to be used with the other statusSampler functions or -1 on error. See lastError() for the "
+      "exact error.\n"
+      "The sampler must be released with closeStatusSampler().",
+      "info the connection information object for the MySQL instance to sample\n"
+      "password the password for the account used by the connection\n"
+      "options a dict with the sampler options: interval (seconds), capacity (samples), maxVariables, "
+      "performanceSchema, historyInterval (seconds), historyLength (entries) and historyFile"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::statusSamplerLatest,
+                                "Returns a dict with the time of the latest sample (0 if there is none yet), the "
+                                "number of samples taken so far, the last sampling error and a variables dict "
+                                "with the values of that sample, as returned by SHOW GLOBAL STATUS.",
+                                "sampler_id the sampler id returned by openStatusSampler()"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::statusSamplerSeries,
+                                "Returns the samples of a numeric variable still in the ring buffer, as a dict with "
+                                "times and values lists, oldest first.",
+                                "sampler_id the sampler id returned by openStatusSampler()\n"
+                                "name the name of the variable\n"
+                                "seconds how far to go back from the latest sample, 0 for all samples"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::statusSamplerRate,
+                                "Returns the average change per second of a counter.",
+                                "sampler_id the sampler id returned by openStatusSampler()\n"
+                                "name the name of the variable\n"
+                                "seconds how far to go back from the latest sample, 0 for all samples"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::statusSamplerHistory,
+                                "Returns the downsampled history of a numeric variable, as a dict with times and "
+                                "values lists, oldest first.",
+                                "sampler_id the sampler id returned by openStatusSampler()\n"
+                                "name the name of the variable\n"
+                                "seconds how far to go back from the latest entry, 0 for the whole history"),
+    DECLARE_MODULE_FUNCTION_DOC(DbMySQLQueryImpl::closeStatusSampler,
+                                "Stops sampling, saves the history and releases the sampler.",
+                                "sampler_id the sampler id returned by openStatusSampler()"),
     NULL);
 
   // returns connection-id or -1 for error
@@ -230,6 +343,31 @@ public:
 
   std::string scramblePassword(const std::string &pass);
 
+  // returns dump-id or -1 for error
+  int openParallelDump(const db_mgmt_ConnectionRef &info, const grt::StringRef &password, grt::DictRef objects,
+                       grt::DictRef options);
+  grt::DictRef parallelDumpStatus(int dump);
+  int cancelParallelDump(int dump);
+  int closeParallelDump(int dump);
+
+  // returns restore-id or -1 for error
+  int openParallelRestore(const db_mgmt_ConnectionRef &info, const grt::StringRef &password, grt::DictRef options);
+  int parallelRestoreAddManifest(int restore, const std::string &folder, grt::DictRef selection);
+  int parallelRestoreAddScript(int restore, const std::string &schema, const std::string &table,
+                               const std::string &path);
+  int startParallelRestore(int restore);
+  grt::DictRef parallelRestoreStatus(int restore);
+  int cancelParallelRestore(int restore);
+  int closeParallelRestore(int restore);
+
+  // returns sampler-id or -1 for error
+  int openStatusSampler(const db_mgmt_ConnectionRef &info, const grt::StringRef &password, grt::DictRef options);
+  grt::DictRef statusSamplerLatest(int sampler);
+  grt::DictRef statusSamplerSeries(int sampler, const std::string &name, double seconds);
+  double statusSamplerRate(int sampler, const std::string &name, double seconds);
+  grt::DictRef statusSamplerHistory(int sampler, const std::string &name, double seconds);
+  int closeStatusSampler(int sampler);
+
 private:
   struct ConnectionInfo {
     typedef std::shared_ptr<ConnectionInfo> Ref;
@@ -256,8 +394,45 @@ private:
     //    #endif
   };
 
+  struct ParallelDumpInfo {
+    typedef std::shared_ptr<ParallelDumpInfo> Ref;
+
+    ParallelDumpInfo() : done(false), result(0) {
+    }
+
+    std::unique_ptr<sql::ParallelDump> dump;
+    std::thread thread;
+    base::Mutex log_mutex;
+    std::list<std::string> log;
+    std::atomic<bool> done;
+    int result;
+  };
+
+  struct ParallelRestoreInfo {
+    typedef std::shared_ptr<ParallelRestoreInfo> Ref;
+
+    ParallelRestoreInfo() : done(false), result(0) {
+    }
+
+    std::unique_ptr<sql::ParallelRestore> restore;
+    std::thread thread;
+    base::Mutex log_mutex;
+    std::list<std::string> log;
+    std::atomic<bool> done;
+    int result;
+  };
+
+  std::vector<sql::ConnectionWrapper> open_parallel_connections(const db_mgmt_ConnectionRef &info,
+                                                                const grt::StringRef &password, ssize_t count);
+  ParallelDumpInfo::Ref get_parallel_dump(int dump);
+  ParallelRestoreInfo::Ref get_parallel_restore(int restore);
+  std::shared_ptr<StatusSampler> get_status_sampler(int sampler);
+
   base::Mutex _mutex;
   std::map<int, ConnectionInfo::Ref> _connections;
+  std::map<int, ParallelDumpInfo::Ref> _parallel_dumps;
+  std::map<int, ParallelRestoreInfo::Ref> _parallel_restores;
+  std::map<int, std::shared_ptr<StatusSampler> > _status_samplers;
   std::map<int, sql::ResultSet *> _resultsets;
   std::map<int, std::shared_ptr<sql::TunnelConnection> > _tunnels;
   std::string _last_error;
@@ -266,6 +441,9 @@ private:
   int _connection_id;
   base::refcount_t _resultset_id;
   int _tunnel_id;
+  int _parallel_dump_id;
+  int _parallel_restore_id;
+  int _status_sampler_id;
 };
 
 GRT_MODULE_ENTRY_POINT(DbMySQLQueryImpl);
@@ -810,3 +988,366 @@ int DbMySQLQueryImpl::closeTunnel(int tunnel) {
   _tunnels.erase(tunnel);
   return 0;
 }
+
+int DbMySQLQueryImpl::openParallelDump(const db_mgmt_ConnectionRef &info, const grt::StringRef &password,
+                                       grt::DictRef objects, grt::DictRef options) {
+  if (!info.is_valid())
+    throw std::invalid_argument("connection info is NULL");
+  if (!objects.is_valid() || !options.is_valid())
+    throw std::invalid_argument("objects and options must be given");
+
+  sql::ParallelDump::Options dump_options;
+  dump_options.output_dir = options.get_string("outputDirectory");
+  dump_options.chunk_rows = (size_t)options.get_int("chunkRows", (ssize_t)dump_options.chunk_rows);
+  dump_options.insert_size = (size_t)options.get_int("insertSize", (ssize_t)dump_options.insert_size);
+  dump_options.compression_level = (int)options.get_int("compressionLevel", dump_options.compression_level);
+  dump_options.consistent = options.get_int("consistent", dump_options.consistent) != 0;
+  dump_options.dump_structure = options.get_int("dumpStructure", dump_options.dump_structure) != 0;
+  dump_options.dump_data = options.get_int("dumpData", dump_options.dump_data) != 0;
+  dump_options.dump_triggers = options.get_int("dumpTriggers", dump_options.dump_triggers) != 0;
+  dump_options.dump_routines = options.get_int("dumpRoutines", dump_options.dump_routines) != 0;
+  dump_options.dump_events = options.get_int("dumpEvents", dump_options.dump_events) != 0;
+  if (dump_options.output_dir.empty())
+    throw std::invalid_argument("outputDirectory option is missing");
+
+  CLEAR_ERROR();
+
+  ParallelDumpInfo::Ref dump_info(new ParallelDumpInfo());
+  try {
+    std::vector<sql::ConnectionWrapper> connections(
+      open_parallel_connections(info, password, options.get_int("connections", 4)));
+    dump_info->dump.reset(new sql::ParallelDump(connections, dump_options));
+  } catch (sql::SQLException &exc) {
+    _last_error = exc.what();
+    _last_error_code = exc.getErrorCode();
+    return -1;
+  }
+
+  for (grt::DictRef::const_iterator schema = objects.begin(); schema != objects.end(); ++schema) {
+    std::vector<std::string> tables;
+    grt::StringListRef names(grt::StringListRef::cast_from(schema->second));
+    for (size_t i = 0; names.is_valid() && i < names.count(); ++i)
+      tables.push_back(names[i]);
+    dump_info->dump->add_schema(schema->first, tables);
+  }
+
+  // The dump reports from its worker threads, so messages are queued until the next status request.
+  ParallelDumpInfo *raw_info = dump_info.get();
+  dump_info->dump->log_cb([raw_info](const std::string &message) {
+    base::MutexLock lock(raw_info->log_mutex);
+    raw_info->log.push_back(message);
+  });
+
+  int dump_id;
+  {
+    base::MutexLock lock(_mutex);
+    dump_id = ++_parallel_dump_id;
+    _parallel_dumps[dump_id] = dump_info;
+  }
+
+  dump_info->thread = std::thread([raw_info]() {
+    try {
+      raw_info->result = raw_info->dump->run();
+    } catch (std::exception &exc) {
+      base::MutexLock lock(raw_info->log_mutex);
+      raw_info->log.push_back(std::string("ERROR: ") + exc.what());
+      raw_info->result = raw_info->dump->error_count() + 1;
+    }
+    raw_info->done = true;
+  });
+
+  return dump_id;
+}
+
+std::vector<sql::ConnectionWrapper> DbMySQLQueryImpl::open_parallel_connections(const db_mgmt_ConnectionRef &info,
+                                                                                const grt::StringRef &password,
+                                                                                ssize_t count) {
+  sql::DriverManager *dm = sql::DriverManager::getDriverManager();
+  sql::Authentication::Ref auth = sql::Authentication::create(info, "");
+  if (password.is_valid())
+    auth->set_password(password.c_str());
+  std::shared_ptr<sql::TunnelConnection> tunnel = dm->getTunnel(info);
+
+  std::vector<sql::ConnectionWrapper> connections;
+  for (ssize_t i = 0; i < std::max((ssize_t)1, count); ++i)
+    connections.push_back(dm->getConnection(info, tunnel, auth));
+  return connections;
+}
+
+DbMySQLQueryImpl::ParallelDumpInfo::Ref DbMySQLQueryImpl::get_parallel_dump(int dump) {
+  base::MutexLock lock(_mutex);
+  std::map<int, ParallelDumpInfo::Ref>::const_iterator iter = _parallel_dumps.find(dump);
+  if (iter == _parallel_dumps.end())
+    throw std::invalid_argument("Invalid dump-id");
+  return iter->second;
+}
+
+grt::DictRef DbMySQLQueryImpl::parallelDumpStatus(int dump) {
+  ParallelDumpInfo::Ref info(get_parallel_dump(dump));
+
+  grt::DictRef status(true);
+  bool done = info->done;
+  status.gset("done", done ? 1 : 0);
+  status.gset("progress", done && !info->dump->cancelled() ? 1.0 : info->dump->progress());
+  status.gset("status", info->dump->status_text());
+  status.gset("errors", done ? info->result : info->dump->error_count());
+
+  grt::StringListRef log(grt::Initialized);
+  {
+    base::MutexLock lock(info->log_mutex);
+    for (const std::string &message : info->log)
+      log.insert(message);
+    info->log.clear();
+  }
+  status.set("log", log);
+
+  return status;
+}
+
+int DbMySQLQueryImpl::cancelParallelDump(int dump) {
+  get_parallel_dump(dump)->dump->cancel();
+  return 0;
+}
+
+int DbMySQLQueryImpl::closeParallelDump(int dump) {
+  ParallelDumpInfo::Ref info(get_parallel_dump(dump));
+  if (info->thread.joinable())
+    info->thread.join();
+
+  base::MutexLock lock(_mutex);
+  _parallel_dumps.erase(dump);
+  return info->result;
+}
+
+int DbMySQLQueryImpl::openParallelRestore(const db_mgmt_ConnectionRef &info, const grt::StringRef &password,
+                                          grt::DictRef options) {
+  if (!info.is_valid())
+    throw std::invalid_argument("connection info is NULL");
+  if (!options.is_valid())
+    throw std::invalid_argument("options must be given");
+
+  sql::ParallelRestore::Options restore_options;
+  restore_options.defer_indexes = options.get_int("deferIndexes", restore_options.defer_indexes) != 0;
+
+  CLEAR_ERROR();
+
+  ParallelRestoreInfo::Ref restore_info(new ParallelRestoreInfo());
+  try {
+    std::vector<sql::ConnectionWrapper> connections(
+      open_parallel_connections(info, password, options.get_int("connections", 4)));
+    restore_info->restore.reset(new sql::ParallelRestore(connections, restore_options));
+  } catch (sql::SQLException &exc) {
+    _last_error = exc.what();
+    _last_error_code = exc.getErrorCode();
+    return -1;
+  }
+
+  ParallelRestoreInfo *raw_info = restore_info.get();
+  restore_info->restore->log_cb([raw_info](const std::string &message) {
+    base::MutexLock lock(raw_info->log_mutex);
+    raw_info->log.push_back(message);
+  });
+
+  base::MutexLock lock(_mutex);
+  int restore_id = ++_parallel_restore_id;
+  _parallel_restores[restore_id] = restore_info;
+  return restore_id;
+}
+
+DbMySQLQueryImpl::ParallelRestoreInfo::Ref DbMySQLQueryImpl::get_parallel_restore(int restore) {
+  base::MutexLock lock(_mutex);
+  std::map<int, ParallelRestoreInfo::Ref>::const_iterator iter = _parallel_restores.find(restore);
+  if (iter == _parallel_restores.end())
+    throw std::invalid_argument("Invalid restore-id");
+  return iter->second;
+}
+
+int DbMySQLQueryImpl::parallelRestoreAddManifest(int restore, const std::string &folder, grt::DictRef selection) {
+  ParallelRestoreInfo::Ref info(get_parallel_restore(restore));
+
+  std::map<std::string, std::set<std::string> > objects;
+  for (grt::DictRef::const_iterator schema = selection.begin(); selection.is_valid() && schema != selection.end();
+       ++schema) {
+    std::set<std::string> &tables = objects[schema->first];
+    grt::StringListRef names(grt::StringListRef::cast_from(schema->second));
+    for (size_t i = 0; names.is_valid() && i < names.count(); ++i)
+      tables.insert(names[i]);
+  }
+
+  CLEAR_ERROR();
+  try {
+    info->restore->add_manifest(folder, objects);
+  } catch (std::exception &exc) {
+    _last_error = exc.what();
+    return -1;
+  }
+  return 0;
+}
+
+int DbMySQLQueryImpl::parallelRestoreAddScript(int restore, const std::string &schema, const std::string &table,
+                                               const std::string &path) {
+  get_parallel_restore(restore)->restore->add_script(schema, table, path);
+  return 0;
+}
+
+int DbMySQLQueryImpl::startParallelRestore(int restore) {
+  ParallelRestoreInfo::Ref info(get_parallel_restore(restore));
+  if (info->thread.joinable())
+    throw std::logic_error("Restore was already started");
+
+  ParallelRestoreInfo *raw_info = info.get();
+  info->thread = std::thread([raw_info]() {
+    try {
+      raw_info->result = raw_info->restore->run();
+    } catch (std::exception &exc) {
+      base::MutexLock lock(raw_info->log_mutex);
+      raw_info->log.push_back(std::string("ERROR: ") + exc.what());
+      raw_info->result = raw_info->restore->error_count() + 1;
+    }
+    raw_info->done = true;
+  });
+  return 0;
+}
+
+grt::DictRef DbMySQLQueryImpl::parallelRestoreStatus(int restore) {
+  ParallelRestoreInfo::Ref info(get_parallel_restore(restore));
+
+  grt::DictRef status(true);
+  bool done = info->done;
+  status.gset("done", done ? 1 : 0);
+  status.gset("progress", done && !info->restore->cancelled() ? 1.0 : info->restore->progress());
+  status.gset("status", info->restore->status_text());
+  status.gset("errors", done ? info->result : info->restore->error_count());
+
+  grt::DictListRef workers(grt::Initialized);
+  for (const sql::ParallelRestore::WorkerStatus &worker_status : info->restore->worker_status()) {
+    grt::DictRef worker(true);
+    worker.gset("rows", (long)worker_status.rows);
+    worker.gset("rowsPerSecond", worker_status.rows_per_second());
+    worker.gset("task", worker_status.task);
+    workers.insert(worker);
+  }
+  status.set("workers", workers);
+
+  grt::StringListRef log(grt::Initialized);
+  {
+    base::MutexLock lock(info->log_mutex);
+    for (const std::string &message : info->log)
+      log.insert(message);
+    info->log.clear();
+  }
+  status.set("log", log);
+
+  return status;
+}
+
+int DbMySQLQueryImpl::cancelParallelRestore(int restore) {
+  get_parallel_restore(restore)->restore->cancel();
+  return 0;
+}
+
+int DbMySQLQueryImpl::closeParallelRestore(int restore) {
+  ParallelRestoreInfo::Ref info(get_parallel_restore(restore));
+  if (info->thread.joinable())
+    info->thread.join();
+
+  base::MutexLock lock(_mutex);
+  _parallel_restores.erase(restore);
+  return info->result;
+}
+
+int DbMySQLQueryImpl::openStatusSampler(const db_mgmt_ConnectionRef &info, const grt::StringRef &password,
+                                        grt::DictRef options) {
+  if (!info.is_valid())
+    throw std::invalid_argument("connection info is NULL");
+
+  StatusSampler::Options sampler_options;
+  if (options.is_valid()) {
+    sampler_options.interval = options.get_double("interval", sampler_options.interval);
+    sampler_options.capacity = (size_t)options.get_int("capacity", sampler_options.capacity);
+    sampler_options.max_variables = (size_t)options.get_int("maxVariables", sampler_options.max_variables);
+    sampler_options.performance_schema =
+      options.get_int("performanceSchema", sampler_options.performance_schema) != 0;
+    sampler_options.history_interval = options.get_double("historyInterval", sampler_options.history_interval);
+    sampler_options.history_length = (size_t)options.get_int("historyLength", sampler_options.history_length);
+    sampler_options.history_file = options.get_string("historyFile");
+  }
+
+  CLEAR_ERROR();
+
+  std::shared_ptr<StatusSampler> sampler;
+  try {
+    std::vector<sql::ConnectionWrapper> connections(open_parallel_connections(info, password, 1));
+    sampler = std::make_shared<StatusSampler>(connections[0], sampler_options);
+  } catch (sql::SQLException &exc) {
+    _last_error = exc.what();
+    _last_error_code = exc.getErrorCode();
+    return -1;
+  }
+  sampler->start();
+
+  base::MutexLock lock(_mutex);
+  int sampler_id = ++_status_sampler_id;
+  _status_samplers[sampler_id] = sampler;
+  return sampler_id;
+}
+
+std::shared_ptr<StatusSampler> DbMySQLQueryImpl::get_status_sampler(int sampler) {
+  base::MutexLock lock(_mutex);
+  std::map<int, std::shared_ptr<StatusSampler> >::const_iterator iter = _status_samplers.find(sampler);
+  if (iter == _status_samplers.end())
+    throw std::invalid_argument("Invalid sampler-id");
+  return iter->second;
+}
+
+static grt::DictRef status_points_dict(const std::vector<StatusSampler::Point> &points) {
+  grt::DictRef result(true);
+  grt::DoubleListRef times(grt::Initialized);
+  grt::DoubleListRef values(grt::Initialized);
+  for (const StatusSampler::Point &point : points) {
+    times.insert(point.time);
+    values.insert(point.value);
+  }
+  result.set("times", times);
+  result.set("values", values);
+  return result;
+}
+
+grt::DictRef DbMySQLQueryImpl::statusSamplerLatest(int sampler) {
+  std::shared_ptr<StatusSampler> status_sampler(get_status_sampler(sampler));
+
+  std::map<std::string, std::string> values;
+  double time = status_sampler->latest(values);
+
+  grt::DictRef variables(true);
+  for (std::map<std::string, std::string>::const_iterator iter = values.begin(); iter != values.end(); ++iter)
+    variables.gset(iter->first, iter->second);
+
+  grt::DictRef result(true);
+  result.set("time", grt::DoubleRef(time));
+  result.set("samples", grt::IntegerRef((ssize_t)status_sampler->sample_count()));
+  result.gset("error", status_sampler->last_error());
+  result.set("variables", variables);
+  return result;
+}
+
+grt::DictRef DbMySQLQueryImpl::statusSamplerSeries(int sampler, const std::string &name, double seconds) {
+  return status_points_dict(get_status_sampler(sampler)->series(name, seconds));
+}
+
+double DbMySQLQueryImpl::statusSamplerRate(int sampler, const std::string &name, double seconds) {
+  return get_status_sampler(sampler)->rate(name, seconds);
+}
+
+grt::DictRef DbMySQLQueryImpl::statusSamplerHistory(int sampler, const std::string &name, double seconds) {
+  return status_points_dict(get_status_sampler(sampler)->history(name, seconds));
+}
+
+int DbMySQLQueryImpl::closeStatusSampler(int sampler) {
+  std::shared_ptr<StatusSampler> status_sampler(get_status_sampler(sampler));
+  status_sampler->stop();
+
+  base::MutexLock lock(_mutex);
+  _status_samplers.erase(sampler);
+  return 0;
+}
@@ -0,0 +1,536 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "status_sampler.h"
+
+#include "base/file_utilities.h"
+#include "base/log.h"
+#include "base/string_utilities.h"
+#include "base/threaded_timer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+DEFAULT_LOG_DOMAIN("StatusSampler")
+
+namespace {
+
+  const char history_magic[8] = {'W', 'B', 'S', 'T', 'H', 'I', 'S', 'T'};
+  const uint32_t history_version = 1;
+  const int max_failures = 10; // Consecutive failed samples after which sampling stops.
+  const double no_value = std::numeric_limits<double>::quiet_NaN();
+
+  double current_time() {
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  bool parse_number(const std::string &text, double &value) {
+    if (text.empty())
+      return false;
+    char *end = nullptr;
+    value = strtod(text.c_str(), &end);
+    return *end == '\0' && std::isfinite(value);
+  }
+
+  std::string format_number(double value) {
+    return base::strfmt("%.15g", value);
+  }
+
+} // namespace
+
+//--------------------------------------------------------------------------------------------------
+
+StatusSampler::Options::Options()
+  : interval(0.5),
+    capacity(600),
+    max_variables(768),
+    performance_schema(true),
+    history_interval(60),
+    history_length(1440) {
+}
+
+//--------------------------------------------------------------------------------------------------
+
+StatusSampler::StatusSampler(const sql::ConnectionWrapper &connection, const Options &options)
+  : _connection(connection),
+    _options(options),
+    _task_id(-1),
+    _stopped(true),
+    _failures(0),
+    _written(0),
+    _variable_count(0),
+    _history_changed(false),
+    _window_start(0) {
+  _options.interval = std::max(_options.interval, 0.1); // The timer can't go much below that.
+  _options.capacity = std::max(_options.capacity, (size_t)2);
+  _options.max_variables = std::max(_options.max_variables, (size_t)1);
+  _options.history_length = std::max(_options.history_length, (size_t)1);
+
+  _sequence.reset(new std::atomic<uint64_t>[_options.capacity]);
+  _times.reset(new std::atomic<double>[_options.capacity]);
+  _values.reset(new std::atomic<double>[_options.capacity * _options.max_variables]);
+  _names.reset(new std::string[_options.max_variables]);
+  for (size_t i = 0; i < _options.capacity; ++i) {
+    _sequence[i].store(0, std::memory_order_relaxed);
+    _times[i].store(0, std::memory_order_relaxed);
+  }
+  for (size_t i = 0; i < _options.capacity * _options.max_variables; ++i)
+    _values[i].store(no_value, std::memory_order_relaxed);
+
+  load_history();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+StatusSampler::~StatusSampler() {
+  stop();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void StatusSampler::start() {
+  if (!_stopped)
+    return;
+  _stopped = false;
+
+  // The timer task only holds a weak reference, so a sampler that is closed while a sample is pending goes away
+  // cleanly. Returning true from the callback removes the task.
+  std::weak_ptr<StatusSampler> weak_self(shared_from_this());
+  _task_id = ThreadedTimer::add_task(TimerTimeSpan, _options.interval, false, [weak_self](int) {
+    std::shared_ptr<StatusSampler> self(weak_self.lock());
+    return !self || !self->sample();
+  });
+  if (_task_id < 0)
+    logError("Could not schedule the status sampling task\n");
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void StatusSampler::stop() {
+  if (!_stopped.exchange(true) && _task_id >= 0)
+    ThreadedTimer::remove_task(_task_id);
+  _task_id = -1;
+  save_history();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::string StatusSampler::last_error() const {
+  std::lock_guard<std::mutex> lock(_text_mutex);
+  return _last_error;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Timer callback, takes one sample. Returns false if sampling should stop.
+ */
+bool StatusSampler::sample() {
+  if (_stopped)
+    return false;
+
+  Values values;
+  try {
+    fetch_status(values);
+    if (_options.performance_schema)
+      fetch_performance_schema(values);
+  } catch (sql::SQLException &exc) {
+    {
+      std::lock_guard<std::mutex> lock(_text_mutex);
+      _last_error = exc.what();
+    }
+    if (++_failures == 1)
+      logWarning("Error sampling server status: %s\n", exc.what());
+    if (_failures < max_failures)
+      return true;
+    logError("Server status sampling stopped after %i failed attempts\n", _failures);
+    return false;
+  }
+  _failures = 0;
+
+  add_sample(current_time(), values);
+  return true;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void StatusSampler::add_sample(double time, const Values &values) {
+  std::vector<double> numbers(_options.max_variables, no_value);
+  for (const auto &value : values)
+    set_value(numbers, value.first, value.second);
+  store(time, numbers);
+  add_to_history(time, numbers);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void StatusSampler::fetch_status(Values &values) {
+  std::unique_ptr<sql::Statement> statement(_connection->createStatement());
+  std::unique_ptr<sql::ResultSet> rs(statement->executeQuery("SHOW GLOBAL STATUS"));
+  while (rs->next())
+    values.push_back(std::make_pair(std::string(rs->getString(1)), std::string(rs->getString(2))));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Adds the statement counts and latencies and the file I/O volume per event, as <event name>:<measure>.
+ * Event names contain slashes, so they can't collide with status variable names.
+ */
+void StatusSampler::fetch_performance_schema(Values &values) {
+  try {
+    std::unique_ptr<sql::Statement> statement(_connection->createStatement());
+    std::unique_ptr<sql::ResultSet> rs(statement->executeQuery(
+      "SELECT EVENT_NAME, COUNT_STAR, SUM_TIMER_WAIT / 1000000000000 "
+      "FROM performance_schema.events_statements_summary_global_by_event_name WHERE COUNT_STAR > 0"));
+    while (rs->next()) {
+      std::string event = rs->getString(1);
+      values.push_back(std::make_pair(event + ":count", std::string(rs->getString(2))));
+      values.push_back(std::make_pair(event + ":latency", std::string(rs->getString(3))));
+    }
+
+    rs.reset(statement->executeQuery(
+      "SELECT EVENT_NAME, SUM_NUMBER_OF_BYTES_READ, SUM_NUMBER_OF_BYTES_WRITE "
+      "FROM performance_schema.file_summary_by_event_name WHERE COUNT_STAR > 0"));
+    while (rs->next()) {
+      std::string event = rs->getString(1);
+      values.push_back(std::make_pair(event + ":read_bytes", std::string(rs->getString(2))));
+      values.push_back(std::make_pair(event + ":write_bytes", std::string(rs->getString(3))));
+    }
+  } catch (sql::SQLException &exc) {
+    // Disabled performance_schema or missing privileges are no reason to stop sampling the status.
+    logWarning("performance_schema summaries not available, sampling global status only: %s\n", exc.what());
+    _options.performance_schema = false;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void StatusSampler::set_value(std::vector<double> &values, const std::string &name, const std::string &value) {
+  double number;
+  if (parse_number(value, number)) {
+    size_t index = column(name);
+    if (index < values.size())
+      values[index] = number;
+  } else {
+    std::lock_guard<std::mutex> lock(_text_mutex);
+    _text_values[name] = value;
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the column of the given variable, adding it if needed. Returns max_variables if there is no room left.
+ * Only called by the sampling task (or before it is started).
+ */
+size_t StatusSampler::column(const std::string &name) {
+  std::map<std::string, size_t>::const_iterator iter = _columns.find(name);
+  if (iter != _columns.end())
+    return iter->second;
+
+  size_t count = _variable_count.load(std::memory_order_relaxed);
+  if (count == _options.max_variables) {
+    logDebug("Variable limit reached, not sampling %s\n", name.c_str());
+    _columns[name] = count;
+    return count;
+  }
+  _names[count] = name;
+  _columns[name] = count;
+  _variable_count.store(count + 1, std::memory_order_release);
+  return count;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int StatusSampler::find_column(const std::string &name) const {
+  size_t count = _variable_count.load(std::memory_order_acquire);
+  for (size_t i = 0; i < count; ++i) {
+    if (_names[i] == name)
+      return (int)i;
+  }
+  return -1;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void StatusSampler::store(double time, const std::vector<double> &values) {
+  uint64_t n = _written.load(std::memory_order_relaxed);
+  size_t slot = (size_t)(n % _options.capacity);
+  size_t count = _variable_count.load(std::memory_order_relaxed);
+
+  _sequence[slot].store(2 * n + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  _times[slot].store(time, std::memory_order_relaxed);
+  std::atomic<double> *row = &_values[slot * _options.max_variables];
+  for (size_t i = 0; i < count; ++i)
+    row[i].store(values[i], std::memory_order_relaxed);
+  _sequence[slot].store(2 * n + 2, std::memory_order_release);
+  _written.store(n + 1, std::memory_order_release);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Reads one value of sample n. Fails if the sample was overwritten meanwhile or is being written.
+ */
+bool StatusSampler::read(uint64_t n, size_t column, Point &point) const {
+  size_t slot = (size_t)(n % _options.capacity);
+  uint64_t sequence = 2 * n + 2;
+  if (_sequence[slot].load(std::memory_order_acquire) != sequence)
+    return false;
+  point.time = _times[slot].load(std::memory_order_relaxed);
+  point.value = _values[slot * _options.max_variables + column].load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return _sequence[slot].load(std::memory_order_relaxed) == sequence;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+double StatusSampler::latest(std::map<std::string, std::string> &values) const {
+  uint64_t written = _written.load(std::memory_order_acquire);
+  if (written == 0)
+    return 0;
+
+  double time = 0;
+  size_t count = _variable_count.load(std::memory_order_acquire);
+  for (size_t i = 0; i < count; ++i) {
+    Point point;
+    if (read(written - 1, i, point) && !std::isnan(point.value)) {
+      values[_names[i]] = format_number(point.value);
+      time = point.time;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(_text_mutex);
+  for (std::map<std::string, std::string>::const_iterator iter = _text_values.begin(); iter != _text_values.end();
+       ++iter)
+    values[iter->first] = iter->second;
+  return time;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<StatusSampler::Point> StatusSampler::series(const std::string &name, double seconds) const {
+  std::vector<Point> points;
+  int index = find_column(name);
+  uint64_t written = _written.load(std::memory_order_acquire);
+  if (index < 0 || written == 0)
+    return points;
+
+  uint64_t oldest = written > _options.capacity ? written - _options.capacity : 0;
+  double since = -std::numeric_limits<double>::infinity();
+  for (uint64_t n = written; n-- > oldest;) {
+    Point point;
+    if (!read(n, (size_t)index, point))
+      break;
+    if (n == written - 1 && seconds > 0)
+      since = point.time - seconds;
+    if (point.time < since)
+      break;
+    if (!std::isnan(point.value))
+      points.push_back(point);
+  }
+  std::reverse(points.begin(), points.end());
+  return points;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+double StatusSampler::rate(const std::string &name, double seconds) const {
+  std::vector<Point> points(series(name, seconds));
+  if (points.size() < 2 || points.back().time <= points.front().time)
+    return 0;
+  return (points.back().value - points.front().value) / (points.back().time - points.front().time);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+std::vector<StatusSampler::Point> StatusSampler::history(const std::string &name, double seconds) const {
+  std::vector<Point> points;
+  int index = find_column(name);
+  if (index < 0)
+    return points;
+
+  std::lock_guard<std::mutex> lock(_history_mutex);
+  if (_history.empty())
+    return points;
+  double since = seconds > 0 ? _history.back().time - seconds : -std::numeric_limits<double>::infinity();
+  for (std::deque<HistoryEntry>::const_reverse_iterator entry = _history.rbegin();
+       entry != _history.rend() && entry->time >= since; ++entry) {
+    if ((size_t)index < entry->values.size() && !std::isnan(entry->values[index])) {
+      Point point = {entry->time, entry->values[index]};
+      points.push_back(point);
+    }
+  }
+  std::reverse(points.begin(), points.end());
+  return points;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Averages the samples over history_interval seconds into one history entry.
+ */
+void StatusSampler::add_to_history(double time, const std::vector<double> &values) {
+  if (_window_start > 0 && time - _window_start >= _options.history_interval) {
+    HistoryEntry entry;
+    entry.time = _window_start;
+    entry.values.resize(_window_sums.size(), no_value);
+    for (size_t i = 0; i < _window_sums.size(); ++i) {
+      if (_window_counts[i] > 0)
+        entry.values[i] = _window_sums[i] / _window_counts[i];
+    }
+
+    std::lock_guard<std::mutex> lock(_history_mutex);
+    _history.push_back(entry);
+    _history_changed = true;
+    while (_history.size() > _options.history_length)
+      _history.pop_front();
+    _window_start = 0;
+  }
+
+  if (_window_start == 0) {
+    _window_start = time;
+    std::fill(_window_sums.begin(), _window_sums.end(), 0.0);
+    std::fill(_window_counts.begin(), _window_counts.end(), 0);
+  }
+
+  size_t count = _variable_count.load(std::memory_order_relaxed);
+  _window_sums.resize(count, 0.0);
+  _window_counts.resize(count, 0);
+  for (size_t i = 0; i < count; ++i) {
+    if (!std::isnan(values[i])) {
+      _window_sums[i] += values[i];
+      ++_window_counts[i];
+    }
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Loads the history saved by a previous sampler. Variables are registered in the order of the file,
+ * so the saved entries can be used as they are.
+ */
+void StatusSampler::load_history() {
+  if (_options.history_file.empty() || !base::file_exists(_options.history_file))
+    return;
+
+  try {
+    base::FileHandle file(_options.history_file, "rb");
+    char magic[sizeof(history_magic)];
+    uint32_t version;
+    uint64_t name_count, entry_count;
+    if (fread(magic, sizeof(magic), 1, file.file()) != 1 || memcmp(magic, history_magic, sizeof(magic)) != 0 ||
+        fread(&version, sizeof(version), 1, file.file()) != 1 || version != history_version ||
+        fread(&name_count, sizeof(name_count), 1, file.file()) != 1) {
+      logWarning("Ignoring invalid status history file %s\n", _options.history_file.c_str());
+      return;
+    }
+
+    std::vector<std::string> names;
+    for (uint64_t i = 0; i < name_count; ++i) {
+      uint32_t length;
+      if (fread(&length, sizeof(length), 1, file.file()) != 1)
+        return;
+      std::string name(length, '\0');
+      if (length > 0 && fread(&name[0], length, 1, file.file()) != 1)
+        return;
+      names.push_back(name);
+    }
+    for (size_t i = 0; i < names.size() && i < _options.max_variables; ++i)
+      column(names[i]);
+
+    if (fread(&entry_count, sizeof(entry_count), 1, file.file()) != 1)
+      return;
+    std::deque<HistoryEntry> history;
+    for (uint64_t i = 0; i < entry_count; ++i) {
+      HistoryEntry entry;
+      uint32_t count;
+      if (fread(&entry.time, sizeof(entry.time), 1, file.file()) != 1 ||
+          fread(&count, sizeof(count), 1, file.file()) != 1)
+        return;
+      entry.values.resize(count);
+      if (count > 0 && fread(&entry.values[0], sizeof(double), count, file.file()) != count)
+        return;
+      entry.values.resize(std::min((size_t)count, _options.max_variables));
+      history.push_back(entry);
+      if (history.size() > _options.history_length)
+        history.pop_front();
+    }
+
+    std::lock_guard<std::mutex> lock(_history_mutex);
+    _history.swap(history);
+    logDebug("Loaded %i status history entries from %s\n", (int)_history.size(), _options.history_file.c_str());
+  } catch (std::exception &e) {
+    logWarning("Could not read status history %s: %s\n", _options.history_file.c_str(), e.what());
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void StatusSampler::save_history() {
+  {
+    std::lock_guard<std::mutex> lock(_history_mutex);
+    if (_options.history_file.empty() || !_history_changed)
+      return;
+    _history_changed = false;
+  }
+
+  std::string path = _options.history_file;
+  try {
+    base::create_directory(base::dirname(path), 0700, true);
+    base::FileHandle file(path + ".tmp", "wb");
+
+    uint64_t name_count = _variable_count.load(std::memory_order_acquire);
+    fwrite(history_magic, sizeof(history_magic), 1, file.file());
+    fwrite(&history_version, sizeof(history_version), 1, file.file());
+    fwrite(&name_count, sizeof(name_count), 1, file.file());
+    for (uint64_t i = 0; i < name_count; ++i) {
+      uint32_t length = (uint32_t)_names[i].size();
+      fwrite(&length, sizeof(length), 1, file.file());
+      fwrite(_names[i].data(), length, 1, file.file());
+    }
+
+    std::lock_guard<std::mutex> lock(_history_mutex);
+    uint64_t entry_count = _history.size();
+    fwrite(&entry_count, sizeof(entry_count), 1, file.file());
+    for (const HistoryEntry &entry : _history) {
+      uint32_t count = (uint32_t)entry.values.size();
+      fwrite(&entry.time, sizeof(entry.time), 1, file.file());
+      fwrite(&count, sizeof(count), 1, file.file());
+      if (count > 0)
+        fwrite(&entry.values[0], sizeof(double), count, file.file());
+    }
+    file.dispose();
+    base::tryRemove(path);
+    base::rename(path + ".tmp", path);
+  } catch (std::exception &e) {
+    logWarning("Could not write status history %s: %s\n", path.c_str(), e.what());
+  }
+}
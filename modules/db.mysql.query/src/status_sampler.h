@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include "cppdbc.h"
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Samples the global status variables of a server, plus the performance_schema statement and file I/O summaries,
+ * at sub-second intervals on its own connection. Sampling is driven by the ThreadedTimer.
+ *
+ * Samples are stored in a fixed size ring buffer, which is only written by the sampling task and can be read from any
+ * thread without locking (every slot carries a sequence number that readers check before and after copying it).
+ * Older data is kept as a downsampled history, averaged over history_interval seconds, which is saved to
+ * history_file when the sampler is stopped and loaded again by the next sampler using the same file.
+ */
+class StatusSampler : public std::enable_shared_from_this<StatusSampler> {
+public:
+  struct Options {
+    Options();
+
+    double interval;          // Seconds between two samples.
+    size_t capacity;          // Number of samples kept in the ring buffer.
+    size_t max_variables;     // Maximum number of distinct variables tracked, further ones are ignored.
+    bool performance_schema;  // Also sample the performance_schema summaries.
+    double history_interval;  // Seconds covered by one history entry.
+    size_t history_length;    // Number of history entries kept.
+    std::string history_file; // Where the history is kept between sessions, empty to not keep it.
+  };
+
+  struct Point {
+    double time;
+    double value;
+  };
+
+  StatusSampler(const sql::ConnectionWrapper &connection, const Options &options);
+  ~StatusSampler();
+
+  typedef std::vector<std::pair<std::string, std::string> > Values;
+
+  void start();
+  void stop();
+
+  // Records one sample of variable values as the server returns them. Called by the sampling task, so it must
+  // not be called while the sampler is started.
+  void add_sample(double time, const Values &values);
+
+  // Fills values with the latest value of every variable, formatted like the server does for numbers.
+  // Returns the time of the sample or 0 if nothing was sampled yet.
+  double latest(std::map<std::string, std::string> &values) const;
+
+  // The samples of the last seconds of a numeric variable, oldest first. Pass 0 for the whole ring buffer.
+  std::vector<Point> series(const std::string &name, double seconds) const;
+
+  // The average per second change of a counter over the last seconds.
+  double rate(const std::string &name, double seconds) const;
+
+  // The downsampled history of the last seconds of a numeric variable, oldest first. Pass 0 for all of it.
+  std::vector<Point> history(const std::string &name, double seconds) const;
+
+  uint64_t sample_count() const {
+    return _written.load(std::memory_order_acquire);
+  }
+  std::string last_error() const;
+
+private:
+  struct HistoryEntry {
+    double time;
+    std::vector<double> values;
+  };
+
+  bool sample();
+  void fetch_status(Values &values);
+  void fetch_performance_schema(Values &values);
+  void set_value(std::vector<double> &values, const std::string &name, const std::string &value);
+  size_t column(const std::string &name);
+  int find_column(const std::string &name) const;
+  void store(double time, const std::vector<double> &values);
+  bool read(uint64_t n, size_t column, Point &point) const;
+  void add_to_history(double time, const std::vector<double> &values);
+  void load_history();
+  void save_history();
+
+  sql::ConnectionWrapper _connection;
+  Options _options;
+  int _task_id;
+  std::atomic<bool> _stopped;
+  int _failures;
+
+  // The ring buffer. Slot n % capacity holds sample n once its sequence number is 2 * n + 2.
+  std::unique_ptr<std::atomic<uint64_t>[]> _sequence;
+  std::unique_ptr<std::atomic<double>[]> _times;
+  std::unique_ptr<std::atomic<double>[]> _values; // capacity rows of max_variables values.
+  std::atomic<uint64_t> _written;
+
+  // Variable names are only appended, by the sampling task, and published through _variable_count.
+  std::unique_ptr<std::string[]> _names;
+  std::atomic<size_t> _variable_count;
+  std::map<std::string, size_t> _columns;
+
+  mutable std::mutex _text_mutex; // Values which are not numbers (e.g. Ssl_cipher) are kept apart.
+  std::map<std::string, std::string> _text_values;
+  std::string _last_error;
+
+  mutable std::mutex _history_mutex;
+  std::deque<HistoryEntry> _history;
+  bool _history_changed; // Not saved yet.
+  double _window_start;
+  std::vector<double> _window_sums;
+  std::vector<size_t> _window_counts;
+};
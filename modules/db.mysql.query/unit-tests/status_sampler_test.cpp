@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "../src/status_sampler.h"
+#include "base/file_utilities.h"
+#include "base/string_utilities.h"
+#include "wb_helpers.h"
+
+#include <atomic>
+#include <thread>
+
+#define SAMPLER_TEST_DIR "status_sampler_test"
+
+BEGIN_TEST_DATA_CLASS(status_sampler_test)
+protected:
+  std::shared_ptr<StatusSampler> sampler(const StatusSampler::Options &options) {
+    return std::make_shared<StatusSampler>(sql::ConnectionWrapper(), options);
+  }
+
+  StatusSampler::Values values(double select_count, const std::string &cipher = "") {
+    StatusSampler::Values result;
+    result.push_back(std::make_pair("Com_select", base::strfmt("%.0f", select_count)));
+    result.push_back(std::make_pair("Threads_connected", "3"));
+    if (!cipher.empty())
+      result.push_back(std::make_pair("Ssl_cipher", cipher));
+    return result;
+  }
+
+TEST_DATA_CONSTRUCTOR(status_sampler_test) {
+  base::remove_recursive(SAMPLER_TEST_DIR);
+}
+
+TEST_DATA_DESTRUCTOR(status_sampler_test) {
+  base::remove_recursive(SAMPLER_TEST_DIR);
+}
+END_TEST_DATA_CLASS
+
+TEST_MODULE(status_sampler_test, "status sampler");
+
+// Latest values, series and rates of the samples in the ring buffer.
+TEST_FUNCTION(1) {
+  std::shared_ptr<StatusSampler> status(sampler(StatusSampler::Options()));
+  std::map<std::string, std::string> latest;
+  ensure_equals("nothing sampled", status->latest(latest), 0.0);
+
+  for (int i = 0; i < 10; ++i)
+    status->add_sample(100 + i, values(i * 10, "AES256-SHA"));
+  ensure_equals("sample count", status->sample_count(), 10U);
+
+  ensure_equals("latest time", status->latest(latest), 109.0);
+  ensure_equals("latest counter", latest["Com_select"], "90");
+  ensure_equals("text value", latest["Ssl_cipher"], "AES256-SHA");
+
+  std::vector<StatusSampler::Point> points = status->series("Com_select", 0);
+  ensure_equals("all samples", points.size(), 10U);
+  ensure_equals("oldest first", points.front().time, 100.0);
+  ensure_equals("newest last", points.back().value, 90.0);
+
+  points = status->series("Com_select", 3);
+  ensure_equals("last seconds", points.size(), 4U);
+  ensure_equals("since", points.front().time, 106.0);
+
+  ensure_equals("rate", status->rate("Com_select", 5), 10.0);
+  ensure_equals("steady value", status->rate("Threads_connected", 5), 0.0);
+  ensure("no series for text", status->series("Ssl_cipher", 0).empty());
+  ensure("no series for unknown", status->series("Uptime", 0).empty());
+}
+
+// The ring buffer keeps the newest samples, further variables beyond the limit are ignored.
+TEST_FUNCTION(2) {
+  StatusSampler::Options options;
+  options.capacity = 5;
+  options.max_variables = 1;
+  std::shared_ptr<StatusSampler> status(sampler(options));
+
+  for (int i = 0; i < 12; ++i)
+    status->add_sample(i, values(i));
+
+  std::vector<StatusSampler::Point> points = status->series("Com_select", 0);
+  ensure_equals("capacity", points.size(), 5U);
+  ensure_equals("oldest kept", points.front().value, 7.0);
+  ensure_equals("newest", points.back().value, 11.0);
+
+  std::map<std::string, std::string> latest;
+  status->latest(latest);
+  ensure("over the limit", latest.find("Threads_connected") == latest.end());
+  ensure("no series over the limit", status->series("Threads_connected", 0).empty());
+}
+
+// Samples are averaged into history entries, which are kept between samplers using the same file.
+TEST_FUNCTION(3) {
+  StatusSampler::Options options;
+  options.history_interval = 10;
+  options.history_file = base::makePath(SAMPLER_TEST_DIR, "history");
+  {
+    std::shared_ptr<StatusSampler> status(sampler(options));
+    for (int i = 0; i < 36; ++i)
+      status->add_sample(1000 + i, values(i));
+
+    std::vector<StatusSampler::Point> points = status->history("Com_select", 0);
+    ensure_equals("history entries", points.size(), 3U);
+    ensure_equals("window start", points[1].time, 1010.0);
+    ensure_equals("window average", points[1].value, 14.5);
+    ensure_equals("last seconds", status->history("Com_select", 10).size(), 2U);
+  }
+  ensure("history saved", base::file_exists(options.history_file));
+
+  // Variables may come in a different order in the next session.
+  std::shared_ptr<StatusSampler> status(sampler(options));
+  std::vector<StatusSampler::Point> points = status->history("Com_select", 0);
+  ensure_equals("history loaded", points.size(), 3U);
+  ensure_equals("loaded average", points[2].value, 24.5);
+  ensure_equals("other variable", status->history("Threads_connected", 0).back().value, 3.0);
+
+  StatusSampler::Values reordered;
+  reordered.push_back(std::make_pair("Threads_connected", "5"));
+  reordered.push_back(std::make_pair("Com_select", "100"));
+  status->add_sample(2000, reordered);
+  status->add_sample(2010, reordered);
+  points = status->history("Com_select", 0);
+  ensure_equals("new entry", points.size(), 4U);
+  ensure_equals("new entry value", points.back().value, 100.0);
+}
+
+// Readers never see a half written sample while the buffer wraps around.
+TEST_FUNCTION(4) {
+  StatusSampler::Options options;
+  options.capacity = 16;
+  std::shared_ptr<StatusSampler> status(sampler(options));
+  status->add_sample(0, values(0));
+
+  std::atomic<bool> done(false);
+  std::atomic<int> bad(0);
+  std::thread reader([&]() {
+    while (!done) {
+      std::vector<StatusSampler::Point> points = status->series("Com_select", 0);
+      for (size_t i = 0; i < points.size(); ++i) {
+        if (points[i].value != 2 * points[i].time || (i > 0 && points[i].time <= points[i - 1].time))
+          ++bad;
+      }
+    }
+  });
+  for (int i = 1; i < 20000; ++i)
+    status->add_sample(i, values(2 * i));
+  done = true;
+  reader.join();
+
+  ensure_equals("consistent samples", bad.load(), 0);
+  ensure_equals("last sample", status->series("Com_select", 0).back().value, 2 * 19999.0);
+}
+
+END_TESTS
@@ -150,12 +150,12 @@ int MysqlSqlFacadeImpl::splitSqlScript(const char *sql, std::size_t length, cons
         have_content = true;
         char quote = *tail++;
         while (tail < end && *tail != quote) {
-          // Skip any escaped character too.
-          if (*tail == '\\')
+          // Skip any escaped character too (but don't run over the end if the text is cut after the backslash).
+          if (*tail == '\\' && tail + 1 < end)
             tail++;
           tail++;
         }
-        if (*tail == quote)
+        if (tail < end && *tail == quote)
           tail++; // Skip trailing quote char to if one was there.
 
         break;
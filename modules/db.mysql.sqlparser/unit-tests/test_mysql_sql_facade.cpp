@@ -28,6 +28,7 @@
 #include "grt_test_utility.h"
 #include "testgrt.h"
 #include "grtsqlparser/sql_facade.h"
+#include "sqlide/sql_statement_stream.h"
 #include "wb_helpers.h"
 
 BEGIN_TEST_DATA_CLASS(mysql_sql_facade)
@@ -230,6 +231,60 @@ TEST_FUNCTION(11) {
   ensure_equals("Unexpected Column Count", columns.size(), 0U);
 }
 
+// Splitting a script piecewise must give the same statements as splitting it at once.
+TEST_FUNCTION(12) {
+  ensure("failed to get sqlparser module", (NULL != sql_facade));
+
+  std::string script =
+    "SELECT 1;\n"
+    "INSERT INTO t VALUES ('a;b', \"c;\\\"d\");\n"
+    "-- comment; here\n"
+    "DELIMITER $$\n"
+    "CREATE PROCEDURE p() BEGIN SELECT 1; END$$\n"
+    "DELIMITER ;\n"
+    "/* block ; */ UPDATE t SET a = 1;\n"
+    "DELIMITER //\n"
+    "SELECT 2//\n"
+    "delimiter ;\n"
+    "SELECT `x;y` FROM z";
+
+  std::vector<std::pair<size_t, size_t> > ranges;
+  sql_facade->splitSqlScript(script.c_str(), script.size(), ";", ranges);
+
+  for (size_t chunk_size = 1; chunk_size < 40; ++chunk_size) {
+    SqlStatementStream stream(sql_facade, ";", chunk_size);
+    std::vector<std::string> statements;
+    std::string statement;
+    for (size_t i = 0; i < script.size(); i += chunk_size) {
+      stream.feed(script.data() + i, std::min(chunk_size, script.size() - i));
+      while (stream.next(statement))
+        statements.push_back(statement);
+    }
+    stream.finish();
+    while (stream.next(statement))
+      statements.push_back(statement);
+
+    ensure_equals("Statement count", statements.size(), ranges.size());
+    for (size_t i = 0; i < ranges.size(); ++i)
+      ensure_equals("Statement text", statements[i], script.substr(ranges[i].first, ranges[i].second));
+  }
+
+  // Resuming after the procedure must continue with the delimiter that was active there.
+  SqlStatementStream stream(sql_facade);
+  stream.feed(script.data(), script.size());
+  stream.finish();
+  std::string statement;
+  for (size_t i = 0; i < 3; ++i)
+    stream.next(statement);
+  ensure_equals("Delimiter after procedure", stream.delimiter(), "$$");
+
+  SqlStatementStream resumed(sql_facade, stream.delimiter());
+  resumed.feed(script.data() + stream.offset(), script.size() - (size_t)stream.offset());
+  resumed.finish();
+  ensure("Statement after resume", resumed.next(statement));
+  ensure_equals("Statement after resume", statement, "/* block ; */ UPDATE t SET a = 1");
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
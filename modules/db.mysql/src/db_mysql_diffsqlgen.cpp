@@ -33,7 +33,11 @@
 #include "grt/common.h"
 
 #include <algorithm>
+#include <atomic>
 #include <ctype.h>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 #include "module_db_mysql.h"
 #include "module_db_mysql_shared_code.h"
@@ -336,10 +340,8 @@ void DiffSQLGeneratorBE::generate_create_stmt(db_mysql_SchemaRef schema) {
   callback->create_schema(schema);
 
   grt::ListRef<db_mysql_Table> tables = schema->tables();
-  for (size_t count = tables.count(), i = 0; i < count; i++) {
-    db_mysql_TableRef table = tables.get(i);
-    generate_create_stmt(table);
-  }
+  run_tasks(tables.count(),
+            [&tables](DiffSQLGeneratorBE &generator, size_t i) { generator.generate_create_stmt(tables.get(i)); });
 
   grt::ListRef<db_mysql_View> views = schema->views();
   for (size_t count = views.count(), i = 0; i < count; i++) {
@@ -1151,20 +1153,20 @@ void DiffSQLGeneratorBE::generate_alter_stmt(db_mysql_SchemaRef schema, const gr
     if (attr_change->get_attr_name().compare("tables") == 0) {
       const grt::MultiChange *list_change = static_cast<const grt::MultiChange *>(attr_change->get_subchange().get());
       const grt::ChangeSet *tables_cs = list_change->subchanges();
-      for (grt::ChangeSet::const_iterator e2 = tables_cs->end(), jt = tables_cs->begin(); jt != e2; jt++) {
-        const grt::DiffChange *table_change = jt->get();
+      run_tasks(tables_cs->changes.size(), [tables_cs](DiffSQLGeneratorBE &generator, size_t i) {
+        const grt::DiffChange *table_change = tables_cs->changes[i].get();
         if (table_change->get_change_type() == grt::ListItemModified) {
-          generate_alter_stmt_drops(
+          generator.generate_alter_stmt_drops(
             db_mysql_TableRef::cast_from(
               static_cast<const grt::ListItemModifiedChange *>(table_change)->get_new_value()),
             static_cast<const grt::ListItemModifiedChange *>(table_change)->get_subchange().get());
         } else if (table_change->get_change_type() == grt::ListItemOrderChanged) {
           const grt::ListItemOrderChange *oc = static_cast<const grt::ListItemOrderChange *>(table_change);
           if (oc->get_subchange())
-            generate_alter_stmt_drops(db_mysql_TableRef::cast_from(oc->get_subchange()->get_new_value()),
-                                      oc->get_subchange()->get_subchange().get());
+            generator.generate_alter_stmt_drops(db_mysql_TableRef::cast_from(oc->get_subchange()->get_new_value()),
+                                                oc->get_subchange()->get_subchange().get());
         }
-      }
+      });
     }
   }
 
@@ -1175,60 +1177,61 @@ void DiffSQLGeneratorBE::generate_alter_stmt(db_mysql_SchemaRef schema, const gr
       const grt::ChangeSet *tables_cs = list_change->subchanges();
 
       // 1st pass, do everything except FKs
-      for (grt::ChangeSet::const_iterator e2 = tables_cs->end(), jt = tables_cs->begin(); jt != e2; jt++) {
-        const grt::DiffChange *table_change = jt->get();
+      const AlterTableFlags first_pass_flags = _separate_foreign_keys ? EverythingButForeignKeys : Everything;
+      run_tasks(tables_cs->changes.size(), [tables_cs, first_pass_flags](DiffSQLGeneratorBE &generator, size_t i) {
+        const grt::DiffChange *table_change = tables_cs->changes[i].get();
         switch (table_change->get_change_type()) {
           case grt::ListItemAdded:
-            generate_create_stmt(
+            generator.generate_create_stmt(
               db_mysql_TableRef::cast_from(static_cast<const grt::ListItemAddedChange *>(table_change)->get_value()));
             break;
           case grt::ListItemRemoved:
-            generate_drop_stmt(
+            generator.generate_drop_stmt(
               db_mysql_TableRef::cast_from(static_cast<const grt::ListItemRemovedChange *>(table_change)->get_value()));
             break;
           case grt::ListItemModified:
-            generate_alter_stmt(
+            generator.generate_alter_stmt(
               db_mysql_TableRef::cast_from(
                 static_cast<const grt::ListItemModifiedChange *>(table_change)->get_new_value()),
               static_cast<const grt::ListItemModifiedChange *>(table_change)->get_subchange().get(),
-              _separate_foreign_keys ? EverythingButForeignKeys : Everything); // everything but FK 1st
+              first_pass_flags); // everything but FK 1st
             break;
           case grt::ListItemOrderChanged: {
             const grt::ListItemOrderChange *oc = static_cast<const grt::ListItemOrderChange *>(table_change);
             if (oc->get_subchange())
-              generate_alter_stmt(db_mysql_TableRef::cast_from(oc->get_subchange()->get_new_value()),
-                                  oc->get_subchange()->get_subchange().get(),
-                                  _separate_foreign_keys ? EverythingButForeignKeys : Everything);
+              generator.generate_alter_stmt(db_mysql_TableRef::cast_from(oc->get_subchange()->get_new_value()),
+                                            oc->get_subchange()->get_subchange().get(), first_pass_flags);
           } break;
           default:
             break;
         }
-      }
+      });
 
       if (_separate_foreign_keys) {
         // 2nd pass, do FKs only
-        for (grt::ChangeSet::const_iterator e2 = tables_cs->end(), jt = tables_cs->begin(); jt != e2; jt++) {
-          const grt::DiffChange *table_change = jt->get();
+        run_tasks(tables_cs->changes.size(), [tables_cs](DiffSQLGeneratorBE &generator, size_t i) {
+          const grt::DiffChange *table_change = tables_cs->changes[i].get();
           switch (table_change->get_change_type()) {
             case grt::ListItemAdded:
             case grt::ListItemRemoved:
               break;
             case grt::ListItemModified:
-              generate_alter_stmt(db_mysql_TableRef::cast_from(
-                                    static_cast<const grt::ListItemModifiedChange *>(table_change)->get_new_value()),
-                                  static_cast<const grt::ListItemModifiedChange *>(table_change)->get_subchange().get(),
-                                  OnlyForeignKeys); // FK only
+              generator.generate_alter_stmt(
+                db_mysql_TableRef::cast_from(
+                  static_cast<const grt::ListItemModifiedChange *>(table_change)->get_new_value()),
+                static_cast<const grt::ListItemModifiedChange *>(table_change)->get_subchange().get(),
+                OnlyForeignKeys); // FK only
               break;
             case grt::ListItemOrderChanged: {
               const grt::ListItemOrderChange *oc = static_cast<const grt::ListItemOrderChange *>(table_change);
               if (oc->get_subchange())
-                generate_alter_stmt(db_mysql_TableRef::cast_from(oc->get_subchange()->get_new_value()),
-                                    oc->get_subchange()->get_subchange().get(), OnlyForeignKeys);
+                generator.generate_alter_stmt(db_mysql_TableRef::cast_from(oc->get_subchange()->get_new_value()),
+                                              oc->get_subchange()->get_subchange().get(), OnlyForeignKeys);
             } break;
             default:
               break;
           }
-        }
+        });
       }
     } else if (attr_change->get_attr_name().compare("views") == 0) {
       const grt::MultiChange *list_change = static_cast<const grt::MultiChange *>(attr_change->get_subchange().get());
@@ -1374,7 +1377,8 @@ DiffSQLGeneratorBE::DiffSQLGeneratorBE(grt::DictRef options, grt::DictRef dbtrai
     _skip_fk_indexes(false),
     _case_sensitive(false),
     _use_oid_as_dict_key(false),
-    _separate_foreign_keys(true) {
+    _separate_foreign_keys(true),
+    _worker_count(std::max(std::thread::hardware_concurrency(), 1U)) {
   if (!options.is_valid())
     return;
   _case_sensitive = (dbtraits.get_int("CaseSensitive", _case_sensitive) != 0);
@@ -1386,6 +1390,7 @@ DiffSQLGeneratorBE::DiffSQLGeneratorBE(grt::DictRef options, grt::DictRef dbtrai
   _gen_create_index = (options.get_int("GenerateCreateIndex", _gen_create_index) != 0);
   _use_filtered_lists = options.get_int("UseFilteredLists", _use_filtered_lists) != 0;
   _separate_foreign_keys = options.get_int("SeparateForeignKeys", _separate_foreign_keys) != 0;
+  _worker_count = (size_t)std::max(options.get_int("GeneratorThreadCount", (ssize_t)_worker_count), (ssize_t)1);
   cb->setOmitSchemas(options.get_int("OmitSchemas", 0) != 0);
   cb->set_gen_use(options.get_int("GenerateUse", 0) != 0);
   fill_set_from_list(grt::StringListRef::cast_from(options.get("UserFilterList", empty_list)), _filtered_users);
@@ -1396,6 +1401,71 @@ DiffSQLGeneratorBE::DiffSQLGeneratorBE(grt::DictRef options, grt::DictRef dbtrai
   fill_set_from_list(grt::StringListRef::cast_from(options.get("TriggerFilterList", empty_list)), _filtered_triggers);
 }
 
+/**
+ * Runs task(generator, i) for all i < count. With several worker threads the tasks are split into consecutive
+ * ranges, each generated with a copy of this generator and a worker call-back (see
+ * DiffSQLGeneratorBEActionInterface::create_worker()). The output of the ranges is merged back in range order, so
+ * the result is identical to running all tasks in order on this thread.
+ */
+void DiffSQLGeneratorBE::run_tasks(size_t count, const std::function<void(DiffSQLGeneratorBE &, size_t)> &task) {
+  const size_t min_tasks_per_range = 16;
+
+  size_t range_count = std::min(count / min_tasks_per_range, _worker_count * 4);
+  std::vector<DiffSQLGeneratorBEActionInterface *> workers;
+  if (_worker_count > 1 && range_count > 1) {
+    for (size_t i = 0; i < range_count; ++i) {
+      DiffSQLGeneratorBEActionInterface *worker = callback->create_worker();
+      if (worker == nullptr)
+        break;
+      workers.push_back(worker);
+    }
+    if (workers.size() < range_count) {
+      for (DiffSQLGeneratorBEActionInterface *worker : workers)
+        delete worker;
+      workers.clear();
+    }
+  }
+
+  if (workers.empty()) {
+    for (size_t i = 0; i < count; ++i)
+      task(*this, i);
+    return;
+  }
+
+  std::atomic<size_t> next_range(0);
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  auto work = [&]() {
+    DiffSQLGeneratorBE generator(*this);
+    for (size_t range; (range = next_range++) < range_count;) {
+      generator.callback = workers[range];
+      try {
+        for (size_t i = range * count / range_count, end = (range + 1) * count / range_count; i < end; ++i)
+          task(generator, i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < std::min(_worker_count, range_count); ++i)
+    threads.push_back(std::thread(work));
+  work();
+  for (std::thread &thread : threads)
+    thread.join();
+
+  for (DiffSQLGeneratorBEActionInterface *worker : workers) {
+    if (!error)
+      callback->merge_worker(worker);
+    delete worker;
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
 void DiffSQLGeneratorBE::process_diff_change(grt::ValueRef org_object, grt::DiffChange *diff, grt::DictRef map) {
   this->target_list = grt::StringListRef();
   this->target_map = map;
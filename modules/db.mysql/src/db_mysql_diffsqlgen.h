@@ -52,6 +52,7 @@
 #include "grtpp_module_cpp.h"
 #include "grts/structs.db.mysql.h"
 
+#include <functional>
 #include <set>
 
 namespace grt {
@@ -96,6 +97,7 @@ class DiffSQLGeneratorBE {
   bool _case_sensitive;
   bool _use_oid_as_dict_key;
   bool _separate_foreign_keys;
+  size_t _worker_count;
   std::set<std::string> _filtered_schemata, _filtered_tables, _filtered_views, _filtered_routines, _filtered_triggers,
     _filtered_users;
 
@@ -179,6 +181,22 @@ class DiffSQLGeneratorBE {
 
   void do_process_diff_change(grt::ValueRef org_object, grt::DiffChange *);
 
+  /**
+   * Runs per table work on up to _worker_count threads (option GeneratorThreadCount), the output is the same
+   * as when run serially on the calling thread.
+   *
+   * Tasks run on worker threads may only do GRT accesses that are safe off the main thread:
+   *  - reading members, lists and dicts of objects that nobody modifies while the generation runs (the catalog,
+   *    the diff and the options), including the GRT tree below /wb (storage engines, character sets, model
+   *    options) as used by the bec:: helpers;
+   *  - copying and dropping references to such values (reference counts are atomic);
+   *  - creating new, unattached values like strings or temporary lists.
+   * They must not change any object reachable from the GRT tree (this fires change signals, records undo
+   * actions and invalidates cached diff hashes), call modules, run Python code, use the SQL parser facade or
+   * write to the target containers of the call-back. Output goes to the worker call-back only.
+   */
+  void run_tasks(size_t count, const std::function<void(DiffSQLGeneratorBE &, size_t)> &task);
+
 public:
   /**
    * DiffSQLGeneratorBE c-tor
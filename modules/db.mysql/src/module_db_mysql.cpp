@@ -284,8 +284,23 @@ namespace {
     grt::ListRef<GrtNamedObject> target_object_list;
     bool disable_object_list;
 
+    // Set for worker call-backs (see create_worker()). They record what would be remembered and leave the
+    // target containers alone, which are only written on the calling thread by merge_worker().
+    ActionGenerateSQL* _parent;
+    struct RememberedSQL {
+      GrtNamedObjectRef object;
+      std::string sql;
+      bool alter;
+      bool front;
+    };
+    std::vector<RememberedSQL> _remembered;
+
     void remember_alter(const GrtNamedObjectRef& obj, const std::string& sql);
     void remember(const GrtNamedObjectRef& obj, const std::string& sql, const bool front = false);
+    bool was_remembered(const GrtNamedObjectRef& obj) const;
+    std::string object_key(const GrtNamedObjectRef& obj) const {
+      return _use_oids_as_dict_key ? obj.id() : get_full_object_name_for_key(obj, _case_sensitive);
+    }
 
     void alter_table_property(std::string& to, const std::string& name, const std::string& value);
 
@@ -421,11 +436,14 @@ namespace {
     virtual void disable_list_insert(const bool flag) {
       disable_object_list = flag;
     };
+
+    virtual DiffSQLGeneratorBEActionInterface* create_worker();
+    virtual void merge_worker(DiffSQLGeneratorBEActionInterface* worker);
   };
 
   ActionGenerateSQL::ActionGenerateSQL(grt::ValueRef target, grt::ListRef<GrtNamedObject> obj_list,
                                        const grt::DictRef options, bool use_oids_as_key = false)
-    : padding(2), _use_oids_as_dict_key(use_oids_as_key), disable_object_list(false) {
+    : padding(2), _use_oids_as_dict_key(use_oids_as_key), disable_object_list(false), _parent(nullptr) {
     first_column = false;
     first_change = false;
     empty_length = 0;
@@ -1423,17 +1441,7 @@ namespace {
       db_mysql_TriggerRef preceding = find_ordering_for_trigger(trigger, position);
       if (preceding.is_valid()) {
         // check if the remember() at the end of this method was called for the "preceding" object
-        bool flag = false;
-        if (target_list.is_valid()) {
-          if (target_object_list.get_index(preceding) != grt::BaseListRef::npos)
-            flag = true;
-        } else {
-          if (target_map
-                .get(_use_oids_as_dict_key ? preceding.id() : get_full_object_name_for_key(preceding, _case_sensitive))
-                .is_valid())
-            flag = true;
-        }
-        if (!flag) {
+        if (!was_remembered(preceding)) {
           trigger_definition = "CREATE";
           if (!trigger->definer().empty()) {
             std::string definer = trigger->definer();
@@ -1622,6 +1630,12 @@ namespace {
   }
 
   void ActionGenerateSQL::remember(const GrtNamedObjectRef& obj, const std::string& sql, const bool front) {
+    if (_parent != nullptr) {
+      if (!target_list.is_valid() || !disable_object_list)
+        _remembered.push_back({obj, sql, false, front});
+      return;
+    }
+
     if (target_list.is_valid()) {
       if (disable_object_list)
         return;
@@ -1629,14 +1643,19 @@ namespace {
       if (target_object_list.is_valid())
         target_object_list.insert(obj, front ? 0 : (size_t)StringListRef::npos);
     } else {
-      target_map.set(_use_oids_as_dict_key ? obj.id() : get_full_object_name_for_key(obj, _case_sensitive),
-                     grt::StringRef(sql));
+      target_map.set(object_key(obj), grt::StringRef(sql));
     }
   }
 
   // in case of ALTERs there could be > 1 statement to remember
   // so we use grt::StringListRefs as needed
   void ActionGenerateSQL::remember_alter(const GrtNamedObjectRef& obj, const std::string& sql) {
+    if (_parent != nullptr) {
+      if (!target_list.is_valid() || !disable_object_list)
+        _remembered.push_back({obj, sql, true, false});
+      return;
+    }
+
     if (target_list.is_valid()) {
       if (disable_object_list)
         return;
@@ -1646,7 +1665,7 @@ namespace {
       return;
     }
 
-    std::string key = _use_oids_as_dict_key ? obj.id() : get_full_object_name_for_key(obj, _case_sensitive);
+    std::string key = object_key(obj);
 
     if (target_map.has_key(key)) {
       grt::ValueRef value = target_map.get(key);
@@ -1665,6 +1684,44 @@ namespace {
     }
   }
 
+  bool ActionGenerateSQL::was_remembered(const GrtNamedObjectRef& obj) const {
+    if (target_list.is_valid()) {
+      if (target_object_list.get_index(obj) != grt::BaseListRef::npos)
+        return true;
+
+      // Workers must also check what they recorded, the parent's containers don't have that yet.
+      for (std::vector<RememberedSQL>::const_iterator iter = _remembered.begin(); iter != _remembered.end(); ++iter)
+        if (iter->object == obj)
+          return true;
+    } else {
+      std::string key = object_key(obj);
+      if (target_map.get(key).is_valid())
+        return true;
+
+      for (std::vector<RememberedSQL>::const_iterator iter = _remembered.begin(); iter != _remembered.end(); ++iter)
+        if (object_key(iter->object) == key)
+          return true;
+    }
+    return false;
+  }
+
+  DiffSQLGeneratorBEActionInterface* ActionGenerateSQL::create_worker() {
+    ActionGenerateSQL* worker = new ActionGenerateSQL(*this);
+    worker->_parent = this;
+    worker->_remembered.clear();
+    return worker;
+  }
+
+  void ActionGenerateSQL::merge_worker(DiffSQLGeneratorBEActionInterface* worker) {
+    const std::vector<RememberedSQL>& remembered = static_cast<ActionGenerateSQL*>(worker)->_remembered;
+    for (std::vector<RememberedSQL>::const_iterator iter = remembered.begin(); iter != remembered.end(); ++iter) {
+      if (iter->alter)
+        remember_alter(iter->object, iter->sql);
+      else
+        remember(iter->object, iter->sql, iter->front);
+    }
+  }
+
 } // namespace
 
 DbMySQLImpl::DbMySQLImpl(grt::CPPModuleLoader* ldr) : grt::ModuleImplBase(ldr), _default_traits(true) {
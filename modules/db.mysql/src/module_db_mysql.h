@@ -198,6 +198,16 @@ public:
   virtual void alter_schema_default_collate(db_mysql_SchemaRef, grt::StringRef value) = 0;
   virtual void alter_schema_props_end(db_mysql_SchemaRef) = 0;
   virtual void disable_list_insert(const bool flag) = 0;
+
+  // Parallel generation. A worker call-back generates into private buffers and can be used on another thread,
+  // merge_worker() then stores its output as if this call-back had generated it. Call-backs which return
+  // nullptr here are always run on the calling thread. Workers may only read the GRT objects passed in and must
+  // not send output or touch GRT state shared with the main thread (see DiffSQLGeneratorBE::run_tasks()).
+  virtual DiffSQLGeneratorBEActionInterface* create_worker() {
+    return nullptr;
+  }
+  virtual void merge_worker(DiffSQLGeneratorBEActionInterface* worker) {
+  }
 };
 
 #define DOC_DbMySQLImpl                                          \
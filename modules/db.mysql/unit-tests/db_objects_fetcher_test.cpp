@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "../../../plugins/db.mysql/backend/db_objects_fetcher.h"
+#include "base/string_utilities.h"
+#include "connection_helpers.h"
+#include "cppdbc.h"
+#include "wb_helpers.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+BEGIN_TEST_DATA_CLASS(db_objects_fetcher)
+public:
+WBTester *wbt;
+std::vector<sql::ConnectionWrapper> connections;
+TEST_DATA_CONSTRUCTOR(db_objects_fetcher) {
+  wbt = new WBTester;
+}
+END_TEST_DATA_CLASS
+
+TEST_MODULE(db_objects_fetcher, "Parallel fetching of object DDL");
+
+static const char *schema = "db_objects_fetcher_test";
+static const char *empty_schema = "db_objects_fetcher_test_empty";
+
+// Tables named so that each one is also matched by the name of another one if used as an unescaped LIKE pattern.
+static const char *table_names[] = {"a_b", "axb", "a%b", "a%%b", "a\\b", "a\\\\b", "t1", "t2", "t3", "t4"};
+
+static void dummy() {
+}
+
+static std::vector<Db_objects_fetcher::Result> fetch(std::vector<sql::ConnectionWrapper> &connections,
+                                                     const std::vector<std::string> &schemata,
+                                                     const std::string &object_type) {
+  std::vector<Db_objects_fetcher::Result> results;
+  std::thread::id thread_id = std::this_thread::get_id();
+  Db_objects_fetcher fetcher(connections);
+  ensure("fetch completed", fetcher.fetch(schemata, object_type, [&](const Db_objects_fetcher::Result &result) {
+    ensure("result delivered on the calling thread", std::this_thread::get_id() == thread_id);
+    results.push_back(result);
+    return true;
+  }));
+  return results;
+}
+
+TEST_FUNCTION(1) {
+  ensure_equals("plain name", Db_objects_fetcher::escape_like_pattern("table1"), "table1");
+  ensure_equals("wildcards", Db_objects_fetcher::escape_like_pattern("a_b%c"), "a\\_b\\%c");
+  ensure_equals("escape character", Db_objects_fetcher::escape_like_pattern("a\\b"), "a\\\\b");
+  ensure_equals("empty name", Db_objects_fetcher::escape_like_pattern(""), "");
+}
+
+TEST_FUNCTION(2) {
+  populate_grt(*wbt);
+
+  for (int i = 0; i < 3; ++i) {
+    connections.push_back(
+      sql::DriverManager::getDriverManager()->getConnection(wbt->get_connection_properties(), std::bind(dummy)));
+    ensure("connection", connections.back().get() != nullptr);
+  }
+
+  std::unique_ptr<sql::Statement> statement(connections[0]->createStatement());
+  statement->execute(std::string("DROP SCHEMA IF EXISTS ") + schema);
+  statement->execute(std::string("DROP SCHEMA IF EXISTS ") + empty_schema);
+  statement->execute(std::string("CREATE SCHEMA ") + schema);
+  statement->execute(std::string("CREATE SCHEMA ") + empty_schema);
+  statement->execute(std::string("USE ") + schema);
+  for (const char *name : table_names) {
+    std::string quoted = base::escape_backticks(name);
+    statement->execute("CREATE TABLE `" + quoted + "` (id INT PRIMARY KEY, `" + quoted + "_value` INT)");
+  }
+  statement->execute("CREATE VIEW v1 AS SELECT id FROM t1");
+  statement->execute("CREATE PROCEDURE same_name() BEGIN SELECT 1; END");
+  statement->execute("CREATE FUNCTION same_name() RETURNS INT RETURN 1");
+}
+
+// Every table of a schema is fetched exactly once and with its own DDL, even if its name contains LIKE wildcards.
+TEST_FUNCTION(3) {
+  std::vector<Db_objects_fetcher::Result> results = fetch(connections, {schema}, "table");
+  size_t count = sizeof(table_names) / sizeof(table_names[0]);
+  ensure_equals("result count", results.size(), count);
+
+  std::set<std::string> names;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Db_objects_fetcher::Result &result = results[i];
+    ensure_equals("schema", result.schema, schema);
+    ensure_equals("index", result.index, i);
+    ensure_equals("count", result.count, count);
+    ensure("no error", result.error.empty());
+    ensure_equals("one object per result", result.objects.size(), 1U);
+
+    const Db_objects_fetcher::Object &object = result.objects[0];
+    ensure("name seen once", names.insert(object.name).second);
+    std::string column = "`" + base::escape_backticks(object.name) + "_value`";
+    ensure("DDL of the object itself", object.ddl.find(column) != std::string::npos);
+  }
+  for (const char *name : table_names)
+    ensure("table fetched", names.count(name) == 1);
+}
+
+// Results come in schema order, empty and unknown schemata are reported with a single empty result.
+TEST_FUNCTION(4) {
+  std::vector<std::string> schemata = {empty_schema, schema, "", "db_objects_fetcher_test_missing", schema};
+  std::vector<Db_objects_fetcher::Result> results = fetch(connections, schemata, "view");
+  ensure_equals("result count", results.size(), 5U);
+
+  ensure_equals("empty schema first", results[0].schema, empty_schema);
+  ensure_equals("empty schema count", results[0].count, 0U);
+  ensure("no objects in empty schema", results[0].objects.empty());
+
+  ensure_equals("schema", results[1].schema, schema);
+  ensure_equals("view", results[1].objects[0].name, "v1");
+  ensure("view DDL", !results[1].objects[0].ddl.empty());
+
+  ensure_equals("no schema name", results[2].schema, "");
+  ensure_equals("no schema name count", results[2].count, 0U);
+
+  ensure_equals("unknown schema", results[3].schema, "db_objects_fetcher_test_missing");
+  ensure_equals("unknown schema count", results[3].count, 0U);
+  ensure("no objects in unknown schema", results[3].objects.empty());
+
+  ensure_equals("schema listed twice", results[4].schema, schema);
+  ensure_equals("view listed twice", results[4].objects[0].name, "v1");
+}
+
+// A procedure and a function sharing a name are requested once, the result holds both.
+TEST_FUNCTION(5) {
+  std::vector<Db_objects_fetcher::Result> results = fetch(connections, {schema}, "routine");
+  ensure_equals("result count", results.size(), 1U);
+  ensure_equals("count", results[0].count, 1U);
+  ensure_equals("routines", results[0].objects.size(), 2U);
+  for (const Db_objects_fetcher::Object &object : results[0].objects)
+    ensure_equals("routine name", object.name, "same_name");
+}
+
+// A single connection gives the same results as several, and the fetch stops as soon as the slot asks for it.
+TEST_FUNCTION(6) {
+  std::vector<sql::ConnectionWrapper> single(connections.begin(), connections.begin() + 1);
+  std::vector<Db_objects_fetcher::Result> expected = fetch(connections, {schema, empty_schema}, "table");
+  std::vector<Db_objects_fetcher::Result> results = fetch(single, {schema, empty_schema}, "table");
+  ensure_equals("result count", results.size(), expected.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    ensure_equals("schema", results[i].schema, expected[i].schema);
+    ensure_equals("object count", results[i].objects.size(), expected[i].objects.size());
+    if (!results[i].objects.empty()) {
+      ensure_equals("name", results[i].objects[0].name, expected[i].objects[0].name);
+      ensure_equals("ddl", results[i].objects[0].ddl, expected[i].objects[0].ddl);
+    }
+  }
+
+  size_t delivered = 0;
+  Db_objects_fetcher fetcher(connections);
+  ensure("stopped", !fetcher.fetch({schema}, "table", [&](const Db_objects_fetcher::Result &) {
+    return ++delivered < 3;
+  }));
+  ensure_equals("results before stopping", delivered, 3U);
+
+  // The connections are still usable after a stopped fetch.
+  ensure_equals("fetch after stopping", fetch(connections, {schema}, "view").size(), 1U);
+}
+
+TEST_FUNCTION(7) {
+  std::unique_ptr<sql::Statement> statement(connections[0]->createStatement());
+  statement->execute(std::string("DROP SCHEMA ") + schema);
+  statement->execute(std::string("DROP SCHEMA ") + empty_schema);
+  connections.clear();
+}
+
+// Due to the tut nature, this must be executed as a last test always,
+// we can't have this inside of the d-tor.
+TEST_FUNCTION(99) {
+  delete wbt;
+}
+
+END_TESTS
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "testgrt.h"
+#include "grt_test_utility.h"
+#include "grtpp_module_cache.h"
+#include "interfaces/sqlgenerator.h"
+#include "grtsqlparser/mysql_parser_services.h"
+#include "base/file_utilities.h"
+#include "wb_helpers.h"
+
+BEGIN_TEST_DATA_CLASS(db_mysql_module_cache_test)
+protected:
+  WBTester *tester;
+
+  TEST_DATA_CONSTRUCTOR(db_mysql_module_cache_test) {
+    tester = new WBTester;
+  }
+
+  // Replaces a loaded module with the one a warm module cache creates for its file, like on the second start.
+  // Returns the original module, which must be put back with restore().
+  grt::Module *register_cached(const std::string &name) {
+    static const char *cache_file = "db_mysql_module_cache_test.xml";
+    base::tryRemove(cache_file);
+
+    grt::Module *module = grt::GRT::get()->get_module(name);
+    ensure("module " + name, module != NULL);
+    {
+      grt::ModuleCache cache(cache_file);
+      cache.load();
+      cache.store(module, module->path());
+      cache.save();
+    }
+
+    grt::ModuleCache cache(cache_file);
+    cache.load();
+    grt::Module *cached = cache.create_module(module->get_loader(), module->path());
+    ensure("cache entry for " + name, cached != NULL);
+    base::tryRemove(cache_file);
+
+    grt::GRT::get()->unregister_module(module);
+    grt::GRT::get()->register_new_module(cached);
+    return module;
+  }
+
+  void restore(grt::Module *module) {
+    grt::Module *cached = grt::GRT::get()->get_module(module->name());
+    grt::GRT::get()->unregister_module(cached);
+    grt::GRT::get()->register_new_module(module);
+    delete cached;
+  }
+END_TEST_DATA_CLASS
+
+TEST_MODULE(db_mysql_module_cache_test, "DB MySQL: modules created from the module cache");
+
+// The SQL generator is used through its C++ interface by export, sync, reporting and wbbatch.
+TEST_FUNCTION(1) {
+  grt::Module *module = register_cached("DbMySQL");
+  try {
+    ensure("not loaded yet", grt::GRT::get()->get_module("DbMySQL") != module);
+
+    SQLGeneratorInterfaceImpl *sqlgen = grt::GRT::get()->find_native_module<SQLGeneratorInterfaceImpl>("DbMySQL");
+    ensure("native module", sqlgen != NULL);
+    ensure_equals("target DBMS", sqlgen->getTargetDBMSName(), "Mysql");
+    grt::DictRef traits = sqlgen->getTraitsForServerVersion(5, 7, 20);
+    ensure("traits", traits.is_valid());
+  } catch (...) {
+    restore(module);
+    throw;
+  }
+  restore(module);
+}
+
+// The parser services are fetched for every parse in the editors and the importer.
+TEST_FUNCTION(2) {
+  grt::Module *module = register_cached("MySQLParserServices");
+  try {
+    parsers::MySQLParserServices::Ref services = parsers::MySQLParserServices::get();
+    ensure("parser services", services != NULL);
+
+    std::vector<parsers::StatementRange> ranges;
+    std::string sql = "select 1; select 2;";
+    services->determineStatementRanges(sql.c_str(), sql.size(), ";", ranges);
+    ensure_equals("statements", ranges.size(), (size_t)2);
+  } catch (...) {
+    restore(module);
+    throw;
+  }
+  restore(module);
+}
+
+END_TESTS
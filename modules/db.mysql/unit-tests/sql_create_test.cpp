@@ -33,6 +33,7 @@
 #include "db_mysql_diffsqlgen.h"
 
 #include "grtsqlparser/mysql_parser_services.h"
+#include "base/string_utilities.h"
 
 BEGIN_TEST_DATA_CLASS(sql_create_test)
 protected:
@@ -45,7 +46,7 @@ TEST_DATA_CONSTRUCTOR(sql_create_test) {
   diffsql_module = NULL;
 
   // load modules
-  diffsql_module = dynamic_cast<SQLGeneratorInterfaceImpl *>(grt::GRT::get()->get_module("DbMySQL"));
+  diffsql_module = grt::GRT::get()->find_native_module<SQLGeneratorInterfaceImpl>("DbMySQL");
   ensure("DiffSQLGen module initialization", NULL != diffsql_module);
 
   // init datatypes
@@ -551,6 +552,126 @@ TEST_FUNCTION(70) {
   tester->wb->close_document_finish();
 }
 
+// Two schemas with enough tables to be split over several threads, foreign keys within and across the schemas
+// and triggers. The modified version adds, drops and changes tables, keys and triggers.
+static std::string parallel_generation_script(bool modified) {
+  std::string sql;
+  for (const char *schema : { "par_a", "par_b" }) {
+    sql.append(base::strfmt("CREATE SCHEMA %s DEFAULT CHARACTER SET utf8;\n", schema));
+    for (int i = 0; i < 80; ++i) {
+      if (modified && i % 11 == 5)
+        continue;
+
+      sql.append(base::strfmt("CREATE TABLE %s.t%d (id INT NOT NULL, parent INT NULL, v INT NULL", schema, i));
+      if (modified && i % 7 == 3)
+        sql.append(", added VARCHAR(20) NULL");
+      sql.append(", PRIMARY KEY (id)");
+      if (i > 0) {
+        const char *target = (strcmp(schema, "par_b") == 0 && i % 2 == 0) ? "par_a" : schema;
+        int parent = (modified && i % 9 == 4) ? i / 3 : i - 1;
+        if (modified && parent % 11 == 5)
+          --parent;
+        sql.append(base::strfmt(", INDEX fk_t%d_idx (parent), CONSTRAINT fk_%s_t%d FOREIGN KEY (parent) "
+                                "REFERENCES %s.t%d (id) ON DELETE CASCADE",
+                                i, schema, i, target, parent));
+      }
+      sql.append(") ENGINE = InnoDB;\n");
+
+      if (i % 5 == 0 && !(modified && i % 10 == 0))
+        sql.append(base::strfmt("CREATE TRIGGER %s.t%d_bi BEFORE INSERT ON %s.t%d FOR EACH ROW SET NEW.v = %d;\n",
+                                schema, i, schema, i, modified ? i + 1 : i));
+    }
+    if (modified) {
+      for (int i = 80; i < 84; ++i)
+        sql.append(
+          base::strfmt("CREATE TABLE %s.t%d (id INT NOT NULL, PRIMARY KEY (id)) ENGINE = InnoDB;\n", schema, i));
+    }
+  }
+  return sql;
+}
+
+// Per table SQL is generated on worker threads. CREATE and ALTER scripts must be identical to serial generation.
+TEST_FUNCTION(80) {
+  NormalizedComparer cmp;
+  grt::DbObjectMatchAlterOmf omf;
+  cmp.init_omf(&omf);
+
+  parsers::MySQLParserServices::Ref services = parsers::MySQLParserServices::get();
+  parsers::MySQLParserContext::Ref context = services->createParserContext(
+    tester->get_rdbms()->characterSets(), tester->get_rdbms()->version(), "", false);
+
+  auto create_catalog = [&](bool modified) {
+    db_mysql_CatalogRef catalog(grt::Initialized);
+    catalog->version(tester->get_rdbms()->version());
+    catalog->defaultCharacterSetName("utf8");
+    catalog->defaultCollationName("utf8_general_ci");
+    grt::replace_contents(catalog->simpleDatatypes(), tester->get_rdbms()->simpleDatatypes());
+
+    grt::DictRef options(true);
+    ensure_equals("parse script", services->parseSQLIntoCatalog(context, catalog,
+                                                                 parallel_generation_script(modified), options), 0U);
+    return catalog;
+  };
+
+  db_mysql_CatalogRef org_catalog = create_catalog(false);
+  db_mysql_CatalogRef mod_catalog = create_catalog(true);
+  ensure_equals("schema count", mod_catalog->schemata().count(), 2U);
+  ensure_equals("table count", mod_catalog->schemata()[0]->tables().count(), 77U);
+
+  auto create_script = [&](ssize_t threads) {
+    grt::ValueRef e;
+    std::shared_ptr<DiffChange> create_change = diff_make(e, mod_catalog, &omf);
+    std::shared_ptr<DiffChange> drop_change = diff_make(mod_catalog, e, &omf);
+
+    DictRef create_map(true);
+    DictRef drop_map(true);
+    grt::DictRef options(true);
+    options.set("UseFilteredLists", grt::IntegerRef(0));
+    options.set("OutputContainer", create_map);
+    options.set("CaseSensitive", grt::IntegerRef(omf.case_sensitive));
+    options.set("GenerateSchemaDrops", grt::IntegerRef(1));
+    options.set("GenerateDrops", grt::IntegerRef(1));
+    options.set("GenerateDocumentProperties", grt::IntegerRef(0));
+    options.set("GeneratorThreadCount", grt::IntegerRef(threads));
+    diffsql_module->generateSQL(mod_catalog, options, create_change);
+
+    options.set("OutputContainer", drop_map);
+    diffsql_module->generateSQL(mod_catalog, options, drop_change);
+
+    diffsql_module->makeSQLExportScript(mod_catalog, options, create_map, drop_map);
+    return options.get_string("OutputScript");
+  };
+
+  auto alter_script = [&](ssize_t threads) {
+    std::shared_ptr<DiffChange> alter_change = diff_make(org_catalog, mod_catalog, &omf);
+    ensure("alter change", (bool)alter_change);
+
+    grt::StringListRef alter_list(grt::Initialized);
+    grt::ListRef<GrtNamedObject> alter_object_list(true);
+    grt::DictRef options(true);
+    options.set("UseFilteredLists", grt::IntegerRef(0));
+    options.set("OutputContainer", alter_list);
+    options.set("OutputObjectContainer", alter_object_list);
+    options.set("CaseSensitive", grt::IntegerRef(omf.case_sensitive));
+    options.set("GeneratorThreadCount", grt::IntegerRef(threads));
+    diffsql_module->generateSQL(mod_catalog, options, alter_change);
+    diffsql_module->makeSQLSyncScript(mod_catalog, options, alter_list, alter_object_list);
+    return options.get_string("OutputScript");
+  };
+
+  std::string serial_create = create_script(1);
+  ensure("create script has foreign keys", serial_create.find("REFERENCES `par_a`.`t") != std::string::npos);
+  ensure("create script has triggers", serial_create.find("t5_bi") != std::string::npos);
+  ensure_equals("parallel create script", create_script(4), serial_create);
+  ensure_equals("parallel create script, odd thread count", create_script(3), serial_create);
+
+  std::string serial_alter = alter_script(1);
+  ensure("alter script has changes", serial_alter.find("ALTER TABLE") != std::string::npos);
+  ensure("alter script drops tables", serial_alter.find("DROP TABLE") != std::string::npos);
+  ensure_equals("parallel alter script", alter_script(4), serial_alter);
+  ensure_equals("parallel alter script, odd thread count", alter_script(3), serial_alter);
+}
+
 // Due to the tut nature, this must be executed as a last test always,
 // we can't have this inside of the d-tor.
 TEST_FUNCTION(99) {
@@ -0,0 +1,507 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "force_layout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+//------------------------------------------------------------------------------
+
+namespace {
+
+  // Buckets node indices by position, so that neighbours can be found without looking at all nodes.
+  class NodeGrid {
+  public:
+    NodeGrid(double cell_size) : _cell_size(cell_size) {
+    }
+
+    void add(size_t node, double x, double y) {
+      _cells[key(cell(x), cell(y))].push_back(node);
+    }
+
+    // Calls f for every node in the cell containing (x, y) and the 8 cells around it.
+    template <typename F>
+    void for_each_near(double x, double y, F f) const {
+      long cx = cell(x), cy = cell(y);
+      for (long i = cx - 1; i <= cx + 1; ++i) {
+        for (long j = cy - 1; j <= cy + 1; ++j) {
+          std::unordered_map<long long, std::vector<size_t> >::const_iterator iter = _cells.find(key(i, j));
+          if (iter != _cells.end()) {
+            for (size_t node : iter->second)
+              f(node);
+          }
+        }
+      }
+    }
+
+  private:
+    double _cell_size;
+    std::unordered_map<long long, std::vector<size_t> > _cells;
+
+    long cell(double v) const {
+      return (long)std::floor(v / _cell_size);
+    }
+
+    static long long key(long x, long y) {
+      return ((long long)x << 32) ^ (long long)(unsigned int)y;
+    }
+  };
+
+  // Components with fewer nodes are relaxed on the calling thread only.
+  const size_t min_nodes_per_thread = 128;
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * A fixed set of threads which run the chunks of a range together with the calling thread. The relaxation runs
+ * hundreds of short steps per component, so the threads are kept for the whole layout instead of being started
+ * for every step.
+ */
+class ForceLayout::WorkerPool {
+public:
+  WorkerPool(unsigned int thread_count) {
+    for (unsigned int i = 1; i < thread_count; ++i)
+      _workers.push_back(std::thread(&WorkerPool::work, this, i));
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopped = true;
+    }
+    _start.notify_all();
+    for (auto &worker : _workers)
+      worker.join();
+  }
+
+  unsigned int size() const {
+    return (unsigned int)_workers.size() + 1;
+  }
+
+  // Runs f(begin, end) over [0, count) split into up to chunk_count chunks. The calling thread takes the first one.
+  void run(size_t count, unsigned int chunk_count, const std::function<void(size_t, size_t)> &f) {
+    chunk_count = std::min(chunk_count, size());
+    if (chunk_count <= 1 || count < 2 * chunk_count) {
+      f(0, count);
+      return;
+    }
+
+    size_t chunk = (count + chunk_count - 1) / chunk_count;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _job = &f;
+      _count = count;
+      _chunk = chunk;
+      _chunk_count = chunk_count;
+      _pending = (unsigned int)_workers.size();
+      ++_generation;
+    }
+    _start.notify_all();
+
+    f(0, std::min(count, chunk));
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this]() { return _pending == 0; });
+    _job = nullptr;
+  }
+
+private:
+  std::vector<std::thread> _workers;
+  std::mutex _mutex;
+  std::condition_variable _start;
+  std::condition_variable _done;
+  const std::function<void(size_t, size_t)> *_job = nullptr;
+  size_t _count = 0;
+  size_t _chunk = 0;
+  unsigned int _chunk_count = 0;
+  unsigned int _pending = 0;
+  unsigned long _generation = 0;
+  bool _stopped = false;
+
+  void work(unsigned int index) {
+    unsigned long seen = 0;
+    for (;;) {
+      const std::function<void(size_t, size_t)> *job;
+      size_t begin, end;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _start.wait(lock, [&]() { return _stopped || _generation != seen; });
+        if (_stopped)
+          return;
+        seen = _generation;
+        job = index < _chunk_count ? _job : nullptr;
+        begin = index * _chunk;
+        end = std::min(_count, begin + _chunk);
+      }
+
+      if (job != nullptr && begin < end)
+        (*job)(begin, end);
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (--_pending == 0)
+        _done.notify_all();
+    }
+  }
+};
+
+//------------------------------------------------------------------------------
+
+size_t ForceLayout::add_node(double width, double height) {
+  Node node;
+  node.width = width;
+  node.height = height;
+  node.x = width / 2;
+  node.y = height / 2;
+  _nodes.push_back(node);
+  return _nodes.size() - 1;
+}
+
+//------------------------------------------------------------------------------
+
+void ForceLayout::connect(size_t node1, size_t node2) {
+  if (node1 == node2 || node1 >= _nodes.size() || node2 >= _nodes.size())
+    return;
+
+  std::vector<size_t> &links = _nodes[node1].links;
+  if (std::find(links.begin(), links.end(), node2) != links.end())
+    return;
+
+  links.push_back(node2);
+  _nodes[node2].links.push_back(node1);
+}
+
+//------------------------------------------------------------------------------
+
+void ForceLayout::layout(const Options &options) {
+  std::vector<Component> components = find_components();
+
+  // Components are sorted by size, so the first one decides how many threads are worth starting.
+  unsigned int thread_count = options.threads > 0 ? options.threads : std::thread::hardware_concurrency();
+  size_t largest = components.empty() ? 0 : components.front().nodes.size();
+  WorkerPool pool(std::max(1U, std::min(thread_count, (unsigned int)(largest / min_nodes_per_thread))));
+
+  for (size_t i = 0; i < components.size(); ++i) {
+    Component &component = components[i];
+
+    // The ideal distance between the centers of two linked nodes.
+    double average_size = 0;
+    for (size_t node : component.nodes)
+      average_size += (_nodes[node].width + _nodes[node].height) / 2;
+    double edge_length = average_size / component.nodes.size() + options.spacing;
+
+    if (component.nodes.size() > 1) {
+      seed_component(component, edge_length, options.seed + (unsigned int)i);
+      relax_component(component, edge_length, options, pool);
+      remove_overlaps(component, options.spacing);
+    }
+    normalize_component(component);
+  }
+
+  pack_components(components, options);
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Returns the connected components, largest first. Nodes keep their insertion order within a component.
+ */
+std::vector<ForceLayout::Component> ForceLayout::find_components() const {
+  std::vector<Component> components;
+  std::vector<bool> visited(_nodes.size(), false);
+
+  for (size_t start = 0; start < _nodes.size(); ++start) {
+    if (visited[start])
+      continue;
+
+    Component component;
+    std::deque<size_t> queue(1, start);
+    visited[start] = true;
+    while (!queue.empty()) {
+      size_t node = queue.front();
+      queue.pop_front();
+      component.nodes.push_back(node);
+      for (size_t link : _nodes[node].links) {
+        if (!visited[link]) {
+          visited[link] = true;
+          queue.push_back(link);
+        }
+      }
+    }
+    std::sort(component.nodes.begin(), component.nodes.end());
+    component.width = component.height = 0;
+    components.push_back(component);
+  }
+
+  std::stable_sort(components.begin(), components.end(), [](const Component &c1, const Component &c2) {
+    return c1.nodes.size() > c2.nodes.size();
+  });
+  return components;
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Places the nodes of a component on a square grid in breadth first order, starting at the node with the most links,
+ * so that linked nodes start out close to each other. A little jitter breaks the symmetry of the grid.
+ */
+void ForceLayout::seed_component(const Component &component, double edge_length, unsigned int seed) {
+  size_t root = component.nodes.front();
+  for (size_t node : component.nodes) {
+    if (_nodes[node].links.size() > _nodes[root].links.size())
+      root = node;
+  }
+
+  std::vector<size_t> order;
+  std::unordered_map<size_t, bool> placed;
+  std::deque<size_t> queue(1, root);
+  placed[root] = true;
+  while (!queue.empty()) {
+    size_t node = queue.front();
+    queue.pop_front();
+    order.push_back(node);
+
+    // Visit the best connected neighbours first.
+    std::vector<size_t> links(_nodes[node].links);
+    std::stable_sort(links.begin(), links.end(),
+                     [this](size_t n1, size_t n2) { return _nodes[n1].links.size() > _nodes[n2].links.size(); });
+    for (size_t link : links) {
+      if (!placed[link]) {
+        placed[link] = true;
+        queue.push_back(link);
+      }
+    }
+  }
+
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<double> jitter(-edge_length / 4, edge_length / 4);
+  size_t columns = (size_t)std::ceil(std::sqrt((double)order.size()));
+  for (size_t i = 0; i < order.size(); ++i) {
+    Node &node = _nodes[order[i]];
+    node.x = (i % columns) * edge_length + jitter(random);
+    node.y = (i / columns) * edge_length + jitter(random);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Fruchterman-Reingold relaxation. Repulsion (k^2 / d) is only applied between nodes closer than 2k, which the grid
+ * finds in constant time per node; attraction (d^2 / k) acts along links. Every node's displacement is computed from
+ * the positions of the previous step only, so the nodes can be split across threads without changing the result.
+ */
+void ForceLayout::relax_component(const Component &component, double edge_length, const Options &options,
+                                  WorkerPool &pool) {
+  const std::vector<size_t> &nodes = component.nodes;
+  const double k = edge_length;
+  const double cutoff = 2 * k;
+  const double start_temperature = k * std::sqrt((double)nodes.size()) / 2;
+  const unsigned int chunk_count = std::max(1U, (unsigned int)(nodes.size() / min_nodes_per_thread));
+
+  std::vector<double> dx(_nodes.size()), dy(_nodes.size());
+  for (int iteration = 0; iteration < options.iterations; ++iteration) {
+    NodeGrid grid(cutoff);
+    for (size_t node : nodes)
+      grid.add(node, _nodes[node].x, _nodes[node].y);
+
+    pool.run(nodes.size(), chunk_count, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        size_t index = nodes[i];
+        const Node &node = _nodes[index];
+        double fx = 0, fy = 0;
+
+        grid.for_each_near(node.x, node.y, [&](size_t other_index) {
+          if (other_index == index)
+            return;
+          const Node &other = _nodes[other_index];
+          double x = node.x - other.x, y = node.y - other.y;
+          double distance = std::sqrt(x * x + y * y);
+          if (distance >= cutoff)
+            return;
+          if (distance < 0.01) {
+            // Nodes on top of each other: push apart in a direction that only depends on their indices.
+            x = index < other_index ? -1 : 1;
+            y = 0;
+            distance = 0.01;
+          }
+          double force = k * k / distance;
+          fx += x / distance * force;
+          fy += y / distance * force;
+        });
+
+        for (size_t link : node.links) {
+          const Node &other = _nodes[link];
+          double x = other.x - node.x, y = other.y - node.y;
+          double distance = std::sqrt(x * x + y * y);
+          if (distance > 0) {
+            double force = distance * distance / k;
+            fx += x / distance * force;
+            fy += y / distance * force;
+          }
+        }
+        dx[index] = fx;
+        dy[index] = fy;
+      }
+    });
+
+    // Linear cooling, limiting how far a node may move in one step.
+    double temperature = start_temperature * (1 - (double)iteration / options.iterations) + k / 100;
+    for (size_t node : nodes) {
+      double length = std::sqrt(dx[node] * dx[node] + dy[node] * dy[node]);
+      if (length > 0) {
+        double step = std::min(length, temperature);
+        _nodes[node].x += dx[node] / length * step;
+        _nodes[node].y += dy[node] / length * step;
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Pushes overlapping nodes apart (plus the spacing around them) along the axis with the smaller overlap. Dense
+ * clusters can keep pushing each other back and forth, so if that doesn't settle the component is spread out a bit
+ * and the process is repeated.
+ */
+void ForceLayout::remove_overlaps(const Component &component, double spacing) {
+  const std::vector<size_t> &nodes = component.nodes;
+  const double margin = spacing / 2;
+
+  // Cells as large as the largest node make sure that overlapping nodes are always in neighbouring cells.
+  double cell_size = 0;
+  for (size_t node : nodes)
+    cell_size = std::max(cell_size, std::max(_nodes[node].width, _nodes[node].height) + margin);
+
+  for (;;) {
+    for (int pass = 0; pass < 50; ++pass) {
+      NodeGrid grid(cell_size);
+      for (size_t node : nodes)
+        grid.add(node, _nodes[node].x, _nodes[node].y);
+
+      bool moved = false;
+      for (size_t index : nodes) {
+        grid.for_each_near(_nodes[index].x, _nodes[index].y, [&](size_t other_index) {
+          if (other_index <= index)
+            return;
+
+          Node &node = _nodes[index];
+          Node &other = _nodes[other_index];
+          double overlap_x = (node.width + other.width) / 2 + margin - std::fabs(node.x - other.x);
+          double overlap_y = (node.height + other.height) / 2 + margin - std::fabs(node.y - other.y);
+          if (overlap_x <= 0 || overlap_y <= 0)
+            return;
+
+          // Coincident nodes are split by index, so the result doesn't depend on anything else.
+          if (overlap_x < overlap_y) {
+            double shift = node.x <= other.x ? overlap_x / 2 : -overlap_x / 2;
+            node.x -= shift;
+            other.x += shift;
+          } else {
+            double shift = node.y <= other.y ? overlap_y / 2 : -overlap_y / 2;
+            node.y -= shift;
+            other.y += shift;
+          }
+          moved = true;
+        });
+      }
+      if (!moved)
+        return;
+    }
+
+    for (size_t node : nodes) {
+      _nodes[node].x *= 1.1;
+      _nodes[node].y *= 1.1;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Moves a component so its top left corner is at (0, 0) and stores its size.
+ */
+void ForceLayout::normalize_component(Component &component) {
+  double left = HUGE_VAL, top = HUGE_VAL, right = -HUGE_VAL, bottom = -HUGE_VAL;
+  for (size_t index : component.nodes) {
+    const Node &node = _nodes[index];
+    left = std::min(left, node.x - node.width / 2);
+    top = std::min(top, node.y - node.height / 2);
+    right = std::max(right, node.x + node.width / 2);
+    bottom = std::max(bottom, node.y + node.height / 2);
+  }
+
+  for (size_t index : component.nodes) {
+    _nodes[index].x -= left;
+    _nodes[index].y -= top;
+  }
+  component.width = right - left;
+  component.height = bottom - top;
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Places the components in rows, largest first. Without a given width the rows are made about as wide as the
+ * square root of the total area, which gives a roughly square result.
+ */
+void ForceLayout::pack_components(std::vector<Component> &components, const Options &options) {
+  double row_width = options.max_width;
+  if (row_width <= 0) {
+    double area = 0;
+    for (const Component &component : components)
+      area += (component.width + options.spacing) * (component.height + options.spacing);
+    row_width = std::sqrt(area);
+  }
+  for (const Component &component : components)
+    row_width = std::max(row_width, component.width);
+
+  double x = 0, y = 0, row_height = 0;
+  _width = _height = 0;
+  for (const Component &component : components) {
+    if (x > 0 && x + component.width > row_width) {
+      x = 0;
+      y += row_height + options.spacing;
+      row_height = 0;
+    }
+
+    for (size_t index : component.nodes) {
+      _nodes[index].x += x;
+      _nodes[index].y += y;
+    }
+
+    _width = std::max(_width, x + component.width);
+    _height = std::max(_height, y + component.height);
+    x += component.width + options.spacing;
+    row_height = std::max(row_height, component.height);
+  }
+}
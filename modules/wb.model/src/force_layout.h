@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Force directed placement of boxes (e.g. table figures) connected by edges (relationships).
+ *
+ * The nodes are split into the connected components of the edge graph. Every component is seeded with a breadth
+ * first grid placement and then relaxed with Fruchterman-Reingold forces, where repulsion is only evaluated between
+ * nodes in neighbouring cells of a uniform grid. Remaining overlaps are removed afterwards and the components are
+ * packed into rows. The force evaluation runs on several threads for larger components; the result depends only on
+ * the input and the seed, not on the number of threads.
+ */
+class ForceLayout {
+public:
+  struct Options {
+    Options() : seed(1), iterations(300), spacing(80), max_width(0), threads(0) {
+    }
+
+    unsigned int seed;
+    int iterations;     // Force iterations per component.
+    double spacing;     // Desired free space between nodes.
+    double max_width;   // Width available for the packed components, 0 to choose one.
+    unsigned int threads; // 0 uses one thread per core.
+  };
+
+  size_t add_node(double width, double height);
+  void connect(size_t node1, size_t node2);
+
+  void layout(const Options &options);
+
+  // Top left corner of a node, valid after layout().
+  double left(size_t node) const {
+    return _nodes[node].x - _nodes[node].width / 2;
+  }
+  double top(size_t node) const {
+    return _nodes[node].y - _nodes[node].height / 2;
+  }
+
+  // Size of the area covered by all nodes after layout().
+  double width() const {
+    return _width;
+  }
+  double height() const {
+    return _height;
+  }
+
+private:
+  struct Node {
+    double width;
+    double height;
+    double x; // Center.
+    double y;
+    std::vector<size_t> links;
+  };
+
+  struct Component {
+    std::vector<size_t> nodes;
+    double width;
+    double height;
+  };
+
+  class WorkerPool;
+
+  std::vector<Node> _nodes;
+  double _width = 0;
+  double _height = 0;
+
+  std::vector<Component> find_components() const;
+  void seed_component(const Component &component, double edge_length, unsigned int seed);
+  void relax_component(const Component &component, double edge_length, const Options &options, WorkerPool &pool);
+  void remove_overlaps(const Component &component, double spacing);
+  void normalize_component(Component &component);
+  void pack_components(std::vector<Component> &components, const Options &options);
+};
@@ -980,7 +980,7 @@ ssize_t WbModelImpl::generateReport(workbench_physical_ModelRef model, const grt
         break;
       }
     }*/
-    sqlgenModule = dynamic_cast<SQLGeneratorInterfaceImpl *>(grt::GRT::get()->get_module("DbMySQL"));
+    sqlgenModule = grt::GRT::get()->find_native_module<SQLGeneratorInterfaceImpl>("DbMySQL");
     if (!sqlgenModule)
       throw std::logic_error("could not find SQL generation module for mysql");
   }
@@ -30,6 +30,8 @@
 #include "base/wb_iterators.h"
 #include "base/file_utilities.h"
 
+#include "force_layout.h"
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -162,6 +164,7 @@ ListRef<app_Plugin> WbModelImpl::getPluginInfo() {
 
   def_export_view_plugin("center", "Center Diagram Contents", list);
   def_export_view_plugin("autolayout", "Autolayout Figures", list);
+  def_export_view_plugin("autolayoutForceDirected", "Autolayout Figures (Force Directed)", list);
 
   def_export_catalog_plugin("createDiagramWithCatalog", "Autoplace Objects of the Catalog on New Model", list);
 
@@ -720,6 +723,93 @@ static bool calculate_view_size(const app_PageSettingsRef &page, double &width,
   }
 }
 
+//------------------------------------------------------------------------------
+/**
+ * Same as autolayout(), but uses the force directed ForceLayout engine, which copes with diagrams of thousands of
+ * figures. The result only depends on the diagram contents, so running it twice gives the same placement.
+ */
+int WbModelImpl::autolayoutForceDirected(model_DiagramRef view) {
+  ListRef<model_Object> selection = view->selection();
+  ListRef<model_Layer> layers = view->layers();
+
+  begin_undo_group();
+
+  do_force_directed_layout(view, view->rootLayer(), selection);
+  for (std::size_t i = 0, layerCount = layers.count(); i != layerCount; ++i)
+    do_force_directed_layout(view, layers.get(i), selection);
+
+  end_undo_group(std::string(_("Autolayout Model '")).append(view->name()).append(_("'")));
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+void WbModelImpl::do_force_directed_layout(const model_DiagramRef &view, const model_LayerRef &layer,
+                                           ListRef<model_Object> &selection) {
+  static const double margin = 20;
+
+  std::vector<model_ObjectRef> candidates;
+  if (selection.count() > 0) {
+    for (std::size_t i = 0; i < selection.count(); ++i)
+      candidates.push_back(selection[i]);
+  } else {
+    for (std::size_t i = 0; i < layer->figures().count(); ++i)
+      candidates.push_back(layer->figures()[i]);
+  }
+
+  std::vector<model_FigureRef> figures;
+  std::map<std::string, size_t> nodes;
+  for (const model_ObjectRef &object : candidates) {
+    if (!workbench_physical_TableFigureRef::can_wrap(object) && !workbench_physical_ViewFigureRef::can_wrap(object))
+      continue;
+
+    model_FigureRef figure(model_FigureRef::cast_from(object));
+    if (figure->layer() == layer && nodes.find(figure.id()) == nodes.end()) {
+      nodes[figure.id()] = figures.size();
+      figures.push_back(figure);
+    }
+  }
+  if (figures.empty())
+    return;
+
+  ForceLayout layout;
+  for (size_t i = 0; i < figures.size(); ++i)
+    layout.add_node(*figures[i]->width(), *figures[i]->height());
+
+  ListRef<model_Connection> connections = view->connections();
+  for (std::size_t i = 0; i < connections.count(); ++i) {
+    const model_ConnectionRef conn = connections[i];
+    if (!conn->startFigure().is_valid() || !conn->endFigure().is_valid())
+      continue;
+
+    std::map<std::string, size_t>::const_iterator start = nodes.find(conn->startFigure().id());
+    std::map<std::string, size_t>::const_iterator end = nodes.find(conn->endFigure().id());
+    if (start != nodes.end() && end != nodes.end())
+      layout.connect(start->second, end->second);
+  }
+
+  ForceLayout::Options options;
+  options.max_width = *layer->width() - 2 * margin;
+  layout.layout(options);
+
+  for (size_t i = 0; i < figures.size(); ++i) {
+    figures[i]->left(floor(layout.left(i)) + margin);
+    figures[i]->top(floor(layout.top(i)) + margin);
+  }
+
+  // Large diagrams may need more pages than the diagram currently has.
+  if (layer == view->rootLayer()) {
+    double page_width, page_height;
+    calculate_view_size(app_PageSettingsRef::cast_from(grt::GRT::get()->get("/wb/doc/pageSettings")), page_width,
+                        page_height);
+
+    double width = std::max(*view->width(), layout.width() + 2 * margin);
+    double height = std::max(*view->height(), layout.height() + 2 * margin);
+    if (width > *view->width() || height > *view->height())
+      view->setPageCounts((ssize_t)ceil(width / page_width), (ssize_t)ceil(height / page_height));
+  }
+}
+
 workbench_physical_DiagramRef WbModelImpl::add_model_view(
   const db_CatalogRef &catalog, int xpages,
   int ypages) { // XXX TODO move this to Workbench module so we can reuse the same code as from wb_component
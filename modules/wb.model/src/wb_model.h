@@ -44,6 +44,7 @@ public:
   DEFINE_INIT_MODULE(WbModel_VERSION, "Oracle and/or its affiliates", grt::ModuleImplBase,
                      DECLARE_MODULE_FUNCTION(WbModelImpl::getPluginInfo),
                      DECLARE_MODULE_FUNCTION(WbModelImpl::autolayout),
+                     DECLARE_MODULE_FUNCTION(WbModelImpl::autolayoutForceDirected),
                      DECLARE_MODULE_FUNCTION(WbModelImpl::createDiagramWithCatalog),
                      DECLARE_MODULE_FUNCTION(WbModelImpl::createDiagramWithObjects),
                      DECLARE_MODULE_FUNCTION(WbModelImpl::fitObjectsToContents),
@@ -59,6 +60,7 @@ public:
 
   int center(model_DiagramRef view);
   int autolayout(model_DiagramRef view);
+  int autolayoutForceDirected(model_DiagramRef view);
 
   int createDiagramWithCatalog(workbench_physical_ModelRef model, db_CatalogRef catalog);
   int createDiagramWithObjects(workbench_physical_ModelRef model, grt::ListRef<GrtObject> objects);
@@ -87,6 +89,8 @@ private:
   bool _use_objects_from_catalog;
 
   int do_autolayout(const model_LayerRef &layer, grt::ListRef<model_Object> &selection);
+  void do_force_directed_layout(const model_DiagramRef &view, const model_LayerRef &layer,
+                                grt::ListRef<model_Object> &selection);
   int do_autoplace_any_list(const model_DiagramRef &view, grt::ListRef<GrtObject> &obj_list);
   int autoplace_relations(const model_DiagramRef &view, const grt::ListRef<db_Table> &tables);
   void handle_fklist_change(const model_DiagramRef &view, const db_TableRef &table, const db_ForeignKeyRef &fk,
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "../src/force_layout.h"
+#include "wb_helpers.h"
+
+#include <cmath>
+#include <random>
+
+BEGIN_TEST_DATA_CLASS(force_layout_test)
+protected:
+  // A few connected clusters of differently sized nodes, a chain and some unconnected nodes.
+  void build_graph(ForceLayout &layout, size_t cluster_size) {
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> size(40, 200);
+
+    for (size_t cluster = 0; cluster < 3; ++cluster) {
+      size_t first = layout.add_node(size(random), size(random));
+      for (size_t i = 1; i < cluster_size; ++i) {
+        size_t node = layout.add_node(size(random), size(random));
+        std::uniform_int_distribution<size_t> target(first, node - 1);
+        layout.connect(node, target(random));
+        if (i % 3 == 0)
+          layout.connect(node, target(random));
+      }
+    }
+
+    size_t previous = layout.add_node(100, 60);
+    for (size_t i = 0; i < 10; ++i) {
+      size_t node = layout.add_node(100, 60);
+      layout.connect(previous, node);
+      previous = node;
+    }
+
+    for (size_t i = 0; i < 5; ++i)
+      layout.add_node(120, 80);
+  }
+
+  void check_no_overlaps(const ForceLayout &layout, const std::vector<std::pair<double, double> > &sizes,
+                         double spacing) {
+    // Overlaps are removed with half the spacing as margin, allow for rounding.
+    double margin = spacing / 2 - 0.001;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      ensure("left inside", layout.left(i) >= -0.001);
+      ensure("top inside", layout.top(i) >= -0.001);
+      ensure("right inside", layout.left(i) + sizes[i].first <= layout.width() + 0.001);
+      ensure("bottom inside", layout.top(i) + sizes[i].second <= layout.height() + 0.001);
+
+      for (size_t j = i + 1; j < sizes.size(); ++j) {
+        bool apart_x = layout.left(i) + sizes[i].first + margin <= layout.left(j) ||
+                       layout.left(j) + sizes[j].first + margin <= layout.left(i);
+        bool apart_y = layout.top(i) + sizes[i].second + margin <= layout.top(j) ||
+                       layout.top(j) + sizes[j].second + margin <= layout.top(i);
+        ensure("no overlap", apart_x || apart_y);
+      }
+    }
+  }
+END_TEST_DATA_CLASS
+
+TEST_MODULE(force_layout_test, "force directed layout");
+
+// Nodes must not overlap each other and everything must be inside the reported area.
+TEST_FUNCTION(1) {
+  ForceLayout layout;
+  std::vector<std::pair<double, double> > sizes;
+  std::mt19937 random(7);
+  std::uniform_int_distribution<int> size(40, 160);
+  for (size_t i = 0; i < 60; ++i) {
+    sizes.push_back(std::make_pair(size(random), size(random)));
+    layout.add_node(sizes.back().first, sizes.back().second);
+    if (i > 0)
+      layout.connect(i, i / 2);
+  }
+
+  ForceLayout::Options options;
+  options.iterations = 100;
+  layout.layout(options);
+
+  check_no_overlaps(layout, sizes, options.spacing);
+}
+
+// The result only depends on the input and the seed, not on the number of threads.
+TEST_FUNCTION(2) {
+  ForceLayout::Options options;
+  options.iterations = 30;
+
+  ForceLayout single, multi;
+  build_graph(single, 400);
+  build_graph(multi, 400);
+
+  options.threads = 1;
+  single.layout(options);
+  options.threads = 4;
+  multi.layout(options);
+
+  ensure_equals("width", single.width(), multi.width());
+  ensure_equals("height", single.height(), multi.height());
+  for (size_t i = 0; i < 3 * 400 + 16; ++i) {
+    ensure_equals("left", single.left(i), multi.left(i));
+    ensure_equals("top", single.top(i), multi.top(i));
+  }
+
+  // Running again with the same input gives the same result.
+  ForceLayout again;
+  build_graph(again, 400);
+  again.layout(options);
+  for (size_t i = 0; i < 3 * 400 + 16; ++i)
+    ensure_equals("repeated left", again.left(i), multi.left(i));
+}
+
+// Unconnected parts are packed into rows no wider than the given width (unless a single part is wider).
+TEST_FUNCTION(3) {
+  ForceLayout layout;
+  std::vector<std::pair<double, double> > sizes;
+  for (size_t i = 0; i < 20; ++i) {
+    sizes.push_back(std::make_pair(100, 50));
+    layout.add_node(100, 50);
+  }
+
+  ForceLayout::Options options;
+  options.max_width = 500;
+  layout.layout(options);
+
+  ensure("packed width", layout.width() <= options.max_width);
+  ensure("several rows", layout.height() > 3 * 50);
+  check_no_overlaps(layout, sizes, options.spacing);
+}
+
+// Linked nodes end up closer to each other than unlinked ones.
+TEST_FUNCTION(4) {
+  ForceLayout layout;
+  const size_t count = 30;
+  for (size_t i = 0; i < count; ++i) {
+    layout.add_node(100, 60);
+    if (i > 0)
+      layout.connect(i - 1, i);
+  }
+
+  ForceLayout::Options options;
+  layout.layout(options);
+
+  auto distance = [&](size_t a, size_t b) {
+    return std::hypot(layout.left(a) - layout.left(b), layout.top(a) - layout.top(b));
+  };
+  double linked = 0, all = 0;
+  size_t pairs = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (i > 0)
+      linked += distance(i - 1, i);
+    for (size_t j = i + 1; j < count; ++j, ++pairs)
+      all += distance(i, j);
+  }
+  ensure("linked nodes are closer", linked / (count - 1) < all / pairs);
+}
+
+END_TESTS
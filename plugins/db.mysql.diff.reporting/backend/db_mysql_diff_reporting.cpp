@@ -83,7 +83,7 @@ std::string DbMySQLDiffReporting::generate_report(const db_mysql_CatalogRef& lef
   bec::apply_user_datatypes(left_cat_copy, rdbms);
 
   SQLGeneratorInterfaceImpl* diffsql_module =
-    dynamic_cast<SQLGeneratorInterfaceImpl*>(grt::GRT::get()->get_module("DbMySQL"));
+    grt::GRT::get()->find_native_module<SQLGeneratorInterfaceImpl>("DbMySQL");
 
   if (diffsql_module == NULL)
     throw DbMySQLDiffReportingException("error loading module DbMySQL");
@@ -1852,12 +1852,14 @@ void MySQLTableEditorBE::reset_partition_definitions(int parts, int subparts) {
 }
 
 db_TableRef MySQLTableEditorBE::create_stub_table(const std::string &schema, const std::string &table) {
+  grt::index_list(get_catalog()->schemata());
   db_SchemaRef dbschema = grt::find_named_object_in_list(get_catalog()->schemata(), schema, false);
   db_TableRef dbtable;
 
-  if (dbschema.is_valid())
+  if (dbschema.is_valid()) {
+    grt::index_list(dbschema->tables());
     dbtable = grt::find_named_object_in_list(dbschema->tables(), table);
-  else {
+  } else {
     dbschema = db_mysql_SchemaRef(grt::Initialized);
     dbschema->owner(get_catalog());
     dbschema->name(schema);
@@ -59,7 +59,7 @@ DbMySQLDiffAlter::~DbMySQLDiffAlter() {
 
 std::string DbMySQLDiffAlter::generate_alter() {
   SQLGeneratorInterfaceImpl *diffsql_module =
-    dynamic_cast<SQLGeneratorInterfaceImpl *>(grt::GRT::get()->get_module("DbMySQL"));
+    grt::GRT::get()->find_native_module<SQLGeneratorInterfaceImpl>("DbMySQL");
 
   if (diffsql_module == NULL)
     throw std::runtime_error("Could not find module DbMySQL");
@@ -222,7 +222,7 @@ std::shared_ptr<DiffTreeBE> DbMySQLDiffAlter::init_diff_tree(const std::vector<s
   _alter_change = diff_make(right_cat_copy, _left_cat_copy, &omf);
 
   SQLGeneratorInterfaceImpl *diffsql_module =
-    dynamic_cast<SQLGeneratorInterfaceImpl *>(grt::GRT::get()->get_module("DbMySQL"));
+    grt::GRT::get()->find_native_module<SQLGeneratorInterfaceImpl>("DbMySQL");
   if (diffsql_module == NULL)
     throw DbMySQLDiffAlterException("error loading module DbMySQL");
 
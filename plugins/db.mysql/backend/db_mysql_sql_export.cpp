@@ -132,7 +132,7 @@ void DbMySQLSQLExport::set_option(const std::string &name, const std::string &va
 
 void DbMySQLSQLExport::set_db_options_for_version(const GrtVersionRef &version) {
   SQLGeneratorInterfaceImpl *diffsql_module =
-    dynamic_cast<SQLGeneratorInterfaceImpl *>(grt::GRT::get()->get_module("DbMySQL"));
+    grt::GRT::get()->find_native_module<SQLGeneratorInterfaceImpl>("DbMySQL");
   if (diffsql_module != NULL)
     _db_options = diffsql_module->getTraitsForServerVersion((int)version->majorNumber(), (int)version->minorNumber(),
                                                             (int)version->releaseNumber());
@@ -276,7 +276,7 @@ ValueRef DbMySQLSQLExport::export_task(grt::StringRef) {
 
   try {
     SQLGeneratorInterfaceImpl *diffsql_module =
-      dynamic_cast<SQLGeneratorInterfaceImpl *>(grt::GRT::get()->get_module("DbMySQL"));
+      grt::GRT::get()->find_native_module<SQLGeneratorInterfaceImpl>("DbMySQL");
 
     if (diffsql_module == NULL)
       return grt::StringRef("\nSQL Script Export Error: Not able to load 'DbMySQL' module");
@@ -1158,6 +1158,7 @@ public:
 
 void DbMySQLScriptSync::apply_changes_to_model() {
   grt::AutoUndo undo;
+  grt::ChangeBatch batch;
   NodeId rootnodeid = _diff_tree->get_root();
   DiffNode* rootnode = _diff_tree->get_node_with_id(rootnodeid);
   db_mysql_CatalogRef mod_cat = get_model_catalog();
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#include "db_objects_fetcher.h"
+
+#include <cppconn/driver.h>
+#include <cppconn/metadata.h>
+#include <cppconn/resultset.h>
+
+#include <memory>
+#include <set>
+#include <thread>
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * The object name filter of getSchemaObjects() is a LIKE pattern, so wildcards and the escape character
+ * in an object name must be escaped to match only that object.
+ */
+std::string Db_objects_fetcher::escape_like_pattern(const std::string &name) {
+  std::string result;
+  result.reserve(name.size());
+  for (char c : name) {
+    if (c == '\\' || c == '%' || c == '_')
+      result.push_back('\\');
+    result.push_back(c);
+  }
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+Db_objects_fetcher::Db_objects_fetcher(const std::vector<sql::ConnectionWrapper> &connections)
+  : _connections(connections), _next_task(0), _cancelled(false) {
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Fetches all objects of the given type ("table", "view", "routine", "trigger") from the given schemata.
+ * First all object names are listed (one request per schema), then the DDL of each object is requested
+ * separately, so that even a single large schema is spread over all connections.
+ *
+ * Returns false if the result slot asked to stop.
+ */
+bool Db_objects_fetcher::fetch(const std::vector<std::string> &schemata, const std::string &object_type,
+                               const Result_slot &result_slot) {
+  _object_type = object_type;
+
+  std::vector<Task> listings(schemata.size());
+  for (size_t i = 0; i < schemata.size(); ++i) {
+    listings[i].schema = schemata[i];
+    listings[i].including_ddl = false;
+    listings[i].done = schemata[i].empty();
+  }
+  run(listings, [](Task &) { return true; });
+
+  // Schemata which failed to list or are empty are kept as already finished tasks,
+  // so their result is delivered in the right order along with the others.
+  std::vector<Task> requests;
+  for (Task &listing : listings) {
+    std::set<std::string> names;
+    for (const Object &object : listing.result.objects)
+      names.insert(object.name);
+
+    if (names.empty() || !listing.result.error.empty()) {
+      Task task;
+      task.schema = listing.schema;
+      task.including_ddl = false;
+      task.result.schema = listing.schema;
+      task.result.index = 0;
+      task.result.count = 0;
+      task.result.error = listing.result.error;
+      task.done = true;
+      requests.push_back(task);
+      continue;
+    }
+
+    // Keep server order, but request routines sharing a name (a procedure and a function) only once.
+    size_t index = 0;
+    for (const Object &object : listing.result.objects) {
+      if (names.erase(object.name) == 0)
+        continue;
+
+      Task task;
+      task.schema = listing.schema;
+      task.name = object.name;
+      task.including_ddl = true;
+      task.result.schema = listing.schema;
+      task.result.index = index++;
+      task.done = false;
+      requests.push_back(task);
+    }
+    for (size_t i = requests.size() - index; i < requests.size(); ++i)
+      requests[i].result.count = index;
+  }
+
+  return run(requests, [&](Task &task) { return result_slot(task.result); });
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Executes all tasks not yet marked as done on the worker threads and passes each finished one
+ * to task_done on the calling thread, strictly in task order.
+ */
+bool Db_objects_fetcher::run(std::vector<Task> &tasks, const std::function<bool(Task &)> &task_done) {
+  if (tasks.empty())
+    return true;
+
+  _next_task = 0;
+  _cancelled = false;
+
+  std::vector<std::thread> workers;
+  size_t worker_count = std::min(_connections.size(), tasks.size());
+  for (size_t i = 0; i < worker_count; ++i)
+    workers.push_back(std::thread(&Db_objects_fetcher::work, this, i, std::ref(tasks)));
+
+  bool completed = true;
+  try {
+    for (Task &task : tasks) {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _task_finished.wait(lock, [&task]() { return task.done; });
+      }
+      if (!task_done(task)) {
+        completed = false;
+        break;
+      }
+    }
+  } catch (...) {
+    _cancelled = true;
+    for (std::thread &worker : workers)
+      worker.join();
+    throw;
+  }
+
+  _cancelled = true;
+  for (std::thread &worker : workers)
+    worker.join();
+
+  return completed;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Db_objects_fetcher::work(size_t connection_index, std::vector<Task> &tasks) {
+  sql::Connection *connection = _connections[connection_index].get();
+  sql::Driver *driver = connection->getDriver();
+  driver->threadInit();
+
+  while (!_cancelled) {
+    size_t index = _next_task++;
+    if (index >= tasks.size())
+      break;
+
+    Task &task = tasks[index];
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (task.done)
+        continue;
+    }
+
+    run_task(connection, task);
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      task.done = true;
+    }
+    _task_finished.notify_all();
+  }
+
+  driver->threadEnd();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+void Db_objects_fetcher::run_task(sql::Connection *connection, Task &task) {
+  try {
+    sql::DatabaseMetaData *dbc_meta = connection->getMetaData();
+    std::unique_ptr<sql::ResultSet> rset(
+      dbc_meta->getSchemaObjects("", task.schema, _object_type, task.including_ddl, escape_like_pattern(task.name)));
+    while (rset->next()) {
+      Object object;
+      object.name = rset->getString("name");
+
+      // Names differing only in case can still match the pattern, so check for the exact name here.
+      if (!task.name.empty() && object.name != task.name)
+        continue;
+
+      if (task.including_ddl)
+        object.ddl = rset->getString("ddl");
+      task.result.objects.push_back(object);
+    }
+  } catch (std::exception &e) {
+    task.result.error = e.what();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
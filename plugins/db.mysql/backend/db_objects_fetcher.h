@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+#ifndef _DB_OBJECTS_FETCHER_H_
+#define _DB_OBJECTS_FETCHER_H_
+
+#include "db_mysql_public_interface.h"
+#include "cppdbc.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Fetches object DDL from a live server over several connections at once.
+ *
+ * Object names of every schema are listed first, then the per object SHOW CREATE requests are spread
+ * over all connections, one worker thread per connection. Results are handed to the caller in the
+ * order of the schema list (and in server order within a schema) and always on the calling thread,
+ * so the caller may safely touch GRT objects, report progress or check for cancellation from there.
+ */
+class WBPLUGINDBMYSQLBE_PUBLIC_FUNC Db_objects_fetcher {
+public:
+  struct Object {
+    std::string name;
+    std::string ddl;
+  };
+
+  // The outcome of one fetch step. For a schema that failed to list or has no objects of the requested
+  // type a single result with count == 0 is delivered.
+  struct Result {
+    std::string schema;
+    size_t index; // Position of this object within its schema.
+    size_t count; // Number of objects in the schema.
+    std::vector<Object> objects;
+    std::string error;
+  };
+
+  // Return false to stop fetching. Pending requests are dropped and fetch() returns false.
+  typedef std::function<bool(const Result &)> Result_slot;
+
+  Db_objects_fetcher(const std::vector<sql::ConnectionWrapper> &connections);
+
+  bool fetch(const std::vector<std::string> &schemata, const std::string &object_type, const Result_slot &result_slot);
+
+  static std::string escape_like_pattern(const std::string &name);
+
+private:
+  struct Task {
+    std::string schema;
+    std::string name;
+    bool including_ddl;
+    Result result;
+    bool done;
+  };
+
+  bool run(std::vector<Task> &tasks, const std::function<bool(Task &)> &task_done);
+  void work(size_t connection_index, std::vector<Task> &tasks);
+  void run_task(sql::Connection *connection, Task &task);
+
+  std::vector<sql::ConnectionWrapper> _connections;
+  std::string _object_type;
+
+  std::mutex _mutex;
+  std::condition_variable _task_finished;
+  std::atomic<size_t> _next_task;
+  std::atomic<bool> _cancelled;
+};
+
+#endif /* _DB_OBJECTS_FETCHER_H_ */
@@ -26,6 +26,7 @@
 #include <memory>
 
 #include "db_plugin_be.h"
+#include "db_objects_fetcher.h"
 #include "grtsqlparser/sql_facade.h"
 #include "grt/icon_manager.h"
 #include "grts/structs.db.h"
@@ -166,6 +167,8 @@ void Db_plugin::load_schemata(std::vector<std::string> &schemata) {
   _schemata.clear();
   _schemata_ddl.clear();
 
+  // A new listing may follow a change of the connection settings, so drop connections of an earlier fetch.
+  release_fetch_connections();
   sql::ConnectionWrapper dbc_conn = _db_conn->get_dbc_connection();
   sql::DatabaseMetaData *dbc_meta(dbc_conn->getMetaData());
 
@@ -237,6 +240,43 @@ void Db_plugin::schemata_selection(const std::vector<std::string> &selection, bo
     _schemata_selection = _schemata;
 }
 
+/**
+ * Returns the connections to fetch object DDL with. Connections opened by earlier calls are reused,
+ * closed ones are dropped and the set is topped up to the configured number of connections.
+ * They stay open until release_fetch_connections() is called.
+ */
+std::vector<sql::ConnectionWrapper> &Db_plugin::fetch_connections() {
+  std::vector<sql::ConnectionWrapper> open_connections;
+  for (sql::ConnectionWrapper &connection : _fetch_connections) {
+    if (connection.get() != nullptr && !connection->isClosed())
+      open_connections.push_back(connection);
+  }
+  _fetch_connections.swap(open_connections);
+
+  if (_fetch_connections.empty())
+    _fetch_connections.push_back(_db_conn->get_dbc_connection());
+
+  long connection_count = bec::GRTManager::get()->get_app_option_int("db.mysql.reverseEngineer:FetchConnections", 4);
+  while ((long)_fetch_connections.size() < connection_count) {
+    try {
+      _fetch_connections.push_back(_db_conn->get_dbc_connection());
+    } catch (std::exception &e) {
+      logWarning("Could not open additional connection for fetching objects, using %i: %s\n",
+                 (int)_fetch_connections.size(), e.what());
+      break;
+    }
+  }
+  return _fetch_connections;
+}
+
+/**
+ * Closes the connections opened for fetching objects. Called once all object types are fetched, so the server
+ * connections are not kept for as long as the plugin lives.
+ */
+void Db_plugin::release_fetch_connections() {
+  _fetch_connections.clear();
+}
+
 void Db_plugin::load_db_objects(Db_object_type db_object_type) {
   Db_objects_setup *setup = db_objects_setup_by_type(db_object_type);
   setup->reset();
@@ -247,63 +287,73 @@ void Db_plugin::load_db_objects(Db_object_type db_object_type) {
   grt::GRT::get()->send_progress(
     0.0, std::string("Fetching ").append(db_objects_type_to_string(db_object_type)).append(" list."));
 
-  sql::ConnectionWrapper dbc_conn = _db_conn->get_dbc_connection();
-  sql::DatabaseMetaData *dbc_meta(dbc_conn->getMetaData());
+  // The DDL of the objects is fetched over several connections in parallel. Results are delivered
+  // back here in schema order, so progress reporting and the object lists stay the same as with a single one.
+  std::vector<sql::ConnectionWrapper> &connections = fetch_connections();
+
   std::string db_object_type_name = db_objects_type_to_string(db_object_type);
-  std::list<Db_obj_handle> db_objects;
   std::list<std::string> db_obj_names;
 
   float total_schemas = (float)_schemata_selection.size();
   int current_schema = 0;
+  int count = 0;
+
+  auto add_objects = [&](const Db_objects_fetcher::Result &result) {
+    const std::string &schema_name = result.schema;
+    if (result.index == 0) {
+      count = 0;
+      grt::GRT::get()->send_progress((current_schema / total_schemas),
+                                     std::string("Fetch ")
+                                       .append(db_objects_type_to_string(db_object_type))
+                                       .append(" objects from ")
+                                       .append(schema_name));
+    }
 
-  for (std::vector<std::string>::const_iterator iter = _schemata_selection.begin(); iter != _schemata_selection.end();
-       ++iter) {
-    const std::string &schema_name = *iter;
-    float total_objects;
-    int count = 0;
-
-    grt::GRT::get()->send_progress((current_schema / total_schemas),
-                                   std::string("Fetch ")
-                                     .append(db_objects_type_to_string(db_object_type))
-                                     .append(" objects from ")
-                                     .append(schema_name));
-
-    if (!schema_name.empty()) {
-      try {
-        std::auto_ptr<sql::ResultSet> rset(dbc_meta->getSchemaObjects("", schema_name, db_object_type_name));
-        total_objects = (float)rset->rowsCount();
-        while (rset->next()) {
-          Db_obj_handle db_obj;
-          db_obj.schema = schema_name;
-          db_obj.name = rset->getString("name");
-          db_obj.ddl = rset->getString("ddl");
-          setup->all.push_back(db_obj);
-
-          // prefixed by schema name
-          db_obj_names.push_back(std::string(schema_name).append(".").append(db_obj.name));
-
-          grt::GRT::get()->send_progress((current_schema / total_schemas) + (count / total_objects) / total_schemas,
-                                         db_obj_names.back());
-
-          count++;
-        }
-      } catch (std::exception &e) {
-        std::string msg = base::strfmt("Failed to fetch %s objects from %s: %s",
-                                       db_objects_type_to_string(db_object_type), schema_name.c_str(), e.what());
-        grt::GRT::get()->send_info(msg);
-        logError("Failed to fetch %s objects from %s: %s", db_objects_type_to_string(db_object_type),
-                 schema_name.c_str(), e.what());
-      }
+    if (!result.error.empty()) {
+      std::string msg = base::strfmt("Failed to fetch %s objects from %s: %s",
+                                     db_objects_type_to_string(db_object_type), schema_name.c_str(),
+                                     result.error.c_str());
+      grt::GRT::get()->send_info(msg);
+      logError("Failed to fetch %s objects from %s: %s", db_objects_type_to_string(db_object_type),
+               schema_name.c_str(), result.error.c_str());
     }
 
-    current_schema++;
-    grt::GRT::get()->send_info(base::strfmt("    %i items from %s", count, schema_name.c_str()));
-  }
+    for (const Db_objects_fetcher::Object &object : result.objects) {
+      Db_obj_handle db_obj;
+      db_obj.schema = schema_name;
+      db_obj.name = object.name;
+      db_obj.ddl = object.ddl;
+      setup->all.push_back(db_obj);
+
+      // prefixed by schema name
+      db_obj_names.push_back(std::string(schema_name).append(".").append(db_obj.name));
+
+      grt::GRT::get()->send_progress(
+        (current_schema / total_schemas) + (result.index / (float)result.count) / total_schemas, db_obj_names.back());
+
+      count++;
+    }
+
+    if (result.index + 1 >= result.count) {
+      current_schema++;
+      grt::GRT::get()->send_info(base::strfmt("    %i items from %s", count, schema_name.c_str()));
+    }
+
+    return !grt::GRT::get()->query_status();
+  };
 
-  // copy from temp list (used for performance optimization)
-  setup->all.reserve(db_objects.size());
-  std::copy(db_objects.begin(), db_objects.end(), setup->all.begin());
-  db_objects.clear();
+  Db_objects_fetcher fetcher(connections);
+  bool completed;
+  try {
+    completed = fetcher.fetch(_schemata_selection, db_object_type_name, add_objects);
+  } catch (...) {
+    release_fetch_connections();
+    throw;
+  }
+  if (!completed) {
+    release_fetch_connections();
+    throw grt::user_cancelled("Fetching of database objects cancelled.");
+  }
 
   // initialize db obj selection
   setup->selection.reset(db_obj_names);
@@ -104,6 +104,10 @@ protected:
 
   std::vector<std::string> _schemata_selection;
 
+  // Connections used to fetch object DDL, shared by all object types of one fetch.
+  std::vector<sql::ConnectionWrapper> _fetch_connections;
+  std::vector<sql::ConnectionWrapper> &fetch_connections();
+
 protected:
   Db_objects_setup _tables;
   Db_objects_setup _views;
@@ -167,6 +171,7 @@ public:
   //  void default_schemata_selection(std::vector<std::string> &selection);
   void schemata_selection(const std::vector<std::string> &selection, bool sel_none_means_sel_all);
   void load_db_objects(Db_object_type db_object_type);
+  void release_fetch_connections();
   void db_objects_activated(Db_object_type db_object_type, bool activated) {
     db_objects_setup_by_type(db_object_type)->activated = activated;
   }
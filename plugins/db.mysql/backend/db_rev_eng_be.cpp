@@ -46,6 +46,7 @@ std::string Db_rev_eng::sql_script() {
 void Db_rev_eng::parse_sql_script(parsers::MySQLParserServices::Ref sql_parser, parsers::MySQLParserContext::Ref context,
                                   db_CatalogRef &catalog, const std::string &sql_script, grt::DictRef &options) {
   grt::AutoUndo undo;
+  grt::ChangeBatch batch;
   sql_parser->parseSQLIntoCatalog(context, db_mysql_CatalogRef::cast_from(catalog), sql_script, options);
   undo.end(_("Reverse Engineer Database"));
 }
@@ -84,6 +84,7 @@ void Sql_import::parse_sql_script(parsers::MySQLParserServices::Ref sql_parser,
   db_CatalogRef &catalog, const std::string &sql_script, grt::DictRef &options)
 {
   grt::AutoUndo undo;
+  grt::ChangeBatch batch;
 
   // XXX: we need a way to convert the encoding. Currently we assume it's always utf-8 here.
   //_options.set("sql_script_codeset", grt::StringRef(_sql_script_codeset));
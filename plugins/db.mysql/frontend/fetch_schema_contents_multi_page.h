@@ -55,6 +55,7 @@ public:
     dbplugin->load_db_objects(Db_plugin::dbotView);
     dbplugin->load_db_objects(Db_plugin::dbotRoutine);
     dbplugin->load_db_objects(Db_plugin::dbotTrigger);
+    dbplugin->release_fetch_connections();
 
     _finished++;
 
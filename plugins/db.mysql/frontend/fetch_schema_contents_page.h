@@ -72,6 +72,7 @@ public:
       _dbplugin->load_db_objects(Db_plugin::dbotRoutine);
     if (!values().get_int("SkipTriggers"))
       _dbplugin->load_db_objects(Db_plugin::dbotTrigger);
+    _dbplugin->release_fetch_connections();
 
     return grt::ValueRef();
   }
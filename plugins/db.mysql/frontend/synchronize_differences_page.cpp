@@ -107,6 +107,7 @@ void SynchronizeDifferencesPage::update_original_columns(std::list<db_ColumnRef>
   std::map<std::string, db_SchemaRef> schema_map;
   std::map<std::string, db_TableRef> table_map;
 
+  grt::index_list(_src->schemata());
   for (std::list<db_ColumnRef>::const_iterator col = changed_columns.begin(); col != changed_columns.end(); ++col) {
     db_TableRef table = db_TableRef::cast_from((*col)->owner());
     db_SchemaRef schema = db_SchemaRef::cast_from(table->owner());
@@ -125,6 +126,7 @@ void SynchronizeDifferencesPage::update_original_columns(std::list<db_ColumnRef>
           schema_map[schema.id()] = orig_schema;
       }
       if (orig_schema.is_valid()) {
+        grt::index_list(orig_schema->tables());
         orig_table = grt::find_named_object_in_list(orig_schema->tables(), table->name());
         if (orig_table.is_valid())
           table_map[table.id()] = orig_table;
@@ -136,6 +138,7 @@ void SynchronizeDifferencesPage::update_original_columns(std::list<db_ColumnRef>
       continue;
     }
 
+    grt::index_list(orig_table->columns());
     db_ColumnRef orig_column = grt::find_named_object_in_list(orig_table->columns(), (*col)->name());
     if (orig_column.is_valid())
       orig_column->oldName((*col)->oldName());
@@ -176,12 +179,14 @@ void SynchronizeDifferencesPage::edit_column_mapping() {
 }
 
 void SynchronizeDifferencesPage::update_original_tables(std::list<db_TableRef> &changed_tables) {
+  grt::index_list(_src->schemata());
   for (std::list<db_TableRef>::const_iterator tbl = changed_tables.begin(); tbl != changed_tables.end(); ++tbl) {
     db_SchemaRef orig_schema = grt::find_named_object_in_list(_src->schemata(), (*tbl)->owner()->name());
     if (!orig_schema.is_valid()) {
       logError("Could not find original schema for %s\n", (*tbl)->owner()->name().c_str());
       continue;
     }
+    grt::index_list(orig_schema->tables());
     db_TableRef orig_table = grt::find_named_object_in_list(orig_schema->tables(), (*tbl)->name());
     if (orig_table.is_valid())
       orig_table->oldName((*tbl)->oldName());
@@ -20,6 +20,7 @@
 # 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
 import os
+import re
 import socket
 import threading
 import time
@@ -47,6 +48,9 @@ MYSQL_ERR_ACCESS_DENIED = 1045
 MYSQL_ERR_PASSWORD_EXPIRED = 1820
 MYSQL_ERR_OFFLINE_MODE = 3032
 
+# Seconds between two samples taken by the native status sampler
+STATUS_SAMPLE_INTERVAL = 0.5
+
 #===============================================================================
 #
 #===============================================================================
@@ -212,6 +216,7 @@ class WbAdminControl(object):
         self.status_variables = {} # 1st time is updated by us and then in a fixed interval by the monitoring thread
         self.status_variables_time = None
         self.status_variable_poll_interval = 3
+        self.status_sampler = None # id of the native status sampler, if it could be started
 
         # Sets the default logging callback
         self.log_cb = self.raw_log
@@ -551,8 +556,55 @@ uses_ssh: %i uses_wmi: %i\n""" % (self.server_profile.uses_ssh, self.server_prof
         return self.sql and self.sql.is_connected()
 
 
+    #---------------------------------------------------------------------------
+    def open_status_sampler(self, password):
+        # The sampler keeps a downsampled history of the status per server, which survives closing the tab
+        host_id = re.sub(r'[^\w.-]', '_', self.server_profile.db_connection_params.hostIdentifier)
+        options = {"interval": STATUS_SAMPLE_INTERVAL,
+                   "performanceSchema": 1,
+                   "historyFile": os.path.join(mforms.App.get().get_user_data_folder(), "status-history", host_id + ".dat")}
+        try:
+            sampler = grt.modules.DbMySQLQuery.openStatusSampler(self.server_profile.db_connection_params, password, options)
+        except Exception, e:
+            log_warning("Could not start the status sampler: %s\n" % e)
+            return None
+        if sampler < 0:
+            log_warning("Could not start the status sampler: %s\n" % grt.modules.DbMySQLQuery.lastError())
+            return None
+        return sampler
+
+    #---------------------------------------------------------------------------
+    def get_status_variables(self):
+        """Returns the latest status variables and the time they were sampled. With the native sampler
+        running these are at most STATUS_SAMPLE_INTERVAL old, otherwise they are updated by the polling thread."""
+        if self.status_sampler is not None:
+            status = grt.modules.DbMySQLQuery.statusSamplerLatest(self.status_sampler)
+            if status["time"]:
+                return dict(status["variables"]), status["time"]
+        return self.status_variables, self.status_variables_time
+
+    #---------------------------------------------------------------------------
+    def status_sampler_polling(self):
+        log_debug("Status sampler running...\n")
+        try:
+            while self.running:
+                time.sleep(self.status_variable_poll_interval)
+                variables, timestamp = self.get_status_variables()
+                if timestamp:
+                    self.status_variables, self.status_variables_time = variables, timestamp
+        finally:
+            sampler, self.status_sampler = self.status_sampler, None
+            grt.modules.DbMySQLQuery.closeStatusSampler(sampler)
+        log_debug("Status sampler done.\n")
+
     #---------------------------------------------------------------------------
     def server_polling_thread(self):
+        # Sampling is done natively if possible, the SHOW GLOBAL STATUS loop below is the fallback
+        self.status_sampler = self.open_status_sampler(self.get_mysql_password())
+        if self.status_sampler is not None:
+            self.status_sampler_polling()
+            return None
+
         try:
             password = self.get_mysql_password()
             self.poll_connection = MySQLConnection(self.server_profile.db_connection_params, password=password)
@@ -76,6 +76,10 @@ Methods:
                        of the current records in the existent log set (if
                        available). E.g. 'Records 1..50 of 145'
 
+    seek_time(t):      Returns the records starting at the first one logged at
+                       or after t (seconds since the epoch). Only available for
+                       log files when `has_time_index` is True.
+
 
     refresh():         After calling this function the log reader should be able
                        to manage new log entries that were added since the last
@@ -93,10 +97,13 @@ Current limitations:
 
 * Cannot read files that aren't readable by the user running Workbench.
 
+* Files read through sudo are not indexed, so they can't be browsed by time.
+
 """
 
 import re
 
+import grt
 from workbench.log import log_info, log_error, log_warning
 
 from wb_server_management import SudoTailInputFile, LocalInputFile, SFTPInputFile
@@ -256,6 +263,9 @@ class SlowQueryLogReader(BaseQueryLogReader):
 
 #========================= File Based Readers =================================
 
+# Seconds between checks for new records in an indexed log file
+LOG_INDEX_TAIL_INTERVAL = 5
+
 class EventLogInput(object):
     def __init__(self, ctrl_be, path):
         self.ctrl_be = ctrl_be
@@ -287,6 +297,8 @@ class BaseLogFileReader(object):
 
         **This is not intended for direct instantiation.**
         '''
+    log_kind = None  # the log type for the native log index: 'error', 'general' or 'slow'
+
     def __init__(self, ctrl_be, log_file_param, pat, chunk_size, truncate_long_lines, append_gaps=True):
         """Constructor
 
@@ -397,6 +409,39 @@ class BaseLogFileReader(object):
 
         self.record_count = 0
 
+        # Plain and sftp accessible files get a record index, built and kept up to date in the background
+        self.log_index = None
+        if not use_sudo and not use_event_viewer and self.log_kind:
+            self._open_log_index(use_sftp)
+
+    def _open_log_index(self, use_sftp):
+        try:
+            if use_sftp:
+                ssh = self.ctrl_be.editor.sshConnection
+                server = self.ctrl_be.server_profile.ssh_hostname
+            else:
+                ssh = None
+                server = ""
+            index = grt.modules.Workbench.openLogIndex(self.log_file_name, self.log_kind, ssh, server, LOG_INDEX_TAIL_INTERVAL)
+            if index >= 0:
+                self.log_index = index
+        except Exception, error:
+            log_warning("Could not index log file %s: %s\n" % (self.log_file_name, error))
+
+    def close(self):
+        if self.log_index is not None:
+            grt.modules.Workbench.closeLogIndex(self.log_index)
+            self.log_index = None
+
+    def __del__(self):
+        try:
+            self.close()
+        except Exception:
+            pass
+
+    @property
+    def has_time_index(self):
+        return self.log_index is not None
 
 
     def has_previous(self):
@@ -412,6 +457,14 @@ class BaseLogFileReader(object):
         return self.chunk_end != self.file_size
 
     def range_text(self):
+        if self.log_index is not None:
+            info = grt.modules.Workbench.logIndexInfo(self.log_index)
+            if self.chunk_start <= info['indexedSize']:
+                first = grt.modules.Workbench.logIndexFindOffset(self.log_index, self.chunk_start)['record']
+                text = 'Records %s..%s of %s' % (first + 1, first + self.record_count, info['recordCount'])
+                if not info['ready']:
+                    text += ' (indexing, %i%% done)' % (info['progress'] * 100)
+                return text
         return '%s records starting at byte offset %s' % (self.record_count, self.chunk_start)
 
     def size_text(self):
@@ -540,6 +593,16 @@ class BaseLogFileReader(object):
         self.chunk_end = self.file_size
         return self.current()
 
+    def seek_time(self, timestamp):
+        '''
+            Returns a list with the records in the chunk that starts with the first
+            record logged at or after the given time (seconds since the epoch).
+            '''
+        position = grt.modules.Workbench.logIndexFindTime(self.log_index, timestamp)
+        self.chunk_start = position['offset']
+        self.chunk_end = min(self.chunk_start + self.chunk_size, self.file_size)
+        return self.current()
+
     def refresh(self):
         '''
             Checks if the log file has been updated since it was opened and if so
@@ -562,6 +625,8 @@ class ErrorLogFileReader(BaseLogFileReader):
     This class enables the retrieval of log entries in a MySQL error
     log file.
     '''
+    log_kind = 'error'
+
     def __init__(self, ctrl_be, file_name, chunk_size=64 * 1024, truncate_long_lines=True):
         # The error log is a mess, there are several different formats for each entry and a new one comes up every version
         mysql_56 = r'^(?P<v56>(\d{2,4}-\d{1,2}-\d{2} {1,2}\d{1,2}:\d{2}:\d{2}) (\d+) \[(.*)\] (.*?))$'
@@ -628,6 +693,8 @@ class GeneralLogFileReader(BaseLogFileReader):
     This class enables the retrieval of log entries in a MySQL general query
     log file.
     '''
+    log_kind = 'general'
+
     def __init__(self, ctrl_be, file_name, chunk_size=64 * 1024, truncate_long_lines=True):
         pat = re.compile(r'^(?P<v57>(\d{2,4}-\d{1,2}-\d{2}T{1,2}\d{1,2}:\d{2}:\d{2}.\d+Z)[\t ]*(\d+)\s*(.*?)(?:\t+| {2,})(.*?))$|^(?P<v56>(\d{6} {1,2}\d{1,2}:\d{2}:\d{2}[\t ]+|[\t ]+)(\s*\d+)(\s*.*?)(?:\t+| {2,})(.*?))$', re.M)
 
@@ -656,6 +723,8 @@ class SlowLogFileReader(BaseLogFileReader):
     This class enables the retrieval of log entries in a MySQL slow query
     log file.
     '''
+    log_kind = 'slow'
+
     def __init__(self, ctrl_be, file_name, chunk_size=64 * 1024, truncate_long_lines=True, append_gaps=False):
         mysql_57 = r'(?:^|\n)(?P<v57># Time: (\d{2,4}-\d{1,2}-\d{2}T{1,2}\d{1,2}:\d{2}:\d{2}.\d+Z).*?\n# User@Host: (.*?)\n# Query_time: +([0-9.]+) +Lock_time: +([\d.]+) +Rows_sent: +(\d+) +Rows_examined: +(\d+)\s*\n(.*?)(?=\n# |\n[^\n]+, Version: |$))'
         mysql_56 = r'(?:^|\n)(?P<v56># Time: (\d{6} {1,2}\d{1,2}:\d{2}:\d{2}).*?\n# User@Host: (.*?)\n# Query_time: +([0-9.]+) +Lock_time: +([\d.]+) +Rows_sent: +(\d+) +Rows_examined: +(\d+)\s*\n(.*?)(?=\n# |\n[^\n]+, Version: |$))'
@@ -131,11 +131,13 @@ class DBStatusDataSource(DataSource):
 
     def poll(self):
         #log_debug3('%s:%s.poll()' % (_this_file, self.__class__.__name__), 'DBStatusDataSource poll.\n')
-        if self.ctrl_be.status_variables:
+        # Comes straight from the native status sampler if it's running
+        status_variables, timestamp = self.ctrl_be.get_status_variables()
+        if status_variables:
             # update monitor stuff
             for name in self.rev_sources:
                 rev_src = self.rev_sources[name]
-                value = float(self.ctrl_be.status_variables[name])
+                value = float(status_variables[name])
                 # rev_src contains list of sources and index of current variable in the sources
                 for (src, i) in rev_src:
                     src.set_var(i, value)
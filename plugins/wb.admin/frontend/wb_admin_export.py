@@ -26,6 +26,7 @@ import subprocess
 import threading
 import thread
 import time
+import json
 import tempfile
 import platform
 import StringIO
@@ -54,6 +55,9 @@ import mforms
 
 from wb_admin_utils import weakcb, WbAdminTabBase, WbAdminValidationConnection
 
+# Number of server connections used by the parallel dump engine
+PARALLEL_DUMP_CONNECTIONS = 4
+
 
 def local_quote_shell_token(s):
     if sys.platform.lower() == "win32":
@@ -350,6 +354,142 @@ class DumpThread(threading.Thread):
         self.done = True
 
 
+class NativeDumpThread(threading.Thread):
+    """Runs the parallel dump engine of the DbMySQLQuery module and mirrors its state in the same
+    attributes DumpThread has, so that the export tab can poll both the same way."""
+    def __init__(self, connection_params, pwd, objects, options, owner, log_queue):
+        self.owner = owner
+        self.connection_params = connection_params
+        self.pwd = pwd
+        self.objects = objects
+        self.options = options
+        self.logging_lock, self.log = log_queue
+        self.is_import = False
+        self.done = False
+        self.progress = 0
+        self.status_text = "Starting"
+        self.error_count = 0
+        self.dump_id = None
+        self.abort_requested = False
+        self.e = None
+        threading.Thread.__init__(self)
+
+    def kill(self):
+        self.abort_requested = True
+        if self.dump_id is not None:
+            grt.modules.DbMySQLQuery.cancelParallelDump(self.dump_id)
+
+    def print_log_message(self,message):
+        if message:
+            self.logging_lock.acquire()
+            self.log.append(message)
+            self.logging_lock.release()
+
+    def run(self):
+        try:
+            dump_id = grt.modules.DbMySQLQuery.openParallelDump(self.connection_params, self.pwd, self.objects, self.options)
+            if dump_id < 0:
+                if grt.modules.DbMySQLQuery.lastErrorCode() == 1045:
+                    self.e = wb_common.InvalidPasswordError('Wrong username/password!')
+                self.print_log_message("Error starting dump: %s" % grt.modules.DbMySQLQuery.lastError())
+                self.error_count += 1
+            else:
+                self.dump_id = dump_id
+                if self.abort_requested:
+                    grt.modules.DbMySQLQuery.cancelParallelDump(dump_id)
+                while True:
+                    status = grt.modules.DbMySQLQuery.parallelDumpStatus(dump_id)
+                    for message in status["log"]:
+                        self.print_log_message(time.strftime(u'%X ') + message)
+                    self.progress = status["progress"]
+                    self.status_text = status["status"]
+                    self.error_count = status["errors"]
+                    if status["done"]:
+                        break
+                    time.sleep(0.3)
+                self.error_count = grt.modules.DbMySQLQuery.closeParallelDump(dump_id)
+        except Exception, exc:
+            import traceback
+            traceback.print_exc()
+            self.print_log_message(u"Error executing task %s" % exc )
+            self.error_count += 1
+        if not self.abort_requested:
+            self.progress = 1
+        self.done = True
+
+
+class NativeRestoreThread(NativeDumpThread):
+    """Runs the parallel restore engine of the DbMySQLQuery module. Either restores the objects
+    selected from a dump manifest or the given (schema, table, path) scripts of a Dump Project Folder."""
+    WORKER_LOG_INTERVAL = 10
+
+    def __init__(self, connection_params, pwd, manifest_folder, objects, scripts, options, owner, log_queue):
+        NativeDumpThread.__init__(self, connection_params, pwd, objects, options, owner, log_queue)
+        self.manifest_folder = manifest_folder
+        self.scripts = scripts
+        self.is_import = True
+
+    def kill(self):
+        self.abort_requested = True
+        if self.dump_id is not None:
+            grt.modules.DbMySQLQuery.cancelParallelRestore(self.dump_id)
+
+    def log_worker_status(self, workers):
+        for i, worker in enumerate(workers):
+            message = "Connection %i: %i rows, %.0f rows/s" % (i + 1, worker["rows"], worker["rowsPerSecond"])
+            if worker["task"]:
+                message += " - %s" % worker["task"]
+            self.print_log_message(time.strftime(u'%X ') + message)
+
+    def run(self):
+        restore_id = None
+        try:
+            restore_id = grt.modules.DbMySQLQuery.openParallelRestore(self.connection_params, self.pwd, self.options)
+            if restore_id < 0:
+                if grt.modules.DbMySQLQuery.lastErrorCode() == 1045:
+                    self.e = wb_common.InvalidPasswordError('Wrong username/password!')
+                self.print_log_message("Error starting restore: %s" % grt.modules.DbMySQLQuery.lastError())
+                self.error_count += 1
+                restore_id = None
+            else:
+                if self.manifest_folder:
+                    if grt.modules.DbMySQLQuery.parallelRestoreAddManifest(restore_id, self.manifest_folder, self.objects) < 0:
+                        raise Exception(grt.modules.DbMySQLQuery.lastError())
+                for schema, table, path in self.scripts:
+                    grt.modules.DbMySQLQuery.parallelRestoreAddScript(restore_id, schema, table, path)
+
+                grt.modules.DbMySQLQuery.startParallelRestore(restore_id)
+                self.dump_id = restore_id
+                if self.abort_requested:
+                    grt.modules.DbMySQLQuery.cancelParallelRestore(restore_id)
+                last_report = time.time()
+                while True:
+                    status = grt.modules.DbMySQLQuery.parallelRestoreStatus(restore_id)
+                    for message in status["log"]:
+                        self.print_log_message(time.strftime(u'%X ') + message)
+                    self.progress = status["progress"]
+                    self.status_text = status["status"]
+                    self.error_count = status["errors"]
+                    if status["done"]:
+                        self.log_worker_status(status["workers"])
+                        break
+                    if time.time() - last_report >= self.WORKER_LOG_INTERVAL:
+                        self.log_worker_status(status["workers"])
+                        last_report = time.time()
+                    time.sleep(0.3)
+        except Exception, exc:
+            import traceback
+            traceback.print_exc()
+            self.print_log_message(u"Error executing task %s" % exc )
+            self.error_count += 1
+        if restore_id is not None:
+            errors = grt.modules.DbMySQLQuery.closeParallelRestore(restore_id)
+            self.error_count = max(self.error_count, errors)
+        if not self.abort_requested:
+            self.progress = 1
+        self.done = True
+
+
 class TableListModel(object):
     def __init__(self):
         self.tables_by_schema = {}
@@ -521,6 +661,9 @@ class WbAdminSchemaListTab(mforms.Box):
             #self.dump_view_check = None
             self.dump_routines_check = None
             self.dump_events_check = None
+            self.parallel_dump_check = None
+            self.parallel_restore_check = newCheckBox()
+            self.defer_indexes_check = newCheckBox()
         else:
             self.filelabel = newLabel("All selected database objects will be exported into a single, self-contained file.")
             self.folderlabel = newLabel("Each table will be exported into a separate file. This allows a selective restore, but may be slower.")
@@ -532,6 +675,7 @@ class WbAdminSchemaListTab(mforms.Box):
             #self.dump_view_check = newCheckBox()
             self.dump_routines_check = newCheckBox()
             self.dump_events_check = newCheckBox()
+            self.parallel_dump_check = newCheckBox()
 
         self.filelabel.set_enabled(False)
         self.filelabel.set_style(mforms.SmallStyle)
@@ -580,6 +724,12 @@ class WbAdminSchemaListTab(mforms.Box):
             tbox.add(self.folder_load_btn, False, True)
             optionsbox.add(tbox, False, True)
 
+            restore_options = newBox(True)
+            restore_options.set_spacing(12)
+            restore_options.add(self.parallel_restore_check, False, True)
+            restore_options.add(self.defer_indexes_check, False, True)
+            optionsbox.add(restore_options, False, True)
+
         optionsbox.add(file_path, False, True)
         optionsbox.add(self.filelabel, False, True)
 
@@ -596,7 +746,7 @@ class WbAdminSchemaListTab(mforms.Box):
             export_options = mforms.newTable()
             export_options.set_homogeneous(True)
             export_options.set_padding(4)
-            export_options.set_row_count(1)
+            export_options.set_row_count(2 if self.parallel_dump_check else 1)
             export_options.set_column_count(2)
             export_options.set_row_spacing(2)
             export_options.set_column_spacing(2)
@@ -606,6 +756,8 @@ class WbAdminSchemaListTab(mforms.Box):
             export_options.add(self.single_transaction_check,0,1,0,1)
         if self.include_schema_check:
             export_options.add(self.include_schema_check,1,2,0,1)
+        if self.parallel_dump_check:
+            export_options.add(self.parallel_dump_check,0,2,1,2)
             
         if self.dump_routines_check:
             export_objects_opts.add(self.dump_routines_check,0,1,0,1)
@@ -713,6 +865,8 @@ class WbAdminSchemaListTab(mforms.Box):
         if is_importing:
             self.file_btn.add_clicked_callback(lambda: self.open_file_chooser(mforms.OpenFile))
             self.folderradio.set_text("Import from Dump Project Folder")
+            self.parallel_restore_check.set_text("Use Parallel Restore Engine (always used for Parallel Dump folders)")
+            self.defer_indexes_check.set_text("Create Secondary Indexes After Loading Data")
             self.export_button.set_text("Start Import")
         else:
             self.file_btn.add_clicked_callback(lambda: self.open_file_chooser(mforms.SaveFile))
@@ -720,6 +874,7 @@ class WbAdminSchemaListTab(mforms.Box):
             self.single_transaction_check.set_enabled(False)
             self.single_transaction_check.add_clicked_callback(self.single_transaction_clicked)
             self.include_schema_check.set_text("Include Create Schema")
+            self.parallel_dump_check.set_text("Use Parallel Dump Engine with Compressed Chunks (project folder only, no mysqldump needed)")
             self.dump_triggers_check.set_text("Dump Triggers")
             #self.dump_view_check.set_text("Dump Views")
             self.dump_routines_check.set_text("Dump Stored Procedures and Functions")
@@ -852,6 +1007,8 @@ class WbAdminSchemaListTab(mforms.Box):
                 self.progress_tab.set_start_enabled(True)
                 self.import_target_schema_panel.set_enabled(True)
                 self.refresh_schema_list()
+            self.parallel_restore_check.set_enabled(folder_selected)
+            self.defer_indexes_check.set_enabled(folder_selected)
             self.schema_list.set_enabled(folder_selected)
             self.table_list.set_enabled(folder_selected)
         else:
@@ -860,6 +1017,7 @@ class WbAdminSchemaListTab(mforms.Box):
                 self.single_transaction_check.set_enabled(False)
             else:
                 self.single_transaction_check.set_enabled(True)
+            self.parallel_dump_check.set_enabled(folder_selected)
 
 
     def refresh(self):
@@ -959,6 +1117,7 @@ class WbAdminImportTab(WbAdminSchemaListTab):
         self.export_button.set_text("Start Import")
         self.tables_paths = {}
         self.views_paths = {}
+        self.manifest_folder = None
         self._update_schema_list_tm = None
         self._update_progress_tm = None
         
@@ -1088,6 +1247,7 @@ class WbAdminImportTab(WbAdminSchemaListTab):
         self.tables_paths = {}
         self.views_paths = {}
         self.needs_default_schema = {}
+        self.manifest_folder = None
         self.schema_list.freeze_refresh()
         self.schema_list.clear()
         try:
@@ -1095,7 +1255,16 @@ class WbAdminImportTab(WbAdminSchemaListTab):
             if save_to_folder:
                 self.progress_tab.set_start_enabled(False)
                 path = self.folder_te.get_string_value()
-                dirList=os.listdir(path)
+                manifest_path = os.path.join(path, "manifest.json")
+                if os.path.isfile(manifest_path):
+                    # a folder written by the parallel dump engine, which lists its contents in a manifest
+                    with open(manifest_path) as f:
+                        manifest = json.load(f)
+                    for schema in manifest["schemas"]:
+                        tables = sorted(table["name"] for table in schema["tables"])
+                        tables_by_schema[schema["name"]] = (tables, set(tables))
+                    self.manifest_folder = path
+                dirList = [] if self.manifest_folder else os.listdir(path)
                 for fname in dirList:
                     fullname = os.path.join(path, fname)
                     if os.path.isfile(fullname) and os.path.splitext(fullname)[1] == ".sql":
@@ -1184,6 +1353,11 @@ class WbAdminImportTab(WbAdminSchemaListTab):
         self.progress_tab.did_start()
         self.progress_tab.set_status("Import is running...")
 
+        if not self.fileradio.get_active() and (self.manifest_folder or self.parallel_restore_check.get_active()):
+            self.path = self.folder_te.get_string_value()
+            self.start_parallel_restore()
+            return
+
         connection_params = self.server_profile.db_connection_params
         tunnel = ConnectionTunnel(connection_params)
 
@@ -1300,6 +1474,36 @@ class WbAdminImportTab(WbAdminSchemaListTab):
         self.dump_thread.start()
         self._update_progress_tm = Utilities.add_timeout(float(0.4), self._update_progress)
 
+    def start_parallel_restore(self):
+        selection = self.table_list_model.get_full_selection()
+        if not selection:
+            self.failed("No objects selected for import")
+            return
+
+        password = self.get_mysql_password(self.bad_password_detected)
+        if password is None:
+            self.cancelled("Password Input Cancelled")
+            return
+
+        objects = {}
+        scripts = []
+        for schema, table in selection:
+            if self.manifest_folder:
+                objects.setdefault(schema, []).append(table)
+            elif (schema, table) in self.tables_paths:
+                scripts.append((schema, table, self.tables_paths[(schema, table)]))
+            elif (schema, table) in self.views_paths:
+                # views, routines and events are run by the engine once all tables are restored
+                scripts.append((schema, "", self.views_paths[(schema, table)]))
+        options = {
+            "connections": PARALLEL_DUMP_CONNECTIONS,
+            "deferIndexes": int(self.defer_indexes_check.get_active())
+        }
+
+        self.dump_thread = NativeRestoreThread(self.server_profile.db_connection_params, password, self.manifest_folder, objects, scripts, options, self, (self.progress_tab.logging_lock, self.progress_tab.log_queue))
+        self.dump_thread.start()
+        self._update_progress_tm = Utilities.add_timeout(float(0.4), self._update_progress)
+
     def _update_progress(self):
         r = self.update_progress()
         if not r:
@@ -1677,7 +1881,8 @@ class WbAdminExportTab(WbAdminSchemaListTab):
         
         self.progress_tab.set_start_enabled(False)
 
-        if not self.check_mysqldump_version(True):
+        use_parallel_dump = save_to_folder and self.parallel_dump_check.get_active()
+        if not use_parallel_dump and not self.check_mysqldump_version(True):
             self.progress_tab.set_start_enabled(True)
             return
 
@@ -1718,6 +1923,10 @@ class WbAdminExportTab(WbAdminSchemaListTab):
             self.progress_tab.set_start_enabled(True)
             return
 
+        if use_parallel_dump:
+            self.start_parallel_dump(schemas_to_dump, skip_data, skip_table_structure, dump_routines, dump_events, dump_triggers)
+            return
+
         # assemble list of operations/command calls to be performed
         operations = []
         if save_to_folder:
@@ -1905,6 +2114,30 @@ class WbAdminExportTab(WbAdminSchemaListTab):
         self.dump_thread.start()
         self._update_progress_tm = Utilities.add_timeout(float(0.4), self._update_progress)
 
+    def start_parallel_dump(self, schemas_to_dump, skip_data, skip_table_structure, dump_routines, dump_events, dump_triggers):
+        password = self.get_mysql_password(self.bad_password_detected)
+        if password is None:
+            self.cancelled("Password Input Cancelled")
+            return
+
+        objects = dict((schema, list(tables)) for schema, tables in schemas_to_dump)
+        options = {
+            "outputDirectory": self.path,
+            "connections": PARALLEL_DUMP_CONNECTIONS,
+            "dumpStructure": int(not skip_table_structure),
+            "dumpData": int(not skip_data),
+            "dumpTriggers": int(dump_triggers),
+            "dumpRoutines": int(dump_routines),
+            "dumpEvents": int(dump_events)
+        }
+
+        self.progress_tab.did_start()
+        self.progress_tab.set_status("Export is running...")
+
+        self.dump_thread = NativeDumpThread(self.server_profile.db_connection_params, password, objects, options, self, (self.progress_tab.logging_lock, self.progress_tab.log_queue))
+        self.dump_thread.start()
+        self._update_progress_tm = Utilities.add_timeout(float(0.4), self._update_progress)
+
     def _update_progress(self):
         r = self.update_progress()
         if not r:
@@ -2337,6 +2570,7 @@ class WbAdminExport(WbAdminTabBase):
             dic["wb.admin.export:dumpRoutines"] = self.export_tab.dump_routines_check.get_active()
             dic["wb.admin.export:dumpEvents"] = self.export_tab.dump_events_check.get_active()
             dic["wb.admin.export:dumpTriggers"] = self.export_tab.dump_triggers_check.get_active()
+            dic["wb.admin.export:parallelDump"] = self.export_tab.parallel_dump_check.get_active()
             dic["wb.admin.export:skipData"] = self.export_tab.dump_type_selector.get_selected_index()
             for key, value in self.get_export_options({}).items():
                 dic["wb.admin.export.option:"+key] = value
@@ -2361,6 +2595,8 @@ class WbAdminExport(WbAdminTabBase):
             self.export_tab.dump_events_check.set_active(dic["wb.admin.export:dumpEvents"] != 0)
         if dic.has_key("wb.admin.export:dumpTriggers"):
             self.export_tab.dump_triggers_check.set_active(dic["wb.admin.export:dumpTriggers"] != 0)
+        if dic.has_key("wb.admin.export:parallelDump"):
+            self.export_tab.parallel_dump_check.set_active(dic["wb.admin.export:parallelDump"] != 0)
         if dic.has_key("wb.admin.export:skipData"):
             self.export_tab.dump_type_selector.set_selected(dic["wb.admin.export:skipData"] != 0)
         values = {}
@@ -172,6 +172,7 @@ Use cases for the server logs
 """
 
 import grt
+import time
 from mforms import newBox, newLabel, newTreeView, newTabView, newButton
 import mforms
 from wb_log_reader import GeneralQueryLogReader, SlowQueryLogReader, GeneralLogFileReader, SlowLogFileReader, ErrorLogFileReader
@@ -263,6 +264,8 @@ class LogView(mforms.Box):
                 self.remove(filter_box)
             self.add(filter_box, False, True)
         
+        if self.log_reader and hasattr(self.log_reader, 'close'):
+            self.log_reader.close()
         try:
             self.log_reader = self.BackendLogReaderClass(*self.args)
         except Exception, error:
@@ -333,6 +336,12 @@ class LogView(mforms.Box):
 
         self.bbox.add(newLabel(""), True, True)
 
+        if getattr(self.log_reader, 'has_time_index', False):
+            self.time_button = newButton()
+            self.time_button.set_text("Go to Time...")
+            self.bbox.add(self.time_button, False, True)
+            self.time_button.add_clicked_callback(self.go_time)
+
         self.bof_button = newButton()
         self.bof_button.set_text("Oldest")
         self.bbox.add(self.bof_button, False, True)
@@ -446,6 +455,21 @@ class LogView(mforms.Box):
         except (ServerIOError, RuntimeError, LogFileAccessError, OperationCancelledError, InvalidPasswordError, IOError, ValueError), error:
             self._show_error(error)
 
+    def go_time(self):
+        ret, text = mforms.Utilities.request_input("Go to Time", "Show the log records starting at (YYYY-MM-DD HH:MM:SS):",
+                                                   time.strftime("%Y-%m-%d %H:%M:%S"))
+        if not ret:
+            return
+        try:
+            timestamp = time.mktime(time.strptime(text.strip(), "%Y-%m-%d %H:%M:%S"))
+        except ValueError:
+            mforms.Utilities.show_error("Go to Time", "'%s' is not a valid time. Use the format YYYY-MM-DD HH:MM:SS." % text, "OK", "", "")
+            return
+        try:
+            self.refresh(self.log_reader.seek_time(timestamp))
+        except (ServerIOError, RuntimeError, LogFileAccessError, OperationCancelledError, InvalidPasswordError, IOError, ValueError), error:
+            self._show_error(error)
+
     def go_eof(self):
         try:
             self.refresh(self.log_reader.last())
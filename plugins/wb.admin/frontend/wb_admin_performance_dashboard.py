@@ -763,7 +763,7 @@ class WbAdminDashboard(WbAdminTabBase):
 
 
     def refresh(self):
-        status_variables, timestamp = self.ctrl_be.status_variables, self.ctrl_be.status_variables_time
+        status_variables, timestamp = self.ctrl_be.get_status_variables()
         if self.last_refresh_time != timestamp:
             for w in self.widgets:
                 if hasattr(w, 'process'):
@@ -30,13 +30,40 @@
 
 #include "grt.h"
 #include "grtpp_helper.h"
+#include "grtpp_metaclass_cache.h"
+
+//--------------------------------------------------------------------------------------------------
+
+static int write_struct_cache(const std::string &structs_dir, const std::string &cache_file) {
+  std::multimap<std::string, std::string> requires;
+
+  g_print("Reading structs from '%s', writing struct cache to '%s'\n", structs_dir.c_str(), cache_file.c_str());
+
+  // The cache must be created from the XML files, never from an older cache.
+  grt::GRT::get()->use_metaclass_cache(false);
+  try {
+    grt::GRT::get()->scan_metaclasses_in(structs_dir, &requires);
+    grt::GRT::get()->end_loading_metaclasses(false);
+
+    grt::MetaClassCache::write(cache_file, structs_dir, requires);
+  } catch (std::exception &exc) {
+    g_printerr("Could not write struct cache: %s\n", exc.what());
+    return 1;
+  }
+
+  return 0;
+}
 
 //--------------------------------------------------------------------------------------------------
 
 int main(int argc, char **argv) {
+  if (argc == 4 && std::string(argv[1]) == "--cache")
+    return write_struct_cache(argv[2], argv[3]);
+
   if (argc < 5) {
     g_print("\nNot enough parameters given. Syntax:\n");
     g_print("  genobj <structs-file> <structs-dir> <output-dir> <impl-output-dir>\n");
+    g_print("  genobj --cache <structs-dir> <cache-file>\n");
     return -1;
   }
 
@@ -0,0 +1,673 @@
+/*
+ * Copyright (c) 2018, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2.0,
+ * as published by the Free Software Foundation.
+ *
+ * This program is also distributed with certain software (including
+ * but not limited to OpenSSL) that is licensed under separate terms, as
+ * designated in a particular file or component or in included license
+ * documentation.  The authors of MySQL hereby grant you an additional
+ * permission to link the program and your derivative works with the
+ * separately licensed software that they have included with MySQL.
+ * This program is distributed in the hope that it will be useful,  but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See
+ * the GNU General Public License, version 2.0, for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA 
+ */
+
+/**
+ * wbbatch - headless processing of model files.
+ *
+ * Loads .mwb files without any UI and writes a forward engineering script, a synchronization script against
+ * a reference model and/or an image of each diagram. Several models can be processed in parallel, in which case
+ * the models are split into groups and each group is handled by a separate worker process (this program again,
+ * started with --worker), since the GRT and the model objects are not meant to be shared between threads.
+ */
+
+#ifdef _MSC_VER
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif // _MSC_VER
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "base/data_types.h"
+#include "base/file_utilities.h"
+#include "base/log.h"
+#include "base/string_utilities.h"
+
+#include "grt.h"
+#include "grts/structs.workbench.h"
+#include "grts/structs.workbench.physical.h"
+#include "grt/grt_manager.h"
+#include "grt/icon_manager.h"
+
+#include "interfaces/interfaces.h"
+#include "wbcanvas/model_diagram_impl.h"
+#include "wbcanvas/workbench_physical_model_impl.h"
+#include "workbench/wb_model_file.h"
+
+#include "mdc_canvas_view_image.h"
+#include "mdc_image_manager.h"
+
+DEFAULT_LOG_DOMAIN("wbbatch")
+
+// Install locations, set by the build. MWB_DATA_DIR and MWB_MODULE_DIR (as exported by the launcher script)
+// or the command line take precedence.
+#ifndef WBBATCH_DATA_DIR
+#define WBBATCH_DATA_DIR "."
+#endif
+#ifndef WBBATCH_MODULE_DIR
+#define WBBATCH_MODULE_DIR "modules"
+#endif
+
+extern void register_all_metaclasses();
+
+static const char *batch_modules[] = {"db.mysql.grt", "db.mysql.sqlparser.grt", "db.mysql.parser.grt", NULL};
+
+static const char *default_sql_mode =
+  "ONLY_FULL_GROUP_BY,STRICT_TRANS_TABLES,NO_ZERO_IN_DATE,NO_ZERO_DATE,ERROR_FOR_DIVISION_BY_ZERO,"
+  "NO_ENGINE_SUBSTITUTION";
+
+struct BatchOptions {
+  std::string data_dir;
+  std::string module_dir;
+  std::string output_dir;
+  std::string source_root; // Common parent folder of all models, ending with a separator.
+  std::string sync_with;
+  std::string sql_mode;
+
+  bool sql = false;
+  bool png = false;
+  bool pdf = false;
+  bool drops = false;
+  bool inserts = false;
+  bool omit_schemas = false;
+  bool verbose = false;
+  bool worker = false;
+  int jobs = 0;
+
+  std::vector<std::string> models;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Canvas delegate for diagrams rendered without a frontend. Each diagram gets an offscreen image view and
+ * images placed on diagrams are taken from the model file being processed.
+ */
+class BatchCanvasDelegate : public ModelBridgeDelegate {
+public:
+  BatchCanvasDelegate(wb::ModelFile *file) : _file(file) {
+  }
+
+  virtual mdc::CanvasView *create_diagram(const model_DiagramRef &diagram) {
+    // The view surface only serves as viewport, exports render the whole diagram on their own surfaces.
+    mdc::ImageCanvasView *view = new mdc::ImageCanvasView(512, 512);
+    view->initialize();
+    return view;
+  }
+
+  virtual void free_canvas_view(mdc::CanvasView *view) {
+    delete view;
+  }
+
+  virtual cairo_surface_t *fetch_image(const std::string &file) {
+    return _file->get_image(file);
+  }
+
+  virtual std::string attach_image(const std::string &name) {
+    return _file->add_image_file(name);
+  }
+
+  virtual void release_image(const std::string &name) {
+  }
+
+private:
+  wb::ModelFile *_file;
+};
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Sets up the GRT the way the application does, but only with the struct definitions and the native
+ * modules needed for script generation. No Python, plugins or UI components are loaded.
+ */
+static bool initialize_grt(const BatchOptions &options) {
+  std::shared_ptr<grt::GRT> runtime = grt::GRT::get();
+
+  register_all_metaclasses();
+  register_interfaces();
+
+  std::string struct_paths[] = {base::makePath(options.data_dir, "grt"), base::makePath(options.data_dir, "structs")};
+  for (auto &path : struct_paths) {
+    if (g_file_test(path.c_str(), G_FILE_TEST_IS_DIR))
+      runtime->scan_metaclasses_in(path);
+  }
+  runtime->end_loading_metaclasses();
+
+  bec::GRTManager::Ref manager = bec::GRTManager::get();
+  manager->setVerbose(options.verbose);
+  manager->set_datadir(options.data_dir);
+  manager->set_basedir(options.data_dir);
+
+  static const char *image_dirs[] = {"images", "images/grt", "images/grt/structs", "images/png", NULL};
+  for (int i = 0; image_dirs[i] != NULL; ++i) {
+    mdc::ImageManager::get_instance()->add_search_path(base::makePath(options.data_dir, image_dirs[i]));
+    bec::IconManager::get_instance()->add_search_path(image_dirs[i]);
+  }
+  bec::IconManager::get_instance()->set_basedir(options.data_dir);
+
+  // A minimal application root, so model objects can find their options and the modules find the document.
+  workbench_WorkbenchRef root(grt::Initialized);
+  app_OptionsRef app_options(grt::Initialized);
+  app_options->owner(root);
+  app_options->options().set("SqlGenerator.Mysql:SQL_MODE", grt::StringRef(options.sql_mode));
+  root->options(app_options);
+  runtime->set_root(root);
+
+  manager->set_app_option_slots(
+    [app_options](const std::string &name) { return app_options->options().get(name); },
+    [app_options](const std::string &name, const grt::ValueRef &value) { app_options->options().set(name, value); });
+
+  bool success = true;
+  for (int i = 0; batch_modules[i] != NULL; ++i) {
+    std::string path = base::makePath(options.module_dir, std::string(batch_modules[i]) + "." G_MODULE_SUFFIX);
+    try {
+      if (!runtime->load_module(path, options.data_dir, false)) {
+        logError("Could not load module %s\n", path.c_str());
+        success = false;
+      }
+    } catch (std::exception &exc) {
+      logError("Could not load module %s: %s\n", path.c_str(), exc.what());
+      success = false;
+    }
+  }
+  runtime->end_loading_modules();
+
+  return success;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static workbench_DocumentRef open_model(wb::ModelFile &file, const std::string &path) {
+  file.open(path);
+
+  workbench_DocumentRef doc(file.retrieve_document());
+  if (!doc.is_valid())
+    throw std::runtime_error("Could not load the document from " + path);
+
+  std::list<std::string> warnings(file.get_load_warnings());
+  for (auto &warning : warnings)
+    logWarning("%s: %s\n", path.c_str(), warning.c_str());
+
+  if (doc->physicalModels().count() == 0)
+    throw std::runtime_error(path + " does not contain a physical model");
+
+  return doc;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static SQLGeneratorInterfaceImpl *sql_generator() {
+  SQLGeneratorInterfaceImpl *module = grt::GRT::get()->find_native_module<SQLGeneratorInterfaceImpl>("DbMySQL");
+  if (module == NULL)
+    throw std::runtime_error("Not able to load 'DbMySQL' module");
+  return module;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void write_file(const std::string &path, const std::string &contents) {
+  GError *error = NULL;
+  if (!g_file_set_contents(path.c_str(), contents.c_str(), (gssize)contents.size(), &error)) {
+    std::string message = error->message;
+    g_error_free(error);
+    throw std::runtime_error("Could not write " + path + ": " + message);
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Same steps as the SQL export wizard (DbMySQLSQLExport::export_task), with all objects selected.
+ */
+static void export_sql_script(const BatchOptions &options, const db_CatalogRef &catalog, const std::string &path) {
+  SQLGeneratorInterfaceImpl *module = sql_generator();
+
+  grt::DictRef export_options(true);
+  export_options.set("GenerateDrops", grt::IntegerRef(options.drops ? 1 : 0));
+  export_options.set("GenerateSchemaDrops", grt::IntegerRef(options.drops ? 1 : 0));
+  export_options.set("GenerateWarnings", grt::IntegerRef(0));
+  export_options.set("GenerateCreateIndex", grt::IntegerRef(0));
+  export_options.set("NoUsersJustPrivileges", grt::IntegerRef(0));
+  export_options.set("NoViewPlaceholders", grt::IntegerRef(0));
+  export_options.set("GenerateInserts", grt::IntegerRef(options.inserts ? 1 : 0));
+  export_options.set("NoFKForInserts", grt::IntegerRef(0));
+  export_options.set("TriggersAfterInserts", grt::IntegerRef(0));
+  export_options.set("OmitSchemas", grt::IntegerRef(options.omit_schemas ? 1 : 0));
+  export_options.set("GenerateUse", grt::IntegerRef(1));
+  export_options.set("SkipForeignKeys", grt::IntegerRef(0));
+  export_options.set("SkipFKIndexes", grt::IntegerRef(0));
+  export_options.set("GenerateDocumentProperties", grt::IntegerRef(0));
+  export_options.set("GenerateAttachedScripts", grt::IntegerRef(0));
+  export_options.set("SortTablesAlphabetically", grt::IntegerRef(0));
+  export_options.set("OutputScriptHeader", grt::StringRef(""));
+  export_options.set("SQL_MODE", bec::GRTManager::get()->get_app_option("SqlGenerator.Mysql:SQL_MODE"));
+  export_options.gset("UseFilteredLists", 0);
+
+  grt::DictRef db_settings = module->getDefaultTraits();
+  db_settings.set("CaseSensitive", grt::IntegerRef(1));
+  export_options.set("DBSettings", db_settings);
+
+  grt::DictRef create_map = module->generateSQLForDifferences(GrtNamedObjectRef(), catalog, export_options);
+  grt::DictRef drop_map;
+  if (options.drops)
+    drop_map = module->generateSQLForDifferences(catalog, GrtNamedObjectRef(), export_options);
+  if (!drop_map.is_valid())
+    drop_map = grt::DictRef(true);
+
+  export_options.set("CaseSensitive", grt::IntegerRef(export_options.get_int("DiffCaseSensitiveness", 1)));
+
+  if (module->makeSQLExportScript(catalog, export_options, create_map, drop_map))
+    throw std::runtime_error("SQL Script Export Module Returned Error");
+
+  write_file(path, export_options.get_string("OutputScriptHeader") + export_options.get_string("OutputScript"));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Writes the ALTER script which turns the reference catalog into the one of the processed model.
+ */
+static void export_sync_script(const db_CatalogRef &reference, const db_CatalogRef &catalog, const std::string &path) {
+  SQLGeneratorInterfaceImpl *module = sql_generator();
+
+  grt::DictRef db_settings = module->getDefaultTraits();
+  db_settings.set("CaseSensitive", grt::IntegerRef(1));
+
+  grt::DictRef diff_options(true);
+  diff_options.set("DBSettings", db_settings);
+
+  grt::BaseListRef args(true);
+  args.ginsert(reference);
+  args.ginsert(catalog);
+  args.ginsert(diff_options);
+
+  grt::Module *db_module = grt::GRT::get()->get_module("DbMySQL");
+  grt::StringRef script = grt::StringRef::cast_from(db_module->call_function("makeAlterScript", args));
+  write_file(path, *script);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void export_diagrams(const BatchOptions &options, wb::ModelFile &file, const workbench_DocumentRef &doc,
+                            const std::string &prefix) {
+  workbench_physical_ModelRef model(doc->physicalModels()[0]);
+  BatchCanvasDelegate delegate(&file);
+
+  model->get_data()->set_delegate(&delegate);
+  model->get_data()->realize();
+
+  // Part of the realization is deferred to idle time, which never comes without a main loop.
+  bec::GRTManager::get()->perform_idle_tasks();
+
+  double scale = *doc->pageSettings()->scale();
+  if (scale <= 0)
+    scale = 1.0;
+
+  std::string error;
+  for (size_t i = 0; i < model->diagrams().count(); ++i) {
+    model_DiagramRef diagram(model->diagrams()[i]);
+    mdc::CanvasView *view = diagram->get_data()->get_canvas_view();
+    if (view == NULL)
+      continue;
+
+    std::string path = prefix + "-" + base::sanitize_file_name(*diagram->name());
+    try {
+      if (options.png)
+        view->export_png(path + ".png", true);
+
+      if (options.pdf) {
+        base::Size size = view->get_total_view_size();
+        size.width = size.width / scale * 2.834;
+        size.height = size.height / scale * 2.834;
+        view->export_pdf(path + ".pdf", size);
+      }
+    } catch (std::exception &exc) {
+      error = "diagram '" + *diagram->name() + "': " + exc.what();
+      break;
+    }
+  }
+
+  model->get_data()->unrealize();
+  model->get_data()->set_delegate(NULL);
+
+  if (!error.empty())
+    throw std::runtime_error(error);
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Returns the model to compare against for the given model file. --sync-with can name either a single
+ * reference model or a folder which holds a model with the same file name.
+ */
+static std::string reference_model_for(const BatchOptions &options, const std::string &model) {
+  if (base::is_directory(options.sync_with))
+    return base::makePath(options.sync_with, base::basename(model));
+  return options.sync_with;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static std::string absolute_path(const std::string &path) {
+  if (g_path_is_absolute(path.c_str()))
+    return base::normalize_path(path);
+  gchar *cwd = g_get_current_dir();
+  std::string result = base::normalize_path(base::makePath(cwd, path));
+  g_free(cwd);
+  return result;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static std::string source_root(const std::vector<std::string> &models) {
+  std::vector<std::string> root;
+  for (size_t i = 0; i < models.size(); ++i) {
+    std::vector<std::string> parts = base::split(base::dirname(absolute_path(models[i])), G_DIR_SEPARATOR_S);
+    if (i == 0) {
+      root = parts;
+      continue;
+    }
+    size_t common = 0;
+    while (common < root.size() && common < parts.size() && root[common] == parts[common])
+      ++common;
+    root.resize(common);
+  }
+  return base::join(root, G_DIR_SEPARATOR_S) + G_DIR_SEPARATOR_S;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Models from different folders may share a file name, so the output files keep the path of their model
+ * below the common parent folder of all models. For models in a single folder that is just the file name.
+ */
+static std::string output_prefix(const BatchOptions &options, const std::string &model) {
+  std::string path = absolute_path(model);
+  if (base::hasPrefix(path, options.source_root))
+    path = path.substr(options.source_root.size());
+  else
+    base::replaceStringInplace(path, ":", ""); // Models on different drives.
+  while (!path.empty() && path[0] == G_DIR_SEPARATOR)
+    path.erase(0, 1);
+  return base::makePath(options.output_dir, base::strip_extension(path));
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static void process_model(const BatchOptions &options, const std::string &path) {
+  std::string tmp_dir = base::makePath(bec::GRTManager::get()->get_tmp_dir(), "batch");
+  std::string prefix = output_prefix(options, path);
+  if (!base::is_directory(base::dirname(prefix)) && !base::create_directory(base::dirname(prefix), 0700, true))
+    throw std::runtime_error("Could not create output folder " + base::dirname(prefix));
+
+  // Every model file gets its own content folder, as models from different folders may share a name.
+  wb::ModelFile file(base::makePath(tmp_dir, "model"));
+  workbench_DocumentRef doc(open_model(file, path));
+
+  workbench_WorkbenchRef root(workbench_WorkbenchRef::cast_from(grt::GRT::get()->root()));
+  root->doc(doc);
+  doc->owner(root);
+
+  try {
+    db_CatalogRef catalog(doc->physicalModels()[0]->catalog());
+
+    if (options.sql)
+      export_sql_script(options, catalog, prefix + ".sql");
+
+    if (!options.sync_with.empty()) {
+      wb::ModelFile reference_file(base::makePath(tmp_dir, "reference"));
+      workbench_DocumentRef reference(open_model(reference_file, reference_model_for(options, path)));
+
+      export_sync_script(reference->physicalModels()[0]->catalog(), catalog, prefix + ".sync.sql");
+      reference_file.cleanup();
+    }
+
+    if (options.png || options.pdf)
+      export_diagrams(options, file, doc, prefix);
+  } catch (...) {
+    root->doc(workbench_DocumentRef());
+    throw;
+  }
+
+  root->doc(workbench_DocumentRef());
+  file.cleanup();
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Processes all given models one after the other in this process. A status line is printed per model,
+ * the result is the number of models which could not be processed.
+ */
+static int process_models(const BatchOptions &options) {
+  if (!initialize_grt(options)) {
+    std::cerr << "Could not load the native modules from " << options.module_dir << std::endl;
+    return (int)options.models.size();
+  }
+
+  int failed = 0;
+  for (auto &model : options.models) {
+    try {
+      process_model(options, model);
+      std::cout << "OK " << model << std::endl;
+    } catch (std::exception &exc) {
+      std::cout << "FAILED " << model << ": " << exc.what() << std::endl;
+      ++failed;
+    }
+  }
+
+  bec::GRTManager::get()->cleanup_tmp_dir();
+
+  return failed;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static std::vector<std::string> worker_arguments(const BatchOptions &options, const std::string &program) {
+  std::vector<std::string> args = {program,          "--worker",          "--data-dir", options.data_dir,
+                                   "--module-dir",   options.module_dir, "--output",   options.output_dir,
+                                   "--sql-mode",     options.sql_mode,   "--source-root", options.source_root};
+  if (!options.sync_with.empty()) {
+    args.push_back("--sync-with");
+    args.push_back(options.sync_with);
+  }
+
+  const std::pair<bool, const char *> flags[] = {
+    {options.sql, "--sql"},     {options.png, "--png"},         {options.pdf, "--pdf"},
+    {options.drops, "--drops"}, {options.inserts, "--inserts"}, {options.omit_schemas, "--omit-schemas"},
+    {options.verbose, "--verbose"}};
+  for (auto &flag : flags) {
+    if (flag.first)
+      args.push_back(flag.second);
+  }
+
+  return args;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+/**
+ * Splits the models into one group per job and runs each group in a worker process. The output of the
+ * workers is relayed once they finish. Returns true if all workers succeeded.
+ */
+static bool run_workers(const BatchOptions &options, const std::string &program) {
+  size_t job_count = std::min((size_t)options.jobs, options.models.size());
+  std::vector<std::vector<std::string> > groups(job_count);
+  for (size_t i = 0; i < options.models.size(); ++i)
+    groups[i % job_count].push_back(options.models[i]);
+
+  std::mutex output_mutex;
+  bool success = true;
+
+  std::vector<std::thread> threads;
+  for (auto &group : groups) {
+    threads.push_back(std::thread([&, group]() {
+      std::vector<std::string> args = worker_arguments(options, program);
+      args.insert(args.end(), group.begin(), group.end());
+
+      std::vector<gchar *> argv;
+      for (auto &arg : args)
+        argv.push_back((gchar *)arg.c_str());
+      argv.push_back(NULL);
+
+      gchar *out = NULL;
+      gchar *err = NULL;
+      gint status = 0;
+      GError *error = NULL;
+      gboolean spawned = g_spawn_sync(NULL, argv.data(), NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, &out, &err, &status, &error);
+
+      std::lock_guard<std::mutex> lock(output_mutex);
+      if (!spawned) {
+        std::cerr << "Could not start worker process: " << error->message << std::endl;
+        g_error_free(error);
+        success = false;
+        return;
+      }
+
+      if (out != NULL)
+        std::cout << out;
+      if (err != NULL)
+        std::cerr << err;
+      g_free(out);
+      g_free(err);
+
+      if (status != 0)
+        success = false;
+    }));
+  }
+
+  for (auto &thread : threads)
+    thread.join();
+
+  return success;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static std::string path_from_environment(const char *name, const char *fallback) {
+  const char *value = getenv(name);
+  return value != NULL ? value : fallback;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+  BatchOptions options;
+  options.data_dir = path_from_environment("MWB_DATA_DIR", WBBATCH_DATA_DIR);
+  options.module_dir = path_from_environment("MWB_MODULE_DIR", WBBATCH_MODULE_DIR);
+  options.sql_mode = default_sql_mode;
+  options.output_dir = ".";
+
+  using namespace dataTypes;
+  OptionsList list;
+  int retval = 0;
+
+  list.addEntry(OptionEntry(OptionArgumentLogical, 'h', "help", "Show help options",
+                            [&list](const OptionEntry &entry, int *retval) {
+                              std::cout << list.getHelp("wbbatch");
+                              *retval = 0;
+                              return false;
+                            }));
+  list.addEntry(OptionEntry(OptionArgumentLogical, "sql", "Write a forward engineering script for each model"));
+  list.addEntry(OptionEntry(OptionArgumentFilename, "sync-with",
+                            "Write an ALTER script against the given reference model\n"
+                            "or the model with the same name in the given folder",
+                            nullptr, "<model file>|<folder>"));
+  list.addEntry(OptionEntry(OptionArgumentLogical, "png", "Export every diagram as PNG image"));
+  list.addEntry(OptionEntry(OptionArgumentLogical, "pdf", "Export every diagram as PDF document"));
+  list.addEntry(OptionEntry(OptionArgumentLogical, "drops", "Generate DROP statements before each CREATE"));
+  list.addEntry(OptionEntry(OptionArgumentLogical, "inserts", "Generate INSERT statements for tables"));
+  list.addEntry(OptionEntry(OptionArgumentLogical, "omit-schemas", "Omit schema qualifier in object names"));
+  list.addEntry(OptionEntry(OptionArgumentText, "sql-mode", "SQL_MODE used for generated scripts", nullptr,
+                            "<mode>"));
+  list.addEntry(OptionEntry(OptionArgumentFilename, 'o', "output", "Folder for the generated files", nullptr,
+                            "<folder>"));
+  list.addEntry(OptionEntry(OptionArgumentNumeric, 'j', "jobs", "Number of worker processes", nullptr, "<count>"));
+  list.addEntry(OptionEntry(OptionArgumentFilename, "data-dir", "Application data folder", nullptr, "<folder>"));
+  list.addEntry(OptionEntry(OptionArgumentFilename, "module-dir", "Folder with the native modules", nullptr,
+                            "<folder>"));
+  list.addEntry(OptionEntry(OptionArgumentLogical, "verbose", "Log to stderr"));
+  list.addEntry(OptionEntry(OptionArgumentLogical, "worker", "Internal: process the models in this process"));
+  list.addEntry(OptionEntry(OptionArgumentFilename, "source-root", "Internal: common folder of all models", nullptr,
+                            "<folder>"));
+
+  try {
+    if (!list.parse(std::vector<std::string>(argv + 1, argv + argc), retval))
+      return retval;
+  } catch (std::exception &exc) {
+    std::cerr << exc.what() << std::endl << list.getHelp("wbbatch");
+    return 1;
+  }
+
+  auto text_value = [&list](const std::string &name, std::string &value) {
+    if (!list.getEntry(name)->value.textValue.empty())
+      value = list.getEntry(name)->value.textValue;
+  };
+  text_value("data-dir", options.data_dir);
+  text_value("module-dir", options.module_dir);
+  text_value("output", options.output_dir);
+  text_value("sync-with", options.sync_with);
+  text_value("sql-mode", options.sql_mode);
+  text_value("source-root", options.source_root);
+
+  options.sql = list.getEntry("sql")->value.logicalValue;
+  options.png = list.getEntry("png")->value.logicalValue;
+  options.pdf = list.getEntry("pdf")->value.logicalValue;
+  options.drops = list.getEntry("drops")->value.logicalValue;
+  options.inserts = list.getEntry("inserts")->value.logicalValue;
+  options.omit_schemas = list.getEntry("omit-schemas")->value.logicalValue;
+  options.verbose = list.getEntry("verbose")->value.logicalValue;
+  options.worker = list.getEntry("worker")->value.logicalValue;
+  options.jobs = list.getEntry("jobs")->value.numericValue;
+  options.models = list.pathArgs;
+
+  if (options.models.empty() || !(options.sql || options.png || options.pdf || !options.sync_with.empty())) {
+    std::cerr << "No model files or nothing to do." << std::endl << list.getHelp("wbbatch");
+    return 1;
+  }
+
+  if (!base::is_directory(options.output_dir) && !base::create_directory(options.output_dir, 0700, true)) {
+    std::cerr << "Could not create output folder " << options.output_dir << std::endl;
+    return 1;
+  }
+
+  base::Logger log(options.verbose);
+
+  // Workers get the folder of the whole model list, their own share may have a different one.
+  if (options.source_root.empty())
+    options.source_root = source_root(options.models);
+
+  if (options.jobs <= 0)
+    options.jobs = (int)std::max(1U, std::thread::hardware_concurrency());
+
+  if (!options.worker && options.jobs > 1 && options.models.size() > 1)
+    return run_workers(options, argv[0]) ? 0 : 1;
+
+  return process_models(options) == 0 ? 0 : 1;
+}
+
+//--------------------------------------------------------------------------------------------------